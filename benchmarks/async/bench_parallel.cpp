@@ -0,0 +1,191 @@
+// ~mgj: parallel_for / parallel_reduce scaling benchmark. Runs three loops shaped like the city builders
+// with 1 to max_threads participants and reports the best time and the speedup over one participant:
+//   transform  4x4 F64 matrix times every vertex, written out as F32 (tile vertex conversion)
+//   bounds     min/max reduce over 2D points (BVH root bounds)
+//   uneven     items whose cost varies 1 to 64x (roof triangulation), once with fixed equal chunks through
+//              thread_pool_fork_join and once with the guided chunks of parallel_for
+// Usage: city_benchmarks parallel [max_threads]
+// max_threads defaults to the logical processor count. Above that the numbers only show oversubscription.
+
+struct BenchParallelData
+{
+    U64 count; // uneven items
+    Vec3F32* positions;
+    Vec3F32* out_positions;
+    Vec2F32* points;
+    F64 matrix[16]; // column major
+    U32 chunk_count; // uneven with fixed chunks
+    U64* item_costs;
+    U64* results;
+};
+
+g_internal void
+bench_parallel_transform_task(async::ThreadInfo thread_info, Arena* scratch_arena, void* data, U64 start_idx, U64 end_idx)
+{
+    (void)thread_info;
+    (void)scratch_arena;
+    BenchParallelData* bench = (BenchParallelData*)data;
+    F64* m = bench->matrix;
+    for (U64 i = start_idx; i < end_idx; ++i)
+    {
+        F64 x = bench->positions[i].x;
+        F64 y = bench->positions[i].y;
+        F64 z = bench->positions[i].z;
+        bench->out_positions[i] = vec_3f32((F32)(m[0] * x + m[4] * y + m[8] * z + m[12]), (F32)(m[1] * x + m[5] * y + m[9] * z + m[13]),
+                                           (F32)(m[2] * x + m[6] * y + m[10] * z + m[14]));
+    }
+}
+
+g_internal Rng2F32
+bench_parallel_bounds_task(async::ThreadInfo thread_info, Arena* scratch_arena, void* data, U64 start_idx, U64 end_idx, Rng2F32 acc)
+{
+    (void)thread_info;
+    (void)scratch_arena;
+    BenchParallelData* bench = (BenchParallelData*)data;
+    for (U64 i = start_idx; i < end_idx; ++i)
+    {
+        acc = city::bounds_union(acc, bench->points[i]);
+    }
+    return acc;
+}
+
+g_internal Rng2F32
+bench_parallel_bounds_combine(Rng2F32 a, Rng2F32 b)
+{
+    return city::bounds_union(a, b);
+}
+
+g_internal U64
+bench_parallel_uneven_item(BenchParallelData* bench, U64 i)
+{
+    U64 hash = i;
+    for (U64 round = 0; round < bench->item_costs[i]; ++round)
+    {
+        hash = hash_index_hash_u64(hash);
+    }
+    return hash;
+}
+
+g_internal void
+bench_parallel_uneven_task(async::ThreadInfo thread_info, Arena* scratch_arena, void* data, U64 start_idx, U64 end_idx)
+{
+    (void)thread_info;
+    (void)scratch_arena;
+    BenchParallelData* bench = (BenchParallelData*)data;
+    for (U64 i = start_idx; i < end_idx; ++i)
+    {
+        bench->results[i] = bench_parallel_uneven_item(bench, i);
+    }
+}
+
+g_internal void
+bench_parallel_uneven_fixed_task(async::ThreadInfo thread_info, void* data, U32 task_idx)
+{
+    (void)thread_info;
+    BenchParallelData* bench = (BenchParallelData*)data;
+    U64 chunk_size = (bench->count + bench->chunk_count - 1) / bench->chunk_count;
+    U64 start_idx = (U64)task_idx * chunk_size;
+    U64 end_idx = Min(start_idx + chunk_size, bench->count);
+    for (U64 i = start_idx; i < end_idx; ++i)
+    {
+        bench->results[i] = bench_parallel_uneven_item(bench, i);
+    }
+}
+
+g_internal void
+bench_parallel_report(const char* name, U32 participant_count, BenchTiming* timing, U64 base_us)
+{
+    INFO_LOG("    %-16s %2u threads %9.2f ms, %5.2fx", name, participant_count, (F64)timing->best_us / 1000.0, (F64)base_us / Max((F64)timing->best_us, 1.0));
+}
+
+g_internal void
+bench_parallel(Arena* arena, String8List args)
+{
+    const U32 iteration_count = 5;
+    const U64 vertex_count = Million(4);
+    const U64 uneven_count = Thousand(200);
+    U32 max_thread_count = Max(OS_GetSystemInfo()->logical_processor_count, 1u);
+    if (args.first)
+    {
+        max_thread_count = Max((U32)U64FromStr8(args.first->string, 10), 1u);
+    }
+
+    BenchParallelData bench = {};
+    bench.positions = PushArrayNoZero(arena, Vec3F32, vertex_count);
+    bench.out_positions = PushArrayNoZero(arena, Vec3F32, vertex_count);
+    bench.points = PushArrayNoZero(arena, Vec2F32, vertex_count);
+    for (U64 i = 0; i < vertex_count; ++i)
+    {
+        bench.positions[i] = vec_3f32(bench_unit_f32(3 * i) * 1000.0f, bench_unit_f32(3 * i + 1) * 1000.0f, bench_unit_f32(3 * i + 2) * 100.0f);
+        bench.points[i] = vec_2f32(bench.positions[i].x, bench.positions[i].y);
+    }
+    F64 matrix[16] = {0.6, -0.8, 0.0, 0.0, 0.8, 0.6, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 12.5, -3.0, 40.0, 1.0};
+    MemoryCopy(bench.matrix, matrix, sizeof(matrix));
+    // ~mgj: mostly cheap items and a tail of expensive ones at the end of the range, like a few big buildings
+    bench.item_costs = PushArrayNoZero(arena, U64, uneven_count);
+    bench.results = PushArrayNoZero(arena, U64, uneven_count);
+    for (U64 i = 0; i < uneven_count; ++i)
+    {
+        bench.item_costs[i] = i > uneven_count * 7 / 8 ? 64 * 16 : 16;
+    }
+
+    INFO_LOG("parallel: %llu vertices, %llu uneven items, 1 to %u threads", vertex_count, uneven_count, max_thread_count);
+    U64 base_us[4] = {};
+    for (U32 participant_count = 1;; participant_count = Min(participant_count * 2, max_thread_count))
+    {
+        Arena* pool_arena = arena_alloc();
+        Debug_SetName(pool_arena, "bench parallel arena");
+        // ~mgj: the caller is a participant, one participant runs everything inline
+        async::ThreadPool* thread_pool = participant_count > 1 ? async::thread_pool_create(pool_arena, participant_count - 1, 256, 16) : 0;
+
+        BenchTiming timings[4] = {};
+        for (U32 iteration = 0; iteration < iteration_count; ++iteration)
+        {
+            U64 start = os_now_microseconds();
+            async::parallel_for(thread_pool, vertex_count, 0, bench_parallel_transform_task, &bench);
+            bench_timing_add(&timings[0], os_now_microseconds() - start);
+
+            start = os_now_microseconds();
+            Rng2F32 bounds = async::parallel_reduce(thread_pool, vertex_count, 0, rng2f32_inverted_inf(), bench_parallel_bounds_task, bench_parallel_bounds_combine, &bench);
+            bench_timing_add(&timings[1], os_now_microseconds() - start);
+            AssertAlways(bounds.max.x >= bounds.min.x);
+
+            bench.count = uneven_count;
+            bench.chunk_count = participant_count;
+            start = os_now_microseconds();
+            if (thread_pool)
+            {
+                async::thread_pool_fork_join(thread_pool, bench.chunk_count, bench_parallel_uneven_fixed_task, &bench);
+            }
+            else
+            {
+                bench_parallel_uneven_fixed_task({}, &bench, 0);
+            }
+            bench_timing_add(&timings[2], os_now_microseconds() - start);
+
+            start = os_now_microseconds();
+            async::parallel_for(thread_pool, uneven_count, 0, bench_parallel_uneven_task, &bench);
+            bench_timing_add(&timings[3], os_now_microseconds() - start);
+        }
+
+        const char* names[4] = {"transform", "bounds", "uneven fixed", "uneven guided"};
+        for (U32 i = 0; i < ArrayCount(timings); ++i)
+        {
+            if (participant_count == 1)
+            {
+                base_us[i] = timings[i].best_us;
+            }
+            bench_parallel_report(names[i], participant_count, &timings[i], base_us[i]);
+        }
+
+        if (thread_pool)
+        {
+            async::thread_pool_destroy(thread_pool);
+        }
+        arena_release(pool_arena);
+        if (participant_count == max_thread_count)
+        {
+            break;
+        }
+    }
+}
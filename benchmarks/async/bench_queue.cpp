@@ -0,0 +1,213 @@
+// ~mgj: Queue contention benchmark. P producers and P consumers move a fixed number of items through a
+// queue of 1024 slots, for P from 1 to max_threads, once through the lock-free Queue and once through
+// the previous rw-mutex queue. Producers retry with a yield when the queue is full so both queues stay
+// bounded. Reports the best of a few runs in million items per second.
+// Usage: city_benchmarks queue [max_threads]
+// max_threads defaults to 32, every step runs 2 * P threads.
+
+// ~mgj: The rw-mutex Queue that the lock-free Queue replaced, kept verbatim (renamed) as the baseline
+// for this benchmark. queue_push grows it without bound, the benchmark only uses the try functions.
+template <typename T>
+struct LegacyQueue
+{
+    volatile U32 next_index;
+    volatile U32 fill_index;
+    U32 items_in_queue_count;
+    U32 queue_size;
+    Arena* arena;
+    T* items;
+    OS_Handle mutex;
+};
+
+template <typename T>
+g_internal void
+_legacy_queue_insert_value(LegacyQueue<T>* queue, T* data)
+{
+    U32 fill_index = queue->fill_index;
+    queue->fill_index = (fill_index + 1) % queue->queue_size;
+    queue->items[fill_index] = *data;
+    queue->items_in_queue_count++;
+}
+
+template <typename T>
+g_internal LegacyQueue<T>*
+legacy_queue_alloc(Arena* arena, U32 queue_size)
+{
+    LegacyQueue<T>* queue = PushStruct(arena, LegacyQueue<T>);
+    queue->queue_size = ClampBot(queue_size, 1);
+    queue->arena = arena;
+    queue->items = PushArray(arena, T, queue->queue_size);
+    queue->mutex = os_rw_mutex_alloc();
+    return queue;
+}
+
+template <typename T>
+g_internal void
+legacy_queue_release(LegacyQueue<T>* queue)
+{
+    os_rw_mutex_release(queue->mutex);
+}
+
+template <typename T>
+g_internal B32
+legacy_queue_try_push(LegacyQueue<T>* queue, T* data)
+{
+    B32 inserted = false;
+    os_mutex_scope_w(queue->mutex)
+    {
+        if (queue->items_in_queue_count < queue->queue_size)
+        {
+            _legacy_queue_insert_value(queue, data);
+            inserted = true;
+        }
+    }
+    return inserted;
+}
+
+template <typename T>
+g_internal B32
+legacy_queue_try_read(LegacyQueue<T>* queue, T* item)
+{
+    B32 has_read = 0;
+    os_mutex_scope_w(queue->mutex)
+    {
+        if (queue->items_in_queue_count > 0)
+        {
+            U32 cur_index = queue->next_index;
+            queue->next_index = (cur_index + 1) % queue->queue_size;
+            *item = queue->items[cur_index];
+            queue->items_in_queue_count--;
+            has_read = 1;
+        }
+    }
+    return has_read;
+}
+
+// ~mgj: same shape as the thread pool's WorkerItem
+struct BenchQueueItem
+{
+    U64 a;
+    U64 b;
+};
+
+template <typename Q, B32 (*TryPush)(Q*, BenchQueueItem*), B32 (*TryRead)(Q*, BenchQueueItem*)>
+g_internal U64
+bench_queue_run(Q* queue, U32 pair_count, U64 item_count)
+{
+    U64 per_producer = item_count / pair_count;
+    std::atomic<U64> consumed = 0;
+    std::atomic<U64> checksum = 0;
+    std::atomic<B32> go = false;
+    std::thread* threads = new std::thread[pair_count * 2];
+    for (U32 p = 0; p < pair_count; ++p)
+    {
+        threads[p] = std::thread([&, p]() {
+            while (!go.load())
+            {
+            }
+            for (U64 i = 0; i < per_producer; ++i)
+            {
+                BenchQueueItem item = {.a = p * per_producer + i, .b = i};
+                while (!TryPush(queue, &item))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+        threads[pair_count + p] = std::thread([&]() {
+            while (!go.load())
+            {
+            }
+            U64 local_sum = 0;
+            BenchQueueItem item = {};
+            while (consumed.load(std::memory_order_relaxed) < per_producer * pair_count)
+            {
+                if (TryRead(queue, &item))
+                {
+                    local_sum += item.a;
+                    consumed.fetch_add(1, std::memory_order_relaxed);
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+            }
+            checksum.fetch_add(local_sum);
+        });
+    }
+
+    U64 start = os_now_microseconds();
+    go.store(true);
+    for (U32 i = 0; i < pair_count * 2; ++i)
+    {
+        threads[i].join();
+    }
+    U64 elapsed_us = os_now_microseconds() - start;
+    delete[] threads;
+
+    U64 total = per_producer * pair_count;
+    AssertAlways(checksum.load() == total * (total - 1) / 2);
+    return elapsed_us;
+}
+
+g_internal B32
+bench_queue_try_push(async::Queue<BenchQueueItem>* queue, BenchQueueItem* item)
+{
+    return async::queue_try_push(queue, item);
+}
+
+g_internal B32
+bench_queue_try_read(async::Queue<BenchQueueItem>* queue, BenchQueueItem* item)
+{
+    return async::queue_try_read(queue, item);
+}
+
+g_internal B32
+bench_legacy_queue_try_push(LegacyQueue<BenchQueueItem>* queue, BenchQueueItem* item)
+{
+    return legacy_queue_try_push(queue, item);
+}
+
+g_internal B32
+bench_legacy_queue_try_read(LegacyQueue<BenchQueueItem>* queue, BenchQueueItem* item)
+{
+    return legacy_queue_try_read(queue, item);
+}
+
+g_internal void
+bench_queue(Arena* arena, String8List args)
+{
+    const U32 iteration_count = 3;
+    const U32 capacity = 1024;
+    const U64 item_count = Million(2);
+    U32 max_pair_count = 32;
+    if (args.first)
+    {
+        max_pair_count = Max((U32)U64FromStr8(args.first->string, 10), 1u);
+    }
+
+    INFO_LOG("queue: %llu items, %u slots, 1 to %u producer/consumer pairs", item_count, capacity, max_pair_count);
+    for (U32 pair_count = 1;; pair_count = Min(pair_count * 2, max_pair_count))
+    {
+        BenchTiming lock_free = {};
+        BenchTiming legacy = {};
+        for (U32 iteration = 0; iteration < iteration_count; ++iteration)
+        {
+            async::Queue<BenchQueueItem>* queue = async::queue_alloc<BenchQueueItem>(arena, capacity, async::QueueFullPolicy_Fail);
+            bench_timing_add(&lock_free, bench_queue_run<async::Queue<BenchQueueItem>, bench_queue_try_push, bench_queue_try_read>(queue, pair_count, item_count));
+            async::queue_release(queue);
+
+            LegacyQueue<BenchQueueItem>* legacy_queue = legacy_queue_alloc<BenchQueueItem>(arena, capacity);
+            bench_timing_add(&legacy, bench_queue_run<LegacyQueue<BenchQueueItem>, bench_legacy_queue_try_push, bench_legacy_queue_try_read>(legacy_queue, pair_count, item_count));
+            legacy_queue_release(legacy_queue);
+        }
+
+        F64 lock_free_mops = (F64)item_count / Max((F64)lock_free.best_us, 1.0);
+        F64 legacy_mops = (F64)item_count / Max((F64)legacy.best_us, 1.0);
+        INFO_LOG("    %2u pairs  lock-free %7.2f M items/s  rw-mutex %7.2f M items/s  %5.2fx", pair_count, lock_free_mops, legacy_mops, lock_free_mops / Max(legacy_mops, 1e-9));
+        if (pair_count == max_pair_count)
+        {
+            break;
+        }
+    }
+}
@@ -0,0 +1,219 @@
+// ~mgj: Map microbenchmark. Compares the Swiss table Map (grown from a small hint and pre-sized),
+// HashIndex and the previous chunked-bucket Map on random U64 keys.
+// Usage: city_benchmarks map [all]
+// The chunked map allocates a chunk per insert, so at 10M keys it needs several GB and is only run with "all".
+
+// ~mgj: The chunked-bucket Map that the Swiss table Map replaced, kept verbatim (renamed) as the
+// baseline for this benchmark. Its bucket count is fixed at creation and it never rehashes.
+const U64 LEGACY_MAP_CHUNK_SIZE = 14;
+template <typename K, typename V, U64 N = LEGACY_MAP_CHUNK_SIZE>
+struct LegacyMapChunk
+{
+    LegacyMapChunk<K, V, N>* next;
+    U64 count;
+    MapItem<K, V> v[N];
+};
+
+template <typename K, typename T, U64 N = LEGACY_MAP_CHUNK_SIZE>
+struct LegacyMapChunkList
+{
+    LegacyMapChunk<K, T, N>* first;
+    LegacyMapChunk<K, T, N>* last;
+    U64 chunk_count;
+    U64 total_count;
+};
+
+template <typename K, typename V>
+struct LegacyMap
+{
+    Arena* arena;
+    LegacyMapChunkList<K, V>* v;
+    U64 capacity;
+};
+
+g_internal U64
+legacy_map_hash_u64(U64 x)
+{
+    String8 str = {.str = (U8*)&x, .size = sizeof(U64)};
+    U64 res = hash_u128_from_str8(str).u64[1];
+    return res;
+}
+
+template <typename K, typename V>
+g_internal LegacyMap<K, V>*
+legacy_map_create(Arena* arena, U64 capacity)
+{
+    using MapType = LegacyMap<K, V>;
+    LegacyMap<K, V>* map = PushStruct(arena, MapType);
+    map->arena = arena;
+    U64 actual_cap = map_round_up_pow2_u64(capacity);
+    using MapKeyValuePairList = LegacyMapChunkList<K, V>;
+    map->v = PushArray(arena, MapKeyValuePairList, actual_cap);
+    map->capacity = actual_cap;
+    return map;
+}
+
+template <typename K, typename V>
+g_internal V*
+legacy_map_get(LegacyMap<K, V>* m, K key)
+{
+    U64 hash = legacy_map_hash_u64(key);
+    U64 index = hash % m->capacity;
+    LegacyMapChunkList<K, V>* chunk_list = &m->v[index];
+    LegacyMapChunk<K, V>* chunk = chunk_list->first;
+    while (chunk)
+    {
+        for (U64 i = 0; i < chunk->count; ++i)
+        {
+            if (chunk->v[i].key == key)
+                return &chunk->v[i].value;
+        }
+        chunk = chunk->next;
+    }
+    return nullptr;
+}
+
+template <typename K, typename V>
+g_internal V*
+legacy_map_insert(LegacyMap<K, V>* m, K key, V& value)
+{
+    using KeyPair = LegacyMapChunk<K, V>;
+
+    U64 hash = legacy_map_hash_u64((U64)key);
+    U64 index = hash % m->capacity;
+    LegacyMapChunkList<K, V>* chunk_list = &m->v[index];
+    LegacyMapChunk<K, V>* chunk = chunk_list->first;
+
+    // check if key is already present
+    for (; chunk; chunk = chunk->next)
+    {
+        for (U64 i = 0; i < chunk->count; ++i)
+        {
+            if (chunk->v[i].key == key)
+                return nullptr;
+        }
+    }
+
+    if (!chunk || chunk->count >= ArrayCount(chunk->v))
+    {
+        chunk = PushStruct(m->arena, KeyPair);
+        SLLQueuePush(chunk_list->first, chunk_list->last, chunk);
+        chunk_list->chunk_count += 1;
+    }
+
+    chunk = chunk_list->last;
+    U64 i = chunk->count;
+    chunk->v[i].key = key;
+    chunk->v[i].value = value;
+    chunk_list->total_count += 1;
+    chunk->count += 1;
+
+    return &chunk->v[i].value;
+}
+
+struct BenchMapResult
+{
+    U64 insert_us;
+    U64 hit_us;
+    U64 miss_us;
+    U64 checksum;
+};
+
+g_internal void
+bench_map_result_print(const char* name, U64 key_count, BenchMapResult result)
+{
+    F64 n = (F64)key_count;
+    INFO_LOG("    %-22s insert %7.1f ns/op, hit %7.1f ns/op, miss %7.1f ns/op (checksum %llu)", name, (F64)result.insert_us * 1000.0 / n, (F64)result.hit_us * 1000.0 / n,
+             (F64)result.miss_us * 1000.0 / n, result.checksum);
+}
+
+template <typename InsertFunc, typename GetFunc>
+g_internal BenchMapResult
+bench_map_run(U64* keys, U64* miss_keys, U64 key_count, InsertFunc insert, GetFunc get)
+{
+    BenchMapResult result = {};
+    U64 start_us = os_now_microseconds();
+    for (U64 i = 0; i < key_count; ++i)
+    {
+        insert(keys[i], i);
+    }
+    result.insert_us = os_now_microseconds() - start_us;
+
+    start_us = os_now_microseconds();
+    for (U64 i = 0; i < key_count; ++i)
+    {
+        U64* value = get(keys[i]);
+        result.checksum += value ? *value : 0;
+    }
+    result.hit_us = os_now_microseconds() - start_us;
+
+    start_us = os_now_microseconds();
+    for (U64 i = 0; i < key_count; ++i)
+    {
+        result.checksum += get(miss_keys[i]) ? 1 : 0;
+    }
+    result.miss_us = os_now_microseconds() - start_us;
+    return result;
+}
+
+g_internal void
+bench_map(Arena* arena, String8List args)
+{
+    B32 run_all = args.first && str8_match(args.first->string, S("all"), 0);
+    const U64 key_counts[] = {Thousand(1), Thousand(100), Million(10)};
+    for (U32 count_idx = 0; count_idx < ArrayCount(key_counts); ++count_idx)
+    {
+        U64 key_count = key_counts[count_idx];
+        Arena* bench_arena = arena_alloc();
+        Debug_SetName(bench_arena, "bench map arena");
+        defer(arena_release(bench_arena));
+
+        // ~mgj: the mixer is a bijection so every key is unique and hits/misses never overlap
+        U64* keys = PushArrayNoZero(bench_arena, U64, key_count);
+        U64* miss_keys = PushArrayNoZero(bench_arena, U64, key_count);
+        for (U64 i = 0; i < key_count; ++i)
+        {
+            keys[i] = hash_index_hash_u64(i + 1);
+            miss_keys[i] = hash_index_hash_u64(key_count + i + 1);
+        }
+
+        INFO_LOG("map %llu keys", key_count);
+        {
+            U64 arena_base_pos = arena_pos(bench_arena);
+            Map<U64, U64>* map = map_create<U64, U64>(bench_arena, 16);
+            BenchMapResult result = bench_map_run(
+                keys, miss_keys, key_count, [&](U64 key, U64 value) { map_insert(map, key, value); }, [&](U64 key) { return map_get(map, key); });
+            bench_map_result_print("Map (grown)", key_count, result);
+            arena_pop_to(bench_arena, arena_base_pos);
+        }
+        {
+            U64 arena_base_pos = arena_pos(bench_arena);
+            Map<U64, U64>* map = map_create<U64, U64>(bench_arena, key_count);
+            BenchMapResult result = bench_map_run(
+                keys, miss_keys, key_count, [&](U64 key, U64 value) { map_insert(map, key, value); }, [&](U64 key) { return map_get(map, key); });
+            bench_map_result_print("Map (pre-sized)", key_count, result);
+            arena_pop_to(bench_arena, arena_base_pos);
+        }
+        {
+            U64 arena_base_pos = arena_pos(bench_arena);
+            HashIndex<U64, U64>* index = hash_index_create<U64, U64>(bench_arena, key_count);
+            BenchMapResult result = bench_map_run(
+                keys, miss_keys, key_count, [&](U64 key, U64 value) { hash_index_insert(index, key, value); }, [&](U64 key) { return hash_index_get(index, key); });
+            bench_map_result_print("HashIndex (pre-sized)", key_count, result);
+            arena_pop_to(bench_arena, arena_base_pos);
+        }
+        if (key_count <= Thousand(100) || run_all)
+        {
+            U64 arena_base_pos = arena_pos(bench_arena);
+            LegacyMap<U64, U64>* map = legacy_map_create<U64, U64>(bench_arena, key_count);
+            BenchMapResult result = bench_map_run(
+                keys, miss_keys, key_count, [&](U64 key, U64 value) { legacy_map_insert(map, key, value); }, [&](U64 key) { return legacy_map_get(map, key); });
+            bench_map_result_print("chunked Map (sized)", key_count, result);
+            arena_pop_to(bench_arena, arena_base_pos);
+        }
+        else
+        {
+            INFO_LOG("    %-22s skipped, pass \"all\" to run it", "chunked Map (sized)");
+        }
+    }
+}
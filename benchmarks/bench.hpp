@@ -0,0 +1,43 @@
+#pragma once
+
+// ~mgj: Every benchmark is a function taking the command line arguments that follow its name.
+// Results are printed as one line per measured case so runs can be diffed.
+typedef void BenchFunc(Arena* arena, String8List args);
+
+struct BenchEntry
+{
+    String8 name;
+    BenchFunc* func;
+};
+
+struct BenchTiming
+{
+    U64 iterations;
+    U64 best_us;
+    U64 total_us;
+};
+
+g_internal void
+bench_timing_add(BenchTiming* timing, U64 elapsed_us)
+{
+    timing->best_us = timing->iterations ? Min(timing->best_us, elapsed_us) : elapsed_us;
+    timing->total_us += elapsed_us;
+    timing->iterations += 1;
+}
+
+g_internal F64
+bench_mb_per_s(U64 bytes, U64 elapsed_us)
+{
+    if (elapsed_us == 0)
+    {
+        return 0.0;
+    }
+    return ((F64)bytes / (F64)MB(1)) / ((F64)elapsed_us / (F64)Million(1));
+}
+
+// ~mgj: deterministic value in [0, 1) for synthetic inputs
+g_internal F32
+bench_unit_f32(U64 seed)
+{
+    return (F32)(hash_index_hash_u64(seed) >> 40) / (F32)(1ull << 24);
+}
@@ -0,0 +1,105 @@
+// user header
+#include "diagnostics.hpp"
+#include "base/base_inc.hpp"
+#include "async/segment_buffer.hpp"
+#include "async/async_heap.hpp"
+#include "async/mpmc_ring.hpp"
+#include "async/mpmc_queue.hpp"
+#include "async/timer_wheel.hpp"
+#include "async/spmc_queue.hpp"
+#include "async/thread_pool.hpp"
+#include "async/thread_pool_stats.hpp"
+#include "async/task_graph.hpp"
+#include "async/parallel.hpp"
+#include "simdjson/simdjson.h"
+#include "osm/osm_elements.hpp"
+#include "lib_wrappers/json.hpp"
+#include "city/json.hpp"
+#include "city/agent_wire.hpp"
+#include "city/agent_ingest.hpp"
+#include "city/agent_store.hpp"
+#include "city/road_bvh.hpp"
+#include "city/road_grid.hpp"
+#include "city/triangulate.hpp"
+
+// user source
+#include "base/base_inc.cpp"
+#include "async/segment_buffer.cpp"
+#include "async/async_heap.cpp"
+#include "async/mpmc_queue.cpp"
+#include "async/mpmc_ring.cpp"
+#include "async/timer_wheel.cpp"
+#include "async/spmc_queue.cpp"
+#include "async/thread_pool.cpp"
+#include "async/thread_pool_stats.cpp"
+#include "async/task_graph.cpp"
+#include "async/parallel.cpp"
+#include "osm/osm_elements.cpp"
+#include "lib_wrappers/json.cpp"
+#include "city/agent_wire.cpp"
+#include "city/agent_ingest.cpp"
+#include "city/agent_store.cpp"
+#include "city/road_bvh.cpp"
+#include "city/road_grid.cpp"
+#include "city/triangulate.cpp"
+
+// benchmark files
+#include "bench.hpp"
+#include "async/bench_parallel.cpp"
+#include "async/bench_queue.cpp"
+#include "base/bench_map.cpp"
+#include "city/bench_agent_ingest.cpp"
+#include "city/bench_agent_store.cpp"
+#include "city/bench_agent_wire.cpp"
+#include "city/bench_road_bvh.cpp"
+#include "city/bench_road_classify.cpp"
+#include "city/bench_road_grid.cpp"
+#include "city/bench_triangulate.cpp"
+#include "osm/bench_osm_ingest.cpp"
+
+g_internal BenchEntry g_bench_entries[] = {
+    {S("agent_ingest"), bench_agent_ingest},
+    {S("agent_store"), bench_agent_store},
+    {S("agent_wire"), bench_agent_wire},
+    {S("map"), bench_map},
+    {S("osm_ingest"), bench_osm_ingest},
+    {S("parallel"), bench_parallel},
+    {S("queue"), bench_queue},
+    {S("road_bvh"), bench_road_bvh},
+    {S("road_classify"), bench_road_classify},
+    {S("road_grid"), bench_road_grid},
+    {S("triangulate"), bench_triangulate},
+};
+
+// ~mgj: Usage: city_benchmarks [name [args...]]. Without a name every benchmark runs with its defaults.
+int
+App(int argc, char** argv)
+{
+    Arena* arena = arena_alloc();
+    Debug_SetName(arena, "bench arena");
+    defer(arena_release(arena));
+
+    String8 name = argc > 1 ? str8_c_string(argv[1]) : S("");
+    String8List args = {};
+    for (int i = 2; i < argc; ++i)
+    {
+        str8_list_push(arena, &args, str8_c_string(argv[i]));
+    }
+
+    B32 found = false;
+    for (U32 i = 0; i < ArrayCount(g_bench_entries); ++i)
+    {
+        BenchEntry* entry = &g_bench_entries[i];
+        if (name.size == 0 || str8_match(name, entry->name, 0))
+        {
+            entry->func(arena, name.size ? args : String8List{});
+            found = true;
+        }
+    }
+    if (!found)
+    {
+        ERROR_LOG("Unknown benchmark: %.*s", str8_varg(name));
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,53 @@
+// ~mgj: Agent update ingest of a synthetic websocket feed, every message of a frame is parsed and coalesced.
+// Usage: city_benchmarks agent_ingest [agent_count [messages_per_frame]]
+// Defaults to 10k agents and 6 messages per frame, a 30 Hz feed at 5 frames per second of backlog.
+
+g_internal String8
+bench_agent_ingest_msg_create(Arena* arena, U32 agent_count, U32 msg_idx)
+{
+    String8List parts = {};
+    str8_list_push(arena, &parts, S("["));
+    for (U32 agent_idx = 0; agent_idx < agent_count; ++agent_idx)
+    {
+        F64 lat = 56.1 + bench_unit_f32((U64)msg_idx * agent_count + agent_idx) * 0.05;
+        F64 lon = 10.1 + bench_unit_f32(((U64)msg_idx * agent_count + agent_idx) ^ 0x5bd1e995) * 0.05;
+        str8_list_push(arena, &parts, push_str8f(arena, "%s{\"id\": %u, \"lat\": %.8f, \"lon\": %.8f}", agent_idx ? "," : "", agent_idx, lat, lon));
+    }
+    str8_list_push(arena, &parts, S("]"));
+    return str8_list_join(arena, &parts, 0);
+}
+
+g_internal void
+bench_agent_ingest(Arena* arena, String8List args)
+{
+    U32 agent_count = args.node_count > 0 ? (U32)U64FromStr8(args.first->string, 10) : 10'000;
+    U32 msg_count = args.node_count > 1 ? (U32)U64FromStr8(args.first->next->string, 10) : 6;
+    const U32 frame_count = 100;
+
+    String8List msgs = {};
+    U64 msg_bytes = 0;
+    for (U32 msg_idx = 0; msg_idx < msg_count; ++msg_idx)
+    {
+        String8 msg = bench_agent_ingest_msg_create(arena, agent_count, msg_idx);
+        str8_list_push(arena, &msgs, msg);
+        msg_bytes += msg.size;
+    }
+
+    city::AgentIngest* ingest = city::agent_ingest_create();
+    defer(city::agent_ingest_release(ingest));
+    U64 frame_pos = arena_pos(arena);
+    BenchTiming timing = {};
+    U64 agent_total = 0;
+    for (U32 frame_idx = 0; frame_idx < frame_count; ++frame_idx)
+    {
+        U64 start_us = os_now_microseconds();
+        Buffer<city::Coordinate> coords = city::agent_ingest_run(ingest, arena, &msgs, os_now_unix_microseconds());
+        bench_timing_add(&timing, os_now_microseconds() - start_us);
+        agent_total += coords.size;
+        arena_pop_to(arena, frame_pos);
+    }
+
+    INFO_LOG("agent_ingest %u agents x %u msgs: %.2f MB per frame, %llu agents per frame", agent_count, msg_count, (F64)msg_bytes / (F64)MB(1), agent_total / frame_count);
+    INFO_LOG("    best %llu us, mean %llu us per frame, %.1f MB/s, %.0f msgs/s", timing.best_us, timing.total_us / timing.iterations, bench_mb_per_s(msg_bytes, timing.best_us),
+             (F64)msg_count * (F64)Million(1) / (F64)Max(timing.best_us, 1ull));
+}
@@ -0,0 +1,129 @@
+// ~mgj: agent_store_update on one thread with the scalar and the AVX2 kernels: frames where every agent has a
+// new sample, and frames without samples where the agents only move by the motion model (most frames with
+// a 5 Hz feed at 60 Hz). Reports those and the kernels on their own in ns per agent.
+// Usage: city_benchmarks agent_store [agent_count ...]
+// Defaults to 1K, 10K and 100K agents.
+
+g_internal U64
+bench_agent_store_frame_us(U32 frame_idx)
+{
+    return 1'000'000 + (U64)frame_idx * 16'667;
+}
+
+g_internal void
+bench_agent_store_coords_fill(Buffer<city::Coordinate> coords, U32 frame_idx)
+{
+    for (U64 agent_idx = 0; agent_idx < coords.size; ++agent_idx)
+    {
+        coords.data[agent_idx].id = (S64)agent_idx;
+        coords.data[agent_idx].lat = 56.1 + bench_unit_f32(agent_idx) * 0.05 + frame_idx * 2e-6;
+        coords.data[agent_idx].lon = 10.1 + bench_unit_f32(agent_idx ^ 0x5bd1e995) * 0.05 - frame_idx * 3e-6;
+        coords.data[agent_idx].timestamp_us = bench_agent_store_frame_us(frame_idx);
+    }
+}
+
+g_internal void
+bench_agent_store_run(Arena* arena, U32 agent_count)
+{
+    const U32 frame_count = 50;
+    // ~mgj: a rotation and an origin shift like the tileset's ecef_to_local
+    F64 ecef_to_local[16] = {-0.17, -0.83, 0.53, 0.0, 0.98, -0.14, 0.09, 0.0, 0.0, 0.54, 0.84, 0.0, 0.0, 0.0, -6.36e6, 1.0};
+
+    U64 frame_pos = arena_pos(arena);
+    Buffer<city::Coordinate>* frames = PushArray(arena, Buffer<city::Coordinate>, frame_count);
+    for (U32 frame_idx = 0; frame_idx < frame_count; ++frame_idx)
+    {
+        frames[frame_idx] = buffer_alloc<city::Coordinate>(arena, agent_count);
+        bench_agent_store_coords_fill(frames[frame_idx], frame_idx);
+    }
+    F64* lat = PushArrayNoZero(arena, F64, agent_count);
+    F64* lon = PushArrayNoZero(arena, F64, agent_count);
+    F64* ecef = PushArrayNoZero(arena, F64, (U64)agent_count * 3);
+    for (U32 agent_idx = 0; agent_idx < agent_count; ++agent_idx)
+    {
+        lat[agent_idx] = frames[0].data[agent_idx].lat;
+        lon[agent_idx] = frames[0].data[agent_idx].lon;
+    }
+
+    for (U32 use_avx2 = 0; use_avx2 < 2; ++use_avx2)
+    {
+        city::AgentStore* store = city::agent_store_create(agent_count);
+        defer(city::agent_store_release(store));
+        if (use_avx2 && !store->use_avx2)
+        {
+            INFO_LOG("agent_store %6u agents avx2: not supported by this CPU", agent_count);
+            continue;
+        }
+        store->use_avx2 = use_avx2;
+        city::AgentMotionConfig motion = city::agent_motion_config_default();
+        motion.playback_delay_us = 50'000;
+        city::agent_store_update(0, store, frames[0], ecef_to_local, 1.0f, &motion, bench_agent_store_frame_us(0));
+
+        BenchTiming update_timing = {};
+        BenchTiming motion_only_timing = {};
+        BenchTiming ecef_timing = {};
+        BenchTiming motion_timing = {};
+        BenchTiming transform_timing = {};
+        for (U32 frame_idx = 1; frame_idx < frame_count; ++frame_idx)
+        {
+            U64 frame_us = bench_agent_store_frame_us(frame_idx);
+            U64 start_us = os_now_microseconds();
+            city::agent_store_update(0, store, frames[frame_idx], ecef_to_local, 1.0f, &motion, frame_us);
+            bench_timing_add(&update_timing, os_now_microseconds() - start_us);
+
+            start_us = os_now_microseconds();
+            city::agent_store_update(0, store, {}, ecef_to_local, 1.0f, &motion, frame_us + 8'000);
+            bench_timing_add(&motion_only_timing, os_now_microseconds() - start_us);
+
+            start_us = os_now_microseconds();
+            if (use_avx2)
+            {
+                city::_agent_store_ecef_from_wgs84_avx2(lat, lon, agent_count, ecef, ecef + agent_count, ecef + 2 * (U64)agent_count);
+            }
+            else
+            {
+                city::_agent_store_ecef_from_wgs84(lat, lon, agent_count, ecef, ecef + agent_count, ecef + 2 * (U64)agent_count);
+            }
+            bench_timing_add(&ecef_timing, os_now_microseconds() - start_us);
+
+            start_us = os_now_microseconds();
+            city::_agent_store_motion(store, 0, store->count, (S64)frame_us - 40'000, &motion);
+            bench_timing_add(&motion_timing, os_now_microseconds() - start_us);
+
+            start_us = os_now_microseconds();
+            if (use_avx2)
+            {
+                city::_agent_store_transforms_avx2(store, 0, store->count, ecef_to_local, 1.0f);
+            }
+            else
+            {
+                city::_agent_store_transforms(store, 0, store->count, ecef_to_local, 1.0f);
+            }
+            bench_timing_add(&transform_timing, os_now_microseconds() - start_us);
+        }
+        AssertAlways(store->count == agent_count);
+
+        F64 ns_per_agent = 1000.0 / (F64)agent_count;
+        INFO_LOG("agent_store %6u agents %-6s: update %6.1f ns/agent (best %llu us), without samples %5.1f ns/agent", agent_count, use_avx2 ? "avx2" : "scalar",
+                 (F64)update_timing.best_us * ns_per_agent, update_timing.best_us, (F64)motion_only_timing.best_us * ns_per_agent);
+        INFO_LOG("    ecef %5.1f ns/agent, motion %5.1f ns/agent, transform %5.1f ns/agent", (F64)ecef_timing.best_us * ns_per_agent, (F64)motion_timing.best_us * ns_per_agent,
+                 (F64)transform_timing.best_us * ns_per_agent);
+    }
+    arena_pop_to(arena, frame_pos);
+}
+
+g_internal void
+bench_agent_store(Arena* arena, String8List args)
+{
+    if (args.node_count == 0)
+    {
+        bench_agent_store_run(arena, 1'000);
+        bench_agent_store_run(arena, 10'000);
+        bench_agent_store_run(arena, 100'000);
+        return;
+    }
+    for (String8Node* node = args.first; node; node = node->next)
+    {
+        bench_agent_store_run(arena, (U32)U64FromStr8(node->string, 10));
+    }
+}
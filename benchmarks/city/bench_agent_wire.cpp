@@ -0,0 +1,114 @@
+// ~mgj: Agent feed encodings side by side. A stand-in publisher moves agent_count agents at city speeds and
+// publishes messages_per_frame ticks of a 30 Hz feed as JSON, binary F64, binary Fixed32 and binary
+// Fixed32 with delta frames; every encoding is then ingested the way the main loop does it.
+// Usage: city_benchmarks agent_wire [agent_count [messages_per_frame]]
+
+struct BenchAgentPublisher
+{
+    Buffer<city::Coordinate> coords;
+    Buffer<F64> lat_velocity; // degrees per tick
+    Buffer<F64> lon_velocity;
+};
+
+g_internal BenchAgentPublisher
+bench_agent_publisher_create(Arena* arena, U32 agent_count)
+{
+    BenchAgentPublisher publisher = {};
+    publisher.coords = buffer_alloc<city::Coordinate>(arena, agent_count);
+    publisher.lat_velocity = buffer_alloc<F64>(arena, agent_count);
+    publisher.lon_velocity = buffer_alloc<F64>(arena, agent_count);
+    for (U32 agent_idx = 0; agent_idx < agent_count; ++agent_idx)
+    {
+        publisher.coords.data[agent_idx].id = agent_idx;
+        publisher.coords.data[agent_idx].lat = 56.1 + bench_unit_f32(agent_idx) * 0.05;
+        publisher.coords.data[agent_idx].lon = 10.1 + bench_unit_f32(agent_idx ^ 0x5bd1e995) * 0.05;
+        // ~mgj: up to about 15 m/s at 30 Hz
+        publisher.lat_velocity.data[agent_idx] = (bench_unit_f32(agent_idx * 3 + 1) - 0.5) * 9e-6;
+        publisher.lon_velocity.data[agent_idx] = (bench_unit_f32(agent_idx * 3 + 2) - 0.5) * 16e-6;
+    }
+    return publisher;
+}
+
+g_internal void
+bench_agent_publisher_tick(BenchAgentPublisher* publisher)
+{
+    for (U64 agent_idx = 0; agent_idx < publisher->coords.size; ++agent_idx)
+    {
+        publisher->coords.data[agent_idx].lat += publisher->lat_velocity.data[agent_idx];
+        publisher->coords.data[agent_idx].lon += publisher->lon_velocity.data[agent_idx];
+    }
+}
+
+g_internal String8
+bench_agent_publisher_json(Arena* arena, BenchAgentPublisher* publisher)
+{
+    String8List parts = {};
+    str8_list_push(arena, &parts, S("["));
+    for (U64 agent_idx = 0; agent_idx < publisher->coords.size; ++agent_idx)
+    {
+        city::Coordinate* coord = &publisher->coords.data[agent_idx];
+        str8_list_push(arena, &parts, push_str8f(arena, "%s{\"id\": %lld, \"lat\": %.8f, \"lon\": %.8f}", agent_idx ? "," : "", coord->id, coord->lat, coord->lon));
+    }
+    str8_list_push(arena, &parts, S("]"));
+    return str8_list_join(arena, &parts, 0);
+}
+
+g_internal void
+bench_agent_wire(Arena* arena, String8List args)
+{
+    U32 agent_count = args.node_count > 0 ? (U32)U64FromStr8(args.first->string, 10) : 10'000;
+    U32 msg_count = args.node_count > 1 ? (U32)U64FromStr8(args.first->next->string, 10) : 6;
+    const U32 frame_count = 100;
+
+    const char* names[] = {"json", "f64", "fixed32", "fixed32 delta"};
+    for (U32 variant = 0; variant < ArrayCount(names); ++variant)
+    {
+        U64 variant_pos = arena_pos(arena);
+        BenchAgentPublisher publisher = bench_agent_publisher_create(arena, agent_count);
+        city::AgentWireEncoder* encoder = 0;
+        if (variant > 0)
+        {
+            city::AgentWireEncoding encoding = variant == 1 ? city::AgentWireEncoding_F64 : city::AgentWireEncoding_Fixed32;
+            encoder = city::agent_wire_encoder_create(encoding, variant == 3, 0);
+        }
+
+        // ~mgj: the first message is a key frame, so every ingest pass below decodes the whole chain
+        String8List msgs = {};
+        U64 msg_bytes = 0;
+        U64 encode_start_us = os_now_microseconds();
+        for (U32 msg_idx = 0; msg_idx < msg_count; ++msg_idx)
+        {
+            bench_agent_publisher_tick(&publisher);
+            String8 msg = encoder ? city::agent_wire_encode(arena, encoder, publisher.coords, 0) : bench_agent_publisher_json(arena, &publisher);
+            str8_list_push(arena, &msgs, msg);
+            msg_bytes += msg.size;
+        }
+        U64 encode_us = os_now_microseconds() - encode_start_us;
+
+        city::AgentIngest* ingest = city::agent_ingest_create();
+        U64 frame_pos = arena_pos(arena);
+        BenchTiming timing = {};
+        U64 agent_total = 0;
+        for (U32 frame_idx = 0; frame_idx < frame_count; ++frame_idx)
+        {
+            U64 start_us = os_now_microseconds();
+            Buffer<city::Coordinate> coords = city::agent_ingest_run(ingest, arena, &msgs, os_now_unix_microseconds());
+            bench_timing_add(&timing, os_now_microseconds() - start_us);
+            agent_total += coords.size;
+            arena_pop_to(arena, frame_pos);
+        }
+        AssertAlways(ingest->stats.failed_message_count == 0);
+
+        INFO_LOG("agent_wire %-13s %u agents x %u msgs: %7.1f KB per msg, %5.1f bytes per agent, publish %llu us", names[variant], agent_count, msg_count,
+                 (F64)msg_bytes / (F64)msg_count / 1024.0, (F64)msg_bytes / ((F64)msg_count * (F64)agent_count), encode_us);
+        INFO_LOG("    ingest best %llu us, mean %llu us per frame, %.0f msgs/s, %llu agents per frame", timing.best_us, timing.total_us / timing.iterations,
+                 (F64)msg_count * (F64)Million(1) / (F64)Max(timing.best_us, 1ull), agent_total / frame_count);
+
+        city::agent_ingest_release(ingest);
+        if (encoder)
+        {
+            city::agent_wire_encoder_release(encoder);
+        }
+        arena_pop_to(arena, variant_pos);
+    }
+}
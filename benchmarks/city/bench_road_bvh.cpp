@@ -0,0 +1,387 @@
+// ~mgj: Road segment BVH benchmark. Builds the BVH over synthetic road networks with the binned SAH
+// builder and the previous median split builder, then measures build time and the average number of
+// nodes the CPU mirror of road_intersection.comp visits per query.
+// Usage: city_benchmarks road_bvh [all]
+// The median builder's Lomuto quick select is quadratic on sorted input, so on the 1M sorted grid it
+// takes seconds and is only run with "all".
+
+// ~mgj: The median split builder that the SAH builder replaced, kept verbatim (renamed) as the
+// baseline for this benchmark.
+struct LegacyRoadSegmentNode
+{
+    LegacyRoadSegmentNode* next;
+    LegacyRoadSegmentNode* parent;
+    U32 final_idx;
+    Rng2F32 bounds;
+    LegacyRoadSegmentNode* children[2];
+    U32 split_axis;
+    F32 split_value;
+
+    // buffer range
+    U32 start_idx;
+    U32 end_idx;
+};
+
+struct LegacyBvhContext
+{
+    LegacyRoadSegmentNode* stack;
+    LegacyRoadSegmentNode* root;
+
+    U32 road_segment_node_count;
+
+    Buffer<city::RoadSegmentCorners> road_segment_buffer;
+    Buffer<city::BoundingBox> bb_buffer;
+
+    U32 leaf_bb_max;
+};
+
+g_internal void
+legacy_quick_select(Buffer<city::BoundingBox> center_buffer, U32 split_axis, U32 start_idx, U32 end_idx, U32 k)
+{
+    Assert(k < center_buffer.size);
+
+    while (start_idx < end_idx)
+    {
+        U32 pivot_idx = end_idx - 1;
+        F32 pivot = center_buffer.data[pivot_idx].center.v[split_axis];
+
+        U32 divider_idx = start_idx;
+        for (U32 i = start_idx; i < pivot_idx; ++i)
+        {
+            if (center_buffer.data[i].center.v[split_axis] < pivot)
+            {
+                Swap(city::BoundingBox, center_buffer.data[i], center_buffer.data[divider_idx]);
+                divider_idx++;
+            }
+        }
+
+        Swap(city::BoundingBox, center_buffer.data[divider_idx], center_buffer.data[pivot_idx]);
+
+        if (divider_idx == k)
+        {
+            break;
+        }
+        else if (divider_idx < k)
+        {
+            start_idx = divider_idx + 1;
+        }
+        else
+        {
+            end_idx = divider_idx;
+        }
+    }
+}
+
+g_internal Rng2F32
+legacy_bounds_union(Buffer<city::BoundingBox> center_buffer, U32 start_idx, U32 end_idx)
+{
+    Rng2F32 bounds = rng2f32_inverted_inf();
+    for (U32 i = start_idx; i < end_idx; ++i)
+    {
+        city::BoundingBox seg_center = center_buffer.data[i];
+        bounds = city::bounds_union(bounds, seg_center.bounds);
+    }
+    return bounds;
+}
+
+g_internal Axis2
+legacy_split_axis_find(Buffer<city::BoundingBox> bb_buffer, U32 start_idx, U32 end_idx)
+{
+    Rng2F32 bounds = rng2f32_inverted_inf();
+    for (U32 i = start_idx; i < end_idx; ++i)
+    {
+        city::BoundingBox* seg_center = bb_buffer[i];
+        for (U32 ax_idx = 0; ax_idx < Axis2_COUNT; ++ax_idx)
+        {
+            if (seg_center->center.v[ax_idx] < bounds.min.v[ax_idx])
+            {
+                bounds.min.v[ax_idx] = seg_center->center.v[ax_idx];
+            }
+
+            if (seg_center->center.v[ax_idx] > bounds.max.v[ax_idx])
+            {
+                bounds.max.v[ax_idx] = seg_center->center.v[ax_idx];
+            }
+        }
+    }
+
+    Vec2F32 diff = sub_2f32(bounds.max, bounds.min);
+    Axis2 split_axis = diff.x > diff.y ? Axis2_X : Axis2_Y;
+    return split_axis;
+}
+
+g_internal city::BvhResult
+legacy_bvh_create(Arena* arena, Buffer<city::RoadSegmentCorners> road_segment_buffer, U32 leaf_bb_max)
+{
+    ScratchScope scratch = ScratchScope(&arena, 1);
+
+    Buffer<city::BoundingBox> bb_buffer = buffer_alloc<city::BoundingBox>(scratch.arena, road_segment_buffer.size);
+
+    // 1. for every element in the buffer, find the center point (used for segmentation)
+    for (U32 i = 0; i < bb_buffer.size; i++)
+    {
+        // init idx to later point to RoadSegmentCorners*
+        bb_buffer.data[i].idx = i;
+
+        // create bounding box around road segment
+        Rng2F32 bounds = rng2f32_inverted_inf();
+        for (U32 j = 0; j < Corner_COUNT; ++j)
+        {
+            city::RoadSegmentCorners* seg = road_segment_buffer[i];
+            Vec2F32 corner = seg->corners[j];
+            bounds = city::bounds_union(bounds, corner);
+        }
+        bb_buffer.data[i].bounds = bounds;
+
+        // find center point
+        Vec2F32 center = {};
+        for (U32 j = 0; j < Corner_COUNT; ++j)
+        {
+            city::RoadSegmentCorners* seg = road_segment_buffer[i];
+            Vec2F32 corner = seg->corners[j];
+            center = add_2f32(center, corner);
+        }
+        bb_buffer.data[i].center = scale_2f32(center, 1.0f / (F32)Corner_COUNT);
+    }
+
+    LegacyBvhContext* bvh = PushStruct(scratch.arena, LegacyBvhContext);
+    bvh->road_segment_buffer = road_segment_buffer;
+    bvh->bb_buffer = bb_buffer;
+    bvh->leaf_bb_max = leaf_bb_max;
+
+    LegacyRoadSegmentNode* root = PushStruct(scratch.arena, LegacyRoadSegmentNode);
+    bvh->root = root;
+    root->bounds = legacy_bounds_union(bb_buffer, 0, bb_buffer.size);
+    root->start_idx = 0;
+    root->end_idx = bb_buffer.size;
+
+    SLLStackPush(bvh->stack, root);
+
+    Buffer<city::RoadSegmentCorners> road_segment_buffer_sorted = buffer_alloc<city::RoadSegmentCorners>(arena, bvh->road_segment_buffer.size);
+    while (bvh->stack)
+    {
+        bvh->road_segment_node_count += 1;
+        LegacyRoadSegmentNode* node = bvh->stack;
+        SLLStackPop(bvh->stack);
+
+        U32 num_elem = node->end_idx - node->start_idx;
+
+        if (num_elem <= leaf_bb_max)
+        {
+            for (U32 i = node->start_idx; i < node->end_idx; ++i)
+            {
+                // copy road segment corners from bb_buffer index to sorted buffer
+                city::BoundingBox bb = bvh->bb_buffer.data[i];
+                road_segment_buffer_sorted.data[i] = bvh->road_segment_buffer.data[bb.idx];
+            }
+            continue;
+        }
+
+        Axis2 split_axis = legacy_split_axis_find(bvh->bb_buffer, node->start_idx, node->end_idx);
+        U32 split_idx = node->start_idx + (num_elem) / 2;
+        legacy_quick_select(bb_buffer, (U32)split_axis, node->start_idx, node->end_idx, split_idx);
+        node->split_axis = split_axis;
+        node->split_value = bb_buffer.data[split_idx].center.v[(U32)split_axis];
+
+        Rng2F32 idx_range = rng_2f32(V2F32(node->start_idx, split_idx), V2F32(split_idx, node->end_idx));
+
+        for (U32 i = 0; i < ArrayCount(idx_range.v); ++i)
+        {
+            node->children[i] = PushStruct(scratch.arena, LegacyRoadSegmentNode);
+            node->children[i]->start_idx = idx_range.min.v[i];
+            node->children[i]->end_idx = idx_range.max.v[i];
+            node->children[i]->bounds = legacy_bounds_union(bb_buffer, node->children[i]->start_idx, node->children[i]->end_idx);
+        }
+
+        SLLStackPush(bvh->stack, node->children[1]);
+        SLLStackPush(bvh->stack, node->children[0]);
+    }
+
+    // create the final road segment node for storage buffer usage
+    Buffer<city::RoadSegmentNodeStorageBuffer> road_segment_node_buffer = buffer_alloc<city::RoadSegmentNodeStorageBuffer>(arena, bvh->road_segment_node_count);
+    Assert(bvh->stack == 0);
+    SLLStackPush(bvh->stack, bvh->root);
+    U32 cur_node_idx = 0;
+    while (bvh->stack)
+    {
+        LegacyRoadSegmentNode* node = bvh->stack;
+        SLLStackPop(bvh->stack);
+
+        node->final_idx = cur_node_idx++;
+        city::RoadSegmentNodeStorageBuffer* current = road_segment_node_buffer[node->final_idx];
+        current->min_x = node->bounds.min.x;
+        current->min_y = node->bounds.min.y;
+        current->max_x = node->bounds.max.x;
+        current->max_y = node->bounds.max.y;
+        current->split_axis = node->split_axis;
+        current->split_value = node->split_value;
+
+        // fill out parent nodes second child idx
+        if (node->parent)
+        {
+            U32 parent_idx = node->parent->final_idx;
+            city::RoadSegmentNodeStorageBuffer* parent = road_segment_node_buffer[parent_idx];
+            parent->child_1_idx = node->final_idx;
+        }
+
+        if (node->children[0] && node->children[1])
+        {
+            current->is_leaf = false;
+            current->child_0_idx = cur_node_idx;
+
+            SLLStackPush(bvh->stack, node->children[1]);
+            SLLStackPush(bvh->stack, node->children[0]);
+            node->children[1]->parent = node;
+        }
+        else
+        {
+            current->is_leaf = true;
+            current->start_idx = node->start_idx;
+            current->end_idx = node->end_idx;
+        }
+    }
+    Assert(cur_node_idx == road_segment_node_buffer.size);
+
+    city::BvhResult result = {road_segment_buffer_sorted, road_segment_node_buffer};
+    return result;
+}
+
+g_internal city::RoadSegmentCorners
+bench_road_segment(U64 edge_id, Vec2F32 from, Vec2F32 to, F32 width)
+{
+    Vec2F32 dir = normalize_2f32(sub_2f32(to, from));
+    Vec2F32 offset = V2F32(-dir.y * width * 0.5f, dir.x * width * 0.5f);
+    city::RoadSegmentCorners segment = {};
+    segment.edge_id = (osm::EdgeId)edge_id;
+    segment.corners[city::RoadSegmentCornerCoord_TopLeft] = add_2f32(from, offset);
+    segment.corners[city::RoadSegmentCornerCoord_TopRight] = add_2f32(to, offset);
+    segment.corners[city::RoadSegmentCornerCoord_BottomRight] = sub_2f32(to, offset);
+    segment.corners[city::RoadSegmentCornerCoord_BottomLeft] = sub_2f32(from, offset);
+    return segment;
+}
+
+// ~mgj: winding roads of 50 segments each, stored road by road like the OSM edge buffer
+g_internal Buffer<city::RoadSegmentCorners>
+bench_roads_create(Arena* arena, U64 segment_count)
+{
+    Buffer<city::RoadSegmentCorners> segments = buffer_alloc<city::RoadSegmentCorners>(arena, segment_count);
+    F32 extent = sqrtf((F32)segment_count) * 25.0f;
+    Vec2F32 pos = {};
+    F32 heading = 0.0f;
+    for (U64 i = 0; i < segment_count; ++i)
+    {
+        if (i % 50 == 0)
+        {
+            pos = V2F32(bench_unit_f32(4 * i) * extent, bench_unit_f32(4 * i + 1) * extent);
+            heading = bench_unit_f32(4 * i + 2) * 6.2831853f;
+        }
+        heading += (bench_unit_f32(4 * i + 3) - 0.5f) * 0.4f;
+        F32 length = 15.0f + 15.0f * bench_unit_f32(i + segment_count);
+        Vec2F32 next_pos = add_2f32(pos, V2F32(cosf(heading) * length, sinf(heading) * length));
+        segments.data[i] = bench_road_segment(i, pos, next_pos, 6.0f);
+        pos = next_pos;
+    }
+    return segments;
+}
+
+// ~mgj: a street grid emitted row by row, so the centers are sorted along both axes
+g_internal Buffer<city::RoadSegmentCorners>
+bench_grid_create(Arena* arena, U64 segment_count)
+{
+    Buffer<city::RoadSegmentCorners> segments = buffer_alloc<city::RoadSegmentCorners>(arena, segment_count);
+    U64 side = (U64)ceilf(sqrtf((F32)segment_count));
+    for (U64 i = 0; i < segment_count; ++i)
+    {
+        Vec2F32 from = V2F32((F32)(i % side) * 30.0f, (F32)(i / side) * 30.0f);
+        segments.data[i] = bench_road_segment(i, from, add_2f32(from, V2F32(24.0f, 0.0f)), 6.0f);
+    }
+    return segments;
+}
+
+g_internal void
+bench_road_bvh_run(const char* name, Buffer<city::RoadSegmentCorners> segments, Buffer<Vec2F32> queries, F64 build_ms, city::BvhResult* bvh)
+{
+    U64 nodes_visited = 0;
+    U64 hit_count = 0;
+    U64 query_start = os_now_microseconds();
+    for (Vec2F32 query : queries)
+    {
+        city::BvhQueryResult result = city::bvh_point_query(bvh, query);
+        nodes_visited += result.nodes_visited;
+        hit_count += result.segment_idx != max_U32;
+    }
+    U64 query_us = os_now_microseconds() - query_start;
+    INFO_LOG("    %-14s build %9.2f ms, %8llu nodes, %6.2f nodes/query, %5.1f%% hits, %7.2f Mquery/s", name, build_ms, bvh->node_buffer.size, (F64)nodes_visited / (F64)queries.size,
+             100.0 * (F64)hit_count / (F64)queries.size, (F64)queries.size / Max((F64)query_us, 1.0));
+    (void)segments;
+}
+
+g_internal void
+bench_road_bvh(Arena* arena, String8List args)
+{
+    (void)arena;
+    B32 run_all = args.first && str8_match(args.first->string, S("all"), 0);
+    U32 thread_count = Max(OS_GetSystemInfo()->logical_processor_count, 2u) - 1;
+    const U32 leaf_bb_max = 10;
+    const U64 segment_counts[] = {Thousand(10), Thousand(100), Million(1)};
+    for (U32 layout_idx = 0; layout_idx < 2; ++layout_idx)
+    {
+        B32 is_grid = layout_idx == 1;
+        for (U64 segment_count : segment_counts)
+        {
+            Arena* bench_arena = arena_alloc();
+            Debug_SetName(bench_arena, "bench road bvh arena");
+            defer(arena_release(bench_arena));
+            async::ThreadPool* thread_pool = async::thread_pool_create(bench_arena, thread_count, 256, 16);
+            defer(async::thread_pool_destroy(thread_pool));
+
+            Buffer<city::RoadSegmentCorners> segments = is_grid ? bench_grid_create(bench_arena, segment_count) : bench_roads_create(bench_arena, segment_count);
+
+            // ~mgj: half the queries are segment centers, the other half random points in the bounds
+            Rng2F32 bounds = rng2f32_inverted_inf();
+            for (city::RoadSegmentCorners& segment : segments)
+            {
+                for (Vec2F32 corner : segment.corners)
+                {
+                    bounds = city::bounds_union(bounds, corner);
+                }
+            }
+            Buffer<Vec2F32> queries = buffer_alloc<Vec2F32>(bench_arena, Min(segment_count, Thousand(100)) * 2);
+            for (U64 i = 0; i < queries.size / 2; ++i)
+            {
+                city::RoadSegmentCorners* segment = &segments.data[hash_index_hash_u64(i) % segments.size];
+                queries.data[2 * i] = scale_2f32(add_2f32(segment->corners[0], segment->corners[2]), 0.5f);
+                queries.data[2 * i + 1] = V2F32(bounds.min.x + bench_unit_f32(3 * i) * (bounds.max.x - bounds.min.x), bounds.min.y + bench_unit_f32(3 * i + 1) * (bounds.max.y - bounds.min.y));
+            }
+
+            INFO_LOG("road_bvh %s %llu segments, %u threads", is_grid ? "sorted grid" : "roads", segment_count, thread_count + 1);
+            {
+                U64 arena_base_pos = arena_pos(bench_arena);
+                BenchTiming timing = {};
+                city::BvhResult bvh = {};
+                for (U32 iteration = 0; iteration < 5; ++iteration)
+                {
+                    arena_pop_to(bench_arena, arena_base_pos);
+                    U64 start = os_now_microseconds();
+                    bvh = city::bvh_create(thread_pool, bench_arena, segments, leaf_bb_max);
+                    bench_timing_add(&timing, os_now_microseconds() - start);
+                }
+                bench_road_bvh_run("SAH", segments, queries, (F64)timing.best_us / 1000.0, &bvh);
+                arena_pop_to(bench_arena, arena_base_pos);
+            }
+            if (!is_grid || segment_count <= Thousand(100) || run_all)
+            {
+                U64 arena_base_pos = arena_pos(bench_arena);
+                U64 start = os_now_microseconds();
+                city::BvhResult bvh = legacy_bvh_create(bench_arena, segments, leaf_bb_max);
+                F64 build_ms = (F64)(os_now_microseconds() - start) / 1000.0;
+                bench_road_bvh_run("median", segments, queries, build_ms, &bvh);
+                arena_pop_to(bench_arena, arena_base_pos);
+            }
+            else
+            {
+                INFO_LOG("    %-14s skipped, pass \"all\" to run it", "median");
+            }
+        }
+    }
+}
@@ -0,0 +1,87 @@
+// ~mgj: Road overlay classification benchmark. Classifies the triangle centroids of a tile like mesh
+// against the road segment BVH, the work road_intersection.comp does per tile, with the scalar CPU
+// mirror, the SSE packet traversal and the packet traversal split over the thread pool.
+// Usage: city_benchmarks road_classify
+
+g_internal void
+bench_road_classify_report(const char* name, BenchTiming* timing, Buffer<U32> segment_idx)
+{
+    U64 hit_count = 0;
+    for (U32 idx : segment_idx)
+    {
+        hit_count += idx != max_U32;
+    }
+    INFO_LOG("    %-14s %9.2f ms, %5.1f%% on road, %7.2f Mtriangles/s", name, (F64)timing->best_us / 1000.0, 100.0 * (F64)hit_count / (F64)segment_idx.size,
+             (F64)segment_idx.size / Max((F64)timing->best_us, 1.0));
+}
+
+g_internal void
+bench_road_classify(Arena* arena, String8List args)
+{
+    (void)arena;
+    (void)args;
+    U32 thread_count = Max(OS_GetSystemInfo()->logical_processor_count, 2u) - 1;
+    const U64 segment_counts[] = {Thousand(10), Thousand(100)};
+    const U64 triangle_count = Million(2);
+    for (U64 segment_count : segment_counts)
+    {
+        Arena* bench_arena = arena_alloc();
+        Debug_SetName(bench_arena, "bench road classify arena");
+        defer(arena_release(bench_arena));
+        async::ThreadPool* thread_pool = async::thread_pool_create(bench_arena, thread_count, 256, 16);
+        defer(async::thread_pool_destroy(thread_pool));
+
+        Buffer<city::RoadSegmentCorners> segments = bench_roads_create(bench_arena, segment_count);
+        city::BvhResult bvh = city::bvh_create(thread_pool, bench_arena, segments, 10);
+        Rng2F32 bounds = {.min = V2F32(bvh.node_buffer.data[0].min_x, bvh.node_buffer.data[0].min_y), .max = V2F32(bvh.node_buffer.data[0].max_x, bvh.node_buffer.data[0].max_y)};
+
+        // ~mgj: centroids of a regular grid of triangle pairs over the road bounds, emitted row by row
+        // like a tile mesh so neighbouring triangles end up in the same packet
+        U64 side = (U64)ceilf(sqrtf((F32)(triangle_count / 2)));
+        Vec2F32 cell_dim = V2F32((bounds.max.x - bounds.min.x) / (F32)side, (bounds.max.y - bounds.min.y) / (F32)side);
+        Buffer<Vec2F32> centroids = buffer_alloc<Vec2F32>(bench_arena, triangle_count);
+        for (U64 i = 0; i < triangle_count; ++i)
+        {
+            U64 cell_idx = i / 2;
+            Vec2F32 cell_min = V2F32(bounds.min.x + (F32)(cell_idx % side) * cell_dim.x, bounds.min.y + (F32)(cell_idx / side) * cell_dim.y);
+            F32 offset = (i % 2) ? 2.0f / 3.0f : 1.0f / 3.0f;
+            centroids.data[i] = add_2f32(cell_min, V2F32(cell_dim.x * offset, cell_dim.y * (1.0f - offset)));
+        }
+        Buffer<U32> segment_idx = buffer_alloc<U32>(bench_arena, triangle_count);
+
+        INFO_LOG("road_classify %llu segments, %llu triangles, %u threads", segment_count, triangle_count, thread_count + 1);
+        {
+            BenchTiming timing = {};
+            for (U32 iteration = 0; iteration < 3; ++iteration)
+            {
+                U64 start = os_now_microseconds();
+                for (U64 i = 0; i < centroids.size; ++i)
+                {
+                    segment_idx.data[i] = city::bvh_point_query(&bvh, centroids.data[i]).segment_idx;
+                }
+                bench_timing_add(&timing, os_now_microseconds() - start);
+            }
+            bench_road_classify_report("scalar", &timing, segment_idx);
+        }
+        {
+            BenchTiming timing = {};
+            for (U32 iteration = 0; iteration < 3; ++iteration)
+            {
+                U64 start = os_now_microseconds();
+                city::bvh_points_classify(&bvh, centroids, segment_idx);
+                bench_timing_add(&timing, os_now_microseconds() - start);
+            }
+            bench_road_classify_report("packet", &timing, segment_idx);
+        }
+        {
+            BenchTiming timing = {};
+            for (U32 iteration = 0; iteration < 3; ++iteration)
+            {
+                U64 start = os_now_microseconds();
+                city::bvh_points_classify_parallel(thread_pool, &bvh, centroids, segment_idx);
+                bench_timing_add(&timing, os_now_microseconds() - start);
+            }
+            bench_road_classify_report("packet parallel", &timing, segment_idx);
+        }
+    }
+}
@@ -0,0 +1,96 @@
+// ~mgj: Nearest road queries against the road grid and road_grid_transforms_snap, the per frame work of snapping
+// the live agents. The roads are the centre lines of bench_roads_create, the agents are spread along them up to
+// 8 m off the road.
+// Usage: city_benchmarks road_grid [query_count]
+// Defaults to 100K queries per frame.
+
+g_internal void
+bench_road_grid(Arena* arena, String8List args)
+{
+    (void)arena;
+    U64 query_count = args.node_count > 0 ? U64FromStr8(args.first->string, 10) : Thousand(100);
+    U32 thread_count = Max(OS_GetSystemInfo()->logical_processor_count, 2u) - 1;
+    const U64 segment_counts[] = {Thousand(10), Thousand(100)};
+    const F32 max_distance = 15.0f;
+    for (U64 segment_count : segment_counts)
+    {
+        Arena* bench_arena = arena_alloc();
+        Debug_SetName(bench_arena, "bench road grid arena");
+        defer(arena_release(bench_arena));
+        async::ThreadPool* thread_pool = async::thread_pool_create(bench_arena, thread_count, 256, 16);
+        defer(async::thread_pool_destroy(thread_pool));
+
+        Buffer<city::RoadSegmentCorners> segments = bench_roads_create(bench_arena, segment_count);
+        Buffer<Vec2F32> from = buffer_alloc<Vec2F32>(bench_arena, segment_count);
+        Buffer<Vec2F32> to = buffer_alloc<Vec2F32>(bench_arena, segment_count);
+        Buffer<osm::EdgeId> edge_ids = buffer_alloc<osm::EdgeId>(bench_arena, segment_count);
+        for (U64 i = 0; i < segment_count; ++i)
+        {
+            Vec2F32* corners = segments.data[i].corners;
+            from.data[i] = scale_2f32(add_2f32(corners[city::RoadSegmentCornerCoord_TopLeft], corners[city::RoadSegmentCornerCoord_BottomLeft]), 0.5f);
+            to.data[i] = scale_2f32(add_2f32(corners[city::RoadSegmentCornerCoord_TopRight], corners[city::RoadSegmentCornerCoord_BottomRight]), 0.5f);
+            edge_ids.data[i] = segments.data[i].edge_id;
+        }
+
+        Buffer<Vec2F32> points = buffer_alloc<Vec2F32>(bench_arena, query_count);
+        for (U64 i = 0; i < query_count; ++i)
+        {
+            U64 segment_idx = (U64)(bench_unit_f32(3 * i) * (F32)(segment_count - 1));
+            Vec2F32 dir = sub_2f32(to.data[segment_idx], from.data[segment_idx]);
+            Vec2F32 normal = normalize_2f32(V2F32(-dir.y, dir.x));
+            Vec2F32 on_road = add_2f32(from.data[segment_idx], scale_2f32(dir, bench_unit_f32(3 * i + 1)));
+            points.data[i] = add_2f32(on_road, scale_2f32(normal, (bench_unit_f32(3 * i + 2) - 0.5f) * 16.0f));
+        }
+        Buffer<city::RoadGridHit> hits = buffer_alloc<city::RoadGridHit>(bench_arena, query_count);
+
+        U64 build_start_us = os_now_microseconds();
+        city::RoadGrid grid = city::road_grid_create(bench_arena, from, to, edge_ids, city::ROAD_GRID_DEFAULT_CELL_SIZE);
+        U64 build_us = os_now_microseconds() - build_start_us;
+        INFO_LOG("road_grid %llu segments, %u x %u cells of %.0f m, %.2f entries per segment, build %.2f ms", segment_count, grid.dim_x, grid.dim_y, grid.cell_size,
+                 (F64)grid.entry_count / (F64)segment_count, (F64)build_us / 1000.0);
+
+        for (U32 parallel = 0; parallel < 2; ++parallel)
+        {
+            BenchTiming timing = {};
+            for (U32 iteration = 0; iteration < 10; ++iteration)
+            {
+                U64 start_us = os_now_microseconds();
+                if (parallel)
+                {
+                    city::road_grid_nearest_parallel(thread_pool, &grid, points, max_distance, hits);
+                }
+                else
+                {
+                    city::road_grid_nearest(&grid, points, max_distance, hits);
+                }
+                bench_timing_add(&timing, os_now_microseconds() - start_us);
+            }
+            U64 hit_count = 0;
+            for (city::RoadGridHit& hit : hits)
+            {
+                hit_count += hit.segment_idx != max_U32;
+            }
+            INFO_LOG("    %-8s %llu queries: %7.2f ms, %6.1f ns per query, %6.2f Mqueries/s, %5.1f%% snapped", parallel ? "parallel" : "serial", query_count,
+                     (F64)timing.best_us / 1000.0, (F64)timing.best_us * 1000.0 / (F64)query_count, (F64)query_count / Max((F64)timing.best_us, 1.0),
+                     100.0 * (F64)hit_count / (F64)query_count);
+        }
+
+        // ~mgj: the transforms are reset every iteration like the store writes them every frame
+        Mat4x4F32* transforms = PushArrayNoZero(bench_arena, Mat4x4F32, query_count);
+        BenchTiming snap_timing = {};
+        for (U32 iteration = 0; iteration < 10; ++iteration)
+        {
+            for (U64 i = 0; i < query_count; ++i)
+            {
+                transforms[i] = mat_4x4f32(1.0f);
+                transforms[i].v[3][0] = points.data[i].x;
+                transforms[i].v[3][1] = points.data[i].y;
+            }
+            U64 start_us = os_now_microseconds();
+            city::road_grid_transforms_snap(thread_pool, &grid, transforms, query_count, max_distance);
+            bench_timing_add(&snap_timing, os_now_microseconds() - start_us);
+        }
+        INFO_LOG("    snap     %llu transforms: %7.2f ms, %6.1f ns per transform", query_count, (F64)snap_timing.best_us / 1000.0,
+                 (F64)snap_timing.best_us * 1000.0 / (F64)query_count);
+    }
+}
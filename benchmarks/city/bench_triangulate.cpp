@@ -0,0 +1,400 @@
+// ~mgj: Building roof triangulation benchmark. Triangulates every building way of a cached Overpass
+// response with the previous ear clipper, with polygon_triangulate on one thread and with
+// polygon_triangulate per building through parallel_reduce, and reports triangles/s.
+// Usage: city_benchmarks triangulate [osm_data.json ...]
+// Without arguments the cached Aarhus response under data/cache is used when present, and a synthetic
+// set of buildings otherwise. The previous ear clipper is quadratic to cubic in the vertex count, so
+// the synthetic set keeps its largest buildings at a few thousand vertices.
+
+// ~mgj: The ear clipper that polygon_triangulate replaced, kept verbatim (renamed) as the baseline
+// for this benchmark.
+enum LegacyDirection
+{
+    LegacyDirection_Undefined,
+    LegacyDirection_Clockwise,
+    LegacyDirection_CounterClockwise
+};
+
+g_internal F64
+legacy_cross_2f64_z_component(Vec2F64 a, Vec2F64 b)
+{
+    return a.x * b.y - a.y * b.x;
+}
+
+g_internal LegacyDirection
+legacy_clockwise_test(Buffer<Vec2F64> node_buffer)
+{
+    F64 total = 0;
+    for (U32 idx = 0; idx < node_buffer.size; idx += 1)
+    {
+        Vec2F64 a = node_buffer.data[idx];
+        Vec2F64 b = node_buffer.data[(idx + 1) % node_buffer.size];
+
+        F64 cross_product_z = legacy_cross_2f64_z_component(a, b);
+        total += cross_product_z;
+    }
+    if (total > 0)
+    {
+        return LegacyDirection_CounterClockwise;
+    }
+    else if (total < 0)
+    {
+        return LegacyDirection_Clockwise;
+    }
+    DEBUG_LOG("legacy_clockwise_test: Lines are collinear\n");
+    return LegacyDirection_Undefined;
+}
+
+g_internal Buffer<U32>
+legacy_index_buffer_create(Arena* arena, U64 buffer_size, LegacyDirection direction)
+{
+    Buffer<U32> index_buffer = buffer_alloc<U32>(arena, buffer_size);
+    if (direction == LegacyDirection_Clockwise)
+    {
+        for (U32 i = 0; i < index_buffer.size; i++)
+        {
+            index_buffer.data[i] = i;
+        }
+    }
+    else if (direction == LegacyDirection_CounterClockwise)
+    {
+        for (U32 i = 0; i < index_buffer.size; i++)
+        {
+            index_buffer.data[i] = index_buffer.size - i - 1;
+        }
+    }
+    else if (direction == LegacyDirection_Undefined)
+    {
+        Assert(0);
+    }
+    return index_buffer;
+}
+
+// Shoelace Algorithm
+// source: https://artofproblemsolving.com/wiki/index.php/Shoelace_Theorem
+g_internal B32
+legacy_point_in_triangle(Vec2F64 p1, Vec2F64 p2, Vec2F64 p3, Vec2F64 point)
+{
+    F64 d1, d2, d3;
+    B32 has_neg, has_pos;
+
+    d1 = legacy_cross_2f64_z_component(sub_2f64(point, p1), sub_2f64(p2, p1));
+    d2 = legacy_cross_2f64_z_component(sub_2f64(point, p2), sub_2f64(p3, p2));
+    d3 = legacy_cross_2f64_z_component(sub_2f64(point, p3), sub_2f64(p1, p3));
+
+    has_neg = (d1 < 0) || (d2 < 0) || (d3 < 0);
+    has_pos = (d1 > 0) || (d2 > 0) || (d3 > 0);
+
+    return !(has_neg && has_pos);
+}
+
+g_internal void
+legacy_node_buffer_print_debug(Buffer<Vec2F64> node_buffer)
+{
+    DEBUG_LOG("Error in ear clipping algo. Expecting vertex_count-2 number of triangles\n"
+              "The following vertices are the problem: \n");
+    for (U32 pt_idx = 0; pt_idx < node_buffer.size; pt_idx++)
+    {
+        printf("%d, %f, %f\n", pt_idx, node_buffer.data[pt_idx].x, node_buffer.data[pt_idx].y);
+    }
+}
+
+g_internal Buffer<U32>
+legacy_ear_clipping(Arena* arena, Buffer<Vec2F64> node_buffer)
+{
+    prof_scope_marker;
+    Assert(node_buffer.size >= 3);
+    ScratchScope scratch = ScratchScope(&arena, 1);
+
+    U32 total_triangle_count = (node_buffer.size - 2);
+    U32 total_index_count = total_triangle_count * 3;
+
+    LegacyDirection direction = legacy_clockwise_test(node_buffer);
+    if (direction == LegacyDirection_Undefined)
+    {
+        DEBUG_LOG("Cannot determine direction\n");
+        DEBUG_FUNC(legacy_node_buffer_print_debug(node_buffer));
+        return {0, 0};
+    }
+    Buffer<U32> index_buffer = legacy_index_buffer_create(scratch.arena, node_buffer.size, direction);
+    Buffer<U32> out_vertex_index_buffer = buffer_alloc<U32>(arena, total_index_count);
+    U32 cur_index_buffer_idx = 0;
+    U32 idx = 0;
+    for (; idx < index_buffer.size;)
+    {
+        if (index_buffer.size < 3)
+        {
+            break;
+        }
+
+        U32 ear_index_buffer_idx = idx % index_buffer.size;
+        U32 prev_index_buffer_idx = (index_buffer.size + idx - 1) % index_buffer.size;
+        U32 next_index_buffer_idx = (index_buffer.size + idx + 1) % index_buffer.size;
+
+        U32 ear_node_buffer_idx = index_buffer.data[ear_index_buffer_idx];
+        U32 prev_node_buffer_idx = index_buffer.data[prev_index_buffer_idx];
+        U32 next_node_buffer_idx = index_buffer.data[next_index_buffer_idx];
+
+        Vec2F64 ear = node_buffer.data[ear_node_buffer_idx];
+        Vec2F64 prev = node_buffer.data[prev_node_buffer_idx];
+        Vec2F64 next = node_buffer.data[next_node_buffer_idx];
+
+        Vec2F64 prev_to_ear = sub_2f64(ear, prev);
+        Vec2F64 ear_to_next = sub_2f64(next, ear);
+
+        F64 cross_product_z = legacy_cross_2f64_z_component(prev_to_ear, ear_to_next);
+
+        // negative cross product z component means that the triangle has clockwise orientation.
+        if (cross_product_z < 0)
+        {
+            B32 is_ear = true;
+            for (U32 test_i = 0; test_i < index_buffer.size - 3; test_i++)
+            {
+                U32 test_node_buffer_idx = index_buffer.data[(next_index_buffer_idx + test_i + 1) % index_buffer.size];
+                Vec2F64 test_point = node_buffer.data[test_node_buffer_idx];
+
+                if (legacy_point_in_triangle(prev, ear, next, test_point))
+                {
+                    is_ear = false;
+                    break;
+                }
+            }
+
+            if (is_ear)
+            {
+                // add ear to vertex buffer
+                out_vertex_index_buffer.data[cur_index_buffer_idx] = prev_node_buffer_idx;
+                out_vertex_index_buffer.data[cur_index_buffer_idx + 1] = ear_node_buffer_idx;
+                out_vertex_index_buffer.data[cur_index_buffer_idx + 2] = next_node_buffer_idx;
+                cur_index_buffer_idx += 3;
+
+                // remove ear from index buffer
+                BufferItemRemove(&index_buffer, ear_index_buffer_idx);
+                idx = 0;
+                continue;
+            }
+        }
+        else if (cross_product_z == 0)
+        {
+            DEBUG_LOG("EarClipping: Two line segments are collinear");
+        }
+        idx++;
+    }
+    if (cur_index_buffer_idx != out_vertex_index_buffer.size)
+    {
+        DEBUG_FUNC(legacy_node_buffer_print_debug(node_buffer));
+        out_vertex_index_buffer.size = cur_index_buffer_idx;
+    }
+
+    Assert(cur_index_buffer_idx == out_vertex_index_buffer.size);
+    return out_vertex_index_buffer;
+}
+
+struct BenchBuildings
+{
+    Buffer<Buffer<Vec2F64>> rings; // open rings in meters
+    U64 vertex_count;
+};
+
+// ~mgj: star shaped rings with noisy radii, most buildings small and a few very large
+g_internal BenchBuildings
+bench_buildings_synthetic(Arena* arena, U64 building_count)
+{
+    BenchBuildings buildings = {.rings = buffer_alloc<Buffer<Vec2F64>>(arena, building_count)};
+    for (U64 i = 0; i < building_count; ++i)
+    {
+        F32 size_class = bench_unit_f32(i * 5);
+        U32 vertex_count = size_class < 0.9f ? 4 + (U32)(bench_unit_f32(i * 5 + 1) * 12.0f) : (size_class < 0.999f ? 50 + (U32)(bench_unit_f32(i * 5 + 1) * 250.0f) : 2000);
+        F64 radius = vertex_count < 20 ? 10.0 : 100.0;
+        Vec2F64 center = vec_2f64(bench_unit_f32(i * 5 + 2) * 5000.0, bench_unit_f32(i * 5 + 3) * 5000.0);
+        Buffer<Vec2F64> ring = buffer_alloc<Vec2F64>(arena, vertex_count);
+        for (U32 j = 0; j < vertex_count; ++j)
+        {
+            F64 angle = 6.283185307179586 * (F64)j / (F64)vertex_count;
+            F64 r = radius * (0.5 + 0.5 * (F64)bench_unit_f32(i * 7919 + j));
+            ring.data[j] = vec_2f64(center.x + r * cos(angle), center.y + r * sin(angle));
+        }
+        buildings.rings.data[i] = ring;
+        buildings.vertex_count += vertex_count;
+    }
+    return buildings;
+}
+
+g_internal BenchBuildings
+bench_buildings_from_osm(Arena* arena, String8 path)
+{
+    BenchBuildings buildings = {};
+    String8 json = wrapper::json_padded_from_file(arena, path);
+    Result<osm::ElementStore> store_result = wrapper::osm_element_store_from_simd_json(arena, json);
+    if (store_result.err)
+    {
+        ERROR_LOG("triangulate: failed to parse %.*s", str8_varg(path));
+        return buildings;
+    }
+    osm::ElementStore* store = &store_result.v;
+    osm::element_store_nodes_sort(&store->nodes);
+
+    U64 building_count = 0;
+    for (U64 way_idx = 0; way_idx < store->ways.count; ++way_idx)
+    {
+        osm::TagList tags = osm::element_store_way_tags(&store->ways, way_idx);
+        for (U64 i = 0; i < tags.count; ++i)
+        {
+            building_count += tags.keys[i] == (osm::StrId)osm::TagKeyId::Building;
+        }
+    }
+
+    buildings.rings = buffer_alloc<Buffer<Vec2F64>>(arena, building_count);
+    buildings.rings.size = 0;
+    F64 origin_lat = store->nodes.count ? store->nodes.lat[0] : 0.0;
+    F64 meters_per_lon = 111320.0 * cos(origin_lat * 0.017453292519943295);
+    for (U64 way_idx = 0; way_idx < store->ways.count; ++way_idx)
+    {
+        B32 is_building = false;
+        osm::TagList tags = osm::element_store_way_tags(&store->ways, way_idx);
+        for (U64 i = 0; i < tags.count; ++i)
+        {
+            is_building = is_building || tags.keys[i] == (osm::StrId)osm::TagKeyId::Building;
+        }
+        Buffer<osm::NodeId> node_ids = osm::element_store_way_node_ids(&store->ways, way_idx);
+        // ~mgj: closed ways only, the closing node is dropped
+        if (!is_building || node_ids.size < 4 || node_ids.data[0] != node_ids.data[node_ids.size - 1])
+        {
+            continue;
+        }
+        Buffer<Vec2F64> ring = buffer_alloc<Vec2F64>(arena, node_ids.size - 1);
+        B32 is_complete = true;
+        for (U64 i = 0; i < ring.size && is_complete; ++i)
+        {
+            U64 node_idx = osm::element_store_node_idx_find(&store->nodes, node_ids.data[i]);
+            is_complete = node_idx < store->nodes.count;
+            if (is_complete)
+            {
+                ring.data[i] = vec_2f64((store->nodes.lon[node_idx]) * meters_per_lon, (store->nodes.lat[node_idx] - origin_lat) * 110574.0);
+            }
+        }
+        if (is_complete)
+        {
+            buildings.rings.data[buildings.rings.size++] = ring;
+            buildings.vertex_count += ring.size;
+        }
+    }
+    return buildings;
+}
+
+g_internal U64
+bench_triangulate_task(async::ThreadInfo thread_info, Arena* scratch_arena, void* data, U64 start_idx, U64 end_idx, U64 triangle_count)
+{
+    (void)thread_info;
+    BenchBuildings* buildings = (BenchBuildings*)data;
+    for (U64 i = start_idx; i < end_idx; ++i)
+    {
+        Temp scratch = temp_begin(scratch_arena);
+        triangle_count += city::polygon_triangulate(scratch.arena, buildings->rings.data[i], {}).size / 3;
+        temp_end(scratch);
+    }
+    return triangle_count;
+}
+
+g_internal U64
+bench_triangulate_combine(U64 a, U64 b)
+{
+    return a + b;
+}
+
+g_internal void
+bench_triangulate_report(const char* name, BenchTiming* timing, U64 triangle_count)
+{
+    INFO_LOG("    %-16s %9.2f ms, %9llu triangles, %7.2f Mtriangles/s", name, (F64)timing->best_us / 1000.0, triangle_count, (F64)triangle_count / Max((F64)timing->best_us, 1.0));
+}
+
+g_internal void
+bench_triangulate_run(const char* name, BenchBuildings* buildings)
+{
+    const U32 iteration_count = 3;
+    U32 thread_count = Max(OS_GetSystemInfo()->logical_processor_count, 2u) - 1;
+    Arena* arena = arena_alloc();
+    Debug_SetName(arena, "bench triangulate arena");
+    defer(arena_release(arena));
+    async::ThreadPool* thread_pool = async::thread_pool_create(arena, thread_count, 256, 16);
+    defer(async::thread_pool_destroy(thread_pool));
+
+    U64 max_vertex_count = 0;
+    for (Buffer<Vec2F64> ring : buildings->rings)
+    {
+        max_vertex_count = Max(max_vertex_count, ring.size);
+    }
+    INFO_LOG("triangulate %s: %llu buildings, %llu vertices, largest %llu, %u threads", name, buildings->rings.size, buildings->vertex_count, max_vertex_count, thread_count + 1);
+
+    {
+        BenchTiming timing = {};
+        U64 triangle_count = 0;
+        for (U32 iteration = 0; iteration < iteration_count; ++iteration)
+        {
+            triangle_count = 0;
+            U64 start = os_now_microseconds();
+            for (Buffer<Vec2F64> ring : buildings->rings)
+            {
+                ScratchScope scratch = ScratchScope(0, 0);
+                triangle_count += legacy_ear_clipping(scratch.arena, ring).size / 3;
+            }
+            bench_timing_add(&timing, os_now_microseconds() - start);
+        }
+        bench_triangulate_report("ear clipping", &timing, triangle_count);
+    }
+    {
+        BenchTiming timing = {};
+        U64 triangle_count = 0;
+        for (U32 iteration = 0; iteration < iteration_count; ++iteration)
+        {
+            triangle_count = 0;
+            U64 start = os_now_microseconds();
+            for (Buffer<Vec2F64> ring : buildings->rings)
+            {
+                ScratchScope scratch = ScratchScope(0, 0);
+                triangle_count += city::polygon_triangulate(scratch.arena, ring, {}).size / 3;
+            }
+            bench_timing_add(&timing, os_now_microseconds() - start);
+        }
+        bench_triangulate_report("z-order", &timing, triangle_count);
+    }
+    {
+        BenchTiming timing = {};
+        U64 triangle_count = 0;
+        for (U32 iteration = 0; iteration < iteration_count; ++iteration)
+        {
+            U64 start = os_now_microseconds();
+            triangle_count = async::parallel_reduce<U64>(thread_pool, buildings->rings.size, 0, 0, bench_triangulate_task, bench_triangulate_combine, buildings);
+            bench_timing_add(&timing, os_now_microseconds() - start);
+        }
+        bench_triangulate_report("z-order parallel", &timing, triangle_count);
+    }
+}
+
+g_internal void
+bench_triangulate(Arena* arena, String8List args)
+{
+    if (args.node_count == 0)
+    {
+        String8 aarhus_path = str8_path_from_str8_list(arena, {S("data"), S("cache"), S("Aarhus"), S("osm_data.json")});
+        if (os_file_path_exists(aarhus_path))
+        {
+            str8_list_push(arena, &args, aarhus_path);
+        }
+        else
+        {
+            BenchBuildings buildings = bench_buildings_synthetic(arena, Thousand(20));
+            bench_triangulate_run("synthetic", &buildings);
+        }
+    }
+    for (String8Node* node = args.first; node; node = node->next)
+    {
+        if (!os_file_path_exists(node->string))
+        {
+            INFO_LOG("triangulate: %.*s not found, skipping", str8_varg(node->string));
+            continue;
+        }
+        BenchBuildings buildings = bench_buildings_from_osm(arena, node->string);
+        bench_triangulate_run((const char*)node->string.str, &buildings);
+    }
+}
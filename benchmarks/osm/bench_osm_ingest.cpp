@@ -0,0 +1,58 @@
+// ~mgj: Ingest of cached Overpass responses into the columnar osm::ElementStore.
+// Usage: city_benchmarks osm_ingest [osm_data.json ...]
+// Without arguments the cached Aarhus and Zurich responses under data/cache are used.
+
+g_internal void
+bench_osm_ingest_file(String8 path)
+{
+    const U32 iteration_count = 5;
+    if (!os_file_path_exists(path))
+    {
+        INFO_LOG("osm_ingest: %.*s not found, skipping", str8_varg(path));
+        return;
+    }
+
+    Arena* arena = arena_alloc();
+    Debug_SetName(arena, "bench osm ingest arena");
+    defer(arena_release(arena));
+
+    String8 json = wrapper::json_padded_from_file(arena, path);
+    U64 arena_base_pos = arena_pos(arena);
+
+    BenchTiming timing = {};
+    osm::ElementStore store = {};
+    U64 store_bytes = 0;
+    for (U32 i = 0; i < iteration_count; ++i)
+    {
+        U64 start_us = os_now_microseconds();
+        Result<osm::ElementStore> store_result = wrapper::osm_element_store_from_simd_json(arena, json);
+        bench_timing_add(&timing, os_now_microseconds() - start_us);
+        if (store_result.err)
+        {
+            ERROR_LOG("osm_ingest: failed to parse %.*s", str8_varg(path));
+            return;
+        }
+        store = store_result.v;
+        store_bytes = arena_pos(arena) - arena_base_pos;
+        arena_pop_to(arena, arena_base_pos);
+    }
+
+    INFO_LOG("osm_ingest %.*s: %.2f MB, %llu nodes, %llu ways, %llu node refs, %llu tags", str8_varg(path), (F64)json.size / (F64)MB(1), store.nodes.count, store.ways.count,
+             store.ways.node_ref_count, store.ways.tag_count);
+    INFO_LOG("    best %.1f MB/s, mean %.1f MB/s, store %.2f MB, peak rss %.2f MB", bench_mb_per_s(json.size, timing.best_us),
+             bench_mb_per_s(json.size * timing.iterations, timing.total_us), (F64)store_bytes / (F64)MB(1), (F64)os_get_process_peak_memory_bytes() / (F64)MB(1));
+}
+
+g_internal void
+bench_osm_ingest(Arena* arena, String8List args)
+{
+    if (args.node_count == 0)
+    {
+        str8_list_push(arena, &args, str8_path_from_str8_list(arena, {S("data"), S("cache"), S("Aarhus"), S("osm_data.json")}));
+        str8_list_push(arena, &args, str8_path_from_str8_list(arena, {S("data"), S("cache"), S("Zurich"), S("osm_data.json")}));
+    }
+    for (String8Node* node = args.first; node; node = node->next)
+    {
+        bench_osm_ingest_file(node->string);
+    }
+}
@@ -72,6 +72,7 @@ _curl_context_cleanup(CurlContext* curl_ctx)
         curl_slist_free_all(curl_ctx->headers);
         curl_ctx->headers = 0;
     }
+    http_body_release(&curl_ctx->body);
     arena_release(curl_ctx->arena);
 }
 
@@ -82,14 +83,8 @@ _libcurl_callback(void* contents, size_t size, size_t nmemb, void* userp)
     size_t total_size = size * nmemb;
     LibCurlCallbackData<T>* callback_data = (LibCurlCallbackData<T>*)userp;
     AsyncHttpTaskState<T>* http_ctx = callback_data->http_ctx;
-    CurlContext* curl_ctx = http_ctx->curl_ctx;
-
-    U8* buffer = PushArray(curl_ctx->arena, U8, total_size);
-    ChunkItem<U8>* chunk = chunk_item_from_array(curl_ctx->arena, buffer, total_size);
-    MemoryCopy(buffer, contents, total_size);
-    chunk_list_insert_chunk(&curl_ctx->chunk_list, chunk);
-
-    return total_size;
+    // ~mgj: anything but total_size fails the transfer with CURLE_WRITE_ERROR
+    return http_body_append(&http_ctx->curl_ctx->body, contents, total_size) ? total_size : 0;
 }
 
 template <typename T>
@@ -133,18 +128,30 @@ g_internal CurlContext*
 _curl_ctx_create(Arena* arena)
 {
     CurlContext* curl_ctx = PushStruct(arena, CurlContext);
+    _curl_ctx_init(curl_ctx);
+    return curl_ctx;
+}
+
+g_internal void
+_curl_ctx_init(CurlContext* curl_ctx)
+{
+    *curl_ctx = {};
     curl_ctx->arena = arena_alloc();
     Debug_SetName(curl_ctx->arena, "async HTTP curl arena");
 
     // curl library inits
     async_http_global_init();
-    CURL* session_handle = curl_easy_init();
-    CURLM* multi_handle = curl_multi_init();
+    curl_ctx->session_handle = curl_easy_init();
+}
 
-    // create curl handles
-    curl_ctx->session_handle = session_handle;
-    curl_ctx->multi_handle = multi_handle;
-    return curl_ctx;
+g_internal B32
+_curl_ctx_submit(CurlContext* curl_ctx, ThreadPool* thread_pool, WorkerItem completion)
+{
+    HttpEngineRequest* request = &curl_ctx->engine_request;
+    request->session_handle = curl_ctx->session_handle;
+    request->thread_pool = thread_pool;
+    request->completion = completion;
+    return http_engine_submit(http_engine_global_get(), request);
 }
 
 g_internal void
@@ -160,6 +167,7 @@ _curl_reset(CurlContext* curl_ctx)
     curl_ctx->headers = 0;
 
     curl_ctx->chunk_list = {};
+    http_body_release(&curl_ctx->body);
     arena_clear(curl_ctx->arena);
 }
 
@@ -168,7 +176,7 @@ _async_http_configure(Arena* arena, CurlContext* curl_ctx, HttpInfo* http_info,
 {
     CURLU* url_handle = curl_url();
     defer(curl_url_cleanup(url_handle));
-    if (curl_ctx->session_handle == 0 || curl_ctx->multi_handle == 0 || url_handle == 0)
+    if (curl_ctx->session_handle == 0 || url_handle == 0)
     {
         return async_user_error(AsyncResult::HandleInitError);
     }
@@ -269,13 +277,6 @@ _async_http_configure(Arena* arena, CurlContext* curl_ctx, HttpInfo* http_info,
     async_return_curl_error(CurlCodeType::Regular, curl_easy_setopt(curl_ctx->session_handle, CURLOPT_WRITEFUNCTION, curl_write_callback));
     async_return_curl_error(CurlCodeType::Regular, curl_easy_setopt(curl_ctx->session_handle, CURLOPT_WRITEDATA, callback_data));
 
-    CURLMcode multi_err = curl_multi_add_handle(curl_ctx->multi_handle, curl_ctx->session_handle);
-    if (multi_err != CURLM_OK)
-    {
-        return async_curl_error(CurlCodeType::Multi, multi_err);
-    }
-    curl_ctx->added_to_multi = true;
-
     return async_no_error();
 }
 
@@ -287,6 +288,14 @@ _async_http_configure(Arena* arena, AsyncHttpTaskState<T>* http_ctx, HttpInfo* h
     callback_data->http_ctx = http_ctx;
     callback_data->arena = arena;
     AsyncError result = _async_http_configure(arena, http_ctx->curl_ctx, http_info, _libcurl_callback<T>, callback_data);
+    if (!result.has_error())
+    {
+        // ~mgj: a transfer gets what is left of the task timeout
+        U64 deadline_us = http_ctx->task_start_us + http_ctx->timeout_us;
+        U64 now_us = os_now_microseconds();
+        long timeout_ms = (long)Max(CeilIntegerDiv(deadline_us - Min(now_us, deadline_us), 1000), 1ull);
+        async_return_curl_error(CurlCodeType::Regular, curl_easy_setopt(http_ctx->curl_ctx->session_handle, CURLOPT_TIMEOUT_MS, timeout_ms));
+    }
     return result;
 }
 
@@ -295,12 +304,10 @@ g_internal AsyncTaskContinuation<T>
 _http_main(ThreadInfo thread_info, AsyncTaskStatus<T>* task_status)
 {
     prof_scope_marker;
+    (void)thread_info;
 
     AssertAlways(task_status->ext_type == async::ExtensionType::Http);
     AsyncHttpTaskState<T>* http_ctx = task_status->http_ext;
-    HttpInfo* next_http_info = http_ctx->next_http_info;
-    AsyncWorkFunc<T> next_func = http_ctx->next_func;
-    CurlContext* curl_ctx = http_ctx->curl_ctx;
 
     if (http_ctx->timeout_us + http_ctx->task_start_us < os_now_microseconds())
     {
@@ -310,171 +317,153 @@ _http_main(ThreadInfo thread_info, AsyncTaskStatus<T>* task_status)
         return {};
     }
 
-    int running = 1;
-    CURLMcode curl_code = curl_multi_perform(curl_ctx->multi_handle, &running);
+    // ~mgj: _worker_task_func hands the transfer to the HTTP engine, which resumes the task with _http_complete
+    AsyncTaskContinuation<T> continuation = {.func = _http_complete<T>, .await_http = true};
+    return continuation;
+}
+
+template <typename T>
+g_internal AsyncTaskContinuation<T>
+_http_complete(ThreadInfo thread_info, AsyncTaskStatus<T>* task_status)
+{
+    prof_scope_marker;
+
+    AsyncHttpTaskState<T>* http_ctx = task_status->http_ext;
+    HttpInfo* next_http_info = http_ctx->next_http_info;
+    AsyncWorkFunc<T> next_func = http_ctx->next_func;
+    CurlContext* curl_ctx = http_ctx->curl_ctx;
 
+    CURLcode result = curl_ctx->engine_request.result;
+    long http_code = (long)curl_ctx->engine_request.http_code;
     B32 retry = false;
     B32 http_error = false;
-    if (curl_code != CURLM_OK)
+
+    UserFuncResult<T> user_result = {};
+    if (result != CURLE_OK)
     {
-        async_error_set(http_ctx, async_curl_regular_error(curl_code));
+        S32 error_code = result ? result : http_code;
+        async_error_set(http_ctx, async_curl_regular_error(error_code));
+        http_ctx->error.curl_code = (U32)error_code;
         retry = true;
     }
-    else if (!running)
+    else
     {
-        S32 msgs_left = 0;
-        B32 found_msg = 0;
-        CURLMsg* msg = curl_multi_info_read(curl_ctx->multi_handle, &msgs_left);
-        for (; msg; msg = curl_multi_info_read(curl_ctx->multi_handle, &msgs_left))
-        {
-            if (msg->msg == CURLMSG_DONE && msg->easy_handle == curl_ctx->session_handle)
-            {
-                found_msg = true;
-                break;
-            }
-        }
-        if (found_msg == false)
-        {
-            task_status->error.store(true);
-            return {};
-        }
+        // ~mgj: the user function reads the body where curl wrote it, it is released by the next _curl_reset
+        String8 final_str_buffer = curl_ctx->body.str;
 
-        CURLcode result = msg->data.result;
-        long http_code = 0;
-        curl_easy_getinfo(msg->easy_handle, CURLINFO_RESPONSE_CODE, &http_code);
-
-        UserFuncResult<T> user_result = {};
-        if (result != CURLE_OK)
+        if (http_code >= 400)
         {
-            S32 error_code = result ? result : http_code;
-            async_error_set(http_ctx, async_curl_regular_error(error_code));
-            http_ctx->error.curl_code = (U32)error_code;
+            http_ctx->http_error_code = (U32)http_code;
+            async_error_set(http_ctx, async_user_error(AsyncResult::HttpError));
+            http_error = true;
             retry = true;
         }
-        else
-        {
-            // prepare response body as string input
-            String8 final_str_buffer = str8_from_chunk_list(task_status->arena, &curl_ctx->chunk_list);
-
-            if (http_code >= 400)
-            {
-                http_ctx->http_error_code = (U32)http_code;
-                async_error_set(http_ctx, async_user_error(AsyncResult::HttpError));
-                http_error = true;
-                retry = true;
-            }
-
-            if (!http_error)
-            {
-                // call user function
-                AssertAlways(next_func != 0);
-                user_result = next_func(task_status->arena, thread_info.thread_pool, final_str_buffer, task_status->user_data);
-                next_func = user_result.next_func ? user_result.next_func : next_func;
-            }
-        }
 
-        // retry if call not succesful and max retries have not been reached.
-        B32 task_retry = false;
-        U64 us_delay = 0;
-
-        if (user_result.successful)
-        {
-            http_ctx->cur_http_retry_count = 0;
-        }
-        else if (user_result.to_reschedule)
+        if (!http_error)
         {
-            // user function retry
-            retry = true;
-            us_delay = user_result.us_delay;
-            http_ctx->cur_http_retry_count = 0;
-        }
-        else if (http_ctx->cur_http_retry_count < http_ctx->max_http_retries)
-        {
-            // task http call retry
-            http_ctx->cur_http_retry_count += 1;
-            Debug_Http_Push(http_ctx->error);
-            us_delay = 10'000'000; // 10 sec
-            retry = true;
-        }
-        else if (http_ctx->cur_task_retry_count < http_ctx->max_task_retries)
-        {
-            // task retry
-            http_ctx->cur_task_retry_count += 1;
-            http_ctx->cur_http_retry_count = 0;
-            task_retry = true;
-            Debug_Http_Push(http_ctx->error);
-            us_delay = 10'000'000; // 10 sec
-            retry = true;
+            // call user function
+            AssertAlways(next_func != 0);
+            user_result = next_func(task_status->arena, thread_info.thread_pool, final_str_buffer, task_status->user_data);
+            next_func = user_result.next_func ? user_result.next_func : next_func;
         }
+    }
 
-        // reschedule with optional delay
-        if (retry)
-        {
-            if (task_retry)
-            {
-                next_http_info = http_ctx->first_http_info;
-                next_func = http_ctx->first_func;
-            }
+    // retry if call not succesful and max retries have not been reached.
+    B32 task_retry = false;
+    U64 us_delay = 0;
 
-            http_ctx->error = async_no_error();
-            _curl_reset(http_ctx->curl_ctx);
-            AsyncError configure_result = _async_http_configure(task_status->arena, http_ctx, next_http_info);
-            if (configure_result.result != AsyncResult::Success)
-            {
-                http_ctx->error = configure_result;
-                Debug_Http_Push(http_ctx->error);
-                task_status->error.store(true);
-                return {};
-            }
+    if (user_result.successful)
+    {
+        http_ctx->cur_http_retry_count = 0;
+    }
+    else if (user_result.to_reschedule)
+    {
+        // user function retry
+        retry = true;
+        us_delay = user_result.us_delay;
+        http_ctx->cur_http_retry_count = 0;
+    }
+    else if (http_ctx->cur_http_retry_count < http_ctx->max_http_retries)
+    {
+        // task http call retry
+        http_ctx->cur_http_retry_count += 1;
+        Debug_Http_Push(http_ctx->error);
+        us_delay = 10'000'000; // 10 sec
+        retry = true;
+    }
+    else if (http_ctx->cur_task_retry_count < http_ctx->max_task_retries)
+    {
+        // task retry
+        http_ctx->cur_task_retry_count += 1;
+        http_ctx->cur_http_retry_count = 0;
+        task_retry = true;
+        Debug_Http_Push(http_ctx->error);
+        us_delay = 10'000'000; // 10 sec
+        retry = true;
+    }
 
-            AsyncTaskContinuation<T> continuation_func = _async_http_task_continuation(http_ctx, next_func, next_http_info, us_delay);
-            return continuation_func;
+    // reschedule with optional delay
+    if (retry)
+    {
+        if (task_retry)
+        {
+            next_http_info = http_ctx->first_http_info;
+            next_func = http_ctx->first_func;
         }
 
-        // record user function error and end the session
-        if (user_result.successful == false)
+        http_ctx->error = async_no_error();
+        _curl_reset(http_ctx->curl_ctx);
+        AsyncError configure_result = _async_http_configure(task_status->arena, http_ctx, next_http_info);
+        if (configure_result.result != AsyncResult::Success)
         {
-            http_ctx->http_error_msg = push_str8_copy(task_status->arena, user_result.msg);
-            http_ctx->error = async_user_error(AsyncResult::UserFunctionError);
+            http_ctx->error = configure_result;
             Debug_Http_Push(http_ctx->error);
             task_status->error.store(true);
             return {};
         }
 
-        if (user_result.successful && user_result.next_task.func)
-        {
-            AsyncTaskContinuation<T> continuation = {.func = user_result.next_task.func, .us_delay = user_result.next_task.us_delay};
-            return continuation;
-        }
+        AsyncTaskContinuation<T> continuation_func = _async_http_task_continuation(http_ctx, next_func, next_http_info, us_delay);
+        return continuation_func;
+    }
 
-        next_http_info = user_result.http_info;
-        if (next_http_info != 0)
-        {
-            AssertAlways(next_func != 0);
-            _curl_reset(http_ctx->curl_ctx);
-            http_ctx->error = _async_http_configure(task_status->arena, http_ctx, next_http_info);
-            if (http_ctx->error.has_error())
-            {
-                Debug_Http_Push(http_ctx->error);
-                task_status->error.store(true);
-                return {};
-            }
-            AsyncTaskContinuation<T> continuation_func = _async_http_task_continuation(http_ctx, next_func, next_http_info);
-            return continuation_func;
-        }
-        else
+    // record user function error and end the session
+    if (user_result.successful == false)
+    {
+        http_ctx->http_error_msg = push_str8_copy(task_status->arena, user_result.msg);
+        http_ctx->error = async_user_error(AsyncResult::UserFunctionError);
+        Debug_Http_Push(http_ctx->error);
+        task_status->error.store(true);
+        return {};
+    }
+
+    if (user_result.successful && user_result.next_task.func)
+    {
+        AsyncTaskContinuation<T> continuation = {.func = user_result.next_task.func, .us_delay = user_result.next_task.us_delay};
+        return continuation;
+    }
+
+    next_http_info = user_result.http_info;
+    if (next_http_info != 0)
+    {
+        AssertAlways(next_func != 0);
+        _curl_reset(http_ctx->curl_ctx);
+        http_ctx->error = _async_http_configure(task_status->arena, http_ctx, next_http_info);
+        if (http_ctx->error.has_error())
         {
             Debug_Http_Push(http_ctx->error);
-            if (user_result.main_thread_func)
-            {
-                _async_main_thread_queue_push(thread_info.thread_pool, task_status, user_result.main_thread_func);
-            }
+            task_status->error.store(true);
+            return {};
         }
+        AsyncTaskContinuation<T> continuation_func = _async_http_task_continuation(http_ctx, next_func, next_http_info);
+        return continuation_func;
     }
     else
     {
-        AsyncTaskContinuation<T> continuation_func = _async_http_task_continuation(http_ctx, next_func, next_http_info);
-        return continuation_func;
+        Debug_Http_Push(http_ctx->error);
+        if (user_result.main_thread_func)
+        {
+            _async_main_thread_queue_push(thread_info.thread_pool, task_status, user_result.main_thread_func);
+        }
     }
     return {};
 }
@@ -533,4 +522,215 @@ async_http_task_run(ThreadPool* thread_pool, HttpInfo* http_info, AsyncHttpTaskS
     return result;
 }
 
+g_internal CoHttpRequestAwaiter
+co_http_request(Arena* arena, HttpInfo* http_info, U32 max_retries, U32 timeout_sec)
+{
+    CoHttpRequestAwaiter request = {};
+    request.arena = arena;
+    request.http_info = http_info;
+    request.max_retries = max_retries;
+    request.timeout_us = (U64)(timeout_sec == 0 ? 300 : timeout_sec) * 1'000'000;
+    return request;
+}
+
+g_internal CoHttpRequestAwaiter
+co_http_download(HttpInfo* http_info, U32 max_retries, U32 timeout_sec)
+{
+    return co_http_request(0, http_info, max_retries, timeout_sec);
+}
+
+g_internal void
+http_response_release(HttpResponse* response)
+{
+    if (response->body_arena != 0)
+    {
+        arena_release(response->body_arena);
+    }
+    response->body = {};
+    response->body_arena = 0;
+}
+
+g_internal B32
+http_body_append(HttpBody* body, void* data, U64 size)
+{
+    if (body->arena == 0)
+    {
+        ArenaParams params = {.reserve_size = HTTP_BODY_RESERVE_SIZE, .commit_size = MB(1), .flags = ArenaFlag_NoChain};
+        body->arena = arena_alloc(&params);
+        Debug_SetName(body->arena, "HTTP body arena");
+        body->str = str8(PushArrayAligned(body->arena, U8, HTTP_BODY_PADDING, 64), 0);
+    }
+    if (arena_pos(body->arena) + size > body->arena->res)
+    {
+        ERROR_LOG("http body: response is larger than %llu bytes", HTTP_BODY_RESERVE_SIZE);
+        return false;
+    }
+
+    // ~mgj: the new bytes start in the old padding and the block only grows at its end, so the body
+    // never moves; the push just extends it by size and the last HTTP_BODY_PADDING bytes are zeroed again
+    U8* push_ptr = PushArrayNoZeroAligned(body->arena, U8, size, 1);
+    AssertAlways(push_ptr == body->str.str + body->str.size + HTTP_BODY_PADDING);
+    MemoryCopy(body->str.str + body->str.size, data, size);
+    body->str.size += size;
+    MemoryZero(body->str.str + body->str.size, HTTP_BODY_PADDING);
+    return true;
+}
+
+g_internal void
+http_body_release(HttpBody* body)
+{
+    if (body->arena != 0)
+    {
+        arena_release(body->arena);
+    }
+    *body = {};
+}
+
+template <typename P>
+bool
+CoHttpRequestAwaiter::await_suspend(std::coroutine_handle<P> coroutine)
+{
+    CoPromiseBase& promise = coroutine.promise();
+    thread_pool = promise.thread_pool;
+    name_id = promise.name_id;
+    handle = coroutine;
+    start_us = os_now_microseconds();
+
+    _curl_ctx_init(&curl_ctx);
+    response.error = _co_http_configure(this);
+    if (!response.error.has_error())
+    {
+        // ~mgj: the engine may resume the coroutine before this returns, nothing in `this` is touched after the submit
+        if (_co_http_submit(this))
+        {
+            return true;
+        }
+        response.error = async_user_error(AsyncResult::NoWorkError);
+    }
+    Debug_Http_Push(response.error);
+    _curl_context_cleanup(&curl_ctx);
+    return false;
+}
+
+g_internal size_t
+_curl_ctx_write_callback(void* contents, size_t size, size_t nmemb, void* userp)
+{
+    size_t total_size = size * nmemb;
+    CurlContext* curl_ctx = (CurlContext*)userp;
+    return http_body_append(&curl_ctx->body, contents, total_size) ? total_size : 0;
+}
+
+g_internal AsyncError
+_co_http_configure(CoHttpRequestAwaiter* request)
+{
+    U64 deadline_us = request->start_us + request->timeout_us;
+    U64 now_us = os_now_microseconds();
+    if (now_us >= deadline_us)
+    {
+        return async_user_error(AsyncResult::TimeoutError);
+    }
+
+    CurlContext* curl_ctx = &request->curl_ctx;
+    AsyncError error = _async_http_configure(curl_ctx->arena, curl_ctx, request->http_info, _curl_ctx_write_callback, curl_ctx);
+    if (!error.has_error())
+    {
+        // ~mgj: a transfer gets what is left of the request timeout
+        long timeout_ms = (long)Max(CeilIntegerDiv(deadline_us - now_us, 1000), 1ull);
+        async_return_curl_error(CurlCodeType::Regular, curl_easy_setopt(curl_ctx->session_handle, CURLOPT_TIMEOUT_MS, timeout_ms));
+    }
+    return error;
+}
+
+g_internal B32
+_co_http_submit(CoHttpRequestAwaiter* request)
+{
+    WorkerItem completion = WorkerItem(request, _co_http_complete);
+    completion.name_id = request->name_id;
+    return _curl_ctx_submit(&request->curl_ctx, request->thread_pool, completion);
+}
+
+g_internal WorkerResult
+_co_http_complete(ThreadInfo thread_info, WorkerData data)
+{
+    prof_scope_marker;
+    (void)thread_info;
+    CoHttpRequestAwaiter* request = (CoHttpRequestAwaiter*)data;
+    HttpEngineRequest* engine_request = &request->curl_ctx.engine_request;
+
+    AsyncError error = async_no_error();
+    request->response.http_code = engine_request->http_code;
+    if (engine_request->result == CURLE_OPERATION_TIMEDOUT)
+    {
+        error = async_user_error(AsyncResult::TimeoutError);
+    }
+    else if (engine_request->result != CURLE_OK)
+    {
+        error = async_curl_regular_error(engine_request->result);
+    }
+    else if (engine_request->http_code >= 400)
+    {
+        error = async_user_error(AsyncResult::HttpError);
+    }
+
+    B32 timed_out = error.result == AsyncResult::TimeoutError;
+    if (error.has_error() && !timed_out && request->retry_count < request->max_retries)
+    {
+        request->retry_count += 1;
+        Debug_Http_Push(error);
+        WorkerResult result = {};
+        result.next_task = WorkerItem(request, _co_http_retry);
+        result.us_delay = 10'000'000; // 10 sec
+        return result;
+    }
+
+    _co_http_finish(request, error);
+    return {};
+}
+
+g_internal WorkerResult
+_co_http_retry(ThreadInfo thread_info, WorkerData data)
+{
+    (void)thread_info;
+    CoHttpRequestAwaiter* request = (CoHttpRequestAwaiter*)data;
+    _curl_reset(&request->curl_ctx);
+    AsyncError error = _co_http_configure(request);
+    if (!error.has_error())
+    {
+        if (_co_http_submit(request))
+        {
+            return {};
+        }
+        error = async_user_error(AsyncResult::NoWorkError);
+    }
+    _co_http_finish(request, error);
+    return {};
+}
+
+g_internal void
+_co_http_finish(CoHttpRequestAwaiter* request, AsyncError error)
+{
+    CurlContext* curl_ctx = &request->curl_ctx;
+    request->response.error = error;
+    if (error.has_error())
+    {
+        Debug_Http_Push(error);
+    }
+    else if (request->arena != 0)
+    {
+        request->response.body = push_str8_copy(request->arena, curl_ctx->body.str);
+    }
+    else
+    {
+        // ~mgj: co_http_download, the response takes the buffer and the cleanup below leaves it alone
+        request->response.body = curl_ctx->body.str;
+        request->response.body_arena = curl_ctx->body.arena;
+        curl_ctx->body = {};
+    }
+    _curl_context_cleanup(curl_ctx);
+
+    // ~mgj: the coroutine continues on this worker; request lives in its frame, so it is not touched after this
+    std::coroutine_handle<> handle = request->handle;
+    handle.resume();
+}
+
 } // namespace async
@@ -11,6 +11,7 @@ template <typename T>
 struct UserFuncResult;
 
 // typedefs for worker funcs
+// ~mgj: response_body is zero padded (see HttpBody) and only valid during the call
 template <typename T>
 using AsyncWorkFunc = UserFuncResult<T> (*)(Arena* arena, async::ThreadPool*, String8 response_body, T* task_state);
 template <typename T>
@@ -150,14 +151,30 @@ async_error(AsyncResult result, CurlCodeType curl_code_type, U32 curl_code, cons
 #define async_error_set(o, e) ((o)->error = (e))
 // clang-format on
 
+// ~mgj: enough for simdjson (SIMDJSON_PADDING) to parse a body in place
+const U64 HTTP_BODY_PADDING = 64;
+const U64 HTTP_BODY_RESERVE_SIZE = GB(4);
+
+// ~mgj: Response body curl streams into. The arena is a single reserved block that never chains, so the
+// body grows in place, stays contiguous and is never copied. str is always followed by HTTP_BODY_PADDING
+// zero bytes; the arena is only created by the first write.
+struct HttpBody
+{
+    Arena* arena;
+    String8 str;
+};
+
 typedef size_t (*CurlWriteCallback)(void* contents, size_t size, size_t nmemb, void* userp);
 struct CurlContext
 {
     Arena* arena;
-    ChunkList<U8> chunk_list;
-    CURLM* multi_handle;
+    ChunkList<U8> chunk_list; // websocket frames
+    HttpBody body;
     CURL* session_handle;
     curl_slist* headers;
+    // ~mgj: requests run on the HttpEngine, only websockets poll a multi handle of their own
+    HttpEngineRequest engine_request;
+    CURLM* multi_handle;
     B32 added_to_multi;
 };
 
@@ -192,6 +209,52 @@ struct AsyncHttpTaskState
     String8 http_error_msg;
 };
 
+// ~mgj: result of co_await co_http_request. body is allocated in the arena given to co_http_request and
+// only set on success; http_code is the last response code, 0 when no response arrived. co_http_download
+// hands over the streamed buffer instead: body is zero padded then and lives in body_arena until
+// http_response_release.
+struct HttpResponse
+{
+    AsyncError error;
+    U32 http_code;
+    String8 body;
+    Arena* body_arena;
+};
+
+// ~mgj: Sends http_info through the global HttpEngine and resumes the awaiting coroutine on a worker once
+// the response is in. Failed requests (curl errors and http codes >= 400) are retried max_retries times,
+// 10 seconds apart, the whole request including retries fails with TimeoutError after timeout_sec. Lives
+// in the awaiting coroutine frame, so the curl state needs no allocation of its own.
+struct CoHttpRequestAwaiter
+{
+    Arena* arena; // 0 hands the streamed body over to the response
+    HttpInfo* http_info;
+    U32 max_retries;
+    U32 retry_count;
+    U64 timeout_us;
+    U64 start_us;
+
+    ThreadPool* thread_pool;
+    U32 name_id;
+    std::coroutine_handle<> handle;
+    CurlContext curl_ctx;
+    HttpResponse response;
+
+    bool
+    await_ready() noexcept
+    {
+        return false;
+    }
+    template <typename P>
+    bool
+    await_suspend(std::coroutine_handle<P> coroutine);
+    HttpResponse
+    await_resume() noexcept
+    {
+        return response;
+    }
+};
+
 template <typename T>
 struct AsyncHttpTaskStateConfig
 {
@@ -248,6 +311,10 @@ template <typename T>
 g_internal AsyncTaskContinuation<T>
 _http_main(ThreadInfo thread_info, AsyncTaskStatus<T>* task_status);
 
+template <typename T>
+g_internal AsyncTaskContinuation<T>
+_http_complete(ThreadInfo thread_info, AsyncTaskStatus<T>* task_status);
+
 template <typename T>
 g_internal AsyncTaskContinuation<T>
 _async_http_task_continuation(AsyncHttpTaskState<T>* http_ctx, AsyncWorkFunc<T> func, HttpInfo* http_info, S64 us_delay = 0);
@@ -267,6 +334,13 @@ _async_main_thread_queue_push(ThreadPool* thread_pool, AsyncTaskStatus<T>* task_
 g_internal CurlContext*
 _curl_ctx_create(Arena* arena);
 
+g_internal void
+_curl_ctx_init(CurlContext* curl_ctx);
+
+// ~mgj: runs the configured session handle on the global HttpEngine, completion is pushed to thread_pool
+g_internal B32
+_curl_ctx_submit(CurlContext* curl_ctx, ThreadPool* thread_pool, WorkerItem completion);
+
 g_internal void
 _curl_reset(CurlContext* curl_ctx);
 
@@ -288,4 +362,39 @@ template <typename T>
 g_internal AsyncHttpTaskCreateResult<T>
 async_http_task_run(ThreadPool* thread_pool, HttpInfo* http_info, AsyncHttpTaskStateConfig<T>* config, const char* task_name);
 
+g_internal CoHttpRequestAwaiter
+co_http_request(Arena* arena, HttpInfo* http_info, U32 max_retries = 0, U32 timeout_sec = 0);
+
+// ~mgj: co_http_request for large bodies that are parsed in place, see HttpResponse
+g_internal CoHttpRequestAwaiter
+co_http_download(HttpInfo* http_info, U32 max_retries = 0, U32 timeout_sec = 0);
+
+g_internal void
+http_response_release(HttpResponse* response);
+
+// ~mgj: false when the body would outgrow HTTP_BODY_RESERVE_SIZE
+g_internal B32
+http_body_append(HttpBody* body, void* data, U64 size);
+
+g_internal void
+http_body_release(HttpBody* body);
+
+g_internal size_t
+_curl_ctx_write_callback(void* contents, size_t size, size_t nmemb, void* userp);
+
+g_internal AsyncError
+_co_http_configure(CoHttpRequestAwaiter* request);
+
+g_internal B32
+_co_http_submit(CoHttpRequestAwaiter* request);
+
+g_internal WorkerResult
+_co_http_complete(ThreadInfo thread_info, WorkerData data);
+
+g_internal WorkerResult
+_co_http_retry(ThreadInfo thread_info, WorkerData data);
+
+g_internal void
+_co_http_finish(CoHttpRequestAwaiter* request, AsyncError error);
+
 } // namespace async
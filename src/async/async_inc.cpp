@@ -1,8 +1,15 @@
 #include "thread_pool.cpp"
+#include "thread_pool_stats.cpp"
+#include "task_graph.cpp"
+#include "parallel.cpp"
+#include "coro.cpp"
 #include "spmc_queue.cpp"
 #include "segment_buffer.cpp"
 #include "async_heap.cpp"
+#include "http_engine.cpp"
 #include "async_http.cpp"
 #include "async_task.cpp"
 #include "mpmc_queue.cpp"
+#include "mpmc_ring.cpp"
+#include "timer_wheel.cpp"
 #include "async_websocket.cpp"
@@ -5,9 +5,16 @@
 #include "http/http.h"
 #include "segment_buffer.hpp"
 #include "async_heap.hpp"
+#include "mpmc_ring.hpp"
 #include "mpmc_queue.hpp"
+#include "timer_wheel.hpp"
 #include "thread_pool.hpp"
+#include "thread_pool_stats.hpp"
+#include "task_graph.hpp"
+#include "parallel.hpp"
+#include "coro.hpp"
 #include "spmc_queue.hpp"
+#include "http_engine.hpp"
 #include "async_task.hpp"
 #include "async_http.hpp"
 #include "async_websocket.hpp"
@@ -10,7 +10,19 @@ _worker_task_func(ThreadInfo thread_info, WorkerData data)
     AsyncTaskContinuation<T> continuation_func = work->func(thread_info, work->data);
     work->func = continuation_func.func;
     WorkerResult worker_result = {};
-    if (work->func)
+    if (work->func && continuation_func.await_http)
+    {
+        // ~mgj: the engine resumes the task from another thread, work and task are not touched after the submit
+        WorkerItem completion = WorkerItem(work, _worker_task_func<T>);
+        completion.name_id = thread_pool_stats_task_name_id(thread_info.thread_pool, task->task_name);
+        if (_curl_ctx_submit(task->http_ext->curl_ctx, thread_info.thread_pool, completion))
+        {
+            return worker_result;
+        }
+        async_error_set(task->http_ext, async_user_error(AsyncResult::NoWorkError));
+        task->error.store(true);
+    }
+    else if (work->func)
     {
         worker_result.next_task = WorkerItem(work, _worker_task_func<T>);
         worker_result.us_delay = continuation_func.us_delay;
@@ -27,6 +39,7 @@ _worker_task_func(ThreadInfo thread_info, WorkerData data)
             AsyncHttpTaskState<T>* http_ctx = task->http_ext;
             _curl_context_cleanup(http_ctx->curl_ctx);
         }
+        _async_task_done_node_notify(task);
         task->done.store(true, std::memory_order_release);
     }
     return worker_result;
@@ -53,11 +66,13 @@ async_task_run(AsyncTaskStatus<T>* task_status, ThreadPool* thread_pool, WorkerT
     work->func = func;
     work->data = task_status;
     WorkerItem task_ext = WorkerItem(work, _worker_task_func<T>);
+    task_ext.name_id = thread_pool_stats_task_name_id(thread_pool, task_status->task_name);
 
     task_status->started = true;
     B32 scheduled = thread_pool_push(thread_pool, &task_ext, us_delay);
     if (!scheduled)
     {
+        _async_task_done_node_notify(task_status);
         task_status->done.store(true);
     }
     return task_status;
@@ -130,4 +145,73 @@ async_task_with_ext_run(Arena* arena, ThreadPool* thread_pool, WorkerTaskFunc<T>
     return async_task_run(task_status, thread_pool, func, us_delay);
 }
 
+template <typename T>
+g_internal AsyncTaskStatus<T>*
+async_task_co_run(ThreadPool* thread_pool, CoTaskFunc<T> func, T* data, const char* task_name)
+{
+    Arena* task_arena = arena_alloc();
+    Debug_SetName(task_arena, task_name);
+    return async_task_co_run(task_arena, thread_pool, func, data, task_name);
+}
+
+template <typename T>
+g_internal AsyncTaskStatus<T>*
+async_task_co_run(Arena* arena, ThreadPool* thread_pool, CoTaskFunc<T> func, T* data, const char* task_name)
+{
+    String8 task_name_str8 = str8_c_string(task_name);
+    AsyncTaskStatus<T>* task_status = _async_task_status_create<T>(arena, thread_pool, task_name_str8, data);
+
+    task_status->started = true;
+    CoDetached co_main = _async_task_co_main(task_status, func(arena, data));
+    U32 name_id = thread_pool_stats_task_name_id(thread_pool, task_status->task_name);
+    if (!_co_detached_start(thread_pool, co_main, name_id))
+    {
+        task_status->error.store(true);
+        _async_task_done_node_notify(task_status);
+        task_status->done.store(true);
+    }
+    return task_status;
+}
+
+template <typename T>
+g_internal CoDetached
+_async_task_co_main(AsyncTaskStatus<T>* task_status, CoTask<B32> task)
+{
+    B32 success = false;
+    {
+        // ~mgj: the task frames live in the task arena, they are destroyed at the end of this scope,
+        // before `done` lets the consumer release the arena
+        CoTask<B32> task_body = std::move(task);
+        success = co_await task_body;
+    }
+    task_status->error.store(!success);
+    _async_task_done_node_notify(task_status);
+    task_status->done.store(true, std::memory_order_release);
+}
+
+// ~mgj: whichever of the task and async_task_done_node_set comes second completes the node
+g_internal TaskNode g_async_task_done_node_fired = {};
+
+template <typename T>
+g_internal void
+async_task_done_node_set(AsyncTaskStatus<T>* task, TaskNode* node)
+{
+    TaskNode* prev = task->done_node.exchange(node, std::memory_order_acq_rel);
+    if (prev == &g_async_task_done_node_fired)
+    {
+        task_node_complete(node, !task->error.load());
+    }
+}
+
+template <typename T>
+g_internal void
+_async_task_done_node_notify(AsyncTaskStatus<T>* task)
+{
+    TaskNode* node = task->done_node.exchange(&g_async_task_done_node_fired, std::memory_order_acq_rel);
+    if (node)
+    {
+        task_node_complete(node, !task->error.load());
+    }
+}
+
 } // namespace async
@@ -4,6 +4,7 @@ namespace async
 
 template <typename T>
 struct AsyncHttpTaskState;
+struct TaskNode;
 
 enum class ExtensionType
 {
@@ -30,6 +31,8 @@ struct AsyncTaskStatus
     B32 started;
     std::atomic<B32> done;
     std::atomic<B32> error;
+    // ~mgj: external task graph node completed with the task, see async_task_done_node_set
+    std::atomic<TaskNode*> done_node;
 
     T* user_data;
 };
@@ -45,6 +48,8 @@ struct AsyncTaskContinuation
 {
     WorkerTaskFunc<T> func;
     S64 us_delay;
+    // ~mgj: run the configured transfer of the http extension first, func runs when it has finished
+    B32 await_http;
 };
 
 template <typename T>
@@ -148,6 +153,35 @@ template <typename T>
 g_internal AsyncTaskStatus<T>*
 async_task_run(Arena* arena, ThreadPool* thread_pool, WorkerTaskFunc<T> func, T* data, const char* task_name, S64 us_delay);
 
+// ~mgj: Completes node (an external task graph node) when the task finishes, right before done is
+// published. Call before the task result is consumed with async_task_is_done; if the task has already
+// finished the node is completed immediately.
+template <typename T>
+g_internal void
+async_task_done_node_set(AsyncTaskStatus<T>* task, TaskNode* node);
+
+template <typename T>
+g_internal void
+_async_task_done_node_notify(AsyncTaskStatus<T>* task);
+
+// ~mgj: Coroutine version of async_task_run. func is called with the task arena (its frame and every frame
+// it awaits with that arena are allocated there, the arena is released with the task result) and runs on thread_pool; the task errors when it returns
+// false. Completion is consumed the same way, with async_task_is_done and async_task_done_node_set.
+template <typename T>
+using CoTaskFunc = CoTask<B32> (*)(Arena* arena, T* data);
+
+template <typename T>
+g_internal AsyncTaskStatus<T>*
+async_task_co_run(ThreadPool* thread_pool, CoTaskFunc<T> func, T* data, const char* task_name);
+
+template <typename T>
+g_internal AsyncTaskStatus<T>*
+async_task_co_run(Arena* arena, ThreadPool* thread_pool, CoTaskFunc<T> func, T* data, const char* task_name);
+
+template <typename T>
+g_internal CoDetached
+_async_task_co_main(AsyncTaskStatus<T>* task_status, CoTask<B32> task);
+
 template <typename T>
 g_internal AsyncTaskStatus<T>*
 async_task_with_ext_run(Arena* arena, ThreadPool* thread_pool, WorkerTaskFunc<T> func, T* data, const char* task_name, S64 us_delay, ExtensionType ext_type, void* ext);
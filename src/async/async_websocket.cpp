@@ -55,7 +55,7 @@ _ws_main(AsyncWebsocketSession* ws_session)
 }
 
 g_internal WebsocketConnection
-async_websocket_start(String8 url)
+async_websocket_start(String8 url, String8 subprotocols)
 {
     Arena* session_arena = arena_alloc();
     Debug_SetName(session_arena, "websocket session arena");
@@ -67,6 +67,11 @@ async_websocket_start(String8 url)
     async_http_global_init();
     ws_session->curl_ctx = _curl_ctx_create(session_arena);
     ws_session->http_info = async::http_info_create(session_arena, HTTP_Method_None, url, {}, {}, {});
+    if (subprotocols.size)
+    {
+        String8 header = push_str8f(session_arena, "Sec-WebSocket-Protocol: %.*s", str8_varg(subprotocols));
+        str8_list_push(session_arena, &ws_session->http_info->headers, header);
+    }
     // websocket extension
     {
         B32 is_ws = str8_match(ws_session->http_info->http_path, S("ws://"), MatchFlag_RightSideSloppy);
@@ -80,12 +85,37 @@ async_websocket_start(String8 url)
         }
     }
 
-    ws_session->error = _async_http_configure(session_arena, ws_session->curl_ctx, ws_session->http_info, _libcurl_ws_callback, ws_session);
+    // ~mgj: a websocket stays open and is polled by its reader, it does not go through the HttpEngine
+    ws_session->curl_ctx->multi_handle = curl_multi_init();
+    ws_session->error = _ws_configure(ws_session);
 
     WebsocketConnection result = WebsocketConnection(ws_session->error, ws_session);
     return result;
 }
 
+g_internal AsyncError
+_ws_configure(AsyncWebsocketSession* ws_session)
+{
+    CurlContext* curl_ctx = ws_session->curl_ctx;
+    if (curl_ctx->multi_handle == 0)
+    {
+        return async_user_error(AsyncResult::HandleInitError);
+    }
+    AsyncError error = _async_http_configure(ws_session->arena, curl_ctx, ws_session->http_info, _libcurl_ws_callback, ws_session);
+    if (error.has_error())
+    {
+        return error;
+    }
+
+    CURLMcode multi_err = curl_multi_add_handle(curl_ctx->multi_handle, curl_ctx->session_handle);
+    if (multi_err != CURLM_OK)
+    {
+        return async_curl_error(CurlCodeType::Multi, multi_err);
+    }
+    curl_ctx->added_to_multi = true;
+    return async_no_error();
+}
+
 g_internal void
 _async_http_connection_end(AsyncWebsocketSession* ws_session)
 {
@@ -101,6 +131,12 @@ _async_http_connection_end(AsyncWebsocketSession* ws_session)
     arena_release(ws_session->arena);
 }
 
+String8
+WebsocketConnection::subprotocol()
+{
+    return this->ws_session ? this->ws_session->subprotocol : String8{};
+}
+
 String8List
 WebsocketConnection::read(Arena* arena)
 {
@@ -120,7 +156,10 @@ _async_websocket_read(Arena* arena, AsyncWebsocketSession* ws_session)
     {
         DEBUG_LOG("error when reading websocket: %u", ws_session->error.curl_code);
         _curl_reset(ws_session->curl_ctx);
-        ws_session->error = _async_http_configure(ws_session->arena, ws_session->curl_ctx, ws_session->http_info, _libcurl_ws_callback, ws_session);
+        // ~mgj: the server may pick differently on the next connection
+        ws_session->subprotocol_checked = false;
+        ws_session->subprotocol = {};
+        ws_session->error = _ws_configure(ws_session);
     }
 
     os_mutex_scope_w(ws_session->msg_rw_mutex)
@@ -133,6 +172,26 @@ _async_websocket_read(Arena* arena, AsyncWebsocketSession* ws_session)
     return result;
 }
 
+g_internal void
+_ws_subprotocol_check(AsyncWebsocketSession* ws_session)
+{
+    if (ws_session->subprotocol_checked)
+    {
+        return;
+    }
+    ws_session->subprotocol_checked = true;
+    curl_header* header = 0;
+    CURLHcode header_code = curl_easy_header(ws_session->curl_ctx->session_handle, "Sec-WebSocket-Protocol", 0, CURLH_HEADER | CURLH_1XX, -1, &header);
+    if (header_code == CURLHE_OK)
+    {
+        String8 value = str8_c_string(header->value);
+        value.size = Min(value.size, sizeof(ws_session->subprotocol_buffer));
+        MemoryCopy(ws_session->subprotocol_buffer, value.str, value.size);
+        ws_session->subprotocol = str8(ws_session->subprotocol_buffer, value.size);
+        DEBUG_LOG("websocket subprotocol: %.*s", str8_varg(ws_session->subprotocol));
+    }
+}
+
 g_internal size_t
 _libcurl_ws_callback(void* contents, size_t size, size_t nmemb, void* userp)
 {
@@ -140,9 +199,11 @@ _libcurl_ws_callback(void* contents, size_t size, size_t nmemb, void* userp)
     AsyncWebsocketSession* ws_session = (AsyncWebsocketSession*)userp;
     CurlContext* curl_ctx = ws_session->curl_ctx;
     Arena* msg_arena = ws_session->msg_arena;
+    _ws_subprotocol_check(ws_session);
 
-    U8* buffer = PushArray(msg_arena, U8, total_size);
-    ChunkItem<U8>* chunk = chunk_item_from_array(msg_arena, buffer, total_size);
+    // ~mgj: partial frames stay in the curl arena, read() clears msg_arena whenever it takes the messages
+    U8* buffer = PushArray(curl_ctx->arena, U8, total_size);
+    ChunkItem<U8>* chunk = chunk_item_from_array(curl_ctx->arena, buffer, total_size);
     MemoryCopy(buffer, contents, total_size);
     chunk_list_insert_chunk(&curl_ctx->chunk_list, chunk);
 
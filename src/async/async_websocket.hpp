@@ -16,6 +16,11 @@ struct AsyncWebsocketSession
     U32 http_error_code;
     String8 http_error_msg;
 
+    // subprotocol the server picked from the offer, read once the upgrade response is in
+    B32 subprotocol_checked;
+    U8 subprotocol_buffer[64];
+    String8 subprotocol;
+
     // msgs
     OS_Handle msg_rw_mutex;
     Arena* msg_arena;     // reset every read
@@ -25,6 +30,9 @@ struct AsyncWebsocketSession
 g_internal void
 _async_http_connection_end(AsyncWebsocketSession* ws_session);
 
+g_internal AsyncError
+_ws_configure(AsyncWebsocketSession* ws_session);
+
 g_internal String8List
 _async_websocket_read(Arena* arena, AsyncWebsocketSession* ws_session);
 
@@ -84,10 +92,18 @@ struct WebsocketConnection
 
     String8List
     read(Arena* arena);
+
+    // ~mgj: empty until the first message arrived or when the server did not pick one of the offered
+    String8
+    subprotocol();
 };
 
+// ~mgj: subprotocols is the comma separated Sec-WebSocket-Protocol offer, most preferred first
 g_internal WebsocketConnection
-async_websocket_start(String8 url);
+async_websocket_start(String8 url, String8 subprotocols = {});
+
+g_internal void
+_ws_subprotocol_check(AsyncWebsocketSession* ws_session);
 
 g_internal size_t
 _libcurl_ws_callback(void* contents, size_t size, size_t nmemb, void* userp);
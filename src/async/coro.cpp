@@ -0,0 +1,192 @@
+namespace async
+{
+
+// ~mgj: the header in front of every frame says where it came from, 16 bytes keep the frame aligned
+static void*
+_co_frame_alloc(Arena* arena, U64 size)
+{
+    U64* header = 0;
+    if (arena)
+    {
+        header = PushArrayNoZeroAligned(arena, U64, 2 + CeilIntegerDiv(size, sizeof(U64)), 16);
+    }
+    else
+    {
+        header = (U64*)malloc(size + 2 * sizeof(U64));
+        AssertAlways(header);
+    }
+    header[0] = arena == 0;
+    return header + 2;
+}
+
+void*
+CoPromiseBase::operator new(size_t size)
+{
+    return _co_frame_alloc(0, size);
+}
+
+void
+CoPromiseBase::operator delete(void* frame)
+{
+    U64* header = (U64*)frame - 2;
+    if (header[0])
+    {
+        free(header);
+    }
+}
+
+template <typename P>
+std::coroutine_handle<>
+CoFinalAwaiter::await_suspend(std::coroutine_handle<P> handle) noexcept
+{
+    CoPromiseBase& promise = handle.promise();
+    if (promise.continuation)
+    {
+        return promise.continuation;
+    }
+    if (promise.when_all)
+    {
+        CoWhenAllState* when_all = promise.when_all;
+        return when_all->remaining.fetch_sub(1) == 1 ? when_all->parent : std::noop_coroutine();
+    }
+    // ~mgj: a root, its owner may destroy the frame as soon as this is visible
+    promise.done.store(true, std::memory_order_release);
+    return std::noop_coroutine();
+}
+
+template <typename P>
+void
+CoDelayAwaiter::await_suspend(std::coroutine_handle<P> handle)
+{
+    CoPromiseBase& promise = handle.promise();
+    AssertAlways(_co_resume_push(promise.thread_pool, handle, promise.name_id, us_delay));
+}
+
+template <typename P>
+bool
+CoThreadHopAwaiter::await_suspend(std::coroutine_handle<P> handle)
+{
+    CoPromiseBase& promise = handle.promise();
+    if (thread_pool_is_main_thread(promise.thread_pool) == to_main_thread)
+    {
+        return false;
+    }
+    if (to_main_thread)
+    {
+        WorkerItem item = WorkerItem(handle.address(), _co_resume_task);
+        item.name_id = promise.name_id;
+        AssertAlways(thread_pool_main_thread_queue_push(promise.thread_pool, &item));
+    }
+    else
+    {
+        AssertAlways(_co_resume_push(promise.thread_pool, handle, promise.name_id));
+    }
+    return true;
+}
+
+template <typename T>
+template <typename P>
+bool
+CoWhenAllAwaiter<T>::await_suspend(std::coroutine_handle<P> parent)
+{
+    CoPromiseBase& parent_promise = parent.promise();
+    // ~mgj: one extra count for this function, whoever takes the count to zero resumes the parent
+    state.remaining.store(task_count + 1);
+    state.parent = parent;
+    for (U32 task_idx = 0; task_idx < task_count; ++task_idx)
+    {
+        typename CoTask<T>::promise_type& promise = tasks[task_idx].handle.promise();
+        promise.thread_pool = parent_promise.thread_pool;
+        promise.name_id = parent_promise.name_id;
+        promise.when_all = &state;
+        AssertAlways(_co_resume_push(parent_promise.thread_pool, tasks[task_idx].handle, parent_promise.name_id));
+    }
+    return state.remaining.fetch_sub(1) != 1;
+}
+
+template <typename T>
+static B32
+co_task_start(ThreadPool* thread_pool, CoTask<T>* task, String8 name)
+{
+    typename CoTask<T>::promise_type& promise = task->handle.promise();
+    promise.thread_pool = thread_pool;
+    promise.name_id = thread_pool_stats_task_name_id(thread_pool, name);
+    return _co_resume_push(thread_pool, task->handle, promise.name_id);
+}
+
+template <typename T>
+static B32
+co_task_is_done(CoTask<T>* task)
+{
+    return task->handle.promise().done.load(std::memory_order_acquire);
+}
+
+template <typename T>
+static T
+co_task_result(CoTask<T>* task)
+{
+    return task->handle.promise().value;
+}
+
+static CoDelayAwaiter
+co_delay(S64 us_delay)
+{
+    return CoDelayAwaiter{.us_delay = us_delay};
+}
+
+static CoThreadHopAwaiter
+co_main_thread()
+{
+    return CoThreadHopAwaiter{.to_main_thread = true};
+}
+
+static CoThreadHopAwaiter
+co_worker_thread()
+{
+    return CoThreadHopAwaiter{.to_main_thread = false};
+}
+
+static CoThreadPoolAwaiter
+co_thread_pool()
+{
+    return CoThreadPoolAwaiter{};
+}
+
+template <typename T>
+static CoWhenAllAwaiter<T>
+co_when_all(CoTask<T>* tasks, U32 task_count)
+{
+    return CoWhenAllAwaiter<T>{.tasks = tasks, .task_count = task_count};
+}
+
+static WorkerResult
+_co_resume_task(ThreadInfo thread_info, WorkerData data)
+{
+    (void)thread_info;
+    std::coroutine_handle<>::from_address(data).resume();
+    return {};
+}
+
+static B32
+_co_resume_push(ThreadPool* thread_pool, std::coroutine_handle<> handle, U32 name_id, S64 us_delay)
+{
+    WorkerItem item = WorkerItem(handle.address(), _co_resume_task);
+    item.name_id = name_id;
+    return thread_pool_push(thread_pool, &item, us_delay);
+}
+
+static B32
+_co_detached_start(ThreadPool* thread_pool, CoDetached detached, U32 name_id)
+{
+    CoDetached::promise_type& promise = detached.handle.promise();
+    promise.thread_pool = thread_pool;
+    promise.name_id = name_id;
+    if (!_co_resume_push(thread_pool, detached.handle, name_id))
+    {
+        detached.handle.destroy();
+        return false;
+    }
+    return true;
+}
+
+} // namespace async
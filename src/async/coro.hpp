@@ -0,0 +1,322 @@
+#pragma once
+
+#include <coroutine>
+
+namespace async
+{
+// ~mgj: Coroutine front-end for the thread pool. A CoTask<T> is a lazily started coroutine that runs on
+// ThreadPool workers and completes with a T. Awaiting a CoTask starts it inline and resumes the awaiter
+// when it returns (symmetric transfer, no pool round trip). Suspension points push a WorkerItem that
+// resumes the coroutine, so a pipeline of requests, delays and main thread hops is one linear function
+// whose state lives in its coroutine frame:
+//
+//     static CoTask<B32>
+//     fetch(Arena* arena, HttpInfo* http_info)
+//     {
+//         HttpResponse response = co_await co_http_request(arena, http_info, 3);
+//         if (response.error.has_error())
+//         {
+//             co_return false;
+//         }
+//         co_await co_delay(1'000'000);
+//         co_await co_main_thread(); // runs in thread_pool_main_thread_queue_drain from here on
+//         ...
+//         co_return true;
+//     }
+//
+// Frames are allocated from the first parameter when it is an Arena* (one push per coroutine call,
+// nothing is freed until the arena is released), from the heap otherwise. The arena is not locked:
+// coroutines running at the same time (co_when_all children) must not allocate from the same one.
+// Exceptions are not supported, an escaping exception ends the program.
+template <typename T>
+struct CoTask;
+
+static void*
+_co_frame_alloc(Arena* arena, U64 size);
+
+struct CoWhenAllState
+{
+    std::atomic<U32> remaining;
+    std::coroutine_handle<> parent;
+};
+
+struct CoPromiseBase
+{
+    // ~mgj: set by co_task_start on the root and copied into every awaited child
+    ThreadPool* thread_pool = 0;
+    U32 name_id = 0;
+    // resumed when the coroutine finishes, at most one of them is set. A root has neither and publishes done.
+    std::coroutine_handle<> continuation = 0;
+    CoWhenAllState* when_all = 0;
+    std::atomic<B32> done = false;
+
+    static void*
+    operator new(size_t size);
+    template <typename... Args>
+    static void*
+    operator new(size_t size, Arena* arena, Args&...)
+    {
+        return _co_frame_alloc(arena, size);
+    }
+    static void
+    operator delete(void* frame);
+
+    void
+    unhandled_exception()
+    {
+        exit_with_error("Unhandled exception in a coroutine");
+    }
+};
+
+struct CoFinalAwaiter
+{
+    bool
+    await_ready() noexcept
+    {
+        return false;
+    }
+    template <typename P>
+    std::coroutine_handle<>
+    await_suspend(std::coroutine_handle<P> handle) noexcept;
+    void
+    await_resume() noexcept
+    {
+    }
+};
+
+template <typename T>
+struct CoTask
+{
+    struct promise_type : CoPromiseBase
+    {
+        T value = {};
+
+        CoTask<T>
+        get_return_object()
+        {
+            return CoTask<T>(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always
+        initial_suspend() noexcept
+        {
+            return {};
+        }
+        CoFinalAwaiter
+        final_suspend() noexcept
+        {
+            return {};
+        }
+        void
+        return_value(T result)
+        {
+            value = result;
+        }
+    };
+
+    std::coroutine_handle<promise_type> handle;
+
+    CoTask() : handle(0)
+    {
+    }
+    explicit CoTask(std::coroutine_handle<promise_type> handle) : handle(handle)
+    {
+    }
+    CoTask(const CoTask<T>& other) = delete;
+    CoTask<T>&
+    operator=(const CoTask<T>& other) = delete;
+    CoTask(CoTask<T>&& other) noexcept : handle(other.handle)
+    {
+        other.handle = 0;
+    }
+    CoTask<T>&
+    operator=(CoTask<T>&& other) noexcept
+    {
+        if (this != &other)
+        {
+            if (handle)
+            {
+                handle.destroy();
+            }
+            handle = other.handle;
+            other.handle = 0;
+        }
+        return *this;
+    }
+    ~CoTask()
+    {
+        if (handle)
+        {
+            handle.destroy();
+        }
+    }
+
+    // awaiting runs the task inline on the awaiting thread
+    bool
+    await_ready() noexcept
+    {
+        return false;
+    }
+    template <typename P>
+    std::coroutine_handle<>
+    await_suspend(std::coroutine_handle<P> parent) noexcept
+    {
+        promise_type& promise = handle.promise();
+        promise.thread_pool = parent.promise().thread_pool;
+        promise.name_id = parent.promise().name_id;
+        promise.continuation = parent;
+        return handle;
+    }
+    T
+    await_resume()
+    {
+        return handle.promise().value;
+    }
+};
+
+// ~mgj: resumes the coroutine on a worker after us_delay
+struct CoDelayAwaiter
+{
+    S64 us_delay;
+
+    bool
+    await_ready() noexcept
+    {
+        return us_delay <= 0;
+    }
+    template <typename P>
+    void
+    await_suspend(std::coroutine_handle<P> handle);
+    void
+    await_resume() noexcept
+    {
+    }
+};
+
+// ~mgj: resumes the coroutine on the main thread (from a worker) or on a worker (from the main thread),
+// does not suspend when already there
+struct CoThreadHopAwaiter
+{
+    B32 to_main_thread;
+
+    bool
+    await_ready() noexcept
+    {
+        return false;
+    }
+    template <typename P>
+    bool
+    await_suspend(std::coroutine_handle<P> handle);
+    void
+    await_resume() noexcept
+    {
+    }
+};
+
+// ~mgj: the pool the coroutine runs on, for work it fans out itself; never suspends
+struct CoThreadPoolAwaiter
+{
+    ThreadPool* thread_pool;
+
+    bool
+    await_ready() noexcept
+    {
+        return false;
+    }
+    template <typename P>
+    bool
+    await_suspend(std::coroutine_handle<P> handle) noexcept
+    {
+        thread_pool = handle.promise().thread_pool;
+        return false;
+    }
+    ThreadPool*
+    await_resume() noexcept
+    {
+        return thread_pool;
+    }
+};
+
+// ~mgj: starts every task on the pool and resumes the awaiter once all of them have finished, results
+// are read from the tasks afterwards with co_task_result
+template <typename T>
+struct CoWhenAllAwaiter
+{
+    CoTask<T>* tasks;
+    U32 task_count;
+    CoWhenAllState state;
+
+    bool
+    await_ready() noexcept
+    {
+        return task_count == 0;
+    }
+    template <typename P>
+    bool
+    await_suspend(std::coroutine_handle<P> parent);
+    void
+    await_resume() noexcept
+    {
+    }
+};
+
+// ~mgj: a coroutine that owns itself, it is destroyed when it finishes
+struct CoDetached
+{
+    struct promise_type : CoPromiseBase
+    {
+        CoDetached
+        get_return_object()
+        {
+            return CoDetached{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_always
+        initial_suspend() noexcept
+        {
+            return {};
+        }
+        std::suspend_never
+        final_suspend() noexcept
+        {
+            return {};
+        }
+        void
+        return_void()
+        {
+        }
+    };
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+////////////////////////////////////////////////
+// ~mgj: Runs a root task on thread_pool, false when the pool does not take work anymore. The caller keeps
+// owning the task and must not destroy it before co_task_is_done.
+template <typename T>
+static B32
+co_task_start(ThreadPool* thread_pool, CoTask<T>* task, String8 name = {});
+template <typename T>
+static B32
+co_task_is_done(CoTask<T>* task);
+template <typename T>
+static T
+co_task_result(CoTask<T>* task);
+static CoDelayAwaiter
+co_delay(S64 us_delay);
+static CoThreadHopAwaiter
+co_main_thread();
+static CoThreadHopAwaiter
+co_worker_thread();
+static CoThreadPoolAwaiter
+co_thread_pool();
+template <typename T>
+static CoWhenAllAwaiter<T>
+co_when_all(CoTask<T>* tasks, U32 task_count);
+
+// ~mgj: internal
+static WorkerResult
+_co_resume_task(ThreadInfo thread_info, WorkerData data);
+static B32
+_co_resume_push(ThreadPool* thread_pool, std::coroutine_handle<> handle, U32 name_id, S64 us_delay = 0);
+static B32
+_co_detached_start(ThreadPool* thread_pool, CoDetached detached, U32 name_id);
+} // namespace async
@@ -0,0 +1,186 @@
+namespace async
+{
+
+g_internal HttpEngine* g_http_engine = 0;
+
+static HttpEngine*
+http_engine_create(HttpEngineConfig* config)
+{
+    async_http_global_init();
+
+    Arena* arena = arena_alloc();
+    Debug_SetName(arena, "http engine arena");
+    HttpEngine* engine = PushStruct(arena, HttpEngine);
+    engine->arena = arena;
+    engine->config = *config;
+    if (engine->config.max_host_connections == 0)
+    {
+        engine->config.max_host_connections = HTTP_ENGINE_MAX_HOST_CONNECTIONS_DEFAULT;
+    }
+    if (engine->config.dns_cache_timeout_sec == 0)
+    {
+        engine->config.dns_cache_timeout_sec = HTTP_ENGINE_DNS_CACHE_TIMEOUT_SEC_DEFAULT;
+    }
+
+    engine->multi_handle = curl_multi_init();
+    AssertAlways(engine->multi_handle);
+    curl_multi_setopt(engine->multi_handle, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+    curl_multi_setopt(engine->multi_handle, CURLMOPT_MAX_HOST_CONNECTIONS, (long)engine->config.max_host_connections);
+    curl_multi_setopt(engine->multi_handle, CURLMOPT_MAX_TOTAL_CONNECTIONS, (long)engine->config.max_total_connections);
+
+    engine->submit_queue = queue_alloc<HttpEngineRequest*>(arena, HTTP_ENGINE_SUBMIT_QUEUE_SIZE, QueueFullPolicy_Spill);
+    engine->kill_switch.store(false);
+    engine->thread_handle = OS_ThreadLaunch(_http_engine_thread, engine, NULL);
+    return engine;
+}
+
+static void
+http_engine_destroy(HttpEngine* engine)
+{
+    queue_close(engine->submit_queue);
+    engine->kill_switch.store(true);
+    curl_multi_wakeup(engine->multi_handle);
+    AssertAlways(OS_ThreadJoin(engine->thread_handle, max_U64));
+
+    curl_multi_cleanup(engine->multi_handle);
+    queue_release(engine->submit_queue);
+    arena_release(engine->arena);
+}
+
+static B32
+http_engine_submit(HttpEngine* engine, HttpEngineRequest* request)
+{
+    if (engine == 0)
+    {
+        return false;
+    }
+    request->next = 0;
+    request->prev = 0;
+    request->result = CURLE_OK;
+    request->http_code = 0;
+    // ~mgj: the completion runs at the priority of the submitter, not of the I/O thread
+    request->completion.priority = _thread_pool_priority_resolve(request->completion.priority);
+    curl_easy_setopt(request->session_handle, CURLOPT_PRIVATE, request);
+    curl_easy_setopt(request->session_handle, CURLOPT_DNS_CACHE_TIMEOUT, (long)engine->config.dns_cache_timeout_sec);
+    curl_easy_setopt(request->session_handle, CURLOPT_PIPEWAIT, 1L);
+
+    if (!queue_push(engine->submit_queue, &request))
+    {
+        return false;
+    }
+    curl_multi_wakeup(engine->multi_handle);
+    return true;
+}
+
+static void
+http_engine_global_set(HttpEngine* engine)
+{
+    g_http_engine = engine;
+}
+
+static HttpEngine*
+http_engine_global_get()
+{
+    return g_http_engine;
+}
+
+static void
+_http_engine_thread(void* data)
+{
+    HttpEngine* engine = (HttpEngine*)data;
+    os_set_thread_name(S("HttpEngine"));
+
+    while (!engine->kill_switch.load())
+    {
+        _http_engine_submit_drain(engine);
+
+        int running_count = 0;
+        CURLMcode multi_code = curl_multi_perform(engine->multi_handle, &running_count);
+        if (multi_code != CURLM_OK)
+        {
+            ERROR_LOG("http engine: curl_multi_perform failed: %s", curl_multi_strerror(multi_code));
+        }
+        _http_engine_completions_post(engine);
+
+        curl_multi_poll(engine->multi_handle, 0, 0, HTTP_ENGINE_POLL_TIMEOUT_MS, 0);
+    }
+
+    // ~mgj: the queue is closed, fail whatever made it in before that and everything still running
+    HttpEngineRequest* request = 0;
+    while (queue_try_read(engine->submit_queue, &request))
+    {
+        _http_engine_request_complete(engine, request, CURLE_ABORTED_BY_CALLBACK);
+    }
+    while (engine->active_first)
+    {
+        request = engine->active_first;
+        curl_multi_remove_handle(engine->multi_handle, request->session_handle);
+        DLLRemove(engine->active_first, engine->active_last, request);
+        _http_engine_request_complete(engine, request, CURLE_ABORTED_BY_CALLBACK);
+    }
+    engine->active_count.store(0);
+}
+
+static void
+_http_engine_submit_drain(HttpEngine* engine)
+{
+    HttpEngineRequest* request = 0;
+    while (queue_try_read(engine->submit_queue, &request))
+    {
+        CURLMcode multi_code = curl_multi_add_handle(engine->multi_handle, request->session_handle);
+        if (multi_code != CURLM_OK)
+        {
+            ERROR_LOG("http engine: curl_multi_add_handle failed: %s", curl_multi_strerror(multi_code));
+            _http_engine_request_complete(engine, request, CURLE_FAILED_INIT);
+            continue;
+        }
+        DLLPushBack(engine->active_first, engine->active_last, request);
+        engine->active_count.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+static void
+_http_engine_completions_post(HttpEngine* engine)
+{
+    int msgs_left = 0;
+    for (CURLMsg* msg = curl_multi_info_read(engine->multi_handle, &msgs_left); msg; msg = curl_multi_info_read(engine->multi_handle, &msgs_left))
+    {
+        if (msg->msg != CURLMSG_DONE)
+        {
+            continue;
+        }
+
+        HttpEngineRequest* request = 0;
+        curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char**)&request);
+        AssertAlways(request && request->session_handle == msg->easy_handle);
+        // ~mgj: msg points into the handle, read it before removing
+        CURLcode result = msg->data.result;
+
+        long http_code = 0;
+        long connect_count = 0;
+        curl_easy_getinfo(request->session_handle, CURLINFO_RESPONSE_CODE, &http_code);
+        curl_easy_getinfo(request->session_handle, CURLINFO_NUM_CONNECTS, &connect_count);
+        request->http_code = (U32)http_code;
+        engine->connect_count.fetch_add((U64)connect_count, std::memory_order_relaxed);
+
+        curl_multi_remove_handle(engine->multi_handle, request->session_handle);
+        DLLRemove(engine->active_first, engine->active_last, request);
+        engine->active_count.fetch_sub(1, std::memory_order_relaxed);
+        _http_engine_request_complete(engine, request, result);
+    }
+}
+
+static void
+_http_engine_request_complete(HttpEngine* engine, HttpEngineRequest* request, CURLcode result)
+{
+    request->result = result;
+    engine->completed_count.fetch_add(1, std::memory_order_relaxed);
+    // ~mgj: the request belongs to its owner again once the completion is pushed
+    WorkerItem completion = request->completion;
+    if (!thread_pool_push(request->thread_pool, &completion))
+    {
+        ERROR_LOG("http engine: completion dropped, the thread pool does not take work anymore");
+    }
+}
+
+} // namespace async
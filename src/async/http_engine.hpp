@@ -0,0 +1,88 @@
+#pragma once
+
+namespace async
+{
+
+// ~mgj: One I/O thread that owns a single curl multi handle and runs every HTTP transfer of the process.
+// Requests are submitted from any thread with a configured easy handle; the I/O thread adds them to the
+// multi handle, sleeps in curl_multi_poll while nothing happens and pushes the request's completion item
+// to its thread pool when the transfer has finished. Because all transfers share the multi handle they
+// share its connection cache and DNS cache, connections are reused across requests to the same host and
+// HTTP/2 streams to a host are multiplexed over one connection. Transfers beyond max_host_connections
+// wait inside curl until a connection to that host frees up.
+const U32 HTTP_ENGINE_MAX_HOST_CONNECTIONS_DEFAULT = 6;
+const U32 HTTP_ENGINE_DNS_CACHE_TIMEOUT_SEC_DEFAULT = 300;
+const U32 HTTP_ENGINE_SUBMIT_QUEUE_SIZE = 256;
+// upper bound for curl_multi_poll, submissions and shutdown wake it up earlier
+const U32 HTTP_ENGINE_POLL_TIMEOUT_MS = 1000;
+
+struct HttpEngineConfig
+{
+    U32 max_host_connections;  // 0 is HTTP_ENGINE_MAX_HOST_CONNECTIONS_DEFAULT
+    U32 max_total_connections; // 0 is unlimited
+    U32 dns_cache_timeout_sec; // 0 is HTTP_ENGINE_DNS_CACHE_TIMEOUT_SEC_DEFAULT
+};
+
+struct HttpEngineRequest
+{
+    HttpEngineRequest* next;
+    HttpEngineRequest* prev;
+
+    // set by the submitter, owned by the engine until completion is pushed
+    CURL* session_handle;
+    ThreadPool* thread_pool;
+    WorkerItem completion;
+
+    // written by the I/O thread before completion is pushed
+    CURLcode result;
+    U32 http_code;
+};
+
+struct HttpEngine
+{
+    Arena* arena;
+    HttpEngineConfig config;
+    CURLM* multi_handle;
+    Queue<HttpEngineRequest*>* submit_queue;
+    OS_Handle thread_handle;
+    std::atomic<B32> kill_switch;
+
+    // I/O thread only
+    HttpEngineRequest* active_first;
+    HttpEngineRequest* active_last;
+
+    // written by the I/O thread, read by anyone
+    std::atomic<U32> active_count;
+    std::atomic<U64> completed_count;
+    std::atomic<U64> connect_count; // transfers that had to open a new connection
+};
+
+static HttpEngine*
+http_engine_create(HttpEngineConfig* config);
+// ~mgj: Stops the I/O thread. Transfers still queued or running complete with CURLE_ABORTED_BY_CALLBACK,
+// so call this before their thread pools are destroyed.
+static void
+http_engine_destroy(HttpEngine* engine);
+// ~mgj: Runs request->session_handle and pushes request->completion to request->thread_pool once it is
+// done. Returns false when the engine is shutting down, the request is untouched then.
+static B32
+http_engine_submit(HttpEngine* engine, HttpEngineRequest* request);
+
+// ~mgj: engine used by async_http and co_http_request, set it up after the thread pool and clear it
+// before destroying either
+static void
+http_engine_global_set(HttpEngine* engine);
+static HttpEngine*
+http_engine_global_get();
+
+// ~mgj: internal
+static void
+_http_engine_thread(void* data);
+static void
+_http_engine_submit_drain(HttpEngine* engine);
+static void
+_http_engine_completions_post(HttpEngine* engine);
+static void
+_http_engine_request_complete(HttpEngine* engine, HttpEngineRequest* request, CURLcode result);
+
+} // namespace async
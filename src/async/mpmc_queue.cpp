@@ -2,103 +2,210 @@
 namespace async
 {
 
+template <typename T>
+static Queue<T>*
+queue_alloc(Arena* arena, U32 capacity, QueueFullPolicy full_policy)
+{
+    Queue<T>* queue = PushStruct(arena, Queue<T>);
+    queue->ring = mpmc_ring_alloc<T>(arena, ClampBot(capacity, 1));
+    queue->full_policy = full_policy;
+    queue->is_closed.store(false);
+    queue->blocked_count.store(0);
+    queue->spill_count.store(0);
+    if (full_policy == QueueFullPolicy_Block)
+    {
+        queue->block_mutex = OS_MutexAlloc();
+        queue->block_cv = os_condition_variable_alloc();
+    }
+    else if (full_policy == QueueFullPolicy_Spill)
+    {
+        queue->spill_mutex = OS_MutexAlloc();
+    }
+    return queue;
+}
+
 template <typename T>
 static void
-_queue_grow(Queue<T>* queue, U32 min_queue_size)
+queue_release(Queue<T>* queue)
 {
-    AssertAlways(queue);
+    if (queue->full_policy == QueueFullPolicy_Block)
+    {
+        os_condition_variable_release(queue->block_cv);
+        OS_MutexRelease(queue->block_mutex);
+    }
+    else if (queue->full_policy == QueueFullPolicy_Spill)
+    {
+        OS_MutexRelease(queue->spill_mutex);
+        if (queue->spill_arena)
+        {
+            arena_release(queue->spill_arena);
+        }
+    }
+}
+
+template <typename T>
+static B32
+queue_try_push(Queue<T>* queue, T* data)
+{
+    if (queue->is_closed.load(std::memory_order_relaxed))
+    {
+        return false;
+    }
+    return mpmc_ring_try_push(queue->ring, data);
+}
 
-    U32 new_queue_size = ClampBot(queue->queue_size * 2, min_queue_size);
-    T* new_items = PushArray(queue->arena, T, new_queue_size);
+template <typename T>
+static B32
+queue_push(Queue<T>* queue, T* data)
+{
+    if (queue_try_push(queue, data))
+    {
+        return true;
+    }
+    if (queue->is_closed.load(std::memory_order_relaxed))
+    {
+        return false;
+    }
 
-    for (U32 item_index = 0; item_index < queue->items_in_queue_count; item_index++)
+    switch (queue->full_policy)
     {
-        U32 source_index = (queue->next_index + item_index) % queue->queue_size;
-        new_items[item_index] = queue->items[source_index];
+        case QueueFullPolicy_Fail:
+            return false;
+        case QueueFullPolicy_Block:
+            return _queue_push_blocking(queue, data);
+        case QueueFullPolicy_Spill:
+            _queue_spill(queue, data);
+            return true;
     }
+    return false;
+}
 
-    queue->items = new_items;
-    queue->queue_size = new_queue_size;
-    queue->next_index = 0;
-    queue->fill_index = queue->items_in_queue_count;
+template <typename T>
+static B32
+queue_try_read(Queue<T>* queue, T* item)
+{
+    if (mpmc_ring_try_pop(queue->ring, item))
+    {
+        _queue_producer_wake(queue);
+        return true;
+    }
+    return queue->spill_count.load(std::memory_order_acquire) > 0 && _queue_unspill(queue, item);
 }
 
 template <typename T>
 static void
-_queue_insert_value(Queue<T>* queue, T* data)
+queue_close(Queue<T>* queue)
 {
-    U32 fill_index = queue->fill_index;
-    queue->fill_index = (fill_index + 1) % queue->queue_size;
-    queue->items[fill_index] = *data;
-    queue->items_in_queue_count++;
+    queue->is_closed.store(true);
+    if (queue->full_policy == QueueFullPolicy_Block)
+    {
+        os_mutex_scope(queue->block_mutex)
+        {
+            os_condition_variable_broadcast(queue->block_cv);
+        }
+    }
 }
 
 template <typename T>
-static Queue<T>*
-queue_alloc(Arena* arena, U32 queue_size)
+static U64
+queue_count(Queue<T>* queue)
 {
-    Queue<T>* queue = PushStruct(arena, Queue<T>);
-    queue->queue_size = ClampBot(queue_size, 1);
-    queue->arena = arena;
-    queue->items = PushArray(arena, T, queue->queue_size);
-    queue->mutex = os_rw_mutex_alloc();
-    return queue;
+    return mpmc_ring_count(queue->ring) + queue->spill_count.load(std::memory_order_relaxed);
 }
 
 template <typename T>
-static void
-queue_release(Queue<T>* queue)
+static B32
+_queue_push_blocking(Queue<T>* queue, T* data)
 {
-    os_rw_mutex_release(queue->mutex);
+    B32 result = false;
+    queue->blocked_count.fetch_add(1);
+    os_mutex_take(queue->block_mutex);
+    for (;;)
+    {
+        // ~mgj: pairs with the fence in _queue_producer_wake: either the consumer sees us blocked and
+        // signals under the mutex, or we see the slot it freed
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (queue->is_closed.load(std::memory_order_relaxed))
+        {
+            break;
+        }
+        if (mpmc_ring_try_push(queue->ring, data))
+        {
+            result = true;
+            break;
+        }
+        if (mpmc_ring_count(queue->ring) > queue->ring->mask)
+        {
+            os_condition_variable_wait(queue->block_cv, queue->block_mutex, max_U64);
+        }
+    }
+    os_mutex_drop(queue->block_mutex);
+    queue->blocked_count.fetch_sub(1);
+    return result;
 }
 
 template <typename T>
 static void
-queue_push(Queue<T>* queue, T* data)
+_queue_producer_wake(Queue<T>* queue)
 {
-    os_mutex_scope_w(queue->mutex)
+    if (queue->full_policy != QueueFullPolicy_Block)
     {
-        if (queue->items_in_queue_count >= queue->queue_size)
+        return;
+    }
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (queue->blocked_count.load(std::memory_order_relaxed) > 0)
+    {
+        os_mutex_scope(queue->block_mutex)
         {
-            _queue_grow(queue, queue->queue_size + 1);
+            os_condition_variable_signal(queue->block_cv);
         }
-
-        _queue_insert_value(queue, data);
     }
 }
 
 template <typename T>
-static B32
-queue_try_push(Queue<T>* queue, T* data)
+static void
+_queue_spill(Queue<T>* queue, T* data)
 {
-    B32 inserted = false;
-    os_mutex_scope_w(queue->mutex)
+    os_mutex_scope(queue->spill_mutex)
     {
-        if (queue->items_in_queue_count < queue->queue_size)
+        QueueSpillNode<T>* node = queue->spill_free;
+        if (node)
+        {
+            SLLStackPop(queue->spill_free);
+        }
+        else
         {
-            _queue_insert_value(queue, data);
-            inserted = true;
+            if (!queue->spill_arena)
+            {
+                queue->spill_arena = arena_alloc();
+                Debug_SetName(queue->spill_arena, "queue spill arena");
+            }
+            node = PushStructNoZero(queue->spill_arena, QueueSpillNode<T>);
         }
+        node->next = 0;
+        node->value = *data;
+        SLLQueuePush(queue->spill_first, queue->spill_last, node);
+        queue->spill_count.fetch_add(1, std::memory_order_release);
     }
-    return inserted;
 }
 
 template <typename T>
 static B32
-queue_try_read(Queue<T>* queue, T* item)
+_queue_unspill(Queue<T>* queue, T* item)
 {
-    B32 has_read = 0;
-    os_mutex_scope_w(queue->mutex)
+    B32 result = false;
+    os_mutex_scope(queue->spill_mutex)
     {
-        if (queue->items_in_queue_count > 0)
+        QueueSpillNode<T>* node = queue->spill_first;
+        if (node)
         {
-            U32 cur_index = queue->next_index;
-            queue->next_index = (cur_index + 1) % queue->queue_size;
-            *item = queue->items[cur_index];
-            queue->items_in_queue_count--;
-            has_read = 1;
+            SLLQueuePop(queue->spill_first, queue->spill_last);
+            *item = node->value;
+            SLLStackPush(queue->spill_free, node);
+            queue->spill_count.fetch_sub(1, std::memory_order_relaxed);
+            result = true;
         }
     }
-    return has_read;
+    return result;
 }
 } // namespace async
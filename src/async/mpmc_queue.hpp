@@ -1,38 +1,86 @@
 #pragma once
 namespace async
 {
+// ~mgj: Bounded lock-free MPMC queue: an MpmcRing plus a policy for pushes that find it full.
+//   Fail   queue_push returns false
+//   Block  queue_push waits until a consumer makes room or the queue is closed
+//   Spill  queue_push moves the item to a mutex guarded overflow list that consumers drain after the ring
+// The fast paths never take a lock. Blocked producers and the overflow list are only touched when the
+// ring is full, consumers check for them with one atomic load. Spilled items can be read after items
+// pushed into the ring later, order is only FIFO while nothing spills.
+enum QueueFullPolicy
+{
+    QueueFullPolicy_Fail,
+    QueueFullPolicy_Block,
+    QueueFullPolicy_Spill,
+};
+
+template <typename T>
+struct QueueSpillNode
+{
+    QueueSpillNode<T>* next;
+    T value;
+};
+
 template <typename T>
 struct Queue
 {
-    volatile U32 next_index;
-    volatile U32 fill_index;
-    U32 items_in_queue_count;
-    U32 queue_size;
-    Arena* arena;
-    T* items;
-    OS_Handle mutex;
+    MpmcRing<T>* ring;
+    QueueFullPolicy full_policy;
+    std::atomic<B32> is_closed;
+
+    // Block
+    alignas(MPMC_RING_CACHE_LINE_SIZE) std::atomic<U32> blocked_count;
+    OS_Handle block_mutex;
+    OS_Handle block_cv;
+
+    // Spill: nodes come from spill_arena and are recycled through spill_free
+    alignas(MPMC_RING_CACHE_LINE_SIZE) std::atomic<U64> spill_count;
+    OS_Handle spill_mutex;
+    Arena* spill_arena;
+    QueueSpillNode<T>* spill_first;
+    QueueSpillNode<T>* spill_last;
+    QueueSpillNode<T>* spill_free;
 };
 
 ////////////////////////////////////////////////
-template <typename T>
-static void
-_queue_grow(Queue<T>* queue, U32 min_queue_size);
-template <typename T>
-static void
-_queue_insert_value(Queue<T>* queue, T* data);
+// ~mgj: capacity is rounded up to a power of two
 template <typename T>
 static Queue<T>*
-queue_alloc(Arena* arena, U32 queue_size);
+queue_alloc(Arena* arena, U32 capacity, QueueFullPolicy full_policy);
 template <typename T>
 static void
 queue_release(Queue<T>* queue);
 template <typename T>
 static B32
 queue_try_read(Queue<T>* queue, T* item);
+// ~mgj: never blocks or spills, false when the ring is full or the queue is closed
 template <typename T>
 static B32
 queue_try_push(Queue<T>* queue, T* data);
+// ~mgj: applies the full policy, false when the item was not queued
 template <typename T>
-static void
+static B32
 queue_push(Queue<T>* queue, T* data);
+// ~mgj: pushes fail from now on and blocked producers return false, reads keep draining what is queued
+template <typename T>
+static void
+queue_close(Queue<T>* queue);
+// ~mgj: a snapshot that may be stale by the time it returns
+template <typename T>
+static U64
+queue_count(Queue<T>* queue);
+
+template <typename T>
+static B32
+_queue_push_blocking(Queue<T>* queue, T* data);
+template <typename T>
+static void
+_queue_spill(Queue<T>* queue, T* data);
+template <typename T>
+static B32
+_queue_unspill(Queue<T>* queue, T* item);
+template <typename T>
+static void
+_queue_producer_wake(Queue<T>* queue);
 } // namespace async
@@ -0,0 +1,95 @@
+namespace async
+{
+
+template <typename T>
+static MpmcRing<T>*
+mpmc_ring_alloc(Arena* arena, U64 capacity)
+{
+    U64 ring_capacity = 2;
+    while (ring_capacity < capacity)
+    {
+        ring_capacity *= 2;
+    }
+
+    MpmcRing<T>* ring = PushStruct(arena, MpmcRing<T>);
+    ring->mask = ring_capacity - 1;
+    ring->cells = PushArray(arena, MpmcRingCell<T>, ring_capacity);
+    for (U64 i = 0; i < ring_capacity; ++i)
+    {
+        ring->cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    ring->enqueue_pos.store(0, std::memory_order_relaxed);
+    ring->dequeue_pos.store(0, std::memory_order_relaxed);
+    return ring;
+}
+
+template <typename T>
+static B32
+mpmc_ring_try_push(MpmcRing<T>* ring, T* item)
+{
+    U64 pos = ring->enqueue_pos.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        MpmcRingCell<T>* cell = &ring->cells[pos & ring->mask];
+        U64 sequence = cell->sequence.load(std::memory_order_acquire);
+        S64 diff = (S64)sequence - (S64)pos;
+        if (diff == 0)
+        {
+            if (ring->enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                cell->value = *item;
+                cell->sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (diff < 0)
+        {
+            // ~mgj: the cell still holds the item from one lap ago
+            return false;
+        }
+        else
+        {
+            pos = ring->enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+template <typename T>
+static B32
+mpmc_ring_try_pop(MpmcRing<T>* ring, T* item)
+{
+    U64 pos = ring->dequeue_pos.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        MpmcRingCell<T>* cell = &ring->cells[pos & ring->mask];
+        U64 sequence = cell->sequence.load(std::memory_order_acquire);
+        S64 diff = (S64)sequence - (S64)(pos + 1);
+        if (diff == 0)
+        {
+            if (ring->dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                *item = cell->value;
+                cell->sequence.store(pos + ring->mask + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (diff < 0)
+        {
+            return false;
+        }
+        else
+        {
+            pos = ring->dequeue_pos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+template <typename T>
+static U64
+mpmc_ring_count(MpmcRing<T>* ring)
+{
+    U64 dequeue_pos = ring->dequeue_pos.load(std::memory_order_acquire);
+    U64 enqueue_pos = ring->enqueue_pos.load(std::memory_order_acquire);
+    return enqueue_pos > dequeue_pos ? enqueue_pos - dequeue_pos : 0;
+}
+} // namespace async
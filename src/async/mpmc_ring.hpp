@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+
+namespace async
+{
+
+// ~mgj: Bounded lock-free multi-producer multi-consumer ring after Dmitry Vyukov. Every cell carries a
+// sequence number: a producer may fill cell i when its sequence equals the enqueue position, a consumer
+// may take it when the sequence equals the dequeue position + 1. Producers and consumers only contend on
+// their own position counter, each on its own cache line.
+static constexpr U64 MPMC_RING_CACHE_LINE_SIZE = 64;
+
+template <typename T> struct MpmcRingCell
+{
+    std::atomic<U64> sequence;
+    T value;
+};
+
+template <typename T> struct MpmcRing
+{
+    U64 mask; // capacity - 1, the capacity is a power of two
+    MpmcRingCell<T>* cells;
+    alignas(MPMC_RING_CACHE_LINE_SIZE) std::atomic<U64> enqueue_pos;
+    alignas(MPMC_RING_CACHE_LINE_SIZE) std::atomic<U64> dequeue_pos;
+};
+
+// ~mgj: capacity is rounded up to a power of two
+template <typename T>
+static MpmcRing<T>*
+mpmc_ring_alloc(Arena* arena, U64 capacity);
+// ~mgj: false when the ring is full
+template <typename T>
+static B32
+mpmc_ring_try_push(MpmcRing<T>* ring, T* item);
+// ~mgj: false when the ring is empty
+template <typename T>
+static B32
+mpmc_ring_try_pop(MpmcRing<T>* ring, T* item);
+// ~mgj: a snapshot that may be stale by the time it returns
+template <typename T>
+static U64
+mpmc_ring_count(MpmcRing<T>* ring);
+
+} // namespace async
@@ -0,0 +1,194 @@
+namespace async
+{
+
+static void
+_parallel_range_init(_ParallelRange* range, ThreadPool* thread_pool, U64 count, U64 grain)
+{
+    U64 max_participant_count = thread_pool ? (U64)thread_pool->thread_count + 1 : 1;
+    if (grain == 0)
+    {
+        grain = Max(count / (max_participant_count * PARALLEL_AUTO_CHUNKS_PER_PARTICIPANT), 1ull);
+    }
+    range->count = count;
+    range->grain = grain;
+    range->participant_count = (U32)Min(max_participant_count, (count + grain - 1) / grain);
+    range->cursor.store(0, std::memory_order_relaxed);
+}
+
+static B32
+_parallel_range_claim(_ParallelRange* range, U64* start_idx, U64* end_idx)
+{
+    U64 cur = range->cursor.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        if (cur >= range->count)
+        {
+            return false;
+        }
+        U64 remaining = range->count - cur;
+        U64 chunk_size = Max(range->grain, remaining / (PARALLEL_GUIDED_DIVISOR * (U64)range->participant_count));
+        U64 next = cur + Min(chunk_size, remaining);
+        if (range->cursor.compare_exchange_weak(cur, next, std::memory_order_relaxed))
+        {
+            *start_idx = cur;
+            *end_idx = next;
+            return true;
+        }
+    }
+}
+
+static void
+_parallel_job_release(_ParallelJob* job)
+{
+    if (job->ref_count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        free(job);
+    }
+}
+
+static WorkerResult
+_parallel_helper_task(ThreadInfo thread_info, WorkerData data)
+{
+    _ParallelJob* job = (_ParallelJob*)data;
+    U32 state = job->state.fetch_add(1, std::memory_order_acquire);
+    if (!(state & PARALLEL_JOB_CLOSED))
+    {
+        U32 participant_idx = job->participant_cursor.fetch_add(1, std::memory_order_relaxed);
+        job->participant_func(thread_info, job->participant_data, participant_idx);
+    }
+    job->state.fetch_sub(1, std::memory_order_release);
+    _parallel_job_release(job);
+    return {};
+}
+
+static void
+_parallel_run(ThreadPool* thread_pool, U32 participant_count, ForkJoinFunc func, void* data)
+{
+    _ParallelJob* job = (_ParallelJob*)malloc(sizeof(_ParallelJob));
+    AssertAlways(job);
+    job->participant_func = func;
+    job->participant_data = data;
+    job->ref_count.store(participant_count, std::memory_order_relaxed);
+    job->state.store(1, std::memory_order_relaxed);
+    job->participant_cursor.store(1, std::memory_order_relaxed);
+    for (U32 i = 1; i < participant_count; ++i)
+    {
+        WorkerItem item = WorkerItem(job, _parallel_helper_task);
+        if (!thread_pool_push(thread_pool, &item))
+        {
+            // ~mgj: the caller covers the range on its own if need be
+            _parallel_job_release(job);
+        }
+    }
+
+    ThreadInfo thread_info = {.thread_pool = thread_pool, .thread_id = t_cur_thread_id};
+    func(thread_info, data, 0);
+
+    // ~mgj: the cursor is used up, helpers from here on exit without a chunk. Only the ones already in one
+    // are waited for.
+    job->state.fetch_or(PARALLEL_JOB_CLOSED, std::memory_order_acq_rel);
+    job->state.fetch_sub(1, std::memory_order_acq_rel);
+    U32 idle_spin_count = 0;
+    while ((job->state.load(std::memory_order_acquire) & ~PARALLEL_JOB_CLOSED) > 0)
+    {
+        if (idle_spin_count++ < 64)
+        {
+            _mm_pause();
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+    _parallel_job_release(job);
+}
+
+static void
+_parallel_for_task(ThreadInfo thread_info, void* data, U32 task_idx)
+{
+    (void)task_idx;
+    prof_scope_marker;
+    _ParallelFor* parallel = (_ParallelFor*)data;
+    U64 start_idx = 0;
+    U64 end_idx = 0;
+    while (_parallel_range_claim(&parallel->range, &start_idx, &end_idx))
+    {
+        ScratchScope scratch = ScratchScope(0, 0);
+        parallel->func(thread_info, scratch.arena, parallel->data, start_idx, end_idx);
+    }
+}
+
+static void
+parallel_for(ThreadPool* thread_pool, U64 count, U64 grain, ParallelForFunc func, void* data)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    _ParallelFor parallel = {.func = func, .data = data};
+    _parallel_range_init(&parallel.range, thread_pool, count, grain);
+    if (parallel.range.participant_count <= 1)
+    {
+        ThreadInfo thread_info = {.thread_pool = thread_pool, .thread_id = t_cur_thread_id};
+        ScratchScope scratch = ScratchScope(0, 0);
+        func(thread_info, scratch.arena, data, 0, count);
+        return;
+    }
+    _parallel_run(thread_pool, parallel.range.participant_count, _parallel_for_task, &parallel);
+}
+
+template <typename T>
+static void
+_parallel_reduce_task(ThreadInfo thread_info, void* data, U32 task_idx)
+{
+    prof_scope_marker;
+    _ParallelReduce<T>* parallel = (_ParallelReduce<T>*)data;
+    T acc = parallel->identity;
+    U64 start_idx = 0;
+    U64 end_idx = 0;
+    while (_parallel_range_claim(&parallel->range, &start_idx, &end_idx))
+    {
+        ScratchScope scratch = ScratchScope(0, 0);
+        acc = parallel->func(thread_info, scratch.arena, parallel->data, start_idx, end_idx, acc);
+    }
+    parallel->partials[task_idx] = acc;
+}
+
+template <typename T>
+static T
+parallel_reduce(ThreadPool* thread_pool, U64 count, U64 grain, T identity, ParallelReduceFunc<T> func, ParallelCombineFunc<T> combine, void* data)
+{
+    if (count == 0)
+    {
+        return identity;
+    }
+
+    _ParallelReduce<T> parallel = {.func = func, .data = data, .identity = identity};
+    _parallel_range_init(&parallel.range, thread_pool, count, grain);
+    if (parallel.range.participant_count <= 1)
+    {
+        ThreadInfo thread_info = {.thread_pool = thread_pool, .thread_id = t_cur_thread_id};
+        ScratchScope scratch = ScratchScope(0, 0);
+        return func(thread_info, scratch.arena, data, 0, count, identity);
+    }
+
+    // ~mgj: the partials live on the caller's scratch, the chunks only pop their own scratch allocations.
+    // Participants whose helper never started keep the identity.
+    ScratchScope scratch = ScratchScope(0, 0);
+    parallel.partials = PushArrayNoZero(scratch.arena, T, parallel.range.participant_count);
+    for (U32 i = 0; i < parallel.range.participant_count; ++i)
+    {
+        parallel.partials[i] = identity;
+    }
+    _parallel_run(thread_pool, parallel.range.participant_count, _parallel_reduce_task<T>, &parallel);
+
+    T result = parallel.partials[0];
+    for (U32 i = 1; i < parallel.range.participant_count; ++i)
+    {
+        result = combine(result, parallel.partials[i]);
+    }
+    return result;
+}
+
+} // namespace async
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+
+namespace async
+{
+
+// ~mgj: Data parallel loops on the thread pool. [0, count) is handed out in chunks from a shared cursor:
+// every claim takes max(grain, remaining / (PARALLEL_GUIDED_DIVISOR * participants)) items, so the first
+// chunks are large and the tail is split finely enough to even out uneven items. grain 0 picks the grain
+// from count and the pool size.
+//
+// The calling thread is one of the participants and the others are helper tasks pushed to the pool. Once
+// the cursor is used up the caller only waits for the helpers still running a chunk, helpers that have not
+// started by then exit without touching the loop. So a loop on the main thread never waits behind the
+// long tasks the workers are busy with, or on workers blocked on the main thread queue.
+//
+// Every chunk gets the thread context scratch arena of the thread it runs on, reset after the chunk.
+// Output must not be allocated from it.
+static constexpr U32 PARALLEL_GUIDED_DIVISOR = 2;
+// ~mgj: with grain 0 there are at least this many chunks per participant
+static constexpr U32 PARALLEL_AUTO_CHUNKS_PER_PARTICIPANT = 16;
+static constexpr U64 PARALLEL_CACHE_LINE_SIZE = 64;
+// ~mgj: set in _ParallelJob::state when the caller has left, the low bits count the running participants
+static constexpr U32 PARALLEL_JOB_CLOSED = 1u << 31;
+
+typedef void (*ParallelForFunc)(ThreadInfo thread_info, Arena* scratch_arena, void* data, U64 start_idx, U64 end_idx);
+// ~mgj: folds [start_idx, end_idx) into acc and returns it
+template <typename T>
+using ParallelReduceFunc = T (*)(ThreadInfo thread_info, Arena* scratch_arena, void* data, U64 start_idx, U64 end_idx, T acc);
+// ~mgj: must be associative and commutative, chunks are not folded in index order
+template <typename T>
+using ParallelCombineFunc = T (*)(T a, T b);
+
+struct _ParallelRange
+{
+    U64 count;
+    U64 grain;
+    U32 participant_count;
+    alignas(PARALLEL_CACHE_LINE_SIZE) std::atomic<U64> cursor;
+};
+
+// ~mgj: shared by the caller and its helper tasks, heap allocated and freed by the last one to let go,
+// so helpers that start after the caller has returned still find it
+struct _ParallelJob
+{
+    ForkJoinFunc participant_func;
+    void* participant_data;
+    std::atomic<U32> ref_count;          // the caller and every queued helper
+    std::atomic<U32> state;              // running participants | PARALLEL_JOB_CLOSED
+    std::atomic<U32> participant_cursor; // hands out the participant indices, the caller is 0
+};
+
+struct _ParallelFor
+{
+    _ParallelRange range;
+    ParallelForFunc func;
+    void* data;
+};
+
+template <typename T> struct _ParallelReduce
+{
+    _ParallelRange range;
+    ParallelReduceFunc<T> func;
+    void* data;
+    T identity;
+    T* partials; // one per participant
+};
+
+// ~mgj: Parallel functions /////////////////////////////
+// ~mgj: calls func on disjoint chunks covering [0, count) and returns when all have finished. Runs inline
+// when thread_pool is 0 or there is only one chunk.
+static void
+parallel_for(ThreadPool* thread_pool, U64 count, U64 grain, ParallelForFunc func, void* data);
+template <typename T>
+static T
+parallel_reduce(ThreadPool* thread_pool, U64 count, U64 grain, T identity, ParallelReduceFunc<T> func, ParallelCombineFunc<T> combine, void* data);
+
+// ~mgj: internal
+static void
+_parallel_range_init(_ParallelRange* range, ThreadPool* thread_pool, U64 count, U64 grain);
+static B32
+_parallel_range_claim(_ParallelRange* range, U64* start_idx, U64* end_idx);
+// ~mgj: runs func(participant_idx) on the caller as participant 0 and on up to participant_count - 1 helpers
+static void
+_parallel_run(ThreadPool* thread_pool, U32 participant_count, ForkJoinFunc func, void* data);
+static WorkerResult
+_parallel_helper_task(ThreadInfo thread_info, WorkerData data);
+static void
+_parallel_job_release(_ParallelJob* job);
+static void
+_parallel_for_task(ThreadInfo thread_info, void* data, U32 task_idx);
+template <typename T>
+static void
+_parallel_reduce_task(ThreadInfo thread_info, void* data, U32 task_idx);
+////////////////////////////////////////////////
+
+} // namespace async
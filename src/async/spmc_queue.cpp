@@ -2,10 +2,27 @@ namespace async
 {
 
 template <typename T>
-static U64
-_spmc_queue_capacity(SpmcQueue<T>* queue)
+static SpmcRing<T>*
+_spmc_queue_ring_alloc(Arena* arena, U64 capacity)
 {
-    return segment_buffer_capacity(&queue->buffer);
+    Assert(IsPow2(capacity));
+    SpmcRing<T>* ring = PushStruct(arena, SpmcRing<T>);
+    ring->mask = capacity - 1;
+    ring->items = PushArrayNoZero(arena, T, capacity);
+    return ring;
+}
+
+template <typename T>
+static SpmcRing<T>*
+_spmc_queue_grow(SpmcQueue<T>* queue, SpmcRing<T>* ring, U64 top, U64 bottom)
+{
+    SpmcRing<T>* new_ring = _spmc_queue_ring_alloc<T>(queue->arena, (ring->mask + 1) * 2);
+    for (U64 i = top; i < bottom; ++i)
+    {
+        new_ring->items[i & new_ring->mask] = ring->items[i & ring->mask];
+    }
+    queue->ring.store(new_ring, std::memory_order_release);
+    return new_ring;
 }
 
 template <typename T>
@@ -18,12 +35,12 @@ spmc_queue_create(Arena* arena, U64 capacity)
     queue->arena = arena;
     queue->top.store(0, std::memory_order_relaxed);
     queue->bottom.store(0, std::memory_order_relaxed);
-    queue->buffer.segment_count.store(0, std::memory_order_relaxed);
-    for (U64 segment_index = 0; segment_index < SPMC_QUEUE_MAX_SEGMENT_COUNT; segment_index++)
+    U64 ring_capacity = SPMC_QUEUE_MIN_CAPACITY;
+    while (ring_capacity < capacity)
     {
-        queue->buffer.segments[segment_index].store(0, std::memory_order_relaxed);
+        ring_capacity *= 2;
     }
-    _spmc_queue_reserve(queue, capacity);
+    queue->ring.store(_spmc_queue_ring_alloc<T>(arena, ring_capacity), std::memory_order_relaxed);
     return queue;
 }
 
@@ -42,9 +59,13 @@ B32
 spmc_queue_push(SpmcQueue<T>* queue, const T& value)
 {
     U64 bottom = queue->bottom.load(std::memory_order_relaxed);
-    U64 segment_index = segment_buffer_segment_index<T>(bottom);
-    _spmc_queue_buffer_ensure_segment(queue, segment_index);
-    spmc_queue_slot_get(&queue->buffer, bottom) = value;
+    U64 top = queue->top.load(std::memory_order_acquire);
+    SpmcRing<T>* ring = queue->ring.load(std::memory_order_relaxed);
+    if (bottom - top > ring->mask)
+    {
+        ring = _spmc_queue_grow(queue, ring, top, bottom);
+    }
+    ring->items[bottom & ring->mask] = value;
     std::atomic_thread_fence(std::memory_order_release);
     queue->bottom.store(bottom + 1, std::memory_order_relaxed);
     return true;
@@ -61,6 +82,7 @@ spmc_queue_pop(SpmcQueue<T>* queue, T& value)
     }
 
     bottom -= 1;
+    SpmcRing<T>* ring = queue->ring.load(std::memory_order_relaxed);
     queue->bottom.store(bottom, std::memory_order_relaxed);
     std::atomic_thread_fence(std::memory_order_seq_cst);
 
@@ -71,18 +93,18 @@ spmc_queue_pop(SpmcQueue<T>* queue, T& value)
         return false;
     }
 
-    T popped_value = spmc_queue_slot_get(&queue->buffer, bottom);
+    T popped_value = ring->items[bottom & ring->mask];
 
     if (top == bottom)
     {
+        // ~mgj: last item, race the stealers for it
         U64 expected_top = top;
-        if (!queue->top.compare_exchange_strong(expected_top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        B32 won = queue->top.compare_exchange_strong(expected_top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        queue->bottom.store(bottom + 1, std::memory_order_relaxed);
+        if (!won)
         {
-            queue->bottom.store(bottom + 1, std::memory_order_relaxed);
             return false;
         }
-
-        queue->bottom.store(bottom + 1, std::memory_order_relaxed);
     }
 
     value = popped_value;
@@ -101,7 +123,8 @@ spmc_queue_steal(SpmcQueue<T>* queue, T& value)
         return false;
     }
 
-    T stolen_value = spmc_queue_slot_get<T>(&queue->buffer, top);
+    SpmcRing<T>* ring = queue->ring.load(std::memory_order_acquire);
+    T stolen_value = ring->items[top & ring->mask];
     if (!queue->top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
     {
         return false;
@@ -111,53 +134,12 @@ spmc_queue_steal(SpmcQueue<T>* queue, T& value)
     return true;
 }
 
-template <typename T>
-static void
-_spmc_queue_buffer_ensure_segment(SpmcQueue<T>* queue, U64 segment_index)
-{
-    Assert(segment_index < SPMC_QUEUE_MAX_SEGMENT_COUNT);
-
-    U64 segment_count = queue->buffer.segment_count.load(std::memory_order_acquire);
-    while (segment_count <= segment_index)
-    {
-        U64 next_segment = segment_count;
-        T* segment = PushArray(queue->arena, T, segment_buffer_capacity<T>(next_segment));
-        queue->buffer.segments[next_segment].store(segment, std::memory_order_release);
-        segment_count = next_segment + 1;
-        queue->buffer.segment_count.store(segment_count, std::memory_order_release);
-    }
-}
-
-template <typename T>
-static void
-_spmc_queue_reserve(SpmcQueue<T>* queue, U64 capacity)
-{
-    U64 segment_count = 1;
-    while (segment_buffer_capacity_from_segment_count<T>(segment_count) < capacity)
-    {
-        segment_count++;
-        Assert(segment_count <= SPMC_QUEUE_MAX_SEGMENT_COUNT);
-    }
-
-    _spmc_queue_buffer_ensure_segment(queue, segment_count - 1);
-}
-
 template <typename T>
 static U64
-spmc_queue_capacity(AsyncSpmcFifoQueue<T>* buffer)
-{
-    U64 segment_count = buffer->segment_count.load(std::memory_order_acquire);
-    return segment_buffer_capacity_from_segment_count<T>(segment_count);
-}
-
-template <typename T>
-static T&
-spmc_queue_slot_get(AsyncSpmcFifoQueue<T>* buffer, U64 index)
+spmc_queue_count(SpmcQueue<T>* queue)
 {
-    U64 segment_index = segment_buffer_segment_index<T>(index);
-    U64 segment_offset = index - segment_buffer_capacity_from_segment_count<T>(segment_index);
-    T* segment = buffer->segments[segment_index].load(std::memory_order_acquire);
-    Assert(segment);
-    return segment[segment_offset];
+    U64 top = queue->top.load(std::memory_order_acquire);
+    U64 bottom = queue->bottom.load(std::memory_order_acquire);
+    return bottom > top ? bottom - top : 0;
 }
 } // namespace async
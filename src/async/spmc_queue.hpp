@@ -5,26 +5,36 @@
 namespace async
 {
 
-static constexpr U64 SPMC_QUEUE_SEGMENT_SHIFT = 6;
-static constexpr U64 SPMC_QUEUE_MAX_SEGMENT_COUNT = 26;
-template <typename T> struct AsyncSpmcFifoQueue
+// ~mgj: Chase-Lev work-stealing deque. The owner thread pushes and pops at the bottom (LIFO), any
+// thread steals from the top (FIFO). top and bottom only ever grow and index the ring modulo its
+// capacity. When the owner runs out of room it copies the live range into a ring twice the size;
+// old rings stay valid in the queue arena because a stealer may still be reading from one.
+static constexpr U64 SPMC_QUEUE_MIN_CAPACITY = 64;
+static constexpr U64 SPMC_QUEUE_CACHE_LINE_SIZE = 64;
+
+template <typename T> struct SpmcRing
 {
-    std::atomic<U64> segment_count;
-    std::atomic<T*> segments[SPMC_QUEUE_MAX_SEGMENT_COUNT];
+    U64 mask; // capacity - 1, the capacity is a power of two
+    T* items;
 };
 
 template <typename T> struct SpmcQueue
 {
-    Arena* arena;
-    std::atomic<U64> top;
-    std::atomic<U64> bottom;
-    AsyncSpmcFifoQueue<T> buffer;
+    Arena* arena; // owned by the queue, only the owner thread allocates from it
+    alignas(SPMC_QUEUE_CACHE_LINE_SIZE) std::atomic<U64> top;
+    alignas(SPMC_QUEUE_CACHE_LINE_SIZE) std::atomic<U64> bottom;
+    std::atomic<SpmcRing<T>*> ring;
 };
 
 template <typename T>
-static U64
-_spmc_queue_capacity(SpmcQueue<T>* queue);
+static SpmcRing<T>*
+_spmc_queue_ring_alloc(Arena* arena, U64 capacity);
+
+template <typename T>
+static SpmcRing<T>*
+_spmc_queue_grow(SpmcQueue<T>* queue, SpmcRing<T>* ring, U64 top, U64 bottom);
 
+// ~mgj: arena becomes owned by the queue and is released by spmc_queue_destroy
 template <typename T>
 SpmcQueue<T>*
 spmc_queue_create(Arena* arena, U64 capacity);
@@ -33,24 +43,24 @@ template <typename T>
 void
 spmc_queue_destroy(SpmcQueue<T>* queue);
 
+// ~mgj: owner thread only
 template <typename T>
 B32
 spmc_queue_push(SpmcQueue<T>* queue, const T& value);
 
+// ~mgj: owner thread only
 template <typename T>
 B32
 spmc_queue_pop(SpmcQueue<T>* queue, T& value);
 
+// ~mgj: any thread. Can fail spuriously when it races another steal or the owner's pop for the last item.
 template <typename T>
 B32
 spmc_queue_steal(SpmcQueue<T>* queue, T& value);
 
+// ~mgj: any thread, a snapshot that may be stale by the time it returns
 template <typename T>
 static U64
-spmc_queue_capacity(AsyncSpmcFifoQueue<T>* buffer);
-
-template <typename T>
-static T&
-spmc_queue_slot_get(AsyncSpmcFifoQueue<T>* buffer, U64 index);
+spmc_queue_count(SpmcQueue<T>* queue);
 
 } // namespace async
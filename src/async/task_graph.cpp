@@ -0,0 +1,177 @@
+namespace async
+{
+
+g_internal TaskGraph*
+task_graph_create(Arena* arena, ThreadPool* thread_pool)
+{
+    TaskGraph* graph = PushStruct(arena, TaskGraph);
+    graph->arena = arena;
+    graph->thread_pool = thread_pool;
+    return graph;
+}
+
+g_internal TaskNode*
+task_node_create(TaskGraph* graph, String8 name, TaskNodeFunc func, void* data)
+{
+    AssertAlways(!graph->is_launched);
+
+    TaskNode* node = PushStruct(graph->arena, TaskNode);
+    node->graph = graph;
+    node->name = push_str8_copy(graph->arena, name);
+    node->func = func;
+    node->data = data;
+    node->wait_count.store(func ? 1 : 2);
+    node->state.store(TaskNodeState_Pending);
+    SLLQueuePush(graph->first_node, graph->last_node, node);
+    graph->unfinished_count.fetch_add(1);
+    return node;
+}
+
+g_internal TaskNode*
+task_node_external_create(TaskGraph* graph, String8 name)
+{
+    return task_node_create(graph, name, 0, 0);
+}
+
+g_internal void
+task_node_depends(TaskNode* node, TaskNode* predecessor)
+{
+    AssertAlways(!node->graph->is_launched);
+    AssertAlways(node->graph == predecessor->graph);
+
+    TaskNodeLink* link = PushStruct(node->graph->arena, TaskNodeLink);
+    link->node = node;
+    SLLStackPush(predecessor->first_successor, link);
+    node->wait_count.fetch_add(1);
+}
+
+g_internal void
+task_graph_launch(TaskGraph* graph)
+{
+    AssertAlways(!graph->is_launched);
+    graph->is_launched = true;
+    for (TaskNode* node = graph->first_node; node; node = node->next)
+    {
+        _task_node_release(node);
+    }
+}
+
+g_internal void
+task_graph_cancel(TaskGraph* graph)
+{
+    graph->cancel_token.is_cancelled.store(true);
+}
+
+g_internal void
+task_graph_wait_idle(TaskGraph* graph)
+{
+    while (graph->running_count.load(std::memory_order_acquire) > 0)
+    {
+        std::this_thread::yield();
+    }
+}
+
+g_internal B32
+task_graph_is_done(TaskGraph* graph)
+{
+    return graph->unfinished_count.load(std::memory_order_acquire) == 0;
+}
+
+g_internal void
+task_node_complete(TaskNode* node, B32 success)
+{
+    AssertAlways(node->func == 0);
+    node->is_external_success.store(success);
+    _task_node_release(node);
+}
+
+g_internal TaskNodeState
+task_node_state(TaskNode* node)
+{
+    return (TaskNodeState)node->state.load(std::memory_order_acquire);
+}
+
+g_internal B32
+task_cancelled(CancelToken* cancel_token)
+{
+    return cancel_token->is_cancelled.load(std::memory_order_relaxed);
+}
+
+g_internal void
+_task_node_release(TaskNode* node)
+{
+    if (node->wait_count.fetch_sub(1, std::memory_order_acq_rel) != 1)
+    {
+        return;
+    }
+
+    // ~mgj: all predecessors are done (and the external completion is in)
+    TaskGraph* graph = node->graph;
+    if (node->is_predecessor_failed.load())
+    {
+        _task_node_finish(node, TaskNodeState_Cancelled);
+    }
+    else if (node->func == 0)
+    {
+        // ~mgj: the external work ran regardless of cancellation, report its outcome
+        _task_node_finish(node, node->is_external_success.load() ? TaskNodeState_Succeeded : TaskNodeState_Failed);
+    }
+    else if (task_cancelled(&graph->cancel_token))
+    {
+        _task_node_finish(node, TaskNodeState_Cancelled);
+    }
+    else
+    {
+        graph->running_count.fetch_add(1);
+        WorkerItem item = WorkerItem(node, _task_node_run);
+        item.name_id = thread_pool_stats_task_name_id(graph->thread_pool, node->name);
+        if (!thread_pool_push(graph->thread_pool, &item))
+        {
+            ThreadInfo thread_info = {.thread_pool = graph->thread_pool, .thread_id = t_cur_thread_id};
+            _task_node_run(thread_info, node);
+        }
+    }
+}
+
+g_internal void
+_task_node_finish(TaskNode* node, TaskNodeState state)
+{
+    node->state.store(state, std::memory_order_release);
+    B32 is_failed = state != TaskNodeState_Succeeded;
+    for (TaskNodeLink* link = node->first_successor; link; link = link->next)
+    {
+        if (is_failed)
+        {
+            link->node->is_predecessor_failed.store(true);
+        }
+        _task_node_release(link->node);
+    }
+    node->graph->unfinished_count.fetch_sub(1, std::memory_order_release);
+}
+
+g_internal WorkerResult
+_task_node_run(ThreadInfo thread_info, WorkerData data)
+{
+    prof_scope_marker;
+    TaskNode* node = (TaskNode*)data;
+    TaskGraph* graph = node->graph;
+
+    TaskNodeState state = TaskNodeState_Cancelled;
+    if (!task_cancelled(&graph->cancel_token))
+    {
+        node->state.store(TaskNodeState_Running, std::memory_order_release);
+        B32 success = node->func(thread_info, node->data, &graph->cancel_token);
+        state = success ? TaskNodeState_Succeeded : TaskNodeState_Failed;
+        if (!success)
+        {
+            ERROR_LOG("Task graph node failed: %.*s", str8_varg(node->name));
+        }
+    }
+    // ~mgj: successors are released (and pushed onto this worker's deque) before the count drops, so
+    // task_graph_wait_idle never sees zero between two chained nodes
+    _task_node_finish(node, state);
+    graph->running_count.fetch_sub(1, std::memory_order_release);
+    return {};
+}
+
+} // namespace async
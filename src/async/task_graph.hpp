@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+
+namespace async
+{
+
+// ~mgj: Dependency graph of tasks on the thread pool. A node runs as soon as all its predecessors have
+// finished, on the worker that finished the last one, so a chain of nodes runs back to back without
+// anyone polling. Build the graph on one thread (nodes, then edges), then call task_graph_launch.
+//
+// A node without a func is external: it finishes when task_node_complete is called on it, e.g. by an
+// AsyncTaskStatus through async_task_done_node_set. When a node fails or is cancelled, every node that
+// depends on it is cancelled without running.
+struct TaskGraph;
+struct TaskNode;
+
+struct CancelToken
+{
+    std::atomic<B32> is_cancelled;
+};
+
+enum TaskNodeState : U32
+{
+    TaskNodeState_Pending,
+    TaskNodeState_Running,
+    TaskNodeState_Succeeded,
+    TaskNodeState_Failed,
+    TaskNodeState_Cancelled,
+};
+
+// ~mgj: returns false on failure. Long running funcs should check task_cancelled(cancel_token).
+typedef B32 (*TaskNodeFunc)(ThreadInfo thread_info, void* data, CancelToken* cancel_token);
+
+struct TaskNodeLink
+{
+    TaskNodeLink* next;
+    TaskNode* node;
+};
+
+struct TaskNode
+{
+    TaskNode* next; // in TaskGraph
+    TaskGraph* graph;
+    String8 name;
+    TaskNodeFunc func; // 0 for external nodes
+    void* data;
+
+    // unfinished predecessors, plus one held until launch, plus one for the completion of an external node
+    std::atomic<U32> wait_count;
+    std::atomic<U32> state;
+    std::atomic<B32> is_predecessor_failed;
+    std::atomic<B32> is_external_success;
+    TaskNodeLink* first_successor;
+};
+
+struct TaskGraph
+{
+    Arena* arena;
+    ThreadPool* thread_pool;
+    CancelToken cancel_token;
+    B32 is_launched;
+    TaskNode* first_node;
+    TaskNode* last_node;
+    std::atomic<U32> unfinished_count;
+    std::atomic<U32> running_count;
+};
+
+// ~mgj: Graph functions /////////////////////////////
+g_internal TaskGraph*
+task_graph_create(Arena* arena, ThreadPool* thread_pool);
+g_internal TaskNode*
+task_node_create(TaskGraph* graph, String8 name, TaskNodeFunc func, void* data);
+g_internal TaskNode*
+task_node_external_create(TaskGraph* graph, String8 name);
+// ~mgj: node starts after predecessor has finished. Only before task_graph_launch.
+g_internal void
+task_node_depends(TaskNode* node, TaskNode* predecessor);
+g_internal void
+task_graph_launch(TaskGraph* graph);
+// ~mgj: nodes that have not started yet are cancelled, running ones see task_cancelled
+g_internal void
+task_graph_cancel(TaskGraph* graph);
+// ~mgj: blocks until no node func is running. Cancel first, external nodes may never complete.
+g_internal void
+task_graph_wait_idle(TaskGraph* graph);
+g_internal B32
+task_graph_is_done(TaskGraph* graph);
+g_internal void
+task_node_complete(TaskNode* node, B32 success);
+g_internal TaskNodeState
+task_node_state(TaskNode* node);
+g_internal B32
+task_cancelled(CancelToken* cancel_token);
+
+// ~mgj: internal
+g_internal void
+_task_node_release(TaskNode* node);
+g_internal void
+_task_node_finish(TaskNode* node, TaskNodeState state);
+g_internal WorkerResult
+_task_node_run(ThreadInfo thread_info, WorkerData data);
+////////////////////////////////////////////////
+
+} // namespace async
@@ -19,40 +19,137 @@ thread_pool_is_main_thread(ThreadPool* thread_pool)
     return _thread_pool_is_main_thread(thread_pool);
 }
 
-static U64
-_thread_pool_next_deadline(ThreadPool* thread_pool)
+static U32
+_thread_pool_random_u32(ThreadPoolWorker* worker)
 {
-    U64 result = max_U64;
+    // ~mgj: xorshift64
+    U64 x = worker->rng_state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    worker->rng_state = x;
+    return (U32)(x >> 32);
+}
 
-    HeapItem<WorkerItem> heap_item = {};
-    if (async::async_min_heap_peek(thread_pool->timer_min_heap, &heap_item))
+static B32
+_thread_pool_try_get_work(ThreadPool* thread_pool, U32 thread_id, WorkerItem* item)
+{
+    AssertAlways(thread_pool);
+    AssertAlways(item);
+    AssertAlways(thread_id < thread_pool->workers.size);
+
+    ThreadPoolWorker* worker = &thread_pool->workers.data[thread_id];
+    ThreadPoolWorkerStats* stats = &thread_pool->stats->workers.data[thread_id];
+    Queue<WorkerItem>* interactive_queue = thread_pool->lane_queues[ThreadPoolPriority_Interactive];
+    Queue<WorkerItem>* streaming_queue = thread_pool->lane_queues[ThreadPoolPriority_Streaming];
+    U32 tick = ++worker->tick;
+    B32 background_first = tick % THREAD_POOL_BACKGROUND_CHECK_INTERVAL == 0;
+    B32 inject_first = tick % THREAD_POOL_INJECT_CHECK_INTERVAL == 0;
+    if (background_first && _thread_pool_background_try_read(thread_pool, item))
     {
-        result = heap_item.k > 0 ? (U64)heap_item.k : 0;
+        _thread_pool_stats_counter_add(&stats->inject_pop_count, 1);
+        return true;
     }
 
-    return result;
+    if (queue_try_read(interactive_queue, item) || (inject_first && queue_try_read(streaming_queue, item)))
+    {
+        _thread_pool_stats_counter_add(&stats->inject_pop_count, 1);
+        return true;
+    }
+
+    if (spmc_queue_pop(worker->local_queue, *item))
+    {
+        _thread_pool_stats_counter_add(&stats->local_pop_count, 1);
+        return true;
+    }
+
+    if (!inject_first && queue_try_read(streaming_queue, item))
+    {
+        _thread_pool_stats_counter_add(&stats->inject_pop_count, 1);
+        return true;
+    }
+
+    // ~mgj: start at a random victim so thieves spread out instead of all hitting worker 0
+    U32 worker_count = (U32)thread_pool->workers.size;
+    U32 victim_start = _thread_pool_random_u32(worker) % worker_count;
+    for (U32 i = 0; i < worker_count; ++i)
+    {
+        U32 victim_idx = (victim_start + i) % worker_count;
+        if (victim_idx != thread_id && spmc_queue_steal(thread_pool->workers.data[victim_idx].local_queue, *item))
+        {
+            _thread_pool_stats_counter_add(&stats->steal_count, 1);
+            return true;
+        }
+    }
+    if (worker_count > 1)
+    {
+        _thread_pool_stats_counter_add(&stats->steal_miss_count, 1);
+    }
+
+    if (!background_first && _thread_pool_background_try_read(thread_pool, item))
+    {
+        _thread_pool_stats_counter_add(&stats->inject_pop_count, 1);
+        return true;
+    }
+
+    return false;
 }
 
 static B32
-_thread_pool_try_get_work(ThreadPool* thread_pool, WorkerItem* item)
+_thread_pool_background_slot_is_free(ThreadPool* thread_pool)
 {
-    AssertAlways(thread_pool);
-    AssertAlways(item);
+    // ~mgj: a worker already running a Background task drains that task's own children (fork/join inside
+    // it) without a slot of its own, otherwise the slot holders could all wait on each other's children
+    return t_cur_priority == ThreadPoolPriority_Background || thread_pool->background_running_count.load() < thread_pool->background_slot_count;
+}
 
-    if (queue_try_read(thread_pool->mpmc_queue, item))
+static B32
+_thread_pool_background_try_read(ThreadPool* thread_pool, WorkerItem* item)
+{
+    Queue<WorkerItem>* queue = thread_pool->lane_queues[ThreadPoolPriority_Background];
+    if (queue_count(queue) == 0)
     {
-        return true;
+        return false;
+    }
+    if (t_cur_priority == ThreadPoolPriority_Background)
+    {
+        return queue_try_read(queue, item);
     }
 
-    HeapItem<WorkerItem> heap_item = {};
-    U64 now = os_now_microseconds();
-    S64 now_s64 = now > (U64)max_S64 ? max_S64 : (S64)now;
-    if (async::async_min_heap_pop_ready(thread_pool->timer_min_heap, now_s64, &heap_item))
+    // ~mgj: the slot is released in _thread_pool_worker_run once the task finishes
+    if (thread_pool->background_running_count.fetch_add(1) >= thread_pool->background_slot_count)
+    {
+        thread_pool->background_running_count.fetch_sub(1);
+        return false;
+    }
+    if (queue_try_read(queue, item))
     {
-        *item = heap_item.v;
         return true;
     }
+    thread_pool->background_running_count.fetch_sub(1);
+    return false;
+}
 
+static B32
+_thread_pool_has_queued_work(ThreadPool* thread_pool)
+{
+    if (queue_count(thread_pool->lane_queues[ThreadPoolPriority_Interactive]) > 0 || queue_count(thread_pool->lane_queues[ThreadPoolPriority_Streaming]) > 0)
+    {
+        return true;
+    }
+    // ~mgj: Background work only counts while a slot is free, workers would spin on it otherwise. The
+    // worker that frees a slot wakes one up.
+    if (queue_count(thread_pool->lane_queues[ThreadPoolPriority_Background]) > 0 && _thread_pool_background_slot_is_free(thread_pool))
+    {
+        return true;
+    }
+    for (ThreadPoolWorker& worker : thread_pool->workers)
+    {
+        if (spmc_queue_count(worker.local_queue) > 0)
+        {
+            return true;
+        }
+    }
     return false;
 }
 
@@ -65,25 +162,267 @@ _thread_pool_worker_task_execute(ThreadInfo thread_info, WorkerItem* item)
     WorkerResult result = item->func(thread_info, item->user_data);
     if (result.next_task.func)
     {
-        B32 queued = thread_pool_push(thread_info.thread_pool, &result.next_task, result.us_delay);
+        ThreadPool* thread_pool = thread_info.thread_pool;
+        if (result.next_task.name_id == 0)
+        {
+            result.next_task.name_id = item->name_id;
+        }
+        if (result.next_task.priority == ThreadPoolPriority_Inherit)
+        {
+            result.next_task.priority = item->priority;
+        }
+        if (result.us_delay > 0 || thread_pool->kill_switch || !_thread_pool_is_worker_thread(thread_pool))
+        {
+            B32 queued = thread_pool_push(thread_pool, &result.next_task, result.us_delay);
+            AssertAlways(queued);
+        }
+        else
+        {
+            // ~mgj: a continuation goes to the back of the shared queue, not on top of the local deque.
+            // Tasks that poll by rescheduling themselves would otherwise pop themselves forever.
+            thread_pool->pending_task_count.fetch_add(1);
+            _thread_pool_push_global(thread_pool, &result.next_task);
+            _thread_pool_notify(thread_pool);
+        }
+    }
+}
+
+static void
+_thread_pool_worker_run(ThreadInfo thread_info, WorkerItem* item)
+{
+    ThreadPool* thread_pool = thread_info.thread_pool;
+    thread_pool->in_flight_count.fetch_add(1);
+    thread_pool->pending_task_count.fetch_sub(1);
+    // ~mgj: nested runs (fork/join helping) restore the lane of the task they interrupted
+    ThreadPoolPriority prev_priority = t_cur_priority;
+    B32 holds_background_slot = item->priority == ThreadPoolPriority_Background && prev_priority != ThreadPoolPriority_Background;
+    t_cur_priority = item->priority;
+    U64 start_us = os_now_microseconds();
+    _thread_pool_worker_task_execute(thread_info, item);
+    _thread_pool_stats_task_record(thread_pool, thread_info.thread_id, item, start_us, os_now_microseconds());
+    t_cur_priority = prev_priority;
+    if (holds_background_slot)
+    {
+        thread_pool->background_running_count.fetch_sub(1);
+        if (queue_count(thread_pool->lane_queues[ThreadPoolPriority_Background]) > 0)
+        {
+            _thread_pool_notify(thread_pool);
+        }
+    }
+    thread_pool->in_flight_count.fetch_sub(1);
+}
+
+static void
+_thread_pool_push_global(ThreadPool* thread_pool, WorkerItem* item)
+{
+    Assert(item->priority != ThreadPoolPriority_Inherit);
+    item->enqueue_us = os_now_microseconds();
+    B32 queued = queue_push(thread_pool->lane_queues[item->priority], item);
+    AssertAlways(queued);
+}
+
+static ThreadPoolPriority
+_thread_pool_priority_resolve(ThreadPoolPriority priority)
+{
+    if (priority != ThreadPoolPriority_Inherit)
+    {
+        return priority;
+    }
+    return t_cur_priority != ThreadPoolPriority_Inherit ? t_cur_priority : ThreadPoolPriority_Streaming;
+}
+
+ThreadPoolPriorityScope::ThreadPoolPriorityScope(ThreadPoolPriority priority)
+{
+    prev_priority = t_cur_priority;
+    t_cur_priority = priority;
+}
+
+ThreadPoolPriorityScope::~ThreadPoolPriorityScope()
+{
+    t_cur_priority = prev_priority;
+}
+
+static B32
+_thread_pool_unpark_one(ThreadPool* thread_pool)
+{
+    // ~mgj: the woken worker counts as searching until it finds work or parks again
+    thread_pool->searching_count.fetch_add(1);
+    U32 worker_count = (U32)thread_pool->workers.size;
+    U32 start = thread_pool->unpark_cursor.fetch_add(1, std::memory_order_relaxed);
+    for (U32 i = 0; i < worker_count; ++i)
+    {
+        ThreadPoolWorker* worker = &thread_pool->workers.data[(start + i) % worker_count];
+        U32 expected = 1;
+        if (worker->is_parked.load(std::memory_order_relaxed) && worker->is_parked.compare_exchange_strong(expected, 0))
+        {
+            os_mutex_scope(worker->park_mutex)
+            {
+                os_condition_variable_signal(worker->park_cv);
+            }
+            return true;
+        }
+    }
+    thread_pool->searching_count.fetch_sub(1);
+    return false;
+}
+
+static void
+_thread_pool_notify(ThreadPool* thread_pool)
+{
+    // ~mgj: pairs with the fence in _thread_pool_park: either the parking worker sees the new task or we
+    // see it parked. A searching worker will find the task itself, and wakes the next one when it does.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (thread_pool->parked_count.load(std::memory_order_relaxed) == 0)
+    {
+        return;
+    }
+    if (thread_pool->searching_count.load(std::memory_order_relaxed) == 0)
+    {
+        _thread_pool_unpark_one(thread_pool);
+    }
+}
+
+static void
+_thread_pool_park(ThreadPool* thread_pool, U32 thread_id, B32* is_searching)
+{
+    ThreadPoolWorker* worker = &thread_pool->workers.data[thread_id];
+    if (*is_searching)
+    {
+        *is_searching = false;
+        thread_pool->searching_count.fetch_sub(1);
+    }
+
+    worker->is_parked.store(1);
+    thread_pool->parked_count.fetch_add(1);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    B32 was_woken = false;
+    if (thread_pool->kill_switch || _thread_pool_has_queued_work(thread_pool))
+    {
+        U32 expected = 1;
+        was_woken = !worker->is_parked.compare_exchange_strong(expected, 0);
+    }
+    else
+    {
+        // ~mgj: no deadline, due timers arrive through the injection ring like any other push
+        os_mutex_take(worker->park_mutex);
+        while (worker->is_parked.load(std::memory_order_acquire) && !thread_pool->kill_switch)
+        {
+            os_condition_variable_wait(worker->park_cv, worker->park_mutex, max_U64);
+        }
+        U32 expected = 1;
+        was_woken = !worker->is_parked.compare_exchange_strong(expected, 0);
+        os_mutex_drop(worker->park_mutex);
+    }
+    thread_pool->parked_count.fetch_sub(1);
+    ThreadPoolWorkerStats* stats = &thread_pool->stats->workers.data[thread_id];
+    _thread_pool_stats_counter_add(&stats->park_count, 1);
+    _thread_pool_stats_counter_add(&stats->wake_count, was_woken ? 1 : 0);
+
+    // ~mgj: whoever cleared is_parked counted this worker as searching
+    *is_searching = was_woken;
+}
+
+static void
+_thread_pool_timer_push(ThreadPool* thread_pool, WorkerItem* item, U64 deadline_us)
+{
+    ThreadPoolTimer timer = {.item = *item, .deadline_us = deadline_us};
+    B32 is_in_worker_ring = _thread_pool_is_worker_thread(thread_pool) && mpmc_ring_try_push(thread_pool->workers.data[t_cur_thread_id].timer_ring, &timer);
+    if (!is_in_worker_ring)
+    {
+        B32 queued = queue_push(thread_pool->timer_queue, &timer);
         AssertAlways(queued);
     }
+
+    // ~mgj: pairs with the fence in _thread_pool_timer_thread: either it sees the new timer before it
+    // sleeps or we see when it sleeps until. Only a deadline before that needs a wakeup.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    U64 wake_us = thread_pool->timer_wake_us.load(std::memory_order_relaxed);
+    if (wake_us != 0 && deadline_us < wake_us && thread_pool->timer_wake_us.compare_exchange_strong(wake_us, 0))
+    {
+        os_mutex_scope(thread_pool->timer_mutex)
+        {
+            os_condition_variable_signal(thread_pool->timer_cv);
+        }
+    }
+}
+
+// ~mgj: moves the timers from the rings into the wheel, returns true when there were any
+static B32
+_thread_pool_timer_drain(ThreadPool* thread_pool)
+{
+    B32 result = false;
+    ThreadPoolTimer timer = {};
+    for (ThreadPoolWorker& worker : thread_pool->workers)
+    {
+        while (mpmc_ring_try_pop(worker.timer_ring, &timer))
+        {
+            timer_wheel_insert(thread_pool->timer_wheel, &timer.item, timer.deadline_us);
+            result = true;
+        }
+    }
+    while (queue_try_read(thread_pool->timer_queue, &timer))
+    {
+        timer_wheel_insert(thread_pool->timer_wheel, &timer.item, timer.deadline_us);
+        result = true;
+    }
+    return result;
+}
+
+static B32
+_thread_pool_timer_rings_empty(ThreadPool* thread_pool)
+{
+    for (ThreadPoolWorker& worker : thread_pool->workers)
+    {
+        if (mpmc_ring_count(worker.timer_ring) > 0)
+        {
+            return false;
+        }
+    }
+    return queue_count(thread_pool->timer_queue) == 0;
 }
 
 static void
-_thread_pool_wake_workers(ThreadPool* thread_pool, B32 wake_all)
+_thread_pool_timer_thread(void* data)
 {
-    os_mutex_scope(thread_pool->work_mutex)
+    ThreadPool* thread_pool = (ThreadPool*)data;
+    os_set_thread_name(S("ThreadPoolTimer"));
+
+    while (!thread_pool->kill_switch)
     {
-        thread_pool->work_generation.fetch_add(1);
-        if (wake_all)
+        _thread_pool_stats_counter_add(&thread_pool->stats->timer_wake_count, 1);
+        _thread_pool_timer_drain(thread_pool);
+
+        B32 has_fired = false;
+        WorkerItem item = {};
+        while (timer_wheel_pop_due(thread_pool->timer_wheel, os_now_microseconds(), &item))
         {
-            os_condition_variable_broadcast(thread_pool->work_cv);
+            _thread_pool_push_global(thread_pool, &item);
+            _thread_pool_stats_counter_add(&thread_pool->stats->timer_fire_count, 1);
+            has_fired = true;
         }
-        else
+        if (has_fired)
+        {
+            _thread_pool_notify(thread_pool);
+        }
+
+        U64 wake_us = timer_wheel_next_us(thread_pool->timer_wheel);
+        if (wake_us <= os_now_microseconds())
+        {
+            continue;
+        }
+        thread_pool->timer_wake_us.store(wake_us);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (_thread_pool_timer_rings_empty(thread_pool))
         {
-            os_condition_variable_signal(thread_pool->work_cv);
+            os_mutex_take(thread_pool->timer_mutex);
+            while (thread_pool->timer_wake_us.load(std::memory_order_acquire) != 0 && !thread_pool->kill_switch &&
+                   os_condition_variable_wait(thread_pool->timer_cv, thread_pool->timer_mutex, wake_us))
+            {
+            }
+            os_mutex_drop(thread_pool->timer_mutex);
         }
+        thread_pool->timer_wake_us.store(0);
     }
 }
 
@@ -116,20 +455,25 @@ thread_pool_push(ThreadPool* thread_pool, WorkerItem* task, S64 us_delay)
     }
 
     thread_pool->pending_task_count.fetch_add(1);
+    task->priority = _thread_pool_priority_resolve(task->priority);
 
     if (us_delay > 0)
     {
-        U64 now = os_now_microseconds();
-        S64 now_s64 = now > (U64)max_S64 ? max_S64 : (S64)now;
-        S64 cutoff_time = now_s64 + us_delay;
-        async::async_min_heap_push(thread_pool->timer_min_heap, *task, cutoff_time);
+        _thread_pool_timer_push(thread_pool, task, os_now_microseconds() + (U64)us_delay);
+        return true;
+    }
+
+    if (_thread_pool_is_worker_thread(thread_pool) && task->priority != ThreadPoolPriority_Background)
+    {
+        task->enqueue_us = os_now_microseconds();
+        spmc_queue_push(thread_pool->workers.data[t_cur_thread_id].local_queue, *task);
     }
     else
     {
-        queue_push(thread_pool->mpmc_queue, task);
+        _thread_pool_push_global(thread_pool, task);
     }
 
-    _thread_pool_wake_workers(thread_pool, false);
+    _thread_pool_notify(thread_pool);
     return true;
 }
 
@@ -148,24 +492,13 @@ thread_pool_main_thread_queue_push(ThreadPool* thread_pool, WorkerItem* item)
     AssertAlways(thread_pool_register_current_thread(thread_pool));
     AssertAlways(_thread_pool_is_worker_thread(thread_pool));
 
-    os_mutex_take(thread_pool->main_thread_queue_mutex);
-    for (;;)
+    if (thread_pool->kill_switch)
     {
-        if (thread_pool->kill_switch)
-        {
-            os_mutex_drop(thread_pool->main_thread_queue_mutex);
-            return false;
-        }
-
-        if (queue_try_push(thread_pool->main_thread_queue, item))
-        {
-            os_condition_variable_broadcast(thread_pool->main_thread_queue_cv);
-            os_mutex_drop(thread_pool->main_thread_queue_mutex);
-            return true;
-        }
-
-        os_condition_variable_wait(thread_pool->main_thread_queue_cv, thread_pool->main_thread_queue_mutex, max_U64);
+        return false;
     }
+    item->priority = _thread_pool_priority_resolve(item->priority);
+    // ~mgj: blocks while the queue is full, thread_pool_destroy closes it to release waiting workers
+    return queue_push(thread_pool->main_thread_queue, item);
 }
 
 static B32
@@ -176,15 +509,7 @@ thread_pool_main_thread_queue_try_pull(ThreadPool* thread_pool, WorkerItem* item
     AssertAlways(thread_pool_register_current_thread(thread_pool));
     AssertAlways(_thread_pool_is_main_thread(thread_pool));
 
-    os_mutex_take(thread_pool->main_thread_queue_mutex);
-    B32 has_item = queue_try_read(thread_pool->main_thread_queue, item);
-    if (has_item)
-    {
-        os_condition_variable_broadcast(thread_pool->main_thread_queue_cv);
-    }
-    os_mutex_drop(thread_pool->main_thread_queue_mutex);
-
-    return has_item;
+    return queue_try_read(thread_pool->main_thread_queue, item);
 }
 
 static void
@@ -201,6 +526,8 @@ thread_pool_main_thread_queue_drain(ThreadPool* thread_pool)
     WorkerItem item = {};
     while (thread_pool_main_thread_queue_try_pull(thread_pool, &item))
     {
+        // ~mgj: work the item pushes stays in the lane of the task that sent it here
+        ThreadPoolPriorityScope priority_scope = ThreadPoolPriorityScope(item.priority);
         _thread_pool_worker_task_execute(thread_info, &item);
     }
 }
@@ -212,8 +539,6 @@ thread_worker(void* data)
     ThreadInput* input = (ThreadInput*)data;
     ThreadPool* thread_pool = input->thread_pool;
     U32 thread_id = input->thread_id;
-    OS_Handle work_mutex = thread_pool->work_mutex;
-    OS_Handle work_cv = thread_pool->work_cv;
 
     os_set_thread_name(PushStr8F(scratch.arena, "ThreadWorker: %zu", thread_id));
     ThreadInfo thread_info = {};
@@ -222,6 +547,7 @@ thread_worker(void* data)
     thread_info.thread_pool = thread_pool;
     thread_info.thread_id = thread_id;
 
+    B32 is_searching = false;
     for (;;)
     {
         if (thread_pool->kill_switch)
@@ -229,26 +555,30 @@ thread_worker(void* data)
             break;
         }
 
-        U64 work_generation = thread_pool->work_generation.load(std::memory_order_acquire);
         WorkerItem item = {};
-        if (_thread_pool_try_get_work(thread_pool, &item))
+        if (_thread_pool_try_get_work(thread_pool, thread_id, &item))
         {
-            thread_pool->in_flight_count.fetch_add(1);
-            thread_pool->pending_task_count.fetch_sub(1);
-            _thread_pool_worker_task_execute(thread_info, &item);
-            thread_pool->in_flight_count.fetch_sub(1);
+            // ~mgj: the last searcher to find work wakes another, so wakeups ramp up one at a time
+            // with the amount of queued work instead of all workers waking for every push
+            if (is_searching)
+            {
+                is_searching = false;
+                if (thread_pool->searching_count.fetch_sub(1) == 1)
+                {
+                    _thread_pool_notify(thread_pool);
+                }
+            }
+            _thread_pool_worker_run(thread_info, &item);
             continue;
         }
 
-        U64 next_deadline = _thread_pool_next_deadline(thread_pool);
-        os_mutex_take(work_mutex);
-        if (!thread_pool->kill_switch && work_generation == thread_pool->work_generation.load(std::memory_order_acquire))
-        {
-            os_condition_variable_wait(work_cv, work_mutex, next_deadline);
-        }
-        os_mutex_drop(work_mutex);
+        _thread_pool_park(thread_pool, thread_id, &is_searching);
     }
 
+    if (is_searching)
+    {
+        thread_pool->searching_count.fetch_sub(1);
+    }
     t_cur_thread_id = max_U32;
     t_thread_pool = 0;
 }
@@ -260,16 +590,36 @@ thread_pool_create(Arena* arena, U32 thread_count, U32 mpmc_queue_size, U32 main
     thread_info->thread_handles = buffer_alloc<OS_Handle>(arena, thread_count);
     thread_info->thread_count = thread_count;
     thread_info->kill_switch = 0;
-    thread_info->work_generation.store(0);
     thread_info->in_flight_count.store(0);
     thread_info->pending_task_count.store(0);
-    thread_info->timer_min_heap = async::async_heap_alloc<WorkerItem>();
-    thread_info->mpmc_queue = queue_alloc<WorkerItem>(arena, mpmc_queue_size);
-    thread_info->work_mutex = OS_MutexAlloc();
-    thread_info->work_cv = os_condition_variable_alloc();
-    thread_info->main_thread_queue = queue_alloc<WorkerItem>(arena, main_thread_queue_size);
-    thread_info->main_thread_queue_mutex = OS_MutexAlloc();
-    thread_info->main_thread_queue_cv = os_condition_variable_alloc();
+    thread_info->timer_wheel = timer_wheel_alloc<WorkerItem>(THREAD_POOL_TIMER_TICK_US, os_now_microseconds());
+    thread_info->timer_queue = queue_alloc<ThreadPoolTimer>(arena, Max(mpmc_queue_size, THREAD_POOL_INJECT_RING_SIZE_MIN), QueueFullPolicy_Spill);
+    thread_info->timer_wake_us.store(0);
+    thread_info->timer_mutex = OS_MutexAlloc();
+    thread_info->timer_cv = os_condition_variable_alloc();
+    for (U32 priority = ThreadPoolPriority_Interactive; priority < ThreadPoolPriority_Count; ++priority)
+    {
+        thread_info->lane_queues[priority] = queue_alloc<WorkerItem>(arena, Max(mpmc_queue_size, THREAD_POOL_INJECT_RING_SIZE_MIN), QueueFullPolicy_Spill);
+    }
+    thread_info->background_slot_count = Max(thread_count / THREAD_POOL_BACKGROUND_SLOT_DIVISOR, 1u);
+    thread_info->background_running_count.store(0);
+    thread_info->searching_count.store(0);
+    thread_info->parked_count.store(0);
+    thread_info->unpark_cursor.store(0);
+    thread_info->main_thread_queue = queue_alloc<WorkerItem>(arena, main_thread_queue_size, QueueFullPolicy_Block);
+    thread_info->stats = thread_pool_stats_create(thread_count);
+
+    thread_info->workers = buffer_alloc<ThreadPoolWorker>(arena, thread_count);
+    for (U32 i = 0; i < thread_count; i++)
+    {
+        ThreadPoolWorker* worker = &thread_info->workers.data[i];
+        worker->local_queue = spmc_queue_create<WorkerItem>(arena_alloc(), THREAD_POOL_LOCAL_QUEUE_SIZE);
+        worker->is_parked.store(0);
+        worker->park_mutex = OS_MutexAlloc();
+        worker->park_cv = os_condition_variable_alloc();
+        worker->rng_state = hash_index_hash_u64(i + 1) | 1;
+        worker->timer_ring = mpmc_ring_alloc<ThreadPoolTimer>(arena, THREAD_POOL_TIMER_RING_SIZE);
+    }
 
     for (U32 i = 0; i < thread_count; i++)
     {
@@ -278,28 +628,116 @@ thread_pool_create(Arena* arena, U32 thread_count, U32 mpmc_queue_size, U32 main
         input->thread_id = i;
         thread_info->thread_handles.data[i] = OS_ThreadLaunch(thread_worker, input, NULL);
     }
+    if (thread_count > 0)
+    {
+        thread_info->timer_thread_handle = OS_ThreadLaunch(_thread_pool_timer_thread, thread_info, NULL);
+    }
 
     return thread_info;
 }
 
+static WorkerResult
+_thread_pool_fork_join_task(ThreadInfo thread_info, WorkerData data)
+{
+    _ForkJoinTask* task = (_ForkJoinTask*)data;
+    task->func(thread_info, task->data, task->task_idx);
+    task->remaining->fetch_sub(1, std::memory_order_release);
+    return {};
+}
+
+static void
+thread_pool_fork_join(ThreadPool* thread_pool, U32 task_count, ForkJoinFunc func, void* data)
+{
+    if (task_count == 0)
+    {
+        return;
+    }
+
+    ScratchScope scratch = ScratchScope(0, 0);
+    B32 is_worker_thread = _thread_pool_is_worker_thread(thread_pool);
+    ThreadInfo thread_info = {};
+    thread_info.thread_pool = thread_pool;
+    thread_info.thread_id = is_worker_thread ? t_cur_thread_id : max_U32;
+
+    std::atomic<U32> remaining = task_count;
+    _ForkJoinTask* tasks = PushArray(scratch.arena, _ForkJoinTask, task_count);
+    for (U32 task_idx = 0; task_idx < task_count; ++task_idx)
+    {
+        tasks[task_idx] = {.func = func, .data = data, .task_idx = task_idx, .remaining = &remaining};
+    }
+    for (U32 task_idx = 1; task_idx < task_count; ++task_idx)
+    {
+        WorkerItem item = WorkerItem(&tasks[task_idx], _thread_pool_fork_join_task);
+        if (!thread_pool_push(thread_pool, &item))
+        {
+            _thread_pool_fork_join_task(thread_info, &tasks[task_idx]);
+        }
+    }
+    _thread_pool_fork_join_task(thread_info, &tasks[0]);
+
+    // ~mgj: only workers help, tasks may assume they run on a worker (e.g. main thread queue pushes).
+    // Idle waiting yields after a short spin so the waiter does not starve the workers on busy cores.
+    U32 idle_spin_count = 0;
+    while (remaining.load(std::memory_order_acquire) > 0)
+    {
+        WorkerItem item = {};
+        if (is_worker_thread && _thread_pool_try_get_work(thread_pool, t_cur_thread_id, &item))
+        {
+            _thread_pool_worker_run(thread_info, &item);
+            idle_spin_count = 0;
+        }
+        else if (idle_spin_count++ < 64)
+        {
+            _mm_pause();
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
 static void
 thread_pool_destroy(ThreadPool* thread_info)
 {
     thread_info->kill_switch = 1;
-    _thread_pool_wake_workers(thread_info, true);
-    os_condition_variable_broadcast(thread_info->main_thread_queue_cv);
+    for (ThreadPoolWorker& worker : thread_info->workers)
+    {
+        os_mutex_scope(worker.park_mutex)
+        {
+            os_condition_variable_signal(worker.park_cv);
+        }
+    }
+    queue_close(thread_info->main_thread_queue);
+    os_mutex_scope(thread_info->timer_mutex)
+    {
+        os_condition_variable_signal(thread_info->timer_cv);
+    }
 
     for (U32 i = 0; i < thread_info->thread_handles.size; i++)
     {
         AssertAlways(OS_ThreadJoin(thread_info->thread_handles.data[i], max_U64));
     }
+    if (thread_info->thread_count > 0)
+    {
+        AssertAlways(OS_ThreadJoin(thread_info->timer_thread_handle, max_U64));
+    }
 
-    queue_release(thread_info->mpmc_queue);
+    for (ThreadPoolWorker& worker : thread_info->workers)
+    {
+        spmc_queue_destroy(worker.local_queue);
+        os_condition_variable_release(worker.park_cv);
+        OS_MutexRelease(worker.park_mutex);
+    }
+    for (U32 priority = ThreadPoolPriority_Interactive; priority < ThreadPoolPriority_Count; ++priority)
+    {
+        queue_release(thread_info->lane_queues[priority]);
+    }
     queue_release(thread_info->main_thread_queue);
-    os_condition_variable_release(thread_info->main_thread_queue_cv);
-    OS_MutexRelease(thread_info->main_thread_queue_mutex);
-    os_condition_variable_release(thread_info->work_cv);
-    OS_MutexRelease(thread_info->work_mutex);
-    async::async_heap_release(thread_info->timer_min_heap);
+    queue_release(thread_info->timer_queue);
+    os_condition_variable_release(thread_info->timer_cv);
+    OS_MutexRelease(thread_info->timer_mutex);
+    timer_wheel_release(thread_info->timer_wheel);
+    thread_pool_stats_destroy(thread_info->stats);
 }
 } // namespace async
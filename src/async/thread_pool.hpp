@@ -1,22 +1,51 @@
 #pragma once
 
+#include <atomic>
+#include <thread>
+
 namespace async
 {
 template <typename T>
-struct Heap;
+struct TimerWheel;
 template <typename T>
 struct Queue;
+template <typename T>
+struct MpmcRing;
+template <typename T>
+struct SpmcQueue;
 struct ThreadPool;
 struct ThreadInfo;
+struct ThreadPoolStats;
 
 struct WorkerResult;
 typedef void* WorkerData;
 typedef WorkerResult (*WorkerFunc)(ThreadInfo, WorkerData);
 
+// ~mgj: Scheduling lanes.
+//   Interactive  work the current frame waits on (per-frame agent updates, fork/join from the main thread)
+//   Streaming    view data that should show up within a few frames (tile loads, uploads)
+//   Background   precompute that may take as long as it needs (OSM parse, NetAScore, road build)
+// Inherit resolves on push to the lane of the task doing the push, or of the pushing thread's
+// ThreadPoolPriorityScope, and to Streaming when there is neither.
+enum ThreadPoolPriority : U32
+{
+    ThreadPoolPriority_Inherit,
+    ThreadPoolPriority_Interactive,
+    ThreadPoolPriority_Streaming,
+    ThreadPoolPriority_Background,
+    ThreadPoolPriority_Count,
+};
+
+read_only g_internal const char* thread_pool_priority_names[ThreadPoolPriority_Count] = {"inherit", "interactive", "streaming", "background"};
+
 struct WorkerItem
 {
     WorkerData user_data;
     WorkerFunc func;
+    ThreadPoolPriority priority = ThreadPoolPriority_Inherit;
+    // ~mgj: instrumentation, see thread_pool_stats.hpp. Set by the pool on push.
+    U64 enqueue_us = 0;
+    U32 name_id = 0;
 
     WorkerItem() = default;
     WorkerItem(WorkerData user_data, WorkerFunc func) : user_data(user_data), func(func)
@@ -42,53 +71,158 @@ struct ThreadInput
     U32 thread_id;
 };
 
+// ~mgj: Work stealing, see thread_pool.cpp. Every THREAD_POOL_INJECT_CHECK_INTERVAL-th lookup a worker
+// checks the Streaming lane before its own deque so external pushes are not starved by local work.
+const U32 THREAD_POOL_INJECT_CHECK_INTERVAL = 61;
+// ~mgj: Background tasks run on at most thread_count / THREAD_POOL_BACKGROUND_SLOT_DIVISOR workers at
+// once (at least one), so a long precompute never occupies the workers view-critical work needs. Every
+// THREAD_POOL_BACKGROUND_CHECK_INTERVAL-th lookup checks the Background lane first so it keeps moving
+// while the other lanes are never empty.
+const U32 THREAD_POOL_BACKGROUND_SLOT_DIVISOR = 2;
+const U32 THREAD_POOL_BACKGROUND_CHECK_INTERVAL = 31;
+const U32 THREAD_POOL_INJECT_RING_SIZE_MIN = 1024;
+const U32 THREAD_POOL_LOCAL_QUEUE_SIZE = 256;
+// ~mgj: delayed tasks fire at the first timer tick at or after their deadline
+const U64 THREAD_POOL_TIMER_TICK_US = 1000;
+const U32 THREAD_POOL_TIMER_RING_SIZE = 256;
+
+struct ThreadPoolTimer
+{
+    WorkerItem item;
+    U64 deadline_us;
+};
+
+struct alignas(64) ThreadPoolWorker
+{
+    // owner pushes and pops, other workers steal
+    SpmcQueue<WorkerItem>* local_queue;
+    // parking: set by the worker before it sleeps, cleared by whoever wakes it
+    std::atomic<U32> is_parked;
+    OS_Handle park_mutex;
+    OS_Handle park_cv;
+    U64 rng_state; // victim selection
+    U32 tick;
+    // delayed tasks pushed by this worker, drained by the timer thread
+    MpmcRing<ThreadPoolTimer>* timer_ring;
+};
+
 struct ThreadPool
 {
     B32 kill_switch;
 
     // worker thread queues
-    // Workers read immediate tasks from the shared queue and delayed tasks from the timer heap.
+    // Every lane has a shared injection queue that spills into its overflow list when the ring is full.
+    // Workers look in the Interactive lane, their own deque, the Streaming lane, steal from each other and
+    // then take Background work while a background slot is free. External threads push into the lane of
+    // the item, workers into their own deque, except for Background items which always go to their lane.
     U32 thread_count;
-    std::atomic<U64> work_generation;
     std::atomic<U32> in_flight_count;
     std::atomic<U32> pending_task_count;
     Buffer<OS_Handle> thread_handles;
-    Heap<WorkerItem>* timer_min_heap;
-    Queue<WorkerItem>* mpmc_queue;
-    OS_Handle work_mutex;
-    OS_Handle work_cv;
+    Buffer<ThreadPoolWorker> workers;
+    Queue<WorkerItem>* lane_queues[ThreadPoolPriority_Count]; // ThreadPoolPriority_Inherit is never queued and has none
+    U32 background_slot_count;
+    std::atomic<U32> background_running_count;
+    // workers woken up that have not found work yet, a push only wakes a worker when this is zero
+    std::atomic<U32> searching_count;
+    std::atomic<U32> parked_count;
+    std::atomic<U32> unpark_cursor;
 
-    // main thread queue: main thread pulls and worker thread push to this queue
+    // delayed tasks
+    // Workers write into their own timer ring, other threads and workers whose ring is full into the
+    // shared timer queue, which spills. Only the timer thread touches the wheel: it drains the rings and
+    // the queue, fires due tasks into the injection queue and sleeps until the next tick that has work.
+    OS_Handle timer_thread_handle;
+    TimerWheel<WorkerItem>* timer_wheel;
+    Queue<ThreadPoolTimer>* timer_queue;
+    // when the sleeping timer thread wakes up next, 0 while it is awake
+    std::atomic<U64> timer_wake_us;
+    OS_Handle timer_mutex;
+    OS_Handle timer_cv;
+
+    // main thread queue: main thread pulls and worker thread push to this queue, pushes block while it is full
     Queue<WorkerItem>* main_thread_queue;
-    OS_Handle main_thread_queue_mutex;
-    OS_Handle main_thread_queue_cv;
+
+    ThreadPoolStats* stats;
+};
+
+// ~mgj: Fork/join over task_count calls of func, see thread_pool_fork_join
+typedef void (*ForkJoinFunc)(ThreadInfo thread_info, void* data, U32 task_idx);
+
+// ~mgj: Sets the lane for Inherit items pushed from this thread while in scope, e.g. on the main
+// thread around a precompute kickoff. Tasks already run with their own lane, a scope inside one
+// overrides it for the pushes it makes.
+struct ThreadPoolPriorityScope
+{
+    ThreadPoolPriority prev_priority;
+
+    ThreadPoolPriorityScope(ThreadPoolPriority priority);
+    ~ThreadPoolPriorityScope();
+};
+
+struct _ForkJoinTask
+{
+    ForkJoinFunc func;
+    void* data;
+    U32 task_idx;
+    std::atomic<U32>* remaining;
 };
 
 // ~mgj: Globals /////////////////////////////
 // used for threads that want to access thread_local data
 thread_local U32 t_cur_thread_id = max_U32;
 thread_local ThreadPool* t_thread_pool = 0;
+// lane of the running task on workers, of the innermost ThreadPoolPriorityScope elsewhere
+thread_local ThreadPoolPriority t_cur_priority = ThreadPoolPriority_Inherit;
 ////////////////////////////////////////////////
-static U64
-_thread_pool_next_deadline(ThreadPool* thread_pool);
 static B32
-_thread_pool_try_get_work(ThreadPool* thread_pool, WorkerItem* item);
+_thread_pool_try_get_work(ThreadPool* thread_pool, U32 thread_id, WorkerItem* item);
+static B32
+_thread_pool_has_queued_work(ThreadPool* thread_pool);
 static void
 _thread_pool_worker_task_execute(ThreadInfo thread_info, WorkerItem* item);
 static void
-_thread_pool_wake_workers(ThreadPool* thread_pool, B32 wake_all);
+_thread_pool_worker_run(ThreadInfo thread_info, WorkerItem* item);
+static void
+_thread_pool_push_global(ThreadPool* thread_pool, WorkerItem* item);
+static ThreadPoolPriority
+_thread_pool_priority_resolve(ThreadPoolPriority priority);
+static B32
+_thread_pool_background_try_read(ThreadPool* thread_pool, WorkerItem* item);
+static B32
+_thread_pool_background_slot_is_free(ThreadPool* thread_pool);
+static B32
+_thread_pool_unpark_one(ThreadPool* thread_pool);
+static void
+_thread_pool_notify(ThreadPool* thread_pool);
+static void
+_thread_pool_park(ThreadPool* thread_pool, U32 thread_id, B32* is_searching);
+static void
+_thread_pool_timer_push(ThreadPool* thread_pool, WorkerItem* item, U64 deadline_us);
+static B32
+_thread_pool_timer_drain(ThreadPool* thread_pool);
+static void
+_thread_pool_timer_thread(void* data);
 static B32
 thread_pool_register_current_thread(ThreadPool* thread_pool);
+// ~mgj: A worker pushes into its own deque, any other thread into the injection queue of the item's lane.
+// Background items always go to their lane and delayed tasks to the timer thread.
 static B32
 thread_pool_push(ThreadPool* thread_pool, WorkerItem* task, S64 us_delay = 0);
 static B32
 thread_pool_has_pending_work(ThreadPool* thread_pool);
 static void
 thread_worker(void* data);
+// ~mgj: mpmc_queue_size sizes the injection ring (at least THREAD_POOL_INJECT_RING_SIZE_MIN)
 static ThreadPool*
 thread_pool_create(Arena* arena, U32 thread_count, U32 mpmc_queue_size, U32 main_thread_queue_size);
 static void
 thread_pool_destroy(ThreadPool* thread_info);
+// ~mgj: Runs func(task_idx) for every task_idx in [0, task_count) on the pool and returns when all
+// calls have finished. Task 0 runs on the calling thread. A calling worker thread executes other
+// queued pool work while it waits, so fork/join can be nested inside worker tasks without deadlock.
+static void
+thread_pool_fork_join(ThreadPool* thread_pool, U32 task_count, ForkJoinFunc func, void* data);
 
 // main thread queue functions
 static B32
@@ -0,0 +1,452 @@
+namespace async
+{
+
+static U32
+latency_histogram_bucket_from_us(U64 us)
+{
+    if (us < LATENCY_HISTOGRAM_SUB_BUCKET_COUNT)
+    {
+        return (U32)us;
+    }
+    if (us >> LATENCY_HISTOGRAM_MAX_BITS)
+    {
+        return LATENCY_HISTOGRAM_BUCKET_COUNT - 1;
+    }
+    // ~mgj: the top SUB_BUCKET_BITS + 1 bits pick the bucket, the leading one picks the power of two
+    U32 exponent = (U32)msb_index(us) - LATENCY_HISTOGRAM_SUB_BUCKET_BITS;
+    U32 mantissa = (U32)(us >> exponent);
+    return (exponent + 1) * LATENCY_HISTOGRAM_SUB_BUCKET_COUNT + mantissa - LATENCY_HISTOGRAM_SUB_BUCKET_COUNT;
+}
+
+static U64
+latency_histogram_us_from_bucket(U32 bucket_idx)
+{
+    if (bucket_idx < LATENCY_HISTOGRAM_SUB_BUCKET_COUNT)
+    {
+        return bucket_idx;
+    }
+    U32 exponent = bucket_idx / LATENCY_HISTOGRAM_SUB_BUCKET_COUNT - 1;
+    U64 mantissa = LATENCY_HISTOGRAM_SUB_BUCKET_COUNT + bucket_idx % LATENCY_HISTOGRAM_SUB_BUCKET_COUNT;
+    return ((mantissa + 1) << exponent) - 1;
+}
+
+static void
+latency_histogram_record(LatencyHistogram* histogram, U64 us)
+{
+    _thread_pool_stats_counter_add(&histogram->counts[latency_histogram_bucket_from_us(us)], 1);
+    _thread_pool_stats_counter_add(&histogram->total_us, us);
+}
+
+static void
+latency_histogram_record_shared(LatencyHistogram* histogram, U64 us)
+{
+    histogram->counts[latency_histogram_bucket_from_us(us)].fetch_add(1, std::memory_order_relaxed);
+    histogram->total_us.fetch_add(us, std::memory_order_relaxed);
+}
+
+static void
+latency_histogram_merge(LatencyHistogram* dst, LatencyHistogram* src)
+{
+    for (U32 i = 0; i < LATENCY_HISTOGRAM_BUCKET_COUNT; ++i)
+    {
+        _thread_pool_stats_counter_add(&dst->counts[i], src->counts[i].load(std::memory_order_relaxed));
+    }
+    _thread_pool_stats_counter_add(&dst->total_us, src->total_us.load(std::memory_order_relaxed));
+}
+
+static LatencySummary
+latency_histogram_summary(LatencyHistogram* histogram)
+{
+    // ~mgj: copy first so the percentiles agree with each other while the histogram is being written
+    U64 counts[LATENCY_HISTOGRAM_BUCKET_COUNT];
+    LatencySummary result = {};
+    for (U32 i = 0; i < LATENCY_HISTOGRAM_BUCKET_COUNT; ++i)
+    {
+        counts[i] = histogram->counts[i].load(std::memory_order_relaxed);
+        result.count += counts[i];
+    }
+    if (result.count == 0)
+    {
+        return result;
+    }
+    result.mean_us = (F64)histogram->total_us.load(std::memory_order_relaxed) / (F64)result.count;
+
+    U64 p50_rank = (result.count * 50 + 99) / 100;
+    U64 p90_rank = (result.count * 90 + 99) / 100;
+    U64 p99_rank = (result.count * 99 + 99) / 100;
+    U64 cumulative = 0;
+    for (U32 i = 0; i < LATENCY_HISTOGRAM_BUCKET_COUNT; ++i)
+    {
+        if (counts[i] == 0)
+        {
+            continue;
+        }
+        U64 prev_cumulative = cumulative;
+        cumulative += counts[i];
+        U64 bucket_us = latency_histogram_us_from_bucket(i);
+        if (prev_cumulative < p50_rank && cumulative >= p50_rank)
+        {
+            result.p50_us = bucket_us;
+        }
+        if (prev_cumulative < p90_rank && cumulative >= p90_rank)
+        {
+            result.p90_us = bucket_us;
+        }
+        if (prev_cumulative < p99_rank && cumulative >= p99_rank)
+        {
+            result.p99_us = bucket_us;
+        }
+        result.max_us = bucket_us;
+    }
+    return result;
+}
+
+static void
+_thread_pool_stats_counter_add(std::atomic<U64>* counter, U64 value)
+{
+    // ~mgj: single writer, a plain add is enough and keeps the lock prefix out of the worker loop
+    counter->store(counter->load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+static ThreadPoolStats*
+thread_pool_stats_create(U32 worker_count)
+{
+    Arena* arena = arena_alloc();
+    Debug_SetName(arena, "thread pool stats arena");
+    ThreadPoolStats* stats = PushStruct(arena, ThreadPoolStats);
+    stats->arena = arena;
+    stats->workers = buffer_alloc<ThreadPoolWorkerStats>(arena, worker_count);
+    for (U32 i = 0; i < worker_count; ++i)
+    {
+        ThreadPoolWorkerStats* worker = &stats->workers.data[i];
+        worker->plot_depth_name = PushStr8F(arena, "ThreadPool worker %u depth", i);
+        worker->plot_task_name = PushStr8F(arena, "ThreadPool worker %u tasks", i);
+        worker->plot_steal_name = PushStr8F(arena, "ThreadPool worker %u steals", i);
+    }
+    stats->tasks = PushArray(arena, ThreadPoolTaskStats, THREAD_POOL_STATS_TASK_NAME_MAX);
+    stats->tasks[0].name = S("unnamed");
+    stats->task_name_count.store(1);
+    stats->task_name_mutex = OS_MutexAlloc();
+    return stats;
+}
+
+static void
+thread_pool_stats_destroy(ThreadPoolStats* stats)
+{
+    if (stats)
+    {
+        OS_MutexRelease(stats->task_name_mutex);
+        arena_release(stats->arena);
+    }
+}
+
+static U32
+_thread_pool_stats_task_name_find(ThreadPoolStats* stats, String8 name, U32 task_name_count)
+{
+    for (U32 i = 1; i < task_name_count; ++i)
+    {
+        if (str8_match(stats->tasks[i].name, name, 0))
+        {
+            return i;
+        }
+    }
+    return 0;
+}
+
+static U32
+thread_pool_stats_task_name_id(ThreadPool* thread_pool, String8 name)
+{
+    ThreadPoolStats* stats = thread_pool->stats;
+    if (name.size == 0)
+    {
+        return 0;
+    }
+
+    U32 result = _thread_pool_stats_task_name_find(stats, name, stats->task_name_count.load(std::memory_order_acquire));
+    if (result == 0)
+    {
+        os_mutex_scope(stats->task_name_mutex)
+        {
+            U32 task_name_count = stats->task_name_count.load(std::memory_order_relaxed);
+            result = _thread_pool_stats_task_name_find(stats, name, task_name_count);
+            if (result == 0 && task_name_count < THREAD_POOL_STATS_TASK_NAME_MAX)
+            {
+                ThreadPoolTaskStats* task = &stats->tasks[task_name_count];
+                task->name = push_str8_copy(stats->arena, name);
+                task->plot_wait_name = PushStr8F(stats->arena, "ThreadPool wait us: %.*s", str8_varg(name));
+                result = task_name_count;
+                stats->task_name_count.store(task_name_count + 1, std::memory_order_release);
+            }
+        }
+    }
+    return result;
+}
+
+static void
+_thread_pool_stats_task_record(ThreadPool* thread_pool, U32 thread_id, WorkerItem* item, U64 start_us, U64 end_us)
+{
+    ThreadPoolStats* stats = thread_pool->stats;
+    ThreadPoolWorkerStats* worker = &stats->workers.data[thread_id];
+    U64 wait_us = start_us > item->enqueue_us ? start_us - item->enqueue_us : 0;
+    U64 run_us = end_us - start_us;
+    _thread_pool_stats_counter_add(&worker->task_count, 1);
+    _thread_pool_stats_counter_add(&worker->busy_us, run_us);
+    latency_histogram_record(&worker->wait_histogram, wait_us);
+    latency_histogram_record(&worker->run_histogram, run_us);
+    latency_histogram_record(&worker->lane_wait_histograms[item->priority], wait_us);
+
+    // ~mgj: unnamed tasks are mostly fork/join slices, all workers recording into one shared
+    // histogram would bounce its cache lines between every core
+    if (item->name_id != 0)
+    {
+        ThreadPoolTaskStats* task = &stats->tasks[item->name_id];
+        latency_histogram_record_shared(&task->wait_histogram, wait_us);
+        latency_histogram_record_shared(&task->run_histogram, run_us);
+    }
+}
+
+static ThreadPoolStatsSnapshot
+thread_pool_stats_snapshot(Arena* arena, ThreadPool* thread_pool)
+{
+    ThreadPoolStats* stats = thread_pool->stats;
+    ThreadPoolStatsSnapshot result = {};
+    result.timestamp_us = os_now_microseconds();
+    result.pending_task_count = thread_pool->pending_task_count.load();
+    result.in_flight_count = thread_pool->in_flight_count.load();
+    result.parked_count = thread_pool->parked_count.load();
+    result.background_running_count = thread_pool->background_running_count.load();
+    result.timer_fire_count = stats->timer_fire_count.load(std::memory_order_relaxed);
+    result.timer_wake_count = stats->timer_wake_count.load(std::memory_order_relaxed);
+
+    ScratchScope scratch = ScratchScope(&arena, 1);
+    for (U32 priority = ThreadPoolPriority_Interactive; priority < ThreadPoolPriority_Count; ++priority)
+    {
+        LatencyHistogram* wait_histogram = PushStruct(scratch.arena, LatencyHistogram);
+        for (ThreadPoolWorkerStats& worker : stats->workers)
+        {
+            latency_histogram_merge(wait_histogram, &worker.lane_wait_histograms[priority]);
+        }
+        ThreadPoolLaneStatsSnapshot* lane = &result.lanes[priority - ThreadPoolPriority_Interactive];
+        lane->name = str8_c_string(thread_pool_priority_names[priority]);
+        lane->queue_depth = (U32)queue_count(thread_pool->lane_queues[priority]);
+        lane->wait = latency_histogram_summary(wait_histogram);
+    }
+
+    result.workers = buffer_alloc<ThreadPoolWorkerStatsSnapshot>(arena, stats->workers.size);
+    for (U32 i = 0; i < stats->workers.size; ++i)
+    {
+        ThreadPoolWorkerStats* worker = &stats->workers.data[i];
+        ThreadPoolWorkerStatsSnapshot* out = &result.workers.data[i];
+        out->thread_id = i;
+        out->local_queue_depth = (U32)spmc_queue_count(thread_pool->workers.data[i].local_queue);
+        out->is_parked = thread_pool->workers.data[i].is_parked.load(std::memory_order_relaxed);
+        out->task_count = worker->task_count.load(std::memory_order_relaxed);
+        out->local_pop_count = worker->local_pop_count.load(std::memory_order_relaxed);
+        out->inject_pop_count = worker->inject_pop_count.load(std::memory_order_relaxed);
+        out->steal_count = worker->steal_count.load(std::memory_order_relaxed);
+        out->steal_miss_count = worker->steal_miss_count.load(std::memory_order_relaxed);
+        out->park_count = worker->park_count.load(std::memory_order_relaxed);
+        out->wake_count = worker->wake_count.load(std::memory_order_relaxed);
+        out->busy_us = worker->busy_us.load(std::memory_order_relaxed);
+        out->wait = latency_histogram_summary(&worker->wait_histogram);
+        out->run = latency_histogram_summary(&worker->run_histogram);
+    }
+
+    U32 task_name_count = stats->task_name_count.load(std::memory_order_acquire);
+    result.tasks = buffer_alloc<ThreadPoolTaskStatsSnapshot>(arena, task_name_count - 1);
+    for (U32 i = 1; i < task_name_count; ++i)
+    {
+        ThreadPoolTaskStats* task = &stats->tasks[i];
+        ThreadPoolTaskStatsSnapshot* out = &result.tasks.data[i - 1];
+        out->name = push_str8_copy(arena, task->name);
+        out->wait = latency_histogram_summary(&task->wait_histogram);
+        out->run = latency_histogram_summary(&task->run_histogram);
+    }
+    return result;
+}
+
+static void
+_thread_pool_stats_json_summary_push(Arena* arena, String8List* list, const char* key, LatencySummary* summary)
+{
+    Str8ListPushF(arena, list, "\"%s\": {\"count\": %llu, \"mean_us\": %.1f, \"p50_us\": %llu, \"p90_us\": %llu, \"p99_us\": %llu, \"max_us\": %llu}", key,
+                  summary->count, summary->mean_us, summary->p50_us, summary->p90_us, summary->p99_us, summary->max_us);
+}
+
+static String8
+thread_pool_stats_json(Arena* arena, ThreadPoolStatsSnapshot* snapshot)
+{
+    ScratchScope scratch = ScratchScope(&arena, 1);
+    String8List list = {};
+    Str8ListPushF(scratch.arena, &list,
+                  "{\n  \"timestamp_us\": %llu,\n  \"pending_task_count\": %u,\n  \"in_flight_count\": %u,\n  \"parked_count\": %u,\n"
+                  "  \"background_running_count\": %u,\n  \"timer_fire_count\": %llu,\n  \"timer_wake_count\": %llu,\n  \"lanes\": [",
+                  snapshot->timestamp_us, snapshot->pending_task_count, snapshot->in_flight_count, snapshot->parked_count, snapshot->background_running_count,
+                  snapshot->timer_fire_count, snapshot->timer_wake_count);
+    for (U64 i = 0; i < ArrayCount(snapshot->lanes); ++i)
+    {
+        ThreadPoolLaneStatsSnapshot* lane = &snapshot->lanes[i];
+        Str8ListPushF(scratch.arena, &list, "%s\n    {\"name\": \"%.*s\", \"queue_depth\": %u, ", i == 0 ? "" : ",", str8_varg(lane->name), lane->queue_depth);
+        _thread_pool_stats_json_summary_push(scratch.arena, &list, "wait", &lane->wait);
+        str8_list_push(scratch.arena, &list, S("}"));
+    }
+    str8_list_push(scratch.arena, &list, S("\n  ],\n  \"workers\": ["));
+    for (U64 i = 0; i < snapshot->workers.size; ++i)
+    {
+        ThreadPoolWorkerStatsSnapshot* worker = &snapshot->workers.data[i];
+        Str8ListPushF(scratch.arena, &list,
+                      "%s\n    {\"thread_id\": %u, \"local_queue_depth\": %u, \"is_parked\": %s, \"task_count\": %llu, \"local_pop_count\": %llu, "
+                      "\"inject_pop_count\": %llu, \"steal_count\": %llu, \"steal_miss_count\": %llu, \"park_count\": %llu, "
+                      "\"wake_count\": %llu, \"busy_us\": %llu, ",
+                      i == 0 ? "" : ",", worker->thread_id, worker->local_queue_depth, worker->is_parked ? "true" : "false", worker->task_count,
+                      worker->local_pop_count, worker->inject_pop_count, worker->steal_count, worker->steal_miss_count,
+                      worker->park_count, worker->wake_count, worker->busy_us);
+        _thread_pool_stats_json_summary_push(scratch.arena, &list, "wait", &worker->wait);
+        str8_list_push(scratch.arena, &list, S(", "));
+        _thread_pool_stats_json_summary_push(scratch.arena, &list, "run", &worker->run);
+        str8_list_push(scratch.arena, &list, S("}"));
+    }
+    str8_list_push(scratch.arena, &list, S("\n  ],\n  \"tasks\": ["));
+    for (U64 i = 0; i < snapshot->tasks.size; ++i)
+    {
+        ThreadPoolTaskStatsSnapshot* task = &snapshot->tasks.data[i];
+        String8 name = escaped_from_raw_str8(scratch.arena, task->name);
+        Str8ListPushF(scratch.arena, &list, "%s\n    {\"name\": \"%.*s\", ", i == 0 ? "" : ",", str8_varg(name));
+        _thread_pool_stats_json_summary_push(scratch.arena, &list, "wait", &task->wait);
+        str8_list_push(scratch.arena, &list, S(", "));
+        _thread_pool_stats_json_summary_push(scratch.arena, &list, "run", &task->run);
+        str8_list_push(scratch.arena, &list, S("}"));
+    }
+    str8_list_push(scratch.arena, &list, S("\n  ]\n}\n"));
+    return str8_list_join(arena, &list, 0);
+}
+
+static void
+_thread_pool_stats_csv_summary_push(Arena* arena, String8List* list, LatencySummary* summary)
+{
+    Str8ListPushF(arena, list, ",%llu,%.1f,%llu,%llu,%llu,%llu", summary->count, summary->mean_us, summary->p50_us, summary->p90_us, summary->p99_us,
+                  summary->max_us);
+}
+
+static String8
+thread_pool_stats_csv(Arena* arena, ThreadPoolStatsSnapshot* snapshot)
+{
+    ScratchScope scratch = ScratchScope(&arena, 1);
+    String8List list = {};
+    // ~mgj: one row per lane, worker and task name, columns that do not apply are empty. queue_depth is
+    // the lane queue on lane rows and the local deque on worker rows.
+    str8_list_push(scratch.arena, &list,
+                   S("timestamp_us,scope,id,name,queue_depth,is_parked,task_count,local_pop_count,inject_pop_count,steal_count,"
+                     "steal_miss_count,park_count,wake_count,busy_us,"
+                     "wait_count,wait_mean_us,wait_p50_us,wait_p90_us,wait_p99_us,wait_max_us,"
+                     "run_count,run_mean_us,run_p50_us,run_p90_us,run_p99_us,run_max_us\n"));
+    for (U64 i = 0; i < ArrayCount(snapshot->lanes); ++i)
+    {
+        ThreadPoolLaneStatsSnapshot* lane = &snapshot->lanes[i];
+        Str8ListPushF(scratch.arena, &list, "%llu,lane,%llu,%.*s,%u,,,,,,,,,", snapshot->timestamp_us, i + ThreadPoolPriority_Interactive, str8_varg(lane->name),
+                      lane->queue_depth);
+        _thread_pool_stats_csv_summary_push(scratch.arena, &list, &lane->wait);
+        str8_list_push(scratch.arena, &list, S(",,,,,,\n"));
+    }
+    for (U64 i = 0; i < snapshot->workers.size; ++i)
+    {
+        ThreadPoolWorkerStatsSnapshot* worker = &snapshot->workers.data[i];
+        Str8ListPushF(scratch.arena, &list, "%llu,worker,%u,,%u,%u,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu", snapshot->timestamp_us, worker->thread_id,
+                      worker->local_queue_depth, worker->is_parked ? 1 : 0, worker->task_count, worker->local_pop_count, worker->inject_pop_count,
+                      worker->steal_count, worker->steal_miss_count, worker->park_count, worker->wake_count, worker->busy_us);
+        _thread_pool_stats_csv_summary_push(scratch.arena, &list, &worker->wait);
+        _thread_pool_stats_csv_summary_push(scratch.arena, &list, &worker->run);
+        str8_list_push(scratch.arena, &list, S("\n"));
+    }
+    for (U64 i = 0; i < snapshot->tasks.size; ++i)
+    {
+        ThreadPoolTaskStatsSnapshot* task = &snapshot->tasks.data[i];
+        // ~mgj: quoted field, quotes inside are doubled
+        Str8ListPushF(scratch.arena, &list, "%llu,task,%llu,\"", snapshot->timestamp_us, i + 1);
+        U64 run_start = 0;
+        for (U64 char_idx = 0; char_idx <= task->name.size; ++char_idx)
+        {
+            if (char_idx == task->name.size || task->name.str[char_idx] == '"')
+            {
+                str8_list_push(scratch.arena, &list, str8(task->name.str + run_start, char_idx - run_start));
+                if (char_idx < task->name.size)
+                {
+                    str8_list_push(scratch.arena, &list, S("\"\""));
+                }
+                run_start = char_idx + 1;
+            }
+        }
+        str8_list_push(scratch.arena, &list, S("\",,,,,,,,,,"));
+        _thread_pool_stats_csv_summary_push(scratch.arena, &list, &task->wait);
+        _thread_pool_stats_csv_summary_push(scratch.arena, &list, &task->run);
+        str8_list_push(scratch.arena, &list, S("\n"));
+    }
+    return str8_list_join(arena, &list, 0);
+}
+
+static B32
+thread_pool_stats_dump(ThreadPool* thread_pool, String8 path, ThreadPoolStatsFormat format)
+{
+    ScratchScope scratch = ScratchScope(0, 0);
+    ThreadPoolStatsSnapshot snapshot = thread_pool_stats_snapshot(scratch.arena, thread_pool);
+    String8 content = format == ThreadPoolStatsFormat_Csv ? thread_pool_stats_csv(scratch.arena, &snapshot) : thread_pool_stats_json(scratch.arena, &snapshot);
+    if (!os_make_parent_directory_if_missing(path))
+    {
+        ERROR_LOG("thread_pool_stats_dump: could not create the directory of %.*s", str8_varg(path));
+        return false;
+    }
+    B32 is_written = os_write_data_to_file_path(path, content);
+    if (!is_written)
+    {
+        ERROR_LOG("thread_pool_stats_dump: could not write %.*s", str8_varg(path));
+    }
+    return is_written;
+}
+
+static void
+thread_pool_stats_plot(ThreadPool* thread_pool)
+{
+#if defined(TRACY_PROFILE_ENABLE)
+    ThreadPoolStats* stats = thread_pool->stats;
+    prof_plot("ThreadPool pending", (S64)thread_pool->pending_task_count.load());
+    prof_plot("ThreadPool in flight", (S64)thread_pool->in_flight_count.load());
+    prof_plot("ThreadPool interactive depth", (S64)queue_count(thread_pool->lane_queues[ThreadPoolPriority_Interactive]));
+    prof_plot("ThreadPool streaming depth", (S64)queue_count(thread_pool->lane_queues[ThreadPoolPriority_Streaming]));
+    prof_plot("ThreadPool background depth", (S64)queue_count(thread_pool->lane_queues[ThreadPoolPriority_Background]));
+    prof_plot("ThreadPool background running", (S64)thread_pool->background_running_count.load());
+    prof_plot("ThreadPool parked", (S64)thread_pool->parked_count.load());
+    for (U32 i = 0; i < stats->workers.size; ++i)
+    {
+        ThreadPoolWorkerStats* worker = &stats->workers.data[i];
+        U64 task_count = worker->task_count.load(std::memory_order_relaxed);
+        U64 steal_count = worker->steal_count.load(std::memory_order_relaxed);
+        prof_plot((const char*)worker->plot_depth_name.str, (S64)spmc_queue_count(thread_pool->workers.data[i].local_queue));
+        prof_plot((const char*)worker->plot_task_name.str, (S64)(task_count - worker->plot_prev_task_count));
+        prof_plot((const char*)worker->plot_steal_name.str, (S64)(steal_count - worker->plot_prev_steal_count));
+        worker->plot_prev_task_count = task_count;
+        worker->plot_prev_steal_count = steal_count;
+    }
+
+    // ~mgj: mean wait of the tasks that started since the last call, names without any are skipped
+    U32 task_name_count = stats->task_name_count.load(std::memory_order_acquire);
+    for (U32 i = 1; i < task_name_count; ++i)
+    {
+        ThreadPoolTaskStats* task = &stats->tasks[i];
+        U64 count = 0;
+        for (std::atomic<U64>& bucket_count : task->wait_histogram.counts)
+        {
+            count += bucket_count.load(std::memory_order_relaxed);
+        }
+        U64 wait_us = task->wait_histogram.total_us.load(std::memory_order_relaxed);
+        if (count > task->plot_prev_count)
+        {
+            prof_plot((const char*)task->plot_wait_name.str, (F64)(wait_us - task->plot_prev_wait_us) / (F64)(count - task->plot_prev_count));
+        }
+        task->plot_prev_count = count;
+        task->plot_prev_wait_us = wait_us;
+    }
+#else
+    (void)thread_pool;
+#endif
+}
+
+} // namespace async
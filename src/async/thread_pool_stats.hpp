@@ -0,0 +1,184 @@
+#pragma once
+
+namespace async
+{
+
+// ~mgj: Log-linear latency histogram in microseconds, HDR style. Values below
+// LATENCY_HISTOGRAM_SUB_BUCKET_COUNT get a bucket each, above that every power of two is split into
+// LATENCY_HISTOGRAM_SUB_BUCKET_COUNT buckets, so a bucket is never wider than 1/8th of its values.
+// Values of 2^LATENCY_HISTOGRAM_MAX_BITS us (~71 minutes) and up land in the last bucket.
+//
+// latency_histogram_record is for a single writer (relaxed load and store, no locked instructions),
+// latency_histogram_record_shared for several. Any thread can read while it is written.
+static constexpr U32 LATENCY_HISTOGRAM_SUB_BUCKET_BITS = 3;
+static constexpr U32 LATENCY_HISTOGRAM_SUB_BUCKET_COUNT = 1u << LATENCY_HISTOGRAM_SUB_BUCKET_BITS;
+static constexpr U32 LATENCY_HISTOGRAM_MAX_BITS = 32;
+static constexpr U32 LATENCY_HISTOGRAM_BUCKET_COUNT = (LATENCY_HISTOGRAM_MAX_BITS - LATENCY_HISTOGRAM_SUB_BUCKET_BITS + 1) * LATENCY_HISTOGRAM_SUB_BUCKET_COUNT;
+
+struct LatencyHistogram
+{
+    std::atomic<U64> total_us;
+    std::atomic<U64> counts[LATENCY_HISTOGRAM_BUCKET_COUNT];
+};
+
+struct LatencySummary
+{
+    U64 count;
+    F64 mean_us;
+    // ~mgj: percentiles and max are the upper bound of their bucket
+    U64 p50_us;
+    U64 p90_us;
+    U64 p99_us;
+    U64 max_us;
+};
+
+// ~mgj: Thread pool instrumentation. Workers count where their work came from, how often they park
+// and get woken, and record queue wait (push to start) and run time per task into per-worker
+// histograms. Tasks pushed with a name id (async_task_run and task graph nodes do this) are also
+// recorded per name, continuations inherit the id of the task that returned them. Delayed tasks count
+// their wait from when the timer fires. Queue wait is also recorded per lane (ThreadPoolPriority).
+const U32 THREAD_POOL_STATS_TASK_NAME_MAX = 64;
+
+enum ThreadPoolStatsFormat
+{
+    ThreadPoolStatsFormat_Json,
+    ThreadPoolStatsFormat_Csv,
+};
+
+struct alignas(64) ThreadPoolWorkerStats
+{
+    // written by the owning worker only
+    std::atomic<U64> task_count;
+    std::atomic<U64> local_pop_count;
+    std::atomic<U64> inject_pop_count; // lane queues, ring and overflow list
+    std::atomic<U64> steal_count;
+    std::atomic<U64> steal_miss_count; // victim scans that came back empty
+    std::atomic<U64> park_count;
+    std::atomic<U64> wake_count; // parks ended by a push
+    std::atomic<U64> busy_us;
+    LatencyHistogram wait_histogram;
+    LatencyHistogram run_histogram;
+    LatencyHistogram lane_wait_histograms[ThreadPoolPriority_Count];
+
+    // thread_pool_stats_plot state
+    String8 plot_depth_name;
+    String8 plot_task_name;
+    String8 plot_steal_name;
+    U64 plot_prev_task_count;
+    U64 plot_prev_steal_count;
+};
+
+struct ThreadPoolTaskStats
+{
+    String8 name;
+    LatencyHistogram wait_histogram;
+    LatencyHistogram run_histogram;
+
+    // thread_pool_stats_plot state
+    String8 plot_wait_name;
+    U64 plot_prev_count;
+    U64 plot_prev_wait_us;
+};
+
+struct ThreadPoolStats
+{
+    Arena* arena;
+    Buffer<ThreadPoolWorkerStats> workers;
+    std::atomic<U64> timer_fire_count; // written by the timer thread only
+    std::atomic<U64> timer_wake_count; // timer thread loop iterations, written by the timer thread only
+
+    // name id 0 is unnamed and not recorded per name, that is also where names past the table end up
+    ThreadPoolTaskStats* tasks;
+    std::atomic<U32> task_name_count;
+    OS_Handle task_name_mutex;
+};
+
+struct ThreadPoolWorkerStatsSnapshot
+{
+    U32 thread_id;
+    U32 local_queue_depth;
+    B32 is_parked;
+    U64 task_count;
+    U64 local_pop_count;
+    U64 inject_pop_count;
+    U64 steal_count;
+    U64 steal_miss_count;
+    U64 park_count;
+    U64 wake_count;
+    U64 busy_us;
+    LatencySummary wait;
+    LatencySummary run;
+};
+
+struct ThreadPoolLaneStatsSnapshot
+{
+    String8 name;
+    U32 queue_depth; // ring and overflow list
+    LatencySummary wait;
+};
+
+struct ThreadPoolTaskStatsSnapshot
+{
+    String8 name;
+    LatencySummary wait;
+    LatencySummary run;
+};
+
+struct ThreadPoolStatsSnapshot
+{
+    U64 timestamp_us;
+    U32 pending_task_count;
+    U32 in_flight_count;
+    U32 parked_count;
+    U32 background_running_count;
+    U64 timer_fire_count;
+    U64 timer_wake_count;
+    // ~mgj: one per lane from ThreadPoolPriority_Interactive on, wait merged over all workers
+    ThreadPoolLaneStatsSnapshot lanes[ThreadPoolPriority_Count - 1];
+    Buffer<ThreadPoolWorkerStatsSnapshot> workers;
+    Buffer<ThreadPoolTaskStatsSnapshot> tasks;
+};
+
+static U32
+latency_histogram_bucket_from_us(U64 us);
+// ~mgj: largest value that falls into bucket_idx
+static U64
+latency_histogram_us_from_bucket(U32 bucket_idx);
+static void
+latency_histogram_record(LatencyHistogram* histogram, U64 us);
+static void
+latency_histogram_record_shared(LatencyHistogram* histogram, U64 us);
+static LatencySummary
+latency_histogram_summary(LatencyHistogram* histogram);
+// ~mgj: adds src into dst, dst must not be written by anyone else
+static void
+latency_histogram_merge(LatencyHistogram* dst, LatencyHistogram* src);
+
+static ThreadPoolStats*
+thread_pool_stats_create(U32 worker_count);
+static void
+thread_pool_stats_destroy(ThreadPoolStats* stats);
+// ~mgj: Id to put in WorkerItem::name_id. Known names are found without locking; a new name takes the
+// table lock once. Returns 0 when the table is full.
+static U32
+thread_pool_stats_task_name_id(ThreadPool* thread_pool, String8 name);
+static ThreadPoolStatsSnapshot
+thread_pool_stats_snapshot(Arena* arena, ThreadPool* thread_pool);
+static String8
+thread_pool_stats_json(Arena* arena, ThreadPoolStatsSnapshot* snapshot);
+static String8
+thread_pool_stats_csv(Arena* arena, ThreadPoolStatsSnapshot* snapshot);
+static B32
+thread_pool_stats_dump(ThreadPool* thread_pool, String8 path, ThreadPoolStatsFormat format);
+// ~mgj: Sends queue depths, per-worker throughput and per-name mean queue wait since the previous call
+// to Tracy. Call once per frame from one thread. Does nothing without TRACY_PROFILE_ENABLE.
+static void
+thread_pool_stats_plot(ThreadPool* thread_pool);
+
+// ~mgj: internal
+static void
+_thread_pool_stats_task_record(ThreadPool* thread_pool, U32 thread_id, WorkerItem* item, U64 start_us, U64 end_us);
+static void
+_thread_pool_stats_counter_add(std::atomic<U64>* counter, U64 value);
+
+} // namespace async
@@ -0,0 +1,186 @@
+namespace async
+{
+
+template <typename T>
+static TimerWheel<T>*
+timer_wheel_alloc(U64 tick_us, U64 now_us)
+{
+    AssertAlways(tick_us > 0);
+    Arena* arena = arena_alloc();
+    Debug_SetName(arena, "timer wheel arena");
+    TimerWheel<T>* wheel = PushStruct(arena, TimerWheel<T>);
+    wheel->arena = arena;
+    wheel->tick_us = tick_us;
+    wheel->cur_tick = now_us / tick_us;
+    return wheel;
+}
+
+template <typename T>
+static void
+timer_wheel_release(TimerWheel<T>* wheel)
+{
+    if (wheel)
+    {
+        arena_release(wheel->arena);
+    }
+}
+
+template <typename T>
+static void
+_timer_wheel_place(TimerWheel<T>* wheel, TimerWheelEntry<T>* entry)
+{
+    U64 deadline_tick = Max(entry->deadline_tick, wheel->cur_tick);
+    U64 delta = deadline_tick - wheel->cur_tick;
+    U32 level = 0;
+    while (level + 1 < TIMER_WHEEL_LEVEL_COUNT && delta >> (TIMER_WHEEL_SLOT_BITS * (level + 1)))
+    {
+        level += 1;
+    }
+    if (delta >> (TIMER_WHEEL_SLOT_BITS * TIMER_WHEEL_LEVEL_COUNT))
+    {
+        // ~mgj: beyond the top level, wait in its furthest slot and get re-placed from there
+        deadline_tick = wheel->cur_tick + (1ull << (TIMER_WHEEL_SLOT_BITS * TIMER_WHEEL_LEVEL_COUNT)) - 1;
+    }
+
+    U32 slot_idx = (U32)(deadline_tick >> (TIMER_WHEEL_SLOT_BITS * level)) & (TIMER_WHEEL_SLOT_COUNT - 1);
+    TimerWheelSlot<T>* slot = &wheel->slots[level][slot_idx];
+    entry->next = 0;
+    SLLQueuePush(slot->first, slot->last, entry);
+    wheel->occupied[level] |= 1ull << slot_idx;
+}
+
+template <typename T>
+static void
+timer_wheel_insert(TimerWheel<T>* wheel, T* value, U64 deadline_us)
+{
+    TimerWheelEntry<T>* entry = wheel->free_first;
+    if (entry)
+    {
+        SLLStackPop(wheel->free_first);
+    }
+    else
+    {
+        entry = PushStructNoZero(wheel->arena, TimerWheelEntry<T>);
+    }
+    // ~mgj: rounded up, an entry never fires before its deadline
+    entry->deadline_tick = deadline_us / wheel->tick_us + (deadline_us % wheel->tick_us != 0);
+    entry->value = *value;
+    _timer_wheel_place(wheel, entry);
+    wheel->count += 1;
+}
+
+template <typename T>
+static U64
+_timer_wheel_next_tick(TimerWheel<T>* wheel)
+{
+    U64 result = max_U64;
+    for (U32 level = 0; level < TIMER_WHEEL_LEVEL_COUNT; ++level)
+    {
+        U64 occupied = wheel->occupied[level];
+        if (occupied == 0)
+        {
+            continue;
+        }
+        // ~mgj: the slot of the current block only holds entries of the next lap, unless the wheel stands
+        // at the start of the block and has not cascaded it yet
+        U32 shift = TIMER_WHEEL_SLOT_BITS * level;
+        U64 block = wheel->cur_tick >> shift;
+        U32 start = (level == 0 || (wheel->cur_tick & ((1ull << shift) - 1)) == 0) ? 0 : 1;
+        U32 rotate = (U32)(block + start) & (TIMER_WHEEL_SLOT_COUNT - 1);
+        U64 rotated = rotate ? (occupied >> rotate) | (occupied << (64 - rotate)) : occupied;
+        U64 offset = start + ctz64(rotated);
+        U64 tick = level == 0 ? wheel->cur_tick + offset : (block + offset) << shift;
+        result = Min(result, tick);
+    }
+    return result;
+}
+
+template <typename T>
+static void
+_timer_wheel_tick_process(TimerWheel<T>* wheel)
+{
+    U64 tick = wheel->cur_tick;
+
+    // ~mgj: cascade top down, an upper level may drop entries into the lower slot cascaded right after
+    U32 top_level = 0;
+    while (top_level + 1 < TIMER_WHEEL_LEVEL_COUNT && (tick & ((1ull << (TIMER_WHEEL_SLOT_BITS * (top_level + 1))) - 1)) == 0)
+    {
+        top_level += 1;
+    }
+    for (U32 level = top_level; level > 0; --level)
+    {
+        U32 slot_idx = (U32)(tick >> (TIMER_WHEEL_SLOT_BITS * level)) & (TIMER_WHEEL_SLOT_COUNT - 1);
+        TimerWheelSlot<T>* slot = &wheel->slots[level][slot_idx];
+        TimerWheelEntry<T>* entry = slot->first;
+        *slot = {};
+        wheel->occupied[level] &= ~(1ull << slot_idx);
+        while (entry)
+        {
+            TimerWheelEntry<T>* next = entry->next;
+            _timer_wheel_place(wheel, entry);
+            entry = next;
+        }
+    }
+
+    U32 slot_idx = (U32)tick & (TIMER_WHEEL_SLOT_COUNT - 1);
+    TimerWheelSlot<T>* slot = &wheel->slots[0][slot_idx];
+    if (slot->first)
+    {
+        if (wheel->due.last)
+        {
+            wheel->due.last->next = slot->first;
+        }
+        else
+        {
+            wheel->due.first = slot->first;
+        }
+        wheel->due.last = slot->last;
+        *slot = {};
+        wheel->occupied[0] &= ~(1ull << slot_idx);
+    }
+    wheel->cur_tick = tick + 1;
+}
+
+template <typename T>
+static B32
+timer_wheel_pop_due(TimerWheel<T>* wheel, U64 now_us, T* out_value)
+{
+    U64 now_tick = now_us / wheel->tick_us;
+    while (!wheel->due.first && wheel->cur_tick <= now_tick)
+    {
+        // ~mgj: skip the ticks where nothing fires or cascades
+        U64 next_tick = _timer_wheel_next_tick(wheel);
+        if (next_tick > now_tick)
+        {
+            wheel->cur_tick = now_tick;
+            break;
+        }
+        wheel->cur_tick = next_tick;
+        _timer_wheel_tick_process(wheel);
+    }
+
+    TimerWheelEntry<T>* entry = wheel->due.first;
+    if (!entry)
+    {
+        return false;
+    }
+    SLLQueuePop(wheel->due.first, wheel->due.last);
+    *out_value = entry->value;
+    SLLStackPush(wheel->free_first, entry);
+    wheel->count -= 1;
+    return true;
+}
+
+template <typename T>
+static U64
+timer_wheel_next_us(TimerWheel<T>* wheel)
+{
+    if (wheel->due.first)
+    {
+        return 0;
+    }
+    U64 next_tick = _timer_wheel_next_tick(wheel);
+    return next_tick == max_U64 ? max_U64 : next_tick * wheel->tick_us;
+}
+
+} // namespace async
@@ -0,0 +1,74 @@
+#pragma once
+
+namespace async
+{
+
+// ~mgj: Hierarchical timer wheel. Time is counted in ticks of tick_us. Level l has
+// TIMER_WHEEL_SLOT_COUNT slots of 64^l ticks each: an entry due within 64 ticks sits in level 0 at its
+// own tick, one due within 64^2 ticks in the level 1 slot of its 64 tick block, and so on. When the
+// wheel reaches the start of a block the block's slot is cascaded one or more levels down, so every
+// entry is moved at most TIMER_WHEEL_LEVEL_COUNT - 1 times and insert and fire are O(1). Entries further
+// out than the top level are parked in its last slot and re-placed when it cascades.
+//
+// Not thread safe: one owner thread inserts and advances. Entries fire at the first tick boundary at
+// or after their deadline, never early.
+static constexpr U32 TIMER_WHEEL_SLOT_BITS = 6;
+static constexpr U32 TIMER_WHEEL_SLOT_COUNT = 1u << TIMER_WHEEL_SLOT_BITS;
+static constexpr U32 TIMER_WHEEL_LEVEL_COUNT = 4;
+
+template <typename T> struct TimerWheelEntry
+{
+    TimerWheelEntry<T>* next;
+    U64 deadline_tick;
+    T value;
+};
+
+template <typename T> struct TimerWheelSlot
+{
+    TimerWheelEntry<T>* first;
+    TimerWheelEntry<T>* last;
+};
+
+template <typename T> struct TimerWheel
+{
+    Arena* arena;
+    U64 tick_us;
+    U64 cur_tick; // the next tick to fire, everything before it has fired
+    U64 count;    // entries in the slots and the due list
+    U64 occupied[TIMER_WHEEL_LEVEL_COUNT]; // bit per non-empty slot
+    TimerWheelSlot<T> slots[TIMER_WHEEL_LEVEL_COUNT][TIMER_WHEEL_SLOT_COUNT];
+    TimerWheelSlot<T> due; // fired, not popped yet
+    TimerWheelEntry<T>* free_first;
+};
+
+template <typename T>
+static TimerWheel<T>*
+timer_wheel_alloc(U64 tick_us, U64 now_us);
+template <typename T>
+static void
+timer_wheel_release(TimerWheel<T>* wheel);
+template <typename T>
+static void
+timer_wheel_insert(TimerWheel<T>* wheel, T* value, U64 deadline_us);
+// ~mgj: advances the wheel to now_us and returns the due entries one per call, false when none are left
+template <typename T>
+static B32
+timer_wheel_pop_due(TimerWheel<T>* wheel, U64 now_us, T* out_value);
+// ~mgj: time of the next tick that fires or cascades something, max_U64 when the wheel is empty. Waking
+// up then and calling timer_wheel_pop_due is enough to fire every entry on time.
+template <typename T>
+static U64
+timer_wheel_next_us(TimerWheel<T>* wheel);
+
+// ~mgj: internal
+template <typename T>
+static void
+_timer_wheel_place(TimerWheel<T>* wheel, TimerWheelEntry<T>* entry);
+template <typename T>
+static U64
+_timer_wheel_next_tick(TimerWheel<T>* wheel);
+template <typename T>
+static void
+_timer_wheel_tick_process(TimerWheel<T>* wheel);
+
+} // namespace async
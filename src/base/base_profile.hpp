@@ -7,10 +7,12 @@
 #define prof_scope_marker ZoneScoped
 #define prof_scope_marker_named(n) ZoneScopedN(n)
 #define prof_frame_marker FrameMark;
+#define prof_plot(name, value) TracyPlot(name, value)
 #else
 #define prof_scope_marker
 #define prof_scope_marker_named(n)
 #define prof_frame_marker ;
+#define prof_plot(name, value)
 #endif
 
 lib_internal U64
@@ -156,3 +156,25 @@ cache_read(Arena* arena, String8 cache_file, String8 hash_input)
     Result<String8> res = {str, !read_from_cache};
     return res;
 }
+
+lib_internal B32
+cache_is_valid(String8 cache_file, String8 hash_input)
+{
+    ScratchScope scratch = ScratchScope(0, 0);
+    String8 cache_meta_file = str8_concat(scratch.arena, cache_file, S(".meta"));
+    B32 is_valid = os_file_path_exists(cache_file) && os_file_path_exists(cache_meta_file);
+    return is_valid && !cache_needs_update(hash_input, cache_meta_file);
+}
+
+lib_internal U64
+cache_meta_hash(String8 cache_file)
+{
+    ScratchScope scratch = ScratchScope(0, 0);
+    String8 cache_meta_file = str8_concat(scratch.arena, cache_file, S(".meta"));
+    String8 meta_str = os_data_from_file_path(scratch.arena, cache_meta_file);
+    if (meta_str.size == 0)
+    {
+        return 0;
+    }
+    return _hash_u64_from_str8(meta_str);
+}
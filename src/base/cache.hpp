@@ -11,3 +11,11 @@ cache_write(String8 cache_file, String8 content, String8 hash_content);
 
 g_internal Result<String8>
 cache_read(Arena* arena, String8 cache_file, String8 hash_input);
+
+// ~mgj: same check as cache_read without reading the cached data
+g_internal B32
+cache_is_valid(String8 cache_file, String8 hash_input);
+
+// ~mgj: hash of the .meta file content, changes whenever cache_write rewrites cache_file. 0 if there is no meta file
+g_internal U64
+cache_meta_hash(String8 cache_file);
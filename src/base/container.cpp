@@ -225,14 +225,11 @@ str8_from_chunk_list(Arena* arena, ChunkList<U8>* list)
     }
     return buffer;
 }
-// Linked List Map
+// Swiss Table Map
 lib_internal inline U64
 map_hash_u64(U64 x)
 {
-    prof_scope_marker;
-    String8 str = {.str = (U8*)&x, .size = sizeof(U64)};
-    U64 res = hash_u128_from_str8(str).u64[1];
-    return res;
+    return hash_index_hash_u64(x);
 }
 
 lib_internal inline U64
@@ -250,6 +247,108 @@ map_round_up_pow2_u64(U64 v)
     return v + 1;
 }
 
+template <typename K>
+lib_internal inline U64
+_map_hash_from_key(K key)
+{
+    U64 key_u64 = 0;
+    MemoryCopy(&key_u64, &key, sizeof(K));
+    return map_hash_u64(key_u64);
+}
+
+lib_internal inline U32
+_map_group_match(U8* ctrl, U8 h2)
+{
+    __m128i group = _mm_loadu_si128((__m128i*)ctrl);
+    return (U32)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)h2)));
+}
+
+lib_internal inline U32
+_map_group_match_empty(U8* ctrl)
+{
+    // ~mgj: only MAP_CTRL_EMPTY has the high bit set
+    __m128i group = _mm_loadu_si128((__m128i*)ctrl);
+    return (U32)_mm_movemask_epi8(group);
+}
+
+template <typename K, typename V>
+lib_internal void
+_map_alloc(Map<K, V>* m, U64 capacity)
+{
+    Assert(IsPow2(capacity) && capacity >= MAP_GROUP_SIZE);
+    m->ctrl = PushArrayNoZero(m->arena, U8, capacity);
+    using MapItemType = MapItem<K, V>;
+    m->slots = PushArrayNoZero(m->arena, MapItemType, capacity);
+    m->capacity = capacity;
+    m->count = 0;
+    MemorySet(m->ctrl, MAP_CTRL_EMPTY, capacity);
+}
+
+template <typename K, typename V>
+lib_internal U64
+_map_group_mask(Map<K, V>* m)
+{
+    return m->capacity / MAP_GROUP_SIZE - 1;
+}
+
+// ~mgj: Returns the slot index of key, or the first empty slot on its probe sequence when missing
+template <typename K, typename V>
+lib_internal U64
+_map_slot_find(Map<K, V>* m, K key, U64 hash, B32* out_found)
+{
+    U8 h2 = (U8)(hash & 0x7f);
+    U64 group_mask = _map_group_mask(m);
+    U64 group_idx = (hash >> 7) & group_mask;
+    for (;;)
+    {
+        U64 group_base = group_idx * MAP_GROUP_SIZE;
+        U8* ctrl = m->ctrl + group_base;
+        for (U32 match = _map_group_match(ctrl, h2); match; match &= match - 1)
+        {
+            U64 slot = group_base + ctz32(match);
+            if (m->slots[slot].key == key)
+            {
+                *out_found = true;
+                return slot;
+            }
+        }
+        U32 empty = _map_group_match_empty(ctrl);
+        if (empty)
+        {
+            *out_found = false;
+            return group_base + ctz32(empty);
+        }
+        group_idx = (group_idx + 1) & group_mask;
+    }
+}
+
+template <typename K, typename V>
+lib_internal void
+_map_grow(Map<K, V>* m, U64 new_capacity)
+{
+    prof_scope_marker;
+    U8* old_ctrl = m->ctrl;
+    MapItem<K, V>* old_slots = m->slots;
+    U64 old_capacity = m->capacity;
+    U64 old_count = m->count;
+
+    // ~mgj: the old arrays stay in the arena until it is released
+    _map_alloc(m, new_capacity);
+    for (U64 i = 0; i < old_capacity; ++i)
+    {
+        if (old_ctrl[i] & MAP_CTRL_EMPTY)
+        {
+            continue;
+        }
+        U64 hash = _map_hash_from_key(old_slots[i].key);
+        B32 found;
+        U64 slot = _map_slot_find(m, old_slots[i].key, hash, &found);
+        m->ctrl[slot] = old_ctrl[i];
+        m->slots[slot] = old_slots[i];
+    }
+    m->count = old_count;
+}
+
 template <typename K, typename V>
 lib_internal Map<K, V>*
 map_create(Arena* arena, U64 capacity)
@@ -257,10 +356,9 @@ map_create(Arena* arena, U64 capacity)
     using MapType = Map<K, V>;
     Map<K, V>* map = PushStruct(arena, MapType);
     map->arena = arena;
-    U64 actual_cap = map_round_up_pow2_u64(capacity);
-    using MapKeyValuePairList = MapChunkList<K, V>;
-    map->v = PushArray(arena, MapKeyValuePairList, actual_cap);
-    map->capacity = actual_cap;
+    // ~mgj: max load factor 7/8
+    U64 actual_cap = Max(MAP_GROUP_SIZE, map_round_up_pow2_u64(capacity + capacity / 7 + 1));
+    _map_alloc(map, actual_cap);
     return map;
 }
 
@@ -268,20 +366,9 @@ template <typename K, typename V>
 lib_internal V*
 map_get(Map<K, V>* m, K key)
 {
-    U64 hash = map_hash_u64(key);
-    U64 index = hash % m->capacity;
-    MapChunkList<K, V>* chunk_list = &m->v[index];
-    MapChunk<K, V>* chunk = chunk_list->first;
-    while (chunk)
-    {
-        for (U64 i = 0; i < chunk->count; ++i)
-        {
-            if (chunk->v[i].key == key)
-                return &chunk->v[i].value;
-        }
-        chunk = chunk->next;
-    }
-    return nullptr;
+    B32 found;
+    U64 slot = _map_slot_find(m, key, _map_hash_from_key(key), &found);
+    return found ? &m->slots[slot].value : nullptr;
 }
 
 template <typename K, typename V>
@@ -303,36 +390,253 @@ template <typename K, typename V>
 lib_internal V*
 map_insert(Map<K, V>* m, K key, V& value)
 {
-    using KeyPair = MapChunk<K, V>;
+    U64 hash = _map_hash_from_key(key);
+    B32 found;
+    U64 slot = _map_slot_find(m, key, hash, &found);
+    if (found)
+    {
+        return nullptr;
+    }
+
+    if ((m->count + 1) * 8 > m->capacity * 7)
+    {
+        _map_grow(m, m->capacity * 2);
+        slot = _map_slot_find(m, key, hash, &found);
+    }
+
+    m->ctrl[slot] = (U8)(hash & 0x7f);
+    m->slots[slot].key = key;
+    m->slots[slot].value = value;
+    m->count += 1;
+    return &m->slots[slot].value;
+}
+
+template <typename K, typename V>
+lib_internal B32
+map_remove(Map<K, V>* m, K key)
+{
+    B32 found;
+    U64 hole = _map_slot_find(m, key, _map_hash_from_key(key), &found);
+    if (!found)
+    {
+        return false;
+    }
+
+    // ~mgj: Backward shift. Invariant: every group between an entry's home group and the group it
+    // lives in is full. Entries in later groups whose probe path crosses the hole are moved into it
+    // until a group that already had an empty slot is reached, since no probe path crosses that.
+    U64 group_mask = _map_group_mask(m);
+    U64 hole_group = hole / MAP_GROUP_SIZE;
+    B32 had_empty = _map_group_match_empty(m->ctrl + hole_group * MAP_GROUP_SIZE) != 0;
+    m->ctrl[hole] = MAP_CTRL_EMPTY;
+    m->count -= 1;
+
+    for (U64 group_idx = (hole_group + 1) & group_mask; !had_empty && group_idx != hole_group; group_idx = (group_idx + 1) & group_mask)
+    {
+        U64 group_base = group_idx * MAP_GROUP_SIZE;
+        U8* ctrl = m->ctrl + group_base;
+        had_empty = _map_group_match_empty(ctrl) != 0;
+        for (U32 full = ~_map_group_match_empty(ctrl) & 0xffff; full; full &= full - 1)
+        {
+            U64 slot = group_base + ctz32(full);
+            U64 home_group = (_map_hash_from_key(m->slots[slot].key) >> 7) & group_mask;
+            if (((hole_group - home_group) & group_mask) < ((group_idx - home_group) & group_mask))
+            {
+                m->ctrl[hole] = ctrl[slot - group_base];
+                m->slots[hole] = m->slots[slot];
+                ctrl[slot - group_base] = MAP_CTRL_EMPTY;
+                hole = slot;
+                hole_group = group_idx;
+            }
+        }
+    }
+    return true;
+}
+
+// Open Addressing Hash Index
+lib_internal inline U64
+hash_index_hash_u64(U64 x)
+{
+    // ~mgj: murmur3 finalizer, the low bits select the group so they have to be well mixed
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ull;
+    x ^= x >> 33;
+    return x;
+}
 
-    U64 hash = map_hash_u64((U64)key);
-    U64 index = hash % m->capacity;
-    MapChunkList<K, V>* chunk_list = &m->v[index];
-    MapChunk<K, V>* chunk = chunk_list->first;
+lib_internal inline U64
+hash_index_capacity_from_count(U64 count)
+{
+    // ~mgj: max load factor 3/4
+    U64 min_capacity = count + count / 3 + 1;
+    return Max(HASH_INDEX_MIN_CAPACITY, u64_up_to_pow2(min_capacity));
+}
+
+template <typename K>
+lib_internal inline U64
+_hash_index_key_u64(K key)
+{
+    U64 key_u64 = 0;
+    MemoryCopy(&key_u64, &key, sizeof(K));
+    return key_u64;
+}
 
-    // check if key is already present
-    for (; chunk; chunk = chunk->next)
+// ~mgj: bit i is set if group[i] == key
+template <typename K>
+lib_internal inline U32
+_hash_index_group_match(K* group, K key)
+{
+    if constexpr (sizeof(K) == sizeof(U64))
+    {
+        __m128i key_wide = _mm_set1_epi64x((S64)_hash_index_key_u64(key));
+        __m128i lo = _mm_loadu_si128((__m128i*)group);
+        __m128i hi = _mm_loadu_si128((__m128i*)(group + 2));
+        U32 lo_mask = (U32)_mm_movemask_pd(_mm_castsi128_pd(_mm_cmpeq_epi64(lo, key_wide)));
+        U32 hi_mask = (U32)_mm_movemask_pd(_mm_castsi128_pd(_mm_cmpeq_epi64(hi, key_wide)));
+        return lo_mask | (hi_mask << 2);
+    }
+    else
     {
-        for (U64 i = 0; i < chunk->count; ++i)
+        U32 mask = 0;
+        for (U32 i = 0; i < HASH_INDEX_GROUP_SIZE; ++i)
         {
-            if (chunk->v[i].key == key)
-                return nullptr;
+            mask |= (U32)(_hash_index_key_u64(group[i]) == _hash_index_key_u64(key)) << i;
         }
+        return mask;
     }
+}
 
-    if (!chunk || chunk->count >= ArrayCount(chunk->v))
+template <typename K, typename V>
+lib_internal void
+_hash_index_alloc(HashIndex<K, V>* index, U64 capacity)
+{
+    Assert(IsPow2(capacity) && capacity >= HASH_INDEX_MIN_CAPACITY);
+    index->keys = PushArrayNoZero(index->arena, K, capacity);
+    index->values = PushArrayNoZero(index->arena, V, capacity);
+    index->capacity = capacity;
+    index->count = 0;
+    for (U64 i = 0; i < capacity; ++i)
     {
-        chunk = PushStruct(m->arena, KeyPair);
-        SLLQueuePush(chunk_list->first, chunk_list->last, chunk);
-        chunk_list->chunk_count += 1;
+        index->keys[i] = index->empty_key;
     }
+}
 
-    chunk = chunk_list->last;
-    U64 i = chunk->count;
-    chunk->v[i].key = key;
-    chunk->v[i].value = value;
-    chunk_list->total_count += 1;
-    chunk->count += 1;
+// ~mgj: Returns the slot holding key, or the first free slot on its probe sequence
+template <typename K, typename V>
+lib_internal U64
+_hash_index_slot_find(HashIndex<K, V>* index, K key, B32* out_found)
+{
+    U64 mask = index->capacity - 1;
+    U64 group_idx = hash_index_hash_u64(_hash_index_key_u64(key)) & mask & ~(HASH_INDEX_GROUP_SIZE - 1);
+    for (;;)
+    {
+        K* group = index->keys + group_idx;
+        U32 match = _hash_index_group_match(group, key);
+        if (match)
+        {
+            *out_found = true;
+            return group_idx + ctz32(match);
+        }
+        U32 empty = _hash_index_group_match(group, index->empty_key);
+        if (empty)
+        {
+            *out_found = false;
+            return group_idx + ctz32(empty);
+        }
+        group_idx = (group_idx + HASH_INDEX_GROUP_SIZE) & mask;
+    }
+}
 
-    return &chunk->v[i].value;
+template <typename K, typename V>
+lib_internal void
+_hash_index_grow(HashIndex<K, V>* index, U64 new_capacity)
+{
+    prof_scope_marker;
+    K* old_keys = index->keys;
+    V* old_values = index->values;
+    U64 old_capacity = index->capacity;
+    U64 old_count = index->count;
+
+    // ~mgj: the old arrays stay in the arena until it is released
+    _hash_index_alloc(index, new_capacity);
+    for (U64 i = 0; i < old_capacity; ++i)
+    {
+        if (_hash_index_key_u64(old_keys[i]) == _hash_index_key_u64(index->empty_key))
+        {
+            continue;
+        }
+        B32 found;
+        U64 slot = _hash_index_slot_find(index, old_keys[i], &found);
+        index->keys[slot] = old_keys[i];
+        index->values[slot] = old_values[i];
+    }
+    index->count = old_count;
+}
+
+template <typename K, typename V>
+lib_internal HashIndex<K, V>*
+hash_index_create(Arena* arena, U64 expected_count, K empty_key)
+{
+    using HashIndexType = HashIndex<K, V>;
+    HashIndexType* index = PushStruct(arena, HashIndexType);
+    index->arena = arena;
+    index->empty_key = empty_key;
+    _hash_index_alloc(index, hash_index_capacity_from_count(expected_count));
+    return index;
+}
+
+template <typename K, typename V>
+lib_internal void
+hash_index_reserve(HashIndex<K, V>* index, U64 expected_count)
+{
+    U64 capacity = hash_index_capacity_from_count(expected_count);
+    if (capacity > index->capacity)
+    {
+        _hash_index_grow(index, capacity);
+    }
+}
+
+template <typename K, typename V>
+lib_internal V*
+hash_index_get(HashIndex<K, V>* index, K key)
+{
+    Assert(_hash_index_key_u64(key) != _hash_index_key_u64(index->empty_key));
+    B32 found;
+    U64 slot = _hash_index_slot_find(index, key, &found);
+    return found ? &index->values[slot] : nullptr;
+}
+
+template <typename K, typename V>
+lib_internal V*
+hash_index_get_or_insert(HashIndex<K, V>* index, K key, B32* out_inserted)
+{
+    Assert(_hash_index_key_u64(key) != _hash_index_key_u64(index->empty_key));
+    hash_index_reserve(index, index->count + 1);
+
+    B32 found;
+    U64 slot = _hash_index_slot_find(index, key, &found);
+    if (!found)
+    {
+        index->keys[slot] = key;
+        MemoryZero(&index->values[slot], sizeof(V));
+        index->count += 1;
+    }
+    *out_inserted = !found;
+    return &index->values[slot];
+}
+
+template <typename K, typename V>
+lib_internal V*
+hash_index_insert(HashIndex<K, V>* index, K key, const V& value)
+{
+    B32 inserted;
+    V* slot_value = hash_index_get_or_insert(index, key, &inserted);
+    if (!inserted)
+    {
+        return nullptr;
+    }
+    *slot_value = value;
+    return slot_value;
 }
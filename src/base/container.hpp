@@ -3,6 +3,8 @@
 #pragma once
 
 #include <initializer_list>
+#include <type_traits>
+#include <immintrin.h>
 
 template <typename T>
 struct Result
@@ -225,7 +227,14 @@ defer_func(F f)
 #define DEFER_3(x) DEFER_2(x, __COUNTER__)
 #define defer(code) auto DEFER_3(_defer_) = defer_func([&]() { code; })
 
-// Linked List Map
+// Swiss Table Map
+// ~mgj: One control byte per slot: MAP_CTRL_EMPTY or the low 7 bits of the key hash. A probe loads
+// a group of 16 control bytes and compares them with SSE2, so slots are only touched on a 7 bit
+// match. Groups are probed linearly, which lets map_remove back-shift entries instead of leaving
+// tombstones. The map grows (in its arena) when the load factor would pass 7/8.
+const U64 MAP_GROUP_SIZE = 16;
+const U8 MAP_CTRL_EMPTY = 0x80;
+
 template <typename K, typename T>
 struct MapItem
 {
@@ -233,31 +242,15 @@ struct MapItem
     T value;
 };
 
-const U64 DEFAULT_MAP_CHUNK_SIZE = 14;
-template <typename K, typename V, U64 N = DEFAULT_MAP_CHUNK_SIZE>
-struct MapChunk
-{
-    static_assert(sizeof(K) == sizeof(void*), "Key size must match pointer size");
-    MapChunk<K, V, N>* next;
-    U64 count;
-    MapItem<K, V> v[N];
-};
-
-template <typename K, typename T, U64 N = DEFAULT_MAP_CHUNK_SIZE>
-struct MapChunkList
-{
-    MapChunk<K, T, N>* first;
-    MapChunk<K, T, N>* last;
-    U64 chunk_count;
-    U64 total_count;
-};
-
 template <typename K, typename V>
 struct Map
 {
+    static_assert(sizeof(K) <= sizeof(U64) && std::is_trivially_copyable_v<K>, "Map keys must be trivially copyable and at most 8 bytes");
     Arena* arena;
-    MapChunkList<K, V>* v;
-    U64 capacity;
+    U8* ctrl;
+    MapItem<K, V>* slots;
+    U64 capacity; // power of two, at least MAP_GROUP_SIZE
+    U64 count;
 };
 
 enum class MapResult : B32
@@ -266,6 +259,7 @@ enum class MapResult : B32
     NotFound = 1
 };
 
+// ~mgj: capacity is the expected number of keys, the map grows past it when needed
 template <typename K, typename V>
 lib_internal Map<K, V>*
 map_create(Arena* arena, U64 capacity);
@@ -278,10 +272,15 @@ template <typename K, typename V>
 lib_internal MapResult
 map_get(Map<K, V>* m, K key, V** out_value);
 
+// ~mgj: returns nullptr if the key is already present
 template <typename K, typename V>
 lib_internal V*
 map_insert(Map<K, V>* m, K key, V& value);
 
+template <typename K, typename V>
+lib_internal B32
+map_remove(Map<K, V>* m, K key);
+
 // private map functions
 lib_internal inline U64
 map_hash_u64(U64 x);
@@ -290,3 +289,51 @@ lib_internal inline U64
 map_round_up_pow2_u64(U64 v);
 
 /////////////////////////////////////////////////////
+
+// Open Addressing Hash Index
+// ~mgj: Keys and values live in separate arrays (SoA) so a probe only touches the keys. Slots are
+// probed in aligned groups of HASH_INDEX_GROUP_SIZE which lets 8 byte keys be compared with SSE4.1.
+// One key value (empty_key, default K{}) is reserved to mark free slots and cannot be inserted.
+const U64 HASH_INDEX_GROUP_SIZE = 4;
+const U64 HASH_INDEX_MIN_CAPACITY = 8;
+
+template <typename K, typename V>
+struct HashIndex
+{
+    static_assert(sizeof(K) <= sizeof(U64) && std::is_trivially_copyable_v<K>, "HashIndex keys must be trivially copyable and at most 8 bytes");
+    Arena* arena;
+    K* keys;
+    V* values;
+    U64 capacity; // power of two
+    U64 count;
+    K empty_key;
+};
+
+template <typename K, typename V>
+lib_internal HashIndex<K, V>*
+hash_index_create(Arena* arena, U64 expected_count, K empty_key = K{});
+
+template <typename K, typename V>
+lib_internal V*
+hash_index_get(HashIndex<K, V>* index, K key);
+
+// ~mgj: returns nullptr if the key is already present (same contract as map_insert)
+template <typename K, typename V>
+lib_internal V*
+hash_index_insert(HashIndex<K, V>* index, K key, const V& value);
+
+// ~mgj: newly inserted values are zero initialized
+template <typename K, typename V>
+lib_internal V*
+hash_index_get_or_insert(HashIndex<K, V>* index, K key, B32* out_inserted);
+
+template <typename K, typename V>
+lib_internal void
+hash_index_reserve(HashIndex<K, V>* index, U64 expected_count);
+
+// private hash index functions
+lib_internal inline U64
+hash_index_hash_u64(U64 x);
+
+lib_internal inline U64
+hash_index_capacity_from_count(U64 count);
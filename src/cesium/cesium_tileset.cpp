@@ -30,6 +30,10 @@ class DTCityTaskProcessor : public CesiumAsync::ITaskProcessor
                                                        delete func;
                                                        return {};
                                                    });
+        // ~mgj: cesium-native hands over closures without the tile they load, so its work cannot be ranked
+        // per tile here. It starts its loads in its own screen space error priority order, the lane keeps
+        // that order while frame-critical work goes first and precompute cannot crowd it out.
+        item.priority = async::ThreadPoolPriority_Streaming;
 
         if (!async::thread_pool_push(thread_pool, &item))
         {
@@ -340,7 +344,8 @@ _ion_raster_overlay_example_add_if_present(Cesium3DTilesSelection::Tileset* tile
 class DTCityPrepareRendererResources : public Cesium3DTilesSelection::IPrepareRendererResources
 {
   public:
-    DTCityPrepareRendererResources(glm::dmat4 ecef_to_local_transform, TilesetRenderer* tile_set_renderer) : ecef_to_local_transform(ecef_to_local_transform), tile_set_renderer(tile_set_renderer)
+    DTCityPrepareRendererResources(glm::dmat4 ecef_to_local_transform, TilesetRenderer* tile_set_renderer, async::ThreadPool* thread_pool)
+        : ecef_to_local_transform(ecef_to_local_transform), tile_set_renderer(tile_set_renderer), thread_pool(thread_pool)
     {
     }
 
@@ -358,7 +363,7 @@ class DTCityPrepareRendererResources : public Cesium3DTilesSelection::IPrepareRe
         render::thread_cmd_buffer_record(thread_ctx);
         defer({ render::thread_cmd_buffer_end(thread_ctx); });
 
-        TileRenderDataList* render_data_list = tile_render_data_from_gltf(*model, ecef_to_local_transform, transform, tileLoadResult.glTFUpAxis, thread_ctx);
+        TileRenderDataList* render_data_list = tile_render_data_from_gltf(thread_pool, tile_set_renderer, *model, ecef_to_local_transform, transform, tileLoadResult.glTFUpAxis, thread_ctx);
         {
             auto stub_func = [](void* data, render::ThreadWorkerCmdCtx* thread_input)
             {
@@ -379,6 +384,7 @@ class DTCityPrepareRendererResources : public Cesium3DTilesSelection::IPrepareRe
                 }
                 render::handle_list_push(thread_ctx, data->render_data.vertex_buffer_handle);
                 render::handle_list_push(thread_ctx, data->render_data.index_buffer_handle);
+                render::handle_list_push(thread_ctx, data->triangle_segment_buffer_handle);
                 render::Handle null_texture_handle = render::texture_zero_handle_get();
                 if (data->render_data.texture_handle.u64 != null_texture_handle.u64 || data->render_data.texture_handle.gen_id != null_texture_handle.gen_id ||
                     data->render_data.texture_handle.type != null_texture_handle.type)
@@ -527,6 +533,7 @@ class DTCityPrepareRendererResources : public Cesium3DTilesSelection::IPrepareRe
   private:
     glm::dmat4 ecef_to_local_transform;
     TilesetRenderer* tile_set_renderer;
+    async::ThreadPool* thread_pool;
 };
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -639,9 +646,58 @@ render_raster_tile_record(render::ThreadWorkerCmdCtx* thread_input, RasterTileIn
     return resource;
 }
 
+struct _TileVertexCopyTask
+{
+    Buffer<render::TileVertex> vertices;
+    glm::dmat4 pos_to_local; // node, up axis, tile and ecef to local in one
+    const U8* pos_data;
+    S64 pos_stride;
+    const U8* uv_data;
+    U32 uv_stride;
+    const U8* overlay_uv_data;
+    U32 overlay_uv_stride;
+};
+
+g_internal void
+_tile_vertex_copy_task(async::ThreadInfo thread_info, Arena* scratch_arena, void* data, U64 start_idx, U64 end_idx)
+{
+    (void)thread_info;
+    (void)scratch_arena;
+    _TileVertexCopyTask* task = (_TileVertexCopyTask*)data;
+    for (U64 i = start_idx; i < end_idx; ++i)
+    {
+        render::TileVertex* vertex = &task->vertices.data[i];
+        vertex->colormap_value = 0.0f;
+        vertex->uv = {};
+        vertex->overlay_uv = {};
+        vertex->object_id = {};
+
+        const F32* pos = (const F32*)(task->pos_data + i * task->pos_stride);
+        glm::dvec4 pos_local = task->pos_to_local * glm::dvec4(pos[0], pos[1], pos[2], 1.0);
+
+        vertex->pos.x = (F32)pos_local.x;
+        vertex->pos.y = (F32)pos_local.y;
+        vertex->pos.z = (F32)pos_local.z;
+
+        if (task->uv_data)
+        {
+            const F32* uv = (const F32*)(task->uv_data + i * (U64)task->uv_stride);
+            vertex->uv.x = uv[0];
+            vertex->uv.y = uv[1];
+        }
+
+        if (task->overlay_uv_data)
+        {
+            const F32* overlay_uv = (const F32*)(task->overlay_uv_data + i * (U64)task->overlay_uv_stride);
+            vertex->overlay_uv.x = overlay_uv[0];
+            vertex->overlay_uv.y = overlay_uv[1];
+        }
+    }
+}
+
 g_internal TileRenderDataList*
-tile_render_data_from_gltf(const CesiumGltf::Model& model, const glm::dmat4& ecef_to_local, const glm::dmat4& tile_transform, CesiumGeometry::Axis gltf_up_axis,
-                           render::ThreadWorkerCmdCtx* thread_input)
+tile_render_data_from_gltf(async::ThreadPool* thread_pool, TilesetRenderer* renderer, const CesiumGltf::Model& model, const glm::dmat4& ecef_to_local, const glm::dmat4& tile_transform,
+                           CesiumGeometry::Axis gltf_up_axis, render::ThreadWorkerCmdCtx* thread_input)
 {
     prof_scope_marker;
     ScratchScope scratch = ScratchScope(0, 0);
@@ -763,39 +819,20 @@ tile_render_data_from_gltf(const CesiumGltf::Model& model, const glm::dmat4& ece
                 Buffer<U32> indices = buffer_alloc<U32>(scratch.arena, index_accessor->count);
 
                 // Copy vertices
-                for (U32 i = 0; i < (U32)pos_accessor->count; ++i)
-                {
-                    render::TileVertex* vertex = &vertices.data[i];
-                    vertex->colormap_value = 0.0f;
-                    vertex->uv = {};
-                    vertex->overlay_uv = {};
-                    vertex->object_id = {};
-
-                    const F32* pos = (const F32*)(pos_data + i * pos_stride);
-                    glm::dmat4 node_matrix(glm::dvec4(node.matrix[0], node.matrix[1], node.matrix[2], node.matrix[3]), glm::dvec4(node.matrix[4], node.matrix[5], node.matrix[6], node.matrix[7]),
-                                           glm::dvec4(node.matrix[8], node.matrix[9], node.matrix[10], node.matrix[11]),
-                                           glm::dvec4(node.matrix[12], node.matrix[13], node.matrix[14], node.matrix[15]));
-                    glm::dvec4 pos_node = node_matrix * glm::dvec4(pos[0], pos[1], pos[2], 1.0);
-                    glm::dvec4 pos_local = ecef_to_local * tile_transform * gltf_to_zup * pos_node;
-
-                    vertex->pos.x = (F32)pos_local.x;
-                    vertex->pos.y = (F32)pos_local.y;
-                    vertex->pos.z = (F32)pos_local.z;
-
-                    if (uv_data)
-                    {
-                        const F32* uv = (const F32*)(uv_data + (U64)i * (U64)uv_stride);
-                        vertex->uv.x = uv[0];
-                        vertex->uv.y = uv[1];
-                    }
-
-                    if (overlay_uv_data)
-                    {
-                        const F32* overlay_uv = (const F32*)(overlay_uv_data + (U64)i * (U64)overlay_uv_stride);
-                        vertex->overlay_uv.x = overlay_uv[0];
-                        vertex->overlay_uv.y = overlay_uv[1];
-                    }
-                }
+                glm::dmat4 node_matrix(glm::dvec4(node.matrix[0], node.matrix[1], node.matrix[2], node.matrix[3]), glm::dvec4(node.matrix[4], node.matrix[5], node.matrix[6], node.matrix[7]),
+                                       glm::dvec4(node.matrix[8], node.matrix[9], node.matrix[10], node.matrix[11]),
+                                       glm::dvec4(node.matrix[12], node.matrix[13], node.matrix[14], node.matrix[15]));
+                _TileVertexCopyTask copy_task = {
+                    .vertices = vertices,
+                    .pos_to_local = ecef_to_local * tile_transform * gltf_to_zup * node_matrix,
+                    .pos_data = pos_data,
+                    .pos_stride = pos_stride,
+                    .uv_data = uv_data,
+                    .uv_stride = uv_stride,
+                    .overlay_uv_data = overlay_uv_data,
+                    .overlay_uv_stride = overlay_uv_stride,
+                };
+                async::parallel_for(thread_pool, vertices.size, TILE_VERTEX_COPY_GRAIN, _tile_vertex_copy_task, &copy_task);
 
                 // Read indices
                 if (primitive.indices >= 0)
@@ -882,6 +919,19 @@ tile_render_data_from_gltf(const CesiumGltf::Model& model, const glm::dmat4& ece
                 index_offset += prim_node->indices.size;
             }
         }
+        // ~mgj: classified here when the road BVH is ready, the tiles loaded before that take the classify
+        // pass of road_intersection.comp
+        Buffer<U32> triangle_segments = buffer_alloc<U32>(tile_render_data_list->arena, index_count / 3);
+        os_mutex_scope_r(renderer->triangle_classifier_mutex)
+        {
+            if (renderer->triangle_classify_func)
+            {
+                render_data->overlay_option = ins_atomic_u32_eval(&renderer->triangle_overlay_option);
+                renderer->triangle_classify_func(renderer->triangle_classify_data, vertices, indices, render_data->overlay_option, triangle_segments);
+                render_data->triangle_segments_cached = true;
+            }
+        }
+
         render::BufferInfo vertex_info = render::BufferInfo(vertices, render::BufferType_Vertex | render::BufferType_StorageBuffer);
         render::BufferInfo index_info = render::BufferInfo(indices, render::BufferType_Index | render::BufferType_StorageBuffer);
 
@@ -891,6 +941,9 @@ tile_render_data_from_gltf(const CesiumGltf::Model& model, const glm::dmat4& ece
         render_data->render_data.vertex_buffer_handle = render::buffer_load_sync(thread_input, &vertex_info, S("cesium_tile_vertex"));
         render_data->render_data.index_buffer_handle = render::buffer_load_sync(thread_input, &index_info, S("cesium_tile_index"));
 
+        render::BufferInfo triangle_segment_info = render::BufferInfo(triangle_segments, render::BufferType_StorageBuffer);
+        render_data->triangle_segment_buffer_handle = render::buffer_load_sync(thread_input, &triangle_segment_info, S("cesium_tile_triangle_segment"));
+
         // Texture Loading
         S32 tex_idx = -1;
         if (model.materials[mat_idx].pbrMetallicRoughness.has_value())
@@ -970,7 +1023,7 @@ _tileset_renderer_create_context(TilesetRenderer* tileset, async::ThreadPool* th
     tileset->local_to_ecef = local_coord_system.getLocalToEcefTransformation();
 
     // Create prepare renderer resources (pass coordinate system for ECEF->local transforms)
-    auto prepare_renderer_resources = std::make_shared<DTCityPrepareRendererResources>(tileset->ecef_to_local, tileset);
+    auto prepare_renderer_resources = std::make_shared<DTCityPrepareRendererResources>(tileset->ecef_to_local, tileset, threads);
 
     std::shared_ptr<spdlog::logger> logger = spdlog::default_logger();
     if (logger)
@@ -1064,6 +1117,7 @@ tileset_renderer_create(TilesetRenderer* tileset, async::ThreadPool* threads, St
 
     tileset->allocator = Allocator::create();
     Debug_SetName(tileset->allocator->arena, "Cesium Tileset Allocator arena");
+    tileset->triangle_classifier_mutex = os_rw_mutex_alloc();
     ScratchScope scratch = ScratchScope(0, 0);
     String8 ion_access_token = {};
     if (env_vars_value_get(scratch.arena, S("CESIUM_ION_ACCESS_TOKEN"), &ion_access_token, 1))
@@ -1124,6 +1178,7 @@ _tileset_renderer_free_handles(TileRenderDataList* list)
     {
         render::handle_destroy_deferred(render_data->render_data.vertex_buffer_handle);
         render::handle_destroy_deferred(render_data->render_data.index_buffer_handle);
+        render::handle_destroy_deferred(render_data->triangle_segment_buffer_handle);
         render::Handle null_texture_handle = render::texture_zero_handle_get();
         if (render_data->render_data.texture_handle.u64 != null_texture_handle.u64 || render_data->render_data.texture_handle.gen_id != null_texture_handle.gen_id ||
             render_data->render_data.texture_handle.type != null_texture_handle.type)
@@ -1249,6 +1304,7 @@ tileset_renderer_destroy(TilesetRenderer* renderer)
 
     renderer->async_system.dispatchMainThreadTasks();
     Allocator::destroy(renderer->allocator);
+    os_rw_mutex_release(renderer->triangle_classifier_mutex);
 
     tileset_renderer_free_list_empty(renderer);
     _tileset_renderer_active_resources_release(renderer);
@@ -1256,6 +1312,22 @@ tileset_renderer_destroy(TilesetRenderer* renderer)
     MemoryZeroStruct(renderer);
 }
 
+g_internal void
+tileset_triangle_classifier_set(TilesetRenderer* renderer, TileTriangleClassifyFunc func, void* data)
+{
+    os_mutex_scope_w(renderer->triangle_classifier_mutex)
+    {
+        renderer->triangle_classify_func = func;
+        renderer->triangle_classify_data = data;
+    }
+}
+
+g_internal void
+tileset_triangle_overlay_option_set(TilesetRenderer* renderer, U32 overlay_option)
+{
+    ins_atomic_u32_eval_assign(&renderer->triangle_overlay_option, overlay_option);
+}
+
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // Update and Rendering
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -1309,12 +1381,15 @@ tileset_update_view(TilesetRenderer* renderer, ui::Camera* camera, Vec2U32 viewp
     // Update the tileset view
     std::vector<Cesium3DTilesSelection::ViewState> views = {view_state};
     tileset_renderer_free_list_empty(renderer);
+    _tileset_view_jump_detect(renderer, camera_pos_local);
+    S64 tile_load_queue_length = 0;
     {
         prof_scope_marker_named("tile load loop");
         for (U32 i = 0; i < renderer->tilesets.size; ++i)
         {
             const Cesium3DTilesSelection::ViewUpdateResult& result = renderer->tilesets.data[i]->updateViewGroup(renderer->tilesets.data[i]->getDefaultViewGroup(), views, (F32)delta_time);
             renderer->tilesets.data[i]->loadTiles();
+            tile_load_queue_length += result.workerThreadTileLoadQueueLength + result.mainThreadTileLoadQueueLength;
 
             for (const Cesium3DTilesSelection::Tile* tile : result.tilesToRenderThisFrame)
             {
@@ -1354,6 +1429,35 @@ tileset_update_view(TilesetRenderer* renderer, ui::Camera* camera, Vec2U32 viewp
             }
         }
     }
+    _tileset_view_full_check(renderer, tile_load_queue_length);
+}
+
+g_internal void
+_tileset_view_jump_detect(TilesetRenderer* renderer, glm::dvec3 camera_pos_local)
+{
+    // ~mgj: the first view of a renderer counts as a jump too, that is the area switch
+    B32 is_jump = !renderer->view_has_prev_position || glm::distance(camera_pos_local, renderer->view_prev_position) > TILESET_VIEW_JUMP_DISTANCE;
+    renderer->view_prev_position = camera_pos_local;
+    renderer->view_has_prev_position = true;
+    if (is_jump)
+    {
+        renderer->view_jump_us = os_now_microseconds();
+    }
+}
+
+g_internal void
+_tileset_view_full_check(TilesetRenderer* renderer, S64 tile_load_queue_length)
+{
+    // ~mgj: full once cesium has nothing left to load for the view and something is on screen, before
+    // the root tiles are in both queues are empty as well
+    if (renderer->view_jump_us == 0 || tile_load_queue_length > 0 || renderer->tiles_to_show_count == 0)
+    {
+        return;
+    }
+    renderer->view_full_ms = (F64)(os_now_microseconds() - renderer->view_jump_us) / 1000.0;
+    renderer->view_jump_us = 0;
+    DEBUG_LOG("Tileset: full view %.1f ms after camera jump\n", renderer->view_full_ms);
+    prof_plot("Tileset time to full view ms", renderer->view_full_ms);
 }
 
 } // namespace cesium
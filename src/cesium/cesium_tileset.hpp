@@ -3,6 +3,10 @@
 namespace cesium
 {
 
+const U64 TILE_VERTEX_COPY_GRAIN = 4096;
+// ~mgj: a camera move of more than this many meters in one frame restarts the time to full view
+const F64 TILESET_VIEW_JUMP_DISTANCE = 200.0;
+
 struct RasterTileInfo
 {
     const CesiumGltf::ImageAsset& image;
@@ -13,14 +17,24 @@ struct RasterTileInfo
     }
 };
 
+// ~mgj: classifies the triangles of a tile on its load thread before the buffers are uploaded: writes the road
+// segment index + 1 per triangle (0 for none) into out_triangle_segments and the overlay_option values into the
+// vertices. See tileset_triangle_classifier_set.
+typedef void (*TileTriangleClassifyFunc)(void* data, Buffer<render::TileVertex> vertices, Buffer<U32> indices, U32 overlay_option, Buffer<U32> out_triangle_segments);
+
 struct TileRenderData
 {
     TileRenderData* next;
     TileRenderData* render_next;
 
     render::TilePipelineData render_data;
-
-    bool compute_scheduled;
+    // ~mgj: road segment index + 1 per triangle, filled by the classify pass of road_intersection.comp so
+    // an overlay switch only has to gather the new option values
+    render::Handle triangle_segment_buffer_handle;
+    // ~mgj: set once the tile is classified (on its load thread or by the classify pass), the vertices then
+    // carry the values of overlay_option
+    B32 triangle_segments_cached;
+    U32 overlay_option;
 };
 
 struct TileRasterOverlayAttachment
@@ -82,6 +96,19 @@ struct TilesetRenderer
 
     TileRenderDataList* active_tile_resource_first;
     RasterRenderResource* active_raster_resource_first;
+
+    // time to full view: a camera jump starts the clock, the first frame without queued tile loads stops it
+    glm::dvec3 view_prev_position;
+    B32 view_has_prev_position;
+    U64 view_jump_us; // 0 while nothing is measured
+    F64 view_full_ms; // last measurement
+
+    // tile triangle classification on the load threads, the rw mutex keeps the classifier data alive while a
+    // load uses it
+    OS_Handle triangle_classifier_mutex;
+    TileTriangleClassifyFunc triangle_classify_func;
+    void* triangle_classify_data;
+    U32 triangle_overlay_option; // ins_atomic_u32, written by the main thread
 };
 
 struct TilesetRendererCreateContext
@@ -97,17 +124,27 @@ tileset_renderer_create(TilesetRenderer* tileset, async::ThreadPool* threads, St
                         U64 cache_byte_size);
 g_internal void
 tileset_renderer_destroy(TilesetRenderer* renderer);
+// ~mgj: func 0 turns classification on the load threads off, it returns once no load uses the old data
+g_internal void
+tileset_triangle_classifier_set(TilesetRenderer* renderer, TileTriangleClassifyFunc func, void* data);
+g_internal void
+tileset_triangle_overlay_option_set(TilesetRenderer* renderer, U32 overlay_option);
 
 // Update and rendering
 g_internal void
 tileset_pump_async(TilesetRenderer* renderer);
 g_internal void
 tileset_update_view(TilesetRenderer* renderer, ui::Camera* camera, Vec2U32 viewport_size, F64 delta_time);
+g_internal void
+_tileset_view_jump_detect(TilesetRenderer* renderer, glm::dvec3 camera_pos_local);
+g_internal void
+_tileset_view_full_check(TilesetRenderer* renderer, S64 tile_load_queue_length);
 
-// Helper to convert cesium glTF to render data
+// Helper to convert cesium glTF to render data. Vertices are converted with parallel_for, tiles with fewer
+// than TILE_VERTEX_COPY_GRAIN vertices per primitive stay on the calling thread.
 g_internal TileRenderDataList*
-tile_render_data_from_gltf(const CesiumGltf::Model& model, const glm::dmat4& ecef_to_local, const glm::dmat4& tile_transform, CesiumGeometry::Axis gltf_up_axis,
-                           render::ThreadWorkerCmdCtx* thread_input);
+tile_render_data_from_gltf(async::ThreadPool* thread_pool, TilesetRenderer* renderer, const CesiumGltf::Model& model, const glm::dmat4& ecef_to_local, const glm::dmat4& tile_transform,
+                           CesiumGeometry::Axis gltf_up_axis, render::ThreadWorkerCmdCtx* thread_input);
 
 g_internal RasterRenderResource*
 render_raster_tile_record(render::ThreadWorkerCmdCtx* thread_input, RasterTileInfo* tile_info);
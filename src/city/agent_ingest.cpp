@@ -0,0 +1,167 @@
+namespace city
+{
+
+g_internal AgentIngest*
+agent_ingest_create()
+{
+    Arena* arena = arena_alloc();
+    Debug_SetName(arena, "agent ingest arena");
+    AgentIngest* ingest = PushStruct(arena, AgentIngest);
+    ingest->arena = arena;
+    ingest->parser = new (PushStructNoZero(arena, simdjson::ondemand::parser)) simdjson::ondemand::parser();
+    ingest->json_arena = arena_alloc();
+    Debug_SetName(ingest->json_arena, "agent ingest json arena");
+    agent_wire_state_init(&ingest->wire_state);
+    return ingest;
+}
+
+g_internal void
+agent_ingest_release(AgentIngest* ingest)
+{
+    ingest->parser->~parser();
+    agent_wire_state_release(&ingest->wire_state);
+    arena_release(ingest->json_arena);
+    arena_release(ingest->arena);
+}
+
+g_internal Buffer<Coordinate>
+agent_ingest_run(AgentIngest* ingest, Arena* arena, String8List* msgs, U64 now_us)
+{
+    prof_scope_marker;
+    U64 start_us = os_now_microseconds();
+
+    ChunkList<Coordinate>* coords = chunk_list_create<Coordinate>(arena, 1024);
+    Map<S64, Coordinate*>* coord_map = map_create<S64, Coordinate*>(arena, 1024);
+    AgentIngestStats stats = {};
+    for (String8Node* node = msgs->first; node; node = node->next)
+    {
+        stats.message_count += 1;
+        B32 ok = false;
+        if (agent_wire_is_frame(node->string))
+        {
+            stats.wire_message_count += 1;
+            ok = _agent_ingest_wire_message(ingest, arena, node->string, now_us, coords, coord_map, &stats);
+        }
+        else
+        {
+            ok = _agent_ingest_json_message(ingest, arena, node->string, now_us, coords, coord_map, &stats);
+        }
+        if (!ok)
+        {
+            stats.failed_message_count += 1;
+        }
+    }
+    Buffer<Coordinate> result = buffer_from_chunk_list<Coordinate>(arena, coords);
+    stats.agent_count = result.size;
+
+    stats.parse_us = os_now_microseconds() - start_us;
+
+    ingest->rate_window_message_count += stats.message_count;
+    if (ingest->rate_window_start_us == 0)
+    {
+        ingest->rate_window_start_us = now_us;
+    }
+    U64 window_us = now_us - Min(ingest->rate_window_start_us, now_us);
+    if (window_us >= AGENT_INGEST_RATE_WINDOW_US)
+    {
+        ingest->stats.messages_per_sec = (F64)ingest->rate_window_message_count * 1'000'000.0 / (F64)window_us;
+        ingest->rate_window_start_us = now_us;
+        ingest->rate_window_message_count = 0;
+    }
+    stats.messages_per_sec = ingest->stats.messages_per_sec;
+    ingest->stats = stats;
+
+    prof_plot("Agent ingest messages/s", stats.messages_per_sec);
+    prof_plot("Agent ingest parse us", (F64)stats.parse_us);
+    return result;
+}
+
+g_internal String8
+_agent_ingest_json_padded(AgentIngest* ingest, String8 msg)
+{
+    U64 size_needed = msg.size + simdjson::SIMDJSON_PADDING;
+    if (ingest->json_capacity < size_needed)
+    {
+        ingest->json_capacity = Max(size_needed + size_needed / 2, AGENT_INGEST_MIN_JSON_CAPACITY);
+        arena_clear(ingest->json_arena);
+        ingest->json_buffer = PushArrayNoZeroAligned(ingest->json_arena, U8, ingest->json_capacity, 64);
+    }
+    MemoryCopy(ingest->json_buffer, msg.str, msg.size);
+    MemoryZero(ingest->json_buffer + msg.size, simdjson::SIMDJSON_PADDING);
+    return str8(ingest->json_buffer, msg.size);
+}
+
+g_internal void
+_agent_ingest_coord_add(Arena* arena, Coordinate* coord, ChunkList<Coordinate>* coords, Map<S64, Coordinate*>* coord_map)
+{
+    Coordinate** existing = map_get(coord_map, coord->id);
+    if (existing)
+    {
+        if ((*existing)->timestamp_us <= coord->timestamp_us)
+        {
+            **existing = *coord;
+        }
+        return;
+    }
+    Coordinate* slot = chunk_list_get_next<Coordinate>(arena, coords);
+    *slot = *coord;
+    map_insert(coord_map, coord->id, slot);
+}
+
+g_internal B32
+_agent_ingest_wire_message(AgentIngest* ingest, Arena* arena, String8 msg, U64 now_us, ChunkList<Coordinate>* coords, Map<S64, Coordinate*>* coord_map, AgentIngestStats* stats)
+{
+    ScratchScope scratch = ScratchScope(&arena, 1);
+    Buffer<Coordinate> frame_coords = {};
+    if (!agent_wire_decode(scratch.arena, &ingest->wire_state, msg, now_us, &frame_coords))
+    {
+        DEBUG_LOG("agent ingest: dropping a %llu byte binary frame", msg.size);
+        return false;
+    }
+    stats->coord_count += frame_coords.size;
+    for (U64 i = 0; i < frame_coords.size; ++i)
+    {
+        _agent_ingest_coord_add(arena, &frame_coords.data[i], coords, coord_map);
+    }
+    return true;
+}
+
+g_internal B32
+_agent_ingest_json_message(AgentIngest* ingest, Arena* arena, String8 msg, U64 now_us, ChunkList<Coordinate>* coords, Map<S64, Coordinate*>* coord_map, AgentIngestStats* stats)
+{
+    String8 json = _agent_ingest_json_padded(ingest, msg);
+    simdjson::ondemand::document doc;
+    simdjson::ondemand::array coord_array;
+    simdjson::error_code error = ingest->parser->iterate(json.str, json.size, ingest->json_capacity).get(doc);
+    if (!error)
+    {
+        error = doc.get_array().get(coord_array);
+    }
+    if (error)
+    {
+        DEBUG_LOG("agent ingest: dropping a %llu byte message, %s", msg.size, simdjson::error_message(error));
+        return false;
+    }
+
+    // ~mgj: coordinates before an error in a message are kept, the rest of the message is lost
+    for (auto element : coord_array)
+    {
+        Coordinate coord = {.timestamp_us = now_us};
+        error = element.get<Coordinate>(coord);
+        if (error)
+        {
+            break;
+        }
+        stats->coord_count += 1;
+        _agent_ingest_coord_add(arena, &coord, coords, coord_map);
+    }
+
+    if (error)
+    {
+        DEBUG_LOG("agent ingest: dropping the rest of a %llu byte message, %s", msg.size, simdjson::error_message(error));
+        return false;
+    }
+    return true;
+}
+
+} // namespace city
@@ -0,0 +1,60 @@
+#pragma once
+
+namespace city
+{
+// ~mgj: Agent update ingest, the stage between the websocket and agent_sim_update. Every message read in
+// a frame is parsed, none is dropped, and the coordinates are coalesced to one per Coordinate::id: the
+// newest timestamp wins and a later message wins a tie. The parser and the padded copy of the message
+// live as long as the ingest, so after the first few frames parsing allocates nothing but the result.
+// Binary frames (agent_wire.hpp) are recognized by their magic and go through the same coalescing.
+const U64 AGENT_INGEST_RATE_WINDOW_US = 1'000'000;
+const U64 AGENT_INGEST_MIN_JSON_CAPACITY = KB(64);
+
+struct AgentIngestStats
+{
+    U32 message_count; // last frame
+    U32 failed_message_count;
+    U32 wire_message_count; // binary frames among message_count
+    U64 coord_count; // in the messages of the last frame
+    U64 agent_count; // after coalescing
+    U64 parse_us;
+    F64 messages_per_sec; // over the last full AGENT_INGEST_RATE_WINDOW_US
+};
+
+struct AgentIngest
+{
+    Arena* arena;
+    simdjson::ondemand::parser* parser;
+
+    // ~mgj: padded copy of the message being parsed, reallocated only when a message does not fit
+    Arena* json_arena;
+    U8* json_buffer;
+    U64 json_capacity;
+
+    AgentWireState wire_state;
+
+    U64 rate_window_start_us;
+    U64 rate_window_message_count;
+    AgentIngestStats stats;
+};
+
+g_internal AgentIngest*
+agent_ingest_create();
+g_internal void
+agent_ingest_release(AgentIngest* ingest);
+// ~mgj: the coordinates are allocated in arena. now_us is unix time in microseconds
+// (os_now_unix_microseconds), the clock of the feed timestamps, and coordinates without one get it so the
+// newest coordinate per agent is picked on one clock.
+g_internal Buffer<Coordinate>
+agent_ingest_run(AgentIngest* ingest, Arena* arena, String8List* msgs, U64 now_us);
+
+// ~mgj: internal
+g_internal String8
+_agent_ingest_json_padded(AgentIngest* ingest, String8 msg);
+g_internal void
+_agent_ingest_coord_add(Arena* arena, Coordinate* coord, ChunkList<Coordinate>* coords, Map<S64, Coordinate*>* coord_map);
+g_internal B32
+_agent_ingest_wire_message(AgentIngest* ingest, Arena* arena, String8 msg, U64 now_us, ChunkList<Coordinate>* coords, Map<S64, Coordinate*>* coord_map, AgentIngestStats* stats);
+g_internal B32
+_agent_ingest_json_message(AgentIngest* ingest, Arena* arena, String8 msg, U64 now_us, ChunkList<Coordinate>* coords, Map<S64, Coordinate*>* coord_map, AgentIngestStats* stats);
+} // namespace city
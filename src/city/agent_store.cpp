@@ -0,0 +1,678 @@
+namespace city
+{
+
+g_internal AgentStore*
+agent_store_create(U32 capacity)
+{
+    Arena* arena = arena_alloc();
+    Debug_SetName(arena, "agent store arena");
+    AgentStore* store = PushStruct(arena, AgentStore);
+    store->arena = arena;
+    store->slot_map = map_create<S64, U32>(arena, Max(capacity, AGENT_STORE_MIN_CAPACITY));
+    store->use_avx2 = _agent_store_avx2_supported();
+    _agent_store_reserve(store, capacity);
+    return store;
+}
+
+g_internal void
+agent_store_release(AgentStore* store)
+{
+    if (store->slot_arena)
+    {
+        arena_release(store->slot_arena);
+    }
+    arena_release(store->arena);
+}
+
+g_internal AgentMotionConfig
+agent_motion_config_default()
+{
+    AgentMotionConfig config = {
+        .interp = AgentMotionInterp_Hermite,
+        .playback_delay_us = 250'000,
+        .max_extrapolation_us = 500'000,
+        .max_extrapolation_m = 25.0,
+        .stale_us = 2'000'000,
+    };
+    return config;
+}
+
+g_internal void
+agent_store_update(async::ThreadPool* thread_pool, AgentStore* store, Buffer<Coordinate> coords, F64* ecef_to_local, F32 scale_factor, const AgentMotionConfig* motion,
+                   U64 now_us)
+{
+    prof_scope_marker;
+    ScratchScope scratch = ScratchScope(0, 0);
+
+    _agent_store_reserve(store, (U64)store->count + coords.size);
+    _AgentStoreUpdateTask task = {
+        .store = store,
+        .update_slots = PushArrayNoZero(scratch.arena, U32, coords.size),
+        .update_us = PushArrayNoZero(scratch.arena, S64, coords.size),
+        .lat = PushArrayNoZero(scratch.arena, F64, coords.size),
+        .lon = PushArrayNoZero(scratch.arena, F64, coords.size),
+        .ecef_x = PushArrayNoZero(scratch.arena, F64, coords.size),
+        .ecef_y = PushArrayNoZero(scratch.arena, F64, coords.size),
+        .ecef_z = PushArrayNoZero(scratch.arena, F64, coords.size),
+        .dead_reckoning_error = PushArrayNoZero(scratch.arena, F64, coords.size),
+        .ecef_to_local = ecef_to_local,
+        .scale_factor = scale_factor,
+        .motion = motion,
+        .render_us = (S64)now_us - (S64)motion->playback_delay_us,
+    };
+
+    // ~mgj: slots. Every agent is updated once, so the sample pass can run its chunks in parallel.
+    {
+        prof_scope_marker_named("agent store slots");
+        U32* slot_update_idxs = PushArrayNoZero(scratch.arena, U32, store->count + coords.size);
+        MemorySet(slot_update_idxs, 0xff, sizeof(U32) * (store->count + coords.size));
+        S64 batch_latency_us = max_S64;
+        for (U64 coord_idx = 0; coord_idx < coords.size; ++coord_idx)
+        {
+            Coordinate* coord = &coords.data[coord_idx];
+            U32 slot = 0;
+            U32* existing = map_get(store->slot_map, coord->id);
+            if (existing)
+            {
+                slot = *existing;
+            }
+            else
+            {
+                slot = store->count++;
+                store->ids[slot] = coord->id;
+                store->sample_head[slot] = 0;
+                store->sample_count[slot] = 0;
+                store->dir_x[slot] = 1.0;
+                store->dir_y[slot] = 0.0;
+                store->dir_z[slot] = 0.0;
+                map_insert(store->slot_map, coord->id, slot);
+            }
+
+            U32 update_idx = slot_update_idxs[slot];
+            if (update_idx == max_U32)
+            {
+                update_idx = task.update_count++;
+                slot_update_idxs[slot] = update_idx;
+                task.update_slots[update_idx] = slot;
+            }
+            else if ((S64)coord->timestamp_us < task.update_us[update_idx])
+            {
+                continue;
+            }
+            task.update_us[update_idx] = (S64)coord->timestamp_us;
+            task.lat[update_idx] = coord->lat;
+            task.lon[update_idx] = coord->lon;
+            batch_latency_us = Min(batch_latency_us, (S64)now_us - (S64)coord->timestamp_us);
+        }
+
+        // ~mgj: feed times move onto the now_us clock by the smallest latency seen. It follows a drop at once and
+        // a rise by 1/64 per update, so one late message does not shift every agent.
+        if (task.update_count)
+        {
+            AgentStoreStats* stats = &store->stats;
+            if (!store->feed_latency_valid || batch_latency_us < stats->feed_latency_us)
+            {
+                stats->feed_latency_us = batch_latency_us;
+                store->feed_latency_valid = true;
+            }
+            else
+            {
+                stats->feed_latency_us += (batch_latency_us - stats->feed_latency_us) / 64;
+            }
+            for (U32 update_idx = 0; update_idx < task.update_count; ++update_idx)
+            {
+                task.update_us[update_idx] = Min(task.update_us[update_idx] + stats->feed_latency_us, (S64)now_us);
+            }
+        }
+    }
+
+    async::parallel_for(thread_pool, task.update_count, 0, _agent_store_sample_task, &task);
+
+    {
+        F64 error_sum = 0.0;
+        F64 error_max = 0.0;
+        U32 error_count = 0;
+        for (U32 update_idx = 0; update_idx < task.update_count; ++update_idx)
+        {
+            F64 error = task.dead_reckoning_error[update_idx];
+            if (error >= 0.0)
+            {
+                error_sum += error;
+                error_max = Max(error_max, error);
+                error_count += 1;
+            }
+        }
+        store->stats.sample_count = task.update_count;
+        store->stats.dead_reckoning_error_mean_m = error_count ? error_sum / (F64)error_count : 0.0;
+        store->stats.dead_reckoning_error_max_m = error_max;
+    }
+
+    if (motion->stale_us)
+    {
+        prof_scope_marker_named("agent store compact");
+        for (U32 slot = 0; slot < store->count;)
+        {
+            S64 newest_us = store->sample_us[(U64)slot * AGENT_STORE_SAMPLE_COUNT + store->sample_head[slot]];
+            if ((S64)now_us - newest_us >= (S64)motion->stale_us)
+            {
+                _agent_store_remove(store, slot);
+                continue;
+            }
+            slot += 1;
+        }
+    }
+
+    async::parallel_for(thread_pool, store->count, 0, _agent_store_frame_task, &task);
+    prof_plot("Agent count", (F64)store->count);
+    prof_plot("Agent dead reckoning error m", store->stats.dead_reckoning_error_mean_m);
+}
+
+g_internal B32
+_agent_store_avx2_supported()
+{
+#if COMPILER_MSVC
+    int info[4] = {};
+    __cpuid(info, 0);
+    if (info[0] < 7)
+    {
+        return false;
+    }
+    __cpuid(info, 1);
+    B32 has_fma = (info[2] & (1 << 12)) != 0;
+    B32 has_osxsave = (info[2] & (1 << 27)) != 0;
+    B32 has_avx = (info[2] & (1 << 28)) != 0;
+    // ~mgj: the OS has to save the ymm registers too
+    if (!has_fma || !has_osxsave || !has_avx || (_xgetbv(0) & 6) != 6)
+    {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+}
+
+g_internal void
+_agent_store_reserve(AgentStore* store, U64 capacity)
+{
+    if (store->slot_arena && store->capacity >= capacity)
+    {
+        return;
+    }
+    U64 new_capacity = Max(Max(capacity, (U64)store->capacity * 2), (U64)AGENT_STORE_MIN_CAPACITY);
+    Arena* slot_arena = arena_alloc();
+    Debug_SetName(slot_arena, "agent store slot arena");
+
+    U64 count = store->count;
+    U64 sample_count = count * AGENT_STORE_SAMPLE_COUNT;
+    U64 sample_capacity = new_capacity * AGENT_STORE_SAMPLE_COUNT;
+    store->ids = _agent_store_array_move(slot_arena, store->ids, count, new_capacity);
+    store->sample_us = _agent_store_array_move(slot_arena, store->sample_us, sample_count, sample_capacity);
+    store->sample_x = _agent_store_array_move(slot_arena, store->sample_x, sample_count, sample_capacity);
+    store->sample_y = _agent_store_array_move(slot_arena, store->sample_y, sample_count, sample_capacity);
+    store->sample_z = _agent_store_array_move(slot_arena, store->sample_z, sample_count, sample_capacity);
+    store->sample_head = _agent_store_array_move(slot_arena, store->sample_head, count, new_capacity);
+    store->sample_count = _agent_store_array_move(slot_arena, store->sample_count, count, new_capacity);
+    store->pos_x = _agent_store_array_move(slot_arena, store->pos_x, count, new_capacity);
+    store->pos_y = _agent_store_array_move(slot_arena, store->pos_y, count, new_capacity);
+    store->pos_z = _agent_store_array_move(slot_arena, store->pos_z, count, new_capacity);
+    store->dir_x = _agent_store_array_move(slot_arena, store->dir_x, count, new_capacity);
+    store->dir_y = _agent_store_array_move(slot_arena, store->dir_y, count, new_capacity);
+    store->dir_z = _agent_store_array_move(slot_arena, store->dir_z, count, new_capacity);
+    store->transforms = _agent_store_array_move(slot_arena, store->transforms, count, new_capacity);
+
+    if (store->slot_arena)
+    {
+        arena_release(store->slot_arena);
+    }
+    store->slot_arena = slot_arena;
+    store->capacity = (U32)new_capacity;
+}
+
+template <typename T>
+g_internal T*
+_agent_store_array_move(Arena* arena, T* array, U64 count, U64 capacity)
+{
+    T* result = PushArrayNoZeroAligned(arena, T, capacity, 64);
+    if (count)
+    {
+        MemoryCopy(result, array, sizeof(T) * count);
+    }
+    return result;
+}
+
+g_internal void
+_agent_store_remove(AgentStore* store, U32 slot)
+{
+    map_remove(store->slot_map, store->ids[slot]);
+    U32 last = store->count - 1;
+    if (slot != last)
+    {
+        store->ids[slot] = store->ids[last];
+        U64 sample_dst = (U64)slot * AGENT_STORE_SAMPLE_COUNT;
+        U64 sample_src = (U64)last * AGENT_STORE_SAMPLE_COUNT;
+        MemoryCopy(store->sample_us + sample_dst, store->sample_us + sample_src, sizeof(S64) * AGENT_STORE_SAMPLE_COUNT);
+        MemoryCopy(store->sample_x + sample_dst, store->sample_x + sample_src, sizeof(F64) * AGENT_STORE_SAMPLE_COUNT);
+        MemoryCopy(store->sample_y + sample_dst, store->sample_y + sample_src, sizeof(F64) * AGENT_STORE_SAMPLE_COUNT);
+        MemoryCopy(store->sample_z + sample_dst, store->sample_z + sample_src, sizeof(F64) * AGENT_STORE_SAMPLE_COUNT);
+        store->sample_head[slot] = store->sample_head[last];
+        store->sample_count[slot] = store->sample_count[last];
+        store->pos_x[slot] = store->pos_x[last];
+        store->pos_y[slot] = store->pos_y[last];
+        store->pos_z[slot] = store->pos_z[last];
+        store->dir_x[slot] = store->dir_x[last];
+        store->dir_y[slot] = store->dir_y[last];
+        store->dir_z[slot] = store->dir_z[last];
+        store->transforms[slot] = store->transforms[last];
+        *map_get(store->slot_map, store->ids[slot]) = slot;
+    }
+    store->count = last;
+}
+
+g_internal void
+_agent_store_sample_task(async::ThreadInfo thread_info, Arena* scratch_arena, void* data, U64 start_idx, U64 end_idx)
+{
+    (void)thread_info;
+    (void)scratch_arena;
+    _AgentStoreUpdateTask* task = (_AgentStoreUpdateTask*)data;
+    AgentStore* store = task->store;
+    U64 count = end_idx - start_idx;
+    F64* ecef_x = task->ecef_x + start_idx;
+    F64* ecef_y = task->ecef_y + start_idx;
+    F64* ecef_z = task->ecef_z + start_idx;
+    if (store->use_avx2)
+    {
+        _agent_store_ecef_from_wgs84_avx2(task->lat + start_idx, task->lon + start_idx, count, ecef_x, ecef_y, ecef_z);
+    }
+    else
+    {
+        _agent_store_ecef_from_wgs84(task->lat + start_idx, task->lon + start_idx, count, ecef_x, ecef_y, ecef_z);
+    }
+
+    for (U64 i = 0; i < count; ++i)
+    {
+        U64 update_idx = start_idx + i;
+        task->dead_reckoning_error[update_idx] =
+            _agent_store_sample_push(store, task->update_slots[update_idx], task->update_us[update_idx], ecef_x[i], ecef_y[i], ecef_z[i], task->motion);
+    }
+}
+
+g_internal void
+_agent_store_frame_task(async::ThreadInfo thread_info, Arena* scratch_arena, void* data, U64 start_idx, U64 end_idx)
+{
+    (void)thread_info;
+    (void)scratch_arena;
+    _AgentStoreUpdateTask* task = (_AgentStoreUpdateTask*)data;
+    _agent_store_motion(task->store, start_idx, end_idx, task->render_us, task->motion);
+    if (task->store->use_avx2)
+    {
+        _agent_store_transforms_avx2(task->store, start_idx, end_idx, task->ecef_to_local, task->scale_factor);
+    }
+    else
+    {
+        _agent_store_transforms(task->store, start_idx, end_idx, task->ecef_to_local, task->scale_factor);
+    }
+}
+
+g_internal F64
+_agent_store_sample_push(AgentStore* store, U32 slot, S64 time_us, F64 x, F64 y, F64 z, const AgentMotionConfig* motion)
+{
+    // ~mgj: returns how far dead reckoning from the previous samples was from this one, or -1
+    U64 base = (U64)slot * AGENT_STORE_SAMPLE_COUNT;
+    U32 count = store->sample_count[slot];
+    U32 head = store->sample_head[slot];
+    F64 error = -1.0;
+    if (count)
+    {
+        S64 newest_us = store->sample_us[base + head];
+        if (time_us < newest_us)
+        {
+            return -1.0;
+        }
+        if (time_us > newest_us)
+        {
+            if (count >= 2)
+            {
+                F64 predicted[3], vel[3];
+                _agent_store_extrapolate(store, slot, time_us, motion, predicted, vel);
+                F64 dx = x - predicted[0], dy = y - predicted[1], dz = z - predicted[2];
+                error = sqrt(dx * dx + dy * dy + dz * dz);
+            }
+            head = (head + 1) % AGENT_STORE_SAMPLE_COUNT;
+            count = Min(count + 1, AGENT_STORE_SAMPLE_COUNT);
+        }
+    }
+    else
+    {
+        count = 1;
+    }
+    store->sample_us[base + head] = time_us;
+    store->sample_x[base + head] = x;
+    store->sample_y[base + head] = y;
+    store->sample_z[base + head] = z;
+    store->sample_head[slot] = (U8)head;
+    store->sample_count[slot] = (U8)count;
+    return error;
+}
+
+g_internal void
+_agent_store_extrapolate(AgentStore* store, U32 slot, S64 time_us, const AgentMotionConfig* motion, F64* out_pos, F64* out_vel)
+{
+    // ~mgj: the velocity between the two newest samples, for at most max_extrapolation_us and max_extrapolation_m
+    U64 base = (U64)slot * AGENT_STORE_SAMPLE_COUNT;
+    U32 head = store->sample_head[slot];
+    F64* samples[3] = {store->sample_x + base, store->sample_y + base, store->sample_z + base};
+    for (U32 c = 0; c < 3; ++c)
+    {
+        out_pos[c] = samples[c][head];
+        out_vel[c] = 0.0;
+    }
+    if (store->sample_count[slot] < 2)
+    {
+        return;
+    }
+    U32 prev = (head + AGENT_STORE_SAMPLE_COUNT - 1) % AGENT_STORE_SAMPLE_COUNT;
+    S64* sample_us = store->sample_us + base;
+    F64 inv_interval_s = 1e6 / (F64)(sample_us[head] - sample_us[prev]);
+    F64 dt_s = (F64)Clamp((S64)0, time_us - sample_us[head], (S64)motion->max_extrapolation_us) * 1e-6;
+    F64 offset[3];
+    for (U32 c = 0; c < 3; ++c)
+    {
+        out_vel[c] = (samples[c][head] - samples[c][prev]) * inv_interval_s;
+        offset[c] = out_vel[c] * dt_s;
+    }
+    F64 offset_len_sq = offset[0] * offset[0] + offset[1] * offset[1] + offset[2] * offset[2];
+    F64 max_sq = motion->max_extrapolation_m * motion->max_extrapolation_m;
+    F64 offset_scale = offset_len_sq > max_sq ? motion->max_extrapolation_m / sqrt(offset_len_sq) : 1.0;
+    for (U32 c = 0; c < 3; ++c)
+    {
+        out_pos[c] += offset[c] * offset_scale;
+    }
+}
+
+// ~mgj: Scalar kernels ////////////////////////////////////
+
+g_internal void
+_agent_store_motion(AgentStore* store, U64 start_idx, U64 end_idx, S64 render_us, const AgentMotionConfig* motion)
+{
+    // ~mgj: before the oldest sample the agent holds it, past the newest it is extrapolated, otherwise it is
+    // interpolated between the samples around render_us. Samples are addressed by age, 0 is the newest.
+    const U32 n = AGENT_STORE_SAMPLE_COUNT;
+    for (U64 slot = start_idx; slot < end_idx; ++slot)
+    {
+        U32 count = store->sample_count[slot];
+        if (count == 0)
+        {
+            continue;
+        }
+        U64 base = slot * n;
+        U32 head = store->sample_head[slot];
+        S64* sample_us = store->sample_us + base;
+        F64* samples[3] = {store->sample_x + base, store->sample_y + base, store->sample_z + base};
+        U32 oldest = (head + n - (count - 1)) % n;
+        F64 pos[3], vel[3];
+        if (render_us >= sample_us[head])
+        {
+            _agent_store_extrapolate(store, (U32)slot, render_us, motion, pos, vel);
+        }
+        else if (render_us <= sample_us[oldest])
+        {
+            for (U32 c = 0; c < 3; ++c)
+            {
+                pos[c] = samples[c][oldest];
+                vel[c] = 0.0;
+            }
+        }
+        else
+        {
+            U32 age = 1;
+            while (sample_us[(head + n - age) % n] > render_us)
+            {
+                age += 1;
+            }
+            U32 i1 = (head + n - age) % n;
+            U32 i2 = (head + n - age + 1) % n;
+            F64 h = (F64)(sample_us[i2] - sample_us[i1]) * 1e-6;
+            F64 s = (F64)(render_us - sample_us[i1]) * 1e-6 / h;
+            if (motion->interp == AgentMotionInterp_Hermite)
+            {
+                // ~mgj: Catmull-Rom tangents from the neighbouring samples, the chord where there is none
+                B32 has_i0 = age + 1 < count;
+                B32 has_i3 = age >= 2;
+                U32 i0 = (head + n - age - 1) % n;
+                U32 i3 = (head + n - age + 2) % n;
+                F64 h1 = has_i0 ? (F64)(sample_us[i2] - sample_us[i0]) * 1e-6 : h;
+                F64 h2 = has_i3 ? (F64)(sample_us[i3] - sample_us[i1]) * 1e-6 : h;
+                F64 s2 = s * s;
+                F64 s3 = s2 * s;
+                F64 h00 = 2.0 * s3 - 3.0 * s2 + 1.0, h10 = s3 - 2.0 * s2 + s, h01 = -2.0 * s3 + 3.0 * s2, h11 = s3 - s2;
+                F64 d00 = 6.0 * s2 - 6.0 * s, d10 = 3.0 * s2 - 4.0 * s + 1.0, d01 = -d00, d11 = 3.0 * s2 - 2.0 * s;
+                for (U32 c = 0; c < 3; ++c)
+                {
+                    F64 p1 = samples[c][i1];
+                    F64 p2 = samples[c][i2];
+                    F64 m1 = ((has_i0 ? p2 - samples[c][i0] : p2 - p1) / h1) * h;
+                    F64 m2 = ((has_i3 ? samples[c][i3] - p1 : p2 - p1) / h2) * h;
+                    pos[c] = h00 * p1 + h10 * m1 + h01 * p2 + h11 * m2;
+                    vel[c] = (d00 * p1 + d10 * m1 + d01 * p2 + d11 * m2) / h;
+                }
+            }
+            else
+            {
+                for (U32 c = 0; c < 3; ++c)
+                {
+                    F64 p1 = samples[c][i1];
+                    F64 p2 = samples[c][i2];
+                    pos[c] = p1 + (p2 - p1) * s;
+                    vel[c] = (p2 - p1) / h;
+                }
+            }
+        }
+
+        store->pos_x[slot] = pos[0];
+        store->pos_y[slot] = pos[1];
+        store->pos_z[slot] = pos[2];
+        if (vel[0] * vel[0] + vel[1] * vel[1] + vel[2] * vel[2] > AGENT_STORE_MIN_SPEED_SQ)
+        {
+            store->dir_x[slot] = vel[0];
+            store->dir_y[slot] = vel[1];
+            store->dir_z[slot] = vel[2];
+        }
+    }
+}
+
+g_internal void
+_agent_store_ecef_from_wgs84(F64* lat, F64* lon, U64 count, F64* ecef_x, F64* ecef_y, F64* ecef_z)
+{
+    // ~mgj: Ellipsoid::cartographicToCartesian at height 0: the surface normal scaled by the squared radii,
+    // divided by the length that puts it on the ellipsoid
+    const F64 deg_to_rad = pi64 / 180.0;
+    const F64 radius_sq_equator = AGENT_STORE_WGS84_RADIUS_EQUATOR * AGENT_STORE_WGS84_RADIUS_EQUATOR;
+    const F64 radius_sq_polar = AGENT_STORE_WGS84_RADIUS_POLAR * AGENT_STORE_WGS84_RADIUS_POLAR;
+    for (U64 i = 0; i < count; ++i)
+    {
+        F64 lat_rad = lat[i] * deg_to_rad;
+        F64 lon_rad = lon[i] * deg_to_rad;
+        F64 cos_lat = cos(lat_rad);
+        F64 normal_x = cos_lat * cos(lon_rad);
+        F64 normal_y = cos_lat * sin(lon_rad);
+        F64 normal_z = sin(lat_rad);
+        F64 k_x = radius_sq_equator * normal_x;
+        F64 k_y = radius_sq_equator * normal_y;
+        F64 k_z = radius_sq_polar * normal_z;
+        F64 inv_gamma = 1.0 / sqrt(normal_x * k_x + normal_y * k_y + normal_z * k_z);
+        ecef_x[i] = k_x * inv_gamma;
+        ecef_y[i] = k_y * inv_gamma;
+        ecef_z[i] = k_z * inv_gamma;
+    }
+}
+
+g_internal void
+_agent_store_transforms(AgentStore* store, U64 start_idx, U64 end_idx, F64* m, F32 scale_factor)
+{
+    // ~mgj: the model faces -x: x is the negated heading in local space, z is x cross up and y is z cross x
+    for (U64 slot = start_idx; slot < end_idx; ++slot)
+    {
+        F64 dir_x = store->dir_x[slot];
+        F64 dir_y = store->dir_y[slot];
+        F64 dir_z = store->dir_z[slot];
+        F64 local_x = m[0] * dir_x + m[4] * dir_y + m[8] * dir_z;
+        F64 local_y = m[1] * dir_x + m[5] * dir_y + m[9] * dir_z;
+        F64 local_z = m[2] * dir_x + m[6] * dir_y + m[10] * dir_z;
+        F64 inv_len = -1.0 / sqrt(local_x * local_x + local_y * local_y + local_z * local_z);
+        F64 x0 = local_x * inv_len;
+        F64 x1 = local_y * inv_len;
+        F64 x2 = local_z * inv_len;
+
+        F64 pos_x = store->pos_x[slot];
+        F64 pos_y = store->pos_y[slot];
+        F64 pos_z = store->pos_z[slot];
+        F64 scale = (F64)scale_factor;
+        Mat4x4F32* t = &store->transforms[slot];
+        t->v[0][0] = (F32)(x0 * scale);
+        t->v[0][1] = (F32)(x1 * scale);
+        t->v[0][2] = (F32)(x2 * scale);
+        t->v[0][3] = 0.0f;
+        t->v[1][0] = (F32)(-x0 * x2 * scale);
+        t->v[1][1] = (F32)(-x1 * x2 * scale);
+        t->v[1][2] = (F32)((x0 * x0 + x1 * x1) * scale);
+        t->v[1][3] = 0.0f;
+        t->v[2][0] = (F32)(x1 * scale);
+        t->v[2][1] = (F32)(-x0 * scale);
+        t->v[2][2] = 0.0f;
+        t->v[2][3] = 0.0f;
+        t->v[3][0] = (F32)(m[0] * pos_x + m[4] * pos_y + m[8] * pos_z + m[12]);
+        t->v[3][1] = (F32)(m[1] * pos_x + m[5] * pos_y + m[9] * pos_z + m[13]);
+        t->v[3][2] = (F32)(m[2] * pos_x + m[6] * pos_y + m[10] * pos_z + m[14]);
+        t->v[3][3] = (F32)(m[3] * pos_x + m[7] * pos_y + m[11] * pos_z + m[15]);
+    }
+}
+
+// ~mgj: AVX2 kernels, 4 agents per iteration and the scalar kernel for the rest /////////////
+
+AGENT_STORE_AVX2 g_internal void
+_agent_store_sincos_avx2(__m256d x, __m256d* out_sin, __m256d* out_cos)
+{
+    // ~mgj: x = q * pi/2 + r with |r| <= pi/4 (pi/2 split in two so q * pi/2 is exact for the q of degrees
+    // that made it here), then the Cephes minimax polynomials on r and the quadrant picks and signs
+    const __m256d two_over_pi = _mm256_set1_pd(0.63661977236758134308);
+    const __m256d pio2_hi = _mm256_set1_pd(1.57079632673412561417e+00);
+    const __m256d pio2_lo = _mm256_set1_pd(6.07710050650619224932e-11);
+    __m256d q = _mm256_round_pd(_mm256_mul_pd(x, two_over_pi), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256d r = _mm256_fnmadd_pd(q, pio2_lo, _mm256_fnmadd_pd(q, pio2_hi, x));
+    __m256d z = _mm256_mul_pd(r, r);
+
+    __m256d sin_poly = _mm256_set1_pd(1.58962301576546568060e-10);
+    sin_poly = _mm256_fmadd_pd(sin_poly, z, _mm256_set1_pd(-2.50507477628578072866e-8));
+    sin_poly = _mm256_fmadd_pd(sin_poly, z, _mm256_set1_pd(2.75573136213857245213e-6));
+    sin_poly = _mm256_fmadd_pd(sin_poly, z, _mm256_set1_pd(-1.98412698295895385996e-4));
+    sin_poly = _mm256_fmadd_pd(sin_poly, z, _mm256_set1_pd(8.33333333332211858878e-3));
+    sin_poly = _mm256_fmadd_pd(sin_poly, z, _mm256_set1_pd(-1.66666666666666307295e-1));
+    __m256d sin_r = _mm256_fmadd_pd(_mm256_mul_pd(sin_poly, z), r, r);
+
+    __m256d cos_poly = _mm256_set1_pd(-1.13585365213876817300e-11);
+    cos_poly = _mm256_fmadd_pd(cos_poly, z, _mm256_set1_pd(2.08757008419747316778e-9));
+    cos_poly = _mm256_fmadd_pd(cos_poly, z, _mm256_set1_pd(-2.75573141792967388112e-7));
+    cos_poly = _mm256_fmadd_pd(cos_poly, z, _mm256_set1_pd(2.48015872888517045348e-5));
+    cos_poly = _mm256_fmadd_pd(cos_poly, z, _mm256_set1_pd(-1.38888888888730564116e-3));
+    cos_poly = _mm256_fmadd_pd(cos_poly, z, _mm256_set1_pd(4.16666666666665929218e-2));
+    __m256d cos_r = _mm256_fmadd_pd(_mm256_mul_pd(cos_poly, z), z, _mm256_fnmadd_pd(_mm256_set1_pd(0.5), z, _mm256_set1_pd(1.0)));
+
+    // ~mgj: odd quadrants swap sin and cos, sin is negative in quadrants 2 and 3, cos in 1 and 2
+    __m256i quadrant = _mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(q));
+    __m256i one = _mm256_set1_epi64x(1);
+    __m256i two = _mm256_set1_epi64x(2);
+    __m256d swap = _mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_and_si256(quadrant, one), one));
+    __m256d sin_sign = _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_and_si256(quadrant, two), 62));
+    __m256d cos_sign = _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_and_si256(_mm256_add_epi64(quadrant, one), two), 62));
+    *out_sin = _mm256_xor_pd(_mm256_blendv_pd(sin_r, cos_r, swap), sin_sign);
+    *out_cos = _mm256_xor_pd(_mm256_blendv_pd(cos_r, sin_r, swap), cos_sign);
+}
+
+AGENT_STORE_AVX2 g_internal void
+_agent_store_ecef_from_wgs84_avx2(F64* lat, F64* lon, U64 count, F64* ecef_x, F64* ecef_y, F64* ecef_z)
+{
+    const __m256d deg_to_rad = _mm256_set1_pd(pi64 / 180.0);
+    const __m256d radius_sq_equator = _mm256_set1_pd(AGENT_STORE_WGS84_RADIUS_EQUATOR * AGENT_STORE_WGS84_RADIUS_EQUATOR);
+    const __m256d radius_sq_polar = _mm256_set1_pd(AGENT_STORE_WGS84_RADIUS_POLAR * AGENT_STORE_WGS84_RADIUS_POLAR);
+    U64 i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m256d sin_lat, cos_lat, sin_lon, cos_lon;
+        _agent_store_sincos_avx2(_mm256_mul_pd(_mm256_loadu_pd(lat + i), deg_to_rad), &sin_lat, &cos_lat);
+        _agent_store_sincos_avx2(_mm256_mul_pd(_mm256_loadu_pd(lon + i), deg_to_rad), &sin_lon, &cos_lon);
+        __m256d normal_x = _mm256_mul_pd(cos_lat, cos_lon);
+        __m256d normal_y = _mm256_mul_pd(cos_lat, sin_lon);
+        __m256d k_x = _mm256_mul_pd(radius_sq_equator, normal_x);
+        __m256d k_y = _mm256_mul_pd(radius_sq_equator, normal_y);
+        __m256d k_z = _mm256_mul_pd(radius_sq_polar, sin_lat);
+        __m256d gamma_sq = _mm256_fmadd_pd(normal_x, k_x, _mm256_fmadd_pd(normal_y, k_y, _mm256_mul_pd(sin_lat, k_z)));
+        __m256d inv_gamma = _mm256_div_pd(_mm256_set1_pd(1.0), _mm256_sqrt_pd(gamma_sq));
+        _mm256_storeu_pd(ecef_x + i, _mm256_mul_pd(k_x, inv_gamma));
+        _mm256_storeu_pd(ecef_y + i, _mm256_mul_pd(k_y, inv_gamma));
+        _mm256_storeu_pd(ecef_z + i, _mm256_mul_pd(k_z, inv_gamma));
+    }
+    _agent_store_ecef_from_wgs84(lat + i, lon + i, count - i, ecef_x + i, ecef_y + i, ecef_z + i);
+}
+
+AGENT_STORE_AVX2 g_internal void
+_agent_store_transforms_avx2(AgentStore* store, U64 start_idx, U64 end_idx, F64* m, F32 scale_factor)
+{
+    __m256d m_col[16];
+    for (U32 i = 0; i < 16; ++i)
+    {
+        m_col[i] = _mm256_set1_pd(m[i]);
+    }
+    const __m256d scale = _mm256_set1_pd((F64)scale_factor);
+    const __m256d minus_one = _mm256_set1_pd(-1.0);
+    const __m128 zero = _mm_setzero_ps();
+
+    U64 slot = start_idx;
+    for (; slot + 4 <= end_idx; slot += 4)
+    {
+        __m256d dir_x = _mm256_loadu_pd(store->dir_x + slot);
+        __m256d dir_y = _mm256_loadu_pd(store->dir_y + slot);
+        __m256d dir_z = _mm256_loadu_pd(store->dir_z + slot);
+        __m256d local_x = _mm256_fmadd_pd(m_col[0], dir_x, _mm256_fmadd_pd(m_col[4], dir_y, _mm256_mul_pd(m_col[8], dir_z)));
+        __m256d local_y = _mm256_fmadd_pd(m_col[1], dir_x, _mm256_fmadd_pd(m_col[5], dir_y, _mm256_mul_pd(m_col[9], dir_z)));
+        __m256d local_z = _mm256_fmadd_pd(m_col[2], dir_x, _mm256_fmadd_pd(m_col[6], dir_y, _mm256_mul_pd(m_col[10], dir_z)));
+        __m256d len_sq = _mm256_fmadd_pd(local_x, local_x, _mm256_fmadd_pd(local_y, local_y, _mm256_mul_pd(local_z, local_z)));
+        __m256d inv_len = _mm256_div_pd(minus_one, _mm256_sqrt_pd(len_sq));
+        __m256d x0 = _mm256_mul_pd(local_x, inv_len);
+        __m256d x1 = _mm256_mul_pd(local_y, inv_len);
+        __m256d x2 = _mm256_mul_pd(local_z, inv_len);
+
+        __m256d pos_x = _mm256_loadu_pd(store->pos_x + slot);
+        __m256d pos_y = _mm256_loadu_pd(store->pos_y + slot);
+        __m256d pos_z = _mm256_loadu_pd(store->pos_z + slot);
+        __m256d w0 = _mm256_fmadd_pd(m_col[0], pos_x, _mm256_fmadd_pd(m_col[4], pos_y, _mm256_fmadd_pd(m_col[8], pos_z, m_col[12])));
+        __m256d w1 = _mm256_fmadd_pd(m_col[1], pos_x, _mm256_fmadd_pd(m_col[5], pos_y, _mm256_fmadd_pd(m_col[9], pos_z, m_col[13])));
+        __m256d w2 = _mm256_fmadd_pd(m_col[2], pos_x, _mm256_fmadd_pd(m_col[6], pos_y, _mm256_fmadd_pd(m_col[10], pos_z, m_col[14])));
+        __m256d w3 = _mm256_fmadd_pd(m_col[3], pos_x, _mm256_fmadd_pd(m_col[7], pos_y, _mm256_fmadd_pd(m_col[11], pos_z, m_col[15])));
+
+        // ~mgj: one register per component of 4 agents, transposed 4x4 at a time into the per agent rows
+        __m128 x_basis[4] = {_mm256_cvtpd_ps(_mm256_mul_pd(x0, scale)), _mm256_cvtpd_ps(_mm256_mul_pd(x1, scale)), _mm256_cvtpd_ps(_mm256_mul_pd(x2, scale)), zero};
+        __m128 y_basis[4] = {_mm256_cvtpd_ps(_mm256_mul_pd(_mm256_mul_pd(x0, x2), _mm256_mul_pd(scale, minus_one))),
+                             _mm256_cvtpd_ps(_mm256_mul_pd(_mm256_mul_pd(x1, x2), _mm256_mul_pd(scale, minus_one))),
+                             _mm256_cvtpd_ps(_mm256_mul_pd(_mm256_fmadd_pd(x0, x0, _mm256_mul_pd(x1, x1)), scale)), zero};
+        __m128 z_basis[4] = {x_basis[1], _mm_sub_ps(zero, x_basis[0]), zero, zero};
+        __m128 w_basis[4] = {_mm256_cvtpd_ps(w0), _mm256_cvtpd_ps(w1), _mm256_cvtpd_ps(w2), _mm256_cvtpd_ps(w3)};
+        _MM_TRANSPOSE4_PS(x_basis[0], x_basis[1], x_basis[2], x_basis[3]);
+        _MM_TRANSPOSE4_PS(y_basis[0], y_basis[1], y_basis[2], y_basis[3]);
+        _MM_TRANSPOSE4_PS(z_basis[0], z_basis[1], z_basis[2], z_basis[3]);
+        _MM_TRANSPOSE4_PS(w_basis[0], w_basis[1], w_basis[2], w_basis[3]);
+        for (U32 i = 0; i < 4; ++i)
+        {
+            F32* t = &store->transforms[slot + i].v[0][0];
+            _mm_storeu_ps(t + 0, x_basis[i]);
+            _mm_storeu_ps(t + 4, y_basis[i]);
+            _mm_storeu_ps(t + 8, z_basis[i]);
+            _mm_storeu_ps(t + 12, w_basis[i]);
+        }
+    }
+    _agent_store_transforms(store, slot, end_idx, m, scale_factor);
+}
+
+} // namespace city
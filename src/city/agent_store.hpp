@@ -0,0 +1,150 @@
+#pragma once
+
+// ~mgj: MSVC takes AVX2 intrinsics anywhere, GCC and Clang only in functions built for the target
+#if COMPILER_MSVC
+#define AGENT_STORE_AVX2
+#else
+#define AGENT_STORE_AVX2 __attribute__((target("avx2,fma")))
+#endif
+
+namespace city
+{
+// ~mgj: Live feed agents as a structure of arrays, slots [0, count) are live. Every agent keeps a ring of its
+// last AGENT_STORE_SAMPLE_COUNT positions with their feed times, and the render position and heading are
+// evaluated from it every frame at now - playback_delay: between two samples by linear or Hermite
+// interpolation, past the newest one by dead reckoning from the last velocity, up to the extrapolation bounds.
+// An update runs in four passes:
+//   slots      serial, map lookup per coordinate, new agents are appended (the newest coordinate of an agent wins)
+//   samples    parallel over the updated agents, WGS84 to ECEF 4 at a time, pushed into the sample rings
+//   compact    serial, agents without a sample for stale_us are swapped out with the last slot
+//   frame      parallel over all live agents, the motion model, then ECEF to local and the model basis 4 at a time
+// so transforms[0, count) is the instance buffer of the frame as is. The 4 wide kernels use AVX2 and FMA
+// when the CPU has them (the build only assumes SSE4), the scalar kernels are the reference and the fallback.
+const U32 AGENT_STORE_MIN_CAPACITY = 1024;
+// ~mgj: Hermite interpolation needs the samples on both sides of the interval
+const U32 AGENT_STORE_SAMPLE_COUNT = 4;
+// ~mgj: slower than this (square meters per second) keeps the previous heading, so standing agents do not spin
+const F64 AGENT_STORE_MIN_SPEED_SQ = 0.01;
+const F64 AGENT_STORE_WGS84_RADIUS_EQUATOR = 6378137.0;
+const F64 AGENT_STORE_WGS84_RADIUS_POLAR = 6356752.3142451793;
+
+#define AGENT_MOTION_INTERPS \
+    X(Linear, "Linear")      \
+    X(Hermite, "Hermite")
+
+enum AgentMotionInterp : U32
+{
+#define X(name, str) AgentMotionInterp_##name,
+    AGENT_MOTION_INTERPS
+#undef X
+        AgentMotionInterp_Count
+};
+
+struct AgentMotionConfig
+{
+    AgentMotionInterp interp;
+    U64 playback_delay_us;    // about one feed interval plus jitter keeps agents between two samples
+    U64 max_extrapolation_us; // dead reckoning stops this long after the newest sample and the agent holds
+    F64 max_extrapolation_m;  // and never moves further than this from it
+    U64 stale_us;             // agents without a sample for this long are removed, 0 keeps them forever
+};
+
+struct AgentStoreStats
+{
+    S64 feed_latency_us;             // the smallest feed time to arrival seen lately, maps feed times onto now_us
+    U32 sample_count;                // samples pushed by the last update
+    F64 dead_reckoning_error_mean_m; // how far the extrapolation was from the samples of the last update
+    F64 dead_reckoning_error_max_m;
+};
+
+struct AgentStore
+{
+    Arena* arena;
+    Arena* slot_arena; // per slot arrays, replaced when they grow
+    Map<S64, U32>* slot_map;
+    U32 count;
+    U32 capacity;
+    B32 use_avx2; // set on create when the CPU supports AVX2 and FMA
+    B32 feed_latency_valid;
+    AgentStoreStats stats;
+
+    S64* ids;
+    // ~mgj: AGENT_STORE_SAMPLE_COUNT per slot, a ring from sample_head back sample_count entries
+    S64* sample_us; // feed time on the now_us clock
+    F64* sample_x;  // ECEF
+    F64* sample_y;
+    F64* sample_z;
+    U8* sample_head;
+    U8* sample_count;
+    F64* pos_x; // ECEF, evaluated for the frame
+    F64* pos_y;
+    F64* pos_z;
+    F64* dir_x; // ECEF, the velocity of the frame or the last one fast enough
+    F64* dir_y;
+    F64* dir_z;
+    Mat4x4F32* transforms; // render::Transform layout: x, y, z basis and position in local coordinates
+};
+
+g_internal AgentStore*
+agent_store_create(U32 capacity);
+g_internal void
+agent_store_release(AgentStore* store);
+g_internal AgentMotionConfig
+agent_motion_config_default();
+// ~mgj: ecef_to_local is a column major 4x4 matrix. now_us is the frame clock (os_now_microseconds), the
+// coordinate timestamps (unix microseconds) are mapped onto it by the feed latency. Runs every frame, with or
+// without coordinates.
+g_internal void
+agent_store_update(async::ThreadPool* thread_pool, AgentStore* store, Buffer<Coordinate> coords, F64* ecef_to_local, F32 scale_factor, const AgentMotionConfig* motion,
+                   U64 now_us);
+
+// ~mgj: internal
+struct _AgentStoreUpdateTask
+{
+    AgentStore* store;
+    U32 update_count;
+    U32* update_slots;
+    S64* update_us;
+    F64* lat;
+    F64* lon;
+    F64* ecef_x;
+    F64* ecef_y;
+    F64* ecef_z;
+    F64* dead_reckoning_error; // per update, negative when the agent had nothing to extrapolate from
+    F64* ecef_to_local;
+    F32 scale_factor;
+    const AgentMotionConfig* motion;
+    S64 render_us;
+};
+
+g_internal B32
+_agent_store_avx2_supported();
+g_internal void
+_agent_store_reserve(AgentStore* store, U64 capacity);
+template <typename T>
+g_internal T*
+_agent_store_array_move(Arena* arena, T* array, U64 count, U64 capacity);
+g_internal void
+_agent_store_remove(AgentStore* store, U32 slot);
+g_internal void
+_agent_store_sample_task(async::ThreadInfo thread_info, Arena* scratch_arena, void* data, U64 start_idx, U64 end_idx);
+g_internal void
+_agent_store_frame_task(async::ThreadInfo thread_info, Arena* scratch_arena, void* data, U64 start_idx, U64 end_idx);
+g_internal F64
+_agent_store_sample_push(AgentStore* store, U32 slot, S64 time_us, F64 x, F64 y, F64 z, const AgentMotionConfig* motion);
+g_internal void
+_agent_store_extrapolate(AgentStore* store, U32 slot, S64 time_us, const AgentMotionConfig* motion, F64* out_pos, F64* out_vel);
+
+g_internal void
+_agent_store_ecef_from_wgs84(F64* lat, F64* lon, U64 count, F64* ecef_x, F64* ecef_y, F64* ecef_z);
+g_internal void
+_agent_store_motion(AgentStore* store, U64 start_idx, U64 end_idx, S64 render_us, const AgentMotionConfig* motion);
+g_internal void
+_agent_store_transforms(AgentStore* store, U64 start_idx, U64 end_idx, F64* ecef_to_local, F32 scale_factor);
+AGENT_STORE_AVX2 g_internal void
+_agent_store_sincos_avx2(__m256d x, __m256d* out_sin, __m256d* out_cos);
+AGENT_STORE_AVX2 g_internal void
+_agent_store_ecef_from_wgs84_avx2(F64* lat, F64* lon, U64 count, F64* ecef_x, F64* ecef_y, F64* ecef_z);
+AGENT_STORE_AVX2 g_internal void
+_agent_store_transforms_avx2(AgentStore* store, U64 start_idx, U64 end_idx, F64* ecef_to_local, F32 scale_factor);
+} // namespace city
@@ -0,0 +1,318 @@
+namespace city
+{
+static_assert(offsetof(Coordinate, lon) == offsetof(Coordinate, lat) + sizeof(F64), "the decoder stores lat and lon with one 16 byte store");
+
+g_internal void
+agent_wire_state_init(AgentWireState* state)
+{
+    *state = {};
+    state->arena = arena_alloc();
+    Debug_SetName(state->arena, "agent wire state arena");
+}
+
+g_internal void
+agent_wire_state_release(AgentWireState* state)
+{
+    arena_release(state->arena);
+    *state = {};
+}
+
+g_internal B32
+agent_wire_is_frame(String8 msg)
+{
+    U32 magic = 0;
+    if (msg.size < sizeof(magic))
+    {
+        return false;
+    }
+    MemoryCopy(&magic, msg.str, sizeof(magic));
+    return magic == AGENT_WIRE_MAGIC;
+}
+
+g_internal B32
+agent_wire_decode(Arena* arena, AgentWireState* state, String8 msg, U64 now_us, Buffer<Coordinate>* out)
+{
+    prof_scope_marker;
+    *out = {};
+    AgentWireHeader header = {};
+    if (msg.size < sizeof(header))
+    {
+        return false;
+    }
+    MemoryCopy(&header, msg.str, sizeof(header));
+    if (header.magic != AGENT_WIRE_MAGIC || header.version != AGENT_WIRE_VERSION || header.encoding >= AgentWireEncoding_Count)
+    {
+        return false;
+    }
+
+    U64 count = header.count;
+    B32 is_delta = (header.flags & AgentWireFlag_Delta) != 0;
+    if (is_delta && header.encoding != AgentWireEncoding_Fixed32)
+    {
+        return false;
+    }
+    U64 position_size = header.encoding == AgentWireEncoding_F64 ? sizeof(F64) : sizeof(S32);
+    U64 payload_size = is_delta ? count * 2 * sizeof(S16) : count * (sizeof(S64) + 2 * position_size);
+    if (msg.size - sizeof(header) < payload_size)
+    {
+        return false;
+    }
+    U8* payload = msg.str + sizeof(header);
+    U64 timestamp_us = header.timestamp_us ? header.timestamp_us : now_us;
+
+    if (is_delta)
+    {
+        // ~mgj: a lost or reordered frame breaks the chain until the next key frame
+        if (!state->valid || state->sequence != header.base_sequence || state->count != count)
+        {
+            return false;
+        }
+        _agent_wire_delta_apply(state->lat_fixed, payload, header.count);
+        _agent_wire_delta_apply(state->lon_fixed, payload + count * sizeof(S16), header.count);
+        state->sequence = header.sequence;
+        *out = buffer_alloc<Coordinate>(arena, count);
+        _agent_wire_coords_from_fixed(out->data, state->ids, state->lat_fixed, state->lon_fixed, header.count, timestamp_us);
+        return true;
+    }
+
+    _agent_wire_state_reserve(state, header.count);
+    MemoryCopy(state->ids, payload, count * sizeof(S64));
+    state->count = header.count;
+    state->sequence = header.sequence;
+    U8* lat = payload + count * sizeof(S64);
+    U8* lon = lat + count * position_size;
+    *out = buffer_alloc<Coordinate>(arena, count);
+    if (header.encoding == AgentWireEncoding_F64)
+    {
+        // ~mgj: deltas are fixed point only, an F64 frame cannot be a base
+        state->valid = false;
+        _agent_wire_coords_from_f64(out->data, state->ids, lat, lon, header.count, timestamp_us);
+    }
+    else
+    {
+        MemoryCopy(state->lat_fixed, lat, count * sizeof(S32));
+        MemoryCopy(state->lon_fixed, lon, count * sizeof(S32));
+        state->valid = true;
+        _agent_wire_coords_from_fixed(out->data, state->ids, state->lat_fixed, state->lon_fixed, header.count, timestamp_us);
+    }
+    return true;
+}
+
+g_internal AgentWireEncoder*
+agent_wire_encoder_create(AgentWireEncoding encoding, B32 delta, U32 key_interval)
+{
+    Arena* arena = arena_alloc();
+    Debug_SetName(arena, "agent wire encoder arena");
+    AgentWireEncoder* encoder = PushStruct(arena, AgentWireEncoder);
+    encoder->arena = arena;
+    encoder->encoding = encoding;
+    encoder->delta = delta && encoding == AgentWireEncoding_Fixed32;
+    encoder->key_interval = key_interval;
+    agent_wire_state_init(&encoder->state);
+    return encoder;
+}
+
+g_internal void
+agent_wire_encoder_release(AgentWireEncoder* encoder)
+{
+    agent_wire_state_release(&encoder->state);
+    arena_release(encoder->arena);
+}
+
+g_internal String8
+agent_wire_encode(Arena* arena, AgentWireEncoder* encoder, Buffer<Coordinate> coords, U64 timestamp_us)
+{
+    prof_scope_marker;
+    AgentWireState* state = &encoder->state;
+    U32 count = (U32)coords.size;
+    AgentWireHeader header = {};
+    header.magic = AGENT_WIRE_MAGIC;
+    header.version = AGENT_WIRE_VERSION;
+    header.encoding = encoder->encoding;
+    header.count = count;
+    header.sequence = encoder->sequence++;
+    header.timestamp_us = timestamp_us;
+
+    B32 key_due = encoder->key_interval && encoder->frames_since_key >= encoder->key_interval;
+    if (encoder->delta && state->valid && state->count == count && !key_due)
+    {
+        U64 frame_size = sizeof(header) + (U64)count * 2 * sizeof(S16);
+        U64 frame_pos = arena_pos(arena);
+        U8* frame = PushArrayNoZero(arena, U8, frame_size);
+        S16* lat_delta = (S16*)(frame + sizeof(header));
+        S16* lon_delta = lat_delta + count;
+        if (_agent_wire_delta_encode(state, coords, lat_delta, lon_delta))
+        {
+            header.flags = AgentWireFlag_Delta;
+            header.base_sequence = state->sequence;
+            MemoryCopy(frame, &header, sizeof(header));
+            state->sequence = header.sequence;
+            encoder->frames_since_key += 1;
+            return str8(frame, frame_size);
+        }
+        arena_pop_to(arena, frame_pos);
+    }
+
+    U64 position_size = encoder->encoding == AgentWireEncoding_F64 ? sizeof(F64) : sizeof(S32);
+    U64 frame_size = sizeof(header) + (U64)count * (sizeof(S64) + 2 * position_size);
+    U8* frame = PushArrayNoZero(arena, U8, frame_size);
+    MemoryCopy(frame, &header, sizeof(header));
+    _agent_wire_state_reserve(state, count);
+    for (U32 i = 0; i < count; ++i)
+    {
+        state->ids[i] = coords.data[i].id;
+    }
+    state->count = count;
+    state->sequence = header.sequence;
+    U8* ids = frame + sizeof(header);
+    U8* lat = ids + (U64)count * sizeof(S64);
+    U8* lon = lat + (U64)count * position_size;
+    MemoryCopy(ids, state->ids, (U64)count * sizeof(S64));
+    if (encoder->encoding == AgentWireEncoding_F64)
+    {
+        for (U32 i = 0; i < count; ++i)
+        {
+            MemoryCopy(lat + i * sizeof(F64), &coords.data[i].lat, sizeof(F64));
+            MemoryCopy(lon + i * sizeof(F64), &coords.data[i].lon, sizeof(F64));
+        }
+        state->valid = false;
+    }
+    else
+    {
+        for (U32 i = 0; i < count; ++i)
+        {
+            state->lat_fixed[i] = (S32)llround(coords.data[i].lat * AGENT_WIRE_FIXED_SCALE);
+            state->lon_fixed[i] = (S32)llround(coords.data[i].lon * AGENT_WIRE_FIXED_SCALE);
+        }
+        MemoryCopy(lat, state->lat_fixed, (U64)count * sizeof(S32));
+        MemoryCopy(lon, state->lon_fixed, (U64)count * sizeof(S32));
+        state->valid = true;
+    }
+    encoder->frames_since_key = 0;
+    return str8(frame, frame_size);
+}
+
+g_internal void
+_agent_wire_state_reserve(AgentWireState* state, U32 count)
+{
+    // ~mgj: only key frames grow the state and they overwrite all of it, nothing has to be kept
+    if (state->capacity >= count)
+    {
+        return;
+    }
+    state->capacity = Max(count + count / 2, 1024u);
+    arena_clear(state->arena);
+    state->ids = PushArrayNoZeroAligned(state->arena, S64, state->capacity, 64);
+    state->lat_fixed = PushArrayNoZeroAligned(state->arena, S32, state->capacity, 64);
+    state->lon_fixed = PushArrayNoZeroAligned(state->arena, S32, state->capacity, 64);
+    state->valid = false;
+}
+
+g_internal void
+_agent_wire_coords_from_f64(Coordinate* out, S64* ids, U8* lat, U8* lon, U32 count, U64 timestamp_us)
+{
+    U32 i = 0;
+    for (; i + 2 <= count; i += 2)
+    {
+        __m128d lat_2 = _mm_loadu_pd((F64*)(lat + i * sizeof(F64)));
+        __m128d lon_2 = _mm_loadu_pd((F64*)(lon + i * sizeof(F64)));
+        out[i].id = ids[i];
+        out[i].timestamp_us = timestamp_us;
+        out[i + 1].id = ids[i + 1];
+        out[i + 1].timestamp_us = timestamp_us;
+        _mm_storeu_pd(&out[i].lat, _mm_unpacklo_pd(lat_2, lon_2));
+        _mm_storeu_pd(&out[i + 1].lat, _mm_unpackhi_pd(lat_2, lon_2));
+    }
+    for (; i < count; ++i)
+    {
+        out[i].id = ids[i];
+        out[i].timestamp_us = timestamp_us;
+        MemoryCopy(&out[i].lat, lat + i * sizeof(F64), sizeof(F64));
+        MemoryCopy(&out[i].lon, lon + i * sizeof(F64), sizeof(F64));
+    }
+}
+
+g_internal void
+_agent_wire_coords_from_fixed(Coordinate* out, S64* ids, S32* lat_fixed, S32* lon_fixed, U32 count, U64 timestamp_us)
+{
+    const F64 scale = 1.0 / AGENT_WIRE_FIXED_SCALE;
+    __m128d scale_2 = _mm_set1_pd(scale);
+    U32 i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i lat_4 = _mm_loadu_si128((__m128i*)(lat_fixed + i));
+        __m128i lon_4 = _mm_loadu_si128((__m128i*)(lon_fixed + i));
+        __m128d lat_lo = _mm_mul_pd(_mm_cvtepi32_pd(lat_4), scale_2);
+        __m128d lat_hi = _mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(lat_4, 8)), scale_2);
+        __m128d lon_lo = _mm_mul_pd(_mm_cvtepi32_pd(lon_4), scale_2);
+        __m128d lon_hi = _mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(lon_4, 8)), scale_2);
+        for (U32 j = 0; j < 4; ++j)
+        {
+            out[i + j].id = ids[i + j];
+            out[i + j].timestamp_us = timestamp_us;
+        }
+        _mm_storeu_pd(&out[i + 0].lat, _mm_unpacklo_pd(lat_lo, lon_lo));
+        _mm_storeu_pd(&out[i + 1].lat, _mm_unpackhi_pd(lat_lo, lon_lo));
+        _mm_storeu_pd(&out[i + 2].lat, _mm_unpacklo_pd(lat_hi, lon_hi));
+        _mm_storeu_pd(&out[i + 3].lat, _mm_unpackhi_pd(lat_hi, lon_hi));
+    }
+    for (; i < count; ++i)
+    {
+        out[i].id = ids[i];
+        out[i].timestamp_us = timestamp_us;
+        out[i].lat = (F64)lat_fixed[i] * scale;
+        out[i].lon = (F64)lon_fixed[i] * scale;
+    }
+}
+
+g_internal void
+_agent_wire_delta_apply(S32* fixed, U8* delta, U32 count)
+{
+    U32 i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i delta_8 = _mm_loadu_si128((__m128i*)(delta + i * sizeof(S16)));
+        __m128i delta_lo = _mm_cvtepi16_epi32(delta_8);
+        __m128i delta_hi = _mm_cvtepi16_epi32(_mm_srli_si128(delta_8, 8));
+        __m128i fixed_lo = _mm_loadu_si128((__m128i*)(fixed + i));
+        __m128i fixed_hi = _mm_loadu_si128((__m128i*)(fixed + i + 4));
+        _mm_storeu_si128((__m128i*)(fixed + i), _mm_add_epi32(fixed_lo, delta_lo));
+        _mm_storeu_si128((__m128i*)(fixed + i + 4), _mm_add_epi32(fixed_hi, delta_hi));
+    }
+    for (; i < count; ++i)
+    {
+        S16 value = 0;
+        MemoryCopy(&value, delta + i * sizeof(S16), sizeof(S16));
+        // ~mgj: wraps like the vector add on a malformed feed
+        fixed[i] = (S32)((U32)fixed[i] + (U32)(S32)value);
+    }
+}
+
+g_internal B32
+_agent_wire_delta_encode(AgentWireState* state, Buffer<Coordinate> coords, S16* lat_delta, S16* lon_delta)
+{
+    for (U64 i = 0; i < coords.size; ++i)
+    {
+        if (coords.data[i].id != state->ids[i])
+        {
+            return false;
+        }
+        S64 lat = llround(coords.data[i].lat * AGENT_WIRE_FIXED_SCALE) - state->lat_fixed[i];
+        S64 lon = llround(coords.data[i].lon * AGENT_WIRE_FIXED_SCALE) - state->lon_fixed[i];
+        if (lat < -32768 || lat > 32767 || lon < -32768 || lon > 32767)
+        {
+            return false;
+        }
+        lat_delta[i] = (S16)lat;
+        lon_delta[i] = (S16)lon;
+    }
+    // ~mgj: the state is what the decoder holds after this frame, the quantized positions
+    for (U64 i = 0; i < coords.size; ++i)
+    {
+        state->lat_fixed[i] += lat_delta[i];
+        state->lon_fixed[i] += lon_delta[i];
+    }
+    return true;
+}
+
+} // namespace city
@@ -0,0 +1,104 @@
+#pragma once
+
+namespace city
+{
+// ~mgj: Binary agent position frames, the compact alternative to the JSON feed. A frame is one websocket
+// message and starts with AGENT_WIRE_MAGIC, so binary and JSON messages can be mixed on one connection.
+// All fields are little endian, the payload is stored per field so it decodes with plain vector loads:
+//   key frame    AgentWireHeader, S64 id[count], lat[count], lon[count]
+//                lat/lon are F64 degrees or S32 fixed point in AGENT_WIRE_FIXED_SCALE units per degree
+//   delta frame  AgentWireHeader, S16 lat_delta[count], S16 lon_delta[count]
+//                fixed point deltas against the frame with sequence base_sequence, same ids in the same order
+// A delta frame whose base was not the last frame decoded is dropped, the chain picks up at the next key
+// frame. The encoder writes a key frame when the agent set changes, a delta does not fit in S16 (about
+// 360 m of latitude at 1e-7 degrees) or key_interval frames have passed.
+#define AGENT_WIRE_SUBPROTOCOL "dtcity.agents.bin.v1"
+#define AGENT_WIRE_JSON_SUBPROTOCOL "dtcity.agents.json"
+const U32 AGENT_WIRE_MAGIC = 0x47415444; // "DTAG"
+const U8 AGENT_WIRE_VERSION = 1;
+const F64 AGENT_WIRE_FIXED_SCALE = 1e7;
+
+enum AgentWireEncoding : U8
+{
+    AgentWireEncoding_F64,
+    AgentWireEncoding_Fixed32,
+    AgentWireEncoding_Count,
+};
+
+enum : U8
+{
+    AgentWireFlag_Delta = (1 << 0),
+};
+
+struct AgentWireHeader
+{
+    U32 magic;
+    U8 version;
+    U8 encoding; // AgentWireEncoding
+    U8 flags;
+    U8 reserved;
+    U32 count;
+    U32 sequence;
+    U32 base_sequence; // delta frames only
+    U32 reserved_2;
+    U64 timestamp_us; // feed time of every position in the frame in unix microseconds, 0 for the time of arrival
+};
+static_assert(sizeof(AgentWireHeader) == 32, "AgentWireHeader is part of the wire format");
+
+// ~mgj: Fixed point positions of the last Fixed32 frame, the base of the next delta frame. Held by the
+// decoder and mirrored by the encoder.
+struct AgentWireState
+{
+    Arena* arena;
+    U32 capacity;
+    U32 count;
+    U32 sequence;
+    B32 valid;
+    S64* ids;
+    S32* lat_fixed;
+    S32* lon_fixed;
+};
+
+struct AgentWireEncoder
+{
+    Arena* arena;
+    AgentWireEncoding encoding;
+    B32 delta;
+    U32 key_interval; // 0 only starts a new key frame when a delta does not work
+    U32 sequence;
+    U32 frames_since_key;
+    AgentWireState state;
+};
+
+g_internal void
+agent_wire_state_init(AgentWireState* state);
+g_internal void
+agent_wire_state_release(AgentWireState* state);
+
+g_internal B32
+agent_wire_is_frame(String8 msg);
+// ~mgj: Decodes a frame into coordinates allocated in arena. Returns false for a malformed frame or a delta
+// frame without its base, out is empty then.
+g_internal B32
+agent_wire_decode(Arena* arena, AgentWireState* state, String8 msg, U64 now_us, Buffer<Coordinate>* out);
+
+// ~mgj: delta is ignored for AgentWireEncoding_F64
+g_internal AgentWireEncoder*
+agent_wire_encoder_create(AgentWireEncoding encoding, B32 delta, U32 key_interval);
+g_internal void
+agent_wire_encoder_release(AgentWireEncoder* encoder);
+g_internal String8
+agent_wire_encode(Arena* arena, AgentWireEncoder* encoder, Buffer<Coordinate> coords, U64 timestamp_us);
+
+// ~mgj: internal
+g_internal void
+_agent_wire_state_reserve(AgentWireState* state, U32 count);
+g_internal void
+_agent_wire_coords_from_f64(Coordinate* out, S64* ids, U8* lat, U8* lon, U32 count, U64 timestamp_us);
+g_internal void
+_agent_wire_coords_from_fixed(Coordinate* out, S64* ids, S32* lat_fixed, S32* lon_fixed, U32 count, U64 timestamp_us);
+g_internal void
+_agent_wire_delta_apply(S32* fixed, U8* delta, U32 count);
+g_internal B32
+_agent_wire_delta_encode(AgentWireState* state, Buffer<Coordinate> coords, S16* lat_delta, S16* lon_delta);
+} // namespace city
@@ -11,6 +11,8 @@ city_init(City* city, String8 cache_path)
     city->cache_path = push_str8_copy(arena, cache_path);
     city->arena = arena;
     city->agent_scale_factor = 1.0f;
+    city->agent_motion = agent_motion_config_default();
+    city->agent_road_snap_distance = 15.0f;
 }
 
 g_internal void
@@ -83,12 +85,40 @@ city_build(City* city, Rng2F64 bbox, String8 tileset_url, String8 area)
     neta::neta_init(neta_state, ctx->data_subdirs.data[dt_DataDirType::Cache], area, bbox, bbox_cache_str);
     road->netascore_file_path = push_str8_copy(road->arena, neta_state->cache_file_location);
 
+    // build graph: osm, neta -> road match -> road segments + BVH -> GPU upload
+    // ~mgj: all of it is precompute, it runs in the Background lane and the graph nodes inherit that
+    async::ThreadPoolPriorityScope priority_scope = async::ThreadPoolPriorityScope(async::ThreadPoolPriority_Background);
+    async::ThreadPool* thread_pool = dt_ctx_get()->thread_pool;
+    RoadBuildTask* road_build_task = PushStruct(city->arena, RoadBuildTask);
+    road_build_task->road = road;
+    road_build_task->network = city->osm_network;
+    CityBuildGraph* build_graph = &city->build_graph;
+    build_graph->graph = async::task_graph_create(city->arena, thread_pool);
+    build_graph->osm = async::task_node_external_create(build_graph->graph, S("Osm"));
+    build_graph->neta = async::task_node_external_create(build_graph->graph, S("Neta"));
+    build_graph->road_match = async::task_node_create(build_graph->graph, S("Road Match"), road_match_run, road_build_task);
+    build_graph->road_segment = async::task_node_create(build_graph->graph, S("Road Segment"), road_segment_run, road_build_task);
+    build_graph->road_upload = async::task_node_create(build_graph->graph, S("Road Upload"), road_upload_run, road_build_task);
+    async::task_node_depends(build_graph->road_match, build_graph->osm);
+    async::task_node_depends(build_graph->road_match, build_graph->neta);
+    async::task_node_depends(build_graph->road_segment, build_graph->road_match);
+    async::task_node_depends(build_graph->road_upload, build_graph->road_segment);
+    async::task_graph_launch(build_graph->graph);
+
     // start async tasks
     city::AsyncCityTask* neta_task = neta::netascore_async_task_create(city->arena, neta_state, bbox);
+    if (neta_task->type == AsyncTaskType::Neta)
+    {
+        async::async_task_done_node_set(neta_task->neta, build_graph->neta);
+    }
+    else
+    {
+        async::task_node_complete(build_graph->neta, true);
+    }
     DLLPushBack(city->task_list.first, city->task_list.last, neta_task);
 
-    async::ThreadPool* thread_pool = dt_ctx_get()->thread_pool;
     AsyncCityTask* osm_task_status = _cache_and_parse_osm_json(thread_pool, road, city->osm_network);
+    async::async_task_done_node_set(osm_task_status->osm, build_graph->osm);
     DLLPushBack(city->task_list.first, city->task_list.last, osm_task_status);
 }
 
@@ -118,20 +148,18 @@ _cache_and_parse_osm_json(async::ThreadPool* thread_pool, Road* road, osm::Netwo
                               str8_varg(dyn_query_str));
 
     String8 path = S("http://overpass-api.de/api/interpreter");
-    Result<String8> cache_result = cache_read(osm_network->arena, osm_network->cache_file_location, osm_network->bbox_cache_str);
+    // ~mgj: the json is only read by the parse task, and not at all when a valid snapshot exists
+    B32 is_cached = cache_is_valid(osm_network->cache_file_location, osm_network->bbox_cache_str);
 
     AsyncCityTask* osm_task = PushStruct(road->arena, AsyncCityTask);
     osm_task->type = city::AsyncTaskType::Osm;
-    if (cache_result.err)
+    if (!is_cached)
     {
         async::HttpInfo* http_info =
             async::http_info_create(osm_network->arena, HTTP_Method_Post, path, S("application/x-www-form-urlencoded"), {S("User-Agent: DTCity/0.1"), S("Accept: application/json")}, {});
         http_info->body = push_str8_copy(osm_network->arena, body);
-        async::AsyncHttpTaskStateConfig<osm::Network> config = async::AsyncHttpTaskStateConfig<osm::Network>(osm::fetch_osm_data_and_parse, osm_network, 3, 1);
-        async::AsyncHttpTaskCreateResult<osm::Network> http_task_result = async::async_http_task_run(thread_pool, http_info, &config, "Osm Task");
-        AssertAlways(http_task_result.async_result.has_error() == false);
-
-        osm_task->osm = http_task_result.task_state;
+        osm_network->overpass_http_info = http_info;
+        osm_task->osm = async::async_task_co_run(thread_pool, osm::fetch_osm_data_and_parse, osm_network, "Osm Task");
     }
     else
     {
@@ -164,7 +192,6 @@ g_internal void
 city_update(City* city, Buffer<city::Coordinate> new_agent_coords, async::ThreadPool* thread_pool, RoadOverlayOption neta_overlay_option, Vec2U32 framebuffer_dim, const AreaConfig* city_config)
 {
     prof_scope_marker;
-    ScratchScope scratch = ScratchScope(0, 0);
     Context* ctx = dt_ctx_get();
     ui::Camera* camera = resource_pool_item_from_idx(ctx->camera_container, city->camera_handle);
     // TODO: vulkan current frame should not be used directly
@@ -190,13 +217,6 @@ city_update(City* city, Buffer<city::Coordinate> new_agent_coords, async::Thread
                 city->neta_task_done = task_result.success;
             }
             break;
-            case AsyncTaskType::Road:
-            {
-                async::AsyncTaskResult<RoadBuildTask> task_result = async::async_task_is_done(task->road);
-                task_done = task_result.done;
-                city->road_building_done = task_result.success;
-            }
-            break;
             case AsyncTaskType::CarSim:
             {
                 async::AsyncTaskResult<CarSimBuildTask> task_result = async::async_task_is_done(task->car_sim);
@@ -228,21 +248,10 @@ city_update(City* city, Buffer<city::Coordinate> new_agent_coords, async::Thread
         task = next_task;
     }
 
-    U64 hovered_object_id = render::latest_hovered_object_id_get();
+    // ~mgj: the road stages are chained in the build graph, only their result is read here
+    city->road_building_done = async::task_node_state(city->build_graph.road_upload) == async::TaskNodeState_Succeeded;
 
-    if (city->neta_task_done && city->osm_task_done && !city->road_building_started)
-    {
-        city->road_building_started = true;
-        DEBUG_LOG("City building work has been schedule");
-        RoadBuildTask* road_build_task = PushStruct(city->arena, RoadBuildTask);
-        road_build_task->road = &city->road;
-        road_build_task->network = city->osm_network;
-        async::AsyncTaskStatus<RoadBuildTask>* road_building_task = async::async_task_run(thread_pool, road_build, road_build_task, "Road Building Task");
-        AsyncCityTask* road_task_list_elem = PushStruct(city->arena, AsyncCityTask);
-        road_task_list_elem->type = AsyncTaskType::Road;
-        road_task_list_elem->road = road_building_task;
-        DLLPushBack(city->task_list.first, city->task_list.last, road_task_list_elem);
-    }
+    U64 hovered_object_id = render::latest_hovered_object_id_get();
 
     if (city->osm_task_done)
     {
@@ -255,9 +264,9 @@ city_update(City* city, Buffer<city::Coordinate> new_agent_coords, async::Thread
 
             bool open = true;
             ImGui::Begin("Object Info", &open, ImGuiWindowFlags_AlwaysAutoResize);
-            for (osm::Tag& tag : way->tags)
+            for (U64 tag_idx = 0; tag_idx < way->tags.count; tag_idx += 1)
             {
-                ImGui::Text("%s: %s", (char*)tag.key.str, (char*)tag.value.str);
+                ImGui::Text("%s: %s", (char*)osm::str8_from_str_id(way->tags.keys[tag_idx]).str, (char*)osm::str8_from_str_id(way->tags.values[tag_idx]).str);
             }
 
             city::RoadInfo* chosen_edge = map_get(city->road.road_info_map, edge->id);
@@ -283,10 +292,9 @@ city_update(City* city, Buffer<city::Coordinate> new_agent_coords, async::Thread
             osm::Way* way = &way_node->way;
             bool open = true;
             ImGui::Begin("Object Info", &open, ImGuiWindowFlags_AlwaysAutoResize);
-            for (U32 tag_idx = 0; tag_idx < way->tags.size; tag_idx += 1)
+            for (U64 tag_idx = 0; tag_idx < way->tags.count; tag_idx += 1)
             {
-                osm::Tag* tag = &way->tags.data[tag_idx];
-                ImGui::Text("%s: %s", (char*)tag->key.str, (char*)tag->value.str);
+                ImGui::Text("%s: %s", (char*)osm::str8_from_str_id(way->tags.keys[tag_idx]).str, (char*)osm::str8_from_str_id(way->tags.values[tag_idx]).str);
             }
             ImVec2 window_size = ImGui::GetWindowSize();
             ImVec2 window_pos = ImVec2((F32)framebuffer_dim.x - window_size.x, 0);
@@ -303,7 +311,6 @@ city_update(City* city, Buffer<city::Coordinate> new_agent_coords, async::Thread
     //
 
     // Update and render Cesium 3D Tiles ////////////
-    bool overlay_option_changed = neta_overlay_option != city->road.overlay_option_cur;
     if (city->road_building_done)
     {
         city->road.overlay_option_cur = neta_overlay_option;
@@ -312,6 +319,12 @@ city_update(City* city, Buffer<city::Coordinate> new_agent_coords, async::Thread
     cesium::TilesetRenderer* tileset = {};
     if (ctx->tileset_pool->item_from_handle(city->tileset_handle, &tileset))
     {
+        // ~mgj: once the BVH is built the tiles that load from then on are classified on their load threads
+        if (city->road_building_done && !tileset->triangle_classify_func)
+        {
+            cesium::tileset_triangle_classifier_set(tileset, road_tile_classify, &city->road);
+        }
+        cesium::tileset_triangle_overlay_option_set(tileset, (U32)neta_overlay_option);
         cesium::tileset_update_view(tileset, camera, framebuffer_dim, ctx->time->time_delta_constant_sec);
 
         // always drawn tiles
@@ -319,10 +332,28 @@ city_update(City* city, Buffer<city::Coordinate> new_agent_coords, async::Thread
         {
             if (city->road_building_done)
             {
-                if (tile->compute_scheduled == false || overlay_option_changed)
+                // ~mgj: a tile is classified against the BVH once, on its load thread or by the classify pass. From then
+                // on overlay_option is the option its vertices hold and a switch only gathers the new option value of
+                // the cached segment per triangle. A dispatch that is not scheduled (buffers still loading) is retried
+                // next frame, so a tile never keeps stale overlay values.
+                if (tile->triangle_segments_cached == false)
+                {
+                    if (draw::draw_road_intersection_compute(tile->render_data.vertex_buffer_handle, tile->render_data.index_buffer_handle, city->road.segment_buffer_handle,
+                                                             city->road.segment_node_buffer_handle, tile->triangle_segment_buffer_handle, neta_overlay_option,
+                                                             render::RoadIntersectionMode_Classify))
+                    {
+                        tile->triangle_segments_cached = true;
+                        tile->overlay_option = (U32)neta_overlay_option;
+                    }
+                }
+                else if (tile->overlay_option != (U32)neta_overlay_option)
                 {
-                    tile->compute_scheduled = draw::draw_road_intersection_compute(tile->render_data.vertex_buffer_handle, tile->render_data.index_buffer_handle, city->road.segment_buffer_handle,
-                                                                                   city->road.segment_node_buffer_handle, neta_overlay_option);
+                    if (draw::draw_road_intersection_compute(tile->render_data.vertex_buffer_handle, tile->render_data.index_buffer_handle, city->road.segment_buffer_handle,
+                                                             city->road.segment_node_buffer_handle, tile->triangle_segment_buffer_handle, neta_overlay_option,
+                                                             render::RoadIntersectionMode_Gather))
+                    {
+                        tile->overlay_option = (U32)neta_overlay_option;
+                    }
                 }
             }
 
@@ -378,6 +409,7 @@ city_update(City* city, Buffer<city::Coordinate> new_agent_coords, async::Thread
             CarSimBuildTask* car_sim_build_task = PushStruct(allocator->arena, CarSimBuildTask);
             car_sim_build_task->car_sim = car_sim;
             car_sim_build_task->network = city->osm_network;
+            async::ThreadPoolPriorityScope priority_scope = async::ThreadPoolPriorityScope(async::ThreadPoolPriority_Background);
             async::AsyncTaskStatus<CarSimBuildTask>* car_sim_task = async::async_task_run(ctx->thread_pool, agent_sim_build, car_sim_build_task, "Car Sim Task");
 
             AsyncCityTask* car_sim_task_list_elem = PushStruct(allocator->arena, AsyncCityTask);
@@ -393,22 +425,16 @@ city_update(City* city, Buffer<city::Coordinate> new_agent_coords, async::Thread
         {
             prof_scope_marker_named("Car update scope");
             F32 scale_factor = city->agent_scale_factor;
-            agent_sim_update(&city->car_sim, new_agent_coords, tileset->ecef_to_local, scale_factor, ctx->io->frame_count);
-
-            ChunkList<render::Transform>* transform_list = chunk_list_create<render::Transform>(scratch.arena, 100);
-            AgentSim* agent_sim = &city->car_sim;
-            S64 frame_rate = ctx->io->frame_rate.load();
-            for (U64 agent_idx = 0; agent_idx < agent_sim->agents_active->size; agent_idx += 1)
-            {
-                Agent* agent = &(*agent_sim->agents_active)[agent_idx];
-
-                if (((S64)ctx->io->frame_count - (S64)agent->latest_update_frame) < (frame_rate * 2)) // Do not add agent after 2 seconds
-                {
-                    chunk_list_insert(scratch.arena, transform_list, agent->model_matrix);
-                }
-            }
-
-            Buffer<render::Transform> transform_buffer = buffer_from_chunk_list(draw::draw_frame_arena_get(), transform_list);
+            // ~mgj: the agents move every frame from their samples, the store is the instance buffer as is
+            RoadGrid* road_grid = city->road_building_done ? &city->road.road_build_result.road_grid : 0;
+            agent_sim_update(ctx->thread_pool, &city->car_sim, new_agent_coords, tileset->ecef_to_local, scale_factor, &city->agent_motion, os_now_microseconds(), road_grid,
+                             city->agent_road_snap_distance);
+
+            AgentStore* agents = city->car_sim.agents;
+            Buffer<render::Transform> transform_buffer = {};
+            transform_buffer.size = agents->count;
+            transform_buffer.data = PushArrayNoZero(draw::draw_frame_arena_get(), render::Transform, agents->count);
+            MemoryCopy(transform_buffer.data, agents->transforms, sizeof(render::Transform) * agents->count);
             // instance buffer offset alignment and assignment
             render::BufferInfo instance_buffer_info = render::BufferInfo(transform_buffer, render::BufferType_Vertex | render::BufferType_StorageBuffer);
             render::MappedHandle<void> camera_handle_void = render::mapped_handle_erased(camera_handle);
@@ -438,6 +464,18 @@ g_internal void
 city_release(City* city)
 {
     Context* ctx = dt_ctx_get();
+    if (city->build_graph.graph)
+    {
+        async::task_graph_cancel(city->build_graph.graph);
+        async::task_graph_wait_idle(city->build_graph.graph);
+    }
+    cesium::TilesetRenderer* tileset = {};
+    B32 has_tileset = ctx->tileset_pool->item_from_handle(city->tileset_handle, &tileset);
+    if (has_tileset)
+    {
+        // ~mgj: the tile load threads read the road BVH until then
+        cesium::tileset_triangle_classifier_set(tileset, 0, 0);
+    }
     if (city->road.arena)
     {
         road_destroy(&city->road);
@@ -446,8 +484,7 @@ city_release(City* city)
     {
         osm::osm_release(city->osm_network);
     }
-    cesium::TilesetRenderer* tileset = {};
-    if (ctx->tileset_pool->item_from_handle(city->tileset_handle, &tileset))
+    if (has_tileset)
     {
         cesium::tileset_renderer_destroy(tileset);
     }
@@ -465,29 +502,47 @@ city_release(City* city)
     }
 }
 
-g_internal async::AsyncTaskContinuation<RoadBuildTask>
-road_build(async::ThreadInfo info, async::AsyncTaskStatus<RoadBuildTask>* status)
+g_internal B32
+road_match_run(async::ThreadInfo info, void* data, async::CancelToken* cancel_token)
 {
     (void)info;
+    (void)cancel_token;
+    RoadBuildTask* task = (RoadBuildTask*)data;
+    Road* road = task->road;
+    osm::Network* network = task->network;
+
+    Map<S64, neta::EdgeList>* neta_edge_map = neta::osm_way_to_edges_map_create(road->arena, network, road->netascore_file_path, road->bbox);
+    road->road_info_map = city::road_info_from_edge_id(road->arena, network, network->edge_structure.edges, neta_edge_map);
+    return true;
+}
 
-    RoadBuildTask* task = status->user_data;
+g_internal B32
+road_segment_run(async::ThreadInfo info, void* data, async::CancelToken* cancel_token)
+{
+    (void)cancel_token;
+    RoadBuildTask* task = (RoadBuildTask*)data;
     Road* road = task->road;
     osm::Network* network = task->network;
 
+    road->road_build_result = city::road_segment_build(info.thread_pool, road->arena, network, network->edge_structure.edges, road->default_road_width, road->road_height, road->ecef_to_local, road->road_info_map);
+    return true;
+}
+
+g_internal B32
+road_upload_run(async::ThreadInfo info, void* data, async::CancelToken* cancel_token)
+{
+    (void)info;
+    (void)cancel_token;
+    RoadBuildTask* task = (RoadBuildTask*)data;
+    Road* road = task->road;
+
     render::ThreadWorkerCmdCtx* thread_ctx = render::thread_ctx_create();
     render::thread_cmd_buffer_record(thread_ctx);
     defer({ render::thread_cmd_buffer_end(thread_ctx); });
 
-    Map<S64, neta::EdgeList>* neta_edge_map = neta::osm_way_to_edges_map_create(road->arena, network, road->netascore_file_path, road->bbox);
-
-    road->road_info_map = city::road_info_from_edge_id(road->arena, network, network->edge_structure.edges, neta_edge_map);
-
     Buffer<U8> colormap_buffer = Buffer<U8>((U8*)g_colormap_inferno, sizeof(g_colormap_inferno));
     render::BufferInfo colormap_buffer_info = render::BufferInfo(colormap_buffer, render::BufferType_StorageBuffer);
     road->colormap_handle = render::buffer_load_sync(thread_ctx, &colormap_buffer_info, S("colormap_buffer"));
-    ////////////////////////////////////////
-    // build road buffers
-    road->road_build_result = city::road_segment_build(road->arena, network, network->edge_structure.edges, road->default_road_width, road->road_height, road->ecef_to_local, road->road_info_map);
     render::BufferInfo road_segment_buffer_info = render::BufferInfo(road->road_build_result.bvh_result.road_segment_buffer_sorted, render::BufferType_StorageBuffer);
     road->segment_buffer_handle = render::buffer_load_sync(thread_ctx, &road_segment_buffer_info, S("road_segment_buffer"));
     render::BufferInfo road_segment_node_buffer_info = render::BufferInfo(road->road_build_result.bvh_result.node_buffer, render::BufferType_StorageBuffer);
@@ -502,7 +557,7 @@ road_build(async::ThreadInfo info, async::AsyncTaskStatus<RoadBuildTask>* status
     // };
     // city::buildings_build();
     // buildings_build(ctx->buildings, &sampler_info, ecef_to_local, ctx->road->road_height);
-    return {};
+    return true;
 }
 
 g_internal async::AsyncTaskContinuation<CarSimBuildTask>
@@ -578,11 +633,11 @@ road_segments_coalesce(RoadSegment* in_out_road_segment_0, RoadSegment* in_out_r
 }
 
 g_internal F32
-tag_value_get(Arena* arena, String8 key, F32 default_width, Buffer<osm::Tag> tags)
+tag_value_get(osm::TagKeyId key, F32 default_width, osm::TagList tags)
 {
     F32 road_width = default_width; // Example value, adjust as needed
     {
-        osm::TagResult result = osm::tag_find(arena, tags, key);
+        osm::TagResult result = osm::tag_find(tags, key);
         if (result.result == osm::TagResultEnum::ROAD_TAG_FOUND)
         {
             F32 float_result = {0};
@@ -595,266 +650,40 @@ tag_value_get(Arena* arena, String8 key, F32 default_width, Buffer<osm::Tag> tag
     return road_width;
 }
 
-// BVH functions /////////////////////////////
-
-g_internal void
-quick_select(Buffer<BoundingBox> center_buffer, U32 split_axis, U32 start_idx, U32 end_idx, U32 k)
+struct _RoadSegmentBuildTask
 {
-    Assert(k < center_buffer.size);
-
-    while (start_idx < end_idx)
-    {
-        U32 pivot_idx = end_idx - 1;
-        F32 pivot = center_buffer.data[pivot_idx].center.v[split_axis];
-
-        U32 divider_idx = start_idx;
-        for (U32 i = start_idx; i < pivot_idx; ++i)
-        {
-            if (center_buffer.data[i].center.v[split_axis] < pivot)
-            {
-                Swap(BoundingBox, center_buffer.data[i], center_buffer.data[divider_idx]);
-                divider_idx++;
-            }
-        }
-
-        Swap(BoundingBox, center_buffer.data[divider_idx], center_buffer.data[pivot_idx]);
-
-        if (divider_idx == k)
-        {
-            break;
-        }
-        else if (divider_idx < k)
-        {
-            start_idx = divider_idx + 1;
-        }
-        else
-        {
-            end_idx = divider_idx;
-        }
-    }
-}
-
-g_internal Rng2F32
-bounds_union(Rng2F32 a, Rng2F32 b)
-{
-    Rng2F32 result;
-    result.min.v[0] = Min(a.min.v[0], b.min.v[0]);
-    result.min.v[1] = Min(a.min.v[1], b.min.v[1]);
-
-    result.max.v[0] = Max(a.max.v[0], b.max.v[0]);
-    result.max.v[1] = Max(a.max.v[1], b.max.v[1]);
-    return result;
-}
-
-g_internal Rng2F32
-bounds_union(Rng2F32 rng, Vec2F32 vec)
-{
-    Rng2F32 result;
-    result.min.v[0] = Min(rng.min.v[0], vec.v[0]);
-    result.min.v[1] = Min(rng.min.v[1], vec.v[1]);
-
-    result.max.v[0] = Max(rng.max.v[0], vec.v[0]);
-    result.max.v[1] = Max(rng.max.v[1], vec.v[1]);
-    return result;
-}
-
-g_internal Rng2F32
-bounds_union(Buffer<BoundingBox> center_buffer, U32 start_idx, U32 end_idx)
-{
-    Rng2F32 bounds = rng2f32_inverted_inf();
-    for (U32 i = start_idx; i < end_idx; ++i)
-    {
-        BoundingBox seg_center = center_buffer.data[i];
-        bounds = bounds_union(bounds, seg_center.bounds);
-    }
-    return bounds;
-}
-
-g_internal Axis2
-split_axis_find(Buffer<BoundingBox> bb_buffer, U32 start_idx, U32 end_idx)
-{
-    Rng2F32 bounds = rng2f32_inverted_inf();
-    for (U32 i = start_idx; i < end_idx; ++i)
-    {
-        BoundingBox* seg_center = bb_buffer[i];
-        for (U32 ax_idx = 0; ax_idx < Axis2_COUNT; ++ax_idx)
-        {
-            if (seg_center->center.v[ax_idx] < bounds.min.v[ax_idx])
-            {
-                bounds.min.v[ax_idx] = seg_center->center.v[ax_idx];
-            }
-
-            if (seg_center->center.v[ax_idx] > bounds.max.v[ax_idx])
-            {
-                bounds.max.v[ax_idx] = seg_center->center.v[ax_idx];
-            }
-        }
-    }
-
-    Vec2F32 diff = sub_2f32(bounds.max, bounds.min);
-    Axis2 split_axis = diff.x > diff.y ? Axis2_X : Axis2_Y;
-    return split_axis;
-}
-
-g_internal BvhResult
-bvh_create(Arena* arena, Buffer<RoadSegmentCorners> road_segment_buffer, U32 leaf_bb_max)
-{
-    ScratchScope scratch = ScratchScope(&arena, 1);
-
-    Buffer<BoundingBox> bb_buffer = buffer_alloc<BoundingBox>(scratch.arena, road_segment_buffer.size);
-
-    // 1. for every element in the buffer, find the center point (used for segmentation)
-    for (U32 i = 0; i < bb_buffer.size; i++)
-    {
-        // init idx to later point to RoadSegmentCorners*
-        bb_buffer.data[i].idx = i;
-
-        // create bounding box around road segment
-        Rng2F32 bounds = rng2f32_inverted_inf();
-        for (U32 j = 0; j < Corner_COUNT; ++j)
-        {
-            RoadSegmentCorners* seg = road_segment_buffer[i];
-            Vec2F32 corner = seg->corners[j];
-            bounds = bounds_union(bounds, corner);
-        }
-        bb_buffer.data[i].bounds = bounds;
-
-        // find center point
-        Vec2F32 center = {};
-        for (U32 j = 0; j < Corner_COUNT; ++j)
-        {
-            RoadSegmentCorners* seg = road_segment_buffer[i];
-            Vec2F32 corner = seg->corners[j];
-            center = add_2f32(center, corner);
-        }
-        bb_buffer.data[i].center = scale_2f32(center, 1.0f / (F32)Corner_COUNT);
-    }
-
-    BvhContext* bvh = PushStruct(scratch.arena, BvhContext);
-    bvh->road_segment_buffer = road_segment_buffer;
-    bvh->bb_buffer = bb_buffer;
-    bvh->leaf_bb_max = leaf_bb_max;
-
-    RoadSegmentNode* root = PushStruct(scratch.arena, RoadSegmentNode);
-    bvh->root = root;
-    root->bounds = bounds_union(bb_buffer, 0, bb_buffer.size);
-    root->start_idx = 0;
-    root->end_idx = bb_buffer.size;
-
-    SLLStackPush(bvh->stack, root);
-
-    Buffer<RoadSegmentCorners> road_segment_buffer_sorted = buffer_alloc<RoadSegmentCorners>(arena, bvh->road_segment_buffer.size);
-    while (bvh->stack)
-    {
-        bvh->road_segment_node_count += 1;
-        RoadSegmentNode* node = bvh->stack;
-        SLLStackPop(bvh->stack);
-
-        U32 num_elem = node->end_idx - node->start_idx;
-
-        if (num_elem <= leaf_bb_max)
-        {
-            for (U32 i = node->start_idx; i < node->end_idx; ++i)
-            {
-                // copy road segment corners from bb_buffer index to sorted buffer
-                BoundingBox bb = bvh->bb_buffer.data[i];
-                road_segment_buffer_sorted.data[i] = bvh->road_segment_buffer.data[bb.idx];
-            }
-            continue;
-        }
-
-        Axis2 split_axis = split_axis_find(bvh->bb_buffer, node->start_idx, node->end_idx);
-        U32 split_idx = node->start_idx + (num_elem) / 2;
-        quick_select(bb_buffer, (U32)split_axis, node->start_idx, node->end_idx, split_idx);
-        node->split_axis = split_axis;
-        node->split_value = bb_buffer.data[split_idx].center.v[(U32)split_axis];
-
-        Rng2F32 idx_range = rng_2f32(V2F32(node->start_idx, split_idx), V2F32(split_idx, node->end_idx));
-
-        for (U32 i = 0; i < ArrayCount(idx_range.v); ++i)
-        {
-            node->children[i] = PushStruct(scratch.arena, RoadSegmentNode);
-            node->children[i]->start_idx = idx_range.min.v[i];
-            node->children[i]->end_idx = idx_range.max.v[i];
-            node->children[i]->bounds = bounds_union(bb_buffer, node->children[i]->start_idx, node->children[i]->end_idx);
-        }
-
-        SLLStackPush(bvh->stack, node->children[1]);
-        SLLStackPush(bvh->stack, node->children[0]);
-    }
-
-    // create the final road segment node for storage buffer usage
-    Buffer<RoadSegmentNodeStorageBuffer> road_segment_node_buffer = buffer_alloc<RoadSegmentNodeStorageBuffer>(arena, bvh->road_segment_node_count);
-    Assert(bvh->stack == 0);
-    SLLStackPush(bvh->stack, bvh->root);
-    U32 cur_node_idx = 0;
-    while (bvh->stack)
-    {
-        RoadSegmentNode* node = bvh->stack;
-        SLLStackPop(bvh->stack);
-
-        node->final_idx = cur_node_idx++;
-        RoadSegmentNodeStorageBuffer* current = road_segment_node_buffer[node->final_idx];
-        current->min_x = node->bounds.min.x;
-        current->min_y = node->bounds.min.y;
-        current->max_x = node->bounds.max.x;
-        current->max_y = node->bounds.max.y;
-        current->split_axis = node->split_axis;
-        current->split_value = node->split_value;
-
-        // fill out parent nodes second child idx
-        if (node->parent)
-        {
-            U32 parent_idx = node->parent->final_idx;
-            RoadSegmentNodeStorageBuffer* parent = road_segment_node_buffer[parent_idx];
-            parent->child_1_idx = node->final_idx;
-        }
-
-        if (node->children[0] && node->children[1])
-        {
-            current->is_leaf = false;
-            current->child_0_idx = cur_node_idx;
-
-            SLLStackPush(bvh->stack, node->children[1]);
-            SLLStackPush(bvh->stack, node->children[0]);
-            node->children[1]->parent = node;
-        }
-        else
-        {
-            current->is_leaf = true;
-            current->start_idx = node->start_idx;
-            current->end_idx = node->end_idx;
-        }
-    }
-    Assert(cur_node_idx == road_segment_node_buffer.size);
-
-    BvhResult result = {road_segment_buffer_sorted, road_segment_node_buffer};
-    return result;
-}
-
-g_internal city::RoadBuildResult
-road_segment_build(Arena* arena, osm::Network* network, Buffer<osm::RoadEdge> edge_buffer, F32 default_road_width, F32 road_height, glm::dmat4& ecef_to_local,
-                   Map<osm::EdgeId, RoadInfo>* road_info_map)
+    osm::Network* network;
+    Buffer<osm::RoadEdge> edge_buffer;
+    F32 default_road_width;
+    F32 road_height;
+    glm::dmat4* ecef_to_local;
+    Map<osm::EdgeId, RoadInfo>* road_info_map;
+
+    Buffer<render::Vertex3DBlend> vertex_buffer;
+    Buffer<U32> index_buffer;
+    Buffer<RoadSegmentCorners> corner_buffer;
+};
+
+// ~mgj: edge i owns vertices [4i, 4i + 4), indices [6i, 6i + 6) and corner i, so chunks write disjoint ranges
+g_internal void
+_road_segment_build_task(async::ThreadInfo thread_info, Arena* scratch_arena, void* data, U64 start_idx, U64 end_idx)
 {
-    prof_scope_marker;
-    ScratchScope scratch = ScratchScope(0, 0);
-
-    Buffer<render::Vertex3DBlend> vertex_buffer = buffer_alloc<render::Vertex3DBlend>(arena, edge_buffer.size * 4);
-    Buffer<U32> index_buffer = buffer_alloc<U32>(arena, edge_buffer.size * 6);
-    Buffer<RoadSegmentCorners> corner_buffer = buffer_alloc<RoadSegmentCorners>(arena, edge_buffer.size);
-
-    U32 cur_vertex_idx = 0;
-    U32 cur_index_idx = 0;
-    for (U32 i = 0; i < edge_buffer.size; i++)
+    (void)thread_info;
+    (void)scratch_arena;
+    _RoadSegmentBuildTask* task = (_RoadSegmentBuildTask*)data;
+    osm::Network* network = task->network;
+    glm::dmat4& ecef_to_local = *task->ecef_to_local;
+    F32 default_road_width = task->default_road_width;
+    for (U64 i = start_idx; i < end_idx; i++)
     {
-        osm::RoadEdge* edge = edge_buffer[i];
+        osm::RoadEdge* edge = task->edge_buffer[i];
 
         osm::EcefLocation start_node = osm::location_get(network, edge->node_id_from);
         osm::EcefLocation end_node = osm::location_get(network, edge->node_id_to);
         osm::WayNode* way_node = osm::way_find(network, edge->way_id);
         osm::Way* way = &way_node->way;
 
-        F32 road_width = tag_value_get(scratch.arena, S("width"), default_road_width, way->tags);
+        F32 road_width = tag_value_get(osm::TagKeyId::Width, default_road_width, way->tags);
 
         RoadSegment road_segment;
         road_segment_from_road_nodes(&road_segment, start_node, end_node, default_road_width);
@@ -880,7 +709,7 @@ road_segment_build(Arena* arena, osm::Network* network, Buffer<osm::RoadEdge> ed
         }
 
         // Road coordinates stored in buffer for 3D geometry projection
-        RoadSegmentCorners* road_segment_corners = corner_buffer[i];
+        RoadSegmentCorners* road_segment_corners = task->corner_buffer[i];
         road_segment_corners->edge_id = edge->id;
         glm::vec2 local_top_left = glm::vec2(ecef_to_local * glm::dvec4(road_segment.start.top.x, road_segment.start.top.y, road_segment.start.node.pos.z, 1.0));
         glm::vec2 local_top_right = glm::vec2(ecef_to_local * glm::dvec4(road_segment.end.top.x, road_segment.end.top.y, road_segment.end.node.pos.z, 1.0));
@@ -890,17 +719,56 @@ road_segment_build(Arena* arena, osm::Network* network, Buffer<osm::RoadEdge> ed
         road_segment_corners->corners[RoadSegmentCornerCoord_TopRight] = vec_2f32(local_top_right.x, local_top_right.y);
         road_segment_corners->corners[RoadSegmentCornerCoord_BottomRight] = vec_2f32(local_bottom_right.x, local_bottom_right.y);
         road_segment_corners->corners[RoadSegmentCornerCoord_BottomLeft] = vec_2f32(local_bottom_left.x, local_bottom_left.y);
-        RoadInfo* road_info = map_get(road_info_map, edge->id);
+        RoadInfo* road_info = map_get(task->road_info_map, edge->id);
         if (road_info)
         {
             road_segment_corners->road_info = *road_info;
         }
 
         // add vertex and inde
-        quad_to_buffer_add(road_segment_corners, vertex_buffer, index_buffer, edge->id, road_height, &cur_vertex_idx, &cur_index_idx);
+        U32 cur_vertex_idx = (U32)i * 4;
+        U32 cur_index_idx = (U32)i * 6;
+        quad_to_buffer_add(road_segment_corners, task->vertex_buffer, task->index_buffer, edge->id, task->road_height, &cur_vertex_idx, &cur_index_idx);
     }
+}
+
+g_internal city::RoadBuildResult
+road_segment_build(async::ThreadPool* thread_pool, Arena* arena, osm::Network* network, Buffer<osm::RoadEdge> edge_buffer, F32 default_road_width, F32 road_height,
+                   glm::dmat4& ecef_to_local, Map<osm::EdgeId, RoadInfo>* road_info_map)
+{
+    prof_scope_marker;
+
+    Buffer<render::Vertex3DBlend> vertex_buffer = buffer_alloc<render::Vertex3DBlend>(arena, edge_buffer.size * 4);
+    Buffer<U32> index_buffer = buffer_alloc<U32>(arena, edge_buffer.size * 6);
+    Buffer<RoadSegmentCorners> corner_buffer = buffer_alloc<RoadSegmentCorners>(arena, edge_buffer.size);
 
-    BvhResult result = bvh_create(arena, corner_buffer, 10);
+    _RoadSegmentBuildTask task = {
+        .network = network,
+        .edge_buffer = edge_buffer,
+        .default_road_width = default_road_width,
+        .road_height = road_height,
+        .ecef_to_local = &ecef_to_local,
+        .road_info_map = road_info_map,
+        .vertex_buffer = vertex_buffer,
+        .index_buffer = index_buffer,
+        .corner_buffer = corner_buffer,
+    };
+    async::parallel_for(thread_pool, edge_buffer.size, 0, _road_segment_build_task, &task);
+
+    BvhResult result = bvh_create(thread_pool, arena, corner_buffer, 10);
+
+    // ~mgj: the centre line of every segment runs between the midpoints of its start and end corners
+    Buffer<Vec2F32> centre_from = buffer_alloc<Vec2F32>(arena, corner_buffer.size);
+    Buffer<Vec2F32> centre_to = buffer_alloc<Vec2F32>(arena, corner_buffer.size);
+    Buffer<osm::EdgeId> centre_edge_ids = buffer_alloc<osm::EdgeId>(arena, corner_buffer.size);
+    for (U64 i = 0; i < corner_buffer.size; ++i)
+    {
+        Vec2F32* corners = corner_buffer.data[i].corners;
+        centre_from.data[i] = scale_2f32(add_2f32(corners[RoadSegmentCornerCoord_TopLeft], corners[RoadSegmentCornerCoord_BottomLeft]), 0.5f);
+        centre_to.data[i] = scale_2f32(add_2f32(corners[RoadSegmentCornerCoord_TopRight], corners[RoadSegmentCornerCoord_BottomRight]), 0.5f);
+        centre_edge_ids.data[i] = corner_buffer.data[i].edge_id;
+    }
+    RoadGrid road_grid = road_grid_create(arena, centre_from, centre_to, centre_edge_ids, ROAD_GRID_DEFAULT_CELL_SIZE);
 
     render::BufferInfo vertex_buffer_info = render::BufferInfo(vertex_buffer, render::BufferType_Vertex);
     render::BufferInfo index_buffer_info = render::BufferInfo(index_buffer, render::BufferType_Index);
@@ -912,6 +780,7 @@ road_segment_build(Arena* arena, osm::Network* network, Buffer<osm::RoadEdge> ed
         .vertex_buffer_handle = vertex_buffer_handle,
         .index_buffer_handle = index_buffer_handle,
         .bvh_result = result,
+        .road_grid = road_grid,
     };
     return road_build_result;
 }
@@ -1094,8 +963,7 @@ agents_create(AgentSim* agent_sim, osm::Network* network)
         mesh_idx++;
     }
     agent_sim->cars = buffer_alloc<Car>(agent_sim->allocator->arena, agent_sim->agent_count);
-    agent_sim->agent_map = map_create<WsId, AgentMapItem>(agent_sim->allocator->arena, agent_sim->agent_count);
-    agent_sim->agents_active = agent_sim->allocator->place<ArenaArray<Agent>>(agent_sim->max_agent_count);
+    agent_sim->agents = agent_store_create(agent_sim->max_agent_count);
 
     for (U32 i = 0; i < agent_sim->agent_count; ++i)
     {
@@ -1130,58 +998,27 @@ agent_sim_destroy(AgentSim* car_sim)
     {
         render::handle_destroy(car_sim->texture_handles.data[i]);
     }
+    if (car_sim->agents)
+    {
+        agent_store_release(car_sim->agents);
+    }
 
     Allocator::destroy(car_sim->allocator);
 }
 
 g_internal void
-agent_sim_update(AgentSim* agent_sim, Buffer<Coordinate> coord_buffer, glm::dmat4& ecef_to_local, F32 scale_factor, U64 cur_frame)
+agent_sim_update(async::ThreadPool* thread_pool, AgentSim* agent_sim, Buffer<Coordinate> coord_buffer, glm::dmat4& ecef_to_local, F32 scale_factor,
+                 const AgentMotionConfig* motion, U64 now_us, RoadGrid* road_grid, F32 road_snap_distance)
 {
-    prof_scope_marker;
-
-    ArenaArray<Agent>* agents_active = agent_sim->agents_active;
-
-    glm::dvec3 z_up = glm::dvec3(0.0f, 0.0f, 1.0f);
-    for (U32 agent_idx = 0; agent_idx < coord_buffer.size; agent_idx++)
+    static_assert(sizeof(render::Transform) == sizeof(Mat4x4F32), "AgentStore::transforms is the agent instance buffer");
+    static_assert(sizeof(glm::dmat4) == sizeof(F64) * 16, "glm::dmat4 is 16 column major doubles");
+    F64 ecef_to_local_cols[16];
+    MemoryCopy(ecef_to_local_cols, &ecef_to_local[0][0], sizeof(ecef_to_local_cols));
+    agent_store_update(thread_pool, agent_sim->agents, coord_buffer, ecef_to_local_cols, scale_factor, motion, now_us);
+    // ~mgj: only the transforms snap, the store keeps the feed positions so every frame snaps from those
+    if (road_grid)
     {
-        Coordinate* coord = &coord_buffer.data[agent_idx];
-
-        glm::dvec3 ecef_coord = util::ecef_from_wgs84(coord->lon, coord->lat);
-        Agent* agent = {};
-        AgentMapItem* agent_ptr = {};
-        MapResult result = map_get(agent_sim->agent_map, coord->id, &agent_ptr);
-        if (result == MapResult::Success)
-        {
-            agent = agent_ptr->agent;
-            glm::dvec3 ecef_dir = ecef_coord - agent->ecef_coord;
-
-            F64 move_len_sq = glm::dot(ecef_dir, ecef_dir);
-            if (move_len_sq > 0.001)
-            {
-                agent->ecef_coord = ecef_coord;
-                agent->ecef_dir = ecef_dir;
-            }
-        }
-        else
-        {
-            glm::dvec3 local_dir = glm::dvec3(1, 0, 0);
-            Agent new_agent = {.ecef_coord = ecef_coord, .ecef_dir = local_dir};
-            agent = agents_active->push(new_agent);
-            AgentMapItem agent_map_item = {.agent = agent};
-            agent_ptr = map_insert(agent_sim->agent_map, coord->id, agent_map_item);
-        }
-
-        // model specific orientation
-        glm::dvec3 x_basis = -glm::normalize(glm::dvec3(ecef_to_local * glm::dvec4(agent->ecef_dir, 0.0)));
-        glm::dvec3 z_basis = glm::cross(x_basis, z_up);
-        glm::dvec3 y_basis = glm::cross(z_basis, x_basis);
-
-        agent->model_matrix.x_basis = glm::vec4(glm::dvec4(x_basis, 0.0f)) * scale_factor;
-        agent->model_matrix.y_basis = glm::vec4(glm::dvec4(y_basis, 0.0f)) * scale_factor;
-        agent->model_matrix.z_basis = glm::vec4(glm::dvec4(z_basis, 0.0f)) * scale_factor;
-        agent->model_matrix.w_basis = glm::vec4(ecef_to_local * glm::dvec4(ecef_coord, 1.0));
-
-        agent->latest_update_frame = cur_frame;
+        road_grid_transforms_snap(thread_pool, road_grid, agent_sim->agents->transforms, agent_sim->agents->count, road_snap_distance);
     }
 }
 // ~mgj: Buildings
@@ -1223,17 +1060,18 @@ buildings_create(String8 cache_path, String8 texture_path, Rng2F64 bbox)
             // http_data = city_http_call_wrapper(scratch.arena, query_str, &params);
             cache_write(cache_data_file, http_data, input_str);
         }
-        osm::RoadNodeParseResult json_result = wrapper::node_buffer_from_simd_json(scratch.arena, http_data, 100);
+        String8 http_json = wrapper::json_padded_copy(scratch.arena, http_data);
+        Result<osm::ElementStore> json_result = wrapper::osm_element_store_from_simd_json(scratch.arena, http_json);
 
         B8 error = true;
-        while (error && json_result.error)
+        while (error && json_result.err)
         {
             ERROR_LOG("BuildingsCreate: Failed to parse OSM node data from json file\n");
             // http_data = city_http_call_wrapper(scratch.arena, query_str, &params);
             if (http_data.size)
             {
-                json_result = wrapper::node_buffer_from_simd_json(scratch.arena, http_data, 100);
-                if (json_result.error == false)
+                json_result = wrapper::osm_element_store_from_simd_json(scratch.arena, http_json);
+                if (json_result.err == false)
                 {
                     cache_write(cache_data_file, http_data, input_str);
                     error = false;
@@ -1278,8 +1116,158 @@ AreTwoConnectedLineSegmentsCollinear(Vec2F64 prev, Vec2F64 cur, Vec2F64 next)
     return is_collinear;
 }
 
+// ~mgj: Facades and roofs are built per building with parallel_for. Every building owns
+// (node_count - 1) * 4 facade vertices and (node_count - 1) * 6 facade indices at its facade offset, and
+// a roof slot of node_count - 1 vertices and (node_count - 3) * 3 indices after the facades. The roof
+// slots are packed once every chunk is done.
+struct _BuildingFacadeTask
+{
+    osm::Network* osm_network;
+    Buffer<osm::Way> ways;
+    glm::dmat4 ecef_to_local;
+    F32 road_height;
+    F32 building_height;
+
+    Buffer<render::TileVertex> vertex_buffer;
+    Buffer<U32> index_buffer;
+    U32* side_offsets; // first facade side of the way, a side is 4 vertices and 6 indices
+};
+
+struct _BuildingRoofTask
+{
+    osm::Network* osm_network;
+    Buffer<osm::Way> ways;
+    glm::dmat4 ecef_to_local;
+    F32 roof_height;
+
+    Buffer<render::TileVertex> vertex_buffer;
+    Buffer<U32> index_buffer;
+    U32* vertex_offsets;
+    U32* index_offsets;
+    U32* vertex_counts;
+    U32* index_counts; // indices are relative to the way's first roof vertex
+};
+
+g_internal void
+_building_facade_task(async::ThreadInfo thread_info, Arena* scratch_arena, void* data, U64 start_idx, U64 end_idx)
+{
+    (void)thread_info;
+    (void)scratch_arena;
+    _BuildingFacadeTask* task = (_BuildingFacadeTask*)data;
+    F32 road_height = task->road_height;
+    F32 building_height = task->building_height;
+    for (U64 way_idx = start_idx; way_idx < end_idx; way_idx++)
+    {
+        osm::Way* way = &task->ways.data[way_idx];
+        Buffer<render::TileVertex> vertex_buffer = task->vertex_buffer;
+        Buffer<U32> index_buffer = task->index_buffer;
+
+        // ~mgj: Add Vertices and Indices for the sides of building
+        U32 side_offset = task->side_offsets[way_idx];
+        for (U32 node_idx = 0, vert_idx = side_offset * 4, index_idx = side_offset * 6; node_idx < way->node_count - 1; node_idx++, vert_idx += 4, index_idx += 6)
+        {
+            osm::EcefLocation node_loc = osm::location_get(task->osm_network, way->node_ids[node_idx]);
+            osm::EcefLocation next_node_loc = osm::location_get(task->osm_network, way->node_ids[node_idx + 1]);
+
+            glm::vec3 local_pos = glm::vec3(task->ecef_to_local * glm::dvec4(node_loc.pos.x, node_loc.pos.y, node_loc.pos.z, 1.0));
+            glm::vec3 local_next_pos = glm::vec3(task->ecef_to_local * glm::dvec4(next_node_loc.pos.x, next_node_loc.pos.y, next_node_loc.pos.z, 1.0));
+
+            F32 side_width = glm::length(local_next_pos - local_pos);
+            Vec2U32 id = {.u64 = (U64)way->id};
+
+            vertex_buffer.data[vert_idx] = {.pos = {local_pos.x, local_pos.y, local_pos.z + road_height}, .uv = {0.0f, 0.0f}, .object_id = id};
+            vertex_buffer.data[vert_idx + 1] = {.pos = {local_pos.x, local_pos.y, local_pos.z + road_height + building_height}, .uv = {0.0f, building_height}, .object_id = id};
+            vertex_buffer.data[vert_idx + 2] = {.pos = {local_next_pos.x, local_next_pos.y, local_next_pos.z + road_height}, .uv = {side_width, 0.0f}, .object_id = id};
+            vertex_buffer.data[vert_idx + 3] = {
+                .pos = {local_next_pos.x, local_next_pos.y, local_next_pos.z + road_height + building_height}, .uv = {side_width, building_height}, .object_id = id};
+
+            index_buffer.data[index_idx] = vert_idx;
+            index_buffer.data[index_idx + 1] = vert_idx + 1;
+            index_buffer.data[index_idx + 2] = vert_idx + 2;
+            index_buffer.data[index_idx + 3] = vert_idx + 1;
+            index_buffer.data[index_idx + 4] = vert_idx + 2;
+            index_buffer.data[index_idx + 5] = vert_idx + 3;
+        }
+    }
+}
+
 g_internal void
-buildings_buffers_create(Arena* arena, osm::Network* osm_network, F32 road_height, glm::dmat4& ecef_to_local, BuildingRenderInfo* out_render_info)
+_building_roof_task(async::ThreadInfo thread_info, Arena* scratch_arena, void* data, U64 start_idx, U64 end_idx)
+{
+    (void)thread_info;
+    _BuildingRoofTask* task = (_BuildingRoofTask*)data;
+    for (U64 way_idx = start_idx; way_idx < end_idx; way_idx++)
+    {
+        Temp scratch = temp_begin(scratch_arena);
+        defer(temp_end(scratch));
+        osm::Way* way = &task->ways.data[way_idx];
+        task->vertex_counts[way_idx] = 0;
+        task->index_counts[way_idx] = 0;
+
+        Buffer<osm::EcefLocation> buildings_utm_node_buffer = buffer_alloc<osm::EcefLocation>(scratch.arena, way->node_count - 1);
+        for (U32 idx = 0; idx < way->node_count - 1; idx += 1)
+        {
+            buildings_utm_node_buffer.data[idx] = osm::location_get(task->osm_network, way->node_ids[idx]);
+        }
+
+        // ~mgj: ignore collinear line segments
+        Buffer<osm::EcefLocation> final_utm_node_buffer = buffer_alloc<osm::EcefLocation>(scratch.arena, buildings_utm_node_buffer.size);
+        {
+            U32 cur_idx = 0;
+            for (U32 idx = 0; idx < buildings_utm_node_buffer.size; idx += 1)
+            {
+                Vec3F64 prev_pos3 = buildings_utm_node_buffer.data[(buildings_utm_node_buffer.size + idx - 1) % buildings_utm_node_buffer.size].pos;
+                Vec3F64 cur_pos3 = buildings_utm_node_buffer.data[idx % buildings_utm_node_buffer.size].pos;
+                Vec3F64 next_pos3 = buildings_utm_node_buffer.data[(idx + 1) % buildings_utm_node_buffer.size].pos;
+                Vec2F64 prev_pos = vec_2f64(prev_pos3.x, prev_pos3.y);
+                Vec2F64 cur_pos = vec_2f64(cur_pos3.x, cur_pos3.y);
+                Vec2F64 next_pos = vec_2f64(next_pos3.x, next_pos3.y);
+
+                B32 is_collinear = AreTwoConnectedLineSegmentsCollinear(prev_pos, cur_pos, next_pos);
+                if (!is_collinear)
+                {
+                    final_utm_node_buffer.data[cur_idx++] = buildings_utm_node_buffer.data[idx];
+                }
+            }
+            final_utm_node_buffer.size = cur_idx;
+        }
+        if (final_utm_node_buffer.size < 3)
+        {
+            continue;
+        }
+
+        Buffer<Vec2F64> node_pos_buffer = buffer_alloc<Vec2F64>(scratch.arena, final_utm_node_buffer.size);
+        for (U32 idx = 0; idx < final_utm_node_buffer.size; idx += 1)
+        {
+            osm::EcefLocation node_utm = final_utm_node_buffer.data[idx];
+            node_pos_buffer.data[idx] = vec_2f64(node_utm.pos.x, node_utm.pos.y);
+        }
+
+        // ~mgj: inner rings of multipolygon buildings are not ingested yet, so there are no holes
+        Buffer<U32> polygon_index_buffer = polygon_triangulate(scratch.arena, node_pos_buffer, {});
+        if (polygon_index_buffer.size > 0)
+        {
+            U32 vertex_offset = task->vertex_offsets[way_idx];
+            for (U32 idx = 0; idx < final_utm_node_buffer.size; idx += 1)
+            {
+                osm::EcefLocation node_utm = final_utm_node_buffer.data[idx];
+                glm::vec3 local_pos = glm::vec3(task->ecef_to_local * glm::dvec4(node_utm.pos.x, node_utm.pos.y, node_utm.pos.z, 1.0));
+                Vec2U32 id = {.u64 = (U64)way->id};
+                task->vertex_buffer.data[vertex_offset + idx] = {
+                    .pos = {local_pos.x, local_pos.y, local_pos.z + task->roof_height},
+                    .uv = {local_pos.x, local_pos.y},
+                    .object_id = id,
+                };
+            }
+            BufferCopy(task->index_buffer, polygon_index_buffer, task->index_offsets[way_idx], 0, polygon_index_buffer.size);
+            task->vertex_counts[way_idx] = final_utm_node_buffer.size;
+            task->index_counts[way_idx] = polygon_index_buffer.size;
+        }
+    }
+}
+
+g_internal void
+buildings_buffers_create(async::ThreadPool* thread_pool, Arena* arena, osm::Network* osm_network, F32 road_height, glm::dmat4& ecef_to_local, BuildingRenderInfo* out_render_info)
 {
     prof_scope_marker;
     ScratchScope scratch = ScratchScope(&arena, 1);
@@ -1287,136 +1275,83 @@ buildings_buffers_create(Arena* arena, osm::Network* osm_network, F32 road_heigh
     F32 building_height = 3;
 
     // ~mgj: Calculate vertex buffer size based on node count
-    U32 total_vertex_count = 0;
-    U32 total_index_count = 0;
+    U32 facade_vertex_count = 0;
+    U32 facade_index_count = 0;
+    U32 roof_vertex_count = 0;
+    U32 roof_index_count = 0;
+    U32* side_offsets = PushArrayNoZero(scratch.arena, U32, ways.size);
+    U32* roof_vertex_offsets = PushArrayNoZero(scratch.arena, U32, ways.size);
+    U32* roof_index_offsets = PushArrayNoZero(scratch.arena, U32, ways.size);
 
     for (U32 i = 0; i < ways.size; i++)
     {
         osm::Way* way = &ways.data[i];
+        side_offsets[i] = facade_vertex_count / 4;
         // ~mgj: first and last node id should be the same
-        U32 way_facade_vertex_count = (way->node_count - 1) * 4;
-        total_vertex_count += way_facade_vertex_count + (way->node_count - 1) * 2;
+        facade_vertex_count += (way->node_count - 1) * 4;
         // ~mgj: count of index for Polyhedron (without ground floor) that makes up the building
-        U64 sides_triangle_count = (way->node_count - 1) * 2;
-        U64 roof_triangle_count = way->node_count - 2;
-        U64 total_triangle_count = sides_triangle_count + roof_triangle_count;
-        total_index_count += total_triangle_count * 3;
+        facade_index_count += (way->node_count - 1) * 6;
+
+        roof_vertex_offsets[i] = roof_vertex_count;
+        roof_index_offsets[i] = roof_index_count;
+        roof_vertex_count += way->node_count - 1;
+        roof_index_count += way->node_count > 3 ? (way->node_count - 3) * 3 : 0;
 
         Assert(way->node_ids[0] == way->node_ids[way->node_count - 1]);
     }
+    for (U32 i = 0; i < ways.size; i++)
+    {
+        roof_vertex_offsets[i] += facade_vertex_count;
+        roof_index_offsets[i] += facade_index_count;
+    }
 
-    Buffer<render::TileVertex> vertex_buffer = buffer_alloc<render::TileVertex>(scratch.arena, total_vertex_count);
-    Buffer<U32> index_buffer = buffer_alloc<U32>(scratch.arena, total_index_count);
+    Buffer<render::TileVertex> vertex_buffer = buffer_alloc<render::TileVertex>(scratch.arena, facade_vertex_count + roof_vertex_count);
+    Buffer<U32> index_buffer = buffer_alloc<U32>(scratch.arena, facade_index_count + roof_index_count);
 
-    U32 base_index_idx = 0;
-    U32 base_vertex_idx = 0;
     {
         prof_scope_marker_named("Facade Creation");
-
-        for (U32 way_idx = 0; way_idx < ways.size; way_idx++)
-        {
-            osm::Way* way = &ways.data[way_idx];
-
-            // ~mgj: Add Vertices and Indices for the sides of building
-            for (U32 node_idx = 0, vert_idx = base_vertex_idx, index_idx = base_index_idx; node_idx < way->node_count - 1; node_idx++, vert_idx += 4, index_idx += 6)
-            {
-                osm::EcefLocation node_loc = osm::location_get(osm_network, way->node_ids[node_idx]);
-                osm::EcefLocation next_node_loc = osm::location_get(osm_network, way->node_ids[node_idx + 1]);
-
-                glm::vec3 local_pos = glm::vec3(ecef_to_local * glm::dvec4(node_loc.pos.x, node_loc.pos.y, node_loc.pos.z, 1.0));
-                glm::vec3 local_next_pos = glm::vec3(ecef_to_local * glm::dvec4(next_node_loc.pos.x, next_node_loc.pos.y, next_node_loc.pos.z, 1.0));
-
-                F32 side_width = glm::length(local_next_pos - local_pos);
-                Vec2U32 id = {.u64 = (U64)way->id};
-
-                vertex_buffer.data[vert_idx] = {.pos = {local_pos.x, local_pos.y, local_pos.z + road_height}, .uv = {0.0f, 0.0f}, .object_id = id};
-                vertex_buffer.data[vert_idx + 1] = {.pos = {local_pos.x, local_pos.y, local_pos.z + road_height + building_height}, .uv = {0.0f, building_height}, .object_id = id};
-                vertex_buffer.data[vert_idx + 2] = {.pos = {local_next_pos.x, local_next_pos.y, local_next_pos.z + road_height}, .uv = {side_width, 0.0f}, .object_id = id};
-                vertex_buffer.data[vert_idx + 3] = {
-                    .pos = {local_next_pos.x, local_next_pos.y, local_next_pos.z + road_height + building_height}, .uv = {side_width, building_height}, .object_id = id};
-
-                index_buffer.data[index_idx] = vert_idx;
-                index_buffer.data[index_idx + 1] = vert_idx + 1;
-                index_buffer.data[index_idx + 2] = vert_idx + 2;
-                index_buffer.data[index_idx + 3] = vert_idx + 1;
-                index_buffer.data[index_idx + 4] = vert_idx + 2;
-                index_buffer.data[index_idx + 5] = vert_idx + 3;
-            }
-
-            base_index_idx += (way->node_count - 1) * 6;
-            base_vertex_idx += (way->node_count - 1) * 4;
-        }
+        _BuildingFacadeTask task = {.osm_network = osm_network,
+                                    .ways = ways,
+                                    .ecef_to_local = ecef_to_local,
+                                    .road_height = road_height,
+                                    .building_height = building_height,
+                                    .vertex_buffer = vertex_buffer,
+                                    .index_buffer = index_buffer,
+                                    .side_offsets = side_offsets};
+        async::parallel_for(thread_pool, ways.size, 0, _building_facade_task, &task);
     }
+    U32 base_index_idx = facade_index_count;
+    U32 base_vertex_idx = facade_vertex_count;
 
     ///////////////////////////////////////////////////////////////////
     // ~mgj: Create roof
     U32 roof_base_index = base_index_idx;
     {
         prof_scope_marker_named("Roof Creation");
+        _BuildingRoofTask task = {.osm_network = osm_network,
+                                  .ways = ways,
+                                  .ecef_to_local = ecef_to_local,
+                                  .roof_height = road_height + building_height,
+                                  .vertex_buffer = vertex_buffer,
+                                  .index_buffer = index_buffer,
+                                  .vertex_offsets = roof_vertex_offsets,
+                                  .index_offsets = roof_index_offsets,
+                                  .vertex_counts = PushArrayNoZero(scratch.arena, U32, ways.size),
+                                  .index_counts = PushArrayNoZero(scratch.arena, U32, ways.size)};
+        async::parallel_for(thread_pool, ways.size, 0, _building_roof_task, &task);
+
+        // ~mgj: pack the slots in way order, the destination never overtakes the source
         for (U32 way_idx = 0; way_idx < ways.size; way_idx++)
         {
-            osm::Way* way = &ways.data[way_idx];
-            Buffer<osm::EcefLocation> buildings_utm_node_buffer = buffer_alloc<osm::EcefLocation>(scratch.arena, way->node_count - 1);
-            for (U32 idx = 0; idx < way->node_count - 1; idx += 1)
+            U32 roof_vertex_offset = roof_vertex_offsets[way_idx];
+            U32 roof_index_offset = roof_index_offsets[way_idx];
+            BufferCopy(vertex_buffer, vertex_buffer, base_vertex_idx, roof_vertex_offset, task.vertex_counts[way_idx]);
+            for (U32 idx = 0; idx < task.index_counts[way_idx]; idx += 1)
             {
-                buildings_utm_node_buffer.data[idx] = osm::location_get(osm_network, way->node_ids[idx]);
-            }
-
-            // ~mgj: ignore collinear line segments
-            Buffer<osm::EcefLocation> final_utm_node_buffer = buffer_alloc<osm::EcefLocation>(scratch.arena, buildings_utm_node_buffer.size);
-            {
-                U32 cur_idx = 0;
-                for (U32 idx = 0; idx < buildings_utm_node_buffer.size; idx += 1)
-                {
-                    Vec3F64 prev_pos3 = buildings_utm_node_buffer.data[(buildings_utm_node_buffer.size + idx - 1) % buildings_utm_node_buffer.size].pos;
-                    Vec3F64 cur_pos3 = buildings_utm_node_buffer.data[idx % buildings_utm_node_buffer.size].pos;
-                    Vec3F64 next_pos3 = buildings_utm_node_buffer.data[(idx + 1) % buildings_utm_node_buffer.size].pos;
-                    Vec2F64 prev_pos = vec_2f64(prev_pos3.x, prev_pos3.y);
-                    Vec2F64 cur_pos = vec_2f64(cur_pos3.x, cur_pos3.y);
-                    Vec2F64 next_pos = vec_2f64(next_pos3.x, next_pos3.y);
-
-                    B32 is_collinear = AreTwoConnectedLineSegmentsCollinear(prev_pos, cur_pos, next_pos);
-                    if (!is_collinear)
-                    {
-                        final_utm_node_buffer.data[cur_idx++] = buildings_utm_node_buffer.data[idx];
-                    }
-                }
-                final_utm_node_buffer.size = cur_idx;
-            }
-
-            // ~mgj: prepare for ear clipping algo
-            Buffer<Vec2F64> node_pos_buffer = buffer_alloc<Vec2F64>(scratch.arena, final_utm_node_buffer.size);
-            for (U32 idx = 0; idx < final_utm_node_buffer.size; idx += 1)
-            {
-                osm::EcefLocation node_utm = final_utm_node_buffer.data[idx];
-                node_pos_buffer.data[idx] = vec_2f64(node_utm.pos.x, node_utm.pos.y);
-            }
-
-            Buffer<U32> polygon_index_buffer = EarClipping(scratch.arena, node_pos_buffer);
-            if (polygon_index_buffer.size > 0)
-            {
-                // vertex buffer fill
-                for (U32 idx = 0; idx < final_utm_node_buffer.size; idx += 1)
-                {
-                    osm::EcefLocation node_utm = final_utm_node_buffer.data[idx];
-                    glm::vec3 local_pos = glm::vec3(ecef_to_local * glm::dvec4(node_utm.pos.x, node_utm.pos.y, node_utm.pos.z, 1.0));
-                    Vec2U32 id = {.u64 = (U64)way->id};
-                    vertex_buffer.data[base_vertex_idx + idx] = {
-                        .pos = {local_pos.x, local_pos.y, local_pos.z + road_height + building_height},
-                        .uv = {local_pos.x, local_pos.y},
-                        .object_id = id,
-                    };
-                }
-
-                // index buffer fill
-                for (U32 idx = 0; idx < polygon_index_buffer.size; idx += 1)
-                {
-                    index_buffer.data[base_index_idx + idx] = polygon_index_buffer.data[idx] + base_vertex_idx;
-                }
-
-                base_vertex_idx += final_utm_node_buffer.size;
-                base_index_idx += polygon_index_buffer.size;
+                index_buffer.data[base_index_idx + idx] = index_buffer.data[roof_index_offset + idx] + base_vertex_idx;
             }
+            base_vertex_idx += task.vertex_counts[way_idx];
+            base_index_idx += task.index_counts[way_idx];
         }
     }
 
@@ -1437,7 +1372,7 @@ buildings_buffers_create(Arena* arena, osm::Network* osm_network, F32 road_heigh
 }
 
 g_internal void
-buildings_build(City* city, osm::Network* osm_network, render::SamplerInfo* sampler_info, glm::dmat4& ecef_to_local, F32 road_height)
+buildings_build(async::ThreadPool* thread_pool, City* city, osm::Network* osm_network, render::SamplerInfo* sampler_info, glm::dmat4& ecef_to_local, F32 road_height)
 {
     Buildings* buildings = &city->buildings;
 
@@ -1445,7 +1380,7 @@ buildings_build(City* city, osm::Network* osm_network, render::SamplerInfo* samp
     render::Handle roof_texture_handle = render::texture_load_async(sampler_info, buildings->roof_texture_path);
 
     city::BuildingRenderInfo render_info;
-    city::buildings_buffers_create(city->arena, osm_network, road_height, ecef_to_local, &render_info);
+    city::buildings_buffers_create(thread_pool, city->arena, osm_network, road_height, ecef_to_local, &render_info);
     render::BufferInfo vertex_buffer_info = render::BufferInfo(render_info.vertex_buffer, render::BufferType_Vertex);
     render::BufferInfo index_buffer_info = render::BufferInfo(render_info.index_buffer, render::BufferType_Index);
 
@@ -1464,175 +1399,6 @@ buildings_build(City* city, osm::Network* osm_network, render::SamplerInfo* samp
                                        .index_offset = render_info.facade_index_offset};
 }
 
-g_internal Direction
-ClockWiseTest(Buffer<Vec2F64> node_buffer)
-{
-    F64 total = 0;
-    for (U32 idx = 0; idx < node_buffer.size; idx += 1)
-    {
-        Vec2F64 a = node_buffer.data[idx];
-        Vec2F64 b = node_buffer.data[(idx + 1) % node_buffer.size];
-
-        F64 cross_product_z = cross_2f64_z_component(a, b);
-        total += cross_product_z;
-    }
-    if (total > 0)
-    {
-        return Direction_CounterClockwise;
-    }
-    else if (total < 0)
-    {
-        return Direction_Clockwise;
-    }
-    DEBUG_LOG("ClockWiseTest: Lines are collinear\n");
-    return Direction_Undefined;
-}
-
-g_internal Buffer<U32>
-IndexBufferCreate(Arena* arena, U64 buffer_size, Direction direction)
-{
-    Buffer<U32> index_buffer = buffer_alloc<U32>(arena, buffer_size);
-    if (direction == Direction_Clockwise)
-    {
-        for (U32 i = 0; i < index_buffer.size; i++)
-        {
-            index_buffer.data[i] = i;
-        }
-    }
-    else if (direction == Direction_CounterClockwise)
-    {
-        for (U32 i = 0; i < index_buffer.size; i++)
-        {
-            index_buffer.data[i] = index_buffer.size - i - 1;
-        }
-    }
-    else if (direction == Direction_Undefined)
-    {
-        Assert(0);
-    }
-    return index_buffer;
-}
-
-// Shoelace Algorithm
-// source: https://artofproblemsolving.com/wiki/index.php/Shoelace_Theorem
-g_internal B32
-PointInTriangle(Vec2F64 p1, Vec2F64 p2, Vec2F64 p3, Vec2F64 point)
-{
-    F64 d1, d2, d3;
-    B32 has_neg, has_pos;
-
-    d1 = cross_2f64_z_component(sub_2f64(point, p1), sub_2f64(p2, p1));
-    d2 = cross_2f64_z_component(sub_2f64(point, p2), sub_2f64(p3, p2));
-    d3 = cross_2f64_z_component(sub_2f64(point, p3), sub_2f64(p1, p3));
-
-    has_neg = (d1 < 0) || (d2 < 0) || (d3 < 0);
-    has_pos = (d1 > 0) || (d2 > 0) || (d3 > 0);
-
-    return !(has_neg && has_pos);
-}
-
-g_internal void
-NodeBufferPrintDebug(Buffer<Vec2F64> node_buffer)
-{
-    DEBUG_LOG("Error in ear clipping algo. Expecting vertex_count-2 number of triangles\n"
-              "The following vertices are the problem: \n");
-    for (U32 pt_idx = 0; pt_idx < node_buffer.size; pt_idx++)
-    {
-        printf("%d, %f, %f\n", pt_idx, node_buffer.data[pt_idx].x, node_buffer.data[pt_idx].y);
-    }
-}
-
-g_internal Buffer<U32>
-EarClipping(Arena* arena, Buffer<Vec2F64> node_buffer)
-{
-    prof_scope_marker;
-    Assert(node_buffer.size >= 3);
-    ScratchScope scratch = ScratchScope(&arena, 1);
-
-    U32 total_triangle_count = (node_buffer.size - 2);
-    U32 total_index_count = total_triangle_count * 3;
-
-    Direction direction = ClockWiseTest(node_buffer);
-    if (direction == Direction_Undefined)
-    {
-        DEBUG_LOG("Cannot determine direction\n");
-        DEBUG_FUNC(NodeBufferPrintDebug(node_buffer));
-        return {0, 0};
-    }
-    Buffer<U32> index_buffer = IndexBufferCreate(scratch.arena, node_buffer.size, direction);
-    Buffer<U32> out_vertex_index_buffer = buffer_alloc<U32>(arena, total_index_count);
-    U32 cur_index_buffer_idx = 0;
-    U32 idx = 0;
-    for (; idx < index_buffer.size;)
-    {
-        if (index_buffer.size < 3)
-        {
-            break;
-        }
-
-        U32 ear_index_buffer_idx = idx % index_buffer.size;
-        U32 prev_index_buffer_idx = (index_buffer.size + idx - 1) % index_buffer.size;
-        U32 next_index_buffer_idx = (index_buffer.size + idx + 1) % index_buffer.size;
-
-        U32 ear_node_buffer_idx = index_buffer.data[ear_index_buffer_idx];
-        U32 prev_node_buffer_idx = index_buffer.data[prev_index_buffer_idx];
-        U32 next_node_buffer_idx = index_buffer.data[next_index_buffer_idx];
-
-        Vec2F64 ear = node_buffer.data[ear_node_buffer_idx];
-        Vec2F64 prev = node_buffer.data[prev_node_buffer_idx];
-        Vec2F64 next = node_buffer.data[next_node_buffer_idx];
-
-        Vec2F64 prev_to_ear = sub_2f64(ear, prev);
-        Vec2F64 ear_to_next = sub_2f64(next, ear);
-
-        F64 cross_product_z = cross_2f64_z_component(prev_to_ear, ear_to_next);
-
-        // negative cross product z component means that the triangle has clockwise orientation.
-        if (cross_product_z < 0)
-        {
-            B32 is_ear = true;
-            for (U32 test_i = 0; test_i < index_buffer.size - 3; test_i++)
-            {
-                U32 test_node_buffer_idx = index_buffer.data[(next_index_buffer_idx + test_i + 1) % index_buffer.size];
-                Vec2F64 test_point = node_buffer.data[test_node_buffer_idx];
-
-                if (PointInTriangle(prev, ear, next, test_point))
-                {
-                    is_ear = false;
-                    break;
-                }
-            }
-
-            if (is_ear)
-            {
-                // add ear to vertex buffer
-                out_vertex_index_buffer.data[cur_index_buffer_idx] = prev_node_buffer_idx;
-                out_vertex_index_buffer.data[cur_index_buffer_idx + 1] = ear_node_buffer_idx;
-                out_vertex_index_buffer.data[cur_index_buffer_idx + 2] = next_node_buffer_idx;
-                cur_index_buffer_idx += 3;
-
-                // remove ear from index buffer
-                BufferItemRemove(&index_buffer, ear_index_buffer_idx);
-                idx = 0;
-                continue;
-            }
-        }
-        else if (cross_product_z == 0)
-        {
-            DEBUG_LOG("EarClipping: Two line segments are collinear");
-        }
-        idx++;
-    }
-    if (cur_index_buffer_idx != out_vertex_index_buffer.size)
-    {
-        DEBUG_FUNC(NodeBufferPrintDebug(node_buffer));
-        out_vertex_index_buffer.size = cur_index_buffer_idx;
-    }
-
-    Assert(cur_index_buffer_idx == out_vertex_index_buffer.size);
-    return out_vertex_index_buffer;
-}
-
 g_internal render::SamplerInfo
 sampler_from_cgltf_sampler(gltfw_Sampler sampler)
 {
@@ -1769,16 +1535,14 @@ road_create(City* city, Road* in_out_road, glm::dmat4& ecef_to_local, String8 ar
     in_out_road->road_height = 10.0f;
     in_out_road->default_road_width = 2.0f;
 
-    U64 node_hashmap_size = 1000;
-    U64 way_hashmap_size = 100;
-    city->osm_network = osm::osm_init(node_hashmap_size, way_hashmap_size, ctx->data_subdirs.data[dt_DataDirType::Cache], area, bbox_cache_str);
+    city->osm_network = osm::osm_init(ctx->data_subdirs.data[dt_DataDirType::Cache], area, bbox_cache_str);
 }
 
 g_internal Map<osm::EdgeId, RoadInfo>*
 road_info_from_edge_id(Arena* arena, osm::Network* network, Buffer<osm::RoadEdge> road_edge_buf, Map<S64, neta::EdgeList>* neta_edge_map)
 {
     prof_scope_marker;
-    Map<osm::EdgeId, RoadInfo>* road_info_map = map_create<osm::EdgeId, RoadInfo>(arena, 1024);
+    Map<osm::EdgeId, RoadInfo>* road_info_map = map_create<osm::EdgeId, RoadInfo>(arena, road_edge_buf.size);
 
     for (osm::RoadEdge& edge : road_edge_buf)
     {
@@ -1846,4 +1610,63 @@ vertex_3d_from_gltfw_vertex(Arena* arena, Buffer<gltfw_Vertex3D> in_vertex_buffe
     return out_vertex_buffer;
 }
 
+// ~mgj: CPU path of road_intersection.comp. Returns the road segment (index into
+// road_segment_buffer_sorted, max_U32 for none) under the centroid of every tile triangle.
+g_internal Buffer<U32>
+road_tile_triangles_classify(Arena* arena, BvhResult* bvh, Buffer<render::TileVertex> vertices, Buffer<U32> indices)
+{
+    ScratchScope scratch = ScratchScope(&arena, 1);
+    U64 triangle_count = indices.size / 3;
+    Buffer<Vec2F32> centroids = buffer_alloc<Vec2F32>(scratch.arena, triangle_count);
+    for (U64 i = 0; i < triangle_count; ++i)
+    {
+        Vec3F32 v0 = vertices.data[indices.data[i * 3]].pos;
+        Vec3F32 v1 = vertices.data[indices.data[i * 3 + 1]].pos;
+        Vec3F32 v2 = vertices.data[indices.data[i * 3 + 2]].pos;
+        centroids.data[i] = {.x = (v0.x + v1.x + v2.x) / 3.0f, .y = (v0.y + v1.y + v2.y) / 3.0f};
+    }
+    Buffer<U32> triangle_segment_idx = buffer_alloc<U32>(arena, triangle_count);
+    bvh_points_classify(bvh, centroids, triangle_segment_idx);
+    return triangle_segment_idx;
+}
+
+// ~mgj: Writes what road_intersection.comp writes for a classified triangle
+g_internal void
+road_tile_overlay_apply(BvhResult* bvh, Buffer<render::TileVertex> vertices, Buffer<U32> indices, Buffer<U32> triangle_segment_idx, RoadOverlayOption overlay_option)
+{
+    for (U64 i = 0; i < triangle_segment_idx.size; ++i)
+    {
+        U32 segment_idx = triangle_segment_idx.data[i];
+        if (segment_idx == max_U32)
+        {
+            continue;
+        }
+        RoadSegmentCorners* segment = bvh->road_segment_buffer_sorted[segment_idx];
+        for (U64 j = i * 3; j < i * 3 + 3; ++j)
+        {
+            render::TileVertex* vertex = vertices[indices.data[j]];
+            vertex->object_id = {.u64 = (U64)segment->edge_id};
+            vertex->colormap_value = segment->road_info.options[overlay_option];
+        }
+    }
+}
+
+// ~mgj: cesium::TileTriangleClassifyFunc, data is the Road. Runs on the tile load threads once the road BVH
+// is built, out_triangle_segments gets the index + 1 convention of road_intersection.comp
+g_internal void
+road_tile_classify(void* data, Buffer<render::TileVertex> vertices, Buffer<U32> indices, U32 overlay_option, Buffer<U32> out_triangle_segments)
+{
+    prof_scope_marker;
+    Road* road = (Road*)data;
+    BvhResult* bvh = &road->road_build_result.bvh_result;
+    ScratchScope scratch = ScratchScope(0, 0);
+    Buffer<U32> triangle_segment_idx = road_tile_triangles_classify(scratch.arena, bvh, vertices, indices);
+    road_tile_overlay_apply(bvh, vertices, indices, triangle_segment_idx, (RoadOverlayOption)overlay_option);
+    for (U64 i = 0; i < triangle_segment_idx.size; ++i)
+    {
+        U32 segment_idx = triangle_segment_idx.data[i];
+        out_triangle_segments.data[i] = segment_idx == max_U32 ? 0 : segment_idx + 1;
+    }
+}
+
 } // namespace city
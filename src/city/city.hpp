@@ -5,131 +5,26 @@
 namespace city
 {
 
-struct Buildings;
-
-enum RoadSegmentCornerCoord
-{
-    RoadSegmentCornerCoord_TopLeft,
-    RoadSegmentCornerCoord_TopRight,
-    RoadSegmentCornerCoord_BottomRight,
-    RoadSegmentCornerCoord_BottomLeft,
-    RoadSegmentCornerCoord_Count
-};
-
-#define ROAD_OVERLAY_OPTIONS            \
-    X(None, "None")                     \
-    X(Bikeability_ft, "Bikeability_ft") \
-    X(Bikeability_tf, "Bikeability_tf") \
-    X(Walkability_tf, "Walkability_tf") \
-    X(Walkability_ft, "Walkability_ft")
-
-enum RoadOverlayOption : U32
-{
-#define X(name, str) RoadOverlayOption_##name,
-    ROAD_OVERLAY_OPTIONS
-#undef X
-        RoadOverlayOption_Count
-};
-
 read_only g_internal const char* road_overlay_option_strs[] = {
 #define X(name, str) str,
     ROAD_OVERLAY_OPTIONS
 #undef X
 };
 
-struct RoadInfo
-{
-    F32 options[RoadOverlayOption_Count];
-};
-
-struct alignas(8) RoadSegmentCorners
-{
-    osm::EdgeId edge_id;
-    Vec2F32 corners[RoadSegmentCornerCoord_Count];
-    RoadInfo road_info;
-};
-// BVH types
-enum Bounds : U32
-{
-    Bounds_Min,
-    Bounds_Max,
-    Bounds_Count
-};
-
-struct RoadSegmentNode
-{
-    RoadSegmentNode* next;
-    RoadSegmentNode* parent;
-    U32 final_idx;
-    Rng2F32 bounds;
-    RoadSegmentNode* children[2];
-    U32 split_axis;
-    F32 split_value;
-
-    // buffer range
-    U32 start_idx;
-    U32 end_idx;
-};
-
-struct RoadSegmentNodeStorageBuffer
-{
-    F32 min_x;
-    F32 min_y;
-    F32 max_x;
-    F32 max_y;
-    U32 split_axis;
-    F32 split_value;
-    U32 is_leaf;
-    union
-    {
-        struct
-        {
-            U32 child_0_idx;
-            U32 child_1_idx;
-        };
-        struct
-        {
-            U32 start_idx;
-            U32 end_idx;
-        };
-    };
-    U32 _pad;
-};
-static_assert(sizeof(RoadSegmentNodeStorageBuffer) == 40, "RoadSegmentNodeStorageBuffer must match std430 RoadSegmentNode size");
-
-struct BoundingBox
-{
-    Vec2F32 center;
-    Rng2F32 bounds;
-    U32 idx;
-};
-
-struct BvhContext
-{
-    RoadSegmentNode* stack;
-    RoadSegmentNode* root;
-
-    U32 road_segment_node_count;
-
-    Buffer<RoadSegmentCorners> road_segment_buffer;
-    Buffer<BoundingBox> bb_buffer;
-
-    U32 leaf_bb_max;
+read_only g_internal const char* agent_motion_interp_strs[] = {
+#define X(name, str) str,
+    AGENT_MOTION_INTERPS
+#undef X
 };
 
-struct BvhResult
-{
-    Buffer<RoadSegmentCorners> road_segment_buffer_sorted;
-    Buffer<RoadSegmentNodeStorageBuffer> node_buffer;
-};
-// /////////////////////////////////
-static_assert(sizeof(RoadSegmentCorners) == 64, "size of road segment might not match shader size");
+struct Buildings;
 
 struct RoadBuildResult
 {
     render::Handle vertex_buffer_handle;
     render::Handle index_buffer_handle;
     BvhResult bvh_result;
+    RoadGrid road_grid; // centre lines, for snapping the agents
 };
 
 struct Road
@@ -185,22 +80,6 @@ struct Car
     F32 speed;
 };
 
-typedef S64 WsId;
-struct Agent
-{
-    glm::dvec3 ecef_coord;
-    glm::dvec3 ecef_dir;
-    U64 latest_update_frame;
-
-    // rendering
-    render::Transform model_matrix;
-};
-
-struct AgentMapItem
-{
-    Agent* agent;
-};
-
 struct AgentSim
 {
     Allocator* allocator;
@@ -211,8 +90,7 @@ struct AgentSim
     U32 max_agent_count;
 
     Buffer<Car> cars;
-    Map<WsId, AgentMapItem>* agent_map;
-    ArenaArray<Agent>* agents_active;
+    AgentStore* agents; // live feed agents, see agent_store.hpp
 
     // rendering
     Buffer<render::MeshHandlePair> meshes;
@@ -247,7 +125,6 @@ enum class AsyncTaskType : U32
     None,
     Neta,
     Osm,
-    Road,
     CarSim,
     Cached,
 
@@ -275,7 +152,6 @@ struct AsyncCityTask
     {
         async::AsyncTaskStatus<neta::NetaTaskState>* neta;
         async::AsyncTaskStatus<osm::Network>* osm;
-        async::AsyncTaskStatus<RoadBuildTask>* road;
         async::AsyncTaskStatus<CarSimBuildTask>* car_sim;
         AsyncTaskType cached_type;
     };
@@ -287,6 +163,18 @@ struct AsyncCityTaskList
     AsyncCityTask* last;
 };
 
+// ~mgj: osm and neta complete when their async tasks do, the road stages then run back to back on the
+// worker that finished the last of them
+struct CityBuildGraph
+{
+    async::TaskGraph* graph;
+    async::TaskNode* osm;
+    async::TaskNode* neta;
+    async::TaskNode* road_match;   // NetAScore values per road edge
+    async::TaskNode* road_segment; // road segments and BVH
+    async::TaskNode* road_upload;  // GPU buffers
+};
+
 struct AreaConfig
 {
     String8 name;
@@ -309,7 +197,6 @@ struct City
     osm::Network* osm_network;
     bool neta_task_done;
     bool osm_task_done;
-    bool road_building_started;
     bool road_building_done;
     bool cars_creation_started;
     bool cars_creation_done;
@@ -317,6 +204,8 @@ struct City
     Road road;
     AgentSim car_sim;
     F32 agent_scale_factor;
+    AgentMotionConfig agent_motion;
+    F32 agent_road_snap_distance; // meters, 0 turns snapping off
     Buildings buildings;
     ArrayResourcePoolHandle tileset_handle;
     neta::NetaState* neta_state;
@@ -324,13 +213,14 @@ struct City
 
     // async
     AsyncCityTaskList task_list;
+    CityBuildGraph build_graph;
 };
 
 g_internal void
 road_destroy(Road* road);
 g_internal city::RoadBuildResult
-road_segment_build(Arena* arena, osm::Network* network, Buffer<osm::RoadEdge> edge_buffer, F32 default_road_width, F32 road_height, glm::dmat4& ecef_to_local,
-                   Map<osm::EdgeId, RoadInfo>* road_info_map);
+road_segment_build(async::ThreadPool* thread_pool, Arena* arena, osm::Network* network, Buffer<osm::RoadEdge> edge_buffer, F32 default_road_width, F32 road_height,
+                   glm::dmat4& ecef_to_local, Map<osm::EdgeId, RoadInfo>* road_info_map);
 
 g_internal AsyncCityTask*
 _cache_and_parse_osm_json(async::ThreadPool* thread_pool, Road* road, osm::Network* osm_network);
@@ -340,13 +230,11 @@ quad_to_buffer_add(RoadSegmentCorners* road_segment, Buffer<render::Vertex3DBlen
 g_internal Buildings*
 buildings_create(String8 cache_path, String8 texture_path, Rng2F64 bbox);
 g_internal void
-buildings_build(City* city, osm::Network* osm_network, render::SamplerInfo* sampler_info, glm::dmat4& ecef_to_local, F32 road_height);
+buildings_build(async::ThreadPool* thread_pool, City* city, osm::Network* osm_network, render::SamplerInfo* sampler_info, glm::dmat4& ecef_to_local, F32 road_height);
 g_internal void
 building_destroy(City* city);
 g_internal void
-buildings_buffers_create(Arena* arena, osm::Network* network, F32 road_height, glm::dmat4& ecef_to_local, BuildingRenderInfo* out_render_info);
-g_internal Buffer<U32>
-EarClipping(Arena* arena, Buffer<Vec2F64> node_buffer);
+buildings_buffers_create(async::ThreadPool* thread_pool, Arena* arena, osm::Network* network, F32 road_height, glm::dmat4& ecef_to_local, BuildingRenderInfo* out_render_info);
 
 // ~mgj: Cars
 g_internal void
@@ -354,14 +242,20 @@ agents_create(AgentSim* car_sim, osm::Network* network);
 g_internal void
 agent_sim_destroy(AgentSim* car_sim);
 g_internal void
-agent_sim_update(AgentSim* agent_sim, Buffer<Coordinate> coord_buffer, glm::dmat4& ecef_to_local, F32 scale_factor, U64 cur_frame);
+agent_sim_update(async::ThreadPool* thread_pool, AgentSim* agent_sim, Buffer<Coordinate> coord_buffer, glm::dmat4& ecef_to_local, F32 scale_factor,
+                 const AgentMotionConfig* motion, U64 now_us, RoadGrid* road_grid, F32 road_snap_distance);
 // ~mgj: HTTP and caching
 g_internal String8
 str8_from_bbox(Arena* arena, Rng2F64 bbox);
 g_internal render::SamplerInfo
 sampler_from_cgltf_sampler(gltfw_Sampler sampler);
-g_internal async::AsyncTaskContinuation<RoadBuildTask>
-road_build(async::ThreadInfo info, async::AsyncTaskStatus<RoadBuildTask>* status);
+// ~mgj: CityBuildGraph nodes, data is a RoadBuildTask
+g_internal B32
+road_match_run(async::ThreadInfo info, void* data, async::CancelToken* cancel_token);
+g_internal B32
+road_segment_run(async::ThreadInfo info, void* data, async::CancelToken* cancel_token);
+g_internal B32
+road_upload_run(async::ThreadInfo info, void* data, async::CancelToken* cancel_token);
 g_internal async::AsyncTaskContinuation<CarSimBuildTask>
 agent_sim_build(async::ThreadInfo info, async::AsyncTaskStatus<CarSimBuildTask>* status);
 g_internal void
@@ -386,28 +280,20 @@ edge_from_road_edge(osm::Network* network, osm::RoadEdge* road_edge, Map<S64, ne
 
 g_internal Buffer<render::TileVertex>
 vertex_3d_from_gltfw_vertex(Arena* arena, Buffer<gltfw_Vertex3D> in_vertex_buffer);
+g_internal Buffer<U32>
+road_tile_triangles_classify(Arena* arena, BvhResult* bvh, Buffer<render::TileVertex> vertices, Buffer<U32> indices);
+g_internal void
+road_tile_overlay_apply(BvhResult* bvh, Buffer<render::TileVertex> vertices, Buffer<U32> indices, Buffer<U32> triangle_segment_idx, RoadOverlayOption overlay_option);
+g_internal void
+road_tile_classify(void* data, Buffer<render::TileVertex> vertices, Buffer<U32> indices, U32 overlay_option, Buffer<U32> out_triangle_segments);
 
 g_internal void
 road_segment_from_road_nodes(RoadSegment* out_road_segment, osm::EcefLocation node_0, osm::EcefLocation node_1, F32 road_width);
 g_internal void
 road_segments_coalesce(RoadSegment* in_out_road_segment_0, RoadSegment* in_out_road_segment_1, F32 road_width);
 g_internal F32
-tag_value_get(Arena* arena, String8 key, F32 default_width, Buffer<osm::Tag> tags);
+tag_value_get(osm::TagKeyId key, F32 default_width, osm::TagList tags);
 
-// BVH functions /////////////////////////////
-g_internal void
-quick_select(Buffer<BoundingBox> center_buffer, U32 split_axis, U32 start_idx, U32 end_idx, U32 k);
-g_internal Rng2F32
-bounds_union(Rng2F32 a, Rng2F32 b);
-g_internal Rng2F32
-bounds_union(Rng2F32 rng, Vec2F32 vec);
-g_internal Rng2F32
-bounds_union(Buffer<BoundingBox> center_buffer, U32 start_idx, U32 end_idx);
-g_internal Axis2
-split_axis_find(Buffer<BoundingBox> bb_buffer, U32 start_idx, U32 end_idx);
-g_internal BvhResult
-bvh_create(Arena* arena, Buffer<RoadSegmentCorners> road_segment_buffer, U32 leaf_bb_max);
-////////////////////////////////////
 
 g_internal Vec3F64
 height_dim_add(Vec2F64 pos, F64 height);
@@ -420,61 +306,4 @@ cross_2f64_z_component(Vec2F64 a, Vec2F64 b);
 g_internal B32
 AreTwoConnectedLineSegmentsCollinear(Vec2F64 prev, Vec2F64 cur, Vec2F64 next);
 
-enum Direction
-{
-    Direction_Undefined,
-    Direction_Clockwise,
-    Direction_CounterClockwise
-};
-
-g_internal Direction
-ClockWiseTest(Buffer<Vec2F64> node_buffer);
-g_internal Buffer<U32>
-IndexBufferCreate(Arena* arena, U64 buffer_size, Direction direction);
-g_internal B32
-PointInTriangle(Vec2F64 p1, Vec2F64 p2, Vec2F64 p3, Vec2F64 point);
-g_internal void
-NodeBufferPrintDebug(Buffer<Vec2F64> node_buffer);
-
-// coordinates from str list
-
-g_internal Buffer<Coordinate>
-_city_coordinate_buffer_from_str(Arena* arena, String8 json)
-{
-    prof_scope_marker;
-    simdjson::ondemand::parser parser;
-    simdjson::ondemand::document doc;
-    simdjson::padded_string json_padded((char*)json.str, json.size);
-    simdjson::error_code error = parser.iterate(json_padded).get(doc);
-    defer(if (error) DEBUG_LOG("error in Coordinate Buffer deserialization"););
-
-    U64 element_count = doc.count_elements();
-    Buffer<Coordinate> coord_buffer = buffer_alloc<Coordinate>(arena, element_count);
-    U32 idx = 0;
-    for (auto obj : doc)
-    {
-        Coordinate* coord = coord_buffer[idx];
-        error = obj.get<Coordinate>(*coord);
-        if (error)
-        {
-            return {};
-        }
-        idx++;
-    }
-
-    return coord_buffer;
-}
-
-g_internal Buffer<Coordinate>
-city_latest_coordinates_buffer_from_str8_list(Arena* arena, String8List* list)
-{
-    Buffer<Coordinate> buffer = {};
-    if (list->last)
-    {
-        String8 json = list->last->string;
-        buffer = _city_coordinate_buffer_from_str(arena, json);
-    }
-    return buffer;
-}
-
 } // namespace city
@@ -1,2 +1,8 @@
 #include "neta.cpp"
+#include "city/road_bvh.cpp"
+#include "city/road_grid.cpp"
+#include "city/triangulate.cpp"
+#include "city/agent_wire.cpp"
+#include "city/agent_ingest.cpp"
+#include "city/agent_store.cpp"
 #include "city/city.cpp"
@@ -5,4 +5,10 @@
 
 // ~mgj: user defined[h/hpp]
 #include "neta.hpp"
+#include "city/road_bvh.hpp"
+#include "city/road_grid.hpp"
+#include "city/triangulate.hpp"
+#include "city/agent_wire.hpp"
+#include "city/agent_ingest.hpp"
+#include "city/agent_store.hpp"
 #include "city/city.hpp"
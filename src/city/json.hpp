@@ -7,6 +7,7 @@ struct Coordinate
     S64 id;
     F64 lat;
     F64 lon;
+    U64 timestamp_us; // unix microseconds, from "t" (unix seconds) when the object has it, otherwise left as it was
 };
 } // namespace city
 
@@ -39,5 +40,16 @@ simdjson::ondemand::value::get(city::Coordinate& out) noexcept
         return error;
     }
 
+    F64 timestamp_sec = 0;
+    error = obj["t"].get_double().get(timestamp_sec);
+    if (error == simdjson::SUCCESS)
+    {
+        out.timestamp_us = (U64)(timestamp_sec * 1'000'000.0);
+    }
+    else if (error != simdjson::NO_SUCH_FIELD)
+    {
+        return error;
+    }
+
     return simdjson::SUCCESS;
 }
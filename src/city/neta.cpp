@@ -128,7 +128,7 @@ osm_way_to_edges_map_create(Arena* arena, osm::Network* network, String8 file_pa
         }
     }
 
-    Map<S64, EdgeList>* edge_map = map_create<S64, EdgeList>(arena, 10);
+    Map<S64, EdgeList>* edge_map = map_create<S64, EdgeList>(arena, edge_buf.size);
     for (U32 i = 0; i < edge_buf.size; i++)
     {
         Edge* edge = edge_buf[i];
@@ -166,66 +166,68 @@ mobilitylab_api_key_header_get(Arena* arena, String8 api_key)
     String8 result = str8_list_join(arena, &parts, 0);
     return result;
 }
-static void
-_netascore_download_enqueue(Arena* arena, NetaTaskState* task_state, String8 key, String8 file_name)
-{
-    NetascoreDownloadQueue* download_queue = &task_state->download_queue;
-    NetascoreDownloadNode* node = PushStruct(arena, NetascoreDownloadNode);
-    node->key = push_str8_copy(arena, key);
-    node->file_name = push_str8_copy(arena, file_name);
-    SLLQueuePush(download_queue->first, download_queue->last, node);
-}
 
-static async::HttpInfo*
-_netascore_next_download_http_info(Arena* arena, NetaTaskState* task_state)
+static Result<NetascoreJobStatus>
+_netascore_job_status_parse(Arena* arena, String8 body)
 {
-    NetascoreDownloadQueue* download_queue = &task_state->download_queue;
-    NetascoreDownloadNode* node = download_queue->first;
-    if (node == 0)
+    Result<NetascoreJobStatus> result = {.err = true};
+    simdjson::dom::parser parser;
+    simdjson::dom::element doc = {};
+    simdjson::error_code err = parser.parse(body.str, body.size).get(doc);
+    if (err)
     {
-        return 0;
+        ERROR_LOG("Failed to parse NetAScore job response");
+        return result;
     }
 
-    String8 download_api = push_str8f(arena, "%.*s%.*s/download/%.*s", str8_varg(mobilitylab_jobs_api_get()), str8_varg(download_queue->job_id), str8_varg(node->key));
-    async::HttpInfo* http_info = async::http_info_create_get(arena, download_api, {task_state->mobility_api_key_header});
-    return http_info;
-}
-
-static async::UserFuncResult<NetaTaskState>
-_netascore_download_file_complete(Arena* arena, async::ThreadPool* thread_pool, String8 body, NetaTaskState* task_state)
-{
-    (void)thread_pool;
-    NetascoreDownloadQueue* download_queue = &task_state->download_queue;
-    if (download_queue->first == 0)
+    simdjson::dom::object obj = {};
+    err = doc.get_object().get(obj);
+    if (err)
     {
-        return async::UserFuncResult<NetaTaskState>::failure(arena, "Missing current NetAScore download file name");
+        ERROR_LOG("Expected NetAScore job response to be an object");
+        return result;
     }
-    SLLQueuePop(download_queue->first, download_queue->last);
 
-    cache_write(task_state->cache_file_location, body, task_state->cache_bbox_str);
-    task_state->data_downloaded.store(true);
+    const char* status = 0;
+    const char* job_id = 0;
+    simdjson::error_code err_status = obj["status"].get_c_str().get(status);
+    simdjson::error_code err_job_id = obj["job_id"].get_c_str().get(job_id);
+    if (err_status || err_job_id)
+    {
+        ERROR_LOG("NetAScore job response is missing status or job_id");
+        return result;
+    }
 
-    return async::UserFuncResult<NetaTaskState>::success();
+    const char* error_msg = 0;
+    if (obj["error"].get_c_str().get(error_msg) == simdjson::SUCCESS && error_msg != 0)
+    {
+        result.v.error_msg = push_str8_copy(arena, str8_c_string(error_msg));
+    }
+    result.v.job_id = push_str8_copy(arena, str8_c_string(job_id));
+    result.v.status = push_str8_copy(arena, str8_c_string(status));
+    result.err = false;
+    return result;
 }
 
-static async::UserFuncResult<NetaTaskState>
-_netascore_downloads_complete(Arena* arena, async::ThreadPool* thread_pool, String8 body, NetaTaskState* task_state)
+static Result<String8>
+_netascore_edges_download_key_parse(Arena* arena, String8 body)
 {
-    (void)thread_pool;
-    NetascoreDownloadQueue* download_queue = &task_state->download_queue;
+    Result<String8> result = {.err = true};
     simdjson::dom::parser parser;
     simdjson::dom::element doc = {};
     simdjson::error_code err = parser.parse(body.str, body.size).get(doc);
     if (err)
     {
-        return async::UserFuncResult<NetaTaskState>::failure(arena, "Failed to parse NetAScore downloads response");
+        ERROR_LOG("Failed to parse NetAScore downloads response");
+        return result;
     }
 
     simdjson::dom::array downloads = {};
     err = doc.get_array().get(downloads);
     if (err)
     {
-        return async::UserFuncResult<NetaTaskState>::failure(arena, "Expected NetAScore downloads response to be an array");
+        ERROR_LOG("Expected NetAScore downloads response to be an array");
+        return result;
     }
 
     for (simdjson::dom::element elem : downloads)
@@ -234,7 +236,8 @@ _netascore_downloads_complete(Arena* arena, async::ThreadPool* thread_pool, Stri
         err = elem.get_object().get(item);
         if (err)
         {
-            return async::UserFuncResult<NetaTaskState>::failure(arena, "Failed to parse NetAScore download item");
+            ERROR_LOG("Failed to parse NetAScore download item");
+            return result;
         }
 
         const char* key = 0;
@@ -243,121 +246,126 @@ _netascore_downloads_complete(Arena* arena, async::ThreadPool* thread_pool, Stri
         simdjson::error_code err_file_name = item["filename"].get_c_str().get(file_name);
         if (err_key || err_file_name)
         {
-            return async::UserFuncResult<NetaTaskState>::failure(arena, "NetAScore download item is missing key or filename");
+            ERROR_LOG("NetAScore download item is missing key or filename");
+            return result;
         }
 
-        String8 file_name_str = str8_c_string(file_name);
-        if (str8_ends_with_lit(file_name_str, "_edges.geojson", MatchFlag_CaseInsensitive))
+        if (str8_ends_with_lit(str8_c_string(file_name), "_edges.geojson", MatchFlag_CaseInsensitive))
         {
-            _netascore_download_enqueue(arena, task_state, str8_c_string(key), file_name_str);
-            break;
+            result.v = push_str8_copy(arena, str8_c_string(key));
+            result.err = false;
+            return result;
         }
     }
 
-    if (download_queue->first)
-    {
-        async::HttpInfo* next_http_info = _netascore_next_download_http_info(arena, task_state);
-        AssertAlways(next_http_info != 0);
-        return async::UserFuncResult<NetaTaskState>::success(next_http_info, _netascore_download_file_complete);
-    }
-    return async::UserFuncResult<NetaTaskState>::failure(arena, "NetAScore downloads response did not contain any *_edges.geojson files");
+    ERROR_LOG("NetAScore downloads response did not contain any *_edges.geojson files");
+    return result;
 }
 
-static async::UserFuncResult<NetaTaskState>
-_netascore_job_status_complete(Arena* arena, async::ThreadPool* thread_pool, String8 body, NetaTaskState* task_state)
+static async::CoTask<B32>
+_netascore_job_run(Arena* arena, NetaTaskState* task_state)
 {
-    (void)thread_pool;
-    NetascoreDownloadQueue* download_queue = &task_state->download_queue;
-    simdjson::dom::parser parser;
-    simdjson::dom::element doc = {};
-    simdjson::error_code err = parser.parse(body.str, body.size).get(doc);
-    if (err)
-    {
-        return async::UserFuncResult<NetaTaskState>::failure(arena, "Failed to parse NetAScore status response");
-    }
-
-    simdjson::dom::object obj = {};
-    err = doc.get_object().get(obj);
-    if (err)
-    {
-        return async::UserFuncResult<NetaTaskState>::failure(arena, "Expected NetAScore status response to be an object");
-    }
-
-    const char* status = 0;
-    const char* job_id = 0;
-    simdjson::error_code err_status = obj["status"].get_c_str().get(status);
-    simdjson::error_code err_job_id = obj["job_id"].get_c_str().get(job_id);
-    if (err_status || err_job_id)
+    const U32 http_retries = 5;
+    async::HttpResponse response = co_await async::co_http_request(arena, task_state->job_http_info, http_retries);
+    if (response.error.has_error())
     {
-        return async::UserFuncResult<NetaTaskState>::failure(arena, "NetAScore status response is missing status or job_id");
+        ERROR_LOG("NetAScore job creation request failed, http code %u", response.http_code);
+        co_return false;
     }
 
-    download_queue->job_id = push_str8_copy(arena, str8_c_string(job_id));
-    if (c_str_equal(status, "queued") || c_str_equal(status, "running"))
+    Result<NetascoreJobStatus> job = _netascore_job_status_parse(arena, response.body);
+    if (job.err)
     {
-        return async::UserFuncResult<NetaTaskState>::reschedule(1'000'000); // 1'000'000 ms = 1 sec delay
+        co_return false;
     }
-
-    if (c_str_equal(status, "done"))
+    if (!str8_match(job.v.status, S("queued"), 0) && !str8_match(job.v.status, S("running"), 0))
     {
-        String8 downloads_api = push_str8f(arena, "%.*s%.*s/downloads", str8_varg(mobilitylab_jobs_api_get()), str8_varg(download_queue->job_id));
-        async::HttpInfo* http_info = async::http_info_create_get(arena, downloads_api, {task_state->mobility_api_key_header});
-        return async::UserFuncResult<NetaTaskState>::success(http_info, _netascore_downloads_complete);
+        ERROR_LOG("Unexpected NetAScore job creation status: %.*s", str8_varg(job.v.status));
+        co_return false;
     }
 
-    if (c_str_equal(status, "failed"))
+    String8 status_api = push_str8f(arena, "%.*s%.*s", str8_varg(mobilitylab_jobs_api_get()), str8_varg(job.v.job_id));
+    async::HttpInfo* status_http_info = async::http_info_create_get(arena, status_api, {task_state->mobility_api_key_header});
+    for (;;)
     {
-        const char* error_msg = 0;
-        if (obj["error"].get_c_str().get(error_msg) == simdjson::SUCCESS && error_msg != 0)
+        // ~mgj: every poll gives its response back to the arena, the job can be queued for minutes
+        U64 poll_pos = arena_pos(arena);
+        response = co_await async::co_http_request(arena, status_http_info, http_retries);
+        if (response.error.has_error())
         {
-            return async::UserFuncResult<NetaTaskState>::failure(arena, "NetAScore job %s failed: %s", job_id, error_msg);
+            ERROR_LOG("NetAScore job status request failed, http code %u", response.http_code);
+            co_return false;
         }
-        return async::UserFuncResult<NetaTaskState>::failure(arena, "NetAScore job %s failed", job_id);
-    }
 
-    return async::UserFuncResult<NetaTaskState>::failure(arena, "Unexpected NetAScore job status: %s", status);
-}
+        Result<NetascoreJobStatus> job_status = _netascore_job_status_parse(arena, response.body);
+        if (job_status.err)
+        {
+            co_return false;
+        }
+        if (str8_match(job_status.v.status, S("done"), 0))
+        {
+            break;
+        }
+        if (str8_match(job_status.v.status, S("failed"), 0))
+        {
+            ERROR_LOG("NetAScore job %.*s failed: %.*s", str8_varg(job.v.job_id), str8_varg(job_status.v.error_msg));
+            co_return false;
+        }
+        if (!str8_match(job_status.v.status, S("queued"), 0) && !str8_match(job_status.v.status, S("running"), 0))
+        {
+            ERROR_LOG("Unexpected NetAScore job status: %.*s", str8_varg(job_status.v.status));
+            co_return false;
+        }
 
-static async::UserFuncResult<NetaTaskState>
-netascore_job_create_complete(Arena* arena, async::ThreadPool* thread_pool, String8 body, NetaTaskState* task_state)
-{
-    (void)thread_pool;
-    NetascoreDownloadQueue* download_queue = &task_state->download_queue;
-    simdjson::dom::parser parser;
-    simdjson::dom::element doc = {};
-    simdjson::error_code err = parser.parse(body.str, body.size).get(doc);
-    if (err)
-    {
-        return async::UserFuncResult<NetaTaskState>::failure(arena, "Failed to parse NetAScore job creation response");
+        arena_pop_to(arena, poll_pos);
+        co_await async::co_delay(1'000'000); // 1 sec
     }
 
-    simdjson::dom::object obj = {};
-    err = doc.get_object().get(obj);
-    if (err)
+    String8 downloads_api = push_str8f(arena, "%.*s%.*s/downloads", str8_varg(mobilitylab_jobs_api_get()), str8_varg(job.v.job_id));
+    async::HttpInfo* downloads_http_info = async::http_info_create_get(arena, downloads_api, {task_state->mobility_api_key_header});
+    response = co_await async::co_http_request(arena, downloads_http_info, http_retries);
+    if (response.error.has_error())
     {
-        return async::UserFuncResult<NetaTaskState>::failure(arena, "Expected NetAScore job creation response to be an object");
+        ERROR_LOG("NetAScore downloads request failed, http code %u", response.http_code);
+        co_return false;
     }
 
-    const char* status = 0;
-    const char* job_id = 0;
-    simdjson::error_code err_status = obj["status"].get_c_str().get(status);
-    simdjson::error_code err_job_id = obj["job_id"].get_c_str().get(job_id);
-    if (err_status || err_job_id)
+    Result<String8> download_key = _netascore_edges_download_key_parse(arena, response.body);
+    if (download_key.err)
     {
-        return async::UserFuncResult<NetaTaskState>::failure(arena, "NetAScore job creation response is missing status or job_id");
+        co_return false;
     }
 
-    if (!c_str_equal(status, "queued") && !c_str_equal(status, "running"))
+    String8 download_api = push_str8f(arena, "%.*s%.*s/download/%.*s", str8_varg(mobilitylab_jobs_api_get()), str8_varg(job.v.job_id), str8_varg(download_key.v));
+    async::HttpInfo* download_http_info = async::http_info_create_get(arena, download_api, {task_state->mobility_api_key_header});
+    // ~mgj: the edges file can be large, it goes from the download buffer straight to the cache file
+    response = co_await async::co_http_download(download_http_info, http_retries);
+    if (response.error.has_error())
     {
-        return async::UserFuncResult<NetaTaskState>::failure(arena, "Unexpected NetAScore job creation status: %s", status);
+        ERROR_LOG("NetAScore edges download failed, http code %u", response.http_code);
+        co_return false;
     }
 
-    *download_queue = {};
-    download_queue->job_id = push_str8_copy(arena, str8_c_string(job_id));
+    cache_write(task_state->cache_file_location, response.body, task_state->cache_bbox_str);
+    async::http_response_release(&response);
+    task_state->data_downloaded.store(true);
+    co_return true;
+}
 
-    String8 status_api = push_str8f(arena, "%.*s%.*s", str8_varg(mobilitylab_jobs_api_get()), str8_varg(download_queue->job_id));
-    async::HttpInfo* http_info = async::http_info_create_get(arena, status_api, {task_state->mobility_api_key_header});
-    return async::UserFuncResult<NetaTaskState>::success(http_info, _netascore_job_status_complete);
+static async::CoTask<B32>
+_netascore_task(Arena* arena, NetaTaskState* task_state)
+{
+    // ~mgj: a failed job is started over once, 10 seconds later
+    const U32 job_retries = 1;
+    for (U32 retry_count = 0;; ++retry_count)
+    {
+        B32 success = co_await _netascore_job_run(arena, task_state);
+        if (success || retry_count == job_retries)
+        {
+            co_return success;
+        }
+        co_await async::co_delay(10'000'000); // 10 sec
+    }
 }
 
 g_internal city::AsyncCityTask*
@@ -387,12 +395,10 @@ netascore_async_task_create(Arena* arena, NetaState* neta, Rng2F64 bbox)
         String8 target_srid_param = push_str8f(task_arena, "target_srid=%d", target_srid);
         async::HttpInfo* http_info = async::http_info_create(task_arena, HTTP_Method_Post, netascore_api, S("application/x-www-form-urlencoded"), {task_state->mobility_api_key_header},
                                                              {target_srid_param, task_state->cache_bbox_str, S("output_format=GeoJSON")});
-        async::AsyncHttpTaskStateConfig<NetaTaskState> config = async::AsyncHttpTaskStateConfig<NetaTaskState>(neta::netascore_job_create_complete, task_state, 5, 1);
-        async::AsyncHttpTaskCreateResult<NetaTaskState> result = async::async_http_task_run(task_arena, ctx->thread_pool, http_info, &config, "Neta Task");
-        AssertAlways(result.async_result.has_error() == false);
+        task_state->job_http_info = http_info;
 
         neta_task->type = city::AsyncTaskType::Neta;
-        neta_task->neta = result.task_state;
+        neta_task->neta = async::async_task_co_run(task_arena, ctx->thread_pool, _netascore_task, task_state, "Neta Task");
     }
     else
     {
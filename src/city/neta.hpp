@@ -29,24 +29,17 @@ struct EdgeList
     EdgeNode* last;
 };
 
-struct NetascoreDownloadNode
+struct NetascoreJobStatus
 {
-    NetascoreDownloadNode* next;
-    String8 key;
-    String8 file_name;
-};
-
-struct NetascoreDownloadQueue
-{
-    NetascoreDownloadNode* first;
-    NetascoreDownloadNode* last;
     String8 job_id;
+    String8 status;
+    String8 error_msg; // only set for failed jobs
 };
 
 struct NetaTaskState
 {
     String8 mobility_api_key_header;
-    NetascoreDownloadQueue download_queue;
+    async::HttpInfo* job_http_info;
     Rng2F64 bbox_wgs84;
     String8 cache_file_location;
     String8 cache_bbox_str;
@@ -66,9 +59,6 @@ struct NetaState
 g_internal void
 neta_init(NetaState* neta_state, String8 cache_path, String8 cache_type, Rng2F64 bbox, String8 bbox_cache_str);
 
-g_internal async::UserFuncResult<NetaTaskState>
-netascore_job_create_complete(Arena* arena, async::ThreadPool* thread_pool, String8 body, NetaTaskState* task_state);
-
 g_internal String8
 mobilitylab_jobs_api_get();
 
@@ -85,20 +75,18 @@ osm_way_to_edges_map_create(Arena* arena, osm::Network* network, String8 file_pa
 g_internal Result<Buffer<Edge>>
 _edge_in_osm_area(Arena* arena, osm::Network* network, simdjson::ondemand::document& doc, Rng2F64 bbox_wgs84);
 
-g_internal void
-_netascore_download_enqueue(Arena* arena, NetaTaskState* task_state, String8 key, String8 file_name);
-
-g_internal async::UserFuncResult<NetaTaskState>
-_netascore_download_file_complete(Arena* arena, async::ThreadPool* thread_pool, String8 body, NetaTaskState* task_state);
+// ~mgj: creates the NetAScore job, polls it until it is done and downloads its edges file into the cache
+g_internal async::CoTask<B32>
+_netascore_task(Arena* arena, NetaTaskState* task_state);
 
-g_internal async::HttpInfo*
-_netascore_next_download_http_info(Arena* arena, NetaTaskState* task_state);
+g_internal async::CoTask<B32>
+_netascore_job_run(Arena* arena, NetaTaskState* task_state);
 
-g_internal async::UserFuncResult<NetaTaskState>
-_netascore_downloads_complete(Arena* arena, async::ThreadPool* thread_pool, String8 body, NetaTaskState* task_state);
+g_internal Result<NetascoreJobStatus>
+_netascore_job_status_parse(Arena* arena, String8 body);
 
-g_internal async::UserFuncResult<NetaTaskState>
-_netascore_job_status_complete(Arena* arena, async::ThreadPool* thread_pool, String8 body, NetaTaskState* task_state);
+g_internal Result<String8>
+_netascore_edges_download_key_parse(Arena* arena, String8 body);
 
 } // namespace neta
 //////////////////////////////////////////////////////////////////////////////////////
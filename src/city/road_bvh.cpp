@@ -0,0 +1,723 @@
+namespace city
+{
+
+g_internal Rng2F32
+bounds_union(Rng2F32 a, Rng2F32 b)
+{
+    Rng2F32 result;
+    result.min.v[0] = Min(a.min.v[0], b.min.v[0]);
+    result.min.v[1] = Min(a.min.v[1], b.min.v[1]);
+
+    result.max.v[0] = Max(a.max.v[0], b.max.v[0]);
+    result.max.v[1] = Max(a.max.v[1], b.max.v[1]);
+    return result;
+}
+
+g_internal Rng2F32
+bounds_union(Rng2F32 rng, Vec2F32 vec)
+{
+    Rng2F32 result;
+    result.min.v[0] = Min(rng.min.v[0], vec.v[0]);
+    result.min.v[1] = Min(rng.min.v[1], vec.v[1]);
+
+    result.max.v[0] = Max(rng.max.v[0], vec.v[0]);
+    result.max.v[1] = Max(rng.max.v[1], vec.v[1]);
+    return result;
+}
+
+// ~mgj: build state /////////////////////////////
+// The top of the tree is split serially until ranges are small enough to hand out as tasks. Every
+// task builds its subtree in depth first order into staging_nodes, after which the subtrees are
+// copied into the final buffer behind their top level parents with their child indices rebased.
+const U32 _BVH_CHILD_TASK_BIT = 1u << 31;
+
+struct _BvhBuildTask
+{
+    U32 start_idx;
+    U32 end_idx;
+    U32 depth;
+    U32 node_count; // of the subtree, set by _bvh_subtree_build_task
+    U32 final_idx;  // of the subtree root in the final node buffer
+};
+
+struct _BvhTopNode
+{
+    Rng2F32 bounds;
+    U32 split_axis;
+    F32 split_value;
+    U32 children[2]; // top node index, or task index | _BVH_CHILD_TASK_BIT
+    U32 node_count;  // of the whole subtree
+    U32 final_idx;
+};
+
+struct _BvhPending
+{
+    Rng2F32 bounds;
+    Rng2F32 centroid_bounds;
+    U32 start_idx;
+    U32 end_idx;
+    U32 depth;
+    U32 parent_idx; // max_U32 when the parent needs no patching
+    U32 child_slot;
+};
+
+struct _BvhSplit
+{
+    U32 axis;
+    F32 value;
+    U32 mid_idx;
+    Rng2F32 bounds[2]; // of the children
+    Rng2F32 centroid_bounds[2];
+};
+
+struct _BvhRootBounds
+{
+    Rng2F32 bounds;
+    Rng2F32 centroid_bounds;
+};
+
+struct _BvhBuild
+{
+    Buffer<RoadSegmentCorners> road_segment_buffer;
+    Buffer<BoundingBox> bb_buffer;
+
+    // ~mgj: the subtree over [start, end) has at most 2 * (end - start) - 1 nodes, so each task builds
+    // at 2 * start and the tasks never overlap
+    RoadSegmentNodeStorageBuffer* staging_nodes;
+    _BvhBuildTask* tasks;
+    U32 leaf_bb_max;
+
+    Buffer<RoadSegmentNodeStorageBuffer> node_buffer;
+    Buffer<RoadSegmentCorners> road_segment_buffer_sorted;
+};
+
+// ~mgj: Bounds in SSE registers hold (min.x, min.y, -max.x, -max.y), so growing one is a single min
+g_internal __m128
+_bvh_bounds_load(Rng2F32 bounds)
+{
+    return _mm_xor_ps(_mm_loadu_ps(bounds.v[0].v), _mm_set_ps(-0.0f, -0.0f, 0.0f, 0.0f));
+}
+
+g_internal __m128
+_bvh_point_load(Vec2F32 point)
+{
+    return _mm_xor_ps(_mm_set_ps(point.y, point.x, point.y, point.x), _mm_set_ps(-0.0f, -0.0f, 0.0f, 0.0f));
+}
+
+g_internal Rng2F32
+_bvh_bounds_store(__m128 bounds)
+{
+    Rng2F32 result;
+    _mm_storeu_ps(result.v[0].v, _mm_xor_ps(bounds, _mm_set_ps(-0.0f, -0.0f, 0.0f, 0.0f)));
+    return result;
+}
+
+g_internal Rng2F32
+_bvh_range_bounds(Buffer<BoundingBox> bb_buffer, U32 start_idx, U32 end_idx, Rng2F32* out_centroid_bounds)
+{
+    __m128 bounds = _bvh_bounds_load(rng2f32_inverted_inf());
+    __m128 centroid_bounds = bounds;
+    for (U32 i = start_idx; i < end_idx; ++i)
+    {
+        bounds = _mm_min_ps(bounds, _bvh_bounds_load(bb_buffer.data[i].bounds));
+        centroid_bounds = _mm_min_ps(centroid_bounds, _bvh_point_load(bb_buffer.data[i].center));
+    }
+    *out_centroid_bounds = _bvh_bounds_store(centroid_bounds);
+    return _bvh_bounds_store(bounds);
+}
+
+// ~mgj: bounding box and center per segment, folded into the bounds of the root as they are written
+g_internal _BvhRootBounds
+_bvh_bounding_box_task(async::ThreadInfo thread_info, Arena* scratch_arena, void* data, U64 start_idx, U64 end_idx, _BvhRootBounds acc)
+{
+    (void)thread_info;
+    (void)scratch_arena;
+    _BvhBuild* build = (_BvhBuild*)data;
+    for (U64 i = start_idx; i < end_idx; ++i)
+    {
+        RoadSegmentCorners* seg = build->road_segment_buffer[i];
+        Rng2F32 bounds = rng2f32_inverted_inf();
+        Vec2F32 center = {};
+        for (U32 j = 0; j < RoadSegmentCornerCoord_Count; ++j)
+        {
+            bounds = bounds_union(bounds, seg->corners[j]);
+            center = add_2f32(center, seg->corners[j]);
+        }
+        build->bb_buffer.data[i] = {.center = scale_2f32(center, 1.0f / (F32)RoadSegmentCornerCoord_Count), .bounds = bounds, .idx = (U32)i};
+    }
+    Rng2F32 centroid_bounds;
+    Rng2F32 bounds = _bvh_range_bounds(build->bb_buffer, (U32)start_idx, (U32)end_idx, &centroid_bounds);
+    return {.bounds = bounds_union(acc.bounds, bounds), .centroid_bounds = bounds_union(acc.centroid_bounds, centroid_bounds)};
+}
+
+g_internal _BvhRootBounds
+_bvh_root_bounds_combine(_BvhRootBounds a, _BvhRootBounds b)
+{
+    return {.bounds = bounds_union(a.bounds, b.bounds), .centroid_bounds = bounds_union(a.centroid_bounds, b.centroid_bounds)};
+}
+
+// ~mgj: half perimeter is the 2D stand-in for surface area
+g_internal F32
+_bvh_half_perimeter(Rng2F32 bounds)
+{
+    return (bounds.max.x - bounds.min.x) + (bounds.max.y - bounds.min.y);
+}
+
+g_internal U32
+_bvh_bin_idx(F32 center, F32 centroid_min, F32 bin_scale)
+{
+    U32 bin_idx = (U32)((center - centroid_min) * bin_scale);
+    return Min(bin_idx, BVH_SAH_BIN_COUNT - 1);
+}
+
+// ~mgj: Splits [start_idx, end_idx) in place. Candidate splits are the bin boundaries on both axes,
+// costed as half perimeter times segment count of each side. When every centroid is in one spot or
+// the node is deeper than BVH_SAH_MAX_DEPTH the range is split at its median on the wider axis.
+// The children's bounds come out of the bins, so each level reads the segments twice (bin, partition).
+g_internal _BvhSplit
+_bvh_split(Buffer<BoundingBox> bb_buffer, U32 start_idx, U32 end_idx, Rng2F32 centroid_bounds, U32 depth)
+{
+    struct Bin
+    {
+        __m128 bounds;
+        __m128 centroid_bounds;
+        U32 count;
+    };
+
+    U32 count = end_idx - start_idx;
+    Vec2F32 extent = sub_2f32(centroid_bounds.max, centroid_bounds.min);
+    F32 bin_scales[Axis2_COUNT];
+    Bin bins[Axis2_COUNT][BVH_SAH_BIN_COUNT];
+    for (U32 axis = 0; axis < Axis2_COUNT; ++axis)
+    {
+        bin_scales[axis] = extent.v[axis] > 0.0f ? (F32)BVH_SAH_BIN_COUNT / extent.v[axis] : 0.0f;
+        for (Bin& bin : bins[axis])
+        {
+            bin = {.bounds = _bvh_bounds_load(rng2f32_inverted_inf()), .centroid_bounds = _bvh_bounds_load(rng2f32_inverted_inf()), .count = 0};
+        }
+    }
+
+    _BvhSplit split = {};
+    F32 best_cost = max_f32;
+    U32 best_bin = 0;
+    if (depth < BVH_SAH_MAX_DEPTH && (bin_scales[Axis2_X] > 0.0f || bin_scales[Axis2_Y] > 0.0f))
+    {
+        for (U32 i = start_idx; i < end_idx; ++i)
+        {
+            BoundingBox* bb = &bb_buffer.data[i];
+            __m128 bounds = _bvh_bounds_load(bb->bounds);
+            __m128 center = _bvh_point_load(bb->center);
+            for (U32 axis = 0; axis < Axis2_COUNT; ++axis)
+            {
+                Bin* bin = &bins[axis][_bvh_bin_idx(bb->center.v[axis], centroid_bounds.min.v[axis], bin_scales[axis])];
+                bin->count += 1;
+                bin->bounds = _mm_min_ps(bin->bounds, bounds);
+                bin->centroid_bounds = _mm_min_ps(bin->centroid_bounds, center);
+            }
+        }
+
+        for (U32 axis = 0; axis < Axis2_COUNT; ++axis)
+        {
+            if (bin_scales[axis] == 0.0f)
+            {
+                continue;
+            }
+            // ~mgj: sweep from the right first so each boundary's right side cost is ready for the left sweep
+            F32 right_costs[BVH_SAH_BIN_COUNT];
+            __m128 right_bounds = _bvh_bounds_load(rng2f32_inverted_inf());
+            U32 right_count = 0;
+            for (U32 bin_idx = BVH_SAH_BIN_COUNT - 1; bin_idx > 0; --bin_idx)
+            {
+                right_bounds = _mm_min_ps(right_bounds, bins[axis][bin_idx].bounds);
+                right_count += bins[axis][bin_idx].count;
+                right_costs[bin_idx] = right_count ? _bvh_half_perimeter(_bvh_bounds_store(right_bounds)) * (F32)right_count : 0.0f;
+            }
+            __m128 left_bounds = _bvh_bounds_load(rng2f32_inverted_inf());
+            U32 left_count = 0;
+            for (U32 bin_idx = 0; bin_idx < BVH_SAH_BIN_COUNT - 1; ++bin_idx)
+            {
+                left_bounds = _mm_min_ps(left_bounds, bins[axis][bin_idx].bounds);
+                left_count += bins[axis][bin_idx].count;
+                if (left_count == 0 || left_count == count)
+                {
+                    continue;
+                }
+                F32 cost = _bvh_half_perimeter(_bvh_bounds_store(left_bounds)) * (F32)left_count + right_costs[bin_idx + 1];
+                if (cost < best_cost)
+                {
+                    best_cost = cost;
+                    best_bin = bin_idx;
+                    split.axis = axis;
+                }
+            }
+        }
+    }
+
+    if (best_cost < max_f32)
+    {
+        U32 axis = split.axis;
+        F32 centroid_min = centroid_bounds.min.v[axis];
+        F32 bin_scale = bin_scales[axis];
+        U32 lo = start_idx;
+        U32 hi = end_idx;
+        while (lo < hi)
+        {
+            if (_bvh_bin_idx(bb_buffer.data[lo].center.v[axis], centroid_min, bin_scale) <= best_bin)
+            {
+                lo += 1;
+            }
+            else
+            {
+                hi -= 1;
+                Swap(BoundingBox, bb_buffer.data[lo], bb_buffer.data[hi]);
+            }
+        }
+        split.mid_idx = lo;
+        split.value = centroid_min + (F32)(best_bin + 1) / bin_scale;
+        __m128 side_bounds[2] = {_bvh_bounds_load(rng2f32_inverted_inf()), _bvh_bounds_load(rng2f32_inverted_inf())};
+        __m128 side_centroid_bounds[2] = {side_bounds[0], side_bounds[0]};
+        for (U32 bin_idx = 0; bin_idx < BVH_SAH_BIN_COUNT; ++bin_idx)
+        {
+            U32 side = bin_idx > best_bin;
+            side_bounds[side] = _mm_min_ps(side_bounds[side], bins[axis][bin_idx].bounds);
+            side_centroid_bounds[side] = _mm_min_ps(side_centroid_bounds[side], bins[axis][bin_idx].centroid_bounds);
+        }
+        for (U32 side = 0; side < 2; ++side)
+        {
+            split.bounds[side] = _bvh_bounds_store(side_bounds[side]);
+            split.centroid_bounds[side] = _bvh_bounds_store(side_centroid_bounds[side]);
+        }
+    }
+    else
+    {
+        U32 axis = extent.x > extent.y ? Axis2_X : Axis2_Y;
+        split.axis = axis;
+        split.mid_idx = start_idx + count / 2;
+        std::nth_element(bb_buffer.data + start_idx, bb_buffer.data + split.mid_idx, bb_buffer.data + end_idx,
+                         [axis](const BoundingBox& a, const BoundingBox& b) { return a.center.v[axis] < b.center.v[axis]; });
+        split.value = bb_buffer.data[split.mid_idx].center.v[axis];
+        split.bounds[0] = _bvh_range_bounds(bb_buffer, start_idx, split.mid_idx, &split.centroid_bounds[0]);
+        split.bounds[1] = _bvh_range_bounds(bb_buffer, split.mid_idx, end_idx, &split.centroid_bounds[1]);
+    }
+    Assert(split.mid_idx > start_idx && split.mid_idx < end_idx);
+    return split;
+}
+
+g_internal void
+_bvh_node_bounds_set(RoadSegmentNodeStorageBuffer* node, Rng2F32 bounds)
+{
+    node->min_x = bounds.min.x;
+    node->min_y = bounds.min.y;
+    node->max_x = bounds.max.x;
+    node->max_y = bounds.max.y;
+}
+
+g_internal void
+_bvh_subtree_build_task(async::ThreadInfo thread_info, void* data, U32 task_idx)
+{
+    prof_scope_marker;
+    (void)thread_info;
+    ScratchScope scratch = ScratchScope(0, 0);
+    _BvhBuild* build = (_BvhBuild*)data;
+    _BvhBuildTask* task = &build->tasks[task_idx];
+    RoadSegmentNodeStorageBuffer* nodes = build->staging_nodes + 2 * (U64)task->start_idx;
+
+    // ~mgj: pushing the right child before the left emits nodes depth first, so child_0 is always
+    // node_idx + 1 and child_1 is patched when the right child is popped. The stack holds at most
+    // depth + 1 entries.
+    _BvhPending* stack = PushArrayNoZero(scratch.arena, _BvhPending, task->end_idx - task->start_idx + 1);
+    U32 stack_count = 0;
+    Rng2F32 centroid_bounds;
+    Rng2F32 bounds = _bvh_range_bounds(build->bb_buffer, task->start_idx, task->end_idx, &centroid_bounds);
+    stack[stack_count++] = {
+        .bounds = bounds, .centroid_bounds = centroid_bounds, .start_idx = task->start_idx, .end_idx = task->end_idx, .depth = task->depth, .parent_idx = max_U32};
+    U32 node_count = 0;
+    while (stack_count > 0)
+    {
+        _BvhPending pending = stack[--stack_count];
+        U32 node_idx = node_count++;
+        if (pending.parent_idx != max_U32)
+        {
+            nodes[pending.parent_idx].child_1_idx = node_idx;
+        }
+
+        RoadSegmentNodeStorageBuffer* node = &nodes[node_idx];
+        *node = {};
+        _bvh_node_bounds_set(node, pending.bounds);
+        if (pending.end_idx - pending.start_idx <= build->leaf_bb_max)
+        {
+            node->is_leaf = true;
+            node->start_idx = pending.start_idx;
+            node->end_idx = pending.end_idx;
+            continue;
+        }
+
+        _BvhSplit split = _bvh_split(build->bb_buffer, pending.start_idx, pending.end_idx, pending.centroid_bounds, pending.depth);
+        node->split_axis = split.axis;
+        node->split_value = split.value;
+        node->child_0_idx = node_idx + 1;
+        stack[stack_count++] = {.bounds = split.bounds[1],
+                                .centroid_bounds = split.centroid_bounds[1],
+                                .start_idx = split.mid_idx,
+                                .end_idx = pending.end_idx,
+                                .depth = pending.depth + 1,
+                                .parent_idx = node_idx};
+        stack[stack_count++] = {.bounds = split.bounds[0],
+                                .centroid_bounds = split.centroid_bounds[0],
+                                .start_idx = pending.start_idx,
+                                .end_idx = split.mid_idx,
+                                .depth = pending.depth + 1,
+                                .parent_idx = max_U32};
+    }
+    task->node_count = node_count;
+
+    for (U32 i = task->start_idx; i < task->end_idx; ++i)
+    {
+        build->road_segment_buffer_sorted.data[i] = build->road_segment_buffer.data[build->bb_buffer.data[i].idx];
+    }
+}
+
+g_internal void
+_bvh_subtree_emit_task(async::ThreadInfo thread_info, void* data, U32 task_idx)
+{
+    (void)thread_info;
+    _BvhBuild* build = (_BvhBuild*)data;
+    _BvhBuildTask* task = &build->tasks[task_idx];
+    RoadSegmentNodeStorageBuffer* src = build->staging_nodes + 2 * (U64)task->start_idx;
+    RoadSegmentNodeStorageBuffer* dst = build->node_buffer.data + task->final_idx;
+    for (U32 i = 0; i < task->node_count; ++i)
+    {
+        dst[i] = src[i];
+        if (!dst[i].is_leaf)
+        {
+            dst[i].child_0_idx += task->final_idx;
+            dst[i].child_1_idx += task->final_idx;
+        }
+    }
+}
+
+// ~mgj: Binned SAH BVH over the road segments. Nodes are emitted in depth first order (child_0 of
+// node i is i + 1) and leaves hold at most leaf_bb_max segments, indexing road_segment_buffer_sorted.
+g_internal BvhResult
+bvh_create(async::ThreadPool* thread_pool, Arena* arena, Buffer<RoadSegmentCorners> road_segment_buffer, U32 leaf_bb_max)
+{
+    prof_scope_marker;
+    ScratchScope scratch = ScratchScope(&arena, 1);
+    AssertAlways(road_segment_buffer.size < _BVH_CHILD_TASK_BIT);
+    U32 segment_count = (U32)road_segment_buffer.size;
+    U32 thread_count = thread_pool->thread_count + 1;
+
+    _BvhBuild build = {};
+    build.road_segment_buffer = road_segment_buffer;
+    build.bb_buffer = buffer_alloc<BoundingBox>(scratch.arena, segment_count);
+    build.staging_nodes = PushArrayNoZero(scratch.arena, RoadSegmentNodeStorageBuffer, 2 * (U64)segment_count + 1);
+    build.leaf_bb_max = Max(leaf_bb_max, 1u);
+    build.road_segment_buffer_sorted = buffer_alloc<RoadSegmentCorners>(arena, segment_count);
+
+    // 1. bounding box and center point per segment, the center decides which side of a split it goes
+    _BvhRootBounds root_identity = {.bounds = rng2f32_inverted_inf(), .centroid_bounds = rng2f32_inverted_inf()};
+    _BvhRootBounds root_bounds =
+        async::parallel_reduce(thread_pool, segment_count, BVH_TASK_PRIM_MIN, root_identity, _bvh_bounding_box_task, _bvh_root_bounds_combine, &build);
+
+    // 2. split the top of the tree until the ranges are small enough to be built as tasks
+    U32 task_prim_max = Max(BVH_TASK_PRIM_MIN, segment_count / (thread_count * 4));
+    _BvhTopNode* top_nodes = PushArrayNoZero(scratch.arena, _BvhTopNode, segment_count + 1);
+    build.tasks = PushArrayNoZero(scratch.arena, _BvhBuildTask, segment_count + 1);
+    _BvhPending* stack = PushArrayNoZero(scratch.arena, _BvhPending, segment_count + 1);
+    U32 top_count = 0;
+    U32 task_count = 0;
+    U32 stack_count = 0;
+    stack[stack_count++] = {.bounds = root_bounds.bounds, .centroid_bounds = root_bounds.centroid_bounds, .start_idx = 0, .end_idx = segment_count, .depth = 0, .parent_idx = max_U32};
+    while (stack_count > 0)
+    {
+        _BvhPending pending = stack[--stack_count];
+        U32 child_ref;
+        if (pending.end_idx - pending.start_idx <= task_prim_max)
+        {
+            child_ref = task_count | _BVH_CHILD_TASK_BIT;
+            build.tasks[task_count++] = {.start_idx = pending.start_idx, .end_idx = pending.end_idx, .depth = pending.depth};
+        }
+        else
+        {
+            child_ref = top_count;
+            _BvhTopNode* top_node = &top_nodes[top_count++];
+            top_node->bounds = pending.bounds;
+            _BvhSplit split = _bvh_split(build.bb_buffer, pending.start_idx, pending.end_idx, pending.centroid_bounds, pending.depth);
+            top_node->split_axis = split.axis;
+            top_node->split_value = split.value;
+            for (U32 child_slot = 2; child_slot-- > 0;)
+            {
+                stack[stack_count++] = {.bounds = split.bounds[child_slot],
+                                        .centroid_bounds = split.centroid_bounds[child_slot],
+                                        .start_idx = child_slot ? split.mid_idx : pending.start_idx,
+                                        .end_idx = child_slot ? pending.end_idx : split.mid_idx,
+                                        .depth = pending.depth + 1,
+                                        .parent_idx = child_ref,
+                                        .child_slot = child_slot};
+            }
+        }
+        if (pending.parent_idx != max_U32)
+        {
+            top_nodes[pending.parent_idx].children[pending.child_slot] = child_ref;
+        }
+    }
+
+    // 3. build the subtrees
+    async::thread_pool_fork_join(thread_pool, task_count, _bvh_subtree_build_task, &build);
+
+    // 4. top nodes were created depth first, so walking them backwards sizes children before parents
+    // and walking them forwards places each child right after its left sibling's subtree
+    for (U32 top_idx = top_count; top_idx-- > 0;)
+    {
+        _BvhTopNode* top_node = &top_nodes[top_idx];
+        top_node->node_count = 1;
+        for (U32 child_ref : top_node->children)
+        {
+            top_node->node_count += (child_ref & _BVH_CHILD_TASK_BIT) ? build.tasks[child_ref & ~_BVH_CHILD_TASK_BIT].node_count : top_nodes[child_ref].node_count;
+        }
+    }
+    U32 node_count = top_count > 0 ? top_nodes[0].node_count : build.tasks[0].node_count;
+    build.node_buffer = buffer_alloc<RoadSegmentNodeStorageBuffer>(arena, node_count);
+    if (top_count > 0)
+    {
+        top_nodes[0].final_idx = 0;
+    }
+    else
+    {
+        build.tasks[0].final_idx = 0;
+    }
+    for (U32 top_idx = 0; top_idx < top_count; ++top_idx)
+    {
+        _BvhTopNode* top_node = &top_nodes[top_idx];
+        RoadSegmentNodeStorageBuffer* node = build.node_buffer[top_node->final_idx];
+        _bvh_node_bounds_set(node, top_node->bounds);
+        node->split_axis = top_node->split_axis;
+        node->split_value = top_node->split_value;
+        node->is_leaf = false;
+
+        U32 child_final_idx = top_node->final_idx + 1;
+        for (U32 child_idx = 0; child_idx < ArrayCount(top_node->children); ++child_idx)
+        {
+            U32 child_ref = top_node->children[child_idx];
+            U32 child_node_count;
+            if (child_ref & _BVH_CHILD_TASK_BIT)
+            {
+                _BvhBuildTask* task = &build.tasks[child_ref & ~_BVH_CHILD_TASK_BIT];
+                task->final_idx = child_final_idx;
+                child_node_count = task->node_count;
+            }
+            else
+            {
+                top_nodes[child_ref].final_idx = child_final_idx;
+                child_node_count = top_nodes[child_ref].node_count;
+            }
+            if (child_idx == 0)
+            {
+                node->child_0_idx = child_final_idx;
+            }
+            else
+            {
+                node->child_1_idx = child_final_idx;
+            }
+            child_final_idx += child_node_count;
+        }
+    }
+    async::thread_pool_fork_join(thread_pool, task_count, _bvh_subtree_emit_task, &build);
+
+    BvhResult result = {build.road_segment_buffer_sorted, build.node_buffer};
+    return result;
+}
+
+// ~mgj: same test as is_face_inside_road_segment in road_intersection.comp
+g_internal B32
+_bvh_point_in_segment(RoadSegmentCorners* segment, Vec2F32 pos)
+{
+    B32 all_positive = true;
+    B32 all_negative = true;
+    for (U32 i = 0; i < RoadSegmentCornerCoord_Count; ++i)
+    {
+        Vec2F32 edge = sub_2f32(segment->corners[(i + 1) % RoadSegmentCornerCoord_Count], segment->corners[i]);
+        Vec2F32 to_point = sub_2f32(pos, segment->corners[i]);
+        F32 cross_z = edge.x * to_point.y - edge.y * to_point.x;
+        all_positive = all_positive && cross_z > 0.0f;
+        all_negative = all_negative && cross_z < 0.0f;
+        if (!all_positive && !all_negative)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// ~mgj: CPU mirror of the traversal in road_intersection.comp, keep the two in sync. Used to measure
+// build quality and to validate the tree without a GPU.
+g_internal BvhQueryResult
+bvh_point_query(BvhResult* bvh, Vec2F32 pos)
+{
+    BvhQueryResult result = {.segment_idx = max_U32, .nodes_visited = 0};
+    U32 stack[BVH_STACK_SIZE];
+    U32 stack_count = 0;
+    stack[stack_count++] = 0;
+    while (stack_count > 0)
+    {
+        RoadSegmentNodeStorageBuffer* node = bvh->node_buffer[stack[--stack_count]];
+        result.nodes_visited += 1;
+        if (!(pos.x >= node->min_x && pos.x <= node->max_x && pos.y >= node->min_y && pos.y <= node->max_y))
+        {
+            continue;
+        }
+
+        if (node->is_leaf)
+        {
+            for (U32 i = node->start_idx; i < node->end_idx; ++i)
+            {
+                if (_bvh_point_in_segment(bvh->road_segment_buffer_sorted[i], pos))
+                {
+                    result.segment_idx = i;
+                    return result;
+                }
+            }
+        }
+        else
+        {
+            AssertAlways(stack_count + 2 <= BVH_STACK_SIZE);
+            B32 is_near_first = pos.v[node->split_axis] < node->split_value;
+            stack[stack_count++] = is_near_first ? node->child_1_idx : node->child_0_idx;
+            stack[stack_count++] = is_near_first ? node->child_0_idx : node->child_1_idx;
+        }
+    }
+    return result;
+}
+
+// ~mgj: Packet traversal /////////////////////////////
+// Four points share one walk down the tree. Every stack entry carries the lanes it is for, and when
+// the lanes disagree on which child is near both orders are pushed with their own lanes, so each lane
+// still sees the leaves in the order bvh_point_query would and picks the same segment where roads
+// overlap. A lane drops out of the walk as soon as it has a segment.
+struct _BvhPacketEntry
+{
+    U32 node_idx;
+    U32 lane_mask;
+};
+
+struct _BvhClassifyTask
+{
+    BvhResult* bvh;
+    Buffer<Vec2F32> points;
+    Buffer<U32> out_segment_idx;
+};
+
+g_internal U32
+_bvh_packet_in_segment(RoadSegmentCorners* segment, __m128 pos_x, __m128 pos_y)
+{
+    __m128 zero = _mm_setzero_ps();
+    __m128 all_positive = _mm_castsi128_ps(_mm_set1_epi32(-1));
+    __m128 all_negative = all_positive;
+    for (U32 i = 0; i < RoadSegmentCornerCoord_Count; ++i)
+    {
+        Vec2F32 corner = segment->corners[i];
+        Vec2F32 edge = sub_2f32(segment->corners[(i + 1) % RoadSegmentCornerCoord_Count], corner);
+        __m128 to_point_x = _mm_sub_ps(pos_x, _mm_set1_ps(corner.x));
+        __m128 to_point_y = _mm_sub_ps(pos_y, _mm_set1_ps(corner.y));
+        __m128 cross_z = _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(edge.x), to_point_y), _mm_mul_ps(_mm_set1_ps(edge.y), to_point_x));
+        all_positive = _mm_and_ps(all_positive, _mm_cmpgt_ps(cross_z, zero));
+        all_negative = _mm_and_ps(all_negative, _mm_cmplt_ps(cross_z, zero));
+    }
+    return (U32)_mm_movemask_ps(_mm_or_ps(all_positive, all_negative));
+}
+
+g_internal void
+_bvh_packet_classify(BvhResult* bvh, Vec2F32* points, U32 point_count, U32* out_segment_idx)
+{
+    F32 xs[BVH_PACKET_WIDTH] = {};
+    F32 ys[BVH_PACKET_WIDTH] = {};
+    for (U32 lane = 0; lane < point_count; ++lane)
+    {
+        xs[lane] = points[lane].x;
+        ys[lane] = points[lane].y;
+        out_segment_idx[lane] = max_U32;
+    }
+    __m128 pos_x = _mm_loadu_ps(xs);
+    __m128 pos_y = _mm_loadu_ps(ys);
+
+    U32 active_mask = (1u << point_count) - 1;
+    _BvhPacketEntry stack[BVH_PACKET_STACK_SIZE];
+    U32 stack_count = 0;
+    stack[stack_count++] = {.node_idx = 0, .lane_mask = active_mask};
+    while (stack_count > 0 && active_mask)
+    {
+        _BvhPacketEntry entry = stack[--stack_count];
+        RoadSegmentNodeStorageBuffer* node = bvh->node_buffer[entry.node_idx];
+        __m128 in_x = _mm_and_ps(_mm_cmpge_ps(pos_x, _mm_set1_ps(node->min_x)), _mm_cmple_ps(pos_x, _mm_set1_ps(node->max_x)));
+        __m128 in_y = _mm_and_ps(_mm_cmpge_ps(pos_y, _mm_set1_ps(node->min_y)), _mm_cmple_ps(pos_y, _mm_set1_ps(node->max_y)));
+        U32 lane_mask = entry.lane_mask & active_mask & (U32)_mm_movemask_ps(_mm_and_ps(in_x, in_y));
+        if (!lane_mask)
+        {
+            continue;
+        }
+
+        if (node->is_leaf)
+        {
+            for (U32 i = node->start_idx; i < node->end_idx && lane_mask; ++i)
+            {
+                U32 hit_mask = _bvh_packet_in_segment(bvh->road_segment_buffer_sorted[i], pos_x, pos_y) & lane_mask;
+                for (U32 hits = hit_mask; hits; hits &= hits - 1)
+                {
+                    out_segment_idx[ctz32(hits)] = i;
+                }
+                lane_mask &= ~hit_mask;
+                active_mask &= ~hit_mask;
+            }
+        }
+        else
+        {
+            AssertAlways(stack_count + 4 <= BVH_PACKET_STACK_SIZE);
+            __m128 pos_axis = node->split_axis == Axis2_X ? pos_x : pos_y;
+            U32 near_first_mask = lane_mask & (U32)_mm_movemask_ps(_mm_cmplt_ps(pos_axis, _mm_set1_ps(node->split_value)));
+            U32 far_first_mask = lane_mask & ~near_first_mask;
+            if (far_first_mask)
+            {
+                stack[stack_count++] = {.node_idx = node->child_0_idx, .lane_mask = far_first_mask};
+                stack[stack_count++] = {.node_idx = node->child_1_idx, .lane_mask = far_first_mask};
+            }
+            if (near_first_mask)
+            {
+                stack[stack_count++] = {.node_idx = node->child_1_idx, .lane_mask = near_first_mask};
+                stack[stack_count++] = {.node_idx = node->child_0_idx, .lane_mask = near_first_mask};
+            }
+        }
+    }
+}
+
+g_internal void
+_bvh_classify_task(async::ThreadInfo thread_info, void* data, U32 task_idx)
+{
+    (void)thread_info;
+    _BvhClassifyTask* task = (_BvhClassifyTask*)data;
+    U64 start_idx = (U64)task_idx * BVH_CLASSIFY_TASK_POINTS;
+    U64 end_idx = Min(start_idx + BVH_CLASSIFY_TASK_POINTS, task->points.size);
+    bvh_points_classify(task->bvh, {.data = &task->points.data[start_idx], .size = end_idx - start_idx},
+                        {.data = &task->out_segment_idx.data[start_idx], .size = end_idx - start_idx});
+}
+
+g_internal void
+bvh_points_classify(BvhResult* bvh, Buffer<Vec2F32> points, Buffer<U32> out_segment_idx)
+{
+    AssertAlways(out_segment_idx.size >= points.size);
+    for (U64 i = 0; i < points.size; i += BVH_PACKET_WIDTH)
+    {
+        U32 point_count = (U32)Min((U64)BVH_PACKET_WIDTH, points.size - i);
+        _bvh_packet_classify(bvh, &points.data[i], point_count, &out_segment_idx.data[i]);
+    }
+}
+
+g_internal void
+bvh_points_classify_parallel(async::ThreadPool* thread_pool, BvhResult* bvh, Buffer<Vec2F32> points, Buffer<U32> out_segment_idx)
+{
+    AssertAlways(out_segment_idx.size >= points.size);
+    _BvhClassifyTask task = {.bvh = bvh, .points = points, .out_segment_idx = out_segment_idx};
+    U32 task_count = (U32)((points.size + BVH_CLASSIFY_TASK_POINTS - 1) / BVH_CLASSIFY_TASK_POINTS);
+    async::thread_pool_fork_join(thread_pool, task_count, _bvh_classify_task, &task);
+}
+
+} // namespace city
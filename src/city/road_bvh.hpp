@@ -0,0 +1,127 @@
+#pragma once
+
+#include <algorithm>
+
+namespace city
+{
+
+enum RoadSegmentCornerCoord
+{
+    RoadSegmentCornerCoord_TopLeft,
+    RoadSegmentCornerCoord_TopRight,
+    RoadSegmentCornerCoord_BottomRight,
+    RoadSegmentCornerCoord_BottomLeft,
+    RoadSegmentCornerCoord_Count
+};
+
+#define ROAD_OVERLAY_OPTIONS            \
+    X(None, "None")                     \
+    X(Bikeability_ft, "Bikeability_ft") \
+    X(Bikeability_tf, "Bikeability_tf") \
+    X(Walkability_tf, "Walkability_tf") \
+    X(Walkability_ft, "Walkability_ft")
+
+enum RoadOverlayOption : U32
+{
+#define X(name, str) RoadOverlayOption_##name,
+    ROAD_OVERLAY_OPTIONS
+#undef X
+        RoadOverlayOption_Count
+};
+
+struct RoadInfo
+{
+    F32 options[RoadOverlayOption_Count];
+};
+
+struct alignas(8) RoadSegmentCorners
+{
+    osm::EdgeId edge_id;
+    Vec2F32 corners[RoadSegmentCornerCoord_Count];
+    RoadInfo road_info;
+};
+static_assert(sizeof(RoadSegmentCorners) == 64, "size of road segment might not match shader size");
+
+// BVH types
+enum Bounds : U32
+{
+    Bounds_Min,
+    Bounds_Max,
+    Bounds_Count
+};
+
+struct RoadSegmentNodeStorageBuffer
+{
+    F32 min_x;
+    F32 min_y;
+    F32 max_x;
+    F32 max_y;
+    U32 split_axis;
+    F32 split_value;
+    U32 is_leaf;
+    union
+    {
+        struct
+        {
+            U32 child_0_idx;
+            U32 child_1_idx;
+        };
+        struct
+        {
+            U32 start_idx;
+            U32 end_idx;
+        };
+    };
+    U32 _pad;
+};
+static_assert(sizeof(RoadSegmentNodeStorageBuffer) == 40, "RoadSegmentNodeStorageBuffer must match std430 RoadSegmentNode size");
+
+struct BoundingBox
+{
+    Vec2F32 center;
+    Rng2F32 bounds;
+    U32 idx;
+};
+
+struct BvhResult
+{
+    Buffer<RoadSegmentCorners> road_segment_buffer_sorted;
+    Buffer<RoadSegmentNodeStorageBuffer> node_buffer;
+};
+
+// ~mgj: Binned SAH build, see bvh_create. Nodes deeper than BVH_SAH_MAX_DEPTH fall back to median
+// splits so no path gets near BVH_STACK_SIZE, the traversal stack in road_intersection.comp.
+const U32 BVH_SAH_BIN_COUNT = 16;
+const U32 BVH_SAH_MAX_DEPTH = 32;
+const U32 BVH_STACK_SIZE = 64;
+const U32 BVH_TASK_PRIM_MIN = 2048; // ranges at most this size are built by a single task
+
+struct BvhQueryResult
+{
+    U32 segment_idx;   // into road_segment_buffer_sorted, max_U32 when no segment contains the point
+    U32 nodes_visited; // nodes popped from the stack, a measure of build quality
+};
+
+// ~mgj: Packet classification, see bvh_points_classify. Four lanes fill an SSE register. A packet can
+// push both child orders per node, so its stack is deeper than the one in the shader.
+const U32 BVH_PACKET_WIDTH = 4;
+const U32 BVH_PACKET_STACK_SIZE = BVH_STACK_SIZE * 4;
+const U32 BVH_CLASSIFY_TASK_POINTS = 4096; // points per task in bvh_points_classify_parallel
+
+// BVH functions /////////////////////////////
+g_internal Rng2F32
+bounds_union(Rng2F32 a, Rng2F32 b);
+g_internal Rng2F32
+bounds_union(Rng2F32 rng, Vec2F32 vec);
+g_internal BvhResult
+bvh_create(async::ThreadPool* thread_pool, Arena* arena, Buffer<RoadSegmentCorners> road_segment_buffer, U32 leaf_bb_max);
+g_internal BvhQueryResult
+bvh_point_query(BvhResult* bvh, Vec2F32 pos);
+// ~mgj: out_segment_idx[i] is what bvh_point_query(bvh, points[i]).segment_idx returns
+g_internal void
+bvh_points_classify(BvhResult* bvh, Buffer<Vec2F32> points, Buffer<U32> out_segment_idx);
+g_internal void
+bvh_points_classify_parallel(async::ThreadPool* thread_pool, BvhResult* bvh, Buffer<Vec2F32> points, Buffer<U32> out_segment_idx);
+////////////////////////////////////
+
+} // namespace city
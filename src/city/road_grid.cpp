@@ -0,0 +1,319 @@
+namespace city
+{
+
+g_internal RoadGrid
+road_grid_create(Arena* arena, Buffer<Vec2F32> segment_from, Buffer<Vec2F32> segment_to, Buffer<osm::EdgeId> segment_edge_ids, F32 cell_size)
+{
+    prof_scope_marker;
+    AssertAlways(segment_to.size == segment_from.size && segment_edge_ids.size == segment_from.size);
+    ScratchScope scratch = ScratchScope(&arena, 1);
+
+    // ~mgj: the segment buffers are kept, not copied
+    RoadGrid grid = {};
+    grid.segment_from = segment_from;
+    grid.segment_to = segment_to;
+    grid.segment_edge_ids = segment_edge_ids;
+
+    U64 segment_count = segment_from.size;
+    Vec2F32 bounds_min = V2F32(0.0f, 0.0f);
+    Vec2F32 bounds_max = V2F32(0.0f, 0.0f);
+    if (segment_count)
+    {
+        bounds_min = bounds_max = segment_from.data[0];
+    }
+    for (U64 i = 0; i < segment_count; ++i)
+    {
+        for (Vec2F32 point : {segment_from.data[i], segment_to.data[i]})
+        {
+            bounds_min = V2F32(Min(bounds_min.x, point.x), Min(bounds_min.y, point.y));
+            bounds_max = V2F32(Max(bounds_max.x, point.x), Max(bounds_max.y, point.y));
+        }
+    }
+
+    grid.origin = bounds_min;
+    grid.cell_size = Max(cell_size, 0.001f);
+    U64 max_cell_count = Max(segment_count * ROAD_GRID_MAX_CELLS_PER_SEGMENT, (U64)1);
+    for (;;)
+    {
+        grid.dim_x = (U32)Max(ceilf((bounds_max.x - bounds_min.x) / grid.cell_size), 1.0f);
+        grid.dim_y = (U32)Max(ceilf((bounds_max.y - bounds_min.y) / grid.cell_size), 1.0f);
+        if ((U64)grid.dim_x * grid.dim_y <= max_cell_count)
+        {
+            break;
+        }
+        grid.cell_size *= 2.0f;
+    }
+    grid.inv_cell_size = 1.0f / grid.cell_size;
+    U32 cell_count = grid.dim_x * grid.dim_y;
+
+    // ~mgj: count, pad every run to the lane count, then fill through a cursor per cell
+    U32* cell_cursor = PushArray(scratch.arena, U32, cell_count);
+    for (U64 i = 0; i < segment_count; ++i)
+    {
+        Vec2F32 from = segment_from.data[i];
+        Vec2F32 to = segment_to.data[i];
+        Rng2S32 range = _road_grid_cell_range(&grid, V2F32(Min(from.x, to.x), Min(from.y, to.y)), V2F32(Max(from.x, to.x), Max(from.y, to.y)));
+        for (S32 y = range.y0; y <= range.y1; ++y)
+        {
+            for (S32 x = range.x0; x <= range.x1; ++x)
+            {
+                cell_cursor[(U32)y * grid.dim_x + (U32)x] += 1;
+            }
+        }
+    }
+    grid.cell_offsets = PushArrayNoZero(arena, U32, cell_count + 1);
+    grid.cell_offsets[0] = 0;
+    for (U32 cell_idx = 0; cell_idx < cell_count; ++cell_idx)
+    {
+        U32 padded_count = (cell_cursor[cell_idx] + ROAD_GRID_LANE_COUNT - 1) / ROAD_GRID_LANE_COUNT * ROAD_GRID_LANE_COUNT;
+        grid.cell_offsets[cell_idx + 1] = grid.cell_offsets[cell_idx] + padded_count;
+        cell_cursor[cell_idx] = grid.cell_offsets[cell_idx];
+    }
+
+    grid.entry_count = grid.cell_offsets[cell_count];
+    grid.entry_from_x = PushArrayNoZeroAligned(arena, F32, grid.entry_count, 16);
+    grid.entry_from_y = PushArrayNoZeroAligned(arena, F32, grid.entry_count, 16);
+    grid.entry_dir_x = PushArrayNoZeroAligned(arena, F32, grid.entry_count, 16);
+    grid.entry_dir_y = PushArrayNoZeroAligned(arena, F32, grid.entry_count, 16);
+    grid.entry_inv_len_sq = PushArrayNoZeroAligned(arena, F32, grid.entry_count, 16);
+    grid.entry_segment_idx = PushArrayNoZeroAligned(arena, U32, grid.entry_count, 16);
+    for (U32 entry_idx = 0; entry_idx < grid.entry_count; ++entry_idx)
+    {
+        grid.entry_from_x[entry_idx] = ROAD_GRID_PAD_COORD;
+        grid.entry_from_y[entry_idx] = ROAD_GRID_PAD_COORD;
+        grid.entry_dir_x[entry_idx] = 0.0f;
+        grid.entry_dir_y[entry_idx] = 0.0f;
+        grid.entry_inv_len_sq[entry_idx] = 0.0f;
+        grid.entry_segment_idx[entry_idx] = max_U32;
+    }
+    for (U64 i = 0; i < segment_count; ++i)
+    {
+        Vec2F32 from = segment_from.data[i];
+        Vec2F32 to = segment_to.data[i];
+        Vec2F32 dir = sub_2f32(to, from);
+        F32 len_sq = dir.x * dir.x + dir.y * dir.y;
+        F32 inv_len_sq = len_sq > 0.0f ? 1.0f / len_sq : 0.0f;
+        Rng2S32 range = _road_grid_cell_range(&grid, V2F32(Min(from.x, to.x), Min(from.y, to.y)), V2F32(Max(from.x, to.x), Max(from.y, to.y)));
+        for (S32 y = range.y0; y <= range.y1; ++y)
+        {
+            for (S32 x = range.x0; x <= range.x1; ++x)
+            {
+                U32 entry_idx = cell_cursor[(U32)y * grid.dim_x + (U32)x]++;
+                grid.entry_from_x[entry_idx] = from.x;
+                grid.entry_from_y[entry_idx] = from.y;
+                grid.entry_dir_x[entry_idx] = dir.x;
+                grid.entry_dir_y[entry_idx] = dir.y;
+                grid.entry_inv_len_sq[entry_idx] = inv_len_sq;
+                grid.entry_segment_idx[entry_idx] = (U32)i;
+            }
+        }
+    }
+    return grid;
+}
+
+g_internal void
+road_grid_nearest(RoadGrid* grid, Buffer<Vec2F32> points, F32 max_distance, Buffer<RoadGridHit> out_hits)
+{
+    AssertAlways(out_hits.size >= points.size);
+    for (U64 i = 0; i < points.size; ++i)
+    {
+        out_hits.data[i] = _road_grid_point_nearest(grid, points.data[i], max_distance);
+    }
+}
+
+g_internal void
+road_grid_nearest_parallel(async::ThreadPool* thread_pool, RoadGrid* grid, Buffer<Vec2F32> points, F32 max_distance, Buffer<RoadGridHit> out_hits)
+{
+    AssertAlways(out_hits.size >= points.size);
+    _RoadGridQueryTask task = {.grid = grid, .points = points, .max_distance = max_distance, .out_hits = out_hits};
+    async::parallel_for(thread_pool, points.size, ROAD_GRID_QUERY_TASK_POINTS, _road_grid_query_task, &task);
+}
+
+g_internal void
+road_grid_transforms_snap(async::ThreadPool* thread_pool, RoadGrid* grid, Mat4x4F32* transforms, U64 count, F32 max_distance)
+{
+    prof_scope_marker;
+    if (grid->entry_count == 0 || max_distance <= 0.0f)
+    {
+        return;
+    }
+    _RoadGridSnapTask task = {.grid = grid, .transforms = transforms, .max_distance = max_distance};
+    async::parallel_for(thread_pool, count, 0, _road_grid_snap_task, &task);
+}
+
+g_internal Rng2S32
+_road_grid_cell_range(RoadGrid* grid, Vec2F32 min, Vec2F32 max)
+{
+    // ~mgj: clamped to the grid, empty (x0 > x1) when the bounds miss it
+    F32 x0 = (min.x - grid->origin.x) * grid->inv_cell_size;
+    F32 y0 = (min.y - grid->origin.y) * grid->inv_cell_size;
+    F32 x1 = (max.x - grid->origin.x) * grid->inv_cell_size;
+    F32 y1 = (max.y - grid->origin.y) * grid->inv_cell_size;
+    Rng2S32 range = {};
+    if (x1 < 0.0f || y1 < 0.0f || x0 >= (F32)grid->dim_x || y0 >= (F32)grid->dim_y)
+    {
+        range.x0 = 1;
+        range.x1 = 0;
+        return range;
+    }
+    range.x0 = (S32)Max(x0, 0.0f);
+    range.y0 = (S32)Max(y0, 0.0f);
+    range.x1 = (S32)Min(x1, (F32)(grid->dim_x - 1));
+    range.y1 = (S32)Min(y1, (F32)(grid->dim_y - 1));
+    return range;
+}
+
+g_internal void
+_road_grid_cell_scan(RoadGrid* grid, U32 cell_idx, __m128 point_x, __m128 point_y, _RoadGridLanes* best)
+{
+    // ~mgj: closest point on each segment: t of the projection clamped to [0, 1]
+    __m128 zero = _mm_setzero_ps();
+    __m128 one = _mm_set1_ps(1.0f);
+    U32 end_idx = grid->cell_offsets[cell_idx + 1];
+    for (U32 entry_idx = grid->cell_offsets[cell_idx]; entry_idx < end_idx; entry_idx += ROAD_GRID_LANE_COUNT)
+    {
+        __m128 dir_x = _mm_load_ps(grid->entry_dir_x + entry_idx);
+        __m128 dir_y = _mm_load_ps(grid->entry_dir_y + entry_idx);
+        __m128 to_point_x = _mm_sub_ps(point_x, _mm_load_ps(grid->entry_from_x + entry_idx));
+        __m128 to_point_y = _mm_sub_ps(point_y, _mm_load_ps(grid->entry_from_y + entry_idx));
+        __m128 proj = _mm_add_ps(_mm_mul_ps(to_point_x, dir_x), _mm_mul_ps(to_point_y, dir_y));
+        __m128 t = _mm_min_ps(_mm_max_ps(_mm_mul_ps(proj, _mm_load_ps(grid->entry_inv_len_sq + entry_idx)), zero), one);
+        __m128 offset_x = _mm_sub_ps(to_point_x, _mm_mul_ps(t, dir_x));
+        __m128 offset_y = _mm_sub_ps(to_point_y, _mm_mul_ps(t, dir_y));
+        __m128 dist_sq = _mm_add_ps(_mm_mul_ps(offset_x, offset_x), _mm_mul_ps(offset_y, offset_y));
+        __m128 closer = _mm_cmplt_ps(dist_sq, best->dist_sq);
+        best->dist_sq = _mm_blendv_ps(best->dist_sq, dist_sq, closer);
+        best->t = _mm_blendv_ps(best->t, t, closer);
+        __m128i lane_entry_idx = _mm_add_epi32(_mm_set1_epi32((S32)entry_idx), _mm_set_epi32(3, 2, 1, 0));
+        best->entry_idx = _mm_castps_si128(_mm_blendv_ps(_mm_castsi128_ps(best->entry_idx), _mm_castsi128_ps(lane_entry_idx), closer));
+    }
+}
+
+g_internal U32
+_road_grid_lanes_min(_RoadGridLanes* best)
+{
+    // ~mgj: the lane with the smallest distance, the first one on a tie
+    alignas(16) F32 dist_sq[ROAD_GRID_LANE_COUNT];
+    _mm_store_ps(dist_sq, best->dist_sq);
+    U32 best_lane = 0;
+    for (U32 lane = 1; lane < ROAD_GRID_LANE_COUNT; ++lane)
+    {
+        if (dist_sq[lane] < dist_sq[best_lane])
+        {
+            best_lane = lane;
+        }
+    }
+    return best_lane;
+}
+
+g_internal RoadGridHit
+_road_grid_point_nearest(RoadGrid* grid, Vec2F32 point, F32 max_distance)
+{
+    // ~mgj: capped so the padding stays out of reach
+    max_distance = Min(max_distance, 1e12f);
+    __m128 point_x = _mm_set1_ps(point.x);
+    __m128 point_y = _mm_set1_ps(point.y);
+    _RoadGridLanes best = {.dist_sq = _mm_set1_ps(max_distance * max_distance), .t = _mm_setzero_ps(), .entry_idx = _mm_set1_epi32(-1)};
+
+    Rng2S32 own = _road_grid_cell_range(grid, point, point);
+    U32 own_cell_idx = max_U32;
+    F32 radius = max_distance;
+    if (own.x0 <= own.x1 && own.y0 <= own.y1)
+    {
+        own_cell_idx = (U32)own.y0 * grid->dim_x + (U32)own.x0;
+        _road_grid_cell_scan(grid, own_cell_idx, point_x, point_y, &best);
+        alignas(16) F32 dist_sq[ROAD_GRID_LANE_COUNT];
+        _mm_store_ps(dist_sq, best.dist_sq);
+        radius = sqrtf(dist_sq[_road_grid_lanes_min(&best)]);
+    }
+
+    Rng2S32 range = _road_grid_cell_range(grid, V2F32(point.x - radius, point.y - radius), V2F32(point.x + radius, point.y + radius));
+    for (S32 y = range.y0; y <= range.y1; ++y)
+    {
+        for (S32 x = range.x0; x <= range.x1; ++x)
+        {
+            U32 cell_idx = (U32)y * grid->dim_x + (U32)x;
+            if (cell_idx != own_cell_idx)
+            {
+                _road_grid_cell_scan(grid, cell_idx, point_x, point_y, &best);
+            }
+        }
+    }
+
+    RoadGridHit hit = {.segment_idx = max_U32, .pos = point};
+    U32 lane = _road_grid_lanes_min(&best);
+    alignas(16) U32 entry_idxs[ROAD_GRID_LANE_COUNT];
+    alignas(16) F32 dist_sq[ROAD_GRID_LANE_COUNT];
+    alignas(16) F32 t[ROAD_GRID_LANE_COUNT];
+    _mm_store_si128((__m128i*)entry_idxs, best.entry_idx);
+    _mm_store_ps(dist_sq, best.dist_sq);
+    _mm_store_ps(t, best.t);
+    U32 entry_idx = entry_idxs[lane];
+    if (entry_idx != max_U32)
+    {
+        hit.segment_idx = grid->entry_segment_idx[entry_idx];
+        hit.t = t[lane];
+        hit.dist_sq = dist_sq[lane];
+        hit.pos = V2F32(grid->entry_from_x[entry_idx] + grid->entry_dir_x[entry_idx] * t[lane], grid->entry_from_y[entry_idx] + grid->entry_dir_y[entry_idx] * t[lane]);
+    }
+    return hit;
+}
+
+g_internal void
+_road_grid_query_task(async::ThreadInfo thread_info, Arena* scratch_arena, void* data, U64 start_idx, U64 end_idx)
+{
+    (void)thread_info;
+    (void)scratch_arena;
+    _RoadGridQueryTask* task = (_RoadGridQueryTask*)data;
+    road_grid_nearest(task->grid, {.data = &task->points.data[start_idx], .size = end_idx - start_idx}, task->max_distance,
+                      {.data = &task->out_hits.data[start_idx], .size = end_idx - start_idx});
+}
+
+g_internal void
+_road_grid_transform_snap(RoadGrid* grid, Mat4x4F32* transform, F32 max_distance)
+{
+    RoadGridHit hit = _road_grid_point_nearest(grid, V2F32(transform->v[3][0], transform->v[3][1]), max_distance);
+    if (hit.segment_idx == max_U32)
+    {
+        return;
+    }
+    Vec2F32 road_dir = sub_2f32(grid->segment_to.data[hit.segment_idx], grid->segment_from.data[hit.segment_idx]);
+    F32 road_len = sqrtf(road_dir.x * road_dir.x + road_dir.y * road_dir.y);
+    transform->v[3][0] = hit.pos.x;
+    transform->v[3][1] = hit.pos.y;
+    if (road_len <= 0.0f)
+    {
+        return;
+    }
+
+    // ~mgj: x along the road in the direction the old x basis pointed, then y up and z = x cross up as in
+    // _agent_store_transforms with a level heading
+    F32* x_basis = transform->v[0];
+    F32 scale = sqrtf(x_basis[0] * x_basis[0] + x_basis[1] * x_basis[1] + x_basis[2] * x_basis[2]);
+    F32 sign = road_dir.x * x_basis[0] + road_dir.y * x_basis[1] < 0.0f ? -1.0f : 1.0f;
+    F32 x0 = sign * road_dir.x / road_len;
+    F32 x1 = sign * road_dir.y / road_len;
+    transform->v[0][0] = x0 * scale;
+    transform->v[0][1] = x1 * scale;
+    transform->v[0][2] = 0.0f;
+    transform->v[1][0] = 0.0f;
+    transform->v[1][1] = 0.0f;
+    transform->v[1][2] = scale;
+    transform->v[2][0] = x1 * scale;
+    transform->v[2][1] = -x0 * scale;
+    transform->v[2][2] = 0.0f;
+}
+
+g_internal void
+_road_grid_snap_task(async::ThreadInfo thread_info, Arena* scratch_arena, void* data, U64 start_idx, U64 end_idx)
+{
+    (void)thread_info;
+    (void)scratch_arena;
+    _RoadGridSnapTask* task = (_RoadGridSnapTask*)data;
+    for (U64 i = start_idx; i < end_idx; ++i)
+    {
+        _road_grid_transform_snap(task->grid, &task->transforms[i], task->max_distance);
+    }
+}
+
+} // namespace city
@@ -0,0 +1,97 @@
+#pragma once
+
+namespace city
+{
+// ~mgj: Uniform grid over the road centre lines in local coordinates, for nearest road queries. Every cell
+// lists the segments whose bounds overlap it, with their start, direction and 1 / length^2 copied in cell
+// order, so a query reads one contiguous run per cell and tests ROAD_GRID_LANE_COUNT segments per SSE
+// iteration without a division. Runs are padded to a multiple of the lane count with points far outside the
+// grid. The best segment is kept per lane and picked once per query.
+// A query scans the cell of the point first and then only the cells within the best distance so far (and
+// max_distance), so most points on a road read a single cell.
+const U32 ROAD_GRID_LANE_COUNT = 4;
+const F32 ROAD_GRID_DEFAULT_CELL_SIZE = 32.0f; // meters, about one OSM edge in a city
+const U32 ROAD_GRID_MAX_CELLS_PER_SEGMENT = 4;  // sparse networks over a large area get larger cells
+const F32 ROAD_GRID_PAD_COORD = 1e18f;          // squared it still fits in an F32
+const U32 ROAD_GRID_QUERY_TASK_POINTS = 4096;   // smallest chunk of road_grid_nearest_parallel
+
+struct RoadGrid
+{
+    Vec2F32 origin;
+    F32 cell_size;
+    F32 inv_cell_size;
+    U32 dim_x;
+    U32 dim_y;
+    U32* cell_offsets; // dim_x * dim_y + 1 offsets into the entries, every run a multiple of ROAD_GRID_LANE_COUNT
+
+    U32 entry_count;
+    F32* entry_from_x; // per entry, 16 byte aligned
+    F32* entry_from_y;
+    F32* entry_dir_x; // to - from
+    F32* entry_dir_y;
+    F32* entry_inv_len_sq; // 0 for zero length segments and padding, their closest point is from
+    U32* entry_segment_idx; // max_U32 for padding
+
+    Buffer<Vec2F32> segment_from;
+    Buffer<Vec2F32> segment_to;
+    Buffer<osm::EdgeId> segment_edge_ids;
+};
+
+struct RoadGridHit
+{
+    U32 segment_idx; // max_U32 when no segment is within max_distance
+    F32 t;           // from segment_from (0) to segment_to (1)
+    F32 dist_sq;
+    Vec2F32 pos;
+};
+
+g_internal RoadGrid
+road_grid_create(Arena* arena, Buffer<Vec2F32> segment_from, Buffer<Vec2F32> segment_to, Buffer<osm::EdgeId> segment_edge_ids, F32 cell_size);
+// ~mgj: out_hits[i] is the closest point on any segment to points[i] within max_distance
+g_internal void
+road_grid_nearest(RoadGrid* grid, Buffer<Vec2F32> points, F32 max_distance, Buffer<RoadGridHit> out_hits);
+g_internal void
+road_grid_nearest_parallel(async::ThreadPool* thread_pool, RoadGrid* grid, Buffer<Vec2F32> points, F32 max_distance, Buffer<RoadGridHit> out_hits);
+// ~mgj: moves every transform within max_distance of a road onto its centre line and turns its x basis along the
+// road, keeping the travel direction and the scale. The basis follows _agent_store_transforms, z is up.
+g_internal void
+road_grid_transforms_snap(async::ThreadPool* thread_pool, RoadGrid* grid, Mat4x4F32* transforms, U64 count, F32 max_distance);
+
+// ~mgj: internal
+struct _RoadGridQueryTask
+{
+    RoadGrid* grid;
+    Buffer<Vec2F32> points;
+    F32 max_distance;
+    Buffer<RoadGridHit> out_hits;
+};
+
+struct _RoadGridSnapTask
+{
+    RoadGrid* grid;
+    Mat4x4F32* transforms;
+    F32 max_distance;
+};
+
+struct _RoadGridLanes
+{
+    __m128 dist_sq;
+    __m128 t;
+    __m128i entry_idx;
+};
+
+g_internal Rng2S32
+_road_grid_cell_range(RoadGrid* grid, Vec2F32 min, Vec2F32 max);
+g_internal void
+_road_grid_cell_scan(RoadGrid* grid, U32 cell_idx, __m128 point_x, __m128 point_y, _RoadGridLanes* best);
+g_internal U32
+_road_grid_lanes_min(_RoadGridLanes* best);
+g_internal RoadGridHit
+_road_grid_point_nearest(RoadGrid* grid, Vec2F32 point, F32 max_distance);
+g_internal void
+_road_grid_query_task(async::ThreadInfo thread_info, Arena* scratch_arena, void* data, U64 start_idx, U64 end_idx);
+g_internal void
+_road_grid_transform_snap(RoadGrid* grid, Mat4x4F32* transform, F32 max_distance);
+g_internal void
+_road_grid_snap_task(async::ThreadInfo thread_info, Arena* scratch_arena, void* data, U64 start_idx, U64 end_idx);
+} // namespace city
@@ -0,0 +1,754 @@
+namespace city
+{
+
+struct _TriNode
+{
+    _TriNode* prev;
+    _TriNode* next;
+    // ~mgj: z-order neighbours, only linked when the polygon is hashed
+    _TriNode* prev_z;
+    _TriNode* next_z;
+    F64 x;
+    F64 y;
+    U32 i; // index into the input vertices
+    U32 z;
+    B32 steiner; // single vertex hole, must survive filtering
+};
+
+struct _Triangulate
+{
+    Arena* arena;
+    Buffer<Vec2F64> vertices;
+    Buffer<U32> indices;
+    U64 index_count;
+
+    // ~mgj: z-order hash of the outer ring bounds, inv_size == 0 when the polygon is not hashed
+    F64 min_x;
+    F64 min_y;
+    F64 inv_size;
+};
+
+g_internal _TriNode*
+_tri_node_insert(_Triangulate* tri, U32 i, _TriNode* last)
+{
+    _TriNode* node = PushStruct(tri->arena, _TriNode);
+    node->x = tri->vertices.data[i].x;
+    node->y = tri->vertices.data[i].y;
+    node->i = i;
+    if (!last)
+    {
+        node->prev = node;
+        node->next = node;
+    }
+    else
+    {
+        node->next = last->next;
+        node->prev = last;
+        last->next->prev = node;
+        last->next = node;
+    }
+    return node;
+}
+
+g_internal void
+_tri_node_remove(_TriNode* node)
+{
+    node->next->prev = node->prev;
+    node->prev->next = node->next;
+    if (node->prev_z)
+    {
+        node->prev_z->next_z = node->next_z;
+    }
+    if (node->next_z)
+    {
+        node->next_z->prev_z = node->prev_z;
+    }
+}
+
+g_internal void
+_tri_emit(_Triangulate* tri, _TriNode* a, _TriNode* b, _TriNode* c)
+{
+    AssertAlways(tri->index_count + 3 <= tri->indices.size);
+    // ~mgj: the ring is clipped counter clockwise, emit clockwise like the roofs always had
+    tri->indices.data[tri->index_count++] = c->i;
+    tri->indices.data[tri->index_count++] = b->i;
+    tri->indices.data[tri->index_count++] = a->i;
+}
+
+// ~mgj: twice the signed area of pqr, negative when p -> q -> r turns counter clockwise
+g_internal F64
+_tri_area(_TriNode* p, _TriNode* q, _TriNode* r)
+{
+    return (q->y - p->y) * (r->x - q->x) - (q->x - p->x) * (r->y - q->y);
+}
+
+g_internal B32
+_tri_equals(_TriNode* a, _TriNode* b)
+{
+    return a->x == b->x && a->y == b->y;
+}
+
+g_internal S32
+_tri_sign(F64 v)
+{
+    return v > 0.0 ? 1 : (v < 0.0 ? -1 : 0);
+}
+
+g_internal B32
+_tri_point_in_triangle(F64 ax, F64 ay, F64 bx, F64 by, F64 cx, F64 cy, F64 px, F64 py)
+{
+    return (cx - px) * (ay - py) >= (ax - px) * (cy - py) && (ax - px) * (by - py) >= (bx - px) * (ay - py) && (bx - px) * (cy - py) >= (cx - px) * (by - py);
+}
+
+g_internal B32
+_tri_point_in_triangle_except_first(F64 ax, F64 ay, F64 bx, F64 by, F64 cx, F64 cy, F64 px, F64 py)
+{
+    return !(ax == px && ay == py) && _tri_point_in_triangle(ax, ay, bx, by, cx, cy, px, py);
+}
+
+// ~mgj: q lies on segment pr, given the three are collinear
+g_internal B32
+_tri_on_segment(_TriNode* p, _TriNode* q, _TriNode* r)
+{
+    return q->x <= Max(p->x, r->x) && q->x >= Min(p->x, r->x) && q->y <= Max(p->y, r->y) && q->y >= Min(p->y, r->y);
+}
+
+g_internal B32
+_tri_intersects(_TriNode* p1, _TriNode* q1, _TriNode* p2, _TriNode* q2)
+{
+    S32 o1 = _tri_sign(_tri_area(p1, q1, p2));
+    S32 o2 = _tri_sign(_tri_area(p1, q1, q2));
+    S32 o3 = _tri_sign(_tri_area(p2, q2, p1));
+    S32 o4 = _tri_sign(_tri_area(p2, q2, q1));
+    if (o1 != o2 && o3 != o4)
+    {
+        return true;
+    }
+    return (o1 == 0 && _tri_on_segment(p1, p2, q1)) || (o2 == 0 && _tri_on_segment(p1, q2, q1)) || (o3 == 0 && _tri_on_segment(p2, p1, q2)) ||
+           (o4 == 0 && _tri_on_segment(p2, q1, q2));
+}
+
+g_internal B32
+_tri_intersects_polygon(_TriNode* a, _TriNode* b)
+{
+    _TriNode* p = a;
+    do
+    {
+        if (p->i != a->i && p->next->i != a->i && p->i != b->i && p->next->i != b->i && _tri_intersects(p, p->next, a, b))
+        {
+            return true;
+        }
+        p = p->next;
+    } while (p != a);
+    return false;
+}
+
+// ~mgj: the diagonal ab leaves a into the polygon interior
+g_internal B32
+_tri_locally_inside(_TriNode* a, _TriNode* b)
+{
+    return _tri_area(a->prev, a, a->next) < 0.0 ? _tri_area(a, b, a->next) >= 0.0 && _tri_area(a, a->prev, b) >= 0.0
+                                                : _tri_area(a, b, a->prev) < 0.0 || _tri_area(a, a->next, b) < 0.0;
+}
+
+g_internal B32
+_tri_middle_inside(_TriNode* a, _TriNode* b)
+{
+    _TriNode* p = a;
+    B32 inside = false;
+    F64 px = (a->x + b->x) / 2.0;
+    F64 py = (a->y + b->y) / 2.0;
+    do
+    {
+        if (((p->y > py) != (p->next->y > py)) && p->next->y != p->y && (px < (p->next->x - p->x) * (py - p->y) / (p->next->y - p->y) + p->x))
+        {
+            inside = !inside;
+        }
+        p = p->next;
+    } while (p != a);
+    return inside;
+}
+
+g_internal B32
+_tri_is_valid_diagonal(_TriNode* a, _TriNode* b)
+{
+    if (a->next->i == b->i || a->prev->i == b->i || _tri_intersects_polygon(a, b))
+    {
+        return false;
+    }
+    B32 is_locally_visible = _tri_locally_inside(a, b) && _tri_locally_inside(b, a) && _tri_middle_inside(a, b) && (_tri_area(a->prev, a, b->prev) != 0.0 || _tri_area(a, b->prev, b) != 0.0);
+    B32 is_zero_length = _tri_equals(a, b) && _tri_area(a->prev, a, a->next) > 0.0 && _tri_area(b->prev, b, b->next) > 0.0;
+    return is_locally_visible || is_zero_length;
+}
+
+// ~mgj: links a and b with a diagonal, splitting the ring in two. Returns the copy of b on the new ring.
+g_internal _TriNode*
+_tri_split_polygon(_Triangulate* tri, _TriNode* a, _TriNode* b)
+{
+    _TriNode* a2 = PushStruct(tri->arena, _TriNode);
+    _TriNode* b2 = PushStruct(tri->arena, _TriNode);
+    *a2 = {.x = a->x, .y = a->y, .i = a->i};
+    *b2 = {.x = b->x, .y = b->y, .i = b->i};
+    _TriNode* an = a->next;
+    _TriNode* bp = b->prev;
+
+    a->next = b;
+    b->prev = a;
+    a2->next = an;
+    an->prev = a2;
+    b2->next = a2;
+    a2->prev = b2;
+    bp->next = b2;
+    b2->prev = bp;
+    return b2;
+}
+
+// ~mgj: Builds the ring of vertices [start_idx, end_idx) counter clockwise, or clockwise for holes
+g_internal _TriNode*
+_tri_linked_list(_Triangulate* tri, U32 start_idx, U32 end_idx, B32 counter_clockwise)
+{
+    F64 signed_area = 0.0;
+    for (U32 i = start_idx, j = end_idx - 1; i < end_idx; j = i++)
+    {
+        Vec2F64 a = tri->vertices.data[j];
+        Vec2F64 b = tri->vertices.data[i];
+        signed_area += (a.x - b.x) * (b.y + a.y);
+    }
+
+    _TriNode* last = 0;
+    if (counter_clockwise == (signed_area > 0.0))
+    {
+        for (U32 i = start_idx; i < end_idx; ++i)
+        {
+            last = _tri_node_insert(tri, i, last);
+        }
+    }
+    else
+    {
+        for (U32 i = end_idx; i > start_idx; --i)
+        {
+            last = _tri_node_insert(tri, i - 1, last);
+        }
+    }
+
+    if (last && _tri_equals(last, last->next))
+    {
+        _tri_node_remove(last);
+        last = last->next;
+    }
+    return last;
+}
+
+// ~mgj: drops duplicate and collinear vertices between start and end
+g_internal _TriNode*
+_tri_filter_points(_TriNode* start, _TriNode* end)
+{
+    if (!start)
+    {
+        return start;
+    }
+    if (!end)
+    {
+        end = start;
+    }
+
+    _TriNode* p = start;
+    B32 again;
+    do
+    {
+        again = false;
+        if (!p->steiner && (_tri_equals(p, p->next) || _tri_area(p->prev, p, p->next) == 0.0))
+        {
+            _tri_node_remove(p);
+            p = end = p->prev;
+            if (p == p->next)
+            {
+                break;
+            }
+            again = true;
+        }
+        else
+        {
+            p = p->next;
+        }
+    } while (again || p != end);
+    return end;
+}
+
+g_internal U32
+_tri_z_order(_Triangulate* tri, F64 x, F64 y)
+{
+    U32 zx = (U32)((x - tri->min_x) * tri->inv_size);
+    U32 zy = (U32)((y - tri->min_y) * tri->inv_size);
+
+    zx = (zx | (zx << 8)) & 0x00FF00FF;
+    zx = (zx | (zx << 4)) & 0x0F0F0F0F;
+    zx = (zx | (zx << 2)) & 0x33333333;
+    zx = (zx | (zx << 1)) & 0x55555555;
+
+    zy = (zy | (zy << 8)) & 0x00FF00FF;
+    zy = (zy | (zy << 4)) & 0x0F0F0F0F;
+    zy = (zy | (zy << 2)) & 0x33333333;
+    zy = (zy | (zy << 1)) & 0x55555555;
+
+    return zx | (zy << 1);
+}
+
+// ~mgj: bottom up merge sort of the z-order list
+g_internal _TriNode*
+_tri_sort_linked(_TriNode* list)
+{
+    U32 merge_count;
+    U32 in_size = 1;
+    do
+    {
+        _TriNode* p = list;
+        _TriNode* tail = 0;
+        list = 0;
+        merge_count = 0;
+
+        while (p)
+        {
+            merge_count += 1;
+            _TriNode* q = p;
+            U32 p_size = 0;
+            for (U32 i = 0; i < in_size; ++i)
+            {
+                p_size += 1;
+                q = q->next_z;
+                if (!q)
+                {
+                    break;
+                }
+            }
+
+            U32 q_size = in_size;
+            while (p_size > 0 || (q_size > 0 && q))
+            {
+                _TriNode* e;
+                if (p_size != 0 && (q_size == 0 || !q || p->z <= q->z))
+                {
+                    e = p;
+                    p = p->next_z;
+                    p_size -= 1;
+                }
+                else
+                {
+                    e = q;
+                    q = q->next_z;
+                    q_size -= 1;
+                }
+
+                if (tail)
+                {
+                    tail->next_z = e;
+                }
+                else
+                {
+                    list = e;
+                }
+                e->prev_z = tail;
+                tail = e;
+            }
+            p = q;
+        }
+        tail->next_z = 0;
+        in_size *= 2;
+    } while (merge_count > 1);
+    return list;
+}
+
+g_internal void
+_tri_index_curve(_Triangulate* tri, _TriNode* start)
+{
+    _TriNode* p = start;
+    do
+    {
+        if (p->z == 0)
+        {
+            p->z = _tri_z_order(tri, p->x, p->y);
+        }
+        p->prev_z = p->prev;
+        p->next_z = p->next;
+        p = p->next;
+    } while (p != start);
+
+    p->prev_z->next_z = 0;
+    p->prev_z = 0;
+    _tri_sort_linked(p);
+}
+
+// ~mgj: no other reflex vertex of the ring lies in the triangle prev, ear, next
+g_internal B32
+_tri_is_ear(_TriNode* ear)
+{
+    _TriNode* a = ear->prev;
+    _TriNode* b = ear;
+    _TriNode* c = ear->next;
+    if (_tri_area(a, b, c) >= 0.0)
+    {
+        return false;
+    }
+
+    F64 x0 = Min(a->x, Min(b->x, c->x));
+    F64 y0 = Min(a->y, Min(b->y, c->y));
+    F64 x1 = Max(a->x, Max(b->x, c->x));
+    F64 y1 = Max(a->y, Max(b->y, c->y));
+    for (_TriNode* p = c->next; p != a; p = p->next)
+    {
+        if (p->x >= x0 && p->x <= x1 && p->y >= y0 && p->y <= y1 && _tri_point_in_triangle_except_first(a->x, a->y, b->x, b->y, c->x, c->y, p->x, p->y) &&
+            _tri_area(p->prev, p, p->next) >= 0.0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+g_internal B32
+_tri_is_ear_hashed(_Triangulate* tri, _TriNode* ear)
+{
+    _TriNode* a = ear->prev;
+    _TriNode* b = ear;
+    _TriNode* c = ear->next;
+    if (_tri_area(a, b, c) >= 0.0)
+    {
+        return false;
+    }
+
+    F64 x0 = Min(a->x, Min(b->x, c->x));
+    F64 y0 = Min(a->y, Min(b->y, c->y));
+    F64 x1 = Max(a->x, Max(b->x, c->x));
+    F64 y1 = Max(a->y, Max(b->y, c->y));
+    U32 min_z = _tri_z_order(tri, x0, y0);
+    U32 max_z = _tri_z_order(tri, x1, y1);
+
+    // ~mgj: walk the z-order list both ways from the ear, stopping outside the bounding box z range
+    auto blocks = [&](_TriNode* p) -> B32 {
+        return p->x >= x0 && p->x <= x1 && p->y >= y0 && p->y <= y1 && p != a && p != c && _tri_point_in_triangle_except_first(a->x, a->y, b->x, b->y, c->x, c->y, p->x, p->y) &&
+               _tri_area(p->prev, p, p->next) >= 0.0;
+    };
+    _TriNode* p = ear->prev_z;
+    _TriNode* n = ear->next_z;
+    while (p && p->z >= min_z && n && n->z <= max_z)
+    {
+        if (blocks(p))
+        {
+            return false;
+        }
+        p = p->prev_z;
+        if (blocks(n))
+        {
+            return false;
+        }
+        n = n->next_z;
+    }
+    for (; p && p->z >= min_z; p = p->prev_z)
+    {
+        if (blocks(p))
+        {
+            return false;
+        }
+    }
+    for (; n && n->z <= max_z; n = n->next_z)
+    {
+        if (blocks(n))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// ~mgj: clips the small self intersections a -> p -> p.next -> b that block every ear
+g_internal _TriNode*
+_tri_cure_local_intersections(_Triangulate* tri, _TriNode* start)
+{
+    _TriNode* p = start;
+    do
+    {
+        _TriNode* a = p->prev;
+        _TriNode* b = p->next->next;
+        if (!_tri_equals(a, b) && _tri_intersects(a, p, p->next, b) && _tri_locally_inside(a, b) && _tri_locally_inside(b, a))
+        {
+            _tri_emit(tri, a, p, b);
+            _tri_node_remove(p);
+            _tri_node_remove(p->next);
+            p = start = b;
+        }
+        p = p->next;
+    } while (p != start);
+    return _tri_filter_points(p, 0);
+}
+
+g_internal void
+_tri_earcut_linked(_Triangulate* tri, _TriNode* ear, U32 pass);
+
+// ~mgj: last resort, split the ring along a valid diagonal and clip both halves
+g_internal void
+_tri_split_earcut(_Triangulate* tri, _TriNode* start)
+{
+    _TriNode* a = start;
+    do
+    {
+        for (_TriNode* b = a->next->next; b != a->prev; b = b->next)
+        {
+            if (a->i != b->i && _tri_is_valid_diagonal(a, b))
+            {
+                _TriNode* c = _tri_split_polygon(tri, a, b);
+                a = _tri_filter_points(a, a->next);
+                c = _tri_filter_points(c, c->next);
+                _tri_earcut_linked(tri, a, 0);
+                _tri_earcut_linked(tri, c, 0);
+                return;
+            }
+        }
+        a = a->next;
+    } while (a != start);
+}
+
+// ~mgj: pass 0 clips ears, pass 1 retries after filtering, pass 2 cures self intersections and
+// pass 3 splits the remaining ring
+g_internal void
+_tri_earcut_linked(_Triangulate* tri, _TriNode* ear, U32 pass)
+{
+    if (!ear)
+    {
+        return;
+    }
+    if (pass == 0 && tri->inv_size != 0.0)
+    {
+        _tri_index_curve(tri, ear);
+    }
+
+    _TriNode* stop = ear;
+    while (ear->prev != ear->next)
+    {
+        _TriNode* prev = ear->prev;
+        _TriNode* next = ear->next;
+        B32 is_ear = tri->inv_size != 0.0 ? _tri_is_ear_hashed(tri, ear) : _tri_is_ear(ear);
+        if (is_ear)
+        {
+            _tri_emit(tri, prev, ear, next);
+            _tri_node_remove(ear);
+            // ~mgj: skipping the next vertex gives fewer sliver triangles
+            ear = next->next;
+            stop = next->next;
+            continue;
+        }
+
+        ear = next;
+        if (ear == stop)
+        {
+            if (pass == 0)
+            {
+                _tri_earcut_linked(tri, _tri_filter_points(ear, 0), 1);
+            }
+            else if (pass == 1)
+            {
+                ear = _tri_cure_local_intersections(tri, _tri_filter_points(ear, 0));
+                _tri_earcut_linked(tri, ear, 2);
+            }
+            else if (pass == 2)
+            {
+                _tri_split_earcut(tri, ear);
+            }
+            break;
+        }
+    }
+}
+
+g_internal _TriNode*
+_tri_leftmost(_TriNode* start)
+{
+    _TriNode* p = start;
+    _TriNode* leftmost = start;
+    do
+    {
+        if (p->x < leftmost->x || (p->x == leftmost->x && p->y < leftmost->y))
+        {
+            leftmost = p;
+        }
+        p = p->next;
+    } while (p != start);
+    return leftmost;
+}
+
+g_internal B32
+_tri_sector_contains_sector(_TriNode* m, _TriNode* p)
+{
+    return _tri_area(m->prev, m, p->prev) < 0.0 && _tri_area(p->next, m, m->next) < 0.0;
+}
+
+// ~mgj: David Eberly's algorithm, finds an outer ring vertex the hole's leftmost vertex can see
+g_internal _TriNode*
+_tri_hole_bridge_find(_TriNode* hole, _TriNode* outer)
+{
+    _TriNode* p = outer;
+    F64 hx = hole->x;
+    F64 hy = hole->y;
+    F64 qx = (F64)neg_inf32();
+    _TriNode* m = 0;
+
+    // ~mgj: the closest edge to the left of the hole vertex on a horizontal ray
+    if (_tri_equals(hole, p))
+    {
+        return p;
+    }
+    do
+    {
+        if (_tri_equals(hole, p->next))
+        {
+            return p->next;
+        }
+        else if (hy <= p->y && hy >= p->next->y && p->next->y != p->y)
+        {
+            F64 x = p->x + (hy - p->y) * (p->next->x - p->x) / (p->next->y - p->y);
+            if (x <= hx && x > qx)
+            {
+                qx = x;
+                m = p->x < p->next->x ? p : p->next;
+                if (x == hx)
+                {
+                    return m;
+                }
+            }
+        }
+        p = p->next;
+    } while (p != outer);
+
+    if (!m)
+    {
+        return 0;
+    }
+
+    // ~mgj: among the reflex vertices inside the triangle hole, ray hit, m take the one with the
+    // smallest angle to the ray
+    _TriNode* stop = m;
+    F64 mx = m->x;
+    F64 my = m->y;
+    F64 tan_min = (F64)inf32();
+    p = m;
+    do
+    {
+        if (hx >= p->x && p->x >= mx && hx != p->x && _tri_point_in_triangle(hy < my ? hx : qx, hy, mx, my, hy < my ? qx : hx, hy, p->x, p->y))
+        {
+            F64 tan = AbsF64(hy - p->y) / (hx - p->x);
+            if (_tri_locally_inside(p, hole) && (tan < tan_min || (tan == tan_min && (p->x > m->x || (p->x == m->x && _tri_sector_contains_sector(m, p))))))
+            {
+                m = p;
+                tan_min = tan;
+            }
+        }
+        p = p->next;
+    } while (p != stop);
+    return m;
+}
+
+g_internal _TriNode*
+_tri_hole_eliminate(_Triangulate* tri, _TriNode* hole, _TriNode* outer)
+{
+    _TriNode* bridge = _tri_hole_bridge_find(hole, outer);
+    if (!bridge)
+    {
+        return outer;
+    }
+    _TriNode* bridge_reverse = _tri_split_polygon(tri, bridge, hole);
+    _tri_filter_points(bridge_reverse, bridge_reverse->next);
+    return _tri_filter_points(bridge, bridge->next);
+}
+
+g_internal _TriNode*
+_tri_holes_eliminate(_Triangulate* tri, Buffer<U32> hole_starts, _TriNode* outer)
+{
+    ScratchScope scratch = ScratchScope(&tri->arena, 1);
+    _TriNode** queue = PushArray(scratch.arena, _TriNode*, hole_starts.size);
+    U64 queue_count = 0;
+    for (U64 i = 0; i < hole_starts.size; ++i)
+    {
+        U32 start_idx = hole_starts.data[i];
+        U32 end_idx = i + 1 < hole_starts.size ? hole_starts.data[i + 1] : (U32)tri->vertices.size;
+        _TriNode* list = start_idx < end_idx ? _tri_linked_list(tri, start_idx, end_idx, false) : 0;
+        if (!list)
+        {
+            continue;
+        }
+        if (list == list->next)
+        {
+            list->steiner = true;
+        }
+        queue[queue_count++] = _tri_leftmost(list);
+    }
+
+    // ~mgj: bridge holes left to right, ties broken by y then by the slope of the first edge
+    std::sort(queue, queue + queue_count, [](_TriNode* a, _TriNode* b) {
+        if (a->x != b->x)
+        {
+            return a->x < b->x;
+        }
+        if (a->y != b->y)
+        {
+            return a->y < b->y;
+        }
+        F64 a_slope = (a->next->y - a->y) / (a->next->x - a->x);
+        F64 b_slope = (b->next->y - b->y) / (b->next->x - b->x);
+        return a_slope < b_slope;
+    });
+    for (U64 i = 0; i < queue_count; ++i)
+    {
+        outer = _tri_hole_eliminate(tri, queue[i], outer);
+    }
+    return outer;
+}
+
+g_internal Buffer<U32>
+polygon_triangulate(Arena* arena, Buffer<Vec2F64> vertices, Buffer<U32> hole_starts)
+{
+    prof_scope_marker;
+    ScratchScope scratch = ScratchScope(&arena, 1);
+    U32 outer_count = hole_starts.size > 0 ? hole_starts.data[0] : (U32)vertices.size;
+    if (outer_count < 3)
+    {
+        return {};
+    }
+
+    // ~mgj: every bridge adds two vertices, and a ring of n vertices has n - 2 triangles
+    U64 triangle_max = vertices.size + 2 * hole_starts.size - 2;
+    _Triangulate tri = {.arena = scratch.arena, .vertices = vertices};
+    tri.indices = buffer_alloc<U32>(arena, triangle_max * 3);
+
+    _TriNode* outer = _tri_linked_list(&tri, 0, outer_count, true);
+    if (!outer || outer->next == outer->prev)
+    {
+        tri.indices.size = 0;
+        return tri.indices;
+    }
+    if (hole_starts.size > 0)
+    {
+        outer = _tri_holes_eliminate(&tri, hole_starts, outer);
+    }
+
+    if (vertices.size > TRIANGULATE_HASH_VERTEX_MIN)
+    {
+        F64 max_x = vertices.data[0].x;
+        F64 max_y = vertices.data[0].y;
+        tri.min_x = max_x;
+        tri.min_y = max_y;
+        for (U32 i = 1; i < outer_count; ++i)
+        {
+            tri.min_x = Min(tri.min_x, vertices.data[i].x);
+            tri.min_y = Min(tri.min_y, vertices.data[i].y);
+            max_x = Max(max_x, vertices.data[i].x);
+            max_y = Max(max_y, vertices.data[i].y);
+        }
+        // ~mgj: z-order coordinates use 15 bits per axis
+        F64 size = Max(max_x - tri.min_x, max_y - tri.min_y);
+        tri.inv_size = size != 0.0 ? 32767.0 / size : 0.0;
+    }
+
+    _tri_earcut_linked(&tri, outer, 0);
+    tri.indices.size = tri.index_count;
+    return tri.indices;
+}
+
+} // namespace city
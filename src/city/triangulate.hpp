@@ -0,0 +1,21 @@
+#pragma once
+
+#include <algorithm>
+
+namespace city
+{
+
+// ~mgj: Polygon triangulation by ear clipping over a doubly linked vertex ring, after mapbox/earcut.
+// Inner rings are bridged into the outer ring first, so a polygon with holes is clipped as one ring.
+// Above TRIANGULATE_HASH_VERTEX_MIN vertices the ring is also linked in z-order, so an ear test only
+// looks at the vertices inside the ear's bounding box instead of the whole ring.
+const U32 TRIANGULATE_HASH_VERTEX_MIN = 80;
+
+// ~mgj: vertices holds the outer ring followed by the inner rings, none of them closed (first vertex
+// not repeated). hole_starts[i] is the first vertex of inner ring i. Rings may have either winding.
+// Returns indices into vertices, three per triangle, with clockwise winding. Degenerate input yields
+// fewer triangles rather than an error.
+g_internal Buffer<U32>
+polygon_triangulate(Arena* arena, Buffer<Vec2F64> vertices, Buffer<U32> hole_starts);
+
+} // namespace city
@@ -52,16 +52,17 @@ draw_flush()
     DrawFrame* frame = draw_frame_get();
     for (RoadIntersectionNode* node = frame->road_intersection_list.first; node; node = node->next)
     {
-        render::road_intersection_compute_add(node->vertex_buffer_handle, node->index_buffer_handle, node->road_segment_buffer_handle, node->road_segment_node_buffer_handle, node->overlay_option);
+        render::road_intersection_compute_add(node->vertex_buffer_handle, node->index_buffer_handle, node->road_segment_buffer_handle, node->road_segment_node_buffer_handle,
+                                              node->triangle_segment_buffer_handle, node->overlay_option, node->mode);
     }
 }
 
 g_internal bool
 draw_road_intersection_compute(render::Handle vertex_buffer_handle, render::Handle index_buffer_handle, render::Handle road_segment_buffer_handle, render::Handle road_segment_node_buffer_handle,
-                               U32 overlay_option)
+                               render::Handle triangle_segment_buffer_handle, U32 overlay_option, render::RoadIntersectionMode mode)
 {
     if (!render::is_resource_loaded(vertex_buffer_handle) || !render::is_resource_loaded(index_buffer_handle) || !render::is_resource_loaded(road_segment_buffer_handle) ||
-        !render::is_resource_loaded(road_segment_node_buffer_handle))
+        !render::is_resource_loaded(road_segment_node_buffer_handle) || !render::is_resource_loaded(triangle_segment_buffer_handle))
     {
         return false;
     }
@@ -72,7 +73,9 @@ draw_road_intersection_compute(render::Handle vertex_buffer_handle, render::Hand
     node->index_buffer_handle = index_buffer_handle;
     node->road_segment_buffer_handle = road_segment_buffer_handle;
     node->road_segment_node_buffer_handle = road_segment_node_buffer_handle;
+    node->triangle_segment_buffer_handle = triangle_segment_buffer_handle;
     node->overlay_option = overlay_option;
+    node->mode = mode;
     SLLQueuePush(frame->road_intersection_list.first, frame->road_intersection_list.last, node);
 
     return true;
@@ -35,7 +35,9 @@ struct RoadIntersectionNode
     render::Handle index_buffer_handle;
     render::Handle road_segment_buffer_handle;
     render::Handle road_segment_node_buffer_handle;
+    render::Handle triangle_segment_buffer_handle;
     U32 overlay_option;
+    render::RoadIntersectionMode mode;
 };
 
 struct RoadIntersectionList
@@ -88,7 +90,7 @@ g_internal void
 draw_blend_3d(render::Blend3DPipelineData pipeline_input);
 g_internal bool
 draw_road_intersection_compute(render::Handle vertex_buffer_handle, render::Handle index_buffer_handle, render::Handle road_segment_buffer_handle, render::Handle road_segment_node_buffer_handle,
-                               U32 overlay_option);
+                               render::Handle triangle_segment_buffer_handle, U32 overlay_option, render::RoadIntersectionMode mode);
 g_internal CarInstanceDrawResult
 draw_car_instance_render(render::MappedHandle<void> camera_handle, Buffer<render::MeshHandlePair> meshes, Buffer<render::Handle> texture_handles, render::BufferInfo* instance_buffer_info);
 
@@ -115,7 +115,7 @@ dt_imgui_setup(vulkan::Context* vk_ctx, io::IO* io_ctx)
 }
 
 g_internal void
-imgui_debug_window(city::City* city, async::ThreadPool* thread_pool)
+imgui_debug_window(city::City* city, async::ThreadPool* thread_pool, city::AgentIngest* agent_ingest)
 {
     Context* ctx = dt_ctx_get();
     ui::Camera* camera = resource_pool_item_from_idx(ctx->camera_container, city->camera_handle);
@@ -141,6 +141,14 @@ imgui_debug_window(city::City* city, async::ThreadPool* thread_pool)
     {
         ImGui::Text("Tileset Renderer Show: %d active", tileset->tiles_to_show_count);
         ImGui::Text("Tileset Renderer Free List Count: %d", tileset->tiles_to_free_stack_count);
+        if (tileset->view_jump_us != 0)
+        {
+            ImGui::Text("Time to full view: loading %.0f ms", (F64)(os_now_microseconds() - tileset->view_jump_us) / 1000.0);
+        }
+        else
+        {
+            ImGui::Text("Time to full view: %.0f ms", tileset->view_full_ms);
+        }
     }
 
     // netascore status
@@ -165,6 +173,18 @@ imgui_debug_window(city::City* city, async::ThreadPool* thread_pool)
         ImGui::Text("Waiting...");
     }
 
+    // agent feed
+    city::AgentIngestStats* ingest_stats = &agent_ingest->stats;
+    ImGui::Text("Agent feed: %.0f msg/s, %u msgs (%u binary, %u failed), %llu coords -> %llu agents, parse %llu us", ingest_stats->messages_per_sec, ingest_stats->message_count,
+                ingest_stats->wire_message_count, ingest_stats->failed_message_count, ingest_stats->coord_count, ingest_stats->agent_count, ingest_stats->parse_us);
+    if (city->car_sim.agents)
+    {
+        city::AgentStore* agents = city->car_sim.agents;
+        city::AgentStoreStats* store_stats = &agents->stats;
+        ImGui::Text("Agent motion: %u agents, %u samples, feed latency %.1f ms, dead reckoning error %.2f m mean, %.2f m max", agents->count, store_stats->sample_count,
+                    (F64)store_stats->feed_latency_us / 1000.0, store_stats->dead_reckoning_error_mean_m, store_stats->dead_reckoning_error_max_m);
+    }
+
     // camera location
     ImGui::Text("Camera Position: %.2f, %.2f, %.2f", camera->position.x, camera->position.y, camera->position.z);
 
@@ -189,6 +209,137 @@ imgui_debug_window(city::City* city, async::ThreadPool* thread_pool)
     ImGui::End();
 }
 
+g_internal void
+imgui_thread_pool_window(async::ThreadPool* thread_pool)
+{
+    // ~mgj: a named task waiting longer than a frame at p99 is starved, highlight it
+    const U64 starved_wait_us = 16'000;
+    const ImVec4 starved_color = ImVec4(1.0f, 0.4f, 0.3f, 1.0f);
+    ScratchScope scratch = ScratchScope(0, 0);
+    Context* ctx = dt_ctx_get();
+    async::ThreadPoolStatsSnapshot snapshot = async::thread_pool_stats_snapshot(scratch.arena, thread_pool);
+
+    ImGui::Begin("Thread Pool", nullptr, ImGuiWindowFlags_None);
+    ImGui::Text("Pending: %u  In flight: %u  Parked: %u", snapshot.pending_task_count, snapshot.in_flight_count, snapshot.parked_count);
+    ImGui::Text("Background running: %u  Timers fired: %llu", snapshot.background_running_count, snapshot.timer_fire_count);
+    String8 cache_dir = ctx->data_subdirs.data[dt_DataDirType::Cache];
+    if (ImGui::Button("Dump JSON"))
+    {
+        async::thread_pool_stats_dump(thread_pool, str8_path_from_str8_list(scratch.arena, {cache_dir, S("thread_pool_stats.json")}), async::ThreadPoolStatsFormat_Json);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Dump CSV"))
+    {
+        async::thread_pool_stats_dump(thread_pool, str8_path_from_str8_list(scratch.arena, {cache_dir, S("thread_pool_stats.csv")}), async::ThreadPoolStatsFormat_Csv);
+    }
+
+    ImGui::SeparatorText("Lanes");
+    if (ImGui::BeginTable("thread_pool_lanes", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit))
+    {
+        const char* headers[] = {"Lane", "Depth", "Count", "Wait p50 us", "Wait p99 us"};
+        for (const char* header : headers)
+        {
+            ImGui::TableSetupColumn(header);
+        }
+        ImGui::TableHeadersRow();
+        for (async::ThreadPoolLaneStatsSnapshot& lane : snapshot.lanes)
+        {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%.*s", str8_varg(lane.name));
+            ImGui::TableNextColumn();
+            ImGui::Text("%u", lane.queue_depth);
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", lane.wait.count);
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", lane.wait.p50_us);
+            ImGui::TableNextColumn();
+            if (lane.wait.p99_us > starved_wait_us)
+            {
+                ImGui::TextColored(starved_color, "%llu", lane.wait.p99_us);
+            }
+            else
+            {
+                ImGui::Text("%llu", lane.wait.p99_us);
+            }
+        }
+        ImGui::EndTable();
+    }
+
+    ImGui::SeparatorText("Workers");
+    if (ImGui::BeginTable("thread_pool_workers", 9, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit))
+    {
+        const char* headers[] = {"Worker", "Depth", "Tasks", "Steals", "Steal misses", "Wakes", "Busy ms", "Wait p99 us", "Run p99 us"};
+        for (const char* header : headers)
+        {
+            ImGui::TableSetupColumn(header);
+        }
+        ImGui::TableHeadersRow();
+        for (async::ThreadPoolWorkerStatsSnapshot& worker : snapshot.workers)
+        {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%u%s", worker.thread_id, worker.is_parked ? " (parked)" : "");
+            ImGui::TableNextColumn();
+            ImGui::Text("%u", worker.local_queue_depth);
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", worker.task_count);
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", worker.steal_count);
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", worker.steal_miss_count);
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu / %llu", worker.wake_count, worker.park_count);
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", worker.busy_us / 1000);
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", worker.wait.p99_us);
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", worker.run.p99_us);
+        }
+        ImGui::EndTable();
+    }
+
+    ImGui::SeparatorText("Tasks");
+    if (ImGui::BeginTable("thread_pool_tasks", 7, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit))
+    {
+        const char* headers[] = {"Name", "Count", "Wait p50 us", "Wait p99 us", "Wait max us", "Run p50 us", "Run p99 us"};
+        for (const char* header : headers)
+        {
+            ImGui::TableSetupColumn(header);
+        }
+        ImGui::TableHeadersRow();
+        for (async::ThreadPoolTaskStatsSnapshot& task : snapshot.tasks)
+        {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%.*s", str8_varg(task.name));
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", task.run.count);
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", task.wait.p50_us);
+            ImGui::TableNextColumn();
+            if (task.wait.p99_us > starved_wait_us)
+            {
+                ImGui::TextColored(starved_color, "%llu", task.wait.p99_us);
+            }
+            else
+            {
+                ImGui::Text("%llu", task.wait.p99_us);
+            }
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", task.wait.max_us);
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", task.run.p50_us);
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", task.run.p99_us);
+        }
+        ImGui::EndTable();
+    }
+
+    ImGui::End();
+}
+
 static void
 dt_main_loop(void* ptr)
 {
@@ -241,11 +392,13 @@ dt_main_loop(void* ptr)
         ////////////////////////////////////////////////////////
     }
 
-    async::WebsocketConnection ws_task_result = async::async_websocket_start(S("ws://127.0.0.1:8080/ws"));
+    // ~mgj: binary frames when the publisher speaks them, the ingest takes either on the same connection
+    async::WebsocketConnection ws_task_result = async::async_websocket_start(S("ws://127.0.0.1:8080/ws"), S(AGENT_WIRE_SUBPROTOCOL ", " AGENT_WIRE_JSON_SUBPROTOCOL));
     if (ws_task_result.has_error())
     {
         ERROR_LOG("Error from websocket");
     }
+    city::AgentIngest* agent_ingest = city::agent_ingest_create();
 
     city::RoadOverlayOption neta_overlay_option = city::RoadOverlayOption_None;
     S32 cur_area_option = 0;
@@ -257,6 +410,8 @@ dt_main_loop(void* ptr)
     city_area_streaming_begin(ctx->thread_pool, area, area_config);
     while (ctx->running)
     {
+        // ~mgj: work the frame pushes without a lane of its own is what the frame waits on
+        async::ThreadPoolPriorityScope frame_priority = async::ThreadPoolPriorityScope(async::ThreadPoolPriority_Interactive);
         dt_time_update(ctx->io, ctx->time);
 
         arena_clear(dt_ctx_get()->arena_frame);
@@ -267,7 +422,7 @@ dt_main_loop(void* ptr)
         async::thread_pool_main_thread_queue_drain(ctx->thread_pool);
 
         String8List ws_msgs = ws_task_result.read(ctx->arena_frame);
-        Buffer<city::Coordinate> new_agent_coords = city::city_latest_coordinates_buffer_from_str8_list(ctx->arena_frame, &ws_msgs);
+        Buffer<city::Coordinate> new_agent_coords = city::agent_ingest_run(agent_ingest, ctx->arena_frame, &ws_msgs, os_now_unix_microseconds());
         Vec2U32 framebuffer_dim = {(U32)io_ctx->framebuffer_width, (U32)io_ctx->framebuffer_height};
 
         ImGui::Begin("Interaction", nullptr);
@@ -290,6 +445,24 @@ dt_main_loop(void* ptr)
         city::City* selected_city = city_buf[area_option];
         ImGui::SliderFloat("Scale", &selected_city->agent_scale_factor, 0.01f, 1.0f, "%.3f");
 
+        ImGui::SeparatorText("Agent Motion");
+        city::AgentMotionConfig* agent_motion = &selected_city->agent_motion;
+        for (U32 i = 0; i < city::AgentMotionInterp_Count; i++)
+        {
+            ImGui::RadioButton(city::agent_motion_interp_strs[i], (int*)&agent_motion->interp, (int)i);
+        }
+        int playback_delay_ms = (int)(agent_motion->playback_delay_us / 1000);
+        if (ImGui::SliderInt("Playback delay (ms)", &playback_delay_ms, 0, 1000))
+        {
+            agent_motion->playback_delay_us = (U64)playback_delay_ms * 1000;
+        }
+        int max_extrapolation_ms = (int)(agent_motion->max_extrapolation_us / 1000);
+        if (ImGui::SliderInt("Max extrapolation (ms)", &max_extrapolation_ms, 0, 2000))
+        {
+            agent_motion->max_extrapolation_us = (U64)max_extrapolation_ms * 1000;
+        }
+        ImGui::SliderFloat("Road snap (m)", &selected_city->agent_road_snap_distance, 0.0f, 50.0f, "%.1f");
+
         ImGui::End();
 
         if (cur_area_option != area_option)
@@ -326,8 +499,10 @@ dt_main_loop(void* ptr)
         city::city_update(area, new_agent_coords, ctx->thread_pool, neta_overlay_option, framebuffer_dim, area_config);
 
         // #if BUILD_DEBUG
-        imgui_debug_window(area, ctx->thread_pool);
+        imgui_debug_window(area, ctx->thread_pool, agent_ingest);
+        imgui_thread_pool_window(ctx->thread_pool);
         // #endif
+        async::thread_pool_stats_plot(ctx->thread_pool);
 
         /////////////////////////////////////
 
@@ -354,6 +529,7 @@ dt_main_loop(void* ptr)
     {
         city::city_release(city_buf[i]);
     }
+    city::agent_ingest_release(agent_ingest);
     render::gpu_work_done_wait();
     draw::draw_release();
     render::render_ctx_destroy();
@@ -39,6 +39,7 @@ struct Context
     ArrayResourcePool<cesium::TilesetRenderer>* tileset_pool;
 
     async::ThreadPool* thread_pool;
+    async::HttpEngine* http_engine;
 };
 
 // ~mgj: Globals
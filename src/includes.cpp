@@ -12,7 +12,9 @@ DISABLE_WARNINGS_POP
 #include "render/render_inc.cpp"
 #include "draw/draw.cpp"
 #include "misc/misc_inc.cpp"
+#include "osm/osm_elements.cpp"
 #include "osm/osm.cpp"
+#include "osm/osm_snapshot.cpp"
 #include "city/city_inc.cpp"
 #include "cesium/cesium_tileset.cpp"
 #include "entrypoint.cpp"
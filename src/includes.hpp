@@ -50,9 +50,11 @@ DISABLE_WARNINGS_POP
 #include "render/render_inc.hpp"
 #include "draw/draw.hpp"
 #include "misc/misc_inc.hpp"
+#include "osm/osm_elements.hpp"
 #include "lib_wrappers/lib_wrappers_inc.hpp"
 #include "gltfw/gltfw.hpp"
 #include "osm/osm.hpp"
+#include "osm/osm_snapshot.hpp"
 #include "cesium/cesium_tileset.hpp"
 #include "city/city_inc.hpp"
 #include "entrypoint.hpp"
@@ -1,178 +1,311 @@
 namespace wrapper
 {
 
-static osm::RoadNodeParseResult
-node_buffer_from_simd_json(Arena* arena, String8 json, U64 node_hashmap_size)
+enum class _OsmElementType : U32
 {
-    prof_scope_marker;
-    simdjson::ondemand::parser parser;
-    simdjson::ondemand::document doc;
-    simdjson::padded_string json_padded((char*)json.str, json.size);
-    simdjson::error_code error = parser.iterate(json_padded).get(doc);
-    U32 error_num = 0;
-    bool error_ret = false;
+    Unknown,
+    Node,
+    Way,
+};
+
+static _OsmElementType
+_osm_element_type_from_str(std::string_view type)
+{
+    if (type == "node")
+    {
+        return _OsmElementType::Node;
+    }
+    if (type == "way")
+    {
+        return _OsmElementType::Way;
+    }
+    return _OsmElementType::Unknown;
+}
+
+static String8
+json_padded_from_file(Arena* arena, String8 path)
+{
+    OS_Handle file = os_file_open(OS_AccessFlag_Read | OS_AccessFlag_ShareRead, path);
+    FileProperties props = os_properties_from_file(file);
+    U8* data = PushArrayNoZero(arena, U8, props.size + simdjson::SIMDJSON_PADDING);
+    U64 read_size = os_file_read(file, r1u64(0, props.size), data);
+    MemoryZero(data + read_size, simdjson::SIMDJSON_PADDING);
+    os_file_close(file);
+    return str8(data, read_size);
+}
+
+static String8
+json_padded_copy(Arena* arena, String8 json)
+{
+    U8* data = PushArrayNoZero(arena, U8, json.size + simdjson::SIMDJSON_PADDING);
+    MemoryCopy(data, json.str, json.size);
+    MemoryZero(data + json.size, simdjson::SIMDJSON_PADDING);
+    return str8(data, json.size);
+}
 
-    Buffer<osm::RoadNodeList> nodes = {};
+// ~mgj: Counting walk. Node references and tags are counted for every element (not only ways)
+// so the fill walk can never run past the end of the flat arrays.
+static simdjson::error_code
+_osm_element_count(simdjson::ondemand::document& doc, osm::ElementStore* store)
+{
+    prof_scope_marker;
+    simdjson::ondemand::array elements;
+    simdjson::error_code error = doc["elements"].get_array().get(elements);
     if (error)
     {
-        goto early_ret;
+        return error;
     }
 
-    nodes = buffer_alloc<osm::RoadNodeList>(arena, node_hashmap_size);
+    for (auto element_result : elements)
     {
-        simdjson::ondemand::array elements;
-        error = doc["elements"].get(elements);
+        simdjson::ondemand::object element;
+        error = element_result.get_object().get(element);
         if (error)
         {
-            goto early_ret;
+            return error;
         }
 
-        for (auto item : elements)
+        _OsmElementType type = _OsmElementType::Unknown;
+        for (auto field_result : element)
         {
-            auto item_object = item.get_object();
-            std::string_view node_key;
-            error = item_object.find_field("type").get(node_key);
+            simdjson::ondemand::field field;
+            std::string_view key;
+            error = std::move(field_result).get(field);
+            if (!error)
+            {
+                error = field.unescaped_key().get(key);
+            }
             if (error)
             {
-                goto early_ret;
+                return error;
             }
 
-            if (node_key == "node")
+            size_t count = 0;
+            if (key == "type")
             {
-                osm::WgsNode* node = PushStruct(arena, osm::WgsNode);
-                U64 id;
-                F64 lat, lon;
-                auto item_value = item.value();
-                error_num |= item_value["id"].get(id);
-                error_num |= item_value["lat"].get_double().get(lat);
-                error_num |= item_value["lon"].get_double().get(lon);
-                if (error_num)
-                {
-                    goto early_ret;
-                }
-                node->id = id;
-                node->lat = lat;
-                node->lon = lon;
-
-                U64 node_slot = node->id % node_hashmap_size;
-                SLLQueuePush(nodes.data[node_slot].first, nodes.data[node_slot].last, node);
+                std::string_view type_str;
+                error = field.value().get_string().get(type_str);
+                type = _osm_element_type_from_str(type_str);
+            }
+            else if (key == "nodes")
+            {
+                error = field.value().count_elements().get(count);
+                store->ways.node_ref_count += count;
+            }
+            else if (key == "tags")
+            {
+                error = field.value().count_fields().get(count);
+                store->ways.tag_count += count;
+            }
+            if (error)
+            {
+                return error;
             }
         }
+
+        if (type == _OsmElementType::Node)
+        {
+            store->nodes.count += 1;
+        }
+        else if (type == _OsmElementType::Way)
+        {
+            store->ways.count += 1;
+        }
     }
-early_ret:
-    if (error || error_num)
-    {
-        DEBUG_LOG("Error in node buffer parsing\n");
-        error_ret = true;
-    }
-    osm::RoadNodeParseResult res = {nodes, error_ret};
-    return res;
+    return simdjson::SUCCESS;
 }
 
-static osm::WayParseResult
-way_buffer_from_simd_json(Arena* arena, String8 json)
+static simdjson::error_code
+_osm_element_store_fill(simdjson::ondemand::document& doc, osm::ElementStore* store)
 {
-    simdjson::dom::parser parser;
-    simdjson::dom::array elements;
-    simdjson::padded_string json_padded((char*)json.str, json.size);
-    auto error = parser.parse(json_padded).get_object()["elements"].get(elements);
-    U32 error_num = 0;
-    bool error_ret = false;
-
-    Buffer<osm::Way> way_buffer = {};
-    U64 way_index = 0;
-    U64 way_count = 0;
+    prof_scope_marker;
+    osm::NodeColumns* nodes = &store->nodes;
+    osm::WayColumns* ways = &store->ways;
+    U64 node_idx = 0;
+    U64 way_idx = 0;
+    U64 node_ref_idx = 0;
+    U64 tag_idx = 0;
 
+    simdjson::ondemand::array elements;
+    simdjson::error_code error = doc["elements"].get_array().get(elements);
     if (error)
     {
-        goto early_ret;
+        return error;
     }
 
-    for (auto item : elements)
+    for (auto element_result : elements)
     {
-        std::string_view node_key;
-        error = item.get_object().at_key("type").get(node_key);
+        simdjson::ondemand::object element;
+        error = element_result.get_object().get(element);
         if (error)
         {
-            goto early_ret;
-        }
-        if (node_key == "way")
-        {
-            way_count += 1;
+            return error;
         }
-    }
 
-    way_buffer = buffer_alloc<osm::Way>(arena, way_count);
-    for (auto elem : elements)
-    {
-        std::string_view elem_key;
-        error = elem.get_object()["type"].get(elem_key);
-        if (error)
-        {
-            goto early_ret;
-        }
-        if (elem_key == "way")
+        _OsmElementType type = _OsmElementType::Unknown;
+        U64 id = 0;
+        F64 lat = 0.0;
+        F64 lon = 0.0;
+        osm::ElementSpan node_span = {.offset = node_ref_idx, .count = 0};
+        osm::ElementSpan tag_span = {.offset = tag_idx, .count = 0};
+        for (auto field_result : element)
         {
-            // ~mgj: Insert into hashmap
-            U64 way_id = elem["id"].get_uint64();
-            osm::Way* way = &way_buffer.data[way_index];
-
-            way->id = way_id;
-            // Get the nodes array and count elements
-            auto nodes_array = elem["nodes"].get_array();
-            way->node_count = nodes_array.size();
-
-            way->node_ids = PushArray(arena, U64, way->node_count);
-            U32 node_index = 0;
-            for (auto node_id : nodes_array)
+            simdjson::ondemand::field field;
+            std::string_view key;
+            error = std::move(field_result).get(field);
+            if (!error)
             {
-                way->node_ids[node_index] = node_id.get_uint64();
-                node_index++;
+                error = field.unescaped_key().get(key);
             }
-
-            // Count tags by iterating through the object
-            auto tags_object = elem["tags"].get_object();
-            U64 tag_count = 0;
-            for (auto _ : tags_object)
+            if (error)
             {
-                (void)_;
-                tag_count++;
+                return error;
             }
 
-            // Reset and iterate again to store the tags
-            tags_object = elem["tags"].get_object();
-            way->tags = buffer_alloc<osm::Tag>(arena, tag_count);
-            U64 tag_cur_index = 0;
-            for (auto tag : tags_object)
+            if (key == "type")
+            {
+                std::string_view type_str;
+                error = field.value().get_string().get(type_str);
+                type = _osm_element_type_from_str(type_str);
+            }
+            else if (key == "id")
+            {
+                error = field.value().get_uint64().get(id);
+            }
+            else if (key == "lat")
+            {
+                error = field.value().get_double().get(lat);
+            }
+            else if (key == "lon")
+            {
+                error = field.value().get_double().get(lon);
+            }
+            else if (key == "nodes")
+            {
+                simdjson::ondemand::array node_refs;
+                error = field.value().get_array().get(node_refs);
+                if (!error)
+                {
+                    for (auto node_ref : node_refs)
+                    {
+                        Assert(node_ref_idx < ways->node_ref_count);
+                        error = node_ref.get_uint64().get(ways->node_refs[node_ref_idx++]);
+                        if (error)
+                        {
+                            break;
+                        }
+                    }
+                }
+            }
+            else if (key == "tags")
+            {
+                simdjson::ondemand::object tags;
+                error = field.value().get_object().get(tags);
+                if (!error)
+                {
+                    for (auto tag_result : tags)
+                    {
+                        simdjson::ondemand::field tag;
+                        std::string_view tag_key;
+                        std::string_view tag_value;
+                        error = std::move(tag_result).get(tag);
+                        if (!error)
+                        {
+                            error = tag.unescaped_key().get(tag_key);
+                        }
+                        if (!error)
+                        {
+                            error = tag.value().get_string().get(tag_value);
+                        }
+                        if (error)
+                        {
+                            break;
+                        }
+                        Assert(tag_idx < ways->tag_count);
+                        // ~mgj: the interner copies, so the parser's string buffer can be reused right away
+                        ways->tag_keys[tag_idx] = osm::str_id_from_str8(str8((U8*)tag_key.data(), tag_key.size()));
+                        ways->tag_values[tag_idx] = osm::str_id_from_str8(str8((U8*)tag_value.data(), tag_value.size()));
+                        tag_idx += 1;
+                    }
+                }
+            }
+            if (error)
             {
-                // Get key and value as string_view
+                return error;
+            }
+        }
 
-                auto key_view = tag.key;
-                auto value_view = tag.value.get_string();
+        if (type == _OsmElementType::Node)
+        {
+            Assert(node_idx < nodes->count);
+            nodes->ids[node_idx] = id;
+            nodes->lat[node_idx] = lat;
+            nodes->lon[node_idx] = lon;
+            node_idx += 1;
+        }
+        else if (type == _OsmElementType::Way)
+        {
+            Assert(way_idx < ways->count);
+            node_span.count = node_ref_idx - node_span.offset;
+            tag_span.count = tag_idx - tag_span.offset;
+            ways->ids[way_idx] = (osm::WayId)id;
+            ways->node_spans[way_idx] = node_span;
+            ways->tag_spans[way_idx] = tag_span;
+            way_idx += 1;
+        }
+        else
+        {
+            // ~mgj: relations etc. are not stored, give their slots back
+            node_ref_idx = node_span.offset;
+            tag_idx = tag_span.offset;
+        }
+    }
 
-                // Convert to String8
-                String8 temp_key = str8((U8*)key_view.data(), key_view.size());
-                String8 temp_value = str8((U8*)value_view.value().data(), value_view.value().size());
+    ways->node_ref_count = node_ref_idx;
+    ways->tag_count = tag_idx;
+    return simdjson::SUCCESS;
+}
 
-                // Copy to arena
-                way->tags.data[tag_cur_index].key = push_str8_copy(arena, temp_key);
-                way->tags.data[tag_cur_index].value = push_str8_copy(arena, temp_value);
+static Result<osm::ElementStore>
+osm_element_store_from_simd_json(Arena* arena, String8 json)
+{
+    prof_scope_marker;
+    osm::ElementStore store = {};
+    simdjson::ondemand::parser parser;
+    simdjson::ondemand::document doc;
+    simdjson::padded_string_view json_view((const char*)json.str, json.size, json.size + simdjson::SIMDJSON_PADDING);
 
-                tag_cur_index++;
-            }
+    // ~mgj: stage 1 (structural indexing) runs once, both walks below reuse it through rewind
+    simdjson::error_code error = parser.iterate(json_view).get(doc);
+    if (!error)
+    {
+        error = _osm_element_count(doc, &store);
+    }
+    if (!error)
+    {
+        osm::NodeColumns* nodes = &store.nodes;
+        osm::WayColumns* ways = &store.ways;
+        nodes->ids = PushArrayNoZero(arena, osm::NodeId, nodes->count);
+        nodes->lat = PushArrayNoZero(arena, F64, nodes->count);
+        nodes->lon = PushArrayNoZero(arena, F64, nodes->count);
+        ways->ids = PushArrayNoZero(arena, osm::WayId, ways->count);
+        ways->node_spans = PushArrayNoZero(arena, osm::ElementSpan, ways->count);
+        ways->tag_spans = PushArrayNoZero(arena, osm::ElementSpan, ways->count);
+        ways->node_refs = PushArrayNoZero(arena, osm::NodeId, ways->node_ref_count);
+        ways->tag_keys = PushArrayNoZero(arena, osm::StrId, ways->tag_count);
+        ways->tag_values = PushArrayNoZero(arena, osm::StrId, ways->tag_count);
 
-            way_index++;
-        }
+        doc.rewind();
+        error = _osm_element_store_fill(doc, &store);
     }
-early_ret:
-    if (error || error_num)
+    if (error)
     {
-        DEBUG_LOG("Error in way buffer parsing\n");
-        error_ret = true;
+        DEBUG_LOG("Error in osm element parsing: %s\n", simdjson::error_message(error));
+        return result_not_ok(osm::ElementStore{});
     }
 
-    osm::WayParseResult res = {way_buffer, error_ret};
-    return res;
+    osm::element_store_nodes_sort(&store.nodes);
+    return result_ok(store);
 }
 
 } // namespace wrapper
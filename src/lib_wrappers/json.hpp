@@ -2,16 +2,19 @@
 
 namespace osm
 {
-struct RoadNodeList;
-struct Way;
-struct RoadNodeParseResult;
-struct WayParseResult;
+struct ElementStore;
 } // namespace osm
 
 namespace wrapper
 {
-static osm::RoadNodeParseResult
-node_buffer_from_simd_json(Arena* arena, String8 json, U64 node_hashmap_size);
-static osm::WayParseResult
-way_buffer_from_simd_json(Arena* arena, String8 json);
+// ~mgj: simdjson reads up to simdjson::SIMDJSON_PADDING bytes past the end of the input. Buffers returned
+// from these functions reserve (and zero) that padding so they can be parsed in place.
+static String8
+json_padded_from_file(Arena* arena, String8 path);
+static String8
+json_padded_copy(Arena* arena, String8 json);
+
+// ~mgj: json must come from one of the json_padded_* functions above or be an async::HttpBody
+static Result<osm::ElementStore>
+osm_element_store_from_simd_json(Arena* arena, String8 json);
 }; // namespace wrapper
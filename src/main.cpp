@@ -46,6 +46,9 @@ ctx_create(io::IO* io_ctx)
     U32 queue_size = 100; // TODO: should be increased
     U32 main_thread_queue_size = 10;
     ctx->thread_pool = async::thread_pool_create(app_arena, thread_count, queue_size, main_thread_queue_size);
+    async::HttpEngineConfig http_engine_config = {};
+    ctx->http_engine = async::http_engine_create(&http_engine_config);
+    async::http_engine_global_set(ctx->http_engine);
 
     return ctx;
 }
@@ -53,6 +56,8 @@ ctx_create(io::IO* io_ctx)
 static void
 ctx_destroy(Context* ctx)
 {
+    async::http_engine_global_set(0);
+    async::http_engine_destroy(ctx->http_engine);
     async::thread_pool_destroy(ctx->thread_pool);
     resource_pool_release(ctx->camera_container);
     arena_release(ctx->arena_main_permanent);
@@ -175,6 +175,18 @@ os_get_process_start_time_unix()
     return (U32)start_time;
 }
 
+lib_internal U64
+os_get_process_peak_memory_bytes()
+{
+    struct rusage usage = {};
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return 0;
+    }
+    // ~mgj: ru_maxrss is reported in kilobytes on linux
+    return (U64)usage.ru_maxrss * KB(1);
+}
+
 ////////////////////////////////
 //~ rjf: @os_hooks Memory Allocation (Implemented Per-OS)
 
@@ -768,6 +780,15 @@ os_now_unix()
     return (U32)t;
 }
 
+lib_internal U64
+os_now_unix_microseconds()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_REALTIME, &t);
+    U64 result = t.tv_sec * Million(1) + (t.tv_nsec / Thousand(1));
+    return result;
+}
+
 lib_internal DateTime
 os_now_universal_time()
 {
@@ -1016,7 +1037,12 @@ lib_internal OS_Handle
 os_condition_variable_alloc()
 {
     OS_LNX_Entity* entity = os_lnx_entity_alloc(OS_LNX_EntityKind_ConditionVariable);
-    int init_result = pthread_cond_init(&entity->cv.cond_handle, 0);
+    // ~mgj: the wait deadlines are os_now_microseconds() times, which read CLOCK_MONOTONIC
+    pthread_condattr_t cond_attr;
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+    int init_result = pthread_cond_init(&entity->cv.cond_handle, &cond_attr);
+    pthread_condattr_destroy(&cond_attr);
     if (init_result == -1)
     {
         os_lnx_entity_release(entity);
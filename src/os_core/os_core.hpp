@@ -188,6 +188,8 @@ lib_internal String8
 os_current_path_get(Arena* arena);
 lib_internal U32
 os_get_process_start_time_unix();
+lib_internal U64
+os_get_process_peak_memory_bytes();
 lib_internal inline String8
 os_path_delimiter();
 
@@ -307,6 +309,8 @@ lib_internal U64
 os_now_microseconds();
 lib_internal U32
 os_now_unix();
+lib_internal U64
+os_now_unix_microseconds();
 lib_internal DateTime
 os_now_universal_time();
 lib_internal DateTime
@@ -199,6 +199,17 @@ os_get_process_start_time_unix()
     return 0;
 }
 
+lib_internal U64
+os_get_process_peak_memory_bytes()
+{
+    PROCESS_MEMORY_COUNTERS counters = {};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        return (U64)counters.PeakWorkingSetSize;
+    }
+    return 0;
+}
+
 lib_internal inline String8
 os_path_delimiter()
 {
@@ -1002,6 +1013,16 @@ os_now_unix()
     return unix_time;
 }
 
+lib_internal U64
+os_now_unix_microseconds()
+{
+    FILETIME file_time;
+    GetSystemTimePreciseAsFileTime(&file_time);
+    U64 win32_time = ((U64)file_time.dwHighDateTime << 32) | file_time.dwLowDateTime;
+    U64 result = (win32_time - 0x19DB1DED53E8000ULL) / 10;
+    return result;
+}
+
 lib_internal DateTime
 os_now_universal_time()
 {
@@ -13,6 +13,7 @@
 #include <Shlobj.h>
 #include <shellapi.h>
 #include <processthreadsapi.h>
+#include <psapi.h>
 #pragma comment(lib, "user32")
 #pragma comment(lib, "winmm")
 #pragma comment(lib, "shell32")
@@ -21,6 +22,7 @@
 #pragma comment(lib, "shlwapi")
 #pragma comment(lib, "comctl32")
 #pragma comment(lib, "gdi32")
+#pragma comment(lib, "psapi")
 
 #pragma comment(                                                                                                                                                                                       \
     linker,                                                                                                                                                                                            \
@@ -1,120 +1,398 @@
 namespace osm
 {
 g_internal Network*
-osm_init(U64 node_hashmap_size, U64 way_hashmap_size, String8 cache_path, String8 area, String8 bbox_cache_str)
+osm_init(String8 cache_path, String8 area, String8 bbox_cache_str)
 {
     Arena* arena = arena_alloc();
     Debug_SetName(arena, "OSM network arena");
-    Buffer<NodeList> node_hashmap = buffer_alloc<NodeList>(arena, node_hashmap_size);
-    Buffer<WayList> way_hashmap = buffer_alloc<WayList>(arena, way_hashmap_size);
-    Map<NodeId, EcefLocation>* ecef_location_map = map_create<NodeId, EcefLocation>(arena, node_hashmap_size);
-    Map<NodeId, WgsLocation>* wgs_location_map = map_create<NodeId, WgsLocation>(arena, node_hashmap_size);
 
     Network* network = PushStruct(arena, Network);
     network->cache_file_location = str8_path_from_str8_list(arena, {cache_path, area, S("osm_data.json")});
+    network->snapshot_file_location = str8_path_from_str8_list(arena, {cache_path, area, S("osm_data.snapshot")});
     network->bbox_cache_str = push_str8_copy(arena, bbox_cache_str);
     network->arena = arena;
-    network->node_hashmap = node_hashmap;
-    network->ecef_location_map = ecef_location_map;
-    network->wgs_location_map = wgs_location_map;
-    network->way_hashmap = way_hashmap;
     return network;
 }
 
 g_internal void
 osm_release(Network* osm_network)
 {
+    snapshot_close(osm_network);
     arena_release(osm_network->arena);
 }
 
 g_internal void
 structure_cleanup(Network* network)
 {
+    snapshot_close(network);
     arena_release(network->arena);
 }
 
-g_internal async::UserFuncResult<osm::Network>
-fetch_osm_data_and_parse(Arena* arena, async::ThreadPool* thread_pool, String8 response_body, osm::Network* osm_network)
+static_assert(async::HTTP_BODY_PADDING >= simdjson::SIMDJSON_PADDING, "http bodies are parsed in place");
+
+g_internal async::CoTask<B32>
+fetch_osm_data_and_parse(Arena* arena, osm::Network* osm_network)
+{
+    const U32 http_retries = 3;
+    async::HttpResponse response = co_await async::co_http_download(osm_network->overpass_http_info, http_retries);
+    if (response.error.has_error())
+    {
+        ERROR_LOG("Overpass request failed, http code %u", response.http_code);
+        co_return false;
+    }
+
+    async::ThreadPool* thread_pool = co_await async::co_thread_pool();
+    async::CoTask<B32> tasks[] = {_network_from_json_co(arena, thread_pool, osm_network, response.body), _cache_write_co(arena, osm_network, response.body)};
+    co_await async::co_when_all(tasks, ArrayCount(tasks));
+    B32 parsed = async::co_task_result(&tasks[0]);
+    for (async::CoTask<B32>& task : tasks)
+    {
+        task = async::CoTask<B32>();
+    }
+    async::http_response_release(&response);
+
+    if (parsed)
+    {
+        snapshot_write(osm_network);
+    }
+    co_return parsed;
+}
+
+g_internal async::CoTask<B32>
+_network_from_json_co(Arena* arena, async::ThreadPool* thread_pool, Network* network, String8 json_padded)
 {
     (void)arena;
-    (void)thread_pool;
-    cache_write(osm_network->cache_file_location, response_body, osm_network->bbox_cache_str);
+    co_return !_network_from_json(thread_pool, network, json_padded);
+}
 
-    async::AsyncTaskContinuation<osm::Network> task_continuation = {.func = parse_osm_data};
-    return async::UserFuncResult<osm::Network>::success(task_continuation);
+g_internal async::CoTask<B32>
+_cache_write_co(Arena* arena, Network* network, String8 content)
+{
+    (void)arena;
+    cache_write(network->cache_file_location, content, network->bbox_cache_str);
+    co_return true;
 }
 
 g_internal async::AsyncTaskContinuation<osm::Network>
 parse_osm_data(async::ThreadInfo thread_info, async::AsyncTaskStatus<osm::Network>* task)
 {
-    (void)thread_info;
-    B32 error = _parse_osm_data(task->user_data);
+    B32 error = _parse_osm_data(thread_info.thread_pool, task->user_data);
     task->error.store(error);
     return {};
 }
 
-g_internal Error
-_parse_osm_data(osm::Network* osm_network)
+// ~mgj: Network build pipeline over the element store
+//   1. way ranges in parallel: classify ways by tag key id, resolve node refs to node rows and mark
+//      every referenced row with the types referencing it (atomic or, the concurrent dedupe)
+//   2. way ranges in parallel: write the Way structs of every type at prefix summed offsets
+//   3. node ranges in parallel: ECEF conversion of every referenced node row
+//   4. serial: location maps, node id arrays and the pointer linked Node/Way graph
+struct _NetworkBuildRange
 {
-    ScratchScope scratch = ScratchScope(0, 0);
+    U64 begin;
+    U64 end;
+    U64 way_counts[enum_idx(WayType::Count)];
+    U64 way_offsets[enum_idx(WayType::Count)];
+};
 
-    String8 file_content = os_data_from_file_path(scratch.arena, osm_network->cache_file_location);
-    RoadNodeParseResult node_result = wrapper::node_buffer_from_simd_json(osm_network->arena, file_content, 1000);
-    if (node_result.error)
+struct _NetworkBuild
+{
+    Network* network;
+    U32 way_range_count;
+    _NetworkBuildRange* way_ranges;
+    U32 node_range_count;
+    _NetworkBuildRange* node_ranges;
+
+    U8* way_type_masks; // per way, bit per WayType
+    Vec3F64* node_ecef; // per referenced node row
+    std::atomic<B32> missing_node;
+};
+static_assert(enum_idx(WayType::Count) <= 8, "way type masks are stored in a U8");
+
+g_internal void
+_network_build_classify_task(async::ThreadInfo thread_info, void* data, U32 task_idx)
+{
+    prof_scope_marker;
+    (void)thread_info;
+    _NetworkBuild* build = (_NetworkBuild*)data;
+    _NetworkBuildRange* range = &build->way_ranges[task_idx];
+    NodeColumns* nodes = &build->network->element_store.nodes;
+    WayColumns* ways = &build->network->element_store.ways;
+    for (U64 way_idx = range->begin; way_idx < range->end; ++way_idx)
     {
-        DEBUG_LOG("Error happend when parsing nodes from json");
-        return true;
+        U8 type_mask = 0;
+        TagList tags = element_store_way_tags(ways, way_idx);
+        for (U64 tag_idx = 0; tag_idx < tags.count; ++tag_idx)
+        {
+            for (U32 type_idx = 0; type_idx < enum_idx(WayType::Count); ++type_idx)
+            {
+                type_mask |= (tags.keys[tag_idx] == (StrId)g_waytype_tag_key[type_idx]) << type_idx;
+            }
+        }
+        build->way_type_masks[way_idx] = type_mask;
+        if (type_mask == 0)
+        {
+            continue;
+        }
+
+        for (U32 type_idx = 0; type_idx < enum_idx(WayType::Count); ++type_idx)
+        {
+            range->way_counts[type_idx] += (type_mask >> type_idx) & 1;
+        }
+        ElementSpan span = ways->node_spans[way_idx];
+        for (U64 ref_idx = span.offset; ref_idx < span.offset + span.count; ++ref_idx)
+        {
+            U64 row = element_store_node_idx_find(nodes, ways->node_refs[ref_idx]);
+            if (row == nodes->count)
+            {
+                if (!build->missing_node.exchange(true, std::memory_order_relaxed))
+                {
+                    DEBUG_LOG("Way %lld references node %llu which is missing from the json", ways->ids[way_idx], ways->node_refs[ref_idx]);
+                }
+                continue;
+            }
+            build->network->node_ref_rows[ref_idx] = (U32)row;
+            std::atomic_ref<U8>(build->network->node_type_masks[row]).fetch_or(type_mask, std::memory_order_relaxed);
+        }
     }
-    WayParseResult osm_way_parse_result = wrapper::way_buffer_from_simd_json(osm_network->arena, file_content);
-    if (osm_way_parse_result.error)
+}
+
+g_internal void
+_network_build_ways_fill_task(async::ThreadInfo thread_info, void* data, U32 task_idx)
+{
+    prof_scope_marker;
+    (void)thread_info;
+    _NetworkBuild* build = (_NetworkBuild*)data;
+    _NetworkBuildRange* range = &build->way_ranges[task_idx];
+    WayColumns* ways = &build->network->element_store.ways;
+    for (U64 way_idx = range->begin; way_idx < range->end; ++way_idx)
     {
-        DEBUG_LOG("Error happend when parsing ways from json");
-        return true;
+        U8 type_mask = build->way_type_masks[way_idx];
+        if (type_mask == 0)
+        {
+            continue;
+        }
+        Buffer<NodeId> node_ids = element_store_way_node_ids(ways, way_idx);
+        Way way = {.id = ways->ids[way_idx], .node_ids = node_ids.data, .node_count = node_ids.size, .tags = element_store_way_tags(ways, way_idx)};
+        for (U32 type_idx = 0; type_idx < enum_idx(WayType::Count); ++type_idx)
+        {
+            if ((type_mask >> type_idx) & 1)
+            {
+                build->network->ways_arr[type_idx].data[range->way_offsets[type_idx]++] = way;
+            }
+        }
+    }
+}
+
+g_internal void
+_network_build_ecef_task(async::ThreadInfo thread_info, void* data, U32 task_idx)
+{
+    prof_scope_marker;
+    (void)thread_info;
+    _NetworkBuild* build = (_NetworkBuild*)data;
+    _NetworkBuildRange* range = &build->node_ranges[task_idx];
+    NodeColumns* nodes = &build->network->element_store.nodes;
+    for (U64 row = range->begin; row < range->end; ++row)
+    {
+        if (build->network->node_type_masks[row] == 0)
+        {
+            continue;
+        }
+        CesiumGeospatial::Cartographic cartographic(glm::radians(nodes->lon[row]), glm::radians(nodes->lat[row]), 0);
+        glm::dvec3 coord_ecef = CesiumGeospatial::Ellipsoid::WGS84.cartographicToCartesian(cartographic);
+        build->node_ecef[row] = vec_3f64(coord_ecef.x, coord_ecef.y, coord_ecef.z);
+    }
+}
+
+g_internal _NetworkBuildRange*
+_network_build_ranges_create(Arena* arena, U64 count, U32 range_count)
+{
+    _NetworkBuildRange* ranges = PushArray(arena, _NetworkBuildRange, range_count);
+    for (U32 range_idx = 0; range_idx < range_count; ++range_idx)
+    {
+        ranges[range_idx].begin = count * range_idx / range_count;
+        ranges[range_idx].end = count * (range_idx + 1) / range_count;
+    }
+    return ranges;
+}
+
+g_internal U32
+_network_build_range_count(async::ThreadPool* thread_pool, U64 count)
+{
+    const U64 min_range_size = 4096;
+    U64 range_count = Min((U64)(thread_pool->thread_count + 1) * 4, count / min_range_size);
+    return (U32)Max(range_count, 1ull);
+}
+
+// ~mgj: Creates a Node for every referenced node row and links it to the ways it is part of. Types
+// are walked in order so every way_queue lists building ways before highway ways, in way order.
+g_internal void
+_network_graph_link(Network* network, U64 used_node_count)
+{
+    prof_scope_marker;
+    Arena* arena = network->arena;
+    NodeColumns* nodes = &network->element_store.nodes;
+    WayColumns* ways = &network->element_store.ways;
+
+    network->node_index = hash_index_create<NodeId, Node*>(arena, used_node_count);
+    network->way_index = hash_index_create<WayId, WayNode*>(arena, ways->count);
+    Node* node_rows = PushArray(arena, Node, nodes->count);
+    for (U64 row = 0; row < nodes->count; ++row)
+    {
+        if (network->node_type_masks[row])
+        {
+            node_rows[row].id = nodes->ids[row];
+            hash_index_insert(network->node_index, nodes->ids[row], &node_rows[row]);
+        }
     }
 
-    Buffer<Way> ways = osm_way_parse_result.ways;
-    for (U32 way_type_idx = 0; way_type_idx < enum_idx(WayType::Count); ++way_type_idx)
+    U64 way_node_count = 0;
+    for (U32 type_idx = 0; type_idx < enum_idx(WayType::Count); ++type_idx)
     {
-        ChunkList<Way>* way_chunk_list = chunk_list_create<Way>(scratch.arena, 1024);
-        ChunkList<NodeId>* node_id_chunk_list = chunk_list_create<NodeId>(scratch.arena, 1024);
-        for (U32 way_index = 0; way_index < ways.size; way_index++)
+        for (Way& way : network->ways_arr[type_idx])
         {
-            Way* way = &ways.data[way_index];
-            TagResult tag_result = tag_find(scratch.arena, way->tags, S(g_waytype_osm_tag[way_type_idx]));
-            if (enum_idx(tag_result.result))
+            way_node_count += way.node_count;
+        }
+    }
+    WayNode* way_nodes = PushArray(arena, WayNode, way_node_count);
+    for (U32 type_idx = 0; type_idx < enum_idx(WayType::Count); ++type_idx)
+    {
+        for (Way& way : network->ways_arr[type_idx])
+        {
+            U32* way_ref_rows = network->node_ref_rows + (way.node_ids - ways->node_refs);
+            if (way.node_count)
             {
-                continue;
+                hash_index_insert(network->way_index, way.id, way_nodes);
             }
-
-            chunk_list_insert(scratch.arena, way_chunk_list, *way);
-            for (U32 node_index = 0; node_index < way->node_count; node_index++)
+            for (U64 node_idx = 0; node_idx < way.node_count; ++node_idx, ++way_nodes)
             {
-                U64 node_id = way->node_ids[node_index];
-                Node* node_utm;
-                B8 inserted = _node_hashmap_insert(osm_network, node_id, way, &node_utm);
-                if (inserted)
-                {
-                    WgsNode* node_coord = _wgs_node_find(node_result.road_nodes, node_id);
+                Node* node = &node_rows[way_ref_rows[node_idx]];
+                way_nodes->way = way;
+                SLLQueuePush(node->way_queue.first, node->way_queue.last, way_nodes);
+            }
+        }
+    }
+}
 
-                    // Cartographic to ECEF transformation
-                    CesiumGeospatial::Cartographic origin_cartographic(glm::radians(node_coord->lon), glm::radians(node_coord->lat), 0);
-                    glm::dvec3 coord_ecef = CesiumGeospatial::Ellipsoid::WGS84.cartographicToCartesian(origin_cartographic);
-                    EcefLocation loc = ecef_location_create(node_id, vec_3f64(coord_ecef.x, coord_ecef.y, coord_ecef.z));
-                    WgsLocation wgs_loc = {.id = node_id, .lat = node_coord->lat, .lon = node_coord->lon};
+g_internal Error
+_network_build(async::ThreadPool* thread_pool, Network* network)
+{
+    prof_scope_marker;
+    ScratchScope scratch = ScratchScope(0, 0);
+    Arena* arena = network->arena;
+    NodeColumns* nodes = &network->element_store.nodes;
+    WayColumns* ways = &network->element_store.ways;
+    AssertAlways(nodes->count < max_U32);
+
+    network->node_type_masks = PushArray(arena, U8, nodes->count);
+    network->node_ref_rows = PushArray(arena, U32, ways->node_ref_count);
+
+    _NetworkBuild* build = PushStruct(scratch.arena, _NetworkBuild);
+    build->network = network;
+    build->way_range_count = _network_build_range_count(thread_pool, ways->count);
+    build->way_ranges = _network_build_ranges_create(scratch.arena, ways->count, build->way_range_count);
+    build->node_range_count = _network_build_range_count(thread_pool, nodes->count);
+    build->node_ranges = _network_build_ranges_create(scratch.arena, nodes->count, build->node_range_count);
+    build->way_type_masks = PushArray(scratch.arena, U8, ways->count);
+    build->node_ecef = PushArrayNoZero(scratch.arena, Vec3F64, nodes->count);
+
+    async::thread_pool_fork_join(thread_pool, build->way_range_count, _network_build_classify_task, build);
+    if (build->missing_node.load())
+    {
+        return true;
+    }
 
-                    map_insert(osm_network->ecef_location_map, node_id, loc);
-                    map_insert(osm_network->wgs_location_map, node_id, wgs_loc);
+    for (U32 type_idx = 0; type_idx < enum_idx(WayType::Count); ++type_idx)
+    {
+        U64 way_count = 0;
+        for (U32 range_idx = 0; range_idx < build->way_range_count; ++range_idx)
+        {
+            build->way_ranges[range_idx].way_offsets[type_idx] = way_count;
+            way_count += build->way_ranges[range_idx].way_counts[type_idx];
+        }
+        network->ways_arr[type_idx] = buffer_alloc<Way>(arena, way_count);
+    }
+    async::thread_pool_fork_join(thread_pool, build->way_range_count, _network_build_ways_fill_task, build);
+    async::thread_pool_fork_join(thread_pool, build->node_range_count, _network_build_ecef_task, build);
 
-                    chunk_list_insert(scratch.arena, node_id_chunk_list, node_id);
-                }
-            }
+    // ~mgj: a node belongs to the node id array of the first way type that references it
+    U64 node_counts[enum_idx(WayType::Count)] = {};
+    U64 used_node_count = 0;
+    for (U64 row = 0; row < nodes->count; ++row)
+    {
+        U8 type_mask = network->node_type_masks[row];
+        if (type_mask)
+        {
+            node_counts[ctz32(type_mask)] += 1;
+            used_node_count += 1;
         }
+    }
+    for (U32 type_idx = 0; type_idx < enum_idx(WayType::Count); ++type_idx)
+    {
+        network->node_id_arr[type_idx] = buffer_alloc<NodeId>(arena, node_counts[type_idx]);
+        node_counts[type_idx] = 0;
+    }
 
-        osm_network->node_id_arr[way_type_idx] = buffer_from_chunk_list(osm_network->arena, node_id_chunk_list);
-        osm_network->ways_arr[way_type_idx] = buffer_from_chunk_list(osm_network->arena, way_chunk_list);
+    network->ecef_location_map = map_create<NodeId, EcefLocation>(arena, used_node_count);
+    network->wgs_location_map = map_create<NodeId, WgsLocation>(arena, used_node_count);
+    for (U64 row = 0; row < nodes->count; ++row)
+    {
+        U8 type_mask = network->node_type_masks[row];
+        if (type_mask == 0)
+        {
+            continue;
+        }
+        NodeId node_id = nodes->ids[row];
+        EcefLocation loc = ecef_location_create(node_id, build->node_ecef[row]);
+        WgsLocation wgs_loc = {.id = node_id, .lat = nodes->lat[row], .lon = nodes->lon[row]};
+        map_insert(network->ecef_location_map, node_id, loc);
+        map_insert(network->wgs_location_map, node_id, wgs_loc);
+
+        U32 type_idx = ctz32(type_mask);
+        network->node_id_arr[type_idx].data[node_counts[type_idx]++] = node_id;
+    }
+
+    _network_graph_link(network, used_node_count);
+    return false;
+}
+
+g_internal Error
+_parse_osm_data(async::ThreadPool* thread_pool, osm::Network* osm_network)
+{
+    prof_scope_marker;
+    ScratchScope scratch = ScratchScope(0, 0);
+
+    if (snapshot_load(osm_network) == false)
+    {
+        return false;
     }
 
-    _road_edge_structure_create(osm_network);
+    String8 file_content = wrapper::json_padded_from_file(scratch.arena, osm_network->cache_file_location);
+    if (_network_from_json(thread_pool, osm_network, file_content))
+    {
+        return true;
+    }
+    snapshot_write(osm_network);
+    return false;
+}
+
+g_internal Error
+_network_from_json(async::ThreadPool* thread_pool, Network* network, String8 json_padded)
+{
+    prof_scope_marker;
+    Result<ElementStore> element_store_result = wrapper::osm_element_store_from_simd_json(network->arena, json_padded);
+    if (element_store_result.err)
+    {
+        DEBUG_LOG("Error happend when parsing osm elements from json");
+        return true;
+    }
+    network->element_store = element_store_result.v;
+    if (_network_build(thread_pool, network))
+    {
+        return true;
+    }
+
+    _road_edge_structure_create(network);
     return false;
 }
 g_internal void
@@ -123,16 +401,22 @@ _road_edge_structure_create(Network* network)
     prof_scope_marker;
     Buffer<osm::Way> way_buf = network->ways_arr[enum_idx(osm::WayType::Highway)];
 
-    ChunkList<RoadEdge>* chunk_list = chunk_list_create<RoadEdge>(network->arena, 1024);
+    // ~mgj: edges are written straight into the final buffer so prev/next point into it
+    U64 edge_count = 0;
+    for (const osm::Way& way : way_buf)
+    {
+        edge_count += way.node_count ? way.node_count - 1 : 0;
+    }
+    Buffer<RoadEdge> road_edge_buf = buffer_alloc<RoadEdge>(network->arena, edge_count);
+    RoadEdge* road_edge = road_edge_buf.data;
     for (const osm::Way& way : way_buf)
     {
         RoadEdge* prev_edge = 0;
-        for (U32 node_idx = 1; node_idx < way.node_count; node_idx++)
+        for (U32 node_idx = 1; node_idx < way.node_count; node_idx++, road_edge++)
         {
             U64 prev_node_id = way.node_ids[node_idx - 1];
             U64 node_id = way.node_ids[node_idx];
 
-            RoadEdge* road_edge = chunk_list_get_next(network->arena, chunk_list);
             road_edge->id = random_u64();
             road_edge->way_id = way.id;
             road_edge->node_id_from = prev_node_id;
@@ -147,8 +431,7 @@ _road_edge_structure_create(Network* network)
         }
     }
 
-    Buffer<RoadEdge> road_edge_buf = buffer_from_chunk_list(network->arena, chunk_list);
-    Map<S64, RoadEdge*>* road_edge_map = map_create<S64, RoadEdge*>(network->arena, 1024);
+    Map<S64, RoadEdge*>* road_edge_map = map_create<S64, RoadEdge*>(network->arena, road_edge_buf.size);
     for (RoadEdge* edge = road_edge_buf.begin(); edge < road_edge_buf.end(); edge++)
     {
         map_insert(road_edge_map, edge->id, edge);
@@ -157,56 +440,37 @@ _road_edge_structure_create(Network* network)
     network->edge_structure = {.edges = road_edge_buf, .edge_map = *road_edge_map};
 }
 
-g_internal WgsNode*
-_wgs_node_find(Buffer<RoadNodeList> node_hashmap, U64 node_id)
-{
-    RoadNodeList* node_list = &node_hashmap.data[node_id % node_hashmap.size];
-
-    WgsNode* node = node_list->first;
-    for (; node; node = node->next)
-    {
-        if (node->id == node_id)
-        {
-            break;
-        }
-    }
-    return node;
-}
-
 g_internal WayNode*
 way_find(Network* network, WayId way_id)
 {
-    WayList* way_list = &network->way_hashmap.data[way_id % network->way_hashmap.size];
-
-    WayNode* node = way_list->first;
-    for (; node; node = node->hash_next)
-    {
-        Way* way = &node->way;
-        if (way->id == way_id)
-        {
-            break;
-        }
-    }
-    return node;
+    WayNode** way_node = hash_index_get(network->way_index, way_id);
+    return way_node ? *way_node : nullptr;
 }
 
 g_internal TagResult
-tag_find(Arena* arena, Buffer<Tag> tags, String8 tag_to_find)
+tag_find(TagList tags, StrId key)
 {
     TagResult result = {};
     result.result = TagResultEnum::ROAD_TAG_NOT_FOUND;
-    for (U32 i = 0; i < tags.size; i++)
+    for (U64 i = 0; i < tags.count; i++)
     {
-        if (Str8Cmp(tags.data[i].key, tag_to_find))
+        if (tags.keys[i] == key)
         {
             result.result = TagResultEnum::ROAD_TAG_FOUND;
-            result.value = push_str8_copy(arena, tags.data[i].value);
+            result.value_id = tags.values[i];
+            result.value = str8_from_str_id(tags.values[i]);
             break;
         }
     }
     return result;
 }
 
+g_internal TagResult
+tag_find(TagList tags, TagKeyId key)
+{
+    return tag_find(tags, (StrId)key);
+}
+
 g_internal EcefLocation
 location_get(Network* network, NodeId node_id)
 {
@@ -236,60 +500,15 @@ wgs_location_get(Network* network, NodeId node_id)
 g_internal Node*
 node_get(Network* network, NodeId node_id)
 {
-    Buffer<NodeList> utm_node_hashmap = network->node_hashmap;
-    U32 slot_index = node_id % utm_node_hashmap.size;
-    NodeList* slot = &utm_node_hashmap.data[slot_index];
-    for (Node* node = slot->first; node; node = node->next)
+    Node** node = hash_index_get(network->node_index, node_id);
+    if (node)
     {
-        if (node->id == node_id)
-        {
-            return node;
-        }
+        return *node;
     }
     Assert(0 && "Node not found in hash map");
     return &g_road_node_utm;
 }
 
-g_internal B32
-_node_hashmap_insert(Network* network, NodeId node_id, Way* way, Node** out)
-{
-    // ~mgj: Insert Node into hash if not already inserted
-    U64 node_slot = node_id % network->node_hashmap.size;
-    NodeList* slot = &network->node_hashmap.data[node_slot];
-    Node* node = slot->first;
-    B32 node_inserted = false;
-    for (; node; node = node->next)
-    {
-        if (node->id == node_id)
-        {
-            break;
-        }
-    }
-    if (!node)
-    {
-        node = PushStruct(network->arena, Node);
-        node->id = node_id;
-        SLLQueuePush(slot->first, slot->last, node);
-        Assert(slot->last->next == 0);
-        node_inserted = 1;
-    }
-
-    WayNode* way_node = PushStruct(network->arena, WayNode);
-    way_node->way = *way;
-
-    // ~mgj: every node should be quickly able to look up the roadways it is part of
-    SLLQueuePush(node->way_queue.first, node->way_queue.last, way_node);
-
-    // ~mgj: Ways are put into its hashmap for quick lookup (relevant for pixel picking operations)
-    U64 way_id = way->id;
-    U64 way_slot = way_id % network->way_hashmap.size;
-    WayList* way_list = &network->way_hashmap.data[way_slot];
-    SLLQueuePush_N(way_list->first, way_list->last, way_node, hash_next);
-
-    *out = node;
-    return node_inserted;
-}
-
 g_internal NodeId
 random_node_id_from_type_get(Network* network, WayType type)
 {
@@ -11,25 +11,7 @@ struct City;
 
 namespace osm
 {
-
-typedef S64 EdgeId;
-typedef U64 NodeId;
-typedef S64 WayId;
-
-struct WgsNode
-{
-    WgsNode* next;
-    NodeId id;
-    F32 lat;
-    F32 lon;
-};
-
-struct Tag
-{
-    Tag* next;
-    String8 key;
-    String8 value;
-};
+struct SnapshotView;
 
 enum class TagResultEnum : int
 {
@@ -40,19 +22,8 @@ enum class TagResultEnum : int
 struct TagResult
 {
     TagResultEnum result;
-    String8 value;
-};
-
-struct RoadNodeList
-{
-    WgsNode* first;
-    WgsNode* last;
-};
-
-struct RoadNodeParseResult
-{
-    Buffer<RoadNodeList> road_nodes;
-    B32 error;
+    StrId value_id;
+    String8 value; // interned, lives as long as the process
 };
 
 struct Way
@@ -64,13 +35,12 @@ struct Way
     NodeId* node_ids; // fixed array with node_count length and node ids as index
     U64 node_count;
 
-    Buffer<Tag> tags;
+    TagList tags;
 };
 
 struct WayNode
 {
     WayNode* next;
-    WayNode* hash_next;
     Way way;
 };
 
@@ -80,15 +50,8 @@ struct WayList
     WayNode* last;
 };
 
-struct WayParseResult
-{
-    Buffer<Way> ways;
-    B32 error;
-};
-
 struct Node
 {
-    Node* next;
     NodeId id;
 
     String8 utm_zone;  // TODO: If not used in future: Delete
@@ -130,12 +93,6 @@ ecef_location_create(U64 id, Vec3F64 pos)
     return loc;
 }
 
-struct NodeList
-{
-    Node* first;
-    Node* last;
-};
-
 #define WAYTYPE_OPTIONS                                                                                                                                                                                \
     X(Building, "building")                                                                                                                                                                            \
     X(Highway, "highway")
@@ -154,33 +111,51 @@ read_only g_internal const char* g_waytype_osm_tag[] = {
 #undef X
 };
 
+// ~mgj: every WayType tag has to be listed in TAG_KEY_OPTIONS as well
+read_only g_internal TagKeyId g_waytype_tag_key[] = {
+#define X(name, str) TagKeyId::name,
+    WAYTYPE_OPTIONS
+#undef X
+};
+
 struct Network
 {
     Arena* arena;
     String8 cache_file_location;
+    String8 snapshot_file_location;
     String8 bbox_cache_str;
+    async::HttpInfo* overpass_http_info; // fetches the content of cache_file_location on a cache miss
+    SnapshotView* snapshot; // set when the network was loaded from snapshot_file_location
+
+    ElementStore element_store; // backing storage for the node ids and tags of every Way
 
-    Buffer<NodeList> node_hashmap; // key is the node id
+    // ~mgj: created by _parse_osm_data, pre-sized from the element counts of the response
+    HashIndex<NodeId, Node*>* node_index;
     Map<NodeId, EcefLocation>* ecef_location_map;
     Map<NodeId, WgsLocation>* wgs_location_map;
 
-    Buffer<WayList> way_hashmap;                    // view into way buffers
+    U8* node_type_masks; // per element store node row, bit per WayType referencing the node
+    U32* node_ref_rows;  // element store node row of every node_refs entry, set for classified ways
+
+    HashIndex<WayId, WayNode*>* way_index;          // first WayNode inserted for each way
     Buffer<Way> ways_arr[enum_idx(WayType::Count)]; // buffer storage
     Buffer<NodeId> node_id_arr[enum_idx(WayType::Count)];
     EdgeStructure edge_structure;
 };
 
-read_only g_internal Node g_road_node_utm = {nullptr, 0, {}, {}};
+read_only g_internal Node g_road_node_utm = {0, {}, {}};
 
 // Public
 g_internal Network*
-osm_init(U64 node_hashmap_size, U64 way_hashmap_size, String8 cache_path, String8 area, String8 bbox_cache_str);
+osm_init(String8 cache_path, String8 area, String8 bbox_cache_str);
 g_internal void
 osm_release(Network* osm_network);
 g_internal void
 structure_cleanup(Network* network);
 g_internal TagResult
-tag_find(Arena* arena, Buffer<Tag> tags, String8 tag_to_find);
+tag_find(TagList tags, StrId key);
+g_internal TagResult
+tag_find(TagList tags, TagKeyId key);
 g_internal WayNode*
 way_find(Network* network, WayId way_id);
 g_internal EcefLocation
@@ -196,17 +171,26 @@ random_neighbour_node_get(Network* network, U64 node_id);
 g_internal NodeId
 random_node_id_from_type_get(Network* network, WayType type);
 
-g_internal async::UserFuncResult<osm::Network>
-fetch_osm_data_and_parse(Arena* arena, async::ThreadPool* thread_pool, String8 response_body, osm::Network* osm_network);
+// ~mgj: Cache miss: downloads overpass_http_info and parses the response where curl streamed it, while
+// the response is written to cache_file_location at the same time. The snapshot is written once both
+// are done, it is keyed on the cache file's meta hash.
+g_internal async::CoTask<B32>
+fetch_osm_data_and_parse(Arena* arena, osm::Network* osm_network);
 g_internal async::AsyncTaskContinuation<osm::Network>
 parse_osm_data(async::ThreadInfo thread_info, async::AsyncTaskStatus<osm::Network>* task);
 g_internal Error
-_parse_osm_data(osm::Network* osm_network);
+_parse_osm_data(async::ThreadPool* thread_pool, osm::Network* osm_network);
 // Privates
+g_internal Error
+_network_from_json(async::ThreadPool* thread_pool, Network* network, String8 json_padded);
+g_internal async::CoTask<B32>
+_network_from_json_co(Arena* arena, async::ThreadPool* thread_pool, Network* network, String8 json_padded);
+g_internal async::CoTask<B32>
+_cache_write_co(Arena* arena, Network* network, String8 content);
+g_internal Error
+_network_build(async::ThreadPool* thread_pool, Network* network);
 g_internal void
 _road_edge_structure_create(Network* network);
-g_internal WgsNode*
-_wgs_node_find(Buffer<RoadNodeList> node_hashmap, U64 node_id);
-g_internal B32
-_node_hashmap_insert(Network* network, U64 node_id, Way* way, Node** out);
+g_internal void
+_network_graph_link(Network* network, U64 used_node_count);
 } // namespace osm
@@ -0,0 +1,180 @@
+namespace osm
+{
+
+struct _NodeSortKey
+{
+    NodeId id;
+    U64 row;
+};
+
+g_internal int
+_node_sort_key_compare(const _NodeSortKey* a, const _NodeSortKey* b)
+{
+    return (a->id > b->id) - (a->id < b->id);
+}
+
+g_internal String8
+_string_table_str8(StringTable* table, StrId id)
+{
+    Assert(id < table->count.load(std::memory_order_acquire));
+    U32 block_idx = msb_index(id + (1u << STRING_TABLE_FIRST_BLOCK_SHIFT)) - STRING_TABLE_FIRST_BLOCK_SHIFT;
+    U32 block_first_id = (1u << (block_idx + STRING_TABLE_FIRST_BLOCK_SHIFT)) - (1u << STRING_TABLE_FIRST_BLOCK_SHIFT);
+    return table->blocks[block_idx][id - block_first_id];
+}
+
+g_internal StrId
+_string_table_intern(StringTable* table, String8 str)
+{
+    U64 hash = hash_u128_from_str8(str).u64[0];
+    StrId id = 0;
+    os_mutex_scope(table->mutex)
+    {
+        for (;; ++hash)
+        {
+            StrId* existing_id = map_get(table->hash_to_id, hash);
+            if (!existing_id)
+            {
+                id = table->count.load(std::memory_order_relaxed);
+                U32 block_idx = msb_index(id + (1u << STRING_TABLE_FIRST_BLOCK_SHIFT)) - STRING_TABLE_FIRST_BLOCK_SHIFT;
+                AssertAlways(block_idx < STRING_TABLE_BLOCK_COUNT);
+                U32 block_first_id = (1u << (block_idx + STRING_TABLE_FIRST_BLOCK_SHIFT)) - (1u << STRING_TABLE_FIRST_BLOCK_SHIFT);
+                if (!table->blocks[block_idx])
+                {
+                    table->blocks[block_idx] = PushArrayNoZero(table->arena, String8, 1ull << (block_idx + STRING_TABLE_FIRST_BLOCK_SHIFT));
+                }
+                // ~mgj: strings are null terminated so they can be handed to C apis as is
+                String8 copy = push_str8_copy(table->arena, str);
+                table->blocks[block_idx][id - block_first_id] = copy;
+                map_insert(table->hash_to_id, hash, id);
+                table->count.store(id + 1, std::memory_order_release);
+                break;
+            }
+            if (str8_match(_string_table_str8(table, *existing_id), str, 0))
+            {
+                id = *existing_id;
+                break;
+            }
+        }
+    }
+    return id;
+}
+
+g_internal StringTable*
+_string_table_create()
+{
+    Arena* arena = arena_alloc();
+    Debug_SetName(arena, "string table arena");
+    StringTable* table = PushStruct(arena, StringTable);
+    table->arena = arena;
+    table->mutex = OS_MutexAlloc();
+    table->hash_to_id = map_create<U64, StrId>(arena, 4096);
+    for (U32 key_idx = 0; key_idx < enum_idx(TagKeyId::Count); ++key_idx)
+    {
+        StrId id = _string_table_intern(table, str8_c_string(g_tag_key_str[key_idx]));
+        Assert(id == key_idx);
+        (void)id;
+    }
+    return table;
+}
+
+// ~mgj: Process wide, created on first use and never released
+g_internal StringTable*
+string_table_global()
+{
+    static StringTable* table = _string_table_create();
+    return table;
+}
+
+g_internal StrId
+str_id_from_str8(String8 str)
+{
+    return _string_table_intern(string_table_global(), str);
+}
+
+// ~mgj: id must come from str_id_from_str8 in this process
+g_internal String8
+str8_from_str_id(StrId id)
+{
+    return _string_table_str8(string_table_global(), id);
+}
+
+// ~mgj: returns nodes->count when the id is not present
+g_internal U64
+element_store_node_idx_find(NodeColumns* nodes, NodeId node_id)
+{
+    U64 lo = 0;
+    U64 hi = nodes->count;
+    while (lo < hi)
+    {
+        U64 mid = lo + (hi - lo) / 2;
+        if (nodes->ids[mid] < node_id)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    if (lo < nodes->count && nodes->ids[lo] == node_id)
+    {
+        return lo;
+    }
+    return nodes->count;
+}
+
+g_internal Buffer<NodeId>
+element_store_way_node_ids(WayColumns* ways, U64 way_idx)
+{
+    Assert(way_idx < ways->count);
+    ElementSpan span = ways->node_spans[way_idx];
+    Buffer<NodeId> node_ids = {.data = ways->node_refs + span.offset, .size = span.count};
+    return node_ids;
+}
+
+g_internal TagList
+element_store_way_tags(WayColumns* ways, U64 way_idx)
+{
+    Assert(way_idx < ways->count);
+    ElementSpan span = ways->tag_spans[way_idx];
+    TagList tags = {.keys = ways->tag_keys + span.offset, .values = ways->tag_values + span.offset, .count = span.count};
+    return tags;
+}
+
+g_internal void
+element_store_nodes_sort(NodeColumns* nodes)
+{
+    prof_scope_marker;
+    B32 is_sorted = true;
+    for (U64 i = 1; i < nodes->count && is_sorted; ++i)
+    {
+        is_sorted = nodes->ids[i - 1] <= nodes->ids[i];
+    }
+    if (is_sorted)
+    {
+        return;
+    }
+
+    ScratchScope scratch = ScratchScope(0, 0);
+    _NodeSortKey* keys = PushArrayNoZero(scratch.arena, _NodeSortKey, nodes->count);
+    F64* lat = PushArrayNoZero(scratch.arena, F64, nodes->count);
+    F64* lon = PushArrayNoZero(scratch.arena, F64, nodes->count);
+    for (U64 i = 0; i < nodes->count; ++i)
+    {
+        keys[i] = {.id = nodes->ids[i], .row = i};
+    }
+    MemoryCopy(lat, nodes->lat, nodes->count * sizeof(F64));
+    MemoryCopy(lon, nodes->lon, nodes->count * sizeof(F64));
+
+    quick_sort(keys, nodes->count, sizeof(_NodeSortKey), _node_sort_key_compare);
+
+    for (U64 i = 0; i < nodes->count; ++i)
+    {
+        U64 row = keys[i].row;
+        nodes->ids[i] = keys[i].id;
+        nodes->lat[i] = lat[row];
+        nodes->lon[i] = lon[row];
+    }
+}
+
+} // namespace osm
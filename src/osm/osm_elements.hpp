@@ -0,0 +1,119 @@
+#pragma once
+
+namespace osm
+{
+
+typedef S64 EdgeId;
+typedef U64 NodeId;
+typedef S64 WayId;
+
+// ~mgj: Interned string, equal strings share one id for the lifetime of the process. Id 0 is the
+// empty string. Ids are not stable across runs so they must never be written to disk.
+typedef U32 StrId;
+
+// ~mgj: Keys interned right after the empty string when the string table is created, so a TagKeyId
+// is also the StrId of its key and matching a well known key is an integer compare
+#define TAG_KEY_OPTIONS                                                                                                                                                                                \
+    X(Building, "building")                                                                                                                                                                            \
+    X(BuildingLevels, "building:levels")                                                                                                                                                               \
+    X(Height, "height")                                                                                                                                                                                \
+    X(Highway, "highway")                                                                                                                                                                              \
+    X(Lanes, "lanes")                                                                                                                                                                                  \
+    X(Maxspeed, "maxspeed")                                                                                                                                                                            \
+    X(Name, "name")                                                                                                                                                                                    \
+    X(Oneway, "oneway")                                                                                                                                                                                \
+    X(Surface, "surface")                                                                                                                                                                              \
+    X(Width, "width")
+
+enum class TagKeyId : StrId
+{
+    Empty,
+#define X(name, str) name,
+    TAG_KEY_OPTIONS
+#undef X
+        Count
+};
+
+read_only g_internal const char* g_tag_key_str[] = {
+    "",
+#define X(name, str) str,
+    TAG_KEY_OPTIONS
+#undef X
+};
+
+// ~mgj: id -> string lives in blocks that double in size and are never moved, so reading a string
+// back takes no lock. Block b holds the ids [4096 * (2^b - 1), 4096 * (2^(b+1) - 1)).
+const U32 STRING_TABLE_FIRST_BLOCK_SHIFT = 12;
+const U32 STRING_TABLE_BLOCK_COUNT = 20;
+
+struct StringTable
+{
+    Arena* arena;
+    OS_Handle mutex;               // guards interning, lookups of existing ids are lock free
+    Map<U64, StrId>* hash_to_id;   // a hash collision continues probing at hash + 1
+    std::atomic<U32> count;
+    String8* blocks[STRING_TABLE_BLOCK_COUNT];
+};
+
+// ~mgj: Tags of one way as two parallel id arrays, keys[i] belongs to values[i]
+struct TagList
+{
+    StrId* keys;
+    StrId* values;
+    U64 count;
+};
+
+// ~mgj: [offset, offset + count) into one of the flat element arrays
+struct ElementSpan
+{
+    U64 offset;
+    U64 count;
+};
+
+// ~mgj: node columns are sorted by id after ingest so lookups can binary search
+struct NodeColumns
+{
+    U64 count;
+    NodeId* ids;
+    F64* lat;
+    F64* lon;
+};
+
+struct WayColumns
+{
+    U64 count;
+    WayId* ids;
+    ElementSpan* node_spans; // into node_refs
+    ElementSpan* tag_spans;  // into tag_keys/tag_values
+
+    U64 node_ref_count;
+    NodeId* node_refs;
+    U64 tag_count;
+    StrId* tag_keys;
+    StrId* tag_values;
+};
+
+// ~mgj: Columnar view of an Overpass json response. Every array is sized from a counting
+// walk over the document before it is filled, so nothing is reallocated or copied afterwards.
+struct ElementStore
+{
+    NodeColumns nodes;
+    WayColumns ways;
+};
+
+g_internal StringTable*
+string_table_global();
+g_internal StrId
+str_id_from_str8(String8 str);
+g_internal String8
+str8_from_str_id(StrId id);
+g_internal U64
+element_store_node_idx_find(NodeColumns* nodes, NodeId node_id);
+g_internal Buffer<NodeId>
+element_store_way_node_ids(WayColumns* ways, U64 way_idx);
+g_internal TagList
+element_store_way_tags(WayColumns* ways, U64 way_idx);
+g_internal void
+element_store_nodes_sort(NodeColumns* nodes);
+
+} // namespace osm
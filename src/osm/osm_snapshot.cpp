@@ -0,0 +1,338 @@
+namespace osm
+{
+
+g_internal U64
+_snapshot_section_push(SnapshotHeader* header, SnapshotSection section, U64 size, U64 cursor)
+{
+    cursor += AlignPadPow2(cursor, SNAPSHOT_SECTION_ALIGN);
+    header->sections[section] = {.offset = cursor, .size = size};
+    return cursor + size;
+}
+
+g_internal U64
+_snapshot_checksum(U8* base, U64 file_size)
+{
+    meow_u128 hash = MeowHash(MeowDefaultSeed, file_size - sizeof(SnapshotHeader), base + sizeof(SnapshotHeader));
+    return MeowU64From(hash, 0);
+}
+
+// ~mgj: index of id in the snapshot's string table, appending it on first use
+g_internal U32
+_snapshot_string_idx(Map<StrId, U32>* string_map, Buffer<StrId>* strings, U64* pool_size, StrId id)
+{
+    U32* string_idx = map_get(string_map, id);
+    if (string_idx)
+    {
+        return *string_idx;
+    }
+    U32 new_idx = (U32)strings->size;
+    strings->data[strings->size++] = id;
+    *pool_size += str8_from_str_id(id).size + 1;
+    map_insert(string_map, id, new_idx);
+    return new_idx;
+}
+
+template <typename T>
+g_internal T*
+_snapshot_section_ptr(SnapshotHeader* header, U8* base, SnapshotSection section)
+{
+    return (T*)(base + header->sections[section].offset);
+}
+
+g_internal B32
+snapshot_write(Network* network)
+{
+    prof_scope_marker;
+    ScratchScope scratch = ScratchScope(0, 0);
+    NodeColumns* nodes = &network->element_store.nodes;
+    WayColumns* ways = &network->element_store.ways;
+    Map<NodeId, EcefLocation>* ecef_map = network->ecef_location_map;
+    Map<NodeId, WgsLocation>* wgs_map = network->wgs_location_map;
+    Buffer<RoadEdge> edges = network->edge_structure.edges;
+    if (edges.size >= max_U32)
+    {
+        return false;
+    }
+
+    U64 meta_hash = cache_meta_hash(network->cache_file_location);
+    if (meta_hash == 0)
+    {
+        return false;
+    }
+
+    // ~mgj: tags become indices into a string table holding each distinct string once
+    U32* tag_keys = PushArrayNoZero(scratch.arena, U32, ways->tag_count);
+    U32* tag_values = PushArrayNoZero(scratch.arena, U32, ways->tag_count);
+    Buffer<StrId> strings = {.data = PushArrayNoZero(scratch.arena, StrId, ways->tag_count * 2), .size = 0};
+    Map<StrId, U32>* string_map = map_create<StrId, U32>(scratch.arena, 1024);
+    U64 pool_size = 0;
+    for (U64 i = 0; i < ways->tag_count; ++i)
+    {
+        tag_keys[i] = _snapshot_string_idx(string_map, &strings, &pool_size, ways->tag_keys[i]);
+        tag_values[i] = _snapshot_string_idx(string_map, &strings, &pool_size, ways->tag_values[i]);
+    }
+    if (pool_size >= max_U32)
+    {
+        return false;
+    }
+
+    SnapshotHeader header = {};
+    header.magic = SNAPSHOT_MAGIC;
+    header.version = SNAPSHOT_VERSION;
+    header.meta_hash = meta_hash;
+    header.ecef_map_capacity = ecef_map->capacity;
+    header.ecef_map_count = ecef_map->count;
+    header.wgs_map_capacity = wgs_map->capacity;
+    header.wgs_map_count = wgs_map->count;
+    U64 way_total = 0;
+    U64 node_id_total = 0;
+    for (U32 type_idx = 0; type_idx < enum_idx(WayType::Count); ++type_idx)
+    {
+        header.way_counts[type_idx] = network->ways_arr[type_idx].size;
+        header.node_id_counts[type_idx] = network->node_id_arr[type_idx].size;
+        way_total += network->ways_arr[type_idx].size;
+        node_id_total += network->node_id_arr[type_idx].size;
+    }
+
+    U64 cursor = sizeof(SnapshotHeader);
+    cursor = _snapshot_section_push(&header, SnapshotSection_NodeIds, nodes->count * sizeof(NodeId), cursor);
+    cursor = _snapshot_section_push(&header, SnapshotSection_NodeLat, nodes->count * sizeof(F64), cursor);
+    cursor = _snapshot_section_push(&header, SnapshotSection_NodeLon, nodes->count * sizeof(F64), cursor);
+    cursor = _snapshot_section_push(&header, SnapshotSection_WayIds, ways->count * sizeof(WayId), cursor);
+    cursor = _snapshot_section_push(&header, SnapshotSection_WayNodeSpans, ways->count * sizeof(ElementSpan), cursor);
+    cursor = _snapshot_section_push(&header, SnapshotSection_WayTagSpans, ways->count * sizeof(ElementSpan), cursor);
+    cursor = _snapshot_section_push(&header, SnapshotSection_WayNodeRefs, ways->node_ref_count * sizeof(NodeId), cursor);
+    cursor = _snapshot_section_push(&header, SnapshotSection_NodeTypeMasks, nodes->count * sizeof(U8), cursor);
+    cursor = _snapshot_section_push(&header, SnapshotSection_NodeRefRows, ways->node_ref_count * sizeof(U32), cursor);
+    cursor = _snapshot_section_push(&header, SnapshotSection_TagKeys, ways->tag_count * sizeof(U32), cursor);
+    cursor = _snapshot_section_push(&header, SnapshotSection_TagValues, ways->tag_count * sizeof(U32), cursor);
+    cursor = _snapshot_section_push(&header, SnapshotSection_Strings, strings.size * sizeof(SnapshotString), cursor);
+    cursor = _snapshot_section_push(&header, SnapshotSection_StringPool, pool_size, cursor);
+    cursor = _snapshot_section_push(&header, SnapshotSection_EcefCtrl, ecef_map->capacity, cursor);
+    cursor = _snapshot_section_push(&header, SnapshotSection_EcefSlots, ecef_map->capacity * sizeof(ecef_map->slots[0]), cursor);
+    cursor = _snapshot_section_push(&header, SnapshotSection_WgsCtrl, wgs_map->capacity, cursor);
+    cursor = _snapshot_section_push(&header, SnapshotSection_WgsSlots, wgs_map->capacity * sizeof(wgs_map->slots[0]), cursor);
+    cursor = _snapshot_section_push(&header, SnapshotSection_Ways, way_total * sizeof(SnapshotWay), cursor);
+    cursor = _snapshot_section_push(&header, SnapshotSection_NodeIdArr, node_id_total * sizeof(NodeId), cursor);
+    cursor = _snapshot_section_push(&header, SnapshotSection_Edges, edges.size * sizeof(SnapshotEdge), cursor);
+    header.file_size = cursor + AlignPadPow2(cursor, SNAPSHOT_SECTION_ALIGN);
+
+    U8* base = PushArray(scratch.arena, U8, header.file_size);
+    MemoryCopy(_snapshot_section_ptr<NodeId>(&header, base, SnapshotSection_NodeIds), nodes->ids, nodes->count * sizeof(NodeId));
+    MemoryCopy(_snapshot_section_ptr<F64>(&header, base, SnapshotSection_NodeLat), nodes->lat, nodes->count * sizeof(F64));
+    MemoryCopy(_snapshot_section_ptr<F64>(&header, base, SnapshotSection_NodeLon), nodes->lon, nodes->count * sizeof(F64));
+    MemoryCopy(_snapshot_section_ptr<WayId>(&header, base, SnapshotSection_WayIds), ways->ids, ways->count * sizeof(WayId));
+    MemoryCopy(_snapshot_section_ptr<ElementSpan>(&header, base, SnapshotSection_WayNodeSpans), ways->node_spans, ways->count * sizeof(ElementSpan));
+    MemoryCopy(_snapshot_section_ptr<ElementSpan>(&header, base, SnapshotSection_WayTagSpans), ways->tag_spans, ways->count * sizeof(ElementSpan));
+    MemoryCopy(_snapshot_section_ptr<NodeId>(&header, base, SnapshotSection_WayNodeRefs), ways->node_refs, ways->node_ref_count * sizeof(NodeId));
+    MemoryCopy(_snapshot_section_ptr<U8>(&header, base, SnapshotSection_NodeTypeMasks), network->node_type_masks, nodes->count * sizeof(U8));
+    MemoryCopy(_snapshot_section_ptr<U32>(&header, base, SnapshotSection_NodeRefRows), network->node_ref_rows, ways->node_ref_count * sizeof(U32));
+    MemoryCopy(_snapshot_section_ptr<U32>(&header, base, SnapshotSection_TagKeys), tag_keys, ways->tag_count * sizeof(U32));
+    MemoryCopy(_snapshot_section_ptr<U32>(&header, base, SnapshotSection_TagValues), tag_values, ways->tag_count * sizeof(U32));
+    SnapshotString* dst_strings = _snapshot_section_ptr<SnapshotString>(&header, base, SnapshotSection_Strings);
+    U8* pool = _snapshot_section_ptr<U8>(&header, base, SnapshotSection_StringPool);
+    U32 pool_offset = 0;
+    for (U64 i = 0; i < strings.size; ++i)
+    {
+        String8 str = str8_from_str_id(strings.data[i]);
+        dst_strings[i] = {.offset = pool_offset, .size = (U32)str.size};
+        MemoryCopy(pool + pool_offset, str.str, str.size);
+        pool[pool_offset + str.size] = 0;
+        pool_offset += (U32)str.size + 1;
+    }
+    MemoryCopy(_snapshot_section_ptr<U8>(&header, base, SnapshotSection_EcefCtrl), ecef_map->ctrl, ecef_map->capacity);
+    MemoryCopy(_snapshot_section_ptr<U8>(&header, base, SnapshotSection_EcefSlots), ecef_map->slots, header.sections[SnapshotSection_EcefSlots].size);
+    MemoryCopy(_snapshot_section_ptr<U8>(&header, base, SnapshotSection_WgsCtrl), wgs_map->ctrl, wgs_map->capacity);
+    MemoryCopy(_snapshot_section_ptr<U8>(&header, base, SnapshotSection_WgsSlots), wgs_map->slots, header.sections[SnapshotSection_WgsSlots].size);
+
+    SnapshotWay* dst_way = _snapshot_section_ptr<SnapshotWay>(&header, base, SnapshotSection_Ways);
+    NodeId* dst_node_id = _snapshot_section_ptr<NodeId>(&header, base, SnapshotSection_NodeIdArr);
+    for (U32 type_idx = 0; type_idx < enum_idx(WayType::Count); ++type_idx)
+    {
+        for (Way& way : network->ways_arr[type_idx])
+        {
+            dst_way->id = way.id;
+            dst_way->node_span = {.offset = (U64)(way.node_ids - ways->node_refs), .count = way.node_count};
+            dst_way->tag_span = {.offset = (U64)(way.tags.keys - ways->tag_keys), .count = way.tags.count};
+            dst_way += 1;
+        }
+        Buffer<NodeId> node_ids = network->node_id_arr[type_idx];
+        MemoryCopy(dst_node_id, node_ids.data, node_ids.size * sizeof(NodeId));
+        dst_node_id += node_ids.size;
+    }
+
+    SnapshotEdge* dst_edges = _snapshot_section_ptr<SnapshotEdge>(&header, base, SnapshotSection_Edges);
+    for (U64 i = 0; i < edges.size; ++i)
+    {
+        RoadEdge* edge = &edges.data[i];
+        dst_edges[i] = {.id = edge->id,
+                        .node_id_from = edge->node_id_from,
+                        .node_id_to = edge->node_id_to,
+                        .way_id = edge->way_id,
+                        .prev_idx = edge->prev ? (U32)(edge->prev - edges.data) : max_U32,
+                        .next_idx = edge->next ? (U32)(edge->next - edges.data) : max_U32};
+    }
+
+    header.checksum = _snapshot_checksum(base, header.file_size);
+    MemoryCopy(base, &header, sizeof(header));
+
+    String8 path = network->snapshot_file_location;
+    B32 is_written = os_write_data_to_file_path(path, str8(base, header.file_size));
+    if (!is_written)
+    {
+        DEBUG_LOG("snapshot_write: Was not able to write %s\n", path.str);
+    }
+    return is_written;
+}
+
+g_internal Error
+snapshot_load(Network* network)
+{
+    prof_scope_marker;
+    String8 path = network->snapshot_file_location;
+    if (!os_file_path_exists(path))
+    {
+        return true;
+    }
+
+    SnapshotView view = {};
+    view.file = os_file_open(OS_AccessFlag_Read | OS_AccessFlag_ShareRead, path);
+    view.size = os_properties_from_file(view.file).size;
+    if (view.size >= sizeof(SnapshotHeader))
+    {
+        view.map = os_file_map_open(OS_AccessFlag_Read, view.file);
+        view.base = (U8*)os_file_map_view_open(view.map, OS_AccessFlag_Read, r1u64(0, view.size));
+    }
+
+    SnapshotHeader* header = (SnapshotHeader*)view.base;
+    B32 is_valid = header && header->magic == SNAPSHOT_MAGIC && header->version == SNAPSHOT_VERSION && header->file_size == view.size;
+    for (U32 section_idx = 0; is_valid && section_idx < SnapshotSection_Count; ++section_idx)
+    {
+        SnapshotSpan span = header->sections[section_idx];
+        is_valid = span.offset <= view.size && span.size <= view.size - span.offset;
+    }
+    is_valid = is_valid && header->meta_hash == cache_meta_hash(network->cache_file_location);
+    is_valid = is_valid && header->checksum == _snapshot_checksum(view.base, view.size);
+    if (!is_valid)
+    {
+        DEBUG_LOG("snapshot_load: %s is stale or corrupt, rebuilding from json\n", path.str);
+        if (view.base)
+        {
+            os_file_map_view_close(view.map, view.base, r1u64(0, view.size));
+            os_file_map_close(view.map);
+        }
+        os_file_close(view.file);
+        return true;
+    }
+
+    Arena* arena = network->arena;
+    U8* base = view.base;
+    network->snapshot = PushStruct(arena, SnapshotView);
+    *network->snapshot = view;
+
+    NodeColumns* nodes = &network->element_store.nodes;
+    nodes->count = header->sections[SnapshotSection_NodeIds].size / sizeof(NodeId);
+    nodes->ids = _snapshot_section_ptr<NodeId>(header, base, SnapshotSection_NodeIds);
+    nodes->lat = _snapshot_section_ptr<F64>(header, base, SnapshotSection_NodeLat);
+    nodes->lon = _snapshot_section_ptr<F64>(header, base, SnapshotSection_NodeLon);
+
+    WayColumns* ways = &network->element_store.ways;
+    ways->count = header->sections[SnapshotSection_WayIds].size / sizeof(WayId);
+    ways->ids = _snapshot_section_ptr<WayId>(header, base, SnapshotSection_WayIds);
+    ways->node_spans = _snapshot_section_ptr<ElementSpan>(header, base, SnapshotSection_WayNodeSpans);
+    ways->tag_spans = _snapshot_section_ptr<ElementSpan>(header, base, SnapshotSection_WayTagSpans);
+    ways->node_ref_count = header->sections[SnapshotSection_WayNodeRefs].size / sizeof(NodeId);
+    ways->node_refs = _snapshot_section_ptr<NodeId>(header, base, SnapshotSection_WayNodeRefs);
+    network->node_type_masks = _snapshot_section_ptr<U8>(header, base, SnapshotSection_NodeTypeMasks);
+    network->node_ref_rows = _snapshot_section_ptr<U32>(header, base, SnapshotSection_NodeRefRows);
+
+    // ~mgj: intern the snapshot's strings and translate the tag indices to this process' ids
+    U64 string_count = header->sections[SnapshotSection_Strings].size / sizeof(SnapshotString);
+    SnapshotString* src_strings = _snapshot_section_ptr<SnapshotString>(header, base, SnapshotSection_Strings);
+    U8* pool = _snapshot_section_ptr<U8>(header, base, SnapshotSection_StringPool);
+    StrId* string_ids = PushArrayNoZero(arena, StrId, string_count);
+    for (U64 i = 0; i < string_count; ++i)
+    {
+        string_ids[i] = str_id_from_str8(str8(pool + src_strings[i].offset, src_strings[i].size));
+    }
+    ways->tag_count = header->sections[SnapshotSection_TagKeys].size / sizeof(U32);
+    ways->tag_keys = PushArrayNoZero(arena, StrId, ways->tag_count);
+    ways->tag_values = PushArrayNoZero(arena, StrId, ways->tag_count);
+    U32* src_tag_keys = _snapshot_section_ptr<U32>(header, base, SnapshotSection_TagKeys);
+    U32* src_tag_values = _snapshot_section_ptr<U32>(header, base, SnapshotSection_TagValues);
+    for (U64 i = 0; i < ways->tag_count; ++i)
+    {
+        ways->tag_keys[i] = string_ids[src_tag_keys[i]];
+        ways->tag_values[i] = string_ids[src_tag_values[i]];
+    }
+
+    using EcefMapType = Map<NodeId, EcefLocation>;
+    using WgsMapType = Map<NodeId, WgsLocation>;
+    network->ecef_location_map = PushStruct(arena, EcefMapType);
+    *network->ecef_location_map = {.arena = arena,
+                                   .ctrl = _snapshot_section_ptr<U8>(header, base, SnapshotSection_EcefCtrl),
+                                   .slots = _snapshot_section_ptr<MapItem<NodeId, EcefLocation>>(header, base, SnapshotSection_EcefSlots),
+                                   .capacity = header->ecef_map_capacity,
+                                   .count = header->ecef_map_count};
+    network->wgs_location_map = PushStruct(arena, WgsMapType);
+    *network->wgs_location_map = {.arena = arena,
+                                  .ctrl = _snapshot_section_ptr<U8>(header, base, SnapshotSection_WgsCtrl),
+                                  .slots = _snapshot_section_ptr<MapItem<NodeId, WgsLocation>>(header, base, SnapshotSection_WgsSlots),
+                                  .capacity = header->wgs_map_capacity,
+                                  .count = header->wgs_map_count};
+
+    SnapshotWay* src_way = _snapshot_section_ptr<SnapshotWay>(header, base, SnapshotSection_Ways);
+    NodeId* src_node_id = _snapshot_section_ptr<NodeId>(header, base, SnapshotSection_NodeIdArr);
+    for (U32 type_idx = 0; type_idx < enum_idx(WayType::Count); ++type_idx)
+    {
+        Buffer<Way> way_buf = buffer_alloc<Way>(arena, header->way_counts[type_idx]);
+        for (Way& way : way_buf)
+        {
+            way = {.id = src_way->id,
+                   .node_ids = ways->node_refs + src_way->node_span.offset,
+                   .node_count = src_way->node_span.count,
+                   .tags = {.keys = ways->tag_keys + src_way->tag_span.offset,
+                            .values = ways->tag_values + src_way->tag_span.offset,
+                            .count = src_way->tag_span.count}};
+            src_way += 1;
+        }
+        network->ways_arr[type_idx] = way_buf;
+        network->node_id_arr[type_idx] = {.data = src_node_id, .size = header->node_id_counts[type_idx]};
+        src_node_id += header->node_id_counts[type_idx];
+    }
+    _network_graph_link(network, header->ecef_map_count);
+
+    U64 edge_count = header->sections[SnapshotSection_Edges].size / sizeof(SnapshotEdge);
+    SnapshotEdge* src_edges = _snapshot_section_ptr<SnapshotEdge>(header, base, SnapshotSection_Edges);
+    Buffer<RoadEdge> edges = buffer_alloc<RoadEdge>(arena, edge_count);
+    Map<EdgeId, RoadEdge*>* edge_map = map_create<EdgeId, RoadEdge*>(arena, edge_count);
+    for (U64 i = 0; i < edge_count; ++i)
+    {
+        SnapshotEdge* src = &src_edges[i];
+        RoadEdge* edge = &edges.data[i];
+        *edge = {.prev = src->prev_idx == max_U32 ? nullptr : &edges.data[src->prev_idx],
+                 .next = src->next_idx == max_U32 ? nullptr : &edges.data[src->next_idx],
+                 .id = src->id,
+                 .node_id_from = src->node_id_from,
+                 .node_id_to = src->node_id_to,
+                 .way_id = src->way_id};
+        map_insert(edge_map, edge->id, edge);
+    }
+    network->edge_structure = {.edges = edges, .edge_map = *edge_map};
+    return false;
+}
+
+g_internal void
+snapshot_close(Network* network)
+{
+    SnapshotView* view = network->snapshot;
+    if (view)
+    {
+        os_file_map_view_close(view->map, view->base, r1u64(0, view->size));
+        os_file_map_close(view->map);
+        os_file_close(view->file);
+        network->snapshot = nullptr;
+    }
+}
+
+} // namespace osm
@@ -0,0 +1,109 @@
+#pragma once
+
+namespace osm
+{
+
+// ~mgj: Binary snapshot of a fully built Network, written next to osm_data.json. Sections hold only
+// pointer free data addressed by byte offsets from the start of the file, so a snapshot is loaded by
+// memory mapping it and pointing the element columns, location maps and node id arrays straight
+// into the view. Only the pointer linked parts (Way/Node graph, tags, edges) are rebuilt on load,
+// from the node rows resolved at build time.
+const U32 SNAPSHOT_MAGIC = 0x534f5444; // "DTOS"
+const U32 SNAPSHOT_VERSION = 3;
+const U64 SNAPSHOT_SECTION_ALIGN = 64;
+
+enum SnapshotSection : U32
+{
+    SnapshotSection_NodeIds,
+    SnapshotSection_NodeLat,
+    SnapshotSection_NodeLon,
+    SnapshotSection_WayIds,
+    SnapshotSection_WayNodeSpans,
+    SnapshotSection_WayTagSpans,
+    SnapshotSection_WayNodeRefs,
+    SnapshotSection_NodeTypeMasks,
+    SnapshotSection_NodeRefRows,
+    SnapshotSection_TagKeys,
+    SnapshotSection_TagValues,
+    SnapshotSection_Strings,
+    SnapshotSection_StringPool,
+    SnapshotSection_EcefCtrl,
+    SnapshotSection_EcefSlots,
+    SnapshotSection_WgsCtrl,
+    SnapshotSection_WgsSlots,
+    SnapshotSection_Ways,
+    SnapshotSection_NodeIdArr,
+    SnapshotSection_Edges,
+    SnapshotSection_Count
+};
+
+struct SnapshotSpan
+{
+    U64 offset; // in bytes from the start of the file
+    U64 size;   // in bytes
+};
+
+struct SnapshotHeader
+{
+    U32 magic;
+    U32 version;
+    U64 meta_hash; // hash of osm_data.json.meta when the snapshot was written
+    U64 checksum;  // of every byte after the header
+    U64 file_size;
+
+    U64 ecef_map_capacity;
+    U64 ecef_map_count;
+    U64 wgs_map_capacity;
+    U64 wgs_map_count;
+    U64 way_counts[enum_idx(WayType::Count)];     // ways per type, stored back to back in SnapshotSection_Ways
+    U64 node_id_counts[enum_idx(WayType::Count)]; // back to back in SnapshotSection_NodeIdArr
+
+    SnapshotSpan sections[SnapshotSection_Count];
+};
+
+// ~mgj: StrIds only hold within one process, so tags are stored as indices into the snapshot's own
+// string table and interned again on load. Offsets index SnapshotSection_StringPool, every string
+// there is null terminated.
+struct SnapshotString
+{
+    U32 offset;
+    U32 size;
+};
+
+// ~mgj: node and tag offsets index the element store's node_refs and tag_keys/tag_values
+struct SnapshotWay
+{
+    WayId id;
+    ElementSpan node_span;
+    ElementSpan tag_span;
+};
+
+struct SnapshotEdge
+{
+    S64 id;
+    S64 node_id_from;
+    S64 node_id_to;
+    S64 way_id;
+    U32 prev_idx; // max_U32 when the edge has no prev/next
+    U32 next_idx;
+};
+
+struct SnapshotView
+{
+    OS_Handle file;
+    OS_Handle map;
+    U8* base;
+    U64 size;
+};
+
+// ~mgj: returns true (error) when the snapshot is missing, corrupt, from another version or older
+// than the json cache. Location maps loaded from a snapshot live in a read only view and must not be
+// inserted into.
+g_internal Error
+snapshot_load(Network* network);
+g_internal B32
+snapshot_write(Network* network);
+g_internal void
+snapshot_close(Network* network);
+
+} // namespace osm
@@ -235,6 +235,13 @@ enable_bitmask(TilePipelineBits)
     return true;
 }
 
+// ~mgj: must match the MODE_ constants in road_intersection.comp
+enum RoadIntersectionMode : U32
+{
+    RoadIntersectionMode_Classify, // BVH query per triangle, caches the segment in the triangle segment buffer
+    RoadIntersectionMode_Gather,   // recolour from the cached segments, no BVH query
+};
+
 struct TilePipelineData
 {
     Handle vertex_buffer_handle;
@@ -430,7 +437,8 @@ agent_instance_compute_bucket_add(render::BufferInfo* instance_buffer_info, rend
                                   U32 instance_buffer_offset);
 
 g_internal bool
-road_intersection_compute_add(Handle vertex_buffer_handle, Handle index_buffer_handle, Handle road_segment_buffer_handle, Handle road_segment_node_buffer_handle, U32 overlay_option);
+road_intersection_compute_add(Handle vertex_buffer_handle, Handle index_buffer_handle, Handle road_segment_buffer_handle, Handle road_segment_node_buffer_handle,
+                              Handle triangle_segment_buffer_handle, U32 overlay_option, RoadIntersectionMode mode);
 
 g_internal Handle
 buffer_load_async(BufferInfo* buffer_info);
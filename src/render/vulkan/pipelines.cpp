@@ -447,12 +447,13 @@ road_intersection_pipeline_create(String8 shader_path)
     push_constant_range.offset = 0;
     push_constant_range.size = sizeof(RoadIntersectionPushConstants);
 
-    // Set 0: Road segments, road segment nodes, vertex buffer, index buffer.
+    // Set 0: Road segments, road segment nodes, vertex buffer, index buffer, triangle segment buffer.
     VkDescriptorSetLayoutBinding storage_buffer_bindings[] = {
         {0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, NULL},
         {1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, NULL},
         {2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, NULL},
         {3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, NULL},
+        {4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, NULL},
     };
 
     VkDescriptorSetLayoutCreateInfo storage_buffer_layout_info{};
@@ -27,7 +27,8 @@ ctx_get()
 }
 
 static void
-road_intersection_bucket_add(BufferHandle* vertex_buffer, BufferHandle* index_buffer, BufferHandle* road_segment_buffer, BufferHandle* road_segment_node_buffer, U32 overlay_option)
+road_intersection_bucket_add(BufferHandle* vertex_buffer, BufferHandle* index_buffer, BufferHandle* road_segment_buffer, BufferHandle* road_segment_node_buffer, BufferHandle* triangle_segment_buffer,
+                             U32 overlay_option, render::RoadIntersectionMode mode)
 {
     Context* vk_ctx = ctx_get();
     RoadIntersectionNode* node = PushStruct(vk_ctx->render_frame_arena, RoadIntersectionNode);
@@ -35,7 +36,9 @@ road_intersection_bucket_add(BufferHandle* vertex_buffer, BufferHandle* index_bu
     node->index_buffer = *index_buffer;
     node->road_segment_buffer = *road_segment_buffer;
     node->road_segment_node_buffer = *road_segment_node_buffer;
+    node->triangle_segment_buffer = *triangle_segment_buffer;
     node->overlay_option_idx = overlay_option;
+    node->mode = mode;
     SLLQueuePush(vk_ctx->render_frame->road_intersection_list.first, vk_ctx->render_frame->road_intersection_list.last, node);
 }
 
@@ -113,6 +116,7 @@ road_intersection_compute()
         RoadIntersectionPushConstants push_constants = {};
         push_constants.road_segment_buffer_elem_count = node->road_segment_buffer.elem_count;
         push_constants.overlay_option_idx = node->overlay_option_idx;
+        push_constants.mode = node->mode;
 
         vkCmdPushConstants(cmd_buffer, pipeline->pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(RoadIntersectionPushConstants), &push_constants);
 
@@ -136,6 +140,11 @@ road_intersection_compute()
         index_buffer_info.offset = 0;
         index_buffer_info.range = VK_WHOLE_SIZE;
 
+        VkDescriptorBufferInfo triangle_segment_buffer_info{};
+        triangle_segment_buffer_info.buffer = node->triangle_segment_buffer.buffer_alloc.buffer;
+        triangle_segment_buffer_info.offset = 0;
+        triangle_segment_buffer_info.range = VK_WHOLE_SIZE;
+
         VkWriteDescriptorSet push_writes[] = {
             {.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, .dstBinding = 0, .descriptorCount = 1, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .pBufferInfo = &road_segment_buffer_info},
             {.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
@@ -145,6 +154,11 @@ road_intersection_compute()
              .pBufferInfo = &road_segment_node_buffer_info},
             {.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, .dstBinding = 2, .descriptorCount = 1, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .pBufferInfo = &vertex_buffer_info},
             {.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, .dstBinding = 3, .descriptorCount = 1, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .pBufferInfo = &index_buffer_info},
+            {.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+             .dstBinding = 4,
+             .descriptorCount = 1,
+             .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+             .pBufferInfo = &triangle_segment_buffer_info},
         };
 
         cmd_push_descriptor_set_khr(cmd_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->pipeline_layout, 0, ArrayCount(push_writes), push_writes);
@@ -152,17 +166,28 @@ road_intersection_compute()
         U32 workgroup_count = (triangle_count + 255) / 256; // 256 is the workgroup size specified in the shader
         vkCmdDispatch(cmd_buffer, workgroup_count, 1, 1);
 
-        VkBufferMemoryBarrier2 barrier = {.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
-                                          .srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
-                                          .srcAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT,
-                                          .dstStageMask = VK_PIPELINE_STAGE_2_VERTEX_INPUT_BIT,
-                                          .dstAccessMask = VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT,
-                                          .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                                          .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                                          .buffer = node->vertex_buffer.buffer_alloc.buffer,
-                                          .offset = 0,
-                                          .size = node->vertex_buffer.buffer_alloc.size};
-        VkDependencyInfo dep_info = {.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO, .bufferMemoryBarrierCount = 1, .pBufferMemoryBarriers = &barrier};
+        // ~mgj: the triangle segments written by a classify pass are read by later gather passes
+        VkBufferMemoryBarrier2 barriers[] = {{.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+                                              .srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                                              .srcAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT,
+                                              .dstStageMask = VK_PIPELINE_STAGE_2_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                                              .dstAccessMask = VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                                              .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                                              .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                                              .buffer = node->vertex_buffer.buffer_alloc.buffer,
+                                              .offset = 0,
+                                              .size = node->vertex_buffer.buffer_alloc.size},
+                                             {.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+                                              .srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                                              .srcAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT,
+                                              .dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                                              .dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT,
+                                              .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                                              .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                                              .buffer = node->triangle_segment_buffer.buffer_alloc.buffer,
+                                              .offset = 0,
+                                              .size = node->triangle_segment_buffer.buffer_alloc.size}};
+        VkDependencyInfo dep_info = {.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO, .bufferMemoryBarrierCount = ArrayCount(barriers), .pBufferMemoryBarriers = barriers};
 
         vkCmdPipelineBarrier2(cmd_buffer, &dep_info);
     }
@@ -108,6 +108,7 @@ struct RoadIntersectionPushConstants
 {
     U32 road_segment_buffer_elem_count;
     U32 overlay_option_idx;
+    U32 mode;
 };
 
 struct Blend3DNode
@@ -132,7 +133,9 @@ struct RoadIntersectionNode
     BufferHandle index_buffer;
     BufferHandle road_segment_buffer;
     BufferHandle road_segment_node_buffer;
+    BufferHandle triangle_segment_buffer;
     U32 overlay_option_idx;
+    render::RoadIntersectionMode mode;
 };
 
 struct RoadIntersectionList
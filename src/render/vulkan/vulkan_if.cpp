@@ -737,7 +737,8 @@ agent_instance_render_bucket_add(render::MappedHandle<void> camera_handle, Buffe
 }
 
 g_internal bool
-road_intersection_compute_add(Handle vertex_buffer_handle, Handle index_buffer_handle, Handle road_segment_buffer_handle, Handle road_segment_node_buffer_handle, U32 overlay_option)
+road_intersection_compute_add(Handle vertex_buffer_handle, Handle index_buffer_handle, Handle road_segment_buffer_handle, Handle road_segment_node_buffer_handle,
+                              Handle triangle_segment_buffer_handle, U32 overlay_option, RoadIntersectionMode mode)
 {
     bool compute_scheduled = false;
 
@@ -745,11 +746,13 @@ road_intersection_compute_add(Handle vertex_buffer_handle, Handle index_buffer_h
     render::AssetItem<vulkan::BufferHandle>* index_buffer = 0;
     render::AssetItem<vulkan::BufferHandle>* road_segment_buffer = 0;
     render::AssetItem<vulkan::BufferHandle>* road_segment_node_buffer = 0;
+    render::AssetItem<vulkan::BufferHandle>* triangle_segment_buffer = 0;
     if (is_resource_loaded(vertex_buffer_handle, &vertex_buffer) && is_resource_loaded(index_buffer_handle, &index_buffer) && is_resource_loaded(road_segment_buffer_handle, &road_segment_buffer) &&
-        is_resource_loaded(road_segment_node_buffer_handle, &road_segment_node_buffer))
+        is_resource_loaded(road_segment_node_buffer_handle, &road_segment_node_buffer) && is_resource_loaded(triangle_segment_buffer_handle, &triangle_segment_buffer))
     {
         compute_scheduled = true;
-        vulkan::road_intersection_bucket_add(&vertex_buffer->item, &index_buffer->item, &road_segment_buffer->item, &road_segment_node_buffer->item, overlay_option);
+        vulkan::road_intersection_bucket_add(&vertex_buffer->item, &index_buffer->item, &road_segment_buffer->item, &road_segment_node_buffer->item, &triangle_segment_buffer->item, overlay_option,
+                                             mode);
     }
     return compute_scheduled;
 }
@@ -0,0 +1,138 @@
+struct TestCoroState
+{
+    async::ThreadPool* thread_pool;
+    std::atomic<U32> leaf_count;
+    std::atomic<U32> worker_step_count;
+    B32 ran_on_main_thread;
+    B32 back_on_worker;
+};
+
+g_internal async::CoTask<U64>
+test_coro_leaf(Arena* arena, TestCoroState* state, U64 value)
+{
+    (void)arena;
+    state->leaf_count.fetch_add(1);
+    co_return value * value;
+}
+
+g_internal async::CoTask<U64>
+test_coro_chain(Arena* arena, TestCoroState* state)
+{
+    U64 sum = 0;
+    for (U64 i = 0; i < 10; ++i)
+    {
+        sum += co_await test_coro_leaf(arena, state, i);
+    }
+    co_await async::co_delay(2'000);
+    sum += co_await test_coro_leaf(arena, state, 10);
+    co_return sum;
+}
+
+g_internal async::CoTask<U64>
+test_coro_when_all(TestCoroState* state)
+{
+    // ~mgj: one arena per child, children run at the same time
+    Arena* arenas[16] = {};
+    async::CoTask<U64> tasks[16];
+    for (U32 i = 0; i < ArrayCount(tasks); ++i)
+    {
+        arenas[i] = arena_alloc();
+        tasks[i] = test_coro_chain(arenas[i], state);
+    }
+    co_await async::co_when_all(tasks, ArrayCount(tasks));
+
+    U64 sum = 0;
+    for (U32 i = 0; i < ArrayCount(tasks); ++i)
+    {
+        sum += async::co_task_result(&tasks[i]);
+        tasks[i] = async::CoTask<U64>();
+        arena_release(arenas[i]);
+    }
+    co_return sum;
+}
+
+g_internal async::CoTask<U64>
+test_coro_thread_hop(TestCoroState* state)
+{
+    state->worker_step_count.fetch_add(1);
+    co_await async::co_main_thread();
+    state->ran_on_main_thread = async::thread_pool_is_main_thread(state->thread_pool);
+    co_await async::co_worker_thread();
+    state->back_on_worker = !async::thread_pool_is_main_thread(state->thread_pool);
+    co_return 1;
+}
+
+g_internal void
+test_coro_wait(async::ThreadPool* thread_pool, async::CoTask<U64>* task)
+{
+    U64 start_us = os_now_microseconds();
+    while (!async::co_task_is_done(task) && os_now_microseconds() - start_us < 5'000'000)
+    {
+        async::thread_pool_main_thread_queue_drain(thread_pool);
+        os_sleep_milliseconds(1);
+    }
+}
+
+TEST_CASE("coroutine tasks chain, delay and allocate their frames from the arena")
+{
+    Arena* arena = arena_alloc();
+    async::ThreadPool* thread_pool = async::thread_pool_create(arena, 4, 64, 64);
+
+    Arena* task_arena = arena_alloc();
+    TestCoroState state = {};
+    U64 pos_before = arena_pos(task_arena);
+    async::CoTask<U64> task = test_coro_chain(task_arena, &state);
+    CHECK(arena_pos(task_arena) > pos_before);
+    CHECK(state.leaf_count.load() == 0); // lazily started
+
+    CHECK(async::co_task_start(thread_pool, &task, S("coro chain")));
+    test_coro_wait(thread_pool, &task);
+    CHECK(async::co_task_is_done(&task));
+    CHECK(async::co_task_result(&task) == 385); // sum of i * i for i in [0, 11)
+    CHECK(state.leaf_count.load() == 11);
+
+    task = async::CoTask<U64>();
+    arena_release(task_arena);
+    async::thread_pool_destroy(thread_pool);
+    arena_release(arena);
+}
+
+TEST_CASE("coroutine when_all resumes the parent once after every child")
+{
+    Arena* arena = arena_alloc();
+    async::ThreadPool* thread_pool = async::thread_pool_create(arena, 4, 64, 64);
+
+    for (U32 iteration = 0; iteration < 20; ++iteration)
+    {
+        TestCoroState state = {};
+        async::CoTask<U64> task = test_coro_when_all(&state);
+        CHECK(async::co_task_start(thread_pool, &task));
+        test_coro_wait(thread_pool, &task);
+        CHECK(async::co_task_is_done(&task));
+        CHECK(async::co_task_result(&task) == 16 * 385);
+        CHECK(state.leaf_count.load() == 16 * 11);
+    }
+
+    async::thread_pool_destroy(thread_pool);
+    arena_release(arena);
+}
+
+TEST_CASE("coroutine hops to the main thread queue and back to a worker")
+{
+    Arena* arena = arena_alloc();
+    async::ThreadPool* thread_pool = async::thread_pool_create(arena, 2, 64, 64);
+    async::thread_pool_register_current_thread(thread_pool);
+
+    TestCoroState state = {.thread_pool = thread_pool};
+    async::CoTask<U64> task = test_coro_thread_hop(&state);
+    CHECK(async::co_task_start(thread_pool, &task));
+    test_coro_wait(thread_pool, &task);
+    CHECK(async::co_task_is_done(&task));
+    CHECK(state.worker_step_count.load() == 1);
+    CHECK(state.ran_on_main_thread);
+    CHECK(state.back_on_worker);
+
+    task = async::CoTask<U64>();
+    async::thread_pool_destroy(thread_pool);
+    arena_release(arena);
+}
@@ -0,0 +1,490 @@
+#if OS_LINUX
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// ~mgj: Loopback HTTP/1.1 server for the engine tests, one thread per connection, keep-alive. Paths:
+//     /slow/<ms>    answers after <ms> milliseconds
+//     /status/<n>   answers with status <n>
+//     /overpass     answers with overpass_body
+//     anything else answers 200 with the path as body
+// It counts connections and the most requests it had in flight at once.
+const U32 TEST_HTTP_SERVER_CONNECTION_MAX = 32;
+
+struct TestHttpServer
+{
+    int listen_fd;
+    U16 port;
+    std::thread accept_thread;
+    std::thread connection_threads[TEST_HTTP_SERVER_CONNECTION_MAX];
+    int connection_fds[TEST_HTTP_SERVER_CONNECTION_MAX];
+    std::atomic<U32> connection_count;
+    std::atomic<U32> request_count;
+    std::atomic<U32> active_request_count;
+    std::atomic<U32> max_active_request_count;
+    std::atomic<B32> stop;
+    String8 overpass_body; // set before the first request
+};
+
+g_internal void
+test_http_server_connection(TestHttpServer* server, int fd)
+{
+    char buffer[4096];
+    U64 size = 0;
+    for (;;)
+    {
+        ssize_t read_size = recv(fd, buffer + size, sizeof(buffer) - size, 0);
+        if (read_size <= 0)
+        {
+            break;
+        }
+        size += (U64)read_size;
+
+        String8 received = str8((U8*)buffer, size);
+        U64 header_end = str8_substr_find(received, S("\r\n\r\n"), 0, 0);
+        if (header_end >= received.size)
+        {
+            continue;
+        }
+
+        server->request_count.fetch_add(1);
+        U32 active_count = server->active_request_count.fetch_add(1) + 1;
+        U32 max_active_count = server->max_active_request_count.load();
+        while (active_count > max_active_count && !server->max_active_request_count.compare_exchange_weak(max_active_count, active_count))
+        {
+        }
+
+        // ~mgj: "GET /path HTTP/1.1", requests have no body
+        U64 path_start = str8_substr_find(received, S(" "), 0, 0) + 1;
+        U64 path_end = str8_substr_find(received, S(" "), path_start, 0);
+        String8 path = str8_prefix(str8_skip(received, path_start), path_end - path_start);
+        U32 status = 200;
+        String8 body = path;
+        if (str8_match(path, S("/overpass"), 0))
+        {
+            body = server->overpass_body;
+        }
+        else if (str8_match(path, S("/slow/"), MatchFlag_RightSideSloppy))
+        {
+            os_sleep_milliseconds((U32)U64FromStr8(str8_skip(path, 6), 10));
+        }
+        else if (str8_match(path, S("/status/"), MatchFlag_RightSideSloppy))
+        {
+            status = (U32)U64FromStr8(str8_skip(path, 8), 10);
+        }
+
+        char response[512];
+        int response_size = snprintf(response, sizeof(response), "HTTP/1.1 %u X\r\nContent-Length: %llu\r\nConnection: keep-alive\r\n\r\n", status, body.size);
+        server->active_request_count.fetch_sub(1);
+        send(fd, response, (size_t)response_size, MSG_NOSIGNAL);
+        for (U64 sent_size = 0; sent_size < body.size;)
+        {
+            ssize_t send_size = send(fd, body.str + sent_size, body.size - sent_size, MSG_NOSIGNAL);
+            if (send_size <= 0)
+            {
+                break;
+            }
+            sent_size += (U64)send_size;
+        }
+
+        U64 request_end = header_end + 4;
+        MemoryCopy(buffer, buffer + request_end, size - request_end);
+        size -= request_end;
+    }
+    close(fd);
+}
+
+g_internal void
+test_http_server_accept(TestHttpServer* server)
+{
+    for (;;)
+    {
+        int fd = accept(server->listen_fd, 0, 0);
+        if (fd < 0 || server->stop.load())
+        {
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+            break;
+        }
+        U32 connection_idx = server->connection_count.fetch_add(1);
+        AssertAlways(connection_idx < TEST_HTTP_SERVER_CONNECTION_MAX);
+        server->connection_fds[connection_idx] = fd;
+        server->connection_threads[connection_idx] = std::thread(test_http_server_connection, server, fd);
+    }
+}
+
+g_internal TestHttpServer*
+test_http_server_start()
+{
+    TestHttpServer* server = new TestHttpServer();
+    server->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    AssertAlways(server->listen_fd >= 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    AssertAlways(bind(server->listen_fd, (sockaddr*)&addr, sizeof(addr)) == 0);
+    AssertAlways(listen(server->listen_fd, 64) == 0);
+    socklen_t addr_size = sizeof(addr);
+    getsockname(server->listen_fd, (sockaddr*)&addr, &addr_size);
+    server->port = ntohs(addr.sin_port);
+    server->accept_thread = std::thread(test_http_server_accept, server);
+    return server;
+}
+
+g_internal void
+test_http_server_stop(TestHttpServer* server)
+{
+    server->stop.store(true);
+    shutdown(server->listen_fd, SHUT_RDWR);
+    server->accept_thread.join();
+    close(server->listen_fd);
+    U32 connection_count = server->connection_count.load();
+    for (U32 i = 0; i < connection_count; ++i)
+    {
+        shutdown(server->connection_fds[i], SHUT_RDWR);
+        server->connection_threads[i].join();
+    }
+    delete server;
+}
+
+struct TestHttpRequest
+{
+    async::HttpEngineRequest engine_request;
+    char body[64];
+    U32 body_size;
+    std::atomic<U32>* done_count;
+};
+
+g_internal size_t
+test_http_request_write(void* contents, size_t size, size_t nmemb, void* userp)
+{
+    TestHttpRequest* request = (TestHttpRequest*)userp;
+    U32 copy_size = Min((U32)(size * nmemb), (U32)sizeof(request->body) - request->body_size);
+    MemoryCopy(request->body + request->body_size, contents, copy_size);
+    request->body_size += copy_size;
+    return size * nmemb;
+}
+
+g_internal async::WorkerResult
+test_http_request_done(async::ThreadInfo thread_info, async::WorkerData data)
+{
+    (void)thread_info;
+    TestHttpRequest* request = (TestHttpRequest*)data;
+    request->done_count->fetch_add(1);
+    return {};
+}
+
+g_internal void
+test_http_request_init(TestHttpRequest* request, async::ThreadPool* thread_pool, std::atomic<U32>* done_count, U16 port, const char* path)
+{
+    char url[128];
+    snprintf(url, sizeof(url), "http://127.0.0.1:%u%s", port, path);
+    request->done_count = done_count;
+    request->engine_request.session_handle = curl_easy_init();
+    request->engine_request.thread_pool = thread_pool;
+    request->engine_request.completion = async::WorkerItem(request, test_http_request_done);
+    curl_easy_setopt(request->engine_request.session_handle, CURLOPT_URL, url);
+    curl_easy_setopt(request->engine_request.session_handle, CURLOPT_WRITEFUNCTION, test_http_request_write);
+    curl_easy_setopt(request->engine_request.session_handle, CURLOPT_WRITEDATA, request);
+}
+
+g_internal void
+test_http_wait(std::atomic<U32>* done_count, U32 expected_count)
+{
+    U64 start_us = os_now_microseconds();
+    while (done_count->load() < expected_count && os_now_microseconds() - start_us < 10'000'000)
+    {
+        os_sleep_milliseconds(1);
+    }
+}
+
+TEST_CASE("http engine reuses connections and caps connections per host")
+{
+    Arena* arena = arena_alloc();
+    async::ThreadPool* thread_pool = async::thread_pool_create(arena, 2, 64, 64);
+    TestHttpServer* server = test_http_server_start();
+    async::HttpEngineConfig config = {.max_host_connections = 2};
+    async::HttpEngine* engine = async::http_engine_create(&config);
+
+    TestHttpRequest requests[16] = {};
+    std::atomic<U32> done_count = 0;
+    for (TestHttpRequest& request : requests)
+    {
+        test_http_request_init(&request, thread_pool, &done_count, server->port, "/slow/20");
+        CHECK(async::http_engine_submit(engine, &request.engine_request));
+    }
+    test_http_wait(&done_count, ArrayCount(requests));
+
+    CHECK(done_count.load() == ArrayCount(requests));
+    B32 all_ok = true;
+    for (TestHttpRequest& request : requests)
+    {
+        all_ok = all_ok && request.engine_request.result == CURLE_OK && request.engine_request.http_code == 200;
+        all_ok = all_ok && str8_match(str8((U8*)request.body, request.body_size), S("/slow/20"), 0);
+        curl_easy_cleanup(request.engine_request.session_handle);
+    }
+    CHECK(all_ok);
+    CHECK(server->request_count.load() == ArrayCount(requests));
+    CHECK(server->max_active_request_count.load() <= 2);
+    CHECK(server->connection_count.load() <= 2);
+    CHECK(engine->connect_count.load() <= 2);
+    CHECK(engine->completed_count.load() == ArrayCount(requests));
+
+    async::http_engine_destroy(engine);
+    test_http_server_stop(server);
+    async::thread_pool_destroy(thread_pool);
+    arena_release(arena);
+}
+
+TEST_CASE("http engine reports status codes, failed connects and aborts on destroy")
+{
+    Arena* arena = arena_alloc();
+    async::ThreadPool* thread_pool = async::thread_pool_create(arena, 2, 64, 64);
+    TestHttpServer* server = test_http_server_start();
+    async::HttpEngineConfig config = {};
+    async::HttpEngine* engine = async::http_engine_create(&config);
+
+    // ~mgj: a port nothing listens on
+    int closed_fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(closed_fd, (sockaddr*)&addr, sizeof(addr));
+    socklen_t addr_size = sizeof(addr);
+    getsockname(closed_fd, (sockaddr*)&addr, &addr_size);
+    close(closed_fd);
+
+    std::atomic<U32> done_count = 0;
+    TestHttpRequest not_found = {};
+    TestHttpRequest refused = {};
+    test_http_request_init(&not_found, thread_pool, &done_count, server->port, "/status/404");
+    test_http_request_init(&refused, thread_pool, &done_count, ntohs(addr.sin_port), "/");
+    CHECK(async::http_engine_submit(engine, &not_found.engine_request));
+    CHECK(async::http_engine_submit(engine, &refused.engine_request));
+    test_http_wait(&done_count, 2);
+    CHECK(not_found.engine_request.result == CURLE_OK);
+    CHECK(not_found.engine_request.http_code == 404);
+    CHECK(refused.engine_request.result == CURLE_COULDNT_CONNECT);
+
+    TestHttpRequest aborted = {};
+    test_http_request_init(&aborted, thread_pool, &done_count, server->port, "/slow/500");
+    CHECK(async::http_engine_submit(engine, &aborted.engine_request));
+    os_sleep_milliseconds(50);
+    async::http_engine_destroy(engine);
+    test_http_wait(&done_count, 3);
+    CHECK(aborted.engine_request.result == CURLE_ABORTED_BY_CALLBACK);
+
+    curl_easy_cleanup(not_found.engine_request.session_handle);
+    curl_easy_cleanup(refused.engine_request.session_handle);
+    curl_easy_cleanup(aborted.engine_request.session_handle);
+    test_http_server_stop(server);
+    async::thread_pool_destroy(thread_pool);
+    arena_release(arena);
+}
+
+struct TestHttpTaskState
+{
+    U16 port;
+    String8 body;
+};
+
+g_internal async::CoTask<B32>
+test_http_co_task(Arena* arena, TestHttpTaskState* state)
+{
+    String8 url = push_str8f(arena, "http://127.0.0.1:%u/hello", state->port);
+    async::HttpInfo* http_info = async::http_info_create_get(arena, url);
+    async::HttpResponse response = co_await async::co_http_request(arena, http_info);
+    state->body = push_str8_copy(arena, response.body);
+    co_return !response.error.has_error() && response.http_code == 200;
+}
+
+g_internal async::UserFuncResult<TestHttpTaskState>
+test_http_task_response(Arena* arena, async::ThreadPool* thread_pool, String8 body, TestHttpTaskState* state)
+{
+    (void)thread_pool;
+    state->body = push_str8_copy(arena, body);
+    return async::UserFuncResult<TestHttpTaskState>::success();
+}
+
+TEST_CASE("coroutine and async_http tasks run their requests on the global http engine")
+{
+    Arena* arena = arena_alloc();
+    async::ThreadPool* thread_pool = async::thread_pool_create(arena, 2, 64, 64);
+    TestHttpServer* server = test_http_server_start();
+    async::HttpEngineConfig config = {};
+    async::HttpEngine* engine = async::http_engine_create(&config);
+    async::http_engine_global_set(engine);
+
+    TestHttpTaskState co_state = {.port = server->port};
+    async::AsyncTaskStatus<TestHttpTaskState>* co_task = async::async_task_co_run(thread_pool, test_http_co_task, &co_state, "http engine coroutine");
+
+    Arena* task_arena = arena_alloc();
+    TestHttpTaskState http_state = {.port = server->port};
+    String8 url = push_str8f(task_arena, "http://127.0.0.1:%u/legacy", server->port);
+    async::HttpInfo* http_info = async::http_info_create_get(task_arena, url);
+    async::AsyncHttpTaskStateConfig<TestHttpTaskState> http_config = async::AsyncHttpTaskStateConfig<TestHttpTaskState>(test_http_task_response, &http_state, 0, 0);
+    async::AsyncHttpTaskCreateResult<TestHttpTaskState> http_task = async::async_http_task_run(task_arena, thread_pool, http_info, &http_config, "http engine task");
+    CHECK(!http_task.async_result.has_error());
+
+    async::AsyncTaskResult<TestHttpTaskState> co_result = {};
+    async::AsyncTaskResult<TestHttpTaskState> http_result = {};
+    U64 start_us = os_now_microseconds();
+    while ((!co_result.done || !http_result.done) && os_now_microseconds() - start_us < 10'000'000)
+    {
+        if (!co_result.done)
+        {
+            co_result = async::async_task_is_done(co_task);
+        }
+        if (!http_result.done)
+        {
+            http_result = async::async_task_is_done(http_task.task_state);
+        }
+        os_sleep_milliseconds(1);
+    }
+    CHECK(co_result.success);
+    CHECK(http_result.success);
+    CHECK(str8_match(co_state.body, S("/hello"), 0));
+    CHECK(str8_match(http_state.body, S("/legacy"), 0));
+
+    async::http_engine_global_set(0);
+    async::http_engine_destroy(engine);
+    test_http_server_stop(server);
+    async::thread_pool_destroy(thread_pool);
+    arena_release(arena);
+}
+
+// ~mgj: an Overpass "out body; >; out skel qt;" response of a street grid, large enough to arrive in
+// many curl writes
+g_internal String8
+test_overpass_response_create(Arena* arena, U32 grid_size)
+{
+    String8List parts = {};
+    str8_list_push(arena, &parts, S("{\n  \"version\": 0.6,\n  \"generator\": \"Overpass API\",\n  \"elements\": [\n"));
+    for (U32 row = 0; row < grid_size; ++row)
+    {
+        String8List node_refs = {};
+        for (U32 col = 0; col < grid_size; ++col)
+        {
+            str8_list_push(arena, &node_refs, push_str8f(arena, col == 0 ? "%u" : ",%u", row * grid_size + col + 1));
+        }
+        String8 refs = str8_list_join(arena, &node_refs, 0);
+        str8_list_push(arena, &parts,
+                       push_str8f(arena, "{\"type\": \"way\", \"id\": %u, \"nodes\": [%.*s], \"tags\": {\"highway\": \"residential\", \"name\": \"Vej %u\"}},\n", row + 1, str8_varg(refs), row));
+    }
+    for (U32 node_idx = 0; node_idx < grid_size * grid_size; ++node_idx)
+    {
+        str8_list_push(arena, &parts,
+                       push_str8f(arena, "{\"type\": \"node\", \"id\": %u, \"lat\": %.7f, \"lon\": %.7f}%s\n", node_idx + 1, 56.1 + (node_idx / grid_size) * 1e-4,
+                                  10.1 + (node_idx % grid_size) * 1e-4, node_idx + 1 == grid_size * grid_size ? "" : ","));
+    }
+    str8_list_push(arena, &parts, S("  ]\n}\n"));
+    return str8_list_join(arena, &parts, 0);
+}
+
+struct TestHttpDownloadState
+{
+    U16 port;
+    String8 cache_file;
+    B32 body_padded;
+    B32 body_arena_owned;
+    B32 body_matches;
+    String8 expected_body;
+    Arena* parse_arena;
+    osm::ElementStore element_store;
+};
+
+g_internal async::CoTask<B32>
+test_http_download_parse(Arena* arena, TestHttpDownloadState* state, String8 body)
+{
+    Result<osm::ElementStore> store = wrapper::osm_element_store_from_simd_json(arena, body);
+    state->element_store = store.v;
+    co_return !store.err;
+}
+
+g_internal async::CoTask<B32>
+test_http_download_cache_write(Arena* arena, TestHttpDownloadState* state, String8 body)
+{
+    (void)arena;
+    cache_write(state->cache_file, body, S("test bbox"));
+    co_return true;
+}
+
+g_internal async::CoTask<B32>
+test_http_download_task(Arena* arena, TestHttpDownloadState* state)
+{
+    String8 url = push_str8f(arena, "http://127.0.0.1:%u/overpass", state->port);
+    async::HttpInfo* http_info = async::http_info_create_get(arena, url);
+    async::HttpResponse response = co_await async::co_http_download(http_info);
+    if (response.error.has_error())
+    {
+        co_return false;
+    }
+
+    state->body_arena_owned = response.body_arena != 0 && response.body.str != 0;
+    state->body_matches = str8_match(response.body, state->expected_body, 0);
+    state->body_padded = true;
+    for (U64 i = 0; i < async::HTTP_BODY_PADDING; ++i)
+    {
+        state->body_padded = state->body_padded && response.body.str[response.body.size + i] == 0;
+    }
+
+    // ~mgj: the same split as the osm fetch, parse in place while the cache file is written
+    async::CoTask<B32> tasks[] = {test_http_download_parse(state->parse_arena, state, response.body), test_http_download_cache_write(arena, state, response.body)};
+    co_await async::co_when_all(tasks, ArrayCount(tasks));
+    B32 parsed = async::co_task_result(&tasks[0]);
+    for (async::CoTask<B32>& task : tasks)
+    {
+        task = async::CoTask<B32>();
+    }
+    async::http_response_release(&response);
+    co_return parsed;
+}
+
+TEST_CASE("co_http_download streams into a padded buffer that is parsed in place")
+{
+    Arena* arena = arena_alloc();
+    async::ThreadPool* thread_pool = async::thread_pool_create(arena, 2, 64, 64);
+    TestHttpServer* server = test_http_server_start();
+    async::HttpEngineConfig config = {};
+    async::HttpEngine* engine = async::http_engine_create(&config);
+    async::http_engine_global_set(engine);
+
+    const U32 grid_size = 200;
+    TestHttpDownloadState state = {.port = server->port, .cache_file = S("test_http_download_cache.json"), .parse_arena = arena_alloc()};
+    state.expected_body = test_overpass_response_create(arena, grid_size);
+    server->overpass_body = state.expected_body;
+    CHECK(state.expected_body.size > MB(1));
+
+    async::AsyncTaskStatus<TestHttpDownloadState>* task = async::async_task_co_run(thread_pool, test_http_download_task, &state, "http download");
+    async::AsyncTaskResult<TestHttpDownloadState> result = {};
+    U64 start_us = os_now_microseconds();
+    while (!result.done && os_now_microseconds() - start_us < 10'000'000)
+    {
+        result = async::async_task_is_done(task);
+        os_sleep_milliseconds(1);
+    }
+    CHECK(result.success);
+    CHECK(state.body_arena_owned);
+    CHECK(state.body_matches);
+    CHECK(state.body_padded);
+    CHECK(state.element_store.ways.count == grid_size);
+    CHECK(state.element_store.nodes.count == grid_size * grid_size);
+    CHECK(state.element_store.ways.node_ref_count == grid_size * grid_size);
+
+    Result<String8> cached = cache_read(arena, state.cache_file, S("test bbox"));
+    CHECK_FALSE(cached.err);
+    CHECK(str8_match(cached.v, state.expected_body, 0));
+    os_delete_file_at_path(state.cache_file);
+    os_delete_file_at_path(S("test_http_download_cache.json.meta"));
+    arena_release(state.parse_arena);
+
+    async::http_engine_global_set(0);
+    async::http_engine_destroy(engine);
+    test_http_server_stop(server);
+    async::thread_pool_destroy(thread_pool);
+    arena_release(arena);
+}
+#endif
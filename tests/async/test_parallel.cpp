@@ -0,0 +1,167 @@
+struct TestParallelData
+{
+    async::ThreadPool* thread_pool;
+    std::atomic<U32>* visit_counts;
+    std::atomic<U32> chunk_count;
+};
+
+g_internal void
+test_parallel_visit_task(async::ThreadInfo thread_info, Arena* scratch_arena, void* data, U64 start_idx, U64 end_idx)
+{
+    (void)thread_info;
+    TestParallelData* parallel = (TestParallelData*)data;
+    // ~mgj: the scratch arena is usable and reset after the chunk
+    U64* scratch_values = PushArrayNoZero(scratch_arena, U64, end_idx - start_idx);
+    for (U64 i = start_idx; i < end_idx; ++i)
+    {
+        scratch_values[i - start_idx] = i;
+    }
+    for (U64 i = start_idx; i < end_idx; ++i)
+    {
+        parallel->visit_counts[scratch_values[i - start_idx]].fetch_add(1, std::memory_order_relaxed);
+    }
+    parallel->chunk_count.fetch_add(1);
+}
+
+g_internal U64
+test_parallel_sum_task(async::ThreadInfo thread_info, Arena* scratch_arena, void* data, U64 start_idx, U64 end_idx, U64 acc)
+{
+    (void)thread_info;
+    (void)scratch_arena;
+    (void)data;
+    for (U64 i = start_idx; i < end_idx; ++i)
+    {
+        acc += i;
+    }
+    return acc;
+}
+
+g_internal U64
+test_parallel_sum_combine(U64 a, U64 b)
+{
+    return a + b;
+}
+
+g_internal void
+test_parallel_nested_task(async::ThreadInfo thread_info, Arena* scratch_arena, void* data, U64 start_idx, U64 end_idx)
+{
+    (void)scratch_arena;
+    std::atomic<U64>* total = (std::atomic<U64>*)data;
+    for (U64 i = start_idx; i < end_idx; ++i)
+    {
+        total->fetch_add(async::parallel_reduce<U64>(thread_info.thread_pool, 100, 1, 0, test_parallel_sum_task, test_parallel_sum_combine, 0));
+    }
+}
+
+struct TestParallelBlockData
+{
+    std::atomic<U32> started_count;
+    std::atomic<U32> release;
+};
+
+g_internal async::WorkerResult
+test_parallel_block_task(async::ThreadInfo thread_info, async::WorkerData data)
+{
+    (void)thread_info;
+    TestParallelBlockData* block = (TestParallelBlockData*)data;
+    block->started_count.fetch_add(1);
+    while (!block->release.load())
+    {
+        std::this_thread::yield();
+    }
+    return {};
+}
+
+TEST_CASE("parallel for visits every index once")
+{
+    Arena* arena = arena_alloc();
+    async::ThreadPool* thread_pool = async::thread_pool_create(arena, 4, 64, 64);
+
+    const U64 count = 100003;
+    std::atomic<U32>* visit_counts = PushArray(arena, std::atomic<U32>, count);
+    TestParallelData parallel = {.thread_pool = thread_pool, .visit_counts = visit_counts};
+    async::parallel_for(thread_pool, count, 0, test_parallel_visit_task, &parallel);
+
+    B32 all_once = true;
+    for (U64 i = 0; i < count; ++i)
+    {
+        all_once = all_once && visit_counts[i].load() == 1;
+    }
+    CHECK(all_once);
+    // ~mgj: the range is split even though the caller could take all of it
+    CHECK(parallel.chunk_count.load() > 5);
+
+    // ~mgj: one chunk, a grain as large as the range runs inline
+    parallel.chunk_count.store(0);
+    async::parallel_for(thread_pool, 10, 10, test_parallel_visit_task, &parallel);
+    CHECK(parallel.chunk_count.load() == 1);
+    async::parallel_for(thread_pool, 0, 0, test_parallel_visit_task, &parallel);
+    async::parallel_for(0, 10, 1, test_parallel_visit_task, &parallel);
+    CHECK(parallel.chunk_count.load() == 2);
+
+    async::thread_pool_destroy(thread_pool);
+    arena_release(arena);
+}
+
+TEST_CASE("parallel reduce folds every index and nests inside parallel for")
+{
+    Arena* arena = arena_alloc();
+    async::ThreadPool* thread_pool = async::thread_pool_create(arena, 3, 64, 64);
+
+    const U64 count = 1000000;
+    U64 sum = async::parallel_reduce<U64>(thread_pool, count, 0, 0, test_parallel_sum_task, test_parallel_sum_combine, 0);
+    CHECK(sum == count * (count - 1) / 2);
+    CHECK(async::parallel_reduce<U64>(thread_pool, 0, 0, 7, test_parallel_sum_task, test_parallel_sum_combine, 0) == 7);
+
+    // ~mgj: inner loops run on workers that are themselves inside a parallel_for chunk
+    std::atomic<U64> total = 0;
+    async::parallel_for(thread_pool, 64, 1, test_parallel_nested_task, &total);
+    CHECK(total.load() == 64 * 4950);
+
+    async::thread_pool_destroy(thread_pool);
+    arena_release(arena);
+}
+
+TEST_CASE("parallel loops on a non worker thread return while every worker is busy")
+{
+    Arena* arena = arena_alloc();
+    const U32 thread_count = 3;
+    async::ThreadPool* thread_pool = async::thread_pool_create(arena, thread_count, 64, 64);
+
+    TestParallelBlockData block = {};
+    for (U32 i = 0; i < thread_count; ++i)
+    {
+        async::WorkerItem item = async::WorkerItem(&block, test_parallel_block_task);
+        AssertAlways(async::thread_pool_push(thread_pool, &item));
+    }
+    while (block.started_count.load() < thread_count)
+    {
+        std::this_thread::yield();
+    }
+
+    // ~mgj: no helper can start, the caller covers the range and does not wait for them
+    const U64 count = 10007;
+    std::atomic<U32>* visit_counts = PushArray(arena, std::atomic<U32>, count);
+    TestParallelData parallel = {.thread_pool = thread_pool, .visit_counts = visit_counts};
+    async::parallel_for(thread_pool, count, 0, test_parallel_visit_task, &parallel);
+    B32 all_once = true;
+    for (U64 i = 0; i < count; ++i)
+    {
+        all_once = all_once && visit_counts[i].load() == 1;
+    }
+    CHECK(all_once);
+    U64 sum = async::parallel_reduce<U64>(thread_pool, count, 0, 0, test_parallel_sum_task, test_parallel_sum_combine, 0);
+    CHECK(sum == count * (count - 1) / 2);
+
+    // ~mgj: the helpers start after their loops have returned and leave without a chunk
+    U32 chunk_count = parallel.chunk_count.load();
+    block.release.store(1);
+    while (async::thread_pool_has_pending_work(thread_pool))
+    {
+        std::this_thread::yield();
+    }
+    CHECK(parallel.chunk_count.load() == chunk_count);
+
+    async::thread_pool_destroy(thread_pool);
+    arena_release(arena);
+}
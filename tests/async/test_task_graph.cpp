@@ -0,0 +1,121 @@
+struct TestGraphData
+{
+    std::atomic<U32> order_counter;
+    U32 order[8];
+    B32 fail_idx_2;
+};
+
+struct TestGraphNodeData
+{
+    TestGraphData* graph_data;
+    U32 idx;
+};
+
+g_internal B32
+test_graph_node_func(async::ThreadInfo thread_info, void* data, async::CancelToken* cancel_token)
+{
+    (void)thread_info;
+    (void)cancel_token;
+    TestGraphNodeData* node_data = (TestGraphNodeData*)data;
+    TestGraphData* graph_data = node_data->graph_data;
+    graph_data->order[node_data->idx] = graph_data->order_counter.fetch_add(1) + 1;
+    return !(graph_data->fail_idx_2 && node_data->idx == 2);
+}
+
+g_internal void
+test_graph_wait_done(async::TaskGraph* graph)
+{
+    while (!async::task_graph_is_done(graph))
+    {
+        std::this_thread::yield();
+    }
+}
+
+TEST_CASE("task graph runs a diamond after its external source completes")
+{
+    Arena* arena = arena_alloc();
+    async::ThreadPool* thread_pool = async::thread_pool_create(arena, 3, 64, 64);
+
+    // ~mgj: source (external) -> 1, 2 -> 3 (fan-in), 1 -> 4
+    TestGraphData graph_data = {};
+    TestGraphNodeData node_data[5] = {};
+    async::TaskGraph* graph = async::task_graph_create(arena, thread_pool);
+    async::TaskNode* source = async::task_node_external_create(graph, S("source"));
+    async::TaskNode* nodes[5] = {source};
+    for (U32 i = 1; i < ArrayCount(nodes); ++i)
+    {
+        node_data[i] = {.graph_data = &graph_data, .idx = i};
+        nodes[i] = async::task_node_create(graph, S("node"), test_graph_node_func, &node_data[i]);
+    }
+    async::task_node_depends(nodes[1], source);
+    async::task_node_depends(nodes[2], source);
+    async::task_node_depends(nodes[3], nodes[1]);
+    async::task_node_depends(nodes[3], nodes[2]);
+    async::task_node_depends(nodes[4], nodes[1]);
+    async::task_graph_launch(graph);
+
+    // ~mgj: nothing may start before the external node completes
+    os_sleep_milliseconds(10);
+    CHECK(graph_data.order_counter.load() == 0);
+    CHECK(async::task_node_state(source) == async::TaskNodeState_Pending);
+
+    async::task_node_complete(source, true);
+    test_graph_wait_done(graph);
+    CHECK(graph_data.order_counter.load() == 4);
+    CHECK(graph_data.order[3] > graph_data.order[1]);
+    CHECK(graph_data.order[3] > graph_data.order[2]);
+    CHECK(graph_data.order[4] > graph_data.order[1]);
+    for (async::TaskNode* node : nodes)
+    {
+        CHECK(async::task_node_state(node) == async::TaskNodeState_Succeeded);
+    }
+
+    async::thread_pool_destroy(thread_pool);
+    arena_release(arena);
+}
+
+TEST_CASE("task graph cancels successors of failed and cancelled nodes")
+{
+    Arena* arena = arena_alloc();
+    async::ThreadPool* thread_pool = async::thread_pool_create(arena, 2, 64, 64);
+
+    // ~mgj: 1 -> 2 (fails) -> 3, 1 -> 4
+    TestGraphData graph_data = {.fail_idx_2 = true};
+    TestGraphNodeData node_data[5] = {};
+    async::TaskGraph* graph = async::task_graph_create(arena, thread_pool);
+    async::TaskNode* nodes[5] = {};
+    for (U32 i = 1; i < ArrayCount(nodes); ++i)
+    {
+        node_data[i] = {.graph_data = &graph_data, .idx = i};
+        nodes[i] = async::task_node_create(graph, S("node"), test_graph_node_func, &node_data[i]);
+    }
+    async::task_node_depends(nodes[2], nodes[1]);
+    async::task_node_depends(nodes[3], nodes[2]);
+    async::task_node_depends(nodes[4], nodes[1]);
+    async::task_graph_launch(graph);
+    test_graph_wait_done(graph);
+    CHECK(async::task_node_state(nodes[1]) == async::TaskNodeState_Succeeded);
+    CHECK(async::task_node_state(nodes[2]) == async::TaskNodeState_Failed);
+    CHECK(async::task_node_state(nodes[3]) == async::TaskNodeState_Cancelled);
+    CHECK(async::task_node_state(nodes[4]) == async::TaskNodeState_Succeeded);
+    CHECK(graph_data.order[3] == 0);
+
+    // ~mgj: a cancelled graph runs nothing that was still waiting, a failed external node counts as failed
+    TestGraphData cancel_data = {};
+    TestGraphNodeData cancel_node_data = {.graph_data = &cancel_data, .idx = 1};
+    async::TaskGraph* cancel_graph = async::task_graph_create(arena, thread_pool);
+    async::TaskNode* external = async::task_node_external_create(cancel_graph, S("external"));
+    async::TaskNode* waiting = async::task_node_create(cancel_graph, S("waiting"), test_graph_node_func, &cancel_node_data);
+    async::task_node_depends(waiting, external);
+    async::task_graph_launch(cancel_graph);
+    async::task_graph_cancel(cancel_graph);
+    async::task_node_complete(external, false);
+    test_graph_wait_done(cancel_graph);
+    async::task_graph_wait_idle(cancel_graph);
+    CHECK(async::task_node_state(external) == async::TaskNodeState_Failed);
+    CHECK(async::task_node_state(waiting) == async::TaskNodeState_Cancelled);
+    CHECK(cancel_data.order_counter.load() == 0);
+
+    async::thread_pool_destroy(thread_pool);
+    arena_release(arena);
+}
@@ -0,0 +1,450 @@
+struct TestForkJoinData
+{
+    async::ThreadPool* thread_pool;
+    U64* values;
+    U32 task_count;
+    std::atomic<U32> call_count;
+};
+
+g_internal void
+test_fork_join_square_task(async::ThreadInfo thread_info, void* data, U32 task_idx)
+{
+    (void)thread_info;
+    TestForkJoinData* fork_join = (TestForkJoinData*)data;
+    fork_join->values[task_idx] = (U64)task_idx * task_idx;
+    fork_join->call_count.fetch_add(1);
+}
+
+g_internal void
+test_fork_join_nested_task(async::ThreadInfo thread_info, void* data, U32 task_idx)
+{
+    (void)thread_info;
+    TestForkJoinData* fork_join = (TestForkJoinData*)data;
+    U64 inner_values[16] = {};
+    TestForkJoinData inner = {.thread_pool = fork_join->thread_pool, .values = inner_values, .task_count = ArrayCount(inner_values)};
+    async::thread_pool_fork_join(fork_join->thread_pool, inner.task_count, test_fork_join_square_task, &inner);
+
+    U64 sum = 0;
+    for (U64 value : inner_values)
+    {
+        sum += value;
+    }
+    fork_join->values[task_idx] = sum;
+    fork_join->call_count.fetch_add(1);
+}
+
+TEST_CASE("thread pool fork join runs every task once")
+{
+    Arena* arena = arena_alloc();
+    async::ThreadPool* thread_pool = async::thread_pool_create(arena, 4, 64, 64);
+
+    U64 values[1000] = {};
+    TestForkJoinData fork_join = {.thread_pool = thread_pool, .values = values, .task_count = ArrayCount(values)};
+    async::thread_pool_fork_join(thread_pool, fork_join.task_count, test_fork_join_square_task, &fork_join);
+
+    B32 all_set = true;
+    for (U32 i = 0; i < ArrayCount(values); ++i)
+    {
+        all_set = all_set && values[i] == (U64)i * i;
+    }
+    CHECK(fork_join.call_count.load() == ArrayCount(values));
+    CHECK(all_set);
+
+    async::thread_pool_destroy(thread_pool);
+    arena_release(arena);
+}
+
+TEST_CASE("thread pool fork join can be nested inside worker tasks")
+{
+    Arena* arena = arena_alloc();
+    // ~mgj: fewer workers than outer tasks, waiting workers have to help or this deadlocks
+    async::ThreadPool* thread_pool = async::thread_pool_create(arena, 2, 64, 64);
+
+    U64 values[8] = {};
+    TestForkJoinData fork_join = {.thread_pool = thread_pool, .values = values, .task_count = ArrayCount(values)};
+    async::thread_pool_fork_join(thread_pool, fork_join.task_count, test_fork_join_nested_task, &fork_join);
+
+    B32 all_set = true;
+    for (U64 value : values)
+    {
+        all_set = all_set && value == 1240; // sum of i * i for i in [0, 16)
+    }
+    CHECK(fork_join.call_count.load() == ArrayCount(values));
+    CHECK(all_set);
+
+    async::thread_pool_destroy(thread_pool);
+    arena_release(arena);
+}
+
+TEST_CASE("spmc queue hands every item to exactly one of owner and thieves")
+{
+    const U32 item_count = 200000;
+    const U32 thief_count = 3;
+    Arena* arena = arena_alloc();
+    // ~mgj: small initial ring so the owner grows it while thieves read from it
+    async::SpmcQueue<U32>* queue = async::spmc_queue_create<U32>(arena_alloc(), 1);
+    std::atomic<U32>* seen = PushArray(arena, std::atomic<U32>, item_count);
+    std::atomic<B32> done = false;
+
+    std::thread thieves[thief_count];
+    for (std::thread& thief : thieves)
+    {
+        thief = std::thread([&]() {
+            U32 value = 0;
+            while (!done.load())
+            {
+                if (async::spmc_queue_steal(queue, value))
+                {
+                    seen[value].fetch_add(1);
+                }
+            }
+        });
+    }
+
+    U32 value = 0;
+    for (U32 i = 0; i < item_count; ++i)
+    {
+        async::spmc_queue_push(queue, i);
+        // ~mgj: pop every third push so the owner races the thieves for the last item too
+        if (i % 3 == 0 && async::spmc_queue_pop(queue, value))
+        {
+            seen[value].fetch_add(1);
+        }
+    }
+    while (async::spmc_queue_pop(queue, value))
+    {
+        seen[value].fetch_add(1);
+    }
+    // ~mgj: a thief that lost the race for the last item already gave up, nothing is left behind
+    while (async::spmc_queue_count(queue) > 0)
+    {
+        std::this_thread::yield();
+    }
+    done.store(true);
+    for (std::thread& thief : thieves)
+    {
+        thief.join();
+    }
+
+    B32 all_once = true;
+    for (U32 i = 0; i < item_count; ++i)
+    {
+        all_once = all_once && seen[i].load() == 1;
+    }
+    CHECK(all_once);
+
+    async::spmc_queue_destroy(queue);
+    arena_release(arena);
+}
+
+TEST_CASE("mpmc ring delivers every item once and reports full")
+{
+    Arena* arena = arena_alloc();
+    async::MpmcRing<U32>* ring = async::mpmc_ring_alloc<U32>(arena, 5);
+    CHECK(ring->mask + 1 == 8);
+    U32 value = 0;
+    for (U32 i = 0; i < 8; ++i)
+    {
+        CHECK(async::mpmc_ring_try_push(ring, &i));
+    }
+    CHECK(!async::mpmc_ring_try_push(ring, &value));
+    CHECK(async::mpmc_ring_count(ring) == 8);
+    for (U32 i = 0; i < 8; ++i)
+    {
+        CHECK((async::mpmc_ring_try_pop(ring, &value) && value == i));
+    }
+    CHECK(!async::mpmc_ring_try_pop(ring, &value));
+
+    const U32 producer_count = 4;
+    const U32 per_producer = 50000;
+    async::MpmcRing<U32>* shared = async::mpmc_ring_alloc<U32>(arena, 64);
+    std::atomic<U32>* seen = PushArray(arena, std::atomic<U32>, producer_count * per_producer);
+    std::atomic<U32> consumed = 0;
+    std::thread threads[producer_count * 2];
+    for (U32 p = 0; p < producer_count; ++p)
+    {
+        threads[p] = std::thread([&, p]() {
+            for (U32 i = 0; i < per_producer; ++i)
+            {
+                U32 item = p * per_producer + i;
+                while (!async::mpmc_ring_try_push(shared, &item))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+        threads[producer_count + p] = std::thread([&]() {
+            U32 item = 0;
+            while (consumed.load() < producer_count * per_producer)
+            {
+                if (async::mpmc_ring_try_pop(shared, &item))
+                {
+                    seen[item].fetch_add(1);
+                    consumed.fetch_add(1);
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    B32 all_once = true;
+    for (U32 i = 0; i < producer_count * per_producer; ++i)
+    {
+        all_once = all_once && seen[i].load() == 1;
+    }
+    CHECK(all_once);
+    arena_release(arena);
+}
+
+struct TestSpawnData
+{
+    async::ThreadPool* thread_pool;
+    std::atomic<U32> run_count;
+};
+
+g_internal async::WorkerResult
+test_spawn_leaf_task(async::ThreadInfo thread_info, async::WorkerData data)
+{
+    (void)thread_info;
+    ((TestSpawnData*)data)->run_count.fetch_add(1);
+    return {};
+}
+
+g_internal async::WorkerResult
+test_spawn_parent_task(async::ThreadInfo thread_info, async::WorkerData data)
+{
+    TestSpawnData* spawn = (TestSpawnData*)data;
+    spawn->run_count.fetch_add(1);
+    // ~mgj: pushed from a worker, lands in its local deque and may be stolen
+    async::WorkerItem child = async::WorkerItem(data, test_spawn_leaf_task);
+    AssertAlways(async::thread_pool_push(thread_info.thread_pool, &child));
+    return {};
+}
+
+TEST_CASE("thread pool runs external and worker pushed tasks once")
+{
+    Arena* arena = arena_alloc();
+    // ~mgj: a small ring forces external pushes into the overflow list
+    async::ThreadPool* thread_pool = async::thread_pool_create(arena, 4, 16, 16);
+
+    TestSpawnData spawn = {.thread_pool = thread_pool};
+    const U32 parent_count = 20000;
+    B32 all_pushed = true;
+    for (U32 i = 0; i < parent_count; ++i)
+    {
+        async::WorkerItem item = async::WorkerItem(&spawn, test_spawn_parent_task);
+        all_pushed = all_pushed && async::thread_pool_push(thread_pool, &item, i % 1000 == 0 ? 1000 : 0);
+    }
+    CHECK(all_pushed);
+    while (async::thread_pool_has_pending_work(thread_pool))
+    {
+        std::this_thread::yield();
+    }
+    CHECK(spawn.run_count.load() == parent_count * 2);
+
+    // ~mgj: every worker parks once the pool drains, a later push still wakes one
+    os_sleep_milliseconds(20);
+    CHECK(thread_pool->parked_count.load() == 4);
+    async::WorkerItem item = async::WorkerItem(&spawn, test_spawn_leaf_task);
+    CHECK(async::thread_pool_push(thread_pool, &item));
+    while (async::thread_pool_has_pending_work(thread_pool))
+    {
+        std::this_thread::yield();
+    }
+    CHECK(spawn.run_count.load() == parent_count * 2 + 1);
+
+    async::thread_pool_destroy(thread_pool);
+    arena_release(arena);
+}
+
+TEST_CASE("queue full policies fail, spill and block")
+{
+    Arena* arena = arena_alloc();
+    U32 value = 0;
+
+    async::Queue<U32>* fail_queue = async::queue_alloc<U32>(arena, 4, async::QueueFullPolicy_Fail);
+    for (U32 i = 0; i < 4; ++i)
+    {
+        CHECK(async::queue_push(fail_queue, &i));
+    }
+    CHECK(!async::queue_push(fail_queue, &value));
+    CHECK(async::queue_count(fail_queue) == 4);
+    async::queue_release(fail_queue);
+
+    // ~mgj: spilled items come out after the ring, nothing is lost
+    async::Queue<U32>* spill_queue = async::queue_alloc<U32>(arena, 4, async::QueueFullPolicy_Spill);
+    for (U32 i = 0; i < 100; ++i)
+    {
+        CHECK(async::queue_push(spill_queue, &i));
+    }
+    CHECK(async::queue_count(spill_queue) == 100);
+    U64 sum = 0;
+    U32 read_count = 0;
+    while (async::queue_try_read(spill_queue, &value))
+    {
+        sum += value;
+        read_count += 1;
+    }
+    CHECK(read_count == 100);
+    CHECK(sum == 99 * 100 / 2);
+    async::queue_release(spill_queue);
+
+    // ~mgj: the producer pushes more than fits and has to wait for the consumer every time
+    const U32 item_count = 100000;
+    async::Queue<U32>* block_queue = async::queue_alloc<U32>(arena, 2, async::QueueFullPolicy_Block);
+    std::atomic<B32> all_pushed = true;
+    std::thread producer = std::thread([&]() {
+        for (U32 i = 0; i < item_count; ++i)
+        {
+            if (!async::queue_push(block_queue, &i))
+            {
+                all_pushed.store(false);
+            }
+        }
+    });
+    B32 in_order = true;
+    for (U32 expected = 0; expected < item_count;)
+    {
+        if (async::queue_try_read(block_queue, &value))
+        {
+            in_order = in_order && value == expected;
+            expected += 1;
+        }
+    }
+    producer.join();
+    CHECK(all_pushed.load());
+    CHECK(in_order);
+
+    // ~mgj: closing releases a blocked producer without queueing its item
+    U32 filler = 0;
+    while (async::queue_try_push(block_queue, &filler))
+    {
+    }
+    std::atomic<B32> blocked_result = true;
+    producer = std::thread([&]() { blocked_result.store(async::queue_push(block_queue, &filler)); });
+    while (block_queue->blocked_count.load() == 0)
+    {
+        std::this_thread::yield();
+    }
+    async::queue_close(block_queue);
+    producer.join();
+    CHECK(!blocked_result.load());
+    CHECK(!async::queue_try_push(block_queue, &filler));
+    async::queue_release(block_queue);
+
+    arena_release(arena);
+}
+
+struct TestLaneData
+{
+    async::ThreadPool* thread_pool;
+    std::atomic<U32> background_running_count;
+    std::atomic<U32> background_running_max;
+    std::atomic<U32> background_done_count;
+    std::atomic<U32> background_done_at_interactive;
+    std::atomic<U32> inherited_background_count;
+};
+
+g_internal async::WorkerResult
+test_lane_child_task(async::ThreadInfo thread_info, async::WorkerData data)
+{
+    (void)thread_info;
+    TestLaneData* lane = (TestLaneData*)data;
+    if (async::t_cur_priority == async::ThreadPoolPriority_Background)
+    {
+        lane->inherited_background_count.fetch_add(1);
+    }
+    return {};
+}
+
+g_internal async::WorkerResult
+test_lane_background_task(async::ThreadInfo thread_info, async::WorkerData data)
+{
+    TestLaneData* lane = (TestLaneData*)data;
+    U32 running_count = lane->background_running_count.fetch_add(1) + 1;
+    U32 running_max = lane->background_running_max.load();
+    while (running_count > running_max && !lane->background_running_max.compare_exchange_weak(running_max, running_count))
+    {
+    }
+    os_sleep_milliseconds(5);
+    async::WorkerItem child = async::WorkerItem(data, test_lane_child_task);
+    AssertAlways(async::thread_pool_push(thread_info.thread_pool, &child));
+    lane->background_running_count.fetch_sub(1);
+    lane->background_done_count.fetch_add(1);
+    return {};
+}
+
+g_internal async::WorkerResult
+test_lane_interactive_task(async::ThreadInfo thread_info, async::WorkerData data)
+{
+    (void)thread_info;
+    TestLaneData* lane = (TestLaneData*)data;
+    lane->background_done_at_interactive.store(lane->background_done_count.load());
+    return {};
+}
+
+g_internal void
+test_lane_fork_join_task(async::ThreadInfo thread_info, void* data, U32 task_idx)
+{
+    (void)thread_info;
+    (void)task_idx;
+    ((std::atomic<U32>*)data)->fetch_add(1);
+}
+
+g_internal async::WorkerResult
+test_lane_background_fork_join_task(async::ThreadInfo thread_info, async::WorkerData data)
+{
+    async::thread_pool_fork_join(thread_info.thread_pool, 16, test_lane_fork_join_task, data);
+    return {};
+}
+
+TEST_CASE("thread pool lanes cap background work and run interactive work first")
+{
+    Arena* arena = arena_alloc();
+    async::ThreadPool* thread_pool = async::thread_pool_create(arena, 4, 64, 64);
+
+    const U32 background_count = 40;
+    TestLaneData lane = {.thread_pool = thread_pool};
+    {
+        async::ThreadPoolPriorityScope priority_scope = async::ThreadPoolPriorityScope(async::ThreadPoolPriority_Background);
+        for (U32 i = 0; i < background_count; ++i)
+        {
+            async::WorkerItem item = async::WorkerItem(&lane, test_lane_background_task);
+            CHECK(async::thread_pool_push(thread_pool, &item));
+        }
+    }
+    lane.background_done_at_interactive.store(max_U32);
+    async::WorkerItem interactive = async::WorkerItem(&lane, test_lane_interactive_task);
+    interactive.priority = async::ThreadPoolPriority_Interactive;
+    CHECK(async::thread_pool_push(thread_pool, &interactive));
+    while (async::thread_pool_has_pending_work(thread_pool))
+    {
+        std::this_thread::yield();
+    }
+
+    // ~mgj: half of the workers take background work, the interactive task does not wait behind it and
+    // the children of background tasks stay in the Background lane
+    CHECK(lane.background_done_count.load() == background_count);
+    CHECK(lane.background_running_max.load() <= thread_pool->background_slot_count);
+    CHECK(lane.background_done_at_interactive.load() < background_count / 2);
+    CHECK(lane.inherited_background_count.load() == background_count);
+    CHECK(thread_pool->background_running_count.load() == 0);
+    async::thread_pool_destroy(thread_pool);
+
+    // ~mgj: with a single background slot the slot holder has to run its own fork/join children
+    thread_pool = async::thread_pool_create(arena, 2, 64, 64);
+    std::atomic<U32> fork_join_count = 0;
+    async::WorkerItem item = async::WorkerItem(&fork_join_count, test_lane_background_fork_join_task);
+    item.priority = async::ThreadPoolPriority_Background;
+    CHECK(async::thread_pool_push(thread_pool, &item));
+    while (async::thread_pool_has_pending_work(thread_pool))
+    {
+        std::this_thread::yield();
+    }
+    CHECK(fork_join_count.load() == 16);
+    async::thread_pool_destroy(thread_pool);
+    arena_release(arena);
+}
@@ -0,0 +1,91 @@
+TEST_CASE("latency histogram buckets are monotonic and within an eighth of the value")
+{
+    B32 monotonic = true;
+    B32 within_bound = true;
+    U32 prev_bucket_idx = 0;
+    for (U64 us = 0; us < (1ull << 20); us += 1 + us / 64)
+    {
+        U32 bucket_idx = async::latency_histogram_bucket_from_us(us);
+        U64 upper_us = async::latency_histogram_us_from_bucket(bucket_idx);
+        monotonic = monotonic && bucket_idx >= prev_bucket_idx;
+        within_bound = within_bound && upper_us >= us && upper_us - us <= us / async::LATENCY_HISTOGRAM_SUB_BUCKET_COUNT;
+        prev_bucket_idx = bucket_idx;
+    }
+    CHECK(monotonic);
+    CHECK(within_bound);
+    CHECK(async::latency_histogram_bucket_from_us((1ull << async::LATENCY_HISTOGRAM_MAX_BITS) - 1) == async::LATENCY_HISTOGRAM_BUCKET_COUNT - 1);
+    CHECK(async::latency_histogram_bucket_from_us(max_U64) == async::LATENCY_HISTOGRAM_BUCKET_COUNT - 1);
+
+    Arena* arena = arena_alloc();
+    async::LatencyHistogram* histogram = PushStruct(arena, async::LatencyHistogram);
+    for (U64 us = 1; us <= 1000; ++us)
+    {
+        async::latency_histogram_record(histogram, us);
+    }
+    async::LatencySummary summary = async::latency_histogram_summary(histogram);
+    CHECK(summary.count == 1000);
+    CHECK(summary.mean_us == doctest::Approx(500.5));
+    CHECK((summary.p50_us >= 500 && summary.p50_us <= 500 + 500 / 8));
+    CHECK((summary.p99_us >= 990 && summary.p99_us <= 990 + 990 / 8));
+    CHECK((summary.max_us >= 1000 && summary.max_us <= 1000 + 1000 / 8));
+    arena_release(arena);
+}
+
+struct TestStatsTask
+{
+    std::atomic<U32> run_count;
+    U32 continuation_count;
+};
+
+g_internal async::WorkerResult
+test_stats_task(async::ThreadInfo thread_info, async::WorkerData data)
+{
+    (void)thread_info;
+    TestStatsTask* task = (TestStatsTask*)data;
+    async::WorkerResult result = {};
+    if (task->run_count.fetch_add(1) + 1 < task->continuation_count)
+    {
+        result.next_task = async::WorkerItem(task, test_stats_task);
+    }
+    return result;
+}
+
+TEST_CASE("thread pool stats count named tasks and their continuations")
+{
+    Arena* arena = arena_alloc();
+    async::ThreadPool* thread_pool = async::thread_pool_create(arena, 4, 64, 64);
+
+    U32 name_id = async::thread_pool_stats_task_name_id(thread_pool, S("Stats \"Test\" Task"));
+    CHECK(name_id != 0);
+    CHECK(async::thread_pool_stats_task_name_id(thread_pool, S("Stats \"Test\" Task")) == name_id);
+    CHECK(async::thread_pool_stats_task_name_id(thread_pool, S("")) == 0);
+
+    TestStatsTask task = {.continuation_count = 50};
+    async::WorkerItem item = async::WorkerItem(&task, test_stats_task);
+    item.name_id = name_id;
+    REQUIRE(async::thread_pool_push(thread_pool, &item));
+    while (async::thread_pool_has_pending_work(thread_pool))
+    {
+        std::this_thread::yield();
+    }
+
+    async::ThreadPoolStatsSnapshot snapshot = async::thread_pool_stats_snapshot(arena, thread_pool);
+    U64 task_count = 0;
+    for (async::ThreadPoolWorkerStatsSnapshot& worker : snapshot.workers)
+    {
+        task_count += worker.task_count;
+    }
+    CHECK(task_count == task.continuation_count);
+    REQUIRE(snapshot.tasks.size == 1);
+    CHECK(str8_match(snapshot.tasks.data[0].name, S("Stats \"Test\" Task"), 0));
+    CHECK(snapshot.tasks.data[0].run.count == task.continuation_count);
+    CHECK(snapshot.tasks.data[0].wait.count == task.continuation_count);
+
+    String8 json = async::thread_pool_stats_json(arena, &snapshot);
+    CHECK(str8_substr_find(json, S("\"name\": \"Stats \\\"Test\\\" Task\""), 0, 0) < json.size);
+    String8 csv = async::thread_pool_stats_csv(arena, &snapshot);
+    CHECK(str8_substr_find(csv, S(",task,1,\"Stats \"\"Test\"\" Task\","), 0, 0) < csv.size);
+
+    async::thread_pool_destroy(thread_pool);
+    arena_release(arena);
+}
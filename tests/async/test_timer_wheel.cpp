@@ -0,0 +1,142 @@
+TEST_CASE("timer wheel fires in deadline order across levels and never early")
+{
+    const U64 tick_us = 1000;
+    const U64 start_us = 123456789;
+    async::TimerWheel<U64>* wheel = async::timer_wheel_alloc<U64>(tick_us, start_us);
+
+    // ~mgj: one per level, a level boundary, and one beyond the top level
+    U64 delays[] = {1, 500, 63 * tick_us, 64 * tick_us, 5000 * tick_us, 300000 * tick_us, 17000000ull * tick_us};
+    for (U64 i = ArrayCount(delays); i > 0; --i)
+    {
+        U64 deadline_us = start_us + delays[i - 1];
+        async::timer_wheel_insert(wheel, &deadline_us, deadline_us);
+    }
+    CHECK(wheel->count == ArrayCount(delays));
+
+    U64 now_us = start_us;
+    U64 fired_count = 0;
+    B32 never_early = true;
+    B32 in_order = true;
+    U64 prev_deadline_us = 0;
+    while (fired_count < ArrayCount(delays))
+    {
+        U64 next_us = async::timer_wheel_next_us(wheel);
+        REQUIRE(next_us != max_U64);
+        now_us = Max(now_us, next_us);
+        U64 deadline_us = 0;
+        while (async::timer_wheel_pop_due(wheel, now_us, &deadline_us))
+        {
+            never_early = never_early && deadline_us <= now_us;
+            in_order = in_order && deadline_us >= prev_deadline_us;
+            prev_deadline_us = deadline_us;
+            fired_count += 1;
+        }
+    }
+    CHECK(never_early);
+    CHECK(in_order);
+    // ~mgj: the last one fired on the first tick at or after its deadline
+    CHECK(now_us - prev_deadline_us < tick_us);
+    CHECK(wheel->count == 0);
+    CHECK(async::timer_wheel_next_us(wheel) == max_U64);
+
+    U64 value = 0;
+    CHECK(!async::timer_wheel_pop_due(wheel, now_us + 1000 * tick_us, &value));
+
+    async::timer_wheel_release(wheel);
+}
+
+TEST_CASE("timer wheel fires past deadlines on the next pop and skips idle time")
+{
+    const U64 tick_us = 1000;
+    async::TimerWheel<U64>* wheel = async::timer_wheel_alloc<U64>(tick_us, 0);
+
+    // ~mgj: a long idle stretch without pops, then a deadline that is already behind the wheel
+    U64 value = 0;
+    CHECK(!async::timer_wheel_pop_due(wheel, 1000000 * tick_us, &value));
+    U64 late_us = 10;
+    async::timer_wheel_insert(wheel, &late_us, late_us);
+    CHECK(async::timer_wheel_next_us(wheel) <= 1000000 * tick_us);
+    CHECK(async::timer_wheel_pop_due(wheel, 1000000 * tick_us, &value));
+    CHECK(value == late_us);
+
+    // ~mgj: many entries in one slot all fire on the same pop, entries are recycled
+    for (U64 i = 0; i < 1000; ++i)
+    {
+        U64 deadline_us = 1000000 * tick_us + 200 * tick_us + i % 7;
+        async::timer_wheel_insert(wheel, &i, deadline_us);
+    }
+    U64 fired_count = 0;
+    CHECK(!async::timer_wheel_pop_due(wheel, 1000000 * tick_us + 199 * tick_us, &value));
+    while (async::timer_wheel_pop_due(wheel, 1000000 * tick_us + 201 * tick_us, &value))
+    {
+        fired_count += 1;
+    }
+    CHECK(fired_count == 1000);
+    CHECK(wheel->free_first != 0);
+
+    async::timer_wheel_release(wheel);
+}
+
+struct TestTimerData
+{
+    std::atomic<U64> fired_us[8];
+};
+
+g_internal async::WorkerResult
+test_timer_task(async::ThreadInfo thread_info, async::WorkerData data)
+{
+    (void)thread_info;
+    std::atomic<U64>* fired_us = (std::atomic<U64>*)data;
+    fired_us->store(os_now_microseconds());
+    return {};
+}
+
+TEST_CASE("thread pool runs delayed tasks after their delay")
+{
+    Arena* arena = arena_alloc();
+    async::ThreadPool* thread_pool = async::thread_pool_create(arena, 2, 64, 64);
+
+    TestTimerData timer = {};
+    U64 pushed_us = os_now_microseconds();
+    for (U32 i = 0; i < ArrayCount(timer.fired_us); ++i)
+    {
+        async::WorkerItem item = async::WorkerItem(&timer.fired_us[i], test_timer_task);
+        // ~mgj: pushed out of order, the later deadlines first
+        CHECK(async::thread_pool_push(thread_pool, &item, (S64)(ArrayCount(timer.fired_us) - i) * 5000));
+    }
+    while (async::thread_pool_has_pending_work(thread_pool))
+    {
+        std::this_thread::yield();
+    }
+
+    B32 never_early = true;
+    for (U32 i = 0; i < ArrayCount(timer.fired_us); ++i)
+    {
+        never_early = never_early && timer.fired_us[i].load() >= pushed_us + (ArrayCount(timer.fired_us) - i) * 5000;
+    }
+    CHECK(never_early);
+
+    async::thread_pool_destroy(thread_pool);
+    arena_release(arena);
+}
+
+TEST_CASE("thread pool timer thread sleeps until a far deadline")
+{
+    Arena* arena = arena_alloc();
+    async::ThreadPool* thread_pool = async::thread_pool_create(arena, 2, 64, 64);
+
+    // ~mgj: a wait that returns at once (a deadline read on the wrong clock) spins the loop millions of times in
+    // this window, a sleeping timer thread goes around it a handful of times
+    std::atomic<U64> fired_us = 0;
+    async::WorkerItem item = async::WorkerItem(&fired_us, test_timer_task);
+    CHECK(async::thread_pool_push(thread_pool, &item, (S64)Million(60)));
+    os_sleep_milliseconds(50);
+    U64 wake_count_before = async::thread_pool_stats_snapshot(arena, thread_pool).timer_wake_count;
+    os_sleep_milliseconds(200);
+    U64 wake_count_after = async::thread_pool_stats_snapshot(arena, thread_pool).timer_wake_count;
+    CHECK(wake_count_after - wake_count_before < 10);
+    CHECK(fired_us.load() == 0);
+
+    async::thread_pool_destroy(thread_pool);
+    arena_release(arena);
+}
@@ -135,3 +135,68 @@ TEST_CASE("Dynamic Array Grows")
     dynamic_array_destroy(&array);
     dynamic_array_release();
 }
+
+TEST_CASE("Hash Index Insert And Get With Growth")
+{
+    Arena* arena = arena_alloc();
+    Debug_SetName(arena, "test hash index arena");
+    defer(arena_release(arena));
+
+    HashIndex<U64, U64>* index = hash_index_create<U64, U64>(arena, 4);
+    U64 initial_capacity = index->capacity;
+    const U64 key_count = 10000;
+    B32 all_inserted = true;
+    for (U64 key = 1; key <= key_count; ++key)
+    {
+        U64 value = key * 3;
+        all_inserted &= hash_index_insert(index, key * 7919, value) != nullptr;
+    }
+    CHECK(all_inserted);
+
+    CHECK(index->count == key_count);
+    CHECK(index->capacity > initial_capacity);
+    CHECK(IsPow2(index->capacity));
+    CHECK(index->count * 4 <= index->capacity * 3);
+
+    B32 all_found = true;
+    for (U64 key = 1; key <= key_count; ++key)
+    {
+        U64* value = hash_index_get(index, key * 7919);
+        all_found &= value && *value == key * 3;
+    }
+    CHECK(all_found);
+    CHECK(hash_index_get(index, (U64)5) == nullptr);
+
+    U64 duplicate = 0;
+    CHECK(hash_index_insert(index, (U64)7919, duplicate) == nullptr);
+    CHECK(*hash_index_get(index, (U64)7919) == 3);
+}
+
+TEST_CASE("Hash Index Get Or Insert And Custom Empty Key")
+{
+    Arena* arena = arena_alloc();
+    Debug_SetName(arena, "test hash index arena");
+    defer(arena_release(arena));
+
+    // ~mgj: 4 byte keys take the scalar group match, and 0 is a valid key when another empty key is given
+    HashIndex<U32, U32>* index = hash_index_create<U32, U32>(arena, 100, max_U32);
+    U64 capacity = index->capacity;
+
+    B32 inserted = false;
+    U32* value = hash_index_get_or_insert(index, (U32)0, &inserted);
+    CHECK(inserted);
+    CHECK(*value == 0);
+    *value = 42;
+
+    value = hash_index_get_or_insert(index, (U32)0, &inserted);
+    CHECK_FALSE(inserted);
+    CHECK(*value == 42);
+
+    for (U32 key = 1; key < 100; ++key)
+    {
+        hash_index_get_or_insert(index, key, &inserted);
+    }
+    // ~mgj: pre-sized for 100 keys so no rehash happened
+    CHECK(index->capacity == capacity);
+    CHECK(index->count == 100);
+}
@@ -0,0 +1,123 @@
+TEST_CASE("Map insert and get")
+{
+    Arena* arena = arena_alloc();
+    Debug_SetName(arena, "test map arena");
+    defer(arena_release(arena));
+
+    Map<S64, U32>* map = map_create<S64, U32>(arena, 4);
+    U32 value = 7;
+    CHECK(map_insert(map, (S64)-3, value) != nullptr);
+    CHECK(map_insert(map, (S64)-3, value) == nullptr);
+    CHECK(map->count == 1);
+
+    U32* out = nullptr;
+    CHECK(map_get(map, (S64)-3, &out) == MapResult::Success);
+    CHECK(*out == 7);
+    CHECK(map_get(map, (S64)4, &out) == MapResult::NotFound);
+    CHECK(out == nullptr);
+}
+
+TEST_CASE("Map grows past its initial capacity")
+{
+    Arena* arena = arena_alloc();
+    Debug_SetName(arena, "test map arena");
+    defer(arena_release(arena));
+
+    Map<U64, U64>* map = map_create<U64, U64>(arena, 10);
+    const U64 key_count = 100000;
+    for (U64 key = 0; key < key_count; ++key)
+    {
+        U64 value = key + 1;
+        map_insert(map, key, value);
+    }
+    CHECK(map->count == key_count);
+    CHECK(IsPow2(map->capacity));
+    CHECK(map->count * 8 <= map->capacity * 7);
+
+    B32 all_found = true;
+    for (U64 key = 0; key < key_count; ++key)
+    {
+        U64* value = map_get(map, key);
+        all_found &= value && *value == key + 1;
+    }
+    CHECK(all_found);
+    CHECK(map_get(map, key_count) == nullptr);
+}
+
+TEST_CASE("Map remove keeps remaining keys reachable")
+{
+    Arena* arena = arena_alloc();
+    Debug_SetName(arena, "test map arena");
+    defer(arena_release(arena));
+
+    Map<U64, U64>* map = map_create<U64, U64>(arena, 20000);
+    for (U64 key = 1; key <= 20000; ++key)
+    {
+        map_insert(map, key, key);
+    }
+    B32 all_removed = true;
+    for (U64 key = 1; key <= 20000; key += 2)
+    {
+        all_removed &= map_remove(map, key);
+    }
+    CHECK(all_removed);
+    CHECK_FALSE(map_remove(map, (U64)1));
+    CHECK(map->count == 10000);
+
+    B32 layout_ok = true;
+    for (U64 key = 1; key <= 20000; ++key)
+    {
+        U64* value = map_get(map, key);
+        layout_ok &= (key % 2) ? value == nullptr : (value && *value == key);
+    }
+    CHECK(layout_ok);
+
+    U64 value = 5;
+    CHECK(map_insert(map, (U64)5, value) != nullptr);
+    CHECK(*map_get(map, (U64)5) == 5);
+}
+
+TEST_CASE("Map remove back-shifts entries from overflowing groups")
+{
+    Arena* arena = arena_alloc();
+    Debug_SetName(arena, "test map arena");
+    defer(arena_release(arena));
+
+    // ~mgj: 4 groups of 16 slots, every key below hashes to group 0 so they spill into groups 1 and 2
+    Map<U64, U64>* map = map_create<U64, U64>(arena, 48);
+    REQUIRE(map->capacity == 64);
+    U64 group_mask = map->capacity / MAP_GROUP_SIZE - 1;
+
+    U64 keys[40] = {};
+    U32 key_count = 0;
+    for (U64 key = 1; key_count < ArrayCount(keys); ++key)
+    {
+        if (((map_hash_u64(key) >> 7) & group_mask) == 0)
+        {
+            keys[key_count++] = key;
+            map_insert(map, key, key);
+        }
+    }
+    REQUIRE(map->capacity == 64);
+
+    for (U32 i = 0; i < 16; ++i)
+    {
+        CHECK(map_remove(map, keys[i]));
+    }
+
+    B32 remaining_found = true;
+    for (U32 i = 16; i < key_count; ++i)
+    {
+        U64* value = map_get(map, keys[i]);
+        remaining_found &= value && *value == keys[i];
+    }
+    CHECK(remaining_found);
+
+    // ~mgj: entries were shifted back towards their home group, so group 2 is empty again
+    B32 last_group_empty = true;
+    for (U64 i = 2 * MAP_GROUP_SIZE; i < 3 * MAP_GROUP_SIZE; ++i)
+    {
+        last_group_empty &= map->ctrl[i] == MAP_CTRL_EMPTY;
+    }
+    CHECK(last_group_empty);
+}
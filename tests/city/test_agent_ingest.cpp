@@ -0,0 +1,115 @@
+g_internal city::Coordinate*
+test_agent_coord_find(Buffer<city::Coordinate> coords, S64 id)
+{
+    for (U64 i = 0; i < coords.size; ++i)
+    {
+        if (coords.data[i].id == id)
+        {
+            return &coords.data[i];
+        }
+    }
+    return 0;
+}
+
+TEST_CASE("Agent ingest applies every message and keeps the newest coordinate per agent")
+{
+    Arena* arena = arena_alloc();
+    defer(arena_release(arena));
+    city::AgentIngest* ingest = city::agent_ingest_create();
+    defer(city::agent_ingest_release(ingest));
+
+    String8List msgs = {};
+    str8_list_push(arena, &msgs, S(R"([{"id": 1, "lat": 56.1, "lon": 10.1}, {"id": 2, "lat": 56.2, "lon": 10.2, "t": 100.5}])"));
+    // ~mgj: agent 3 only shows up in an intermediate message, the old ingest only parsed the last one
+    str8_list_push(arena, &msgs, S(R"([{"id": 1, "lat": 57.1, "lon": 11.1}, {"id": 3, "lat": 56.3, "lon": 10.3}])"));
+    // ~mgj: older feed time than the first update of agent 2, it loses even though it arrives later
+    str8_list_push(arena, &msgs, S(R"([{"id": 2, "lat": 50.0, "lon": 5.0, "t": 99.0}])"));
+    str8_list_push(arena, &msgs, S(R"([{"id": 4, "lat": 56.4, "lon": 10.4}, {"id": 5, "lat": "broken"}])"));
+    str8_list_push(arena, &msgs, S("not json"));
+
+    Buffer<city::Coordinate> coords = city::agent_ingest_run(ingest, arena, &msgs, 1'000'000);
+    CHECK(coords.size == 4);
+    CHECK(ingest->stats.message_count == 5);
+    CHECK(ingest->stats.failed_message_count == 2);
+    CHECK(ingest->stats.coord_count == 6);
+    CHECK(ingest->stats.agent_count == 4);
+
+    city::Coordinate* agent_1 = test_agent_coord_find(coords, 1);
+    REQUIRE(agent_1);
+    CHECK(agent_1->lat == 57.1);
+    CHECK(agent_1->timestamp_us == 1'000'000);
+    city::Coordinate* agent_2 = test_agent_coord_find(coords, 2);
+    REQUIRE(agent_2);
+    CHECK(agent_2->lat == 56.2);
+    CHECK(agent_2->timestamp_us == 100'500'000);
+    CHECK(test_agent_coord_find(coords, 3));
+    CHECK(test_agent_coord_find(coords, 4));
+    CHECK_FALSE(test_agent_coord_find(coords, 5));
+}
+
+TEST_CASE("Agent ingest picks the newest coordinate of a feed that mixes timestamped and untimestamped updates")
+{
+    Arena* arena = arena_alloc();
+    defer(arena_release(arena));
+    city::AgentIngest* ingest = city::agent_ingest_create();
+    defer(city::agent_ingest_release(ingest));
+
+    // ~mgj: now_us is 100.6 s unix time, the coordinates without "t" get it and compare against "t" on one clock
+    String8List msgs = {};
+    str8_list_push(arena, &msgs, S(R"([{"id": 1, "lat": 56.1, "lon": 10.1, "t": 100.5}, {"id": 2, "lat": 56.2, "lon": 10.2}, {"id": 3, "lat": 56.3, "lon": 10.3}])"));
+    str8_list_push(arena, &msgs, S(R"([{"id": 1, "lat": 57.1, "lon": 11.1}, {"id": 2, "lat": 57.2, "lon": 11.2, "t": 100.7}, {"id": 3, "lat": 57.3, "lon": 11.3, "t": 100.4}])"));
+
+    Buffer<city::Coordinate> coords = city::agent_ingest_run(ingest, arena, &msgs, 100'600'000);
+    REQUIRE(coords.size == 3);
+    city::Coordinate* agent_1 = test_agent_coord_find(coords, 1);
+    REQUIRE(agent_1);
+    CHECK(agent_1->lat == 57.1);
+    CHECK(agent_1->timestamp_us == 100'600'000);
+    city::Coordinate* agent_2 = test_agent_coord_find(coords, 2);
+    REQUIRE(agent_2);
+    CHECK(agent_2->lat == 57.2);
+    CHECK(agent_2->timestamp_us == 100'700'000);
+    city::Coordinate* agent_3 = test_agent_coord_find(coords, 3);
+    REQUIRE(agent_3);
+    CHECK(agent_3->lat == 56.3);
+    CHECK(agent_3->timestamp_us == 100'600'000);
+}
+
+TEST_CASE("Agent ingest reuses its padded buffer across frames")
+{
+    Arena* arena = arena_alloc();
+    defer(arena_release(arena));
+    city::AgentIngest* ingest = city::agent_ingest_create();
+    defer(city::agent_ingest_release(ingest));
+
+    // ~mgj: 10k agents in one message, larger than the initial buffer
+    String8List parts = {};
+    str8_list_push(arena, &parts, S("["));
+    for (U32 agent_idx = 0; agent_idx < 10'000; ++agent_idx)
+    {
+        str8_list_push(arena, &parts, push_str8f(arena, "%s{\"id\": %u, \"lat\": 56.%04u, \"lon\": 10.%04u}", agent_idx ? "," : "", agent_idx, agent_idx, agent_idx));
+    }
+    str8_list_push(arena, &parts, S("]"));
+    String8 big_msg = str8_list_join(arena, &parts, 0);
+
+    U8* json_buffer = 0;
+    for (U32 frame_idx = 0; frame_idx < 4; ++frame_idx)
+    {
+        U64 frame_pos = arena_pos(arena);
+        String8List msgs = {};
+        str8_list_push(arena, &msgs, big_msg);
+        str8_list_push(arena, &msgs, S(R"([{"id": 7, "lat": 1.0, "lon": 2.0}])"));
+        Buffer<city::Coordinate> coords = city::agent_ingest_run(ingest, arena, &msgs, (U64)(frame_idx + 1) * 600'000);
+        CHECK(coords.size == 10'000);
+        CHECK(test_agent_coord_find(coords, 7)->lat == 1.0);
+        if (frame_idx == 0)
+        {
+            json_buffer = ingest->json_buffer;
+            CHECK(ingest->json_capacity >= big_msg.size + simdjson::SIMDJSON_PADDING);
+        }
+        CHECK(ingest->json_buffer == json_buffer);
+        arena_pop_to(arena, frame_pos);
+    }
+    // ~mgj: the window opened with the first frame at 0.6 s and closed at 1.8 s after 6 messages
+    CHECK(ingest->stats.messages_per_sec == doctest::Approx(6.0 / 1.2));
+}
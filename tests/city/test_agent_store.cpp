@@ -0,0 +1,268 @@
+g_internal void
+test_agent_store_matrix(F64* m)
+{
+    // ~mgj: column major rotation about z by 30 degrees and about x by 10 degrees, then a translation
+    // the size of an ECEF to local origin shift
+    F64 cz = cos(pi64 / 6.0), sz = sin(pi64 / 6.0);
+    F64 cx = cos(pi64 / 18.0), sx = sin(pi64 / 18.0);
+    F64 values[16] = {cz, sz * cx, sz * sx, 0.0, -sz, cz * cx, cz * sx, 0.0, 0.0, -sx, cx, 0.0, -3.5e6, 6.1e5, -5.2e6, 1.0};
+    MemoryCopy(m, values, sizeof(values));
+}
+
+g_internal U32*
+test_agent_store_slot(city::AgentStore* store, S64 id)
+{
+    return map_get(store->slot_map, id);
+}
+
+TEST_CASE("Agent store WGS84 to ECEF matches the ellipsoid and the AVX2 kernel matches the scalar one")
+{
+    Arena* arena = arena_alloc();
+    defer(arena_release(arena));
+
+    F64 lat[3] = {0.0, 90.0, 0.0};
+    F64 lon[3] = {0.0, 0.0, 90.0};
+    F64 x[3], y[3], z[3];
+    city::_agent_store_ecef_from_wgs84(lat, lon, 3, x, y, z);
+    CHECK(x[0] == doctest::Approx(city::AGENT_STORE_WGS84_RADIUS_EQUATOR));
+    CHECK(AbsF64(y[0]) < 1e-6);
+    CHECK(z[1] == doctest::Approx(city::AGENT_STORE_WGS84_RADIUS_POLAR));
+    CHECK(y[2] == doctest::Approx(city::AGENT_STORE_WGS84_RADIUS_EQUATOR));
+
+    if (!city::_agent_store_avx2_supported())
+    {
+        return;
+    }
+    // ~mgj: the whole range of both angles, every quadrant of the range reduction, and an odd count for the tail
+    const U64 count = 4099;
+    F64* lats = PushArray(arena, F64, count);
+    F64* lons = PushArray(arena, F64, count);
+    for (U64 i = 0; i < count; ++i)
+    {
+        lats[i] = -90.0 + 180.0 * (F64)i / (F64)(count - 1);
+        lons[i] = -180.0 + 360.0 * (F64)((i * 7919) % count) / (F64)(count - 1);
+    }
+    F64* scalar = PushArray(arena, F64, count * 3);
+    F64* simd = PushArray(arena, F64, count * 3);
+    city::_agent_store_ecef_from_wgs84(lats, lons, count, scalar, scalar + count, scalar + 2 * count);
+    city::_agent_store_ecef_from_wgs84_avx2(lats, lons, count, simd, simd + count, simd + 2 * count);
+    F64 max_error = 0.0;
+    for (U64 i = 0; i < count * 3; ++i)
+    {
+        max_error = Max(max_error, AbsF64(scalar[i] - simd[i]));
+    }
+    // ~mgj: meters, against coordinates of about 6.4e6
+    CHECK(max_error < 1e-6);
+}
+
+TEST_CASE("Agent store AVX2 transforms match the scalar transforms")
+{
+    city::AgentStore* store = city::agent_store_create(0);
+    defer(city::agent_store_release(store));
+    if (!store->use_avx2)
+    {
+        return;
+    }
+
+    store->count = 23;
+    for (U32 slot = 0; slot < store->count; ++slot)
+    {
+        store->pos_x[slot] = 3.5e6 + slot * 17.0;
+        store->pos_y[slot] = 6.1e5 - slot * 3.0;
+        store->pos_z[slot] = 5.2e6 + slot * 11.0;
+        store->dir_x[slot] = cos(slot * 0.7);
+        store->dir_y[slot] = sin(slot * 0.7) * 2.0;
+        store->dir_z[slot] = slot * 0.05 - 0.5;
+    }
+    F64 m[16];
+    test_agent_store_matrix(m);
+
+    Mat4x4F32 scalar[23];
+    city::_agent_store_transforms(store, 0, store->count, m, 2.5f);
+    MemoryCopy(scalar, store->transforms, sizeof(scalar));
+    city::_agent_store_transforms_avx2(store, 0, store->count, m, 2.5f);
+    for (U32 slot = 0; slot < store->count; ++slot)
+    {
+        for (U32 i = 0; i < 16; ++i)
+        {
+            F32 expected = (&scalar[slot].v[0][0])[i];
+            F32 actual = (&store->transforms[slot].v[0][0])[i];
+            CHECK(actual == doctest::Approx(expected).epsilon(1e-5));
+        }
+    }
+    // ~mgj: unit heading scaled, and the basis is orthogonal
+    Mat4x4F32* t = &scalar[5];
+    F32 x_len_sq = t->v[0][0] * t->v[0][0] + t->v[0][1] * t->v[0][1] + t->v[0][2] * t->v[0][2];
+    CHECK(x_len_sq == doctest::Approx(2.5f * 2.5f));
+    CHECK(t->v[0][0] * t->v[1][0] + t->v[0][1] * t->v[1][1] + t->v[0][2] * t->v[1][2] == doctest::Approx(0.0).scale(1.0));
+    CHECK(t->v[0][0] * t->v[2][0] + t->v[0][1] * t->v[2][1] + t->v[0][2] * t->v[2][2] == doctest::Approx(0.0).scale(1.0));
+    CHECK(t->v[3][3] == 1.0f);
+}
+
+TEST_CASE("Agent store keeps the newest coordinate per agent, updates headings and compacts stale agents")
+{
+    city::AgentStore* store = city::agent_store_create(0);
+    defer(city::agent_store_release(store));
+    Arena* arena = arena_alloc();
+    defer(arena_release(arena));
+    F64 m[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+    // ~mgj: no playback delay, the agents are where their newest sample is
+    city::AgentMotionConfig motion = city::agent_motion_config_default();
+    motion.playback_delay_us = 0;
+
+    // ~mgj: 1 s, three agents, agent 2 twice with the older coordinate last
+    Buffer<city::Coordinate> coords = buffer_alloc<city::Coordinate>(arena, 4);
+    coords.data[0] = {.id = 1, .lat = 56.1, .lon = 10.1, .timestamp_us = 1'000'000};
+    coords.data[1] = {.id = 2, .lat = 56.25, .lon = 10.25, .timestamp_us = 1'000'000};
+    coords.data[2] = {.id = 3, .lat = 56.3, .lon = 10.3, .timestamp_us = 1'000'000};
+    coords.data[3] = {.id = 2, .lat = 56.2, .lon = 10.2, .timestamp_us = 900'000};
+    city::agent_store_update(0, store, coords, m, 1.0f, &motion, 1'000'000);
+    REQUIRE(store->count == 3);
+    CHECK(store->stats.feed_latency_us == 0);
+    U32 slot_2 = *test_agent_store_slot(store, 2);
+    F64 lat[1] = {56.25};
+    F64 lon[1] = {10.25};
+    F64 x, y, z;
+    city::_agent_store_ecef_from_wgs84(lat, lon, 1, &x, &y, &z);
+    CHECK(store->pos_x[slot_2] == doctest::Approx(x));
+    CHECK(store->dir_x[slot_2] == 1.0);
+    // ~mgj: identity ecef_to_local, the transform position is the ECEF position
+    CHECK(store->transforms[slot_2].v[3][0] == doctest::Approx((F32)x));
+
+    // ~mgj: 100 ms later agent 1 moves 1e-5 degrees north, agent 3 slower than AGENT_STORE_MIN_SPEED_SQ
+    U32 slot_1 = *test_agent_store_slot(store, 1);
+    U32 slot_3 = *test_agent_store_slot(store, 3);
+    F64 old_pos_1_z = store->pos_z[slot_1];
+    coords.size = 2;
+    coords.data[0] = {.id = 1, .lat = 56.10001, .lon = 10.1, .timestamp_us = 1'100'000};
+    coords.data[1] = {.id = 3, .lat = 56.3 + 1e-10, .lon = 10.3, .timestamp_us = 1'100'000};
+    city::agent_store_update(0, store, coords, m, 1.0f, &motion, 1'100'000);
+    CHECK(store->count == 3);
+    CHECK(store->stats.sample_count == 2);
+    CHECK(store->dir_z[slot_1] > 5.0);
+    CHECK((store->pos_z[slot_1] - old_pos_1_z) * 10.0 == doctest::Approx(store->dir_z[slot_1]));
+    CHECK(store->dir_x[slot_3] == 1.0);
+
+    // ~mgj: 3 s, agent 2 had its last sample 2 s ago and is swapped out, the others keep their map entries
+    coords.size = 1;
+    coords.data[0] = {.id = 4, .lat = 56.4, .lon = 10.4, .timestamp_us = 3'000'000};
+    city::agent_store_update(0, store, coords, m, 1.0f, &motion, 3'000'000);
+    CHECK(store->count == 3);
+    CHECK(test_agent_store_slot(store, 2) == 0);
+    for (S64 id : {1, 3, 4})
+    {
+        U32* slot = test_agent_store_slot(store, id);
+        REQUIRE(slot);
+        CHECK(store->ids[*slot] == id);
+    }
+    CHECK(store->slot_map->count == store->count);
+}
+
+TEST_CASE("Agent store interpolates behind the playback delay and extrapolates within the bounds")
+{
+    city::AgentStore* store = city::agent_store_create(0);
+    defer(city::agent_store_release(store));
+    city::AgentMotionConfig motion = city::agent_motion_config_default();
+    motion.max_extrapolation_us = 2'000'000;
+    motion.max_extrapolation_m = 100.0;
+
+    // ~mgj: x = t^2 sampled at 0, 1, 2 and 3 s
+    store->count = 1;
+    store->dir_x[0] = 1.0;
+    for (S64 t = 0; t < 4; ++t)
+    {
+        F64 error = city::_agent_store_sample_push(store, 0, t * 1'000'000, (F64)(t * t), 0.0, 0.0, &motion);
+        // ~mgj: dead reckoning from the two samples before is off by 2 from the third one on
+        CHECK(error == (t >= 2 ? 2.0 : -1.0));
+    }
+    REQUIRE(store->sample_count[0] == 4);
+
+    // ~mgj: Catmull-Rom tangents are exact for a quadratic on uniform samples, so Hermite is too
+    motion.interp = city::AgentMotionInterp_Hermite;
+    city::_agent_store_motion(store, 0, 1, 1'500'000, &motion);
+    CHECK(store->pos_x[0] == doctest::Approx(2.25));
+    CHECK(store->dir_x[0] == doctest::Approx(3.0));
+    motion.interp = city::AgentMotionInterp_Linear;
+    city::_agent_store_motion(store, 0, 1, 1'500'000, &motion);
+    CHECK(store->pos_x[0] == doctest::Approx(2.5));
+    CHECK(store->dir_x[0] == doctest::Approx(3.0));
+
+    // ~mgj: before the oldest sample the agent holds it
+    city::_agent_store_motion(store, 0, 1, -500'000, &motion);
+    CHECK(store->pos_x[0] == 0.0);
+
+    // ~mgj: past the newest sample it moves on at 5 m/s, until max_extrapolation_us or max_extrapolation_m
+    city::_agent_store_motion(store, 0, 1, 3'200'000, &motion);
+    CHECK(store->pos_x[0] == doctest::Approx(10.0));
+    CHECK(store->dir_x[0] == doctest::Approx(5.0));
+    city::_agent_store_motion(store, 0, 1, 60'000'000, &motion);
+    CHECK(store->pos_x[0] == doctest::Approx(19.0));
+    motion.max_extrapolation_m = 2.0;
+    city::_agent_store_motion(store, 0, 1, 60'000'000, &motion);
+    CHECK(store->pos_x[0] == doctest::Approx(11.0));
+
+    // ~mgj: an older sample is dropped, a newer one pushes the oldest out of the ring
+    CHECK(city::_agent_store_sample_push(store, 0, 2'500'000, 100.0, 0.0, 0.0, &motion) == -1.0);
+    CHECK(store->sample_us[store->sample_head[0]] == 3'000'000);
+    motion.max_extrapolation_m = 100.0;
+    CHECK(city::_agent_store_sample_push(store, 0, 4'000'000, 16.0, 0.0, 0.0, &motion) == doctest::Approx(2.0));
+    CHECK(store->sample_count[0] == 4);
+    city::_agent_store_motion(store, 0, 1, 0, &motion);
+    CHECK(store->pos_x[0] == 1.0);
+}
+
+TEST_CASE("Agent store moves feed times onto the local clock by the smallest latency")
+{
+    city::AgentStore* store = city::agent_store_create(0);
+    defer(city::agent_store_release(store));
+    Arena* arena = arena_alloc();
+    defer(arena_release(arena));
+    F64 m[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+    city::AgentMotionConfig motion = city::agent_motion_config_default();
+
+    // ~mgj: unix time feed, a monotonic local clock
+    const U64 feed_us = 1'760'000'000'000'000ull;
+    const U64 local_us = 5'000'000;
+    Buffer<city::Coordinate> coords = buffer_alloc<city::Coordinate>(arena, 1);
+    coords.data[0] = {.id = 1, .lat = 56.1, .lon = 10.1, .timestamp_us = feed_us};
+    city::agent_store_update(0, store, coords, m, 1.0f, &motion, local_us);
+    S64 latency_us = (S64)local_us - (S64)feed_us;
+    CHECK(store->stats.feed_latency_us == latency_us);
+    CHECK(store->sample_us[store->sample_head[0]] == (S64)local_us);
+
+    // ~mgj: 50 ms later than usual moves the latency by 1/64 of it, earlier than usual takes it at once
+    coords.data[0].timestamp_us = feed_us + 100'000;
+    city::agent_store_update(0, store, coords, m, 1.0f, &motion, local_us + 150'000);
+    CHECK(store->stats.feed_latency_us == latency_us + 50'000 / 64);
+    CHECK(store->sample_us[store->sample_head[0]] == (S64)local_us + 100'000 + 50'000 / 64);
+    coords.data[0].timestamp_us = feed_us + 200'000;
+    city::agent_store_update(0, store, coords, m, 1.0f, &motion, local_us + 190'000);
+    CHECK(store->stats.feed_latency_us == latency_us - 10'000);
+}
+
+TEST_CASE("Agent store grows past its capacity")
+{
+    city::AgentStore* store = city::agent_store_create(0);
+    defer(city::agent_store_release(store));
+    Arena* arena = arena_alloc();
+    defer(arena_release(arena));
+    F64 m[16];
+    test_agent_store_matrix(m);
+    city::AgentMotionConfig motion = city::agent_motion_config_default();
+
+    const U32 count = city::AGENT_STORE_MIN_CAPACITY * 3 + 5;
+    Buffer<city::Coordinate> coords = buffer_alloc<city::Coordinate>(arena, count);
+    for (U32 i = 0; i < count; ++i)
+    {
+        coords.data[i] = {.id = (S64)i * 3, .lat = 56.0 + i * 1e-5, .lon = 10.0 - i * 1e-5, .timestamp_us = 1'000'000};
+    }
+    city::agent_store_update(0, store, {coords.data, count / 2}, m, 1.0f, &motion, 1'000'000);
+    Mat4x4F32 first = store->transforms[7];
+    city::agent_store_update(0, store, coords, m, 1.0f, &motion, 1'000'000);
+    CHECK(store->count == count);
+    CHECK(store->capacity >= count);
+    U32 slot = *test_agent_store_slot(store, 7 * 3);
+    CHECK(store->ids[slot] == 7 * 3);
+    CHECK(store->sample_count[slot] == 1);
+    CHECK(MemoryMatch(&first, &store->transforms[slot], sizeof(first)));
+}
@@ -0,0 +1,181 @@
+g_internal Buffer<city::Coordinate>
+test_agent_wire_coords_create(Arena* arena, U32 count, U32 step)
+{
+    Buffer<city::Coordinate> coords = buffer_alloc<city::Coordinate>(arena, count);
+    for (U32 i = 0; i < count; ++i)
+    {
+        coords.data[i].id = 1000 + i;
+        coords.data[i].lat = 56.15 + i * 1e-4 + step * 2e-6;
+        coords.data[i].lon = -10.2 - i * 1e-4 + step * 3e-6;
+    }
+    return coords;
+}
+
+g_internal city::AgentWireHeader
+test_agent_wire_header(String8 frame)
+{
+    city::AgentWireHeader header = {};
+    MemoryCopy(&header, frame.str, sizeof(header));
+    return header;
+}
+
+TEST_CASE("Agent wire frames round trip in both encodings")
+{
+    Arena* arena = arena_alloc();
+    defer(arena_release(arena));
+    city::AgentWireState state = {};
+    city::agent_wire_state_init(&state);
+    defer(city::agent_wire_state_release(&state));
+
+    // ~mgj: odd count so the vector loops and the scalar tails both run
+    Buffer<city::Coordinate> coords = test_agent_wire_coords_create(arena, 13, 0);
+    for (U32 encoding = 0; encoding < city::AgentWireEncoding_Count; ++encoding)
+    {
+        city::AgentWireEncoder* encoder = city::agent_wire_encoder_create((city::AgentWireEncoding)encoding, false, 0);
+        defer(city::agent_wire_encoder_release(encoder));
+        String8 frame = city::agent_wire_encode(arena, encoder, coords, 77'000'000);
+        CHECK(city::agent_wire_is_frame(frame));
+
+        Buffer<city::Coordinate> decoded = {};
+        REQUIRE(city::agent_wire_decode(arena, &state, frame, 1, &decoded));
+        REQUIRE(decoded.size == coords.size);
+        for (U64 i = 0; i < coords.size; ++i)
+        {
+            CHECK(decoded.data[i].id == coords.data[i].id);
+            CHECK(decoded.data[i].timestamp_us == 77'000'000);
+            if (encoding == city::AgentWireEncoding_F64)
+            {
+                CHECK(decoded.data[i].lat == coords.data[i].lat);
+                CHECK(decoded.data[i].lon == coords.data[i].lon);
+            }
+            else
+            {
+                CHECK(AbsF64(decoded.data[i].lat - coords.data[i].lat) <= 0.51 / city::AGENT_WIRE_FIXED_SCALE);
+                CHECK(AbsF64(decoded.data[i].lon - coords.data[i].lon) <= 0.51 / city::AGENT_WIRE_FIXED_SCALE);
+            }
+        }
+    }
+
+    // ~mgj: truncated and foreign messages are rejected
+    city::AgentWireEncoder* encoder = city::agent_wire_encoder_create(city::AgentWireEncoding_Fixed32, false, 0);
+    defer(city::agent_wire_encoder_release(encoder));
+    String8 frame = city::agent_wire_encode(arena, encoder, coords, 0);
+    Buffer<city::Coordinate> decoded = {};
+    CHECK_FALSE(city::agent_wire_decode(arena, &state, str8_prefix(frame, frame.size - 1), 1, &decoded));
+    CHECK_FALSE(city::agent_wire_is_frame(S("[{\"id\": 1}]")));
+    CHECK(city::agent_wire_decode(arena, &state, frame, 5, &decoded));
+    CHECK(decoded.data[0].timestamp_us == 5);
+}
+
+TEST_CASE("Agent wire delta frames follow the previous frame and fall back to key frames")
+{
+    Arena* arena = arena_alloc();
+    defer(arena_release(arena));
+    city::AgentWireState state = {};
+    city::agent_wire_state_init(&state);
+    defer(city::agent_wire_state_release(&state));
+    city::AgentWireEncoder* encoder = city::agent_wire_encoder_create(city::AgentWireEncoding_Fixed32, true, 3);
+    defer(city::agent_wire_encoder_release(encoder));
+
+    const U32 count = 21;
+    U64 key_size = 0;
+    for (U32 step = 0; step < 8; ++step)
+    {
+        Buffer<city::Coordinate> coords = test_agent_wire_coords_create(arena, count, step);
+        String8 frame = city::agent_wire_encode(arena, encoder, coords, 0);
+        city::AgentWireHeader header = test_agent_wire_header(frame);
+        // ~mgj: key, 3 deltas, key because of key_interval, 3 deltas
+        B32 expect_delta = step % 4 != 0;
+        CHECK(((header.flags & city::AgentWireFlag_Delta) != 0) == expect_delta);
+        if (!expect_delta)
+        {
+            key_size = frame.size;
+        }
+        else
+        {
+            CHECK(header.base_sequence + 1 == header.sequence);
+            CHECK(frame.size < key_size / 3);
+        }
+
+        Buffer<city::Coordinate> decoded = {};
+        REQUIRE(city::agent_wire_decode(arena, &state, frame, 0, &decoded));
+        REQUIRE(decoded.size == count);
+        for (U32 i = 0; i < count; ++i)
+        {
+            CHECK(decoded.data[i].id == coords.data[i].id);
+            CHECK(AbsF64(decoded.data[i].lat - coords.data[i].lat) <= 0.51 / city::AGENT_WIRE_FIXED_SCALE);
+            CHECK(AbsF64(decoded.data[i].lon - coords.data[i].lon) <= 0.51 / city::AGENT_WIRE_FIXED_SCALE);
+        }
+    }
+
+    // ~mgj: the interval is up again at step 8. After that a jump of more than S16 fixed point units and a
+    // changed agent set both need a key frame.
+    String8 frame = city::agent_wire_encode(arena, encoder, test_agent_wire_coords_create(arena, count, 8), 0);
+    CHECK((test_agent_wire_header(frame).flags & city::AgentWireFlag_Delta) == 0);
+    Buffer<city::Coordinate> coords = test_agent_wire_coords_create(arena, count, 9);
+    frame = city::agent_wire_encode(arena, encoder, coords, 0);
+    CHECK((test_agent_wire_header(frame).flags & city::AgentWireFlag_Delta) != 0);
+    coords.data[3].lat += 0.01;
+    frame = city::agent_wire_encode(arena, encoder, coords, 0);
+    CHECK((test_agent_wire_header(frame).flags & city::AgentWireFlag_Delta) == 0);
+    coords.data[4].id = 5;
+    frame = city::agent_wire_encode(arena, encoder, coords, 0);
+    CHECK((test_agent_wire_header(frame).flags & city::AgentWireFlag_Delta) == 0);
+}
+
+TEST_CASE("Agent wire delta frames without their base are dropped until the next key frame")
+{
+    Arena* arena = arena_alloc();
+    defer(arena_release(arena));
+    city::AgentWireState state = {};
+    city::agent_wire_state_init(&state);
+    defer(city::agent_wire_state_release(&state));
+    city::AgentWireEncoder* encoder = city::agent_wire_encoder_create(city::AgentWireEncoding_Fixed32, true, 4);
+    defer(city::agent_wire_encoder_release(encoder));
+
+    String8 frames[6] = {};
+    for (U32 step = 0; step < ArrayCount(frames); ++step)
+    {
+        frames[step] = city::agent_wire_encode(arena, encoder, test_agent_wire_coords_create(arena, 9, step), 0);
+    }
+    Buffer<city::Coordinate> decoded = {};
+    CHECK(city::agent_wire_decode(arena, &state, frames[0], 0, &decoded));
+    CHECK(city::agent_wire_decode(arena, &state, frames[1], 0, &decoded));
+    // ~mgj: frames[2] is lost
+    CHECK_FALSE(city::agent_wire_decode(arena, &state, frames[3], 0, &decoded));
+    CHECK(decoded.size == 0);
+    CHECK_FALSE(city::agent_wire_decode(arena, &state, frames[4], 0, &decoded));
+    REQUIRE((test_agent_wire_header(frames[5]).flags & city::AgentWireFlag_Delta) == 0);
+    CHECK(city::agent_wire_decode(arena, &state, frames[5], 0, &decoded));
+    CHECK(decoded.size == 9);
+}
+
+TEST_CASE("Agent ingest takes binary frames and JSON messages from the same feed")
+{
+    Arena* arena = arena_alloc();
+    defer(arena_release(arena));
+    city::AgentIngest* ingest = city::agent_ingest_create();
+    defer(city::agent_ingest_release(ingest));
+    city::AgentWireEncoder* encoder = city::agent_wire_encoder_create(city::AgentWireEncoding_Fixed32, true, 0);
+    defer(city::agent_wire_encoder_release(encoder));
+
+    Buffer<city::Coordinate> coords = buffer_alloc<city::Coordinate>(arena, 2);
+    coords.data[0] = {.id = 1, .lat = 56.1, .lon = 10.1};
+    coords.data[1] = {.id = 2, .lat = 56.2, .lon = 10.2};
+    String8List msgs = {};
+    str8_list_push(arena, &msgs, city::agent_wire_encode(arena, encoder, coords, 0));
+    str8_list_push(arena, &msgs, S(R"([{"id": 2, "lat": 50.0, "lon": 5.0}, {"id": 3, "lat": 56.3, "lon": 10.3}])"));
+    coords.data[0].lat = 56.1001;
+    str8_list_push(arena, &msgs, city::agent_wire_encode(arena, encoder, coords, 0));
+
+    Buffer<city::Coordinate> result = city::agent_ingest_run(ingest, arena, &msgs, 1'000'000);
+    CHECK(ingest->stats.message_count == 3);
+    CHECK(ingest->stats.wire_message_count == 2);
+    CHECK(ingest->stats.failed_message_count == 0);
+    CHECK(ingest->stats.coord_count == 6);
+    REQUIRE(result.size == 3);
+    CHECK(test_agent_coord_find(result, 1)->lat == doctest::Approx(56.1001));
+    // ~mgj: same time of arrival, the later binary frame wins over the JSON message
+    CHECK(test_agent_coord_find(result, 2)->lat == doctest::Approx(56.2));
+    CHECK(test_agent_coord_find(result, 3)->lat == doctest::Approx(56.3));
+}
@@ -0,0 +1,142 @@
+// ~mgj: side * side rectangular segments laid out row by row, i.e. already sorted along x and y
+g_internal Buffer<city::RoadSegmentCorners>
+test_road_grid_create(Arena* arena, U32 side)
+{
+    Buffer<city::RoadSegmentCorners> segments = buffer_alloc<city::RoadSegmentCorners>(arena, (U64)side * side);
+    for (U32 y = 0; y < side; ++y)
+    {
+        for (U32 x = 0; x < side; ++x)
+        {
+            city::RoadSegmentCorners* segment = &segments.data[y * side + x];
+            F32 x0 = (F32)x * 10.0f;
+            F32 y0 = (F32)y * 10.0f;
+            segment->edge_id = y * side + x;
+            segment->corners[city::RoadSegmentCornerCoord_TopLeft] = V2F32(x0, y0 + 3.0f);
+            segment->corners[city::RoadSegmentCornerCoord_TopRight] = V2F32(x0 + 8.0f, y0 + 3.0f);
+            segment->corners[city::RoadSegmentCornerCoord_BottomRight] = V2F32(x0 + 8.0f, y0);
+            segment->corners[city::RoadSegmentCornerCoord_BottomLeft] = V2F32(x0, y0);
+        }
+    }
+    return segments;
+}
+
+TEST_CASE("Road bvh finds every segment")
+{
+    Arena* arena = arena_alloc();
+    async::ThreadPool* thread_pool = async::thread_pool_create(arena, 4, 64, 64);
+    U32 leaf_bb_max = 10;
+    Buffer<city::RoadSegmentCorners> segments = test_road_grid_create(arena, 100);
+    city::BvhResult bvh = city::bvh_create(thread_pool, arena, segments, leaf_bb_max);
+    REQUIRE(bvh.road_segment_buffer_sorted.size == segments.size);
+
+    // ~mgj: depth first layout, leaves within the limit and covering every segment exactly once
+    B32 is_depth_first = true;
+    B32 is_leaf_bounded = true;
+    U64 leaf_segment_count = 0;
+    for (U32 node_idx = 0; node_idx < bvh.node_buffer.size; ++node_idx)
+    {
+        city::RoadSegmentNodeStorageBuffer* node = &bvh.node_buffer.data[node_idx];
+        if (node->is_leaf)
+        {
+            is_leaf_bounded = is_leaf_bounded && node->end_idx - node->start_idx <= leaf_bb_max;
+            leaf_segment_count += node->end_idx - node->start_idx;
+        }
+        else
+        {
+            is_depth_first = is_depth_first && node->child_0_idx == node_idx + 1 && node->child_1_idx > node_idx + 1 && node->child_1_idx < bvh.node_buffer.size;
+        }
+    }
+    CHECK(is_depth_first);
+    CHECK(is_leaf_bounded);
+    CHECK(leaf_segment_count == segments.size);
+
+    B32 all_found = true;
+    U64 nodes_visited = 0;
+    for (city::RoadSegmentCorners& segment : segments)
+    {
+        Vec2F32 center = add_2f32(segment.corners[city::RoadSegmentCornerCoord_BottomLeft], V2F32(4.0f, 1.5f));
+        city::BvhQueryResult query = city::bvh_point_query(&bvh, center);
+        all_found = all_found && query.segment_idx != max_U32 && bvh.road_segment_buffer_sorted.data[query.segment_idx].edge_id == segment.edge_id;
+        nodes_visited += query.nodes_visited;
+    }
+    CHECK(all_found);
+    // ~mgj: a balanced tree over 1000 leaves visits about 2 * log2(1000) nodes, leave some slack
+    CHECK((F64)nodes_visited / (F64)segments.size < 40.0);
+
+    // ~mgj: the gap between two segments is inside the root bounds but in no segment
+    CHECK(city::bvh_point_query(&bvh, V2F32(9.0f, 1.0f)).segment_idx == max_U32);
+    CHECK(city::bvh_point_query(&bvh, V2F32(-5.0f, -5.0f)).segment_idx == max_U32);
+
+    async::thread_pool_destroy(thread_pool);
+    arena_release(arena);
+}
+
+TEST_CASE("Road bvh handles identical and missing segments")
+{
+    Arena* arena = arena_alloc();
+    async::ThreadPool* thread_pool = async::thread_pool_create(arena, 2, 64, 64);
+
+    city::BvhResult empty = city::bvh_create(thread_pool, arena, {}, 10);
+    CHECK(empty.node_buffer.size == 1);
+    CHECK(empty.node_buffer.data[0].is_leaf);
+    CHECK(city::bvh_point_query(&empty, V2F32(0.0f, 0.0f)).segment_idx == max_U32);
+
+    // ~mgj: no SAH split separates equal centroids, the median fallback must still terminate
+    Buffer<city::RoadSegmentCorners> segments = test_road_grid_create(arena, 1);
+    Buffer<city::RoadSegmentCorners> stacked = buffer_alloc<city::RoadSegmentCorners>(arena, 5000);
+    for (city::RoadSegmentCorners& segment : stacked)
+    {
+        segment = segments.data[0];
+    }
+    city::BvhResult bvh = city::bvh_create(thread_pool, arena, stacked, 10);
+    CHECK(bvh.road_segment_buffer_sorted.size == stacked.size);
+    CHECK(city::bvh_point_query(&bvh, V2F32(4.0f, 1.5f)).segment_idx != max_U32);
+
+    async::thread_pool_destroy(thread_pool);
+    arena_release(arena);
+}
+
+TEST_CASE("Road bvh packet classification matches point query")
+{
+    Arena* arena = arena_alloc();
+    async::ThreadPool* thread_pool = async::thread_pool_create(arena, 2, 64, 64);
+
+    // ~mgj: widen the grid segments so neighbours overlap, the packet must pick the same one
+    Buffer<city::RoadSegmentCorners> segments = test_road_grid_create(arena, 60);
+    for (city::RoadSegmentCorners& segment : segments)
+    {
+        for (Vec2F32& corner : segment.corners)
+        {
+            corner = add_2f32(scale_2f32(sub_2f32(corner, V2F32(4.0f, 1.5f)), 1.8f), V2F32(4.0f, 1.5f));
+        }
+    }
+    city::BvhResult bvh = city::bvh_create(thread_pool, arena, segments, 10);
+
+    // ~mgj: odd count to leave a partial packet at the end
+    Buffer<Vec2F32> points = buffer_alloc<Vec2F32>(arena, 20001);
+    for (U64 i = 0; i < points.size; ++i)
+    {
+        F32 x = (F32)(hash_index_hash_u64(i * 2) >> 40) / (F32)(1ull << 24);
+        F32 y = (F32)(hash_index_hash_u64(i * 2 + 1) >> 40) / (F32)(1ull << 24);
+        points.data[i] = V2F32(x * 620.0f - 10.0f, y * 620.0f - 10.0f);
+    }
+    Buffer<U32> packet_idx = buffer_alloc<U32>(arena, points.size);
+    Buffer<U32> parallel_idx = buffer_alloc<U32>(arena, points.size);
+    city::bvh_points_classify(&bvh, points, packet_idx);
+    city::bvh_points_classify_parallel(thread_pool, &bvh, points, parallel_idx);
+
+    B32 all_match = true;
+    U64 hit_count = 0;
+    for (U64 i = 0; i < points.size; ++i)
+    {
+        U32 expected = city::bvh_point_query(&bvh, points.data[i]).segment_idx;
+        all_match = all_match && packet_idx.data[i] == expected && parallel_idx.data[i] == expected;
+        hit_count += expected != max_U32;
+    }
+    CHECK(all_match);
+    CHECK(hit_count > 0);
+    CHECK(hit_count < points.size);
+
+    async::thread_pool_destroy(thread_pool);
+    arena_release(arena);
+}
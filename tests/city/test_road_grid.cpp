@@ -0,0 +1,161 @@
+g_internal F32
+test_road_grid_rand(U64* state)
+{
+    *state = *state * 6364136223846793005ull + 1442695040888963407ull;
+    return (F32)(*state >> 40) / (F32)(1ull << 24);
+}
+
+g_internal F32
+test_road_grid_dist_sq(Vec2F32 point, Vec2F32 from, Vec2F32 to)
+{
+    Vec2F32 dir = sub_2f32(to, from);
+    F32 len_sq = dir.x * dir.x + dir.y * dir.y;
+    F32 t = len_sq > 0.0f ? Clamp(0.0f, ((point.x - from.x) * dir.x + (point.y - from.y) * dir.y) / len_sq, 1.0f) : 0.0f;
+    F32 dx = point.x - (from.x + dir.x * t);
+    F32 dy = point.y - (from.y + dir.y * t);
+    return dx * dx + dy * dy;
+}
+
+TEST_CASE("Road grid nearest matches a brute force search")
+{
+    Arena* arena = arena_alloc();
+    defer(arena_release(arena));
+
+    // ~mgj: short segments like OSM edges, a few long diagonals over many cells and one zero length segment
+    const U32 segment_count = 2000;
+    Buffer<Vec2F32> from = buffer_alloc<Vec2F32>(arena, segment_count);
+    Buffer<Vec2F32> to = buffer_alloc<Vec2F32>(arena, segment_count);
+    Buffer<osm::EdgeId> edge_ids = buffer_alloc<osm::EdgeId>(arena, segment_count);
+    U64 rng = 7;
+    for (U32 i = 0; i < segment_count; ++i)
+    {
+        from.data[i] = V2F32(test_road_grid_rand(&rng) * 1000.0f - 200.0f, test_road_grid_rand(&rng) * 800.0f + 50.0f);
+        F32 length = i % 100 == 0 ? 400.0f : 10.0f + 30.0f * test_road_grid_rand(&rng);
+        F32 angle = test_road_grid_rand(&rng) * 6.2831853f;
+        to.data[i] = add_2f32(from.data[i], V2F32(cosf(angle) * length, sinf(angle) * length));
+        edge_ids.data[i] = 1000 + i;
+    }
+    to.data[5] = from.data[5];
+    city::RoadGrid grid = city::road_grid_create(arena, from, to, edge_ids, 25.0f);
+    CHECK(grid.entry_count % city::ROAD_GRID_LANE_COUNT == 0);
+
+    // ~mgj: points inside and around the grid
+    const U32 point_count = 3000;
+    Buffer<Vec2F32> points = buffer_alloc<Vec2F32>(arena, point_count);
+    for (U32 i = 0; i < point_count; ++i)
+    {
+        points.data[i] = V2F32(test_road_grid_rand(&rng) * 1200.0f - 300.0f, test_road_grid_rand(&rng) * 1000.0f - 50.0f);
+    }
+    points.data[0] = from.data[5];
+
+    for (F32 max_distance : {5.0f, 30.0f, 1e30f})
+    {
+        Buffer<city::RoadGridHit> hits = buffer_alloc<city::RoadGridHit>(arena, point_count);
+        city::road_grid_nearest(&grid, points, max_distance, hits);
+        U32 miss_count = 0;
+        for (U32 i = 0; i < point_count; ++i)
+        {
+            F32 best_dist_sq = max_distance * max_distance;
+            for (U32 segment_idx = 0; segment_idx < segment_count; ++segment_idx)
+            {
+                best_dist_sq = Min(best_dist_sq, test_road_grid_dist_sq(points.data[i], from.data[segment_idx], to.data[segment_idx]));
+            }
+            city::RoadGridHit* hit = &hits.data[i];
+            if (best_dist_sq >= max_distance * max_distance)
+            {
+                CHECK(hit->segment_idx == max_U32);
+                miss_count += 1;
+                continue;
+            }
+            REQUIRE(hit->segment_idx < segment_count);
+            CHECK(hit->dist_sq == doctest::Approx(best_dist_sq).epsilon(1e-3).scale(1.0));
+            CHECK(test_road_grid_dist_sq(points.data[i], from.data[hit->segment_idx], to.data[hit->segment_idx]) == doctest::Approx(hit->dist_sq).epsilon(1e-3).scale(1.0));
+            Vec2F32 expected_pos = add_2f32(from.data[hit->segment_idx], scale_2f32(sub_2f32(to.data[hit->segment_idx], from.data[hit->segment_idx]), hit->t));
+            CHECK(hit->pos.x == doctest::Approx(expected_pos.x));
+            CHECK(hit->pos.y == doctest::Approx(expected_pos.y));
+        }
+        if (max_distance > 1e20f)
+        {
+            CHECK(miss_count == 0);
+        }
+    }
+}
+
+TEST_CASE("Road grid handles no segments and parallel queries")
+{
+    Arena* arena = arena_alloc();
+    defer(arena_release(arena));
+
+    city::RoadGrid empty = city::road_grid_create(arena, {}, {}, {}, city::ROAD_GRID_DEFAULT_CELL_SIZE);
+    Vec2F32 point = V2F32(3.0f, 4.0f);
+    Buffer<city::RoadGridHit> hit = buffer_alloc<city::RoadGridHit>(arena, 1);
+    city::road_grid_nearest(&empty, {&point, 1}, 100.0f, hit);
+    CHECK(hit.data[0].segment_idx == max_U32);
+
+    // ~mgj: a street grid, every point 2 m north of the horizontal street below it
+    const U32 side = 40;
+    Buffer<Vec2F32> from = buffer_alloc<Vec2F32>(arena, side * side);
+    Buffer<Vec2F32> to = buffer_alloc<Vec2F32>(arena, side * side);
+    Buffer<osm::EdgeId> edge_ids = buffer_alloc<osm::EdgeId>(arena, side * side);
+    for (U32 i = 0; i < side * side; ++i)
+    {
+        from.data[i] = V2F32((F32)(i % side) * 50.0f, (F32)(i / side) * 50.0f);
+        to.data[i] = add_2f32(from.data[i], V2F32(50.0f, 0.0f));
+        edge_ids.data[i] = i;
+    }
+    city::RoadGrid grid = city::road_grid_create(arena, from, to, edge_ids, city::ROAD_GRID_DEFAULT_CELL_SIZE);
+    const U32 point_count = 20000;
+    Buffer<Vec2F32> points = buffer_alloc<Vec2F32>(arena, point_count);
+    for (U32 i = 0; i < point_count; ++i)
+    {
+        U32 segment_idx = (i * 7919) % (side * side);
+        points.data[i] = add_2f32(from.data[segment_idx], V2F32(10.0f + (F32)(i % 30), 2.0f));
+    }
+
+    async::ThreadPool* thread_pool = async::thread_pool_create(arena, 3, 64, 16);
+    defer(async::thread_pool_destroy(thread_pool));
+    Buffer<city::RoadGridHit> hits = buffer_alloc<city::RoadGridHit>(arena, point_count);
+    city::road_grid_nearest_parallel(thread_pool, &grid, points, 10.0f, hits);
+    for (U32 i = 0; i < point_count; ++i)
+    {
+        U32 segment_idx = (i * 7919) % (side * side);
+        REQUIRE(hits.data[i].segment_idx == segment_idx);
+        CHECK(hits.data[i].dist_sq == doctest::Approx(4.0f));
+        CHECK(hits.data[i].pos.y == doctest::Approx(points.data[i].y - 2.0f));
+    }
+}
+
+TEST_CASE("Road grid snaps transforms onto the road and along it")
+{
+    Arena* arena = arena_alloc();
+    defer(arena_release(arena));
+
+    Vec2F32 from = V2F32(0.0f, 0.0f);
+    Vec2F32 to = V2F32(100.0f, 0.0f);
+    osm::EdgeId edge_id = 1;
+    city::RoadGrid grid = city::road_grid_create(arena, {&from, 1}, {&to, 1}, {&edge_id, 1}, city::ROAD_GRID_DEFAULT_CELL_SIZE);
+
+    // ~mgj: one agent 3 m off the road heading mostly west at scale 2, one 40 m off the road
+    Mat4x4F32 transforms[2] = {};
+    transforms[0].v[0][0] = -1.6f;
+    transforms[0].v[0][1] = 1.2f;
+    transforms[0].v[3][0] = 30.0f;
+    transforms[0].v[3][1] = 3.0f;
+    transforms[0].v[3][2] = 7.0f;
+    transforms[0].v[3][3] = 1.0f;
+    transforms[1].v[0][0] = 1.0f;
+    transforms[1].v[3][0] = 50.0f;
+    transforms[1].v[3][1] = 40.0f;
+    Mat4x4F32 far_before = transforms[1];
+
+    city::road_grid_transforms_snap(0, &grid, transforms, 2, 15.0f);
+    CHECK(transforms[0].v[3][0] == doctest::Approx(30.0f));
+    CHECK(transforms[0].v[3][1] == doctest::Approx(0.0f));
+    CHECK(transforms[0].v[3][2] == 7.0f);
+    CHECK(transforms[0].v[0][0] == doctest::Approx(-2.0f));
+    CHECK(transforms[0].v[0][1] == doctest::Approx(0.0f));
+    CHECK(transforms[0].v[1][2] == doctest::Approx(2.0f));
+    CHECK(transforms[0].v[2][0] == doctest::Approx(0.0f));
+    CHECK(transforms[0].v[2][1] == doctest::Approx(2.0f));
+    CHECK(MemoryCompare(&transforms[1], &far_before, sizeof(Mat4x4F32)) == 0);
+}
@@ -0,0 +1,95 @@
+// ~mgj: twice the area covered by the triangles, positive for clockwise triangles
+g_internal F64
+test_triangles_area(Buffer<Vec2F64> vertices, Buffer<U32> indices)
+{
+    F64 area = 0.0;
+    for (U64 i = 0; i + 2 < indices.size; i += 3)
+    {
+        Vec2F64 a = vertices.data[indices.data[i]];
+        Vec2F64 b = vertices.data[indices.data[i + 1]];
+        Vec2F64 c = vertices.data[indices.data[i + 2]];
+        area -= (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    }
+    return area;
+}
+
+TEST_CASE("Triangulate convex and concave rings")
+{
+    Arena* arena = arena_alloc();
+
+    // ~mgj: counter clockwise square, triangles come out clockwise
+    Vec2F64 square[] = {{0, 0}, {4, 0}, {4, 4}, {0, 4}};
+    Buffer<Vec2F64> square_buffer = {square, ArrayCount(square)};
+    Buffer<U32> indices = city::polygon_triangulate(arena, square_buffer, {});
+    CHECK(indices.size == 6);
+    CHECK(test_triangles_area(square_buffer, indices) == doctest::Approx(32.0));
+
+    // ~mgj: clockwise L shape
+    Vec2F64 l_shape[] = {{0, 0}, {0, 3}, {1, 3}, {1, 1}, {3, 1}, {3, 0}};
+    Buffer<Vec2F64> l_buffer = {l_shape, ArrayCount(l_shape)};
+    indices = city::polygon_triangulate(arena, l_buffer, {});
+    CHECK(indices.size == 12);
+    CHECK(test_triangles_area(l_buffer, indices) == doctest::Approx(10.0));
+
+    // ~mgj: a comb with more teeth than TRIANGULATE_HASH_VERTEX_MIN takes the z-order path
+    U32 tooth_count = 100;
+    Buffer<Vec2F64> comb = buffer_alloc<Vec2F64>(arena, tooth_count * 2 + 2);
+    for (U32 i = 0; i < tooth_count; ++i)
+    {
+        comb.data[2 * i] = vec_2f64((F64)i * 2.0, 1.0);
+        comb.data[2 * i + 1] = vec_2f64((F64)i * 2.0 + 1.0, (i % 2) ? 10.0 : 5.0);
+    }
+    comb.data[tooth_count * 2] = vec_2f64((F64)tooth_count * 2.0, 0.0);
+    comb.data[tooth_count * 2 + 1] = vec_2f64(0.0, 0.0);
+    F64 comb_area = 0.0;
+    for (U64 i = 0; i < comb.size; ++i)
+    {
+        Vec2F64 a = comb.data[i];
+        Vec2F64 b = comb.data[(i + 1) % comb.size];
+        comb_area += a.x * b.y - a.y * b.x;
+    }
+    indices = city::polygon_triangulate(arena, comb, {});
+    CHECK(indices.size == (comb.size - 2) * 3);
+    CHECK(test_triangles_area(comb, indices) == doctest::Approx(AbsF64(comb_area)));
+
+    // ~mgj: degenerate rings produce nothing instead of failing
+    Vec2F64 line[] = {{0, 0}, {1, 1}, {2, 2}};
+    CHECK(city::polygon_triangulate(arena, {line, ArrayCount(line)}, {}).size == 0);
+    CHECK(city::polygon_triangulate(arena, {line, 2}, {}).size == 0);
+
+    arena_release(arena);
+}
+
+TEST_CASE("Triangulate rings with holes")
+{
+    Arena* arena = arena_alloc();
+
+    // ~mgj: 10x10 outer ring with two 2x2 courtyards, the holes wound the same way as the outer ring
+    Vec2F64 vertices[] = {{0, 0}, {10, 0}, {10, 10}, {0, 10}, {2, 2}, {4, 2}, {4, 4}, {2, 4}, {6, 6}, {8, 6}, {8, 8}, {6, 8}};
+    U32 hole_starts[] = {4, 8};
+    Buffer<Vec2F64> vertex_buffer = {vertices, ArrayCount(vertices)};
+    Buffer<U32> indices = city::polygon_triangulate(arena, vertex_buffer, {hole_starts, ArrayCount(hole_starts)});
+    // ~mgj: n + 2 * holes - 2 triangles
+    CHECK(indices.size == (12 + 2 * 2 - 2) * 3);
+    CHECK(test_triangles_area(vertex_buffer, indices) == doctest::Approx(2.0 * (100.0 - 4.0 - 4.0)));
+
+    // ~mgj: no triangle covers a courtyard center
+    B32 courtyard_covered = false;
+    Vec2F64 centers[] = {{3, 3}, {7, 7}};
+    for (Vec2F64 center : centers)
+    {
+        for (U64 i = 0; i < indices.size; i += 3)
+        {
+            Vec2F64 a = vertices[indices.data[i]];
+            Vec2F64 b = vertices[indices.data[i + 1]];
+            Vec2F64 c = vertices[indices.data[i + 2]];
+            F64 d0 = (b.x - a.x) * (center.y - a.y) - (b.y - a.y) * (center.x - a.x);
+            F64 d1 = (c.x - b.x) * (center.y - b.y) - (c.y - b.y) * (center.x - b.x);
+            F64 d2 = (a.x - c.x) * (center.y - c.y) - (a.y - c.y) * (center.x - c.x);
+            courtyard_covered = courtyard_covered || (d0 < 0 && d1 < 0 && d2 < 0);
+        }
+    }
+    CHECK(!courtyard_covered);
+
+    arena_release(arena);
+}
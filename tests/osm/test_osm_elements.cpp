@@ -0,0 +1,92 @@
+TEST_CASE("Osm element store ingest")
+{
+    Arena* arena = arena_alloc();
+    Debug_SetName(arena, "test osm element arena");
+    defer(arena_release(arena));
+
+    String8 json = wrapper::json_padded_copy(arena, S(R"({
+        "version": 0.6,
+        "elements": [
+            {"type": "way", "id": 10, "nodes": [3, 1, 2], "tags": {"highway": "residential", "name": "Vej"}},
+            {"type": "relation", "id": 99, "members": [], "tags": {"type": "route"}},
+            {"type": "way", "id": 11, "nodes": [2, 3], "tags": {"building": "yes"}},
+            {"type": "node", "id": 3, "lat": 56.5, "lon": 10.5},
+            {"type": "node", "id": 1, "lat": 56.1, "lon": 10.1},
+            {"type": "node", "id": 2, "lat": 56.2, "lon": 10.2}
+        ]
+    })"));
+
+    Result<osm::ElementStore> store_result = wrapper::osm_element_store_from_simd_json(arena, json);
+    REQUIRE_FALSE(store_result.err);
+    osm::ElementStore* store = &store_result.v;
+
+    CHECK(store->nodes.count == 3);
+    CHECK(store->ways.count == 2);
+    CHECK(store->ways.node_ref_count == 5);
+    CHECK(store->ways.tag_count == 3);
+
+    // ~mgj: nodes are sorted by id so they can be found with a binary search
+    CHECK(store->nodes.ids[0] == 1);
+    CHECK(store->nodes.ids[2] == 3);
+    U64 node_idx = osm::element_store_node_idx_find(&store->nodes, 3);
+    CHECK(node_idx == 2);
+    CHECK(store->nodes.lat[node_idx] == 56.5);
+    CHECK(store->nodes.lon[node_idx] == 10.5);
+    CHECK(osm::element_store_node_idx_find(&store->nodes, 4) == store->nodes.count);
+
+    Buffer<osm::NodeId> way_node_ids = osm::element_store_way_node_ids(&store->ways, 0);
+    CHECK(store->ways.ids[0] == 10);
+    CHECK(way_node_ids.size == 3);
+    CHECK(way_node_ids.data[0] == 3);
+    CHECK(way_node_ids.data[2] == 2);
+
+    osm::TagList way_tags = osm::element_store_way_tags(&store->ways, 1);
+    CHECK(store->ways.ids[1] == 11);
+    CHECK(way_tags.count == 1);
+    CHECK(way_tags.keys[0] == (osm::StrId)osm::TagKeyId::Building);
+    CHECK(str8_match(osm::str8_from_str_id(way_tags.values[0]), S("yes"), 0));
+
+    // ~mgj: well known keys have compile time ids, other strings are interned as they are met
+    osm::TagList road_tags = osm::element_store_way_tags(&store->ways, 0);
+    CHECK(road_tags.keys[0] == (osm::StrId)osm::TagKeyId::Highway);
+    CHECK(road_tags.keys[1] == (osm::StrId)osm::TagKeyId::Name);
+    CHECK(road_tags.values[1] == osm::str_id_from_str8(S("Vej")));
+}
+
+TEST_CASE("Osm string table interns")
+{
+    CHECK(osm::str_id_from_str8(S("")) == 0);
+    CHECK(osm::str_id_from_str8(S("width")) == (osm::StrId)osm::TagKeyId::Width);
+    CHECK(str8_match(osm::str8_from_str_id((osm::StrId)osm::TagKeyId::BuildingLevels), S("building:levels"), 0));
+
+    osm::StrId residential = osm::str_id_from_str8(S("residential"));
+    CHECK(residential >= (osm::StrId)osm::TagKeyId::Count);
+    CHECK(osm::str_id_from_str8(S("residential")) == residential);
+    CHECK(osm::str_id_from_str8(S("residentia")) != residential);
+
+    // ~mgj: ids and strings stay valid while later interns grow the table past its first block
+    String8 residential_str = osm::str8_from_str_id(residential);
+    Arena* arena = arena_alloc();
+    defer(arena_release(arena));
+    B32 all_match = true;
+    for (U32 i = 0; i < 10000; ++i)
+    {
+        String8 value = PushStr8F(arena, "value %u", i);
+        all_match = all_match && str8_match(osm::str8_from_str_id(osm::str_id_from_str8(value)), value, 0);
+    }
+    CHECK(all_match);
+    CHECK(osm::str_id_from_str8(S("residential")) == residential);
+    CHECK(osm::str8_from_str_id(residential).str == residential_str.str);
+    CHECK(residential_str.str[residential_str.size] == 0);
+}
+
+TEST_CASE("Osm element store rejects malformed json")
+{
+    Arena* arena = arena_alloc();
+    Debug_SetName(arena, "test osm element arena");
+    defer(arena_release(arena));
+
+    String8 json = wrapper::json_padded_copy(arena, S(R"({"elements": [{"type": "node", "id": "not a number"}]})"));
+    Result<osm::ElementStore> store_result = wrapper::osm_element_store_from_simd_json(arena, json);
+    CHECK(store_result.err);
+}
@@ -8,17 +8,76 @@
 #include "base/base_inc.hpp"
 #include "async/segment_buffer.hpp"
 #include "async/async_heap.hpp"
+#include "async/mpmc_ring.hpp"
+#include "async/mpmc_queue.hpp"
+#include "async/timer_wheel.hpp"
+#include "async/spmc_queue.hpp"
+#include "async/thread_pool.hpp"
+#include "async/thread_pool_stats.hpp"
+#include "async/task_graph.hpp"
+#include "async/parallel.hpp"
+#include "async/coro.hpp"
+#include "curl/curl.h"
+#include "http/http.h"
+#include "async/http_engine.hpp"
+#include "async/async_task.hpp"
+#include "async/async_http.hpp"
+#include "simdjson/simdjson.h"
+#include "osm/osm_elements.hpp"
+#include "lib_wrappers/json.hpp"
+#include "city/json.hpp"
+#include "city/agent_wire.hpp"
+#include "city/agent_ingest.hpp"
+#include "city/agent_store.hpp"
+#include "city/road_bvh.hpp"
+#include "city/road_grid.hpp"
+#include "city/triangulate.hpp"
 
 // user source
 #include "base/base_inc.cpp"
 #include "async/segment_buffer.cpp"
 #include "async/async_heap.cpp"
+#include "async/mpmc_queue.cpp"
+#include "async/mpmc_ring.cpp"
+#include "async/timer_wheel.cpp"
+#include "async/spmc_queue.cpp"
+#include "async/thread_pool.cpp"
+#include "async/thread_pool_stats.cpp"
+#include "async/task_graph.cpp"
+#include "async/parallel.cpp"
+#include "async/coro.cpp"
+#include "async/http_engine.cpp"
+#include "async/async_http.cpp"
+#include "async/async_task.cpp"
+#include "osm/osm_elements.cpp"
+#include "lib_wrappers/json.cpp"
+#include "city/agent_wire.cpp"
+#include "city/agent_ingest.cpp"
+#include "city/agent_store.cpp"
+#include "city/road_bvh.cpp"
+#include "city/road_grid.cpp"
+#include "city/triangulate.cpp"
 
 // test files
+#include "async/test_coro.cpp"
 #include "async/test_heap.cpp"
+#include "async/test_http_engine.cpp"
+#include "async/test_parallel.cpp"
+#include "async/test_task_graph.cpp"
+#include "async/test_thread_pool.cpp"
+#include "async/test_thread_pool_stats.cpp"
+#include "async/test_timer_wheel.cpp"
 #include "base/test_allocator.cpp"
 #include "base/test_container.cpp"
+#include "base/test_map.cpp"
 #include "base/test_strings.cpp"
+#include "city/test_agent_ingest.cpp"
+#include "city/test_agent_store.cpp"
+#include "city/test_agent_wire.cpp"
+#include "city/test_road_bvh.cpp"
+#include "city/test_road_grid.cpp"
+#include "city/test_triangulate.cpp"
+#include "osm/test_osm_elements.cpp"
 
 int
 App(int argc, char** argv)